@@ -4,43 +4,54 @@
     float4x4 projMatrix;
 };
 
-cbuffer g_object : register(b1)
-{
-    float4x4 worldMatrix;
-};
-
 Texture2D g_texture : register(t0);
 SamplerState g_sampler : register(s0);
 
 struct VSInput
 {
-    float3 position : POSITION;
+    // Per Vertex (the unit quad)
+    float2 corner : POSITION;
     float2 texcoord : TEXCOORD;
+
+    // Per Instance (SpriteInstance)
+    float4 transform : TRANSFORM;
+    float2 translation : TRANSLATION;
+    float depth : DEPTH;
+    float4 color : COLOR;
+    float4 uvRect : UVRECT;
 };
 
 struct PSInput
 {
     float4 position : SV_POSITION;
     float2 texcoord : TEXCOORD;
+    float4 color : COLOR;
 };
 
 PSInput VS(VSInput input)
 {
     PSInput output;
 
+    float2 position =
+        input.corner.x * input.transform.xy +
+        input.corner.y * input.transform.zw +
+        input.translation;
+
     output.position =
-    mul(mul(mul(
-        float4(input.position, 1.0f),
-        worldMatrix),
+    mul(mul(
+        float4(position, input.depth, 1.0f),
         viewMatrix),
         projMatrix);
-    
-    output.texcoord = input.texcoord;
+
+    output.texcoord = lerp(input.uvRect.xy, input.uvRect.zw, input.texcoord);
+
+    // The textures are premultiplied, so is the tint.
+    output.color = float4(input.color.rgb * input.color.a, input.color.a);
 
     return output;
 }
 
 float4 PS(PSInput input) : SV_Target
 {
-    return g_texture.Sample(g_sampler, input.texcoord);
+    return g_texture.Sample(g_sampler, input.texcoord) * input.color;
 }
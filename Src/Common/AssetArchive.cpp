@@ -0,0 +1,535 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/AssetArchive.h"
+
+#include "Common/CompressUtils/LZ4.h"
+
+namespace d14engine
+{
+    namespace
+    {
+        constexpr uint32_t g_magic = 0x41343144; // "D14A"
+        constexpr uint32_t g_version = 1;
+
+        struct Header
+        {
+            uint32_t magic = g_magic;
+            uint32_t version = g_version;
+
+            uint32_t recordCount = 0;
+            uint32_t alignment = 0;
+
+            uint64_t recordsOffset = 0;
+            uint64_t namesOffset = 0;
+            uint64_t namesSize = 0;
+        };
+        // Leaves some room for the future fields.
+        constexpr uint64_t g_headerSize = 64;
+
+        static_assert(sizeof(Header) <= g_headerSize);
+
+        uint64_t alignUp(uint64_t offset, uint64_t alignment)
+        {
+            return (offset + alignment - 1) & ~(alignment - 1);
+        }
+
+        // wchar_t is UTF-16 on Windows and UTF-32 on the POSIX systems.
+        String toUtf8(WstringView str)
+        {
+            String result = {};
+            result.reserve(str.size());
+
+            for (size_t i = 0; i < str.size(); ++i)
+            {
+                auto code = (uint32_t)str[i];
+
+                if constexpr (sizeof(wchar_t) == 2)
+                {
+                    if (code >= 0xd800 && code < 0xdc00 && i + 1 < str.size())
+                    {
+                        auto low = (uint32_t)str[i + 1];
+                        if (low >= 0xdc00 && low < 0xe000)
+                        {
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                            ++i;
+                        }
+                    }
+                }
+                if (code < 0x80)
+                {
+                    result.push_back((char)code);
+                }
+                else if (code < 0x800)
+                {
+                    result.push_back((char)(0xc0 | (code >> 6)));
+                    result.push_back((char)(0x80 | (code & 0x3f)));
+                }
+                else if (code < 0x10000)
+                {
+                    result.push_back((char)(0xe0 | (code >> 12)));
+                    result.push_back((char)(0x80 | ((code >> 6) & 0x3f)));
+                    result.push_back((char)(0x80 | (code & 0x3f)));
+                }
+                else
+                {
+                    result.push_back((char)(0xf0 | (code >> 18)));
+                    result.push_back((char)(0x80 | ((code >> 12) & 0x3f)));
+                    result.push_back((char)(0x80 | ((code >> 6) & 0x3f)));
+                    result.push_back((char)(0x80 | (code & 0x3f)));
+                }
+            }
+            return result;
+        }
+
+        Wstring fromUtf8(StringView str)
+        {
+            Wstring result = {};
+            result.reserve(str.size());
+
+            for (size_t i = 0; i < str.size(); )
+            {
+                auto byte = (uint8_t)str[i];
+
+                size_t count = byte < 0x80 ? 0 : byte < 0xe0 ? 1 : byte < 0xf0 ? 2 : 3;
+                uint32_t code = count == 0 ? byte : byte & (0x3f >> count);
+
+                if (count > 0 && i + count >= str.size()) break; // truncated
+
+                for (size_t k = 1; k <= count; ++k)
+                {
+                    code = (code << 6) | ((uint8_t)str[i + k] & 0x3f);
+                }
+                i += count + 1;
+
+                if (sizeof(wchar_t) == 2 && code >= 0x10000)
+                {
+                    code -= 0x10000;
+                    result.push_back((wchar_t)(0xd800 + (code >> 10)));
+                    result.push_back((wchar_t)(0xdc00 + (code & 0x3ff)));
+                }
+                else result.push_back((wchar_t)code);
+            }
+            return result;
+        }
+
+        Wstring normalizeDirectory(WstrViewRefer directory)
+        {
+            Wstring result(directory);
+            std::replace(result.begin(), result.end(), L'\\', L'/');
+
+            while (result.starts_with(L"./")) result.erase(0, 2);
+
+            if (!result.empty() && result.back() != L'/') result.push_back(L'/');
+
+            return result;
+        }
+
+        struct MountTable
+        {
+            std::shared_mutex mutex = {};
+
+            // The later mounted ones are searched first.
+            std::vector<std::pair<Wstring, SharedPtr<AssetArchive>>> archives = {};
+        };
+        MountTable& mountTable()
+        {
+            static MountTable table = {};
+            return table;
+        }
+    }
+
+    bool AssetArchive::open(const std::filesystem::path& path)
+    {
+        static_assert(sizeof(Record) == 40, "The records are read in place.");
+
+        close();
+
+        if (!m_file.open(path, MappedFile::Mode::Read) || m_file.size() < g_headerSize)
+        {
+            close(); return false;
+        }
+        Header header = {};
+        std::memcpy(&header, m_file.data(), sizeof(header));
+
+        auto fileSize = m_file.size();
+
+        bool isValid =
+            header.magic == g_magic &&
+            header.version == g_version &&
+            header.recordsOffset % alignof(Record) == 0 &&
+            header.recordsOffset <= fileSize &&
+            (uint64_t)header.recordCount * sizeof(Record) <= fileSize - header.recordsOffset &&
+            header.namesOffset <= fileSize &&
+            header.namesSize <= fileSize - header.namesOffset;
+
+        if (!isValid)
+        {
+            close(); return false;
+        }
+        m_records = (const Record*)(m_file.data() + header.recordsOffset);
+        m_recordCount = header.recordCount;
+
+        m_names = (const char*)(m_file.data() + header.namesOffset);
+
+        // Checks the records once so that the lookups can trust them.
+        for (uint32_t i = 0; i < m_recordCount; ++i)
+        {
+            auto& record = m_records[i];
+
+            isValid =
+                (uint64_t)record.nameOffset + record.nameLength <= header.namesSize &&
+                record.dataOffset <= fileSize &&
+                record.storedSize <= fileSize - record.dataOffset &&
+                (record.compression == Compression::None ?
+                    record.storedSize == record.originalSize :
+                    record.compression == Compression::LZ4);
+
+            // The binary search relies on the order.
+            if (isValid && i > 0)
+            {
+                isValid = nameOf(m_records[i - 1]) < nameOf(record);
+            }
+            if (!isValid)
+            {
+                close(); return false;
+            }
+        }
+        return true;
+    }
+
+    void AssetArchive::close()
+    {
+        m_file.close();
+
+        m_records = nullptr;
+        m_recordCount = 0;
+        m_names = nullptr;
+    }
+
+    StringView AssetArchive::nameOf(const Record& record) const
+    {
+        return { m_names + record.nameOffset, record.nameLength };
+    }
+
+    const AssetArchive::Record* AssetArchive::findRecord(StringView name) const
+    {
+        auto end = m_records + m_recordCount;
+
+        auto itor = std::lower_bound(m_records, end, name, [this](const Record& record, StringView name)
+        {
+            return nameOf(record) < name;
+        });
+        if (itor != end && nameOf(*itor) == name) return itor;
+
+        return nullptr;
+    }
+
+    Optional<AssetArchive::Asset> AssetArchive::loadRecord(const Record& record) const
+    {
+        Asset asset = {};
+
+        auto data = m_file.data() + record.dataOffset;
+        if (record.compression == Compression::None)
+        {
+            // The view must not be null even for an empty asset.
+            asset.view = data != nullptr ? data : (const uint8_t*)"";
+            asset.viewSize = (size_t)record.storedSize;
+        }
+        else // Compression::LZ4
+        {
+            asset.storage.resize((size_t)record.originalSize);
+
+            if (!compress_utils::lz4::decompress(
+                data, (size_t)record.storedSize,
+                asset.storage.data(), asset.storage.size()))
+            {
+                return std::nullopt;
+            }
+        }
+        return asset;
+    }
+
+    bool AssetArchive::isOpen() const
+    {
+        return m_file.isOpen();
+    }
+
+    size_t AssetArchive::size() const
+    {
+        return m_recordCount;
+    }
+
+    bool AssetArchive::contains(WstrViewRefer name) const
+    {
+        return findRecord(normalizeName(name)) != nullptr;
+    }
+
+    Optional<AssetArchive::Asset> AssetArchive::load(WstrViewRefer name) const
+    {
+        auto record = findRecord(normalizeName(name));
+        if (record == nullptr) return std::nullopt;
+
+        return loadRecord(*record);
+    }
+
+    std::vector<Wstring> AssetArchive::list(WstrViewRefer directory) const
+    {
+        auto prefix = normalizeName(directory);
+        if (!prefix.empty() && prefix.back() != '/') prefix.push_back('/');
+
+        auto end = m_records + m_recordCount;
+
+        auto itor = std::lower_bound(m_records, end, prefix, [this](const Record& record, StringView prefix)
+        {
+            return nameOf(record) < prefix;
+        });
+        std::vector<Wstring> names = {};
+        for (; itor != end && nameOf(*itor).starts_with(prefix); ++itor)
+        {
+            names.push_back(fromUtf8(nameOf(*itor)));
+        }
+        return names;
+    }
+
+    bool AssetArchive::verify() const
+    {
+        for (uint32_t i = 0; i < m_recordCount; ++i)
+        {
+            auto asset = loadRecord(m_records[i]);
+            if (!asset.has_value() || checksum(asset->data(), asset->size()) != m_records[i].checksum)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    String AssetArchive::normalizeName(WstrViewRefer name)
+    {
+        auto result = toUtf8(name);
+        std::replace(result.begin(), result.end(), '\\', '/');
+
+        while (result.starts_with("./")) result.erase(0, 2);
+        while (result.starts_with('/')) result.erase(0, 1);
+
+        return result;
+    }
+
+    uint32_t AssetArchive::checksum(const uint8_t* data, size_t size)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    void AssetArchive::mount(WstrRefer directory, ShrdPtrRefer<AssetArchive> archive)
+    {
+        auto& table = mountTable();
+        std::unique_lock lock(table.mutex);
+
+        table.archives.emplace_back(normalizeDirectory(directory), archive);
+    }
+
+    void AssetArchive::unmount(WstrRefer directory)
+    {
+        auto& table = mountTable();
+        std::unique_lock lock(table.mutex);
+
+        std::erase_if(table.archives, [&](auto& mount)
+        {
+            return mount.first == normalizeDirectory(directory);
+        });
+    }
+
+    Optional<AssetArchive::Asset> AssetArchive::resolve(WstrViewRefer path)
+    {
+        auto& table = mountTable();
+        std::shared_lock lock(table.mutex);
+
+        if (table.archives.empty()) return std::nullopt;
+
+        Wstring normalized(path);
+        std::replace(normalized.begin(), normalized.end(), L'\\', L'/');
+
+        while (normalized.starts_with(L"./")) normalized.erase(0, 2);
+
+        for (auto itor = table.archives.rbegin(); itor != table.archives.rend(); ++itor)
+        {
+            auto& [directory, archive] = *itor;
+            if (!normalized.starts_with(directory)) continue;
+
+            auto asset = archive->load(WstringView(normalized).substr(directory.size()));
+            if (asset.has_value())
+            {
+                asset->archive = archive;
+                return asset;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::vector<Wstring> AssetArchive::resolveList(WstrViewRefer directory)
+    {
+        auto& table = mountTable();
+        std::shared_lock lock(table.mutex);
+
+        auto normalized = normalizeDirectory(directory);
+
+        for (auto itor = table.archives.rbegin(); itor != table.archives.rend(); ++itor)
+        {
+            auto& [mountPath, archive] = *itor;
+            if (!normalized.starts_with(mountPath)) continue;
+
+            auto names = archive->list(WstringView(normalized).substr(mountPath.size()));
+            if (!names.empty())
+            {
+                auto prefixLength = normalized.size() - mountPath.size();
+                for (auto& name : names) name.erase(0, prefixLength);
+                return names;
+            }
+        }
+        return {};
+    }
+
+    void AssetArchiveWriter::add(WstrViewRefer name, std::vector<uint8_t> data, bool compress)
+    {
+        Entry entry = {};
+
+        entry.originalSize = data.size();
+        entry.checksum = AssetArchive::checksum(data.data(), data.size());
+
+        if (compress && !data.empty())
+        {
+            auto compressed = compress_utils::lz4::compress(data.data(), data.size());
+            if (compressed.size() <= data.size() - data.size() / 8)
+            {
+                entry.data = std::move(compressed);
+                entry.compression = AssetArchive::Compression::LZ4;
+            }
+        }
+        if (entry.compression == AssetArchive::Compression::None)
+        {
+            entry.data = std::move(data);
+        }
+        m_entries[AssetArchive::normalizeName(name)] = std::move(entry);
+    }
+
+    bool AssetArchiveWriter::addFile(WstrViewRefer name, const std::filesystem::path& path, bool compress)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) return false;
+
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+        if (stream.bad()) return false;
+
+        add(name, std::move(data), compress);
+        return true;
+    }
+
+    size_t AssetArchiveWriter::addDirectory(const std::filesystem::path& directory, WstrViewRefer prefix, bool compress)
+    {
+        size_t count = 0;
+
+        std::error_code error = {};
+        for (auto& item : std::filesystem::recursive_directory_iterator(directory, error))
+        {
+            if (!item.is_regular_file()) continue;
+
+            auto relative = item.path().lexically_relative(directory).generic_wstring();
+            if (addFile(Wstring(prefix) + relative, item.path(), compress)) ++count;
+        }
+        return count;
+    }
+
+    size_t AssetArchiveWriter::size() const
+    {
+        return m_entries.size();
+    }
+
+    bool AssetArchiveWriter::write(const std::filesystem::path& path) const
+    {
+        if (alignment == 0 || !std::has_single_bit(alignment)) return false;
+
+        auto temporary = path;
+        temporary += L".tmp";
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+            if (!stream) return false;
+
+            uint64_t offset = 0;
+            auto padTo = [&](uint64_t target)
+            {
+                static const char zeros[64] = {};
+                while (offset < target)
+                {
+                    auto count = (size_t)std::min<uint64_t>(target - offset, sizeof(zeros));
+                    stream.write(zeros, count);
+                    offset += count;
+                }
+            };
+            padTo(g_headerSize);
+
+            // The layout of the records matches AssetArchive::Record.
+            struct Record
+            {
+                uint32_t nameOffset, nameLength;
+                uint64_t dataOffset, storedSize, originalSize;
+                uint32_t compression, checksum;
+            };
+            std::vector<Record> records = {};
+            records.reserve(m_entries.size());
+
+            String names = {};
+            for (auto& [name, entry] : m_entries)
+            {
+                padTo(alignUp(offset, alignment));
+
+                records.push_back(
+                {
+                    .nameOffset = (uint32_t)names.size(),
+                    .nameLength = (uint32_t)name.size(),
+                    .dataOffset = offset,
+                    .storedSize = entry.data.size(),
+                    .originalSize = entry.originalSize,
+                    .compression = (uint32_t)entry.compression,
+                    .checksum = entry.checksum
+                });
+                names += name;
+
+                stream.write((const char*)entry.data.data(), entry.data.size());
+                offset += entry.data.size();
+            }
+            Header header = {};
+            header.recordCount = (uint32_t)records.size();
+            header.alignment = alignment;
+
+            padTo(alignUp(offset, 8));
+            header.recordsOffset = offset;
+
+            stream.write((const char*)records.data(), records.size() * sizeof(Record));
+            offset += records.size() * sizeof(Record);
+
+            header.namesOffset = offset;
+            header.namesSize = names.size();
+
+            stream.write(names.data(), names.size());
+
+            stream.seekp(0);
+            stream.write((const char*)&header, sizeof(header));
+
+            if (!stream.flush()) return false;
+        }
+        std::error_code error = {};
+        std::filesystem::rename(temporary, path, error);
+
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+}
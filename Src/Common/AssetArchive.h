@@ -0,0 +1,159 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+#include "Common/MappedFile.h"
+
+namespace d14engine
+{
+    // Packs many small assets (e.g. the cursors and the compiled shaders)
+    // into one file that is memory-mapped once instead of opening each of
+    // them, and the uncompressed assets are read in place (zero-copy).
+    //
+    // The names are relative paths (e.g. L"Cursors/Dark/Arrow.png") with
+    // the separators normalized to '/', and they are case-sensitive.
+    //
+    // File layout (native endianness):
+    // header, the data of each entry (aligned as the header specifies),
+    // the entry records sorted by name, the UTF-8 names of the entries.
+
+    struct AssetArchive : cpp_lang_utils::NonCopyable
+    {
+        enum class Compression : uint32_t
+        {
+            None = 0, LZ4 = 1
+        };
+        struct Asset
+        {
+            // Points into the mapping if the asset is stored uncompressed.
+            const uint8_t* view = nullptr;
+            size_t viewSize = 0;
+
+            // Holds the decompressed data (empty for the zero-copy ones).
+            std::vector<uint8_t> storage = {};
+
+            // Keeps the mounted archive alive while the view refers to it.
+            SharedPtr<const AssetArchive> archive = {};
+
+            const uint8_t* data() const
+            {
+                return view != nullptr ? view : storage.data();
+            }
+            size_t size() const
+            {
+                return view != nullptr ? viewSize : storage.size();
+            }
+        };
+        AssetArchive() = default;
+
+        // Returns false if the file is missing or corrupted.
+        bool open(const std::filesystem::path& path);
+
+        void close();
+
+    protected:
+        MappedFile m_file = {};
+
+        struct Record
+        {
+            uint32_t nameOffset = 0, nameLength = 0;
+
+            uint64_t dataOffset = 0;
+            uint64_t storedSize = 0;
+            uint64_t originalSize = 0;
+
+            Compression compression = Compression::None;
+
+            // FNV-1a of the original data.
+            uint32_t checksum = 0;
+        };
+        const Record* m_records = nullptr;
+        uint32_t m_recordCount = 0;
+
+        const char* m_names = nullptr;
+
+        StringView nameOf(const Record& record) const;
+
+        const Record* findRecord(StringView name) const;
+
+        Optional<Asset> loadRecord(const Record& record) const;
+
+    public:
+        bool isOpen() const;
+
+        size_t size() const;
+
+        bool contains(WstrViewRefer name) const;
+
+        Optional<Asset> load(WstrViewRefer name) const;
+
+        // Returns the names under the directory (e.g. L"Cursors/Dark/Busy/")
+        // in order, including the ones in the subdirectories.
+        std::vector<Wstring> list(WstrViewRefer directory) const;
+
+        // Decompresses every entry and compares the checksums.
+        bool verify() const;
+
+        // Returns the UTF-8 name with the separators normalized, which has
+        // no leading "./" or '/'.
+        static String normalizeName(WstrViewRefer name);
+
+        static uint32_t checksum(const uint8_t* data, size_t size);
+
+    public:
+        /////////////////
+        // Mount Table //
+        /////////////////
+
+        // With an archive mounted at L"Bin/", a path such as
+        // L"Bin/Shaders/CSO/Letterbox_VS.cso" is resolved as the entry
+        // L"Shaders/CSO/Letterbox_VS.cso", so the loaders of the loose files
+        // read the archive first without knowing about it.
+
+        static void mount(WstrRefer directory, ShrdPtrRefer<AssetArchive> archive);
+        static void unmount(WstrRefer directory);
+
+        // Returns std::nullopt if the path is not in any mounted archive.
+        static Optional<Asset> resolve(WstrViewRefer path);
+
+        // Returns the names of the entries under the directory (relative to
+        // it), which is empty if the directory is not in any mounted archive.
+        static std::vector<Wstring> resolveList(WstrViewRefer directory);
+    };
+
+    struct AssetArchiveWriter
+    {
+        // Must be a power of 2, and 16 suffices for the SIMD loads.
+        uint32_t alignment = 16;
+
+        // The compressed data is kept only if it saves at least 1/8 of the
+        // size, so the already compressed formats (e.g. PNG) are stored as is.
+        void add(WstrViewRefer name, std::vector<uint8_t> data, bool compress = true);
+
+        bool addFile(WstrViewRefer name, const std::filesystem::path& path, bool compress = true);
+
+        // Adds the files under the directory recursively with their relative
+        // paths (after the prefix), and returns the count of the added ones.
+        size_t addDirectory(const std::filesystem::path& directory, WstrViewRefer prefix = {}, bool compress = true);
+
+        size_t size() const;
+
+        // Writes to a temporary file and renames it to the path.
+        bool write(const std::filesystem::path& path) const;
+
+    protected:
+        struct Entry
+        {
+            std::vector<uint8_t> data = {};
+
+            uint64_t originalSize = 0;
+
+            AssetArchive::Compression compression = AssetArchive::Compression::None;
+
+            uint32_t checksum = 0;
+        };
+        // Sorted by the UTF-8 names, and the later one wins.
+        std::map<String, Entry> m_entries = {};
+    };
+}
@@ -0,0 +1,190 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/AtlasUtils/RectPacker.h"
+
+namespace d14engine::atlas_utils
+{
+    MaxRectsPacker::MaxRectsPacker(uint32_t width, uint32_t height, Heuristic heuristic)
+        :
+        m_heuristic(heuristic)
+    {
+        reset(width, height);
+    }
+
+    void MaxRectsPacker::reset(uint32_t width, uint32_t height)
+    {
+        m_width = width;
+        m_height = height;
+
+        m_freeRects.clear();
+        if (width != 0 && height != 0)
+        {
+            m_freeRects.push_back({ 0, 0, width, height });
+        }
+        m_usedArea = 0;
+    }
+
+    std::pair<uint64_t, uint64_t> MaxRectsPacker::score(const Rect& freeRect, uint32_t width, uint32_t height) const
+    {
+        uint64_t leftoverH = freeRect.width - width;
+        uint64_t leftoverV = freeRect.height - height;
+
+        switch (m_heuristic)
+        {
+        case Heuristic::BestAreaFit:
+        {
+            return { freeRect.area() - (uint64_t)width * height, std::min(leftoverH, leftoverV) };
+        }
+        case Heuristic::BottomLeft:
+        {
+            return { (uint64_t)freeRect.y + height, freeRect.x };
+        }
+        default:
+        {
+            return { std::min(leftoverH, leftoverV), std::max(leftoverH, leftoverV) };
+        }
+        }
+    }
+
+    void MaxRectsPacker::split(const Rect& used)
+    {
+        size_t firstNew = m_freeRects.size();
+
+        for (size_t i = 0; i < firstNew; )
+        {
+            auto freeRect = m_freeRects[i];
+            if (!freeRect.overlaps(used))
+            {
+                ++i;
+                continue;
+            }
+            // Each side of the used one that cuts into the free one leaves
+            // a maximal free rectangle on that side.
+            if (used.x > freeRect.x)
+            {
+                m_freeRects.push_back({ freeRect.x, freeRect.y, used.x - freeRect.x, freeRect.height });
+            }
+            if (used.right() < freeRect.right())
+            {
+                m_freeRects.push_back({ used.right(), freeRect.y, freeRect.right() - used.right(), freeRect.height });
+            }
+            if (used.y > freeRect.y)
+            {
+                m_freeRects.push_back({ freeRect.x, freeRect.y, freeRect.width, used.y - freeRect.y });
+            }
+            if (used.bottom() < freeRect.bottom())
+            {
+                m_freeRects.push_back({ freeRect.x, used.bottom(), freeRect.width, freeRect.bottom() - used.bottom() });
+            }
+            // Swaps in the last old one to keep the new ones at the end.
+            m_freeRects[i] = m_freeRects[firstNew - 1];
+            m_freeRects[firstNew - 1] = m_freeRects.back();
+            m_freeRects.pop_back();
+            --firstNew;
+        }
+        prune(firstNew);
+    }
+
+    void MaxRectsPacker::prune(size_t firstNew)
+    {
+        std::vector<bool> removed(m_freeRects.size());
+
+        for (size_t i = firstNew; i < m_freeRects.size(); ++i)
+        {
+            if (removed[i]) continue;
+
+            for (size_t j = 0; j < m_freeRects.size(); ++j)
+            {
+                if (i == j || removed[j]) continue;
+
+                // The old ones never contain each other already.
+                if (m_freeRects[j].contains(m_freeRects[i]))
+                {
+                    removed[i] = true;
+                    break;
+                }
+                if (m_freeRects[i].contains(m_freeRects[j]))
+                {
+                    removed[j] = true;
+                }
+            }
+        }
+        size_t count = 0;
+        for (size_t i = 0; i < m_freeRects.size(); ++i)
+        {
+            if (!removed[i]) m_freeRects[count++] = m_freeRects[i];
+        }
+        m_freeRects.resize(count);
+    }
+
+    double MaxRectsPacker::occupancy() const
+    {
+        uint64_t area = (uint64_t)m_width * m_height;
+        return area != 0 ? (double)m_usedArea / area : 0.0;
+    }
+
+    Optional<Rect> MaxRectsPacker::insert(uint32_t width, uint32_t height)
+    {
+        if (width == 0 || height == 0) return std::nullopt;
+
+        const Rect* best = nullptr;
+        std::pair<uint64_t, uint64_t> bestScore = {};
+
+        for (auto& freeRect : m_freeRects)
+        {
+            if (freeRect.width >= width && freeRect.height >= height)
+            {
+                auto s = score(freeRect, width, height);
+                if (best == nullptr || s < bestScore)
+                {
+                    best = &freeRect;
+                    bestScore = s;
+                }
+            }
+        }
+        if (best == nullptr) return std::nullopt;
+
+        Rect used = { best->x, best->y, width, height };
+
+        split(used);
+        m_usedArea += used.area();
+
+        return used;
+    }
+
+    void MaxRectsPacker::release(const Rect& rect)
+    {
+        m_freeRects.push_back(rect);
+        prune(m_freeRects.size() - 1);
+
+        m_usedArea -= rect.area();
+    }
+
+    Optional<std::vector<Rect>> MaxRectsPacker::insertAll(const SizeArray& sizes)
+    {
+        std::vector<size_t> order(sizes.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        // The longer side decides first since the long thin ones are the
+        // hardest to place later.
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+        {
+            auto& sa = sizes[a];
+            auto& sb = sizes[b];
+
+            auto ka = std::make_pair(std::max(sa.first, sa.second), std::min(sa.first, sa.second));
+            auto kb = std::make_pair(std::max(sb.first, sb.second), std::min(sb.first, sb.second));
+
+            return ka > kb;
+        });
+        std::vector<Rect> rects(sizes.size());
+        for (auto index : order)
+        {
+            auto rect = insert(sizes[index].first, sizes[index].second);
+            if (!rect.has_value()) return std::nullopt;
+
+            rects[index] = rect.value();
+        }
+        return rects;
+    }
+}
@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::atlas_utils
+{
+    struct Rect
+    {
+        uint32_t x = 0, y = 0;
+        uint32_t width = 0, height = 0;
+
+        uint32_t right() const { return x + width; }
+        uint32_t bottom() const { return y + height; }
+
+        uint64_t area() const { return (uint64_t)width * height; }
+
+        bool contains(const Rect& other) const
+        {
+            return other.x >= x && other.y >= y &&
+                   other.right() <= right() && other.bottom() <= bottom();
+        }
+        bool overlaps(const Rect& other) const
+        {
+            return other.x < right() && other.right() > x &&
+                   other.y < bottom() && other.bottom() > y;
+        }
+    };
+
+    // Implements the MaxRects algorithm (Jukka Jylänki, 2010), which keeps
+    // the maximal free rectangles (they may overlap each other) and places
+    // each new one in the free rectangle that fits it best.
+    //
+    // The rectangles are never rotated so that the UVs stay axis-aligned.
+    // The released space is not merged with the neighbors, so the packing
+    // degrades after many releases and should be redone from scratch then.
+
+    struct MaxRectsPacker
+    {
+        enum class Heuristic
+        {
+            // Minimizes the shorter leftover side, which packs the best in
+            // general and is the default.
+            BestShortSideFit,
+            // Minimizes the leftover area.
+            BestAreaFit,
+            // Places at the lowest then leftmost position (i.e. Tetris).
+            BottomLeft
+        };
+        MaxRectsPacker(uint32_t width = 0, uint32_t height = 0, Heuristic heuristic = Heuristic::BestShortSideFit);
+
+        void reset(uint32_t width, uint32_t height);
+
+    protected:
+        uint32_t m_width = 0, m_height = 0;
+
+        Heuristic m_heuristic = {};
+
+        std::vector<Rect> m_freeRects = {};
+
+        uint64_t m_usedArea = 0;
+
+        // Returns (primary, secondary) where the smaller is the better.
+        std::pair<uint64_t, uint64_t> score(const Rect& freeRect, uint32_t width, uint32_t height) const;
+
+        void split(const Rect& used);
+
+        // Removes the free rectangles contained in the others, where only
+        // the ones after firstNew can be newly contained or containing.
+        void prune(size_t firstNew);
+
+    public:
+        uint32_t width() const { return m_width; }
+        uint32_t height() const { return m_height; }
+
+        uint64_t usedArea() const { return m_usedArea; }
+
+        // The ratio of the used area to the whole area.
+        double occupancy() const;
+
+        // Returns std::nullopt if no free rectangle can hold it.
+        Optional<Rect> insert(uint32_t width, uint32_t height);
+
+        // The rectangle must be the result of an insertion.
+        void release(const Rect& rect);
+
+        using SizeArray = std::vector<std::pair<uint32_t, uint32_t>>;
+
+        // Inserts the sizes from the largest for a tighter packing, and
+        // returns the rectangles in the original order (or std::nullopt
+        // if any of them does not fit, and the packer should be reset).
+        Optional<std::vector<Rect>> insertAll(const SizeArray& sizes);
+    };
+}
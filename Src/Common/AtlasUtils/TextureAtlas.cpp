@@ -0,0 +1,195 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/AtlasUtils/TextureAtlas.h"
+
+namespace d14engine::atlas_utils
+{
+    TextureAtlas::TextureAtlas(uint32_t width, uint32_t height, uint32_t padding, uint32_t bleed)
+        :
+        m_padding(padding),
+        m_bleed(std::min(bleed, padding)),
+        m_packer(width, height),
+        m_image(width, height) { }
+
+    void TextureAtlas::markDirty(const Rect& rect)
+    {
+        if (m_dirtyRect.has_value())
+        {
+            auto& dirty = m_dirtyRect.value();
+
+            auto right = std::max(dirty.right(), rect.right());
+            auto bottom = std::max(dirty.bottom(), rect.bottom());
+
+            dirty.x = std::min(dirty.x, rect.x);
+            dirty.y = std::min(dirty.y, rect.y);
+
+            dirty.width = right - dirty.x;
+            dirty.height = bottom - dirty.y;
+        }
+        else m_dirtyRect = rect;
+    }
+
+    void TextureAtlas::blit(const pixel_utils::ImageView& source, const Rect& rect)
+    {
+        for (uint32_t y = 0; y < rect.height; ++y)
+        {
+            std::memcpy(m_image.row(rect.y + y) + rect.x * 4_uz, source.row(y), rect.width * 4_uz);
+        }
+        if (m_bleed == 0) return;
+
+        // The columns first, and then the rows with the extruded columns,
+        // so that the corners are filled as well.
+        for (uint32_t y = 0; y < rect.height; ++y)
+        {
+            auto row = m_image.row(rect.y + y);
+
+            auto left = row + rect.x * 4_uz;
+            auto right = row + (rect.right() - 1) * 4_uz;
+
+            for (uint32_t i = 1; i <= m_bleed; ++i)
+            {
+                std::memcpy(left - i * 4_uz, left, 4);
+                std::memcpy(right + i * 4_uz, right, 4);
+            }
+        }
+        auto offset = (rect.x - m_bleed) * 4_uz;
+        auto rowSize = (rect.width + 2 * m_bleed) * 4_uz;
+
+        for (uint32_t i = 1; i <= m_bleed; ++i)
+        {
+            std::memcpy(m_image.row(rect.y - i) + offset, m_image.row(rect.y) + offset, rowSize);
+            std::memcpy(m_image.row(rect.bottom() - 1 + i) + offset, m_image.row(rect.bottom() - 1) + offset, rowSize);
+        }
+    }
+
+    Optional<TextureAtlas::ID> TextureAtlas::insert(const pixel_utils::ImageView& image)
+    {
+        if (image.width == 0 || image.height == 0) return std::nullopt;
+
+        auto slot = m_packer.insert(image.width + 2 * m_padding, image.height + 2 * m_padding);
+        if (!slot.has_value()) return std::nullopt;
+
+        Entry entry =
+        {
+            .slot = slot.value(),
+            .rect = { slot->x + m_padding, slot->y + m_padding, image.width, image.height }
+        };
+        blit(image, entry.rect);
+        markDirty(entry.slot);
+
+        m_imageArea += entry.rect.area();
+
+        auto id = m_nextID++;
+        m_entries[id] = entry;
+
+        return id;
+    }
+
+    void TextureAtlas::erase(ID id)
+    {
+        auto itor = m_entries.find(id);
+        if (itor != m_entries.end())
+        {
+            m_packer.release(itor->second.slot);
+            m_imageArea -= itor->second.rect.area();
+
+            m_entries.erase(itor);
+        }
+    }
+
+    bool TextureAtlas::contains(ID id) const
+    {
+        return m_entries.find(id) != m_entries.end();
+    }
+
+    size_t TextureAtlas::size() const
+    {
+        return m_entries.size();
+    }
+
+    bool TextureAtlas::repack()
+    {
+        return repack(m_image.width, m_image.height);
+    }
+
+    bool TextureAtlas::repack(uint32_t width, uint32_t height)
+    {
+        MaxRectsPacker::SizeArray sizes = {};
+        sizes.reserve(m_entries.size());
+
+        for (auto& entry : m_entries)
+        {
+            sizes.emplace_back(entry.second.slot.width, entry.second.slot.height);
+        }
+        MaxRectsPacker packer(width, height);
+
+        auto slots = packer.insertAll(sizes);
+        if (!slots.has_value()) return false;
+
+        // The slots (including the extruded edges) are moved as they are.
+        pixel_utils::Image image(width, height);
+
+        size_t index = 0;
+        for (auto& entry : m_entries)
+        {
+            auto& oldSlot = entry.second.slot;
+            auto& newSlot = slots.value()[index++];
+
+            for (uint32_t y = 0; y < oldSlot.height; ++y)
+            {
+                std::memcpy(
+                    image.row(newSlot.y + y) + newSlot.x * 4_uz,
+                    m_image.row(oldSlot.y + y) + oldSlot.x * 4_uz,
+                    oldSlot.width * 4_uz);
+            }
+            entry.second.slot = newSlot;
+            entry.second.rect.x = newSlot.x + m_padding;
+            entry.second.rect.y = newSlot.y + m_padding;
+        }
+        m_packer = std::move(packer);
+        m_image = std::move(image);
+
+        ++m_generation;
+        m_dirtyRect = Rect{ 0, 0, width, height };
+
+        return true;
+    }
+
+    uint32_t TextureAtlas::generation() const
+    {
+        return m_generation;
+    }
+
+    Rect TextureAtlas::rect(ID id) const
+    {
+        return m_entries.at(id).rect;
+    }
+
+    UVRect TextureAtlas::uvRect(ID id) const
+    {
+        auto& r = m_entries.at(id).rect;
+
+        float w = (float)m_image.width;
+        float h = (float)m_image.height;
+
+        return { r.x / w, r.y / h, r.right() / w, r.bottom() / h };
+    }
+
+    const pixel_utils::Image& TextureAtlas::image() const
+    {
+        return m_image;
+    }
+
+    double TextureAtlas::occupancy() const
+    {
+        uint64_t area = (uint64_t)m_image.width * m_image.height;
+        return area != 0 ? (double)m_imageArea / area : 0.0;
+    }
+
+    Optional<Rect> TextureAtlas::takeDirtyRect()
+    {
+        auto rect = m_dirtyRect;
+        m_dirtyRect.reset();
+        return rect;
+    }
+}
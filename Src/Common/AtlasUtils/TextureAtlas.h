@@ -0,0 +1,103 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/AtlasUtils/RectPacker.h"
+#include "Common/PixelUtils/Image.h"
+
+namespace d14engine::atlas_utils
+{
+    // The texture coordinates in [0, 1] of a region in the atlas.
+    struct UVRect
+    {
+        float left = 0.0f, top = 0.0f;
+        float right = 1.0f, bottom = 1.0f;
+    };
+
+    // Packs many small images (e.g. the frames of the sequences) into one
+    // large image, so that they are drawn from a single texture with the
+    // UV rectangles instead of switching between the separate textures.
+    //
+    // The padding is the gap kept around each image so that the bilinear
+    // filtering never samples the neighbors, and the bleed (which is at
+    // most the padding) extrudes the edge pixels of each image into that
+    // gap so that the filtering at the edges never samples the background.
+    //
+    // The images can be inserted and erased at any time, and repack lays
+    // out the remaining ones from scratch after the erasures have left the
+    // free space fragmented (or to move them into a larger atlas).
+
+    struct TextureAtlas
+    {
+        TextureAtlas(uint32_t width, uint32_t height, uint32_t padding = 2, uint32_t bleed = 1);
+
+        using ID = uint32_t;
+
+    protected:
+        uint32_t m_padding = {}, m_bleed = {};
+
+        MaxRectsPacker m_packer = {};
+
+        pixel_utils::Image m_image = {};
+
+        struct Entry
+        {
+            // The slot is the packed one that includes the padding.
+            Rect slot = {}, rect = {};
+        };
+        std::map<ID, Entry> m_entries = {};
+
+        ID m_nextID = 0;
+
+        uint64_t m_imageArea = 0;
+
+        uint32_t m_generation = 0;
+
+        Optional<Rect> m_dirtyRect = {};
+
+        void markDirty(const Rect& rect);
+
+        // Copies the pixels to the rectangle and extrudes the edges.
+        void blit(const pixel_utils::ImageView& source, const Rect& rect);
+
+    public:
+        uint32_t width() const { return m_image.width; }
+        uint32_t height() const { return m_image.height; }
+
+        uint32_t padding() const { return m_padding; }
+        uint32_t bleed() const { return m_bleed; }
+
+        // Returns std::nullopt if the atlas is full (or the image empty).
+        Optional<ID> insert(const pixel_utils::ImageView& image);
+
+        // The pixels are left in place (only the space is released).
+        void erase(ID id);
+
+        bool contains(ID id) const;
+
+        size_t size() const;
+
+        // Returns false and keeps the layout if the images cannot fit,
+        // and the IDs stay the same while the rectangles may change.
+        bool repack();
+        bool repack(uint32_t width, uint32_t height);
+
+        // Changed by each successful repack, after which the rectangles
+        // (and the UVs) of all the images must be queried again.
+        uint32_t generation() const;
+
+        // The pixels of the image in the atlas (without the padding).
+        Rect rect(ID id) const;
+
+        UVRect uvRect(ID id) const;
+
+        const pixel_utils::Image& image() const;
+
+        // The ratio of the image area to the atlas area.
+        double occupancy() const;
+
+        // Returns the bounds of the pixels changed since the last call,
+        // so that only that part of the texture needs to be updated.
+        Optional<Rect> takeDirtyRect();
+    };
+}
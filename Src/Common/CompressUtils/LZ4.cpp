@@ -0,0 +1,201 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/CompressUtils/LZ4.h"
+
+namespace d14engine::compress_utils
+{
+    namespace lz4
+    {
+        namespace
+        {
+            constexpr size_t g_minMatch = 4;
+
+            // The last match must start at least 12 bytes before the end,
+            // and the last 5 bytes are always literals.
+            constexpr size_t g_matchFindLimit = 12;
+            constexpr size_t g_lastLiterals = 5;
+
+            constexpr size_t g_maxOffset = 65535;
+
+            constexpr int g_hashBits = 12;
+
+            uint32_t read32(const uint8_t* ptr)
+            {
+                uint32_t value = {};
+                std::memcpy(&value, ptr, sizeof(value));
+                return value;
+            }
+
+            uint32_t hash(uint32_t sequence)
+            {
+                return (sequence * 2654435761u) >> (32 - g_hashBits);
+            }
+
+            void writeLength(std::vector<uint8_t>& out, size_t length)
+            {
+                for (; length >= 255; length -= 255)
+                {
+                    out.push_back(255);
+                }
+                out.push_back((uint8_t)length);
+            }
+
+            void writeSequence(
+                std::vector<uint8_t>& out,
+                const uint8_t* literals,
+                size_t literalLength,
+                size_t offset,
+                size_t matchLength)
+            {
+                // The match length is stored minus g_minMatch.
+                auto extraMatch = matchLength - g_minMatch;
+
+                uint8_t token = (uint8_t)(std::min(literalLength, 15_uz) << 4);
+                if (matchLength != 0) token |= (uint8_t)std::min(extraMatch, 15_uz);
+
+                out.push_back(token);
+                if (literalLength >= 15) writeLength(out, literalLength - 15);
+
+                out.insert(out.end(), literals, literals + literalLength);
+
+                if (matchLength != 0)
+                {
+                    out.push_back((uint8_t)(offset & 0xff));
+                    out.push_back((uint8_t)(offset >> 8));
+
+                    if (extraMatch >= 15) writeLength(out, extraMatch - 15);
+                }
+            }
+        }
+
+        size_t compressBound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        std::vector<uint8_t> compress(const uint8_t* data, size_t size)
+        {
+            // The empty block is a single token without any literal, and
+            // the data may be null in that case.
+            if (size == 0) return { 0 };
+
+            std::vector<uint8_t> out = {};
+            out.reserve(compressBound(size));
+
+            size_t anchor = 0;
+
+            if (size > g_matchFindLimit)
+            {
+                // Holds (position + 1) of the last sequence of each hash.
+                std::vector<uint32_t> table((size_t)1 << g_hashBits);
+
+                size_t matchLimit = size - g_lastLiterals;
+                size_t searchLimit = size - g_matchFindLimit;
+
+                // Skips faster through the incompressible data.
+                size_t step = 1, misses = 0;
+
+                for (size_t ip = 0; ip < searchLimit; )
+                {
+                    auto sequence = read32(data + ip);
+                    auto& slot = table[hash(sequence)];
+
+                    size_t ref = slot;
+                    slot = (uint32_t)(ip + 1);
+
+                    if (ref == 0 || ip + 1 - ref > g_maxOffset || read32(data + ref - 1) != sequence)
+                    {
+                        step = 1 + (++misses >> 6);
+                        ip += step;
+                        continue;
+                    }
+                    --ref; misses = 0;
+
+                    size_t length = g_minMatch;
+                    while (ip + length < matchLimit && data[ref + length] == data[ip + length])
+                    {
+                        ++length;
+                    }
+                    writeSequence(out, data + anchor, ip - anchor, ip - ref, length);
+
+                    ip += length;
+                    anchor = ip;
+                }
+            }
+            writeSequence(out, data + anchor, size - anchor, 0, 0);
+
+            return out;
+        }
+
+        bool decompress(const uint8_t* data, size_t size, uint8_t* dst, size_t dstSize)
+        {
+            // See compress, and dst may be null in that case.
+            if (dstSize == 0) return size == 1 && data[0] == 0;
+
+            size_t ip = 0, op = 0;
+
+            auto readLength = [&](size_t& length)
+            {
+                uint8_t byte = 255;
+                while (byte == 255)
+                {
+                    if (ip >= size) return false;
+                    byte = data[ip++];
+                    length += byte;
+                }
+                return true;
+            };
+            while (ip < size)
+            {
+                uint8_t token = data[ip++];
+
+                size_t literalLength = token >> 4;
+                if (literalLength == 15 && !readLength(literalLength))
+                {
+                    return false;
+                }
+                if (literalLength > size - ip || literalLength > dstSize - op)
+                {
+                    return false;
+                }
+                std::memcpy(dst + op, data + ip, literalLength);
+
+                ip += literalLength;
+                op += literalLength;
+
+                // The last sequence has no match.
+                if (ip == size) break;
+
+                if (size - ip < 2) return false;
+
+                size_t offset = data[ip] | ((size_t)data[ip + 1] << 8);
+                ip += 2;
+
+                size_t matchLength = token & 0x0f;
+                if (matchLength == 15 && !readLength(matchLength))
+                {
+                    return false;
+                }
+                matchLength += g_minMatch;
+
+                if (offset == 0 || offset > op || matchLength > dstSize - op)
+                {
+                    return false;
+                }
+                // The match may overlap the output (e.g. a run of bytes),
+                // so it must be copied byte by byte in that case.
+                auto match = dst + op - offset;
+                if (offset >= matchLength)
+                {
+                    std::memcpy(dst + op, match, matchLength);
+                }
+                else for (size_t i = 0; i < matchLength; ++i)
+                {
+                    dst[op + i] = match[i];
+                }
+                op += matchLength;
+            }
+            return op == dstSize;
+        }
+    }
+}
@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::compress_utils
+{
+    namespace lz4
+    {
+        // Implements the LZ4 block format (without the frame format), which
+        // decompresses fast enough to be used for the assets on startup.
+
+        // Returns the maximal size of the compressed data.
+        size_t compressBound(size_t size);
+
+        std::vector<uint8_t> compress(const uint8_t* data, size_t size);
+
+        // The original size must be known (e.g. stored alongside), and false
+        // is returned if the data is corrupted or the size does not match.
+        bool decompress(const uint8_t* data, size_t size, uint8_t* dst, size_t dstSize);
+    }
+}
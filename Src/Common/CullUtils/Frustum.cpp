@@ -0,0 +1,247 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/CullUtils/Frustum.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_CULL_UTILS_SSE2 true
+#else
+#define _D14_CULL_UTILS_SSE2 false
+#endif
+
+namespace d14engine::cull_utils
+{
+    AABB AABB::fromMinMax(
+        float minX, float minY, float minZ,
+        float maxX, float maxY, float maxZ)
+    {
+        return
+        {
+            (minX + maxX) * 0.5f, (minY + maxY) * 0.5f, (minZ + maxZ) * 0.5f,
+            (maxX - minX) * 0.5f, (maxY - minY) * 0.5f, (maxZ - minZ) * 0.5f
+        };
+    }
+
+    Frustum Frustum::fromMatrix(const float(&m)[4][4])
+    {
+        // Each clip coordinate is the dot product of the point and a column,
+        // e.g. the left plane is where x >= -w, i.e. dot(v, col0 + col3) >= 0.
+        auto column = [&](int j) -> Plane
+        {
+            return { m[0][j], m[1][j], m[2][j], m[3][j] };
+        };
+        auto combine = [](const Plane& p, float sign, const Plane& q)
+        {
+            Plane result = { p.a + sign * q.a, p.b + sign * q.b, p.c + sign * q.c, p.d + sign * q.d };
+
+            auto length = std::sqrt(result.a * result.a + result.b * result.b + result.c * result.c);
+            if (length > 0.0f)
+            {
+                result.a /= length; result.b /= length;
+                result.c /= length; result.d /= length;
+            }
+            return result;
+        };
+        auto col0 = column(0), col1 = column(1), col2 = column(2), col3 = column(3);
+
+        Frustum frustum = {};
+
+        frustum.planes[0] = combine(col3, +1.0f, col0); // left: x >= -w
+        frustum.planes[1] = combine(col3, -1.0f, col0); // right: x <= w
+        frustum.planes[2] = combine(col3, +1.0f, col1); // bottom: y >= -w
+        frustum.planes[3] = combine(col3, -1.0f, col1); // top: y <= w
+        frustum.planes[4] = combine(col2, +0.0f, col2); // near: z >= 0
+        frustum.planes[5] = combine(col3, -1.0f, col2); // far: z <= w
+
+        return frustum;
+    }
+
+    bool Frustum::intersects(const Sphere& sphere) const
+    {
+        for (auto& p : planes)
+        {
+            if (p.distance(sphere.x, sphere.y, sphere.z) < -sphere.radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const AABB& box) const
+    {
+        for (auto& p : planes)
+        {
+            // The projected half size of the box on the normal.
+            auto radius =
+                std::abs(p.a) * box.extentX +
+                std::abs(p.b) * box.extentY +
+                std::abs(p.c) * box.extentZ;
+
+            if (p.distance(box.centerX, box.centerY, box.centerZ) + radius < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void SphereArray::clear()
+    {
+        x.clear(); y.clear(); z.clear(); radius.clear();
+    }
+
+    void SphereArray::reserve(size_t count)
+    {
+        x.reserve(count); y.reserve(count); z.reserve(count); radius.reserve(count);
+    }
+
+    void SphereArray::push_back(const Sphere& sphere)
+    {
+        x.push_back(sphere.x);
+        y.push_back(sphere.y);
+        z.push_back(sphere.z);
+        radius.push_back(sphere.radius);
+    }
+
+    size_t SphereArray::size() const
+    {
+        return x.size();
+    }
+
+    void AABBArray::clear()
+    {
+        centerX.clear(); centerY.clear(); centerZ.clear();
+        extentX.clear(); extentY.clear(); extentZ.clear();
+    }
+
+    void AABBArray::reserve(size_t count)
+    {
+        centerX.reserve(count); centerY.reserve(count); centerZ.reserve(count);
+        extentX.reserve(count); extentY.reserve(count); extentZ.reserve(count);
+    }
+
+    void AABBArray::push_back(const AABB& box)
+    {
+        centerX.push_back(box.centerX);
+        centerY.push_back(box.centerY);
+        centerZ.push_back(box.centerZ);
+        extentX.push_back(box.extentX);
+        extentY.push_back(box.extentY);
+        extentZ.push_back(box.extentZ);
+    }
+
+    size_t AABBArray::size() const
+    {
+        return centerX.size();
+    }
+
+    namespace
+    {
+#if _D14_CULL_UTILS_SSE2
+        struct PlaneSSE2
+        {
+            __m128 a, b, c, d;
+            __m128 absA, absB, absC;
+        };
+        std::array<PlaneSSE2, 6> broadcast(const Frustum& frustum)
+        {
+            std::array<PlaneSSE2, 6> planes = {};
+            for (size_t i = 0; i < planes.size(); ++i)
+            {
+                auto& p = frustum.planes[i];
+                planes[i] =
+                {
+                    _mm_set1_ps(p.a), _mm_set1_ps(p.b), _mm_set1_ps(p.c), _mm_set1_ps(p.d),
+                    _mm_set1_ps(std::abs(p.a)), _mm_set1_ps(std::abs(p.b)), _mm_set1_ps(std::abs(p.c))
+                };
+            }
+            return planes;
+        }
+
+        // Writes the 4 results of the inside mask (bit i for the i-th one).
+        size_t storeResults(int mask, uint8_t* results)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                results[i] = (uint8_t)((mask >> i) & 1);
+            }
+            return (size_t)std::popcount((unsigned)mask);
+        }
+#endif
+    }
+
+    size_t cull(const Frustum& frustum, const SphereArray& spheres, uint8_t* results)
+    {
+        size_t i = 0, count = 0, size = spheres.size();
+#if _D14_CULL_UTILS_SSE2
+        auto planes = broadcast(frustum);
+        for (; i + 4 <= size; i += 4)
+        {
+            auto x = _mm_loadu_ps(spheres.x.data() + i);
+            auto y = _mm_loadu_ps(spheres.y.data() + i);
+            auto z = _mm_loadu_ps(spheres.z.data() + i);
+            auto negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius.data() + i));
+
+            auto outside = _mm_setzero_ps();
+            for (auto& p : planes)
+            {
+                auto distance = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(p.a, x), _mm_mul_ps(p.b, y)),
+                    _mm_add_ps(_mm_mul_ps(p.c, z), p.d));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+            }
+            count += storeResults(~_mm_movemask_ps(outside) & 0xf, results + i);
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            Sphere sphere = { spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i] };
+            count += results[i] = frustum.intersects(sphere);
+        }
+        return count;
+    }
+
+    size_t cull(const Frustum& frustum, const AABBArray& boxes, uint8_t* results)
+    {
+        size_t i = 0, count = 0, size = boxes.size();
+#if _D14_CULL_UTILS_SSE2
+        auto planes = broadcast(frustum);
+        for (; i + 4 <= size; i += 4)
+        {
+            auto x = _mm_loadu_ps(boxes.centerX.data() + i);
+            auto y = _mm_loadu_ps(boxes.centerY.data() + i);
+            auto z = _mm_loadu_ps(boxes.centerZ.data() + i);
+            auto ex = _mm_loadu_ps(boxes.extentX.data() + i);
+            auto ey = _mm_loadu_ps(boxes.extentY.data() + i);
+            auto ez = _mm_loadu_ps(boxes.extentZ.data() + i);
+
+            auto outside = _mm_setzero_ps();
+            for (auto& p : planes)
+            {
+                auto distance = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(p.a, x), _mm_mul_ps(p.b, y)),
+                    _mm_add_ps(_mm_mul_ps(p.c, z), p.d));
+
+                auto radius = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(p.absA, ex), _mm_mul_ps(p.absB, ey)),
+                    _mm_mul_ps(p.absC, ez));
+
+                // distance + radius < 0
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+            count += storeResults(~_mm_movemask_ps(outside) & 0xf, results + i);
+        }
+#endif
+        for (; i < size; ++i)
+        {
+            AABB box =
+            {
+                boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i],
+                boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]
+            };
+            count += results[i] = frustum.intersects(box);
+        }
+        return count;
+    }
+}
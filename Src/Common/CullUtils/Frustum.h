@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::cull_utils
+{
+    struct Sphere
+    {
+        float x = 0.0f, y = 0.0f, z = 0.0f;
+        float radius = 0.0f;
+    };
+    // Axis-aligned bounding box by the center and the half size.
+    struct AABB
+    {
+        float centerX = 0.0f, centerY = 0.0f, centerZ = 0.0f;
+        float extentX = 0.0f, extentY = 0.0f, extentZ = 0.0f;
+
+        static AABB fromMinMax(
+            float minX, float minY, float minZ,
+            float maxX, float maxY, float maxZ);
+    };
+    using Bounds = Variant<Sphere, AABB>;
+
+    // The points with a * x + b * y + c * z + d >= 0 are inside, and the
+    // normal (a, b, c) is of unit length so that d is the distance.
+    struct Plane
+    {
+        float a = 0.0f, b = 0.0f, c = 0.0f, d = 0.0f;
+
+        float distance(float x, float y, float z) const
+        {
+            // Grouped as the batched tests do to give the same results.
+            return (a * x + b * y) + (c * z + d);
+        }
+    };
+
+    struct Frustum
+    {
+        // left, right, bottom, top, near, far
+        std::array<Plane, 6> planes = {};
+
+        // Extracts the planes from the view-projection matrix in the row
+        // vector convention (i.e. clip = v * M as DirectXMath does) and
+        // with the clip depth in [0, w] (as Direct3D does).  An orthographic
+        // matrix gives a box, which is culled in the same way.
+        static Frustum fromMatrix(const float(&m)[4][4]);
+
+        // The tests are conservative: a few bounds near the corners of the
+        // frustum may pass while being outside, but no inside one is culled.
+
+        bool intersects(const Sphere& sphere) const;
+        bool intersects(const AABB& box) const;
+    };
+
+    // The bounds in the structure of arrays for the batched tests, which
+    // tests 4 of them at once with SSE2 (and the rest one by one).
+
+    struct SphereArray
+    {
+        std::vector<float> x = {}, y = {}, z = {}, radius = {};
+
+        void clear();
+        void reserve(size_t count);
+        void push_back(const Sphere& sphere);
+
+        size_t size() const;
+    };
+    struct AABBArray
+    {
+        std::vector<float> centerX = {}, centerY = {}, centerZ = {};
+        std::vector<float> extentX = {}, extentY = {}, extentZ = {};
+
+        void clear();
+        void reserve(size_t count);
+        void push_back(const AABB& box);
+
+        size_t size() const;
+    };
+
+    // Writes 1 to results[i] if the i-th bounds intersects the frustum or
+    // 0 otherwise, and returns the count of the intersecting ones.
+
+    size_t cull(const Frustum& frustum, const SphereArray& spheres, uint8_t* results);
+    size_t cull(const Frustum& frustum, const AABBArray& boxes, uint8_t* results);
+}
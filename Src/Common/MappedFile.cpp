@@ -0,0 +1,185 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace d14engine
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::filesystem::path& path, Mode mode)
+    {
+        close();
+
+        m_mode = mode;
+#ifdef _WIN32
+        bool isWritable = mode == Mode::ReadWrite;
+
+        m_file = CreateFileW
+        (
+        /* lpFileName            */ path.c_str(),
+        /* dwDesiredAccess       */ isWritable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+        /* dwShareMode           */ FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        /* lpSecurityAttributes  */ nullptr,
+        /* dwCreationDisposition */ isWritable ? OPEN_ALWAYS : OPEN_EXISTING,
+        /* dwFlagsAndAttributes  */ FILE_ATTRIBUTE_NORMAL,
+        /* hTemplateFile         */ nullptr
+        );
+        if (m_file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(m_file, &size))
+        {
+            close(); return false;
+        }
+        m_size = (uint64_t)size.QuadPart;
+#else
+        int flags = mode == Mode::ReadWrite ? (O_RDWR | O_CREAT) : O_RDONLY;
+
+        m_file = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (m_file < 0) return false;
+
+        struct stat info = {};
+        if (fstat(m_file, &info) != 0)
+        {
+            close(); return false;
+        }
+        m_size = (uint64_t)info.st_size;
+#endif
+        if (!map())
+        {
+            close(); return false;
+        }
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        unmap();
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_file >= 0)
+        {
+            ::close(m_file);
+            m_file = -1;
+        }
+#endif
+        m_size = 0;
+    }
+
+    bool MappedFile::map()
+    {
+        if (m_size == 0) return true;
+
+        if (m_size > (uint64_t)SIZE_MAX) return false;
+#ifdef _WIN32
+        bool isWritable = m_mode == Mode::ReadWrite;
+
+        m_mapping = CreateFileMappingW
+        (
+        /* hFile                   */ m_file,
+        /* lpFileMappingAttributes */ nullptr,
+        /* flProtect               */ isWritable ? PAGE_READWRITE : PAGE_READONLY,
+        /* dwMaximumSizeHigh       */ 0,
+        /* dwMaximumSizeLow        */ 0,
+        /* lpName                  */ nullptr
+        );
+        if (m_mapping == nullptr) return false;
+
+        m_data = (uint8_t*)MapViewOfFile
+        (
+        /* hFileMappingObject   */ m_mapping,
+        /* dwDesiredAccess      */ isWritable ? FILE_MAP_WRITE : FILE_MAP_READ,
+        /* dwFileOffsetHigh     */ 0,
+        /* dwFileOffsetLow      */ 0,
+        /* dwNumberOfBytesToMap */ 0
+        );
+        if (m_data == nullptr)
+        {
+            unmap(); return false;
+        }
+#else
+        int prot = m_mode == Mode::ReadWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+
+        auto data = mmap(nullptr, (size_t)m_size, prot, MAP_SHARED, m_file, 0);
+        if (data == MAP_FAILED) return false;
+
+        m_data = (uint8_t*)data;
+#endif
+        return true;
+    }
+
+    void MappedFile::unmap()
+    {
+#ifdef _WIN32
+        if (m_data != nullptr) UnmapViewOfFile(m_data);
+
+        if (m_mapping != nullptr)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+        }
+#else
+        if (m_data != nullptr) munmap(m_data, (size_t)m_size);
+#endif
+        m_data = nullptr;
+    }
+
+    bool MappedFile::isOpen() const
+    {
+#ifdef _WIN32
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        return m_file >= 0;
+#endif
+    }
+
+    MappedFile::Mode MappedFile::mode() const { return m_mode; }
+
+    uint8_t* MappedFile::data() const { return m_data; }
+
+    uint64_t MappedFile::size() const { return m_size; }
+
+    bool MappedFile::resize(uint64_t size)
+    {
+        if (!isOpen() || m_mode != Mode::ReadWrite) return false;
+
+        unmap();
+#ifdef _WIN32
+        LARGE_INTEGER distance = {};
+        distance.QuadPart = (LONGLONG)size;
+
+        bool isResized = SetFilePointerEx(m_file, distance, nullptr, FILE_BEGIN) && SetEndOfFile(m_file);
+#else
+        bool isResized = ftruncate(m_file, (off_t)size) == 0;
+#endif
+        // Keeps the old size mapped if failed.
+        if (isResized) m_size = size;
+
+        return map() && isResized;
+    }
+
+    bool MappedFile::flush()
+    {
+        if (m_data == nullptr) return isOpen();
+#ifdef _WIN32
+        return FlushViewOfFile(m_data, 0) && FlushFileBuffers(m_file);
+#else
+        return msync(m_data, (size_t)m_size, MS_SYNC) == 0;
+#endif
+    }
+}
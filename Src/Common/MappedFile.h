@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+namespace d14engine
+{
+    // Maps a whole file into the address space, which is backed by the
+    // file mapping of Win32 on Windows and by mmap on the POSIX systems.
+    //
+    // The failures are reported with the return values instead of the
+    // exceptions since the files may be missing or locked at any time.
+
+    struct MappedFile : cpp_lang_utils::NonCopyable
+    {
+        MappedFile() = default;
+
+        virtual ~MappedFile();
+
+        enum class Mode { Read, ReadWrite };
+
+        // The file is created if it does not exist in ReadWrite mode.
+        bool open(const std::filesystem::path& path, Mode mode);
+
+        void close();
+
+    protected:
+        Mode m_mode = Mode::Read;
+
+        uint8_t* m_data = nullptr;
+        uint64_t m_size = 0;
+
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_file = -1;
+#endif
+        bool map();
+        void unmap();
+
+    public:
+        bool isOpen() const;
+
+        Mode mode() const;
+
+        // nullptr for an empty file since it cannot be mapped.
+        uint8_t* data() const;
+        uint64_t size() const;
+
+        // Only available in ReadWrite mode: the file is truncated or
+        // extended (with zeros) and remapped, so the old data pointer
+        // is invalidated.
+        bool resize(uint64_t size);
+
+        // Writes the dirty pages back to the disk synchronously.
+        bool flush();
+    };
+}
@@ -0,0 +1,152 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Blur.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_PIXEL_UTILS_SSE2 true
+#else
+#define _D14_PIXEL_UTILS_SSE2 false
+#endif
+
+namespace d14engine::pixel_utils
+{
+    namespace
+    {
+        // The normalized weights of the 2 * radius + 1 taps.
+        std::vector<float> gaussianWeights(float stdDev, uint32_t radius)
+        {
+            std::vector<float> weights(2 * radius + 1);
+
+            double sum = 0.0;
+            for (uint32_t i = 0; i < weights.size(); ++i)
+            {
+                double x = (double)i - radius;
+                sum += weights[i] = (float)std::exp(-x * x / (2.0 * stdDev * stdDev));
+            }
+            for (auto& weight : weights) weight = (float)(weight / sum);
+
+            return weights;
+        }
+
+        // Sums the taps of 4 consecutive outputs, where the taps of output
+        // i start at src[i] and are step floats apart.
+        template<bool Simd>
+        void convolve4(const float* src, size_t step, const std::vector<float>& weights, float* dst)
+        {
+#if _D14_PIXEL_UTILS_SSE2
+            if constexpr (Simd)
+            {
+                auto sum = _mm_setzero_ps();
+                for (size_t k = 0; k < weights.size(); ++k)
+                {
+                    auto value = _mm_loadu_ps(src + k * step);
+                    sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weights[k])));
+                }
+                _mm_storeu_ps(dst, sum);
+                return;
+            }
+#endif
+            float sum[4] = {};
+            for (size_t k = 0; k < weights.size(); ++k)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    sum[i] += src[k * step + i] * weights[k];
+                }
+            }
+            std::memcpy(dst, sum, sizeof(sum));
+        }
+
+        template<bool Simd>
+        Mask gaussianBlurImpl(const Mask& source, float stdDev)
+        {
+            auto radius = gaussianRadius(stdDev);
+            if (radius == 0) return source;
+
+            auto weights = gaussianWeights(stdDev, radius);
+
+            uint32_t width = source.width + 2 * radius;
+            uint32_t height = source.height + 2 * radius;
+
+            // Each row of the outputs is rounded up to 4 floats, and the
+            // source is padded by 2 radii so that every tap is in range.
+            size_t pitch = (width + 3) & ~3u;
+
+            size_t srcPitch = pitch + 2 * radius;
+            std::vector<float> padded(srcPitch * source.height);
+
+            for (uint32_t y = 0; y < source.height; ++y)
+            {
+                auto src = source.row(y);
+                auto dst = padded.data() + y * srcPitch + 2 * radius;
+
+                for (uint32_t x = 0; x < source.width; ++x) dst[x] = src[x];
+            }
+            // The horizontal pass, which also pads the rows vertically.
+            std::vector<float> temporary(pitch * (height + 2 * radius));
+
+            for (uint32_t y = 0; y < source.height; ++y)
+            {
+                auto src = padded.data() + y * srcPitch;
+                auto dst = temporary.data() + (y + 2 * radius) * pitch;
+
+                for (size_t x = 0; x < pitch; x += 4)
+                {
+                    convolve4<Simd>(src + x, 1, weights, dst + x);
+                }
+            }
+            // The vertical pass.
+            Mask result(width, height);
+
+            std::vector<float> row(pitch);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                auto src = temporary.data() + y * pitch;
+
+                for (size_t x = 0; x < pitch; x += 4)
+                {
+                    convolve4<Simd>(src + x, pitch, weights, row.data() + x);
+                }
+                auto dst = result.row(y);
+                uint32_t x = 0;
+#if _D14_PIXEL_UTILS_SSE2
+                if constexpr (Simd)
+                {
+                    auto zero = _mm_setzero_ps();
+                    auto max = _mm_set1_ps(255.0f);
+
+                    for (; x + 4 <= width; x += 4)
+                    {
+                        auto value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(row.data() + x), zero), max);
+                        auto p = _mm_cvtps_epi32(value);
+
+                        p = _mm_packus_epi16(_mm_packs_epi32(p, p), p);
+                        auto packed = _mm_cvtsi128_si32(p);
+                        std::memcpy(dst + x, &packed, 4);
+                    }
+                }
+#endif
+                for (; x < width; ++x)
+                {
+                    dst[x] = (uint8_t)std::nearbyint(std::clamp(row[x], 0.0f, 255.0f));
+                }
+            }
+            return result;
+        }
+    }
+
+    uint32_t gaussianRadius(float stdDev)
+    {
+        return stdDev > 0.0f ? (uint32_t)std::ceil(3.0f * stdDev) : 0;
+    }
+
+    Mask gaussianBlur(const Mask& source, float stdDev)
+    {
+        return gaussianBlurImpl<true>(source, stdDev);
+    }
+
+    Mask gaussianBlurScalar(const Mask& source, float stdDev)
+    {
+        return gaussianBlurImpl<false>(source, stdDev);
+    }
+}
@@ -0,0 +1,20 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Image.h"
+
+namespace d14engine::pixel_utils
+{
+    // Returns the radius of the kernel in pixels, i.e. ceil(3 * stdDev),
+    // beyond which the weights are negligible.
+    uint32_t gaussianRadius(float stdDev);
+
+    // Blurs the mask separably with the Gaussian of the standard deviation
+    // (as the shadow effect of D2D1 does), and the result is padded by the
+    // radius on each side so that nothing is cut off.
+    Mask gaussianBlur(const Mask& source, float stdDev);
+
+    // The reference path that produces the same result without SIMD.
+    Mask gaussianBlurScalar(const Mask& source, float stdDev);
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::pixel_utils
+{
+    // The pixel utilities work on 8-bit 4-channel pixels with the alpha
+    // in the last byte (i.e. RGBA8 or BGRA8), and the kernels other than
+    // swapRedBlue never depend on the order of the color channels.
+
+    struct ImageView
+    {
+        const uint8_t* data = nullptr;
+
+        uint32_t width = 0, height = 0;
+
+        // The byte count of each scanline (at least 4 * width).
+        size_t pitch = 0;
+
+        const uint8_t* row(uint32_t y) const { return data + y * pitch; }
+    };
+
+    // Owns tightly packed pixels (i.e. pitch == 4 * width).
+    struct Image
+    {
+        Image() = default;
+
+        Image(uint32_t width, uint32_t height)
+            :
+            width(width), height(height),
+            pixels((size_t)width * height * 4) { }
+
+        uint32_t width = 0, height = 0;
+
+        std::vector<uint8_t> pixels = {};
+
+        size_t pitch() const { return (size_t)width * 4; }
+
+        uint8_t* row(uint32_t y) { return pixels.data() + y * pitch(); }
+
+        ImageView view() const { return { pixels.data(), width, height, pitch() }; }
+    };
+
+    // Owns tightly packed 8-bit single-channel pixels, e.g. the coverage
+    // of the glyphs and the alpha of the shadows.
+    struct Mask
+    {
+        Mask() = default;
+
+        Mask(uint32_t width, uint32_t height)
+            :
+            width(width), height(height),
+            pixels((size_t)width * height) { }
+
+        uint32_t width = 0, height = 0;
+
+        std::vector<uint8_t> pixels = {};
+
+        uint8_t* row(uint32_t y) { return pixels.data() + (size_t)y * width; }
+        const uint8_t* row(uint32_t y) const { return pixels.data() + (size_t)y * width; }
+    };
+}
@@ -0,0 +1,133 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/MipChain.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_PIXEL_UTILS_SSE2 true
+#else
+#define _D14_PIXEL_UTILS_SSE2 false
+#endif
+
+namespace d14engine::pixel_utils
+{
+    namespace
+    {
+        template<bool Simd>
+        Image halveImpl(const ImageView& source, Filter filter)
+        {
+            uint32_t width = std::max(1u, source.width / 2);
+            uint32_t height = std::max(1u, source.height / 2);
+
+            bool isEven = source.width % 2 == 0 && source.height % 2 == 0;
+            if (filter != Filter::Box || !isEven)
+            {
+                if constexpr (Simd)
+                {
+                    return resample(source, width, height, filter);
+                }
+                else return resampleScalar(source, width, height, filter);
+            }
+            Image result(width, height);
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                auto row0 = source.row(y * 2);
+                auto row1 = source.row(y * 2 + 1);
+
+                auto dst = result.row(y);
+
+                uint32_t x = 0;
+#if _D14_PIXEL_UTILS_SSE2
+                if constexpr (Simd)
+                {
+                    auto zero = _mm_setzero_si128();
+                    auto two = _mm_set1_epi16(2);
+
+                    // Takes 4 source pixels of each row for 2 result pixels.
+                    for (; x + 2 <= width; x += 2)
+                    {
+                        auto a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                        auto b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+
+                        auto lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+                        auto hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+                        // Adds the 2 columns in each half.
+                        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+                        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+                        auto sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two);
+                        sum = _mm_srli_epi16(sum, 2);
+
+                        _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(sum, sum));
+                    }
+                }
+#endif
+                for (; x < width; ++x)
+                {
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        uint32_t sum = row0[x * 8 + c] + row0[x * 8 + 4 + c] +
+                                       row1[x * 8 + c] + row1[x * 8 + 4 + c];
+
+                        dst[x * 4 + c] = (uint8_t)((sum + 2) >> 2);
+                    }
+                }
+            }
+            return result;
+        }
+    }
+
+    uint32_t mipLevelCount(uint32_t width, uint32_t height)
+    {
+        return (uint32_t)std::bit_width(std::max({ width, height, 1u }));
+    }
+
+    Image halve(const ImageView& source, Filter filter)
+    {
+        return halveImpl<true>(source, filter);
+    }
+
+    Image halveScalar(const ImageView& source, Filter filter)
+    {
+        return halveImpl<false>(source, filter);
+    }
+
+    Image halveRoundingUp(const ImageView& source)
+    {
+        if (source.width % 2 == 0 && source.height % 2 == 0)
+        {
+            return halve(source);
+        }
+        Image padded(source.width + source.width % 2, source.height + source.height % 2);
+
+        for (uint32_t y = 0; y < padded.height; ++y)
+        {
+            auto src = source.row(std::min(y, source.height - 1));
+            auto dst = padded.row(y);
+
+            std::copy_n(src, (size_t)source.width * 4, dst);
+            if (padded.width > source.width)
+            {
+                std::copy_n(src + (size_t)(source.width - 1) * 4, 4, dst + (size_t)source.width * 4);
+            }
+        }
+        return halve(padded.view());
+    }
+
+    std::vector<Image> generateMipChain(const ImageView& base, Filter filter)
+    {
+        std::vector<Image> levels = {};
+
+        auto count = mipLevelCount(base.width, base.height);
+        if (count > 0) levels.reserve(count - 1);
+
+        auto previous = base;
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            levels.push_back(halve(previous, filter));
+            previous = levels.back().view();
+        }
+        return levels;
+    }
+}
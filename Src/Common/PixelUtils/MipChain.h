@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Image.h"
+#include "Common/PixelUtils/Resample.h"
+
+namespace d14engine::pixel_utils
+{
+    // Returns the level count of the full mip chain (including the base).
+    uint32_t mipLevelCount(uint32_t width, uint32_t height);
+
+    // Returns the next level, i.e. max(1, floor(size / 2)) on each axis.
+    //
+    // The box filter of the even sizes is an exact 2 x 2 average, and the
+    // other cases fall back to resample (premultiplied as the mipmaps are).
+    Image halve(const ImageView& source, Filter filter = Filter::Box);
+    Image halveScalar(const ImageView& source, Filter filter = Filter::Box);
+
+    // Returns ceil(size / 2) on each axis (as the levels of TilePyramid),
+    // where the last column and row of an odd size are repeated so that
+    // each result pixel is still an exact 2 x 2 box.
+    Image halveRoundingUp(const ImageView& source);
+
+    // Returns the levels after the base in order (each one is generated
+    // from the previous one), so the result is empty for a 1 x 1 base.
+    std::vector<Image> generateMipChain(const ImageView& base, Filter filter = Filter::Box);
+}
@@ -0,0 +1,99 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Premultiply.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_PIXEL_UTILS_SSE2 true
+#else
+#define _D14_PIXEL_UTILS_SSE2 false
+#endif
+
+namespace d14engine::pixel_utils
+{
+    void premultiply(uint8_t* pixels, size_t pixelCount)
+    {
+        size_t index = 0;
+#if _D14_PIXEL_UTILS_SSE2
+        auto zero = _mm_setzero_si128();
+
+        // The multiplier of the alpha lane is 255, which keeps it intact.
+        auto colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+        auto alphaLane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+        auto half = _mm_set1_epi16(128);
+
+        // Takes 2 pixels in 16-bit lanes.
+        auto multiply = [&](__m128i color)
+        {
+            auto alpha = _mm_shufflelo_epi16(color, _MM_SHUFFLE(3, 3, 3, 3));
+            alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+            alpha = _mm_or_si128(_mm_and_si128(alpha, colorMask), alphaLane);
+
+            // (t + (t >> 8)) >> 8 with t = c * a + 128 equals round(c * a / 255),
+            // and no lane overflows since t + (t >> 8) <= 65407.
+            auto t = _mm_add_epi16(_mm_mullo_epi16(color, alpha), half);
+            return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        };
+        for (; index + 4 <= pixelCount; index += 4)
+        {
+            auto ptr = (__m128i*)(pixels + index * 4);
+            auto data = _mm_loadu_si128(ptr);
+
+            auto lo = multiply(_mm_unpacklo_epi8(data, zero));
+            auto hi = multiply(_mm_unpackhi_epi8(data, zero));
+
+            _mm_storeu_si128(ptr, _mm_packus_epi16(lo, hi));
+        }
+#endif
+        premultiplyScalar(pixels + index * 4, pixelCount - index);
+    }
+
+    void premultiplyScalar(uint8_t* pixels, size_t pixelCount)
+    {
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            auto pixel = pixels + i * 4;
+            uint32_t alpha = pixel[3];
+
+            for (int c = 0; c < 3; ++c)
+            {
+                uint32_t t = pixel[c] * alpha + 128;
+                pixel[c] = (uint8_t)((t + (t >> 8)) >> 8);
+            }
+        }
+    }
+
+    void swapRedBlue(uint8_t* pixels, size_t pixelCount)
+    {
+        size_t index = 0;
+#if _D14_PIXEL_UTILS_SSE2
+        auto greenAlphaMask = _mm_set1_epi32((int)0xff00ff00);
+        auto redBlueMask = _mm_set1_epi32(0x00ff00ff);
+
+        for (; index + 4 <= pixelCount; index += 4)
+        {
+            auto ptr = (__m128i*)(pixels + index * 4);
+            auto data = _mm_loadu_si128(ptr);
+
+            // Byte 0 and byte 2 of each pixel trade places, and the bits
+            // shifted out of each 32-bit lane are simply dropped.
+            auto redBlue = _mm_and_si128(data, redBlueMask);
+            redBlue = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+
+            auto greenAlpha = _mm_and_si128(data, greenAlphaMask);
+
+            _mm_storeu_si128(ptr, _mm_or_si128(_mm_and_si128(redBlue, redBlueMask), greenAlpha));
+        }
+#endif
+        swapRedBlueScalar(pixels + index * 4, pixelCount - index);
+    }
+
+    void swapRedBlueScalar(uint8_t* pixels, size_t pixelCount)
+    {
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+        }
+    }
+}
@@ -0,0 +1,16 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::pixel_utils
+{
+    // Multiplies the color channels by the alpha with exact rounding,
+    // i.e. round(color * alpha / 255), so the SIMD path and the scalar
+    // reference path produce identical results.
+    void premultiply(uint8_t* pixels, size_t pixelCount);
+    void premultiplyScalar(uint8_t* pixels, size_t pixelCount);
+
+    // Converts between RGBA8 and BGRA8 in place.
+    void swapRedBlue(uint8_t* pixels, size_t pixelCount);
+    void swapRedBlueScalar(uint8_t* pixels, size_t pixelCount);
+}
@@ -0,0 +1,288 @@
+﻿#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Resample.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_PIXEL_UTILS_SSE2 true
+#else
+#define _D14_PIXEL_UTILS_SSE2 false
+#endif
+
+namespace d14engine::pixel_utils
+{
+    namespace
+    {
+        constexpr double g_pi = 3.14159265358979323846;
+
+        double sinc(double x)
+        {
+            if (x == 0.0) return 1.0;
+            x *= g_pi; return std::sin(x) / x;
+        }
+
+        double kernel(Filter filter, double x)
+        {
+            switch (filter)
+            {
+            case Filter::Box:
+            {
+                return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+            }
+            case Filter::Mitchell:
+            {
+                constexpr double B = 1.0 / 3.0, C = 1.0 / 3.0;
+
+                x = std::abs(x);
+                if (x < 1.0)
+                {
+                    return ((12.0 - 9.0 * B - 6.0 * C) * x * x * x +
+                            (-18.0 + 12.0 * B + 6.0 * C) * x * x +
+                            (6.0 - 2.0 * B)) / 6.0;
+                }
+                if (x < 2.0)
+                {
+                    return ((-B - 6.0 * C) * x * x * x +
+                            (6.0 * B + 30.0 * C) * x * x +
+                            (-12.0 * B - 48.0 * C) * x +
+                            (8.0 * B + 24.0 * C)) / 6.0;
+                }
+                return 0.0;
+            }
+            case Filter::Lanczos3:
+            {
+                return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+            }
+            default: return 0.0;
+            }
+        }
+
+        // The weights of the source pixels for each destination pixel on
+        // one axis, and every list is padded to the same length (taps).
+        struct Contributions
+        {
+            size_t taps = 0;
+
+            std::vector<uint32_t> starts = {};
+            std::vector<float> weights = {};
+
+            const float* weightsOf(size_t index) const
+            {
+                return weights.data() + index * taps;
+            }
+        };
+
+        Contributions computeContributions(uint32_t srcSize, uint32_t dstSize, Filter filter)
+        {
+            double scale = (double)srcSize / dstSize;
+            double filterScale = std::max(scale, 1.0);
+            double support = filterSupport(filter) * filterScale;
+
+            Contributions result = {};
+            result.taps = std::min((size_t)std::ceil(support) * 2 + 1, (size_t)srcSize);
+            result.starts.resize(dstSize);
+            result.weights.resize(dstSize * result.taps);
+
+            for (uint32_t i = 0; i < dstSize; ++i)
+            {
+                double center = (i + 0.5) * scale;
+
+                auto left = (int64_t)std::max(0.0, std::floor(center - support + 0.5));
+                auto right = (int64_t)std::min((double)srcSize, std::floor(center + support + 0.5));
+
+                right = std::clamp(right, left + 1, left + (int64_t)result.taps);
+
+                // Keeps the padded taps inside the source so that the zero
+                // weights can be applied without the bound checks.
+                auto start = std::min(left, (int64_t)(srcSize - result.taps));
+                auto weights = result.weights.data() + i * result.taps + (left - start);
+
+                double sum = 0.0;
+                for (int64_t j = left; j < right; ++j)
+                {
+                    double w = kernel(filter, (j + 0.5 - center) / filterScale);
+                    weights[j - left] = (float)w; sum += w;
+                }
+                if (sum != 0.0)
+                {
+                    for (int64_t j = left; j < right; ++j)
+                    {
+                        weights[j - left] = (float)(weights[j - left] / sum);
+                    }
+                }
+                else weights[0] = 1.0f; // only with the degenerated filters
+
+                result.starts[i] = (uint32_t)start;
+            }
+            return result;
+        }
+
+        template<bool Simd>
+        Image resampleImpl(
+            const ImageView& source,
+            uint32_t width,
+            uint32_t height,
+            Filter filter,
+            bool premultiplied)
+        {
+            Image result(width, height);
+
+            if (source.width == 0 || source.height == 0 || width == 0 || height == 0)
+            {
+                return result;
+            }
+            auto horzContrib = computeContributions(source.width, width, filter);
+            auto vertContrib = computeContributions(source.height, height, filter);
+
+            // Holds one vertically filtered row in floats.
+            std::vector<float> row((size_t)source.width * 4);
+
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                auto srcY = vertContrib.starts[y];
+                auto vertWeights = vertContrib.weightsOf(y);
+
+                std::fill(row.begin(), row.end(), 0.0f);
+
+                for (size_t k = 0; k < vertContrib.taps; ++k)
+                {
+                    float w = vertWeights[k];
+                    if (w == 0.0f) continue;
+
+                    auto src = source.row(srcY + (uint32_t)k);
+#if _D14_PIXEL_UTILS_SSE2
+                    if constexpr (Simd)
+                    {
+                        auto weight = _mm_set1_ps(w);
+                        auto zero = _mm_setzero_si128();
+
+                        for (uint32_t x = 0; x < source.width; ++x)
+                        {
+                            int32_t pixel;
+                            std::memcpy(&pixel, src + x * 4, 4);
+
+                            auto data = _mm_cvtsi32_si128(pixel);
+                            data = _mm_unpacklo_epi8(data, zero);
+                            data = _mm_unpacklo_epi16(data, zero);
+
+                            auto dst = row.data() + x * 4;
+                            auto value = _mm_mul_ps(_mm_cvtepi32_ps(data), weight);
+                            _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), value));
+                        }
+                        continue;
+                    }
+#endif
+                    for (size_t i = 0; i < row.size(); ++i)
+                    {
+                        row[i] += (float)src[i] * w;
+                    }
+                }
+                auto dst = result.row(y);
+
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    auto srcX = horzContrib.starts[x];
+                    auto horzWeights = horzContrib.weightsOf(x);
+#if _D14_PIXEL_UTILS_SSE2
+                    if constexpr (Simd)
+                    {
+                        auto sum = _mm_setzero_ps();
+                        for (size_t k = 0; k < horzContrib.taps; ++k)
+                        {
+                            auto value = _mm_loadu_ps(row.data() + (srcX + k) * 4);
+                            sum = _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(horzWeights[k])));
+                        }
+                        sum = _mm_max_ps(sum, _mm_setzero_ps());
+                        sum = _mm_min_ps(sum, _mm_set1_ps(255.0f));
+
+                        if (premultiplied)
+                        {
+                            sum = _mm_min_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(3, 3, 3, 3)));
+                        }
+                        // Rounds to the nearest (even) integer.
+                        auto data = _mm_cvtps_epi32(sum);
+                        data = _mm_packs_epi32(data, data);
+                        data = _mm_packus_epi16(data, data);
+
+                        auto pixel = _mm_cvtsi128_si32(data);
+                        std::memcpy(dst + x * 4, &pixel, 4);
+                        continue;
+                    }
+#endif
+                    float sum[4] = {};
+                    for (size_t k = 0; k < horzContrib.taps; ++k)
+                    {
+                        auto value = row.data() + (srcX + k) * 4;
+                        for (int c = 0; c < 4; ++c)
+                        {
+                            sum[c] += value[c] * horzWeights[k];
+                        }
+                    }
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        sum[c] = std::clamp(sum[c], 0.0f, 255.0f);
+                    }
+                    if (premultiplied)
+                    {
+                        for (int c = 0; c < 3; ++c)
+                        {
+                            sum[c] = std::min(sum[c], sum[3]);
+                        }
+                    }
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        dst[x * 4 + c] = (uint8_t)std::nearbyint(sum[c]);
+                    }
+                }
+            }
+            return result;
+        }
+    }
+
+    float filterSupport(Filter filter)
+    {
+        switch (filter)
+        {
+        case Filter::Box: return 0.5f;
+        case Filter::Mitchell: return 2.0f;
+        case Filter::Lanczos3: return 3.0f;
+        default: return 0.5f;
+        }
+    }
+
+    Image resample(
+        const ImageView& source,
+        uint32_t width,
+        uint32_t height,
+        Filter filter,
+        bool premultiplied)
+    {
+        return resampleImpl<true>(source, width, height, filter, premultiplied);
+    }
+
+    Image resampleScalar(
+        const ImageView& source,
+        uint32_t width,
+        uint32_t height,
+        Filter filter,
+        bool premultiplied)
+    {
+        return resampleImpl<false>(source, width, height, filter, premultiplied);
+    }
+
+    std::pair<uint32_t, uint32_t> fitSize(
+        uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight)
+    {
+        if (width == 0 || height == 0) return { 0, 0 };
+
+        maxWidth = std::min(maxWidth, width);
+        maxHeight = std::min(maxHeight, height);
+
+        double scale = std::min((double)maxWidth / width, (double)maxHeight / height);
+
+        return
+        {
+            std::max(1u, (uint32_t)std::round(width * scale)),
+            std::max(1u, (uint32_t)std::round(height * scale))
+        };
+    }
+}
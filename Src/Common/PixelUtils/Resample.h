@@ -0,0 +1,49 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/PixelUtils/Image.h"
+
+namespace d14engine::pixel_utils
+{
+    enum class Filter
+    {
+        // Averages the covered source pixels, which is the cheapest one
+        // and suits the integral downscaling (e.g. the mipmaps).
+        Box,
+        // The cubic filter with B = C = 1/3, which rings less than Lanczos.
+        Mitchell,
+        // The windowed sinc filter with 3 lobes, which is the sharpest one.
+        Lanczos3
+    };
+
+    // Returns the radius of the filter in the source pixels (for upscaling).
+    float filterSupport(Filter filter);
+
+    // Scales the image separably with the filter (enlarged by the scale
+    // factor for downscaling so that every source pixel contributes).
+    //
+    // The source should be premultiplied when it has translucent pixels,
+    // or the colors of the transparent pixels will bleed into the result;
+    // with premultiplied set the color channels are also clamped to the
+    // alpha so that the ringing never produces invalid pixels.
+    Image resample(
+        const ImageView& source,
+        uint32_t width,
+        uint32_t height,
+        Filter filter = Filter::Mitchell,
+        bool premultiplied = true);
+
+    // The reference path that produces the same result without SIMD.
+    Image resampleScalar(
+        const ImageView& source,
+        uint32_t width,
+        uint32_t height,
+        Filter filter = Filter::Mitchell,
+        bool premultiplied = true);
+
+    // Returns the largest size (at least 1 x 1) that fits in the bounds
+    // and keeps the aspect ratio, which never exceeds the original size.
+    std::pair<uint32_t, uint32_t> fitSize(
+        uint32_t width, uint32_t height, uint32_t maxWidth, uint32_t maxHeight);
+}
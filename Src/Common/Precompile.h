@@ -6,21 +6,38 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <deque>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <future>
 #include <iomanip>
 #include <iterator>
 #include <list>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <regex>
 #include <set>
+#include <shared_mutex>
 #include <sstream>
 #include <string_view>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -76,6 +93,12 @@ namespace d14engine
 // Windows & DirectX SDK //
 ///////////////////////////
 
+// The cores without any Windows dependency (e.g. the text, pixel and cull
+// utilities, the allocators, the display lists and the software rasterizer)
+// only use the standard library above, so they can also be built for the
+// POSIX systems, where the SDK is not available (see CMakeLists.txt).
+#ifdef _WIN32
+
 #define _D14_AGILITY_SDK true
 
 #if _D14_AGILITY_SDK
@@ -122,6 +145,7 @@ extern "C" { __declspec(dllexport) extern const char* D3D12SDKPath = _D14_AGILIT
 
 #include <DirectXColors.h>
 #include <DirectXMath.h>
+#include <emmintrin.h>
 
 #ifdef _DEBUG
 #include <dxgidebug.h>
@@ -152,6 +176,12 @@ namespace d14engine
 
 #pragma comment(lib, "dxcompiler.lib")
 
+#else
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#endif
+
 ///////////////////
 // Miscellaneous //
 ///////////////////
@@ -160,5 +190,7 @@ constexpr size_t operator""_uz(unsigned long long num)
 {
     return (size_t)num;
 }
+#ifdef _MSC_VER
 // Allows virtual inheritance to solve diamond problem.
 #pragma warning(disable : 4250)
+#endif
@@ -8,6 +8,12 @@ namespace d14engine
 {
     ResourcePack loadResource(WstrRefer name, WstrRefer type)
     {
+        auto archived = AssetArchive::resolve(L"Resources/" + type + L"/" + name);
+        if (archived.has_value())
+        {
+            auto asset = std::make_shared<AssetArchive::Asset>(std::move(archived.value()));
+            return { (void*)asset->data(), asset->size(), asset };
+        }
         auto hModule = GetModuleHandle(nullptr);
 
         auto hResInfo = FindResource(hModule, name.c_str(), type.c_str());
@@ -2,12 +2,20 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/AssetArchive.h"
+
 namespace d14engine
 {
     struct ResourcePack
     {
         void * data = {};
         size_t size = {};
+
+        // Keeps the data of an archived resource alive (empty for the Win32
+        // resources, which live as long as the module).
+        SharedPtr<AssetArchive::Asset> asset = {};
     };
+    // The entry L"Resources/<type>/<name>" of an asset archive mounted at the
+    // root (i.e. L"") takes precedence over the Win32 resource.
     ResourcePack loadResource(WstrRefer name, WstrRefer type);
 }
@@ -2,27 +2,22 @@
 
 #include "Pipeline/2D/Sprite.h"
 
-#include "Common/DirectXError.h"
-
-#include "Renderer/GpuBuffer.h"
-
-using namespace d14engine::renderer;
-
 namespace d14engine::pipeline
 {
-    void Sprite::onRendererUpdateObjectHelper(Renderer* rndr)
+    SpriteInstance Sprite::instance(const atlas_utils::UVRect& uvRect, const TransformSystem::Float4x4& world) const
     {
-        textureData.update(rndr);
-    }
+        SpriteInstance inst = {};
 
-    void Sprite::onRendererDrawD3d12ObjectHelper(Renderer* rndr)
-    {
-        auto buffer = m_buffers.at(rndr->currFrameIndex())->resource();
-        textureData.draw(rndr, { rootParamIndex, buffer->GetGPUVirtualAddress() });
-    }
+        inst.setTransform(world);
 
-    const Sprite::BufferArray& Sprite::buffers() const
-    {
-        return m_buffers;
+        auto unorm8 = [](float value)
+        {
+            return (uint32_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+        };
+        inst.color = unorm8(color.x) | unorm8(color.y) << 8 | unorm8(color.z) << 16 | unorm8(color.w) << 24;
+
+        inst.uvRect = uvRect;
+
+        return inst;
     }
 }
@@ -2,39 +2,46 @@
 
 #include "Common/Precompile.h"
 
+#include "Pipeline/2D/SpriteBatch.h"
 #include "Pipeline/2D/TextureSequence.h"
 
-#include "Renderer/Interfaces/DrawObject.h"
-
-namespace d14engine::renderer { struct ConstantBuffer; }
-
 namespace d14engine::pipeline
 {
-    struct Sprite : renderer::DrawObject
+    // The sprites are not drawn one by one but gathered by the SpriteGroup
+    // that holds them into the instance buffers, so a sprite is only the
+    // data of its instance.
+    //
+    // The position, the size, the rotation and the depth are the local
+    // transform of the node of the sprite in SpriteGroup::transforms, whose
+    // world matrix is what the instance is drawn with.
+    struct Sprite
     {
-        // prevent std::unique_ptr from generating default deleter
-        virtual ~Sprite() = default;
+        TextureSequence textureData = {};
 
-    protected:
-        void onRendererUpdateObjectHelper(renderer::Renderer* rndr) override;
-        void onRendererDrawD3d12ObjectHelper(renderer::Renderer* rndr) override;
+        bool visible = true;
 
-    public:
-        TextureSequence textureData = {};
+        // The center and the size in the space of the parent (on the plane
+        // of z = depth), i.e. in the world space if there is no parent.
+        XMFLOAT2 position = { 0.0f, 0.0f };
+        XMFLOAT2 size = { 1.0f, 1.0f };
+
+        float rotation = 0.0f; // counterclockwise in radians
+
+        // The larger ones are drawn first (i.e. farther from the camera).
+        float depth = 0.0f;
 
-    public:
-        UINT rootParamIndex = 0;
+        // The tint with the straight alpha (premultiplied in the shader).
+        XMFLOAT4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-        // Indicates how many buffers need to be updated in the subsequent render passes.
-        UINT dirtyFrameCount = renderer::FrameResource::g_bufferCount;
+        SpriteBlend blend = SpriteBlend::Alpha;
 
-    protected:
-        using Buffer = UniquePtr<renderer::ConstantBuffer>;
-        using BufferArray = renderer::FrameResource::Array<Buffer>;
+        // A node of SpriteGroup::transforms that the sprite is relative to
+        // (e.g. a ship that carries its turrets), or none for the world.
+        TransformSystem::Handle parent = TransformSystem::g_invalidHandle;
 
-        BufferArray m_buffers = {};
+        // Created, updated and destroyed by the group that draws the sprite.
+        TransformSystem::Handle node = TransformSystem::g_invalidHandle;
 
-    public:
-        const BufferArray& buffers() const;
+        SpriteInstance instance(const atlas_utils::UVRect& uvRect, const TransformSystem::Float4x4& world) const;
     };
 }
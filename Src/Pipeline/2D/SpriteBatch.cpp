@@ -0,0 +1,133 @@
+﻿#include "Common/Precompile.h"
+
+#include "Pipeline/2D/SpriteBatch.h"
+
+namespace d14engine::pipeline
+{
+    void SpriteInstance::setTransform(float x, float y, float width, float height, float rotation)
+    {
+        float c = std::cos(rotation);
+        float s = std::sin(rotation);
+
+        m11 = c * width;
+        m12 = s * width;
+        m21 = -s * height;
+        m22 = c * height;
+
+        dx = x;
+        dy = y;
+    }
+
+    void SpriteInstance::setTransform(const TransformSystem::Float4x4& world)
+    {
+        m11 = world.m[0][0];
+        m12 = world.m[0][1];
+        m21 = world.m[1][0];
+        m22 = world.m[1][1];
+
+        dx = world.m[3][0];
+        dy = world.m[3][1];
+
+        depth = world.m[3][2];
+    }
+
+    void SpriteBatcher::clear()
+    {
+        m_instances.clear();
+        m_items.clear();
+    }
+
+    void SpriteBatcher::reserve(size_t count)
+    {
+        m_instances.reserve(count);
+        m_items.reserve(count);
+    }
+
+    void SpriteBatcher::add(TextureID texture, SpriteBlend blend, const SpriteInstance& instance)
+    {
+        m_items.push_back({ makeKey(texture, blend, instance.depth), (uint32_t)m_instances.size() });
+        m_instances.push_back(instance);
+    }
+
+    size_t SpriteBatcher::size() const
+    {
+        return m_instances.size();
+    }
+
+    uint64_t SpriteBatcher::makeKey(TextureID texture, SpriteBlend blend, float depth)
+    {
+        // depth (32 bits) | blend (2 bits) | texture (20 bits)
+        //
+        // The float bits are flipped to sort as the unsigned integers, and
+        // then inverted to put the farther ones (larger depth) first.
+        auto bits = std::bit_cast<uint32_t>(depth);
+        bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+
+        return ((uint64_t)~bits << 22) | ((uint64_t)blend << 20) | (texture & (g_maxTextureCount - 1));
+    }
+
+    void SpriteBatcher::sortItems()
+    {
+        if (m_items.size() < 2) return;
+
+        // Counts all the bytes in one pass, and the byte that is the same
+        // in all the keys (i.e. a single bucket holds them all) is skipped.
+        std::vector<std::array<size_t, 256>> offsets(8);
+        for (auto& item : m_items)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                ++offsets[i][(item.key >> (i * 8)) & 0xff];
+            }
+        }
+        m_scratch.resize(m_items.size());
+
+        for (int i = 0; i < 8; ++i)
+        {
+            auto& offset = offsets[i];
+            auto shift = i * 8;
+
+            if (offset[(m_items.front().key >> shift) & 0xff] == m_items.size()) continue;
+
+            size_t sum = 0;
+            for (auto& o : offset)
+            {
+                auto count = o;
+                o = sum;
+                sum += count;
+            }
+            for (auto& item : m_items)
+            {
+                m_scratch[offset[(item.key >> shift) & 0xff]++] = item;
+            }
+            m_items.swap(m_scratch);
+        }
+    }
+
+    const SpriteBatcher::BatchArray& SpriteBatcher::build(SpriteInstance* destination)
+    {
+        sortItems();
+
+        m_batches.clear();
+        for (size_t i = 0; i < m_items.size(); ++i)
+        {
+            auto& item = m_items[i];
+            destination[i] = m_instances[item.index];
+
+            auto texture = (TextureID)(item.key & (g_maxTextureCount - 1));
+            auto blend = (SpriteBlend)((item.key >> 20) & 0x3);
+
+            if (m_batches.empty() || m_batches.back().texture != texture || m_batches.back().blend != blend)
+            {
+                m_batches.push_back({ texture, blend, (uint32_t)i, 0 });
+            }
+            ++m_batches.back().instanceCount;
+        }
+        return m_batches;
+    }
+
+    const SpriteBatcher::BatchArray& SpriteBatcher::batches() const
+    {
+        return m_batches;
+    }
+}
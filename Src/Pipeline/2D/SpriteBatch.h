@@ -0,0 +1,110 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/AtlasUtils/TextureAtlas.h"
+
+#include "Pipeline/Data/TransformSystem.h"
+
+namespace d14engine::pipeline
+{
+    // The textures are premultiplied (as the loaders produce them).
+    enum class SpriteBlend : uint8_t
+    {
+        // Overwrites the target (with the alpha ignored).
+        Opaque,
+        // Blends over the target.
+        Alpha,
+        // Adds to the target (e.g. the glows and the particles).
+        Additive
+    };
+    constexpr size_t g_spriteBlendCount = 3;
+
+    // Matches the per-instance input of Sprite.hlsl.
+    struct SpriteInstance
+    {
+        // Maps the corner (x, y) of the unit quad (in [-0.5, 0.5]) to
+        // (x * m11 + y * m21 + dx, x * m12 + y * m22 + dy).
+        float m11 = 1.0f, m12 = 0.0f;
+        float m21 = 0.0f, m22 = 1.0f;
+        float dx = 0.0f, dy = 0.0f;
+
+        float depth = 0.0f;
+
+        // The tint in R8G8B8A8 (with R in the lowest byte).
+        uint32_t color = 0xffffffff;
+
+        atlas_utils::UVRect uvRect = {};
+
+        // Scales the quad to the size, rotates it (counterclockwise in
+        // radians with y pointing up), then moves its center to (x, y).
+        void setTransform(float x, float y, float width, float height, float rotation = 0.0f);
+
+        // Takes the x/y rows and the translation of the world matrix, i.e.
+        // the same as above for a node of the position (x, y, depth), the
+        // scaling (width, height, 1) and the rotation around z.
+        void setTransform(const TransformSystem::Float4x4& world);
+    };
+    static_assert(sizeof(SpriteInstance) == 48);
+
+    // Gathers the sprite instances of a frame and orders them to be drawn
+    // with a few instanced calls, each of which shares the texture and the
+    // blend state (i.e. a batch).
+    //
+    // The scene has no depth buffer, so the instances are ordered from
+    // back to front (the larger depth first), and the ones of the same
+    // depth (e.g. a layer) by the blend state and then the texture, which
+    // means the sprites should share a few depths to be batched well.
+    //
+    // The sorting is a stable radix sort on a 64-bit key (so the same ones
+    // stay in the submission order), which only runs the passes over the
+    // bytes that differ between the keys.
+
+    struct SpriteBatcher
+    {
+        // Identifies the textures of a group (e.g. the SRV slots).
+        using TextureID = uint32_t;
+
+        constexpr static TextureID g_maxTextureCount = 1 << 20;
+
+        struct Batch
+        {
+            TextureID texture = {};
+            SpriteBlend blend = {};
+
+            uint32_t firstInstance = 0;
+            uint32_t instanceCount = 0;
+        };
+        using BatchArray = std::vector<Batch>;
+
+        void clear();
+
+        void reserve(size_t count);
+
+        void add(TextureID texture, SpriteBlend blend, const SpriteInstance& instance);
+
+        size_t size() const;
+
+        // Writes the instances in the draw order to the destination that
+        // holds size() of them (e.g. the mapped upload buffer).
+        const BatchArray& build(SpriteInstance* destination);
+
+        const BatchArray& batches() const;
+
+    protected:
+        std::vector<SpriteInstance> m_instances = {};
+
+        struct SortItem
+        {
+            uint64_t key = {};
+            uint32_t index = {};
+        };
+        std::vector<SortItem> m_items = {}, m_scratch = {};
+
+        BatchArray m_batches = {};
+
+        static uint64_t makeKey(TextureID texture, SpriteBlend blend, float depth);
+
+        void sortItems();
+    };
+}
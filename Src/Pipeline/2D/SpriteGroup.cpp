@@ -2,29 +2,550 @@
 
 #include "Pipeline/2D/SpriteGroup.h"
 
+#include "Common/DirectXError.h"
+
+#include "Renderer/Camera.h"
 #include "Renderer/GpuBuffer.h"
+#include "Renderer/GraphUtils/ParamHelper.h"
+#include "Renderer/GraphUtils/PSO.h"
+#include "Renderer/GraphUtils/Shader.h"
+#include "Renderer/GraphUtils/StaticSampler.h"
+#include "Renderer/Renderer.h"
 
 using namespace d14engine::renderer;
 
 namespace d14engine::pipeline
 {
-    SpriteGroup::SpriteGroup(Renderer* rndr)
+    SpriteGroup::SpriteGroup(Renderer* rndr, UINT maxTextureCount, DXGI_SAMPLE_DESC sampleDesc) : rndr(rndr)
+    {
+        createRootSignature();
+        createPipelineState(sampleDesc);
+        createVertexBuffer();
+        createSrvTable(maxTextureCount);
+    }
+
+    SpriteGroup::~SpriteGroup()
+    {
+        if (m_srvHeap) m_srvHeap->free(m_srvTable);
+    }
+
+    void SpriteGroup::onRendererUpdateLayerHelper(Renderer* rndr)
+    {
+        if (camera) camera->onRendererUpdateObject(rndr);
+
+        ++m_updateCount;
+        m_droppedCount = 0;
+
+        updateTransforms();
+
+        cullSprites();
+
+        m_batcher.clear();
+        m_batcher.reserve(sprites.size() - m_culledCount);
+
+        for (size_t i = 0; i < sprites.size(); ++i)
+        {
+            auto& sprite = sprites[i];
+            if (!sprite->visible) continue;
+
+            // The animations go on out of the view as well.
+            sprite->textureData.update(rndr);
+
+            if (!m_cullingResults.empty() && !m_cullingResults[i]) continue;
+
+            auto frame = sprite->textureData.currFrame();
+            if (frame == nullptr) continue;
+
+            auto id = textureID(frame->texture.Get());
+            if (!id.has_value())
+            {
+                ++m_droppedCount; continue;
+            }
+
+            auto& world = transforms.worldMatrix(sprite->node);
+            m_batcher.add(id.value(), sprite->blend, sprite->instance(frame->uvRect, world));
+        }
+        // The buffer of the current frame is no longer used by the GPU
+        // (after Renderer::waitCurrFrameResource), so it can be rewritten.
+        auto& buffer = m_instanceBuffers.at(rndr->currFrameIndex());
+        if (!buffer || buffer->elemCount() < m_batcher.size())
+        {
+            auto elemCount = std::bit_ceil(std::max(m_batcher.size(), 1024_uz));
+            buffer = std::make_unique<UploadBuffer>(rndr->d3d12Device(), (UINT)elemCount, sizeof(SpriteInstance), rndr->gpuAllocator().get());
+        }
+        m_batcher.build((SpriteInstance*)buffer->mapped());
+    }
+
+    void SpriteGroup::updateSpriteNode(Sprite& sprite)
     {
+        auto node = sprite.node;
+        bool created = node >= m_spriteNodes.size() || m_spriteNodes[node].sprite != &sprite;
+
+        if (created)
+        {
+            node = sprite.node = transforms.create();
+            if (node >= m_spriteNodes.size()) m_spriteNodes.resize(node + 1);
+
+            m_spriteNodes[node] = { .sprite = &sprite };
+        }
+        auto& cache = m_spriteNodes[node];
+        cache.lastSeen = m_updateCount;
+
+        if (created || cache.position.x != sprite.position.x ||
+            cache.position.y != sprite.position.y || cache.depth != sprite.depth)
+        {
+            cache.position = sprite.position;
+            cache.depth = sprite.depth;
+
+            transforms.setPosition(node, { sprite.position.x, sprite.position.y, sprite.depth });
+        }
+        if (created || cache.size.x != sprite.size.x || cache.size.y != sprite.size.y)
+        {
+            cache.size = sprite.size;
+
+            transforms.setScaling(node, { sprite.size.x, sprite.size.y, 1.0f });
+        }
+        if (created || cache.rotation != sprite.rotation)
+        {
+            cache.rotation = sprite.rotation;
+
+            using Quaternion = TransformSystem::Quaternion;
+            transforms.setRotation(node, Quaternion::fromRollPitchYaw(0.0f, 0.0f, sprite.rotation));
+        }
+        // Compared with the actual one since destroying the parent attaches
+        // the node to the grandparent, and the invalid parents (or the ones
+        // that make a cycle) are ignored.
+        if (transforms.parent(node) != sprite.parent)
+        {
+            transforms.setParent(node, sprite.parent);
+        }
+    }
+
+    void SpriteGroup::updateTransforms()
+    {
+        for (auto& sprite : sprites) updateSpriteNode(*sprite);
+
+        // The sprites that have been removed from the group since the last
+        // update, whose children are attached to their parents then.
+        for (size_t node = 0; node < m_spriteNodes.size(); ++node)
+        {
+            auto& cache = m_spriteNodes[node];
+            if (cache.sprite != nullptr && cache.lastSeen != m_updateCount)
+            {
+                transforms.destroy((TransformSystem::Handle)node);
+                cache = {};
+            }
+        }
+        transforms.update();
+    }
+
+    void SpriteGroup::cullSprites()
+    {
+        m_culledCount = 0;
+        m_cullingResults.clear();
+
+        if (!frustumCulling || !camera) return;
+
+        // Indexed as the sprites, where the invisible ones are empty spheres
+        // at the origin and skipped anyway.
+        m_cullingSpheres.clear();
+        m_cullingSpheres.reserve(sprites.size());
+
+        for (auto& sprite : sprites)
+        {
+            cull_utils::Sphere sphere = {};
+            if (sprite->visible)
+            {
+                // The corners of the quad are at +-0.5 of the x/y rows from
+                // the translation, so the farthest one is off by a half of
+                // sqrt(|x|^2 + |y|^2 + 2|x.y|), which holds for the parents
+                // of any rotation and scaling.
+                auto& m = transforms.worldMatrix(sprite->node).m;
+
+                float xx = m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2];
+                float yy = m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2];
+                float xy = m[0][0] * m[1][0] + m[0][1] * m[1][1] + m[0][2] * m[1][2];
+
+                sphere = { m[3][0], m[3][1], m[3][2], 0.5f * std::sqrt(xx + yy + 2.0f * std::abs(xy)) };
+            }
+            m_cullingSpheres.push_back(sphere);
+        }
+        m_cullingResults.resize(sprites.size());
+        cull_utils::cull(camera->frustum(), m_cullingSpheres, m_cullingResults.data());
+
+        for (size_t i = 0; i < sprites.size(); ++i)
+        {
+            if (sprites[i]->visible && !m_cullingResults[i]) ++m_culledCount;
+        }
     }
 
     void SpriteGroup::onRendererDrawD3d12LayerHelper(Renderer* rndr)
     {
+        auto& batches = m_batcher.batches();
+        if (batches.empty() || !camera) return;
+
+        auto cmdList = rndr->cmdList();
+
+        ////////////////
+        // Rasterizer //
+        ////////////////
+
+        auto viewport = camera->viewport();
+        auto scissors = camera->scissors();
+
+        cmdList->RSSetViewports(1, &viewport);
+        cmdList->RSSetScissorRects(1, &scissors);
+
+        ////////////////////
+        // Shader Context //
+        ////////////////////
+
+        cmdList->SetGraphicsRootSignature(m_rootSigature.Get());
+
+        auto cameraBuffer = camera->buffers().at(rndr->currFrameIndex())->resource();
+        cmdList->SetGraphicsRootConstantBufferView(0, cameraBuffer->GetGPUVirtualAddress());
+
+        ID3D12DescriptorHeap* ppHeaps[] = { m_srvHeap->heap() };
+        cmdList->SetDescriptorHeaps(NUM_ARR_ARGS(ppHeaps));
+
+        /////////////////////
+        // Input Assembler //
+        /////////////////////
+
+        auto& instanceBuffer = m_instanceBuffers.at(rndr->currFrameIndex());
+
+        D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[] =
+        {
+            m_vertexBufferView,
+            {
+                .BufferLocation = instanceBuffer->resource()->GetGPUVirtualAddress(),
+                .SizeInBytes    = (UINT)(m_batcher.size() * sizeof(SpriteInstance)),
+                .StrideInBytes  = sizeof(SpriteInstance)
+            }
+        };
+        cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        cmdList->IASetVertexBuffers(0, NUM_ARR_ARGS(vertexBufferViews));
+
+        /////////////
+        // Batches //
+        /////////////
+
+        Optional<SpriteBlend> currBlend = {};
+
+        for (auto& batch : batches)
+        {
+            if (currBlend != batch.blend)
+            {
+                currBlend = batch.blend;
+                cmdList->SetPipelineState(m_pipelineStates[(size_t)batch.blend].Get());
+            }
+            cmdList->SetGraphicsRootDescriptorTable(1, m_srvTable.gpu(batch.texture));
+
+            cmdList->DrawInstanced
+            (
+            /* VertexCountPerInstance */ 4,
+            /* InstanceCount          */ batch.instanceCount,
+            /* StartVertexLocation    */ 0,
+            /* StartInstanceLocation  */ batch.firstInstance
+            );
+        }
     }
 
     void SpriteGroup::createRootSignature()
     {
+        CD3DX12_DESCRIPTOR_RANGE1 descRange(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+
+        CD3DX12_ROOT_PARAMETER1 rootParams[2] = {};
+        rootParams[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_VERTEX);
+        rootParams[1].InitAsDescriptorTable(1, &descRange, D3D12_SHADER_VISIBILITY_PIXEL);
+
+        D3D12_ROOT_SIGNATURE_FLAGS rootSigFlags =
+        (
+            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
+
+            // Only VS and PS are needed to draw the quads.
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+            D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS
+        );
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSigDesc = {};
+        rootSigDesc.Init_1_1
+        (
+        /* numParameters     */ _countof(rootParams),
+        /* _pParameters      */ rootParams,
+        /* numStaticSamplers */ 1,
+        /* _pStaticSamplers  */ graph_utils::static_sampler::linearClamp(0),
+        /* flags             */ rootSigFlags
+        );
+        ComPtr<ID3DBlob> rootSigBlob = {};
+
+        THROW_IF_ERROR(D3DX12SerializeVersionedRootSignature
+        (
+        /* pRootSignatureDesc */ &rootSigDesc,
+        /* MaxVersion         */ rndr->d3d12DeviceInfo().feature.rootSignature.HighestVersion,
+        /* ppBlob             */ &rootSigBlob,
+        /* ppErrorBlob        */ ppErrorBlob
+        ));
+        THROW_IF_FAILED(rndr->d3d12Device()->CreateRootSignature
+        (
+        /* nodeMask               */ 0,
+        /* pBlobWithRootSignature */
+        /* blobLengthInBytes      */ BLB_PSZ_ARGS(rootSigBlob),
+        /* riid                   */
+        /* ppvRootSignature       */ IID_PPV_ARGS(&m_rootSigature)
+        ));
     }
 
-    void SpriteGroup::createPipelineState()
+    void SpriteGroup::createPipelineState(DXGI_SAMPLE_DESC sampleDesc)
     {
+        graph_utils::shader::Package shaders =
+        {
+            { L"VS", {{ L"VS", L"vs_6_0" }} },
+            { L"PS", {{ L"PS", L"ps_6_0" }} }
+        };
+        graph_utils::shader::loadDefaultObject
+        (
+            rndr->createInfo.shaderPath(), L"Sprite",
+            { graph_utils::shader::HLSL }, shaders
+        );
+
+        // The per-vertex elements are the unit quad (slot 0), and the
+        // per-instance ones match the layout of SpriteInstance (slot 1).
+        D3D12_INPUT_ELEMENT_DESC inputElemDescs[] =
+        {{
+            .SemanticName         = "POSITION",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32G32_FLOAT,
+            .InputSlot            = 0,
+            .AlignedByteOffset    = 0,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+            .InstanceDataStepRate = 0
+        },{
+            .SemanticName         = "TEXCOORD",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32G32_FLOAT,
+            .InputSlot            = 0,
+            .AlignedByteOffset    = D3D12_APPEND_ALIGNED_ELEMENT,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+            .InstanceDataStepRate = 0
+        },{
+            .SemanticName         = "TRANSFORM",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32G32B32A32_FLOAT,
+            .InputSlot            = 1,
+            .AlignedByteOffset    = 0,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+            .InstanceDataStepRate = 1
+        },{
+            .SemanticName         = "TRANSLATION",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32G32_FLOAT,
+            .InputSlot            = 1,
+            .AlignedByteOffset    = D3D12_APPEND_ALIGNED_ELEMENT,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+            .InstanceDataStepRate = 1
+        },{
+            .SemanticName         = "DEPTH",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32_FLOAT,
+            .InputSlot            = 1,
+            .AlignedByteOffset    = D3D12_APPEND_ALIGNED_ELEMENT,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+            .InstanceDataStepRate = 1
+        },{
+            .SemanticName         = "COLOR",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R8G8B8A8_UNORM,
+            .InputSlot            = 1,
+            .AlignedByteOffset    = D3D12_APPEND_ALIGNED_ELEMENT,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+            .InstanceDataStepRate = 1
+        },{
+            .SemanticName         = "UVRECT",
+            .SemanticIndex        = 0,
+            .Format               = DXGI_FORMAT_R32G32B32A32_FLOAT,
+            .InputSlot            = 1,
+            .AlignedByteOffset    = D3D12_APPEND_ALIGNED_ELEMENT,
+            .InputSlotClass       = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+            .InstanceDataStepRate = 1
+        }};
+
+        auto psoDesc = graph_utils::GPSODescTemplate();
+
+        psoDesc.pRootSignature = m_rootSigature.Get();
+        psoDesc.VS = { BLB_PSZ_ARGS(shaders[L"VS"].blob) };
+        psoDesc.PS = { BLB_PSZ_ARGS(shaders[L"PS"].blob) };
+        psoDesc.InputLayout = { ARR_NUM_ARGS(inputElemDescs) };
+        psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+        psoDesc.SampleDesc = sampleDesc;
+
+        // There is no depth buffer in the scene (the instances are drawn
+        // from back to front), and the quads may be mirrored by the size.
+        psoDesc.DepthStencilState.DepthEnable = FALSE;
+        psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+
+        for (size_t i = 0; i < g_spriteBlendCount; ++i)
+        {
+            auto& rtBlend = psoDesc.BlendState.RenderTarget[0];
+            switch ((SpriteBlend)i)
+            {
+            case SpriteBlend::Opaque:
+            {
+                rtBlend.BlendEnable = FALSE;
+                break;
+            }
+            case SpriteBlend::Alpha:
+            {
+                rtBlend.BlendEnable = TRUE;
+                rtBlend.SrcBlend = D3D12_BLEND_ONE;
+                rtBlend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+                rtBlend.SrcBlendAlpha = D3D12_BLEND_ONE;
+                rtBlend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+                break;
+            }
+            case SpriteBlend::Additive:
+            {
+                rtBlend.BlendEnable = TRUE;
+                rtBlend.SrcBlend = D3D12_BLEND_ONE;
+                rtBlend.DestBlend = D3D12_BLEND_ONE;
+                rtBlend.SrcBlendAlpha = D3D12_BLEND_ZERO;
+                rtBlend.DestBlendAlpha = D3D12_BLEND_ONE;
+                break;
+            }
+            default: break;
+            }
+            THROW_IF_FAILED(rndr->d3d12Device()->CreateGraphicsPipelineState
+            (
+            /* pDesc           */ &psoDesc,
+            /* riid            */
+            /* ppPipelineState */ IID_PPV_ARGS(&m_pipelineStates[i])
+            ));
+        }
     }
 
     void SpriteGroup::createVertexBuffer()
     {
+        // The unit quad centered at the origin (see SpriteInstance)
+        // with y pointing up as in the world space of the camera.
+        Vertex quad[] =
+        {
+        /* Top    Left  */ { { -0.5f, +0.5f }, { 0.0f, 0.0f } },
+        /* Top    Right */ { { +0.5f, +0.5f }, { 1.0f, 0.0f } },
+        /* Bottom Left  */ { { -0.5f, -0.5f }, { 0.0f, 1.0f } },
+        /* Bottom Right */ { { +0.5f, -0.5f }, { 1.0f, 1.0f } }
+        };
+        m_vertexBuffer = std::make_unique<DefaultBuffer>
+        (
+            rndr->d3d12Device(), sizeof(quad),
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+            rndr->gpuAllocator().get()
+        );
+        m_vertexBuffer->uploadData(rndr->uploadQueue().get(), quad, sizeof(quad));
+
+        m_vertexBufferView.BufferLocation = m_vertexBuffer->resource()->GetGPUVirtualAddress();
+        m_vertexBufferView.SizeInBytes = sizeof(quad);
+        m_vertexBufferView.StrideInBytes = sizeof(Vertex);
+    }
+
+    void SpriteGroup::createSrvTable(UINT maxTextureCount)
+    {
+        maxTextureCount = std::clamp(maxTextureCount, 1u, SpriteBatcher::g_maxTextureCount);
+
+        m_srvHeap = rndr->srvDescriptors();
+
+        auto table = m_srvHeap->allocate(maxTextureCount);
+        THROW_IF_FALSE(table.has_value());
+
+        m_srvTable = table.value();
+    }
+
+    bool SpriteGroup::isTextureInFlight(const TextureSlot& slot) const
+    {
+        return slot.lastUse + FrameResource::g_bufferCount > m_updateCount;
+    }
+
+    Optional<SpriteBatcher::TextureID> SpriteGroup::textureID(ID3D12Resource* texture)
+    {
+        auto itor = m_textureIDs.find(texture);
+        if (itor != m_textureIDs.end())
+        {
+            m_textureSlots[itor->second].lastUse = m_updateCount;
+            return itor->second;
+        }
+        SpriteBatcher::TextureID id = {};
+
+        if (!m_freeTextureIDs.empty())
+        {
+            id = m_freeTextureIDs.back();
+            m_freeTextureIDs.pop_back();
+        }
+        else if (m_textureSlots.size() < m_srvTable.range.count)
+        {
+            id = (SpriteBatcher::TextureID)m_textureSlots.size();
+            m_textureSlots.emplace_back();
+        }
+        else // Replaces the least recently drawn one.
+        {
+            auto slot = std::min_element(m_textureSlots.begin(), m_textureSlots.end(),
+                [](const TextureSlot& a, const TextureSlot& b) { return a.lastUse < b.lastUse; });
+
+            if (isTextureInFlight(*slot)) return std::nullopt;
+
+            id = (SpriteBatcher::TextureID)(slot - m_textureSlots.begin());
+            m_textureIDs.erase(slot->texture.Get());
+        }
+        auto textureDesc = texture->GetDesc();
+
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = textureDesc.Format;
+        srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+        srvDesc.Texture2D.MipLevels = textureDesc.MipLevels;
+        rndr->d3d12Device()->CreateShaderResourceView(texture, &srvDesc, m_srvTable.cpu(id));
+
+        m_textureSlots[id] = { texture, m_updateCount };
+        m_textureIDs[texture] = id;
+
+        return id;
+    }
+
+    void SpriteGroup::releaseUnusedTextures()
+    {
+        for (size_t id = 0; id < m_textureSlots.size(); ++id)
+        {
+            auto& slot = m_textureSlots[id];
+            if (slot.texture && !isTextureInFlight(slot))
+            {
+                m_textureIDs.erase(slot.texture.Get());
+                slot = {};
+
+                m_freeTextureIDs.push_back((SpriteBatcher::TextureID)id);
+            }
+        }
+    }
+
+    UINT SpriteGroup::textureCount() const
+    {
+        return (UINT)m_textureIDs.size();
+    }
+
+    size_t SpriteGroup::droppedCount() const
+    {
+        return m_droppedCount;
+    }
+
+    size_t SpriteGroup::instanceCount() const
+    {
+        return m_batcher.size();
+    }
+
+    size_t SpriteGroup::culledCount() const
+    {
+        return m_culledCount;
+    }
+
+    const SpriteBatcher::BatchArray& SpriteGroup::batches() const
+    {
+        return m_batcher.batches();
     }
 }
@@ -2,41 +2,184 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/CullUtils/Frustum.h"
+
+#include "Pipeline/2D/Sprite.h"
+#include "Pipeline/2D/SpriteBatch.h"
+
+#include "Renderer/DescriptorHeap.h"
+#include "Renderer/FrameData/FrameResource.h"
 #include "Renderer/Interfaces/DrawLayer.h"
 
 namespace d14engine::renderer
 {
+    struct Camera;
     struct DefaultBuffer;
     struct Renderer;
+    struct UploadBuffer;
 }
 namespace d14engine::pipeline
 {
+    // Draws the sprites with a few instanced calls: in each update, the
+    // instances are gathered and sorted by SpriteBatcher into the instance
+    // buffer of the current frame, and then each batch is drawn with one
+    // DrawInstanced of the unit quad.
+    //
+    // Each sprite gets a node in the transforms of the group when it is
+    // first gathered, whose local transform follows the sprite, and all
+    // the world matrices are updated at once per frame (the dirty ones).
+    // The node is destroyed after the sprite is removed from the group.
+    //
+    // The sprites out of the frustum of the camera are culled in batches
+    // (see cull_utils::cull) before being gathered, so they are neither
+    // uploaded nor drawn.
+    //
+    // The textures get their SRVs in the table of the group (allocated from
+    // Renderer::srvDescriptors) when they are first drawn, and they are kept
+    // alive in their slots until the table is full, after which the least
+    // recently drawn one that no frame in flight refers to gives its slot
+    // to the new texture.  If there is no such one, the sprites of the new
+    // texture are skipped in that frame and counted in droppedCount.
+
     struct SpriteGroup : renderer::DrawLayer
     {
-        explicit SpriteGroup(renderer::Renderer* rndr);
+        // GPU Commands Required
+        // The sample desc must match the render target, e.g. the MSAA
+        // setting of the ScenePanel that the group is drawn in.
+        SpriteGroup(
+            renderer::Renderer* rndr,
+            UINT maxTextureCount = 1024,
+            DXGI_SAMPLE_DESC sampleDesc = { 1, 0 });
 
-        // prevent std::unique_ptr from generating default deleter
-        virtual ~SpriteGroup() = default;
+        virtual ~SpriteGroup();
 
     protected:
+        void onRendererUpdateLayerHelper(renderer::Renderer* rndr) override;
         void onRendererDrawD3d12LayerHelper(renderer::Renderer* rndr) override;
 
+    public:
+        // Provides the viewport, the scissors and the view/proj matrices,
+        // which is updated by the group (i.e. not added as a draw object).
+        SharedPtr<renderer::Camera> camera = {};
+
+        // The ones of the same depth, blend state and texture are drawn
+        // in this order.
+        std::vector<SharedPtr<Sprite>> sprites = {};
+
+        bool frustumCulling = true;
+
+        // Holds the nodes of the sprites, and the ones created by the user
+        // as the parents of the sprites (which are kept as they are).
+        TransformSystem transforms = {};
+
     protected:
+        renderer::Renderer* rndr = nullptr;
+
         ComPtr<ID3D12RootSignature> m_rootSigature = {};
-        ComPtr<ID3D12PipelineState> m_pipelineState = {};
+
+        std::array<ComPtr<ID3D12PipelineState>, g_spriteBlendCount> m_pipelineStates = {};
 
         struct Vertex
         {
-            XMFLOAT3 position = {};
+            XMFLOAT2 corner = {};
             XMFLOAT2 texcoord = {};
         };
-
         UniquePtr<renderer::DefaultBuffer> m_vertexBuffer = {};
         D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView = {};
 
-    protected:
         void createRootSignature();
-        void createPipelineState();
+        void createPipelineState(DXGI_SAMPLE_DESC sampleDesc);
         void createVertexBuffer();
+
+    protected:
+        // The texture table is a contiguous range of the shared SRV heap,
+        // so no heap switch is needed between the groups.
+        SharedPtr<renderer::DescriptorHeap> m_srvHeap = {};
+        renderer::DescriptorHeap::Descriptor m_srvTable = {};
+
+        struct TextureSlot
+        {
+            ComPtr<ID3D12Resource> texture = {};
+
+            // The update in which the texture was drawn last time.
+            UINT64 lastUse = 0;
+        };
+        // Indexed by the texture IDs, i.e. the slots of the SRV table.
+        std::vector<TextureSlot> m_textureSlots = {};
+        std::unordered_map<ID3D12Resource*, SpriteBatcher::TextureID> m_textureIDs = {};
+
+        std::vector<SpriteBatcher::TextureID> m_freeTextureIDs = {};
+
+        // Counts the updates, and the draw commands of an update are done
+        // after g_bufferCount more updates (see FrameResource).
+        UINT64 m_updateCount = 0;
+
+        size_t m_droppedCount = 0;
+
+        void createSrvTable(UINT maxTextureCount);
+
+        bool isTextureInFlight(const TextureSlot& slot) const;
+
+        // Returns std::nullopt if every slot is referred to by the frames
+        // in flight.
+        Optional<SpriteBatcher::TextureID> textureID(ID3D12Resource* texture);
+
+    public:
+        // Frees the slots of the textures that no frame in flight refers
+        // to, e.g. after the sprites have changed their textures.
+        void releaseUnusedTextures();
+
+    protected:
+        struct SpriteNode
+        {
+            // The sprite that the node was created for, which is compared
+            // as the address only (it may be gone).
+            const Sprite* sprite = nullptr;
+
+            // The update in which the sprite was gathered last time.
+            UINT64 lastSeen = 0;
+
+            // The local transform written last time, so that the unchanged
+            // sprites do not mark their nodes dirty.
+            XMFLOAT2 position = {}, size = {};
+            float rotation = {}, depth = {};
+        };
+        // Indexed by the handles of the transforms.
+        std::vector<SpriteNode> m_spriteNodes = {};
+
+        void updateSpriteNode(Sprite& sprite);
+
+        void updateTransforms();
+
+    protected:
+        // The bounding spheres of the visible sprites (rotation-invariant),
+        // which are reused in each update.
+        cull_utils::SphereArray m_cullingSpheres = {};
+        std::vector<uint8_t> m_cullingResults = {};
+
+        size_t m_culledCount = 0;
+
+        void cullSprites();
+
+    protected:
+        SpriteBatcher m_batcher = {};
+
+        // Grows to fit the instances (by powers of 2) and never shrinks.
+        using InstanceBuffer = UniquePtr<renderer::UploadBuffer>;
+        renderer::FrameResource::Array<InstanceBuffer> m_instanceBuffers = {};
+
+    public:
+        UINT textureCount() const;
+
+        // The sprites skipped in the current frame as the table is full.
+        size_t droppedCount() const;
+
+        size_t instanceCount() const;
+
+        // The visible sprites out of the frustum in the current frame.
+        size_t culledCount() const;
+
+        // The batches drawn in the current frame (e.g. for the statistics).
+        const SpriteBatcher::BatchArray& batches() const;
     };
 }
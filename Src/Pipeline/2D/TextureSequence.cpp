@@ -2,13 +2,9 @@
 
 #include "Pipeline/2D/TextureSequence.h"
 
-#include "Renderer/GpuBuffer.h"
-
-using namespace d14engine::renderer;
-
 namespace d14engine::pipeline
 {
-    void TextureSequence::draw(Renderer* rndr, const BufferInfo& info)
+    const TextureFrame* TextureSequence::currFrame() const
     {
         if (visible)
         {
@@ -16,12 +12,12 @@ namespace d14engine::pipeline
             if (index.has_value())
             {
                 auto& f = fanim.frames[index.value()];
-                if (f)
+                if (f.texture)
                 {
-                    rndr->cmdList()->SetGraphicsRootConstantBufferView(
-                        info.rootParamIndex, info.gpuVirtAddr);
+                    return &f;
                 }
             }
         }
+        return nullptr;
     }
 }
@@ -2,19 +2,25 @@
 
 #include "Common/Precompile.h"
 
-#include "Renderer/FrameData/FrameSequence.h"
+#include "Common/AtlasUtils/TextureAtlas.h"
 
-namespace d14engine::renderer { struct DefaultBuffer; }
+#include "Renderer/FrameData/FrameSequence.h"
 
 namespace d14engine::pipeline
 {
-    struct TextureSequence : renderer::FrameSequence<SharedPtr<renderer::DefaultBuffer>>
+    struct TextureFrame
+    {
+        // A 2D texture in the PIXEL_SHADER_RESOURCE state, e.g. the resource
+        // of graph_utils::texture::loadMipmapped.
+        ComPtr<ID3D12Resource> texture = {};
+
+        // The frames packed in an atlas share the texture, and each one
+        // is the region of the UV rectangle in it.
+        atlas_utils::UVRect uvRect = {};
+    };
+    struct TextureSequence : renderer::FrameSequence<TextureFrame>
     {
-        struct BufferInfo
-        {
-            UINT rootParamIndex;
-            D3D12_GPU_VIRTUAL_ADDRESS gpuVirtAddr;
-        };
-        void draw(renderer::Renderer* rndr, const BufferInfo& info);
+        // Returns nullptr if invisible or the current frame has no texture.
+        const TextureFrame* currFrame() const;
     };
 }
@@ -1 +1,41 @@
 ﻿#include "Common/Precompile.h"
+
+#include "Pipeline/Cameras/Camera2D.h"
+
+namespace d14engine::pipeline
+{
+    Camera2D::Camera2D(ID3D12Device* device) : Camera(device)
+    {
+        nearZ = 0.0f;
+        farZ = 1000.0f;
+    }
+
+    void Camera2D::updateViewMatrix()
+    {
+        eyePos = { position.x, position.y, 0.0f };
+        eyeDir = { 0.0f, 0.0f, 1.0f };
+
+        up = { -std::sin(rotation), std::cos(rotation), 0.0f };
+
+        Camera::updateViewMatrix();
+    }
+
+    void Camera2D::updateProjMatrix()
+    {
+        auto width = m_viewport.Width / zoom;
+        auto height = m_viewport.Height / zoom;
+
+        XMStoreFloat4x4(&m_data.projMatrix, XMMatrixOrthographicLH(width, height, nearZ, farZ));
+    }
+
+    XMFLOAT2 Camera2D::viewportToWorld(const XMFLOAT2& point) const
+    {
+        auto dx = (point.x - m_viewport.TopLeftX - m_viewport.Width * 0.5f) / zoom;
+        auto dy = (m_viewport.TopLeftY + m_viewport.Height * 0.5f - point.y) / zoom;
+
+        auto c = std::cos(rotation);
+        auto s = std::sin(rotation);
+
+        return { position.x + dx * c - dy * s, position.y + dx * s + dy * c };
+    }
+}
@@ -1,3 +1,34 @@
 ﻿#pragma once
 
 #include "Common/Precompile.h"
+
+#include "Renderer/Camera.h"
+
+namespace d14engine::pipeline
+{
+    // An orthographic camera looking along +z (with y pointing up), whose
+    // view is centered at the position and scaled by the zoom, which means
+    // a world unit spans zoom pixels.  The depth in [nearZ, farZ] is kept
+    // for the draw order (e.g. the depth of the sprites).
+    //
+    // After changing the parameters, updateViewMatrix/updateProjMatrix
+    // need to be called as the base camera requires.
+
+    struct Camera2D : renderer::Camera
+    {
+        explicit Camera2D(ID3D12Device* device);
+
+        XMFLOAT2 position = { 0.0f, 0.0f };
+
+        float rotation = 0.0f; // counterclockwise in radians
+
+        float zoom = 1.0f;
+
+        void updateViewMatrix() override;
+        void updateProjMatrix() override;
+
+        // Maps the point in the viewport (in pixels with y pointing down)
+        // to the world space, e.g. to pick the objects by the mouse.
+        XMFLOAT2 viewportToWorld(const XMFLOAT2& point) const;
+    };
+}
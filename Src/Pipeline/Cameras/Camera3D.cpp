@@ -1 +1,51 @@
 ﻿#include "Common/Precompile.h"
+
+#include "Pipeline/Cameras/Camera3D.h"
+
+namespace d14engine::pipeline
+{
+    Camera3D::Camera3D(ID3D12Device* device) : Camera(device)
+    {
+        // Here left blank intentionally.
+    }
+
+    void Camera3D::updateViewMatrix()
+    {
+        constexpr float maxPitch = XM_PIDIV2 - 0.001f;
+        pitch = std::clamp(pitch, -maxPitch, maxPitch);
+
+        eyeDir =
+        {
+            std::cos(pitch) * std::sin(yaw),
+            std::sin(pitch),
+            std::cos(pitch) * std::cos(yaw)
+        };
+        up = { 0.0f, 1.0f, 0.0f };
+
+        Camera::updateViewMatrix();
+    }
+
+    void Camera3D::lookAt(const XMFLOAT3& target)
+    {
+        auto dx = target.x - eyePos.x;
+        auto dy = target.y - eyePos.y;
+        auto dz = target.z - eyePos.z;
+
+        yaw = std::atan2(dx, dz);
+        pitch = std::atan2(dy, std::sqrt(dx * dx + dz * dz));
+    }
+
+    void Camera3D::moveLocal(const XMFLOAT3& offset)
+    {
+        auto forward = XMLoadFloat3(&eyeDir);
+        auto upward = XMLoadFloat3(&up);
+        auto right = XMVector3Normalize(XMVector3Cross(upward, forward));
+
+        auto position = XMLoadFloat3(&eyePos);
+        position = XMVectorAdd(position, XMVectorScale(right, offset.x));
+        position = XMVectorAdd(position, XMVectorScale(upward, offset.y));
+        position = XMVectorAdd(position, XMVectorScale(forward, offset.z));
+
+        XMStoreFloat3(&eyePos, position);
+    }
+}
@@ -1,3 +1,34 @@
 ﻿#pragma once
 
 #include "Common/Precompile.h"
+
+#include "Renderer/Camera.h"
+
+namespace d14engine::pipeline
+{
+    // A perspective camera oriented by the yaw and the pitch (e.g. for the
+    // first-person views), which keeps eyeDir and up in sync with them.
+    //
+    // After changing the parameters, updateViewMatrix/updateProjMatrix
+    // need to be called as the base camera requires.
+
+    struct Camera3D : renderer::Camera
+    {
+        explicit Camera3D(ID3D12Device* device);
+
+        // Turns around +y in radians, and 0 looks along +z.
+        float yaw = 0.0f;
+
+        // Turns up (positive) or down in radians, which is kept in
+        // (-pi/2, pi/2) so that the view never flips.
+        float pitch = 0.0f;
+
+        void updateViewMatrix() override;
+
+        // Sets the yaw and the pitch to face the target from eyePos.
+        void lookAt(const XMFLOAT3& target);
+
+        // Moves eyePos by the offset in the view space (right, up, forward).
+        void moveLocal(const XMFLOAT3& offset);
+    };
+}
@@ -0,0 +1,444 @@
+﻿#include "Common/Precompile.h"
+
+#include "Pipeline/Data/TransformSystem.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_TRANSFORM_SYSTEM_SSE2 true
+#else
+#define _D14_TRANSFORM_SYSTEM_SSE2 false
+#endif
+
+namespace d14engine::pipeline
+{
+    TransformSystem::Quaternion TransformSystem::Quaternion::fromRollPitchYaw(float pitch, float yaw, float roll)
+    {
+        auto sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+        auto sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+        auto sr = std::sin(roll * 0.5f), cr = std::cos(roll * 0.5f);
+
+        return
+        {
+            cr * sp * cy + sr * cp * sy,
+            cr * cp * sy - sr * sp * cy,
+            sr * cp * cy - cr * sp * sy,
+            cr * cp * cy + sr * sp * sy
+        };
+    }
+
+    TransformSystem::Handle TransformSystem::create(Handle parent)
+    {
+        Handle node = {};
+        if (!m_freeHandles.empty())
+        {
+            node = m_freeHandles.back();
+            m_freeHandles.pop_back();
+
+            m_positionX[node] = m_positionY[node] = m_positionZ[node] = 0.0f;
+            m_rotationX[node] = m_rotationY[node] = m_rotationZ[node] = 0.0f;
+            m_rotationW[node] = 1.0f;
+            m_scalingX[node] = m_scalingY[node] = m_scalingZ[node] = 1.0f;
+
+            m_parents[node] = m_firstChildren[node] = m_nextSiblings[node] = g_invalidHandle;
+            m_depths[node] = 0;
+
+            m_alive[node] = true;
+            m_worldMatrices[node] = {};
+
+            // A stale entry may be left in the dirty list by destroy(),
+            // and then the flag stays set so that markDirty reuses it.
+        }
+        else // append
+        {
+            node = (Handle)m_alive.size();
+
+            m_positionX.push_back(0.0f); m_positionY.push_back(0.0f); m_positionZ.push_back(0.0f);
+            m_rotationX.push_back(0.0f); m_rotationY.push_back(0.0f); m_rotationZ.push_back(0.0f); m_rotationW.push_back(1.0f);
+            m_scalingX.push_back(1.0f); m_scalingY.push_back(1.0f); m_scalingZ.push_back(1.0f);
+
+            m_parents.push_back(g_invalidHandle);
+            m_firstChildren.push_back(g_invalidHandle);
+            m_nextSiblings.push_back(g_invalidHandle);
+            m_depths.push_back(0);
+
+            m_alive.push_back(true);
+            m_worldMatrices.emplace_back();
+
+            m_dirty.push_back(false);
+        }
+        if (isValid(parent))
+        {
+            attach(node, parent);
+            m_depths[node] = m_depths[parent] + 1;
+        }
+        markDirty(node);
+
+        return node;
+    }
+
+    void TransformSystem::destroy(Handle node)
+    {
+        if (!isValid(node)) return;
+
+        auto parent = m_parents[node];
+        for (auto child = m_firstChildren[node]; child != g_invalidHandle; )
+        {
+            auto next = m_nextSiblings[child];
+
+            m_parents[child] = m_nextSiblings[child] = g_invalidHandle;
+            if (parent != g_invalidHandle) attach(child, parent);
+
+            updateDepths(child);
+            markDirty(child);
+
+            child = next;
+        }
+        m_firstChildren[node] = g_invalidHandle;
+
+        detach(node);
+
+        m_alive[node] = false;
+        m_freeHandles.push_back(node);
+    }
+
+    bool TransformSystem::isValid(Handle node) const
+    {
+        return node < m_alive.size() && m_alive[node];
+    }
+
+    size_t TransformSystem::size() const
+    {
+        return m_alive.size() - m_freeHandles.size();
+    }
+
+    bool TransformSystem::setParent(Handle node, Handle parent)
+    {
+        if (!isValid(node)) return false;
+
+        if (parent != g_invalidHandle)
+        {
+            if (!isValid(parent)) return false;
+
+            for (auto ancestor = parent; ancestor != g_invalidHandle; ancestor = m_parents[ancestor])
+            {
+                if (ancestor == node) return false;
+            }
+        }
+        if (m_parents[node] != parent)
+        {
+            detach(node);
+            if (parent != g_invalidHandle) attach(node, parent);
+
+            updateDepths(node);
+            markDirty(node);
+        }
+        return true;
+    }
+
+    TransformSystem::Handle TransformSystem::parent(Handle node) const
+    {
+        return m_parents.at(node);
+    }
+
+    void TransformSystem::setPosition(Handle node, const Vector3& value)
+    {
+        m_positionX.at(node) = value.x;
+        m_positionY[node] = value.y;
+        m_positionZ[node] = value.z;
+
+        markDirty(node);
+    }
+
+    void TransformSystem::setRotation(Handle node, const Quaternion& value)
+    {
+        m_rotationX.at(node) = value.x;
+        m_rotationY[node] = value.y;
+        m_rotationZ[node] = value.z;
+        m_rotationW[node] = value.w;
+
+        markDirty(node);
+    }
+
+    void TransformSystem::setScaling(Handle node, const Vector3& value)
+    {
+        m_scalingX.at(node) = value.x;
+        m_scalingY[node] = value.y;
+        m_scalingZ[node] = value.z;
+
+        markDirty(node);
+    }
+
+    TransformSystem::Vector3 TransformSystem::position(Handle node) const
+    {
+        return { m_positionX.at(node), m_positionY[node], m_positionZ[node] };
+    }
+
+    TransformSystem::Quaternion TransformSystem::rotation(Handle node) const
+    {
+        return { m_rotationX.at(node), m_rotationY[node], m_rotationZ[node], m_rotationW[node] };
+    }
+
+    TransformSystem::Vector3 TransformSystem::scaling(Handle node) const
+    {
+        return { m_scalingX.at(node), m_scalingY[node], m_scalingZ[node] };
+    }
+
+    size_t TransformSystem::update()
+    {
+        // Sorts the dirty nodes by the depth (i.e. counting sort), so the
+        // parents are always computed before their children.
+        uint32_t maxDepth = 0;
+        for (auto node : m_dirtyNodes)
+        {
+            if (m_alive[node]) maxDepth = std::max(maxDepth, m_depths[node]);
+        }
+        m_depthOffsets.assign(maxDepth + 2, 0);
+        for (auto node : m_dirtyNodes)
+        {
+            if (m_alive[node]) ++m_depthOffsets[m_depths[node] + 1];
+        }
+        std::partial_sum(m_depthOffsets.begin(), m_depthOffsets.end(), m_depthOffsets.begin());
+
+        m_sortedNodes.resize(m_depthOffsets.back());
+        for (auto node : m_dirtyNodes)
+        {
+            if (m_alive[node]) m_sortedNodes[m_depthOffsets[m_depths[node]]++] = node;
+
+            m_dirty[node] = false;
+        }
+        m_dirtyNodes.clear();
+
+        computeWorldMatrices();
+
+        return m_sortedNodes.size();
+    }
+
+    bool TransformSystem::isDirty(Handle node) const
+    {
+        return isValid(node) && m_dirty[node];
+    }
+
+    const TransformSystem::Float4x4& TransformSystem::worldMatrix(Handle node) const
+    {
+        return m_worldMatrices.at(node);
+    }
+
+    void TransformSystem::markDirty(Handle node)
+    {
+        if (m_dirty[node]) return;
+
+        m_stack.clear();
+        m_stack.push_back(node);
+
+        while (!m_stack.empty())
+        {
+            auto curr = m_stack.back();
+            m_stack.pop_back();
+
+            // The descendants of a dirty node are all dirty already.
+            if (m_dirty[curr]) continue;
+
+            m_dirty[curr] = true;
+            m_dirtyNodes.push_back(curr);
+
+            for (auto child = m_firstChildren[curr]; child != g_invalidHandle; child = m_nextSiblings[child])
+            {
+                m_stack.push_back(child);
+            }
+        }
+    }
+
+    void TransformSystem::attach(Handle node, Handle parent)
+    {
+        m_parents[node] = parent;
+
+        m_nextSiblings[node] = m_firstChildren[parent];
+        m_firstChildren[parent] = node;
+    }
+
+    void TransformSystem::detach(Handle node)
+    {
+        auto parent = m_parents[node];
+        if (parent == g_invalidHandle) return;
+
+        auto* link = &m_firstChildren[parent];
+        while (*link != node)
+        {
+            link = &m_nextSiblings[*link];
+        }
+        *link = m_nextSiblings[node];
+
+        m_parents[node] = m_nextSiblings[node] = g_invalidHandle;
+    }
+
+    void TransformSystem::updateDepths(Handle node)
+    {
+        m_stack.clear();
+        m_stack.push_back(node);
+
+        while (!m_stack.empty())
+        {
+            auto curr = m_stack.back();
+            m_stack.pop_back();
+
+            auto parent = m_parents[curr];
+            m_depths[curr] = parent != g_invalidHandle ? m_depths[parent] + 1 : 0;
+
+            for (auto child = m_firstChildren[curr]; child != g_invalidHandle; child = m_nextSiblings[child])
+            {
+                m_stack.push_back(child);
+            }
+        }
+    }
+
+    void TransformSystem::computeLocalMatrix(Handle node, Float4x4& local) const
+    {
+        auto qx = m_rotationX[node], qy = m_rotationY[node];
+        auto qz = m_rotationZ[node], qw = m_rotationW[node];
+
+        auto xx = qx * qx, yy = qy * qy, zz = qz * qz;
+        auto xy = qx * qy, xz = qx * qz, yz = qy * qz;
+        auto xw = qx * qw, yw = qy * qw, zw = qz * qw;
+
+        auto sx = m_scalingX[node], sy = m_scalingY[node], sz = m_scalingZ[node];
+
+        auto& m = local.m;
+
+        m[0][0] = (1.0f - 2.0f * (yy + zz)) * sx;
+        m[0][1] = (2.0f * (xy + zw)) * sx;
+        m[0][2] = (2.0f * (xz - yw)) * sx;
+        m[0][3] = 0.0f;
+
+        m[1][0] = (2.0f * (xy - zw)) * sy;
+        m[1][1] = (1.0f - 2.0f * (xx + zz)) * sy;
+        m[1][2] = (2.0f * (yz + xw)) * sy;
+        m[1][3] = 0.0f;
+
+        m[2][0] = (2.0f * (xz + yw)) * sz;
+        m[2][1] = (2.0f * (yz - xw)) * sz;
+        m[2][2] = (1.0f - 2.0f * (xx + yy)) * sz;
+        m[2][3] = 0.0f;
+
+        m[3][0] = m_positionX[node];
+        m[3][1] = m_positionY[node];
+        m[3][2] = m_positionZ[node];
+        m[3][3] = 1.0f;
+    }
+
+#if _D14_TRANSFORM_SYSTEM_SSE2
+    void TransformSystem::computeLocalMatrices(const Handle* nodes, Float4x4* locals) const
+    {
+        // Each lane holds one of the 4 nodes, and the results are transposed
+        // into the rows of their matrices.
+        auto gather = [&](const std::vector<float>& v)
+        {
+            return _mm_setr_ps(v[nodes[0]], v[nodes[1]], v[nodes[2]], v[nodes[3]]);
+        };
+        auto qx = gather(m_rotationX), qy = gather(m_rotationY);
+        auto qz = gather(m_rotationZ), qw = gather(m_rotationW);
+
+        auto one = _mm_set1_ps(1.0f), two = _mm_set1_ps(2.0f), zero = _mm_setzero_ps();
+
+        auto xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+        auto xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+        auto xw = _mm_mul_ps(qx, qw), yw = _mm_mul_ps(qy, qw), zw = _mm_mul_ps(qz, qw);
+
+        auto sx = gather(m_scalingX), sy = gather(m_scalingY), sz = gather(m_scalingZ);
+
+        __m128 rows[4][4] =
+        {
+            {
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, zw)), sx),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, yw)), sx),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, zw)), sy),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, xw)), sy),
+                zero
+            },
+            {
+                _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, yw)), sz),
+                _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, xw)), sz),
+                _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                zero
+            },
+            {
+                gather(m_positionX), gather(m_positionY), gather(m_positionZ), one
+            }
+        };
+        for (int r = 0; r < 4; ++r)
+        {
+            auto& row = rows[r];
+            _MM_TRANSPOSE4_PS(row[0], row[1], row[2], row[3]);
+
+            for (int k = 0; k < 4; ++k)
+            {
+                _mm_store_ps(locals[k].m[r], row[k]);
+            }
+        }
+    }
+#endif
+
+    void TransformSystem::computeWorldMatrix(Handle node, const Float4x4& local)
+    {
+        auto parent = m_parents[node];
+        auto& world = m_worldMatrices[node];
+
+        if (parent == g_invalidHandle)
+        {
+            world = local;
+            return;
+        }
+        // world = local * parent, and the parent's is up to date as it is
+        // either clean or computed before (at a smaller depth).
+        auto& p = m_worldMatrices[parent].m;
+#if _D14_TRANSFORM_SYSTEM_SSE2
+        auto p0 = _mm_load_ps(p[0]), p1 = _mm_load_ps(p[1]);
+        auto p2 = _mm_load_ps(p[2]), p3 = _mm_load_ps(p[3]);
+
+        for (int r = 0; r < 4; ++r)
+        {
+            auto& l = local.m[r];
+            _mm_store_ps(world.m[r], _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(l[0]), p0), _mm_mul_ps(_mm_set1_ps(l[1]), p1)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(l[2]), p2), _mm_mul_ps(_mm_set1_ps(l[3]), p3))));
+        }
+#else
+        for (int r = 0; r < 4; ++r)
+        {
+            auto& l = local.m[r];
+            for (int c = 0; c < 4; ++c)
+            {
+                world.m[r][c] = (l[0] * p[0][c] + l[1] * p[1][c]) + (l[2] * p[2][c] + l[3] * p[3][c]);
+            }
+        }
+#endif
+    }
+
+    void TransformSystem::computeWorldMatrices()
+    {
+        // The parent of a node may be in the same batch, but it is always
+        // before the node in the sorted order.
+        size_t i = 0;
+#if _D14_TRANSFORM_SYSTEM_SSE2
+        Float4x4 locals[4] = {};
+        for (; i + 4 <= m_sortedNodes.size(); i += 4)
+        {
+            computeLocalMatrices(&m_sortedNodes[i], locals);
+
+            for (size_t k = 0; k < 4; ++k)
+            {
+                computeWorldMatrix(m_sortedNodes[i + k], locals[k]);
+            }
+        }
+#endif
+        for (; i < m_sortedNodes.size(); ++i)
+        {
+            Float4x4 local = {};
+            computeLocalMatrix(m_sortedNodes[i], local);
+            computeWorldMatrix(m_sortedNodes[i], local);
+        }
+    }
+}
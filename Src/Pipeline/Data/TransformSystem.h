@@ -0,0 +1,135 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::pipeline
+{
+    // Keeps the transforms of many nodes (e.g. sprites and meshes) in the
+    // structure of arrays, with each node optionally attached to a parent.
+    //
+    // Changing a node marks it and its descendants dirty, and update()
+    // recomputes only the dirty world matrices: the local matrices in the
+    // batches of 4 nodes (with SSE2), then the world ones from the parents
+    // down to the children (with the matrix rows in SSE2).
+    //
+    // The matrices are the same as Transformation::updateWorldMatrix gives
+    // (scaling, then rotation, then translation) in the row vector convention
+    // of DirectXMath, so each one can be loaded by XMLoadFloat4x4 directly.
+
+    struct TransformSystem
+    {
+        using Handle = uint32_t;
+
+        constexpr static Handle g_invalidHandle = UINT32_MAX;
+
+        struct Vector3
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f;
+        };
+        struct Quaternion
+        {
+            float x = 0.0f, y = 0.0f, z = 0.0f, w = 1.0f;
+
+            // Matches XMQuaternionRotationRollPitchYaw, i.e. rotates around z
+            // (roll), then x (pitch), then y (yaw) in radians.
+            static Quaternion fromRollPitchYaw(float pitch, float yaw, float roll);
+        };
+        struct alignas(16) Float4x4
+        {
+            float m[4][4] =
+            {
+                { 1.0f, 0.0f, 0.0f, 0.0f },
+                { 0.0f, 1.0f, 0.0f, 0.0f },
+                { 0.0f, 0.0f, 1.0f, 0.0f },
+                { 0.0f, 0.0f, 0.0f, 1.0f }
+            };
+        };
+
+        //------------------------------------------------------------------
+        // Hierarchy
+        //------------------------------------------------------------------
+
+        // The new node has the identity transform.
+        Handle create(Handle parent = g_invalidHandle);
+
+        // The children of the node are attached to its parent (with their
+        // local transforms unchanged), and the handle may be reused later.
+        void destroy(Handle node);
+
+        bool isValid(Handle node) const;
+
+        size_t size() const;
+
+        // Returns false if the parent is the node itself or its descendant.
+        bool setParent(Handle node, Handle parent);
+
+        Handle parent(Handle node) const;
+
+        //------------------------------------------------------------------
+        // Local Transform
+        //------------------------------------------------------------------
+
+        void setPosition(Handle node, const Vector3& value);
+        void setRotation(Handle node, const Quaternion& value);
+        void setScaling(Handle node, const Vector3& value);
+
+        Vector3 position(Handle node) const;
+        Quaternion rotation(Handle node) const;
+        Vector3 scaling(Handle node) const;
+
+        //------------------------------------------------------------------
+        // World Matrix
+        //------------------------------------------------------------------
+
+        // Returns the count of the recomputed world matrices.
+        size_t update();
+
+        bool isDirty(Handle node) const;
+
+        // Up to date after update(), including the parent's transform.
+        const Float4x4& worldMatrix(Handle node) const;
+
+    protected:
+        // Local Transform
+        std::vector<float> m_positionX = {}, m_positionY = {}, m_positionZ = {};
+        std::vector<float> m_rotationX = {}, m_rotationY = {}, m_rotationZ = {}, m_rotationW = {};
+        std::vector<float> m_scalingX = {}, m_scalingY = {}, m_scalingZ = {};
+
+        // Hierarchy (the children of each node are in a linked list)
+        std::vector<Handle> m_parents = {}, m_firstChildren = {}, m_nextSiblings = {};
+        std::vector<uint32_t> m_depths = {};
+
+        std::vector<uint8_t> m_alive = {};
+        std::vector<Handle> m_freeHandles = {};
+
+        // World Matrix
+        std::vector<Float4x4> m_worldMatrices = {};
+
+        // Every descendant of a dirty node is dirty as well, so the list
+        // holds each dirty node once (in no particular order).
+        std::vector<uint8_t> m_dirty = {};
+        std::vector<Handle> m_dirtyNodes = {};
+
+        // Reused by markDirty/updateDepths and update().
+        std::vector<Handle> m_stack = {};
+
+        std::vector<Handle> m_sortedNodes = {};
+        std::vector<size_t> m_depthOffsets = {};
+
+        void markDirty(Handle node);
+
+        void attach(Handle node, Handle parent);
+        void detach(Handle node);
+
+        void updateDepths(Handle node);
+
+        void computeLocalMatrix(Handle node, Float4x4& local) const;
+
+        // Computes the local matrices of 4 nodes at once (with SSE2).
+        void computeLocalMatrices(const Handle* nodes, Float4x4* locals) const;
+
+        void computeWorldMatrix(Handle node, const Float4x4& local);
+
+        void computeWorldMatrices();
+    };
+}
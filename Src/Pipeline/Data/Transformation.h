@@ -6,6 +6,8 @@
 
 namespace d14engine::pipeline
 {
+    // Composes the world matrix of a standalone object, and TransformSystem
+    // updates the ones of many objects (with the parents) in batches.
     struct Transformation
     {
         XMFLOAT3 position = { 0.0f, 0.0f, 0.0f };
@@ -47,6 +47,50 @@ namespace d14engine::renderer
         updateProjMatrix();
     }
 
+    void Camera::cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results)
+    {
+        results.assign(objects.size(), 1);
+
+        m_cullingSpheres.clear();
+        m_cullingBoxes.clear();
+        m_sphereIndices.clear();
+        m_boxIndices.clear();
+
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            auto bounds = objects[i]->d3d12ObjectBounds();
+            if (bounds.has_value())
+            {
+                if (std::holds_alternative<cull_utils::Sphere>(bounds.value()))
+                {
+                    m_cullingSpheres.push_back(std::get<cull_utils::Sphere>(bounds.value()));
+                    m_sphereIndices.push_back(i);
+                }
+                else // cull_utils::AABB
+                {
+                    m_cullingBoxes.push_back(std::get<cull_utils::AABB>(bounds.value()));
+                    m_boxIndices.push_back(i);
+                }
+            }
+        }
+        auto frustum = this->frustum();
+
+        m_batchResults.resize(m_cullingSpheres.size());
+        cull_utils::cull(frustum, m_cullingSpheres, m_batchResults.data());
+
+        for (size_t i = 0; i < m_sphereIndices.size(); ++i)
+        {
+            results[m_sphereIndices[i]] = m_batchResults[i];
+        }
+        m_batchResults.resize(m_cullingBoxes.size());
+        cull_utils::cull(frustum, m_cullingBoxes, m_batchResults.data());
+
+        for (size_t i = 0; i < m_boxIndices.size(); ++i)
+        {
+            results[m_boxIndices[i]] = m_batchResults[i];
+        }
+    }
+
     void Camera::onRendererUpdateObjectHelper(Renderer* rndr)
     {
         if (dirtyFrameCount > 0)
@@ -96,6 +140,14 @@ namespace d14engine::renderer
         XMStoreFloat4x4(&m_data.projMatrix, XMMatrixPerspectiveFovLH(fovAngleY, getAspectRatio(), nearZ, farZ));
     }
 
+    cull_utils::Frustum Camera::frustum() const
+    {
+        XMFLOAT4X4 viewProj = {};
+        XMStoreFloat4x4(&viewProj, XMMatrixMultiply(viewMatrix(), projMatrix()));
+
+        return cull_utils::Frustum::fromMatrix(viewProj.m);
+    }
+
     const Camera::BufferArray& Camera::buffers() const
     {
         return m_buffers;
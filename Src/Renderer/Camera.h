@@ -2,6 +2,7 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/CullUtils/Frustum.h"
 #include "Common/MathUtils/3D.h"
 
 #include "Renderer/FrameData/FrameResource.h"
@@ -38,6 +39,8 @@ namespace d14engine::renderer
 
         void onViewResize(UINT width, UINT height) override;
 
+        void cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results) override;
+
         ////////////////
         // DrawObject //
         ////////////////
@@ -98,8 +101,28 @@ namespace d14engine::renderer
         XMMATRIX XM_CALLCONV viewMatrix() const;
         XMMATRIX XM_CALLCONV projMatrix() const;
 
-        void updateViewMatrix();
-        void updateProjMatrix();
+        // Overridden by the cameras of the other projections or controls,
+        // e.g. pipeline::Camera2D (orthographic) and pipeline::Camera3D.
+        virtual void updateViewMatrix();
+        virtual void updateProjMatrix();
+
+        //--------------------------------------------
+        // Frustum Culling
+        //--------------------------------------------
+
+    public:
+        // Extracted from the current view/proj matrices.
+        cull_utils::Frustum frustum() const;
+
+    protected:
+        // The bounds are gathered in the structure of arrays for the
+        // batched tests, and these are reused in each frame.
+        cull_utils::SphereArray m_cullingSpheres = {};
+        cull_utils::AABBArray m_cullingBoxes = {};
+
+        std::vector<size_t> m_sphereIndices = {}, m_boxIndices = {};
+
+        std::vector<uint8_t> m_batchResults = {};
 
         //--------------------------------------------
         // GPU/Shader Resources
@@ -0,0 +1,756 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/D2D1Recorder.h"
+
+#include "Common/DirectXError.h"
+
+namespace d14engine::renderer
+{
+    namespace
+    {
+        DisplayList::Point toPoint(const D2D1_POINT_2F& point)
+        {
+            return { point.x, point.y };
+        }
+
+        DisplayList::Rect toRect(const D2D1_RECT_F& rect)
+        {
+            return { rect.left, rect.top, rect.right, rect.bottom };
+        }
+
+        DisplayList::Color toColor(const D2D1_COLOR_F& color)
+        {
+            return { color.r, color.g, color.b, color.a };
+        }
+
+        DisplayList::Matrix toMatrix(const D2D1_MATRIX_3X2_F& matrix)
+        {
+            return { matrix._11, matrix._12, matrix._21, matrix._22, matrix._31, matrix._32 };
+        }
+
+        D2D1_POINT_2F fromPoint(const DisplayList::Point& point)
+        {
+            return { point.x, point.y };
+        }
+
+        D2D1_RECT_F fromRect(const DisplayList::Rect& rect)
+        {
+            return { rect.left, rect.top, rect.right, rect.bottom };
+        }
+
+        D2D1_COLOR_F fromColor(const DisplayList::Color& color)
+        {
+            return { color.r, color.g, color.b, color.a };
+        }
+
+        D2D1_MATRIX_3X2_F fromMatrix(const DisplayList::Matrix& matrix)
+        {
+            return { matrix.m11, matrix.m12, matrix.m21, matrix.m22, matrix.dx, matrix.dy };
+        }
+
+        D2D1_ROUNDED_RECT toRoundedRect(const DisplayList::Rect& rect, float radiusX, float radiusY)
+        {
+            return { fromRect(rect), radiusX, radiusY };
+        }
+
+        // The color of the solid brush is recorded by value, while the other
+        // brushes are recorded by reference (see D2D1Recorder::batching).
+        bool isSolidColor(ID2D1Brush* brush)
+        {
+            ComPtr<ID2D1SolidColorBrush> solidBrush = {};
+            return brush != nullptr && SUCCEEDED(brush->QueryInterface(IID_PPV_ARGS(&solidBrush)));
+        }
+    }
+
+    D2D1Recorder::D2D1Recorder(ID2D1DeviceContext* context)
+        :
+        m_context(context)
+    {
+        m_replayer = std::make_unique<D2D1Replayer>(context, m_batched);
+    }
+
+    D2D1Recorder::~D2D1Recorder() = default;
+
+    ID2D1DeviceContext* D2D1Recorder::context() const
+    {
+        return m_context.Get();
+    }
+
+    bool D2D1Recorder::isCapturing() const
+    {
+        return m_capture != nullptr;
+    }
+
+    void D2D1Recorder::beginCapture(ShrdPtrRefer<DisplayList> list, ID2D1Image* frameTarget)
+    {
+        m_capture = list;
+        m_capture->clear();
+
+        m_frameTarget = frameTarget;
+
+        // Records the current state so that the list can be replayed alone.
+        m_context->GetTarget(&m_recordedTarget);
+
+        D2D1_MATRIX_3X2_F transform = {};
+        m_context->GetTransform(&transform);
+
+        m_capture->record(DisplayList::SetTarget
+        {
+            .target = m_recordedTarget.Get() == m_frameTarget.Get() ?
+                DisplayList::g_nullResource :
+                resourceOf(m_recordedTarget.Get(), DisplayList::ResourceType::Target)
+        });
+        m_capture->record(DisplayList::SetTransform{ .transform = toMatrix(transform) });
+    }
+
+    SharedPtr<DisplayList> D2D1Recorder::endCapture()
+    {
+        m_recordedTarget.Reset();
+        m_frameTarget.Reset();
+
+        return std::move(m_capture);
+    }
+
+    bool D2D1Recorder::isDeferring() const
+    {
+        return batching && m_drawDepth > 0 && !m_capture;
+    }
+
+    DisplayList& D2D1Recorder::recording()
+    {
+        return m_capture ? *m_capture : m_deferred;
+    }
+
+    void D2D1Recorder::recordTransform()
+    {
+        m_deferred.record(DisplayList::SetTransform{ .transform = toMatrix(m_transform) });
+    }
+
+    void D2D1Recorder::BeginDraw()
+    {
+        m_context->BeginDraw();
+
+        if (m_drawDepth++ == 0) m_context->GetTransform(&m_transform);
+    }
+
+    HRESULT D2D1Recorder::EndDraw()
+    {
+        flush();
+
+        if (m_drawDepth > 0) --m_drawDepth;
+
+        return m_context->EndDraw();
+    }
+
+    void D2D1Recorder::flush()
+    {
+        if (m_deferred.empty()) return;
+
+        m_batched = batcher.run(m_deferred);
+        m_batched.replay(*m_replayer);
+
+        // Releases the resources kept alive by the lists.
+        m_deferred.clear();
+        m_batched.clear();
+    }
+
+    void D2D1Recorder::syncTarget()
+    {
+        ComPtr<ID2D1Image> target = {};
+        m_context->GetTarget(&target);
+
+        if (target.Get() != m_recordedTarget.Get())
+        {
+            m_recordedTarget = target;
+
+            m_capture->record(DisplayList::SetTarget
+            {
+                .target = target.Get() == m_frameTarget.Get() ?
+                    DisplayList::g_nullResource :
+                    resourceOf(target.Get(), DisplayList::ResourceType::Target)
+            });
+        }
+    }
+
+    DisplayList::ResourceID D2D1Recorder::resourceOf(IUnknown* object, DisplayList::ResourceType type)
+    {
+        if (object == nullptr) return DisplayList::g_nullResource;
+
+        auto& list = recording();
+
+        if (auto id = list.findResource(object); id.has_value())
+        {
+            return id.value();
+        }
+        DisplayList::Resource resource = { .type = type };
+
+        switch (type)
+        {
+        case DisplayList::ResourceType::Bitmap:
+        case DisplayList::ResourceType::Target:
+        {
+            ComPtr<ID2D1Bitmap> bitmap = {};
+            if (SUCCEEDED(object->QueryInterface(IID_PPV_ARGS(&bitmap))))
+            {
+                auto size = bitmap->GetSize();
+                resource.bounds = { 0.0f, 0.0f, size.width, size.height };
+            }
+            break;
+        }
+        case DisplayList::ResourceType::TextLayout:
+        {
+            auto layout = (IDWriteTextLayout*)object;
+            resource.bounds = { 0.0f, 0.0f, layout->GetMaxWidth(), layout->GetMaxHeight() };
+
+            // The glyphs may extend beyond the layout box (e.g. the italic
+            // and the unwrapped ones), which the overhangs cover.
+            DWRITE_OVERHANG_METRICS overhangs = {};
+            if (SUCCEEDED(layout->GetOverhangMetrics(&overhangs)))
+            {
+                resource.bounds.left = std::min(resource.bounds.left, -overhangs.left);
+                resource.bounds.top = std::min(resource.bounds.top, -overhangs.top);
+                resource.bounds.right = std::max(resource.bounds.right, resource.bounds.right + overhangs.right);
+                resource.bounds.bottom = std::max(resource.bounds.bottom, resource.bounds.bottom + overhangs.bottom);
+            }
+
+            // The font is only saved with the captures (not for batching).
+            if (!m_capture) break;
+
+            // The overloads of IDWriteTextLayout take the text positions.
+            auto format = static_cast<IDWriteTextFormat*>(layout);
+            resource.fontSize = format->GetFontSize();
+
+            resource.name.resize(format->GetFontFamilyNameLength() + 1);
+            if (SUCCEEDED(format->GetFontFamilyName(resource.name.data(), (UINT32)resource.name.size())))
+            {
+                resource.name.pop_back();
+            }
+            else resource.name.clear();
+            break;
+        }
+        case DisplayList::ResourceType::Geometry:
+        {
+            D2D1_RECT_F bounds = {};
+            if (SUCCEEDED(((ID2D1Geometry*)object)->GetBounds(nullptr, &bounds)))
+            {
+                resource.bounds = toRect(bounds);
+            }
+            break;
+        }
+        default: break;
+        }
+        // Keeps the object alive until the list is released.
+        object->AddRef();
+        resource.object = SharedPtr<void>(object, [](void* ptr) { ((IUnknown*)ptr)->Release(); });
+
+        return list.addResource(object, std::move(resource));
+    }
+
+    DisplayList::Brush D2D1Recorder::brushOf(ID2D1Brush* brush)
+    {
+        DisplayList::Brush result = {};
+        if (brush == nullptr) return result;
+
+        result.opacity = brush->GetOpacity();
+
+        ComPtr<ID2D1SolidColorBrush> solidBrush = {};
+        if (SUCCEEDED(brush->QueryInterface(IID_PPV_ARGS(&solidBrush))))
+        {
+            result.color = toColor(solidBrush->GetColor());
+        }
+        else result.resource = resourceOf(brush, DisplayList::ResourceType::Brush);
+
+        return result;
+    }
+
+    void D2D1Recorder::SetTarget(ID2D1Image* image)
+    {
+        flush();
+
+        m_context->SetTarget(image);
+
+        if (m_capture && image != m_recordedTarget.Get())
+        {
+            m_recordedTarget = image;
+
+            m_capture->record(DisplayList::SetTarget
+            {
+                .target = image == m_frameTarget.Get() ?
+                    DisplayList::g_nullResource :
+                    resourceOf(image, DisplayList::ResourceType::Target)
+            });
+        }
+    }
+
+    void D2D1Recorder::SetTransform(const D2D1_MATRIX_3X2_F& transform)
+    {
+        m_transform = transform;
+
+        issue([&] { m_context->SetTransform(transform); }, [&]
+        {
+            return DisplayList::SetTransform{ .transform = toMatrix(transform) };
+        });
+    }
+
+    void D2D1Recorder::GetTransform(D2D1_MATRIX_3X2_F* transform) const
+    {
+        if (isDeferring())
+        {
+            *transform = m_transform;
+        }
+        else m_context->GetTransform(transform);
+    }
+
+    void D2D1Recorder::Clear(const D2D1_COLOR_F& color)
+    {
+        issue([&] { m_context->Clear(color); }, [&]
+        {
+            return DisplayList::Clear{ .color = toColor(color) };
+        });
+    }
+
+    void D2D1Recorder::PushAxisAlignedClip(const D2D1_RECT_F& clipRect, D2D1_ANTIALIAS_MODE antialiasMode)
+    {
+        issue([&] { m_context->PushAxisAlignedClip(clipRect, antialiasMode); }, [&]
+        {
+            return DisplayList::PushClip{ .rect = toRect(clipRect), .antialiasMode = (uint32_t)antialiasMode };
+        });
+    }
+
+    void D2D1Recorder::PopAxisAlignedClip()
+    {
+        issue([&] { m_context->PopAxisAlignedClip(); }, [&]
+        {
+            return DisplayList::PopClip{};
+        });
+    }
+
+    void D2D1Recorder::PushLayer(const D2D1_LAYER_PARAMETERS1& layerParameters, ID2D1Layer* layer)
+    {
+        issue([&] { m_context->PushLayer(layerParameters, layer); }, [&]
+        {
+            return DisplayList::PushLayer
+            {
+                .bounds = toRect(layerParameters.contentBounds),
+                .mask = resourceOf(layerParameters.geometricMask, DisplayList::ResourceType::Geometry),
+                .maskTransform = toMatrix(layerParameters.maskTransform),
+                .opacity = layerParameters.opacity,
+                .opacityBrush = resourceOf(layerParameters.opacityBrush, DisplayList::ResourceType::Brush)
+            };
+        },
+        layerParameters.opacityBrush == nullptr);
+    }
+
+    void D2D1Recorder::PopLayer()
+    {
+        issue([&] { m_context->PopLayer(); }, [&]
+        {
+            return DisplayList::PopLayer{};
+        });
+    }
+
+    void D2D1Recorder::FillRectangle(const D2D1_RECT_F& rect, ID2D1Brush* brush)
+    {
+        issue([&] { m_context->FillRectangle(rect, brush); }, [&]
+        {
+            return DisplayList::FillRect{ .rect = toRect(rect), .brush = brushOf(brush) };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawRectangle(
+        const D2D1_RECT_F& rect,
+        ID2D1Brush* brush,
+        FLOAT strokeWidth,
+        ID2D1StrokeStyle* strokeStyle)
+    {
+        issue([&] { m_context->DrawRectangle(rect, brush, strokeWidth, strokeStyle); }, [&]
+        {
+            return DisplayList::DrawRect
+            {
+                .rect = toRect(rect),
+                .brush = brushOf(brush),
+                .strokeWidth = strokeWidth,
+                .strokeStyle = resourceOf(strokeStyle, DisplayList::ResourceType::StrokeStyle)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::FillRoundedRectangle(const D2D1_ROUNDED_RECT& roundedRect, ID2D1Brush* brush)
+    {
+        issue([&] { m_context->FillRoundedRectangle(roundedRect, brush); }, [&]
+        {
+            return DisplayList::FillRoundedRect
+            {
+                .rect = toRect(roundedRect.rect),
+                .radiusX = roundedRect.radiusX,
+                .radiusY = roundedRect.radiusY,
+                .brush = brushOf(brush)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawRoundedRectangle(
+        const D2D1_ROUNDED_RECT& roundedRect,
+        ID2D1Brush* brush,
+        FLOAT strokeWidth,
+        ID2D1StrokeStyle* strokeStyle)
+    {
+        issue([&] { m_context->DrawRoundedRectangle(roundedRect, brush, strokeWidth, strokeStyle); }, [&]
+        {
+            return DisplayList::DrawRoundedRect
+            {
+                .rect = toRect(roundedRect.rect),
+                .radiusX = roundedRect.radiusX,
+                .radiusY = roundedRect.radiusY,
+                .brush = brushOf(brush),
+                .strokeWidth = strokeWidth,
+                .strokeStyle = resourceOf(strokeStyle, DisplayList::ResourceType::StrokeStyle)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawLine(
+        D2D1_POINT_2F point0,
+        D2D1_POINT_2F point1,
+        ID2D1Brush* brush,
+        FLOAT strokeWidth,
+        ID2D1StrokeStyle* strokeStyle)
+    {
+        issue([&] { m_context->DrawLine(point0, point1, brush, strokeWidth, strokeStyle); }, [&]
+        {
+            return DisplayList::DrawLine
+            {
+                .point0 = toPoint(point0),
+                .point1 = toPoint(point1),
+                .brush = brushOf(brush),
+                .strokeWidth = strokeWidth,
+                .strokeStyle = resourceOf(strokeStyle, DisplayList::ResourceType::StrokeStyle)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawBitmap(
+        ID2D1Bitmap* bitmap,
+        const D2D1_RECT_F& destinationRectangle,
+        FLOAT opacity,
+        D2D1_INTERPOLATION_MODE interpolationMode,
+        const D2D1_RECT_F* sourceRectangle)
+    {
+        issue([&]
+        {
+            m_context->DrawBitmap
+            (
+            /* bitmap               */ bitmap,
+            /* destinationRectangle */ destinationRectangle,
+            /* opacity              */ opacity,
+            /* interpolationMode    */ interpolationMode,
+            /* sourceRectangle      */ sourceRectangle
+            );
+        },
+        [&]
+        {
+            return DisplayList::DrawBitmap
+            {
+                .bitmap = resourceOf(bitmap, DisplayList::ResourceType::Bitmap),
+                .destination = toRect(destinationRectangle),
+                .opacity = opacity,
+                .interpolationMode = (uint32_t)interpolationMode,
+                .hasSource = sourceRectangle != nullptr,
+                .source = sourceRectangle != nullptr ? toRect(*sourceRectangle) : DisplayList::Rect{}
+            };
+        });
+    }
+
+    void D2D1Recorder::DrawTextLayout(
+        D2D1_POINT_2F origin,
+        IDWriteTextLayout* textLayout,
+        ID2D1Brush* defaultFillBrush,
+        D2D1_DRAW_TEXT_OPTIONS options)
+    {
+        issue([&] { m_context->DrawTextLayout(origin, textLayout, defaultFillBrush, options); }, [&]
+        {
+            return DisplayList::DrawTextLayout
+            {
+                .layout = resourceOf(textLayout, DisplayList::ResourceType::TextLayout),
+                .origin = toPoint(origin),
+                .brush = brushOf(defaultFillBrush),
+                .options = (uint32_t)options
+            };
+        },
+        isSolidColor(defaultFillBrush));
+    }
+
+    void D2D1Recorder::FillGeometry(ID2D1Geometry* geometry, ID2D1Brush* brush)
+    {
+        issue([&] { m_context->FillGeometry(geometry, brush); }, [&]
+        {
+            return DisplayList::FillGeometry
+            {
+                .geometry = resourceOf(geometry, DisplayList::ResourceType::Geometry),
+                .brush = brushOf(brush)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawGeometry(
+        ID2D1Geometry* geometry,
+        ID2D1Brush* brush,
+        FLOAT strokeWidth,
+        ID2D1StrokeStyle* strokeStyle)
+    {
+        issue([&] { m_context->DrawGeometry(geometry, brush, strokeWidth, strokeStyle); }, [&]
+        {
+            return DisplayList::DrawGeometry
+            {
+                .geometry = resourceOf(geometry, DisplayList::ResourceType::Geometry),
+                .brush = brushOf(brush),
+                .strokeWidth = strokeWidth,
+                .strokeStyle = resourceOf(strokeStyle, DisplayList::ResourceType::StrokeStyle)
+            };
+        },
+        isSolidColor(brush));
+    }
+
+    void D2D1Recorder::DrawImage(ID2D1Effect* effect, D2D1_POINT_2F targetOffset)
+    {
+        issue([&] { m_context->DrawImage(effect, targetOffset); }, [&]
+        {
+            DisplayList::DrawImage command =
+            {
+                .image = resourceOf(effect, DisplayList::ResourceType::Image),
+                .offset = toPoint(targetOffset)
+            };
+            ComPtr<ID2D1Image> output = {};
+            effect->GetOutput(&output);
+
+            D2D1_RECT_F bounds = {};
+            if (SUCCEEDED(m_context->GetImageLocalBounds(output.Get(), &bounds)))
+            {
+                command.hasBounds = true;
+                command.bounds = toRect(bounds);
+
+                command.bounds.left += targetOffset.x;
+                command.bounds.top += targetOffset.y;
+                command.bounds.right += targetOffset.x;
+                command.bounds.bottom += targetOffset.y;
+            }
+            return command;
+        },
+        false);
+    }
+
+    D2D1Replayer::D2D1Replayer(ID2D1DeviceContext* context, const DisplayList& list)
+        :
+        m_context(context),
+        m_list(list)
+    {
+        m_context->GetTarget(&m_frameTarget);
+
+        THROW_IF_FAILED(m_context->CreateSolidColorBrush({}, &m_solidBrush));
+    }
+
+    ID2D1Brush* D2D1Replayer::brushOf(const DisplayList::Brush& brush)
+    {
+        if (brush.resource == DisplayList::g_nullResource)
+        {
+            auto& c = brush.color;
+            if (!m_solidState.has_value() ||
+                std::memcmp(&m_solidState->color, &c, sizeof(c)) != 0 ||
+                m_solidState->opacity != brush.opacity)
+            {
+                m_solidBrush->SetColor(fromColor(c));
+                m_solidBrush->SetOpacity(brush.opacity);
+
+                m_solidState = brush;
+            }
+            return m_solidBrush.Get();
+        }
+        return objectOf<ID2D1Brush>(brush.resource);
+    }
+
+    void D2D1Replayer::setTarget(const DisplayList::SetTarget& command)
+    {
+        if (command.target == DisplayList::g_nullResource)
+        {
+            m_context->SetTarget(m_frameTarget.Get());
+        }
+        else if (auto target = objectOf<ID2D1Image>(command.target))
+        {
+            m_context->SetTarget(target);
+        }
+    }
+
+    void D2D1Replayer::setTransform(const DisplayList::SetTransform& command)
+    {
+        m_context->SetTransform(fromMatrix(command.transform));
+    }
+
+    void D2D1Replayer::clear(const DisplayList::Clear& command)
+    {
+        m_context->Clear(fromColor(command.color));
+    }
+
+    void D2D1Replayer::pushClip(const DisplayList::PushClip& command)
+    {
+        m_context->PushAxisAlignedClip(fromRect(command.rect), (D2D1_ANTIALIAS_MODE)command.antialiasMode);
+    }
+
+    void D2D1Replayer::popClip(const DisplayList::PopClip& command)
+    {
+        m_context->PopAxisAlignedClip();
+    }
+
+    void D2D1Replayer::pushLayer(const DisplayList::PushLayer& command)
+    {
+        m_context->PushLayer(D2D1::LayerParameters1
+        (
+        /* contentBounds     */ fromRect(command.bounds),
+        /* geometricMask     */ objectOf<ID2D1Geometry>(command.mask),
+        /* maskAntialiasMode */ D2D1_ANTIALIAS_MODE_PER_PRIMITIVE,
+        /* maskTransform     */ fromMatrix(command.maskTransform),
+        /* opacity           */ command.opacity,
+        /* opacityBrush      */ objectOf<ID2D1Brush>(command.opacityBrush)
+        ),
+        nullptr);
+    }
+
+    void D2D1Replayer::popLayer(const DisplayList::PopLayer& command)
+    {
+        m_context->PopLayer();
+    }
+
+    void D2D1Replayer::fillRect(const DisplayList::FillRect& command)
+    {
+        if (auto brush = brushOf(command.brush))
+        {
+            m_context->FillRectangle(fromRect(command.rect), brush);
+        }
+    }
+
+    void D2D1Replayer::drawRect(const DisplayList::DrawRect& command)
+    {
+        if (auto brush = brushOf(command.brush))
+        {
+            m_context->DrawRectangle
+            (
+            /* rect        */ fromRect(command.rect),
+            /* brush       */ brush,
+            /* strokeWidth */ command.strokeWidth,
+            /* strokeStyle */ objectOf<ID2D1StrokeStyle>(command.strokeStyle)
+            );
+        }
+    }
+
+    void D2D1Replayer::fillRoundedRect(const DisplayList::FillRoundedRect& command)
+    {
+        if (auto brush = brushOf(command.brush))
+        {
+            m_context->FillRoundedRectangle(toRoundedRect(command.rect, command.radiusX, command.radiusY), brush);
+        }
+    }
+
+    void D2D1Replayer::drawRoundedRect(const DisplayList::DrawRoundedRect& command)
+    {
+        if (auto brush = brushOf(command.brush))
+        {
+            m_context->DrawRoundedRectangle
+            (
+            /* roundedRect */ toRoundedRect(command.rect, command.radiusX, command.radiusY),
+            /* brush       */ brush,
+            /* strokeWidth */ command.strokeWidth,
+            /* strokeStyle */ objectOf<ID2D1StrokeStyle>(command.strokeStyle)
+            );
+        }
+    }
+
+    void D2D1Replayer::drawLine(const DisplayList::DrawLine& command)
+    {
+        if (auto brush = brushOf(command.brush))
+        {
+            m_context->DrawLine
+            (
+            /* point0      */ fromPoint(command.point0),
+            /* point1      */ fromPoint(command.point1),
+            /* brush       */ brush,
+            /* strokeWidth */ command.strokeWidth,
+            /* strokeStyle */ objectOf<ID2D1StrokeStyle>(command.strokeStyle)
+            );
+        }
+    }
+
+    void D2D1Replayer::drawBitmap(const DisplayList::DrawBitmap& command)
+    {
+        if (auto bitmap = objectOf<ID2D1Bitmap>(command.bitmap))
+        {
+            auto source = fromRect(command.source);
+
+            m_context->DrawBitmap
+            (
+            /* bitmap               */ bitmap,
+            /* destinationRectangle */ fromRect(command.destination),
+            /* opacity              */ command.opacity,
+            /* interpolationMode    */ (D2D1_INTERPOLATION_MODE)command.interpolationMode,
+            /* sourceRectangle      */ command.hasSource ? &source : nullptr
+            );
+        }
+    }
+
+    void D2D1Replayer::drawTextLayout(const DisplayList::DrawTextLayout& command)
+    {
+        auto layout = objectOf<IDWriteTextLayout>(command.layout);
+        auto brush = brushOf(command.brush);
+
+        if (layout != nullptr && brush != nullptr)
+        {
+            m_context->DrawTextLayout
+            (
+            /* origin           */ fromPoint(command.origin),
+            /* textLayout       */ layout,
+            /* defaultFillBrush */ brush,
+            /* options          */ (D2D1_DRAW_TEXT_OPTIONS)command.options
+            );
+        }
+    }
+
+    void D2D1Replayer::fillGeometry(const DisplayList::FillGeometry& command)
+    {
+        auto geometry = objectOf<ID2D1Geometry>(command.geometry);
+        auto brush = brushOf(command.brush);
+
+        if (geometry != nullptr && brush != nullptr)
+        {
+            m_context->FillGeometry(geometry, brush);
+        }
+    }
+
+    void D2D1Replayer::drawGeometry(const DisplayList::DrawGeometry& command)
+    {
+        auto geometry = objectOf<ID2D1Geometry>(command.geometry);
+        auto brush = brushOf(command.brush);
+
+        if (geometry != nullptr && brush != nullptr)
+        {
+            m_context->DrawGeometry
+            (
+            /* geometry    */ geometry,
+            /* brush       */ brush,
+            /* strokeWidth */ command.strokeWidth,
+            /* strokeStyle */ objectOf<ID2D1StrokeStyle>(command.strokeStyle)
+            );
+        }
+    }
+
+    void D2D1Replayer::drawImage(const DisplayList::DrawImage& command)
+    {
+        if (auto effect = objectOf<ID2D1Effect>(command.image))
+        {
+            m_context->DrawImage(effect, fromPoint(command.offset));
+        }
+    }
+}
@@ -0,0 +1,244 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+#include "Renderer/DisplayList.h"
+#include "Renderer/DisplayListBatcher.h"
+
+namespace d14engine::renderer
+{
+    struct D2D1Replayer;
+
+    // Forwards the 2D draw calls of the objects to the device context (the
+    // methods are named after those of ID2D1DeviceContext), and records
+    // them into the display list while a capture is active, each with the
+    // time spent in issuing it.
+    //
+    // Note that D2D1 batches the commands, so the timing only covers the
+    // CPU work of issuing them instead of the GPU work of drawing them.
+    //
+    // Between BeginDraw and EndDraw, the commands are deferred and issued
+    // in the order of DisplayListBatcher when the section ends or the
+    // target changes (see batching).
+    struct D2D1Recorder : cpp_lang_utils::NonCopyable
+    {
+        explicit D2D1Recorder(ID2D1DeviceContext* context);
+
+        virtual ~D2D1Recorder();
+
+        // Call flush before issuing the draw calls to the context directly.
+        ID2D1DeviceContext* context() const;
+
+    protected:
+        ComPtr<ID2D1DeviceContext> m_context = {};
+
+        SharedPtr<DisplayList> m_capture = {};
+
+        // The target of the last recorded command, which is compared with
+        // that of the context to record the changes made outside (e.g. by
+        // MaskObject::beginDraw with the context).
+        ComPtr<ID2D1Image> m_recordedTarget = {};
+
+        // The target that the null resource of SetTarget refers to.
+        ComPtr<ID2D1Image> m_frameTarget = {};
+
+    public:
+        bool isCapturing() const;
+
+        void beginCapture(ShrdPtrRefer<DisplayList> list, ID2D1Image* frameTarget);
+
+        SharedPtr<DisplayList> endCapture();
+
+    public:
+        // Defers the commands whose state is kept by value in the display
+        // list (those with the solid brushes, the bitmaps, the clips...) and
+        // reorders them with batcher.  The others (those with the bitmap or
+        // gradient brushes and the effects, whose state is changed between
+        // the draws) flush the deferred ones and are issued at once.
+        //
+        // The frames being captured are not batched, so the capture keeps
+        // the original order with the time of each call.
+        bool batching = true;
+
+        DisplayListBatcher batcher = {};
+
+    protected:
+        // Count of the nested BeginDraw calls issued through the recorder.
+        UINT m_drawDepth = 0;
+
+        // The transform of the context after the deferred commands.
+        D2D1_MATRIX_3X2_F m_transform = D2D1::Matrix3x2F::Identity();
+
+        DisplayList m_deferred = {}, m_batched = {};
+
+        UniquePtr<D2D1Replayer> m_replayer = {};
+
+        bool isDeferring() const;
+
+        // The list that the commands are recorded into.
+        DisplayList& recording();
+
+        // Starts the deferred commands with the current transform, so that
+        // the batcher knows the bounds of the first draws.
+        void recordTransform();
+
+    public:
+        // Issues the deferred commands.
+        void flush();
+
+    protected:
+        using Clock = std::chrono::steady_clock;
+
+        // Issues the call and records the command built after it (so that
+        // the resources are only looked up when capturing or deferring).
+        template<typename Call_T, typename Build_T>
+        void issue(Call_T&& call, Build_T&& build, bool deferrable = true)
+        {
+            if (!m_capture)
+            {
+                if (deferrable && isDeferring())
+                {
+                    if (m_deferred.empty()) recordTransform();
+
+                    m_deferred.record(build()); return;
+                }
+                flush();
+                call(); return;
+            }
+            syncTarget();
+
+            auto start = Clock::now();
+            call();
+            auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+            m_capture->record(build(), (uint64_t)duration.count());
+        }
+        void syncTarget();
+
+        DisplayList::ResourceID resourceOf(IUnknown* object, DisplayList::ResourceType type);
+
+        DisplayList::Brush brushOf(ID2D1Brush* brush);
+
+    public:
+        void BeginDraw();
+
+        HRESULT EndDraw();
+
+        void SetTarget(ID2D1Image* image);
+
+        void SetTransform(const D2D1_MATRIX_3X2_F& transform);
+
+        void GetTransform(D2D1_MATRIX_3X2_F* transform) const;
+
+        void Clear(const D2D1_COLOR_F& color);
+
+        void PushAxisAlignedClip(const D2D1_RECT_F& clipRect, D2D1_ANTIALIAS_MODE antialiasMode);
+
+        void PopAxisAlignedClip();
+
+        void PushLayer(const D2D1_LAYER_PARAMETERS1& layerParameters, ID2D1Layer* layer = nullptr);
+
+        void PopLayer();
+
+        void FillRectangle(const D2D1_RECT_F& rect, ID2D1Brush* brush);
+
+        void DrawRectangle(
+            const D2D1_RECT_F& rect,
+            ID2D1Brush* brush,
+            FLOAT strokeWidth = 1.0f,
+            ID2D1StrokeStyle* strokeStyle = nullptr);
+
+        void FillRoundedRectangle(const D2D1_ROUNDED_RECT& roundedRect, ID2D1Brush* brush);
+
+        void DrawRoundedRectangle(
+            const D2D1_ROUNDED_RECT& roundedRect,
+            ID2D1Brush* brush,
+            FLOAT strokeWidth = 1.0f,
+            ID2D1StrokeStyle* strokeStyle = nullptr);
+
+        void DrawLine(
+            D2D1_POINT_2F point0,
+            D2D1_POINT_2F point1,
+            ID2D1Brush* brush,
+            FLOAT strokeWidth = 1.0f,
+            ID2D1StrokeStyle* strokeStyle = nullptr);
+
+        void DrawBitmap(
+            ID2D1Bitmap* bitmap,
+            const D2D1_RECT_F& destinationRectangle,
+            FLOAT opacity = 1.0f,
+            D2D1_INTERPOLATION_MODE interpolationMode = D2D1_INTERPOLATION_MODE_LINEAR,
+            const D2D1_RECT_F* sourceRectangle = nullptr);
+
+        void DrawTextLayout(
+            D2D1_POINT_2F origin,
+            IDWriteTextLayout* textLayout,
+            ID2D1Brush* defaultFillBrush,
+            D2D1_DRAW_TEXT_OPTIONS options = D2D1_DRAW_TEXT_OPTIONS_NONE);
+
+        void FillGeometry(ID2D1Geometry* geometry, ID2D1Brush* brush);
+
+        void DrawGeometry(
+            ID2D1Geometry* geometry,
+            ID2D1Brush* brush,
+            FLOAT strokeWidth = 1.0f,
+            ID2D1StrokeStyle* strokeStyle = nullptr);
+
+        void DrawImage(ID2D1Effect* effect, D2D1_POINT_2F targetOffset);
+    };
+
+    // Replays a display list to a device context with the live objects of
+    // the resources, so it only works in the process that recorded it.
+    // The commands whose resources are not alive are skipped.
+    struct D2D1Replayer : DisplayList::IBackend
+    {
+        D2D1Replayer(ID2D1DeviceContext* context, const DisplayList& list);
+
+    protected:
+        ComPtr<ID2D1DeviceContext> m_context = {};
+
+        const DisplayList& m_list;
+
+        // The null resource of SetTarget refers to the current target.
+        ComPtr<ID2D1Image> m_frameTarget = {};
+
+        ComPtr<ID2D1SolidColorBrush> m_solidBrush = {};
+
+        // Skips recoloring the brush for the consecutive draws of the same
+        // color, e.g. those grouped by DisplayListBatcher.
+        Optional<DisplayList::Brush> m_solidState = {};
+
+        template<typename Interface_T>
+        Interface_T* objectOf(DisplayList::ResourceID id) const
+        {
+            auto resource = m_list.resource(id);
+            return resource != nullptr ? (Interface_T*)resource->object.get() : nullptr;
+        }
+        ID2D1Brush* brushOf(const DisplayList::Brush& brush);
+
+    public:
+        // Override DisplayList::IBackend
+        void setTarget(const DisplayList::SetTarget& command) override;
+        void setTransform(const DisplayList::SetTransform& command) override;
+        void clear(const DisplayList::Clear& command) override;
+
+        void pushClip(const DisplayList::PushClip& command) override;
+        void popClip(const DisplayList::PopClip& command) override;
+        void pushLayer(const DisplayList::PushLayer& command) override;
+        void popLayer(const DisplayList::PopLayer& command) override;
+
+        void fillRect(const DisplayList::FillRect& command) override;
+        void drawRect(const DisplayList::DrawRect& command) override;
+        void fillRoundedRect(const DisplayList::FillRoundedRect& command) override;
+        void drawRoundedRect(const DisplayList::DrawRoundedRect& command) override;
+        void drawLine(const DisplayList::DrawLine& command) override;
+
+        void drawBitmap(const DisplayList::DrawBitmap& command) override;
+        void drawTextLayout(const DisplayList::DrawTextLayout& command) override;
+        void fillGeometry(const DisplayList::FillGeometry& command) override;
+        void drawGeometry(const DisplayList::DrawGeometry& command) override;
+        void drawImage(const DisplayList::DrawImage& command) override;
+    };
+}
@@ -0,0 +1,185 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/DescriptorAllocator.h"
+
+namespace d14engine::renderer
+{
+    DescriptorAllocator::DescriptorAllocator(uint32_t capacity, uint32_t ringCapacity)
+        :
+        m_capacity(capacity),
+        m_ringCapacity(std::min(ringCapacity, capacity))
+    {
+        auto persistentCapacity = m_capacity - m_ringCapacity;
+        if (persistentCapacity > 0)
+        {
+            insertFreeRange(0, persistentCapacity);
+        }
+    }
+
+    void DescriptorAllocator::insertFreeRange(uint32_t offset, uint32_t count)
+    {
+        // Merges with the adjacent free ranges on both sides.
+
+        auto next = m_freeRanges.lower_bound(offset);
+        if (next != m_freeRanges.end() && offset + count == next->first)
+        {
+            count += next->second;
+            eraseFreeRange(next);
+        }
+        auto itor = m_freeRanges.lower_bound(offset);
+        if (itor != m_freeRanges.begin())
+        {
+            auto prev = std::prev(itor);
+            if (prev->first + prev->second == offset)
+            {
+                offset = prev->first;
+                count += prev->second;
+                eraseFreeRange(prev);
+            }
+        }
+        m_freeRanges.emplace(offset, count);
+        m_freeSizes.emplace(count, offset);
+    }
+
+    void DescriptorAllocator::eraseFreeRange(std::map<uint32_t, uint32_t>::iterator itor)
+    {
+        m_freeSizes.erase({ itor->second, itor->first });
+        m_freeRanges.erase(itor);
+    }
+
+    Optional<DescriptorAllocator::Range> DescriptorAllocator::allocate(uint32_t count)
+    {
+        if (count == 0) return std::nullopt;
+
+        auto fit = m_freeSizes.lower_bound({ count, 0 });
+        if (fit == m_freeSizes.end()) return std::nullopt;
+
+        auto [freeCount, offset] = *fit;
+        eraseFreeRange(m_freeRanges.find(offset));
+
+        if (freeCount > count)
+        {
+            insertFreeRange(offset + count, freeCount - count);
+        }
+        m_persistentUsed += count;
+
+        return Range{ offset, count };
+    }
+
+    void DescriptorAllocator::free(const Range& range)
+    {
+        if (range.count > 0) m_currFrees.push_back(range);
+    }
+
+    Optional<DescriptorAllocator::Range> DescriptorAllocator::allocateTransient(uint32_t count)
+    {
+        if (count == 0 || count > m_ringCapacity) return std::nullopt;
+
+        if (m_ringUsed == 0)
+        {
+            m_ringHead = m_ringTail = 0;
+        }
+        // The free slots are [head, capacity) + [0, tail) if the head is
+        // not behind the tail, or [head, tail) otherwise.
+
+        uint32_t skipped = 0;
+        if (m_ringUsed == 0 || m_ringHead > m_ringTail)
+        {
+            if (m_ringHead + count > m_ringCapacity)
+            {
+                if (count > m_ringTail) return std::nullopt;
+
+                skipped = m_ringCapacity - m_ringHead;
+                m_ringHead = 0;
+            }
+        }
+        else if (m_ringHead + count > m_ringTail)
+        {
+            return std::nullopt;
+        }
+        auto offset = m_ringHead;
+
+        m_ringHead = (m_ringHead + count) % m_ringCapacity;
+        m_ringUsed += skipped + count;
+        m_currRingUsed += skipped + count;
+
+        return Range{ m_capacity - m_ringCapacity + offset, count };
+    }
+
+    void DescriptorAllocator::endFrame(uint64_t fenceValue)
+    {
+        for (auto& range : m_currFrees)
+        {
+            m_pendingFrees.push_back({ fenceValue, range });
+        }
+        m_currFrees.clear();
+
+        if (m_currRingUsed > 0)
+        {
+            m_ringFrames.push_back({ fenceValue, m_currRingUsed });
+            m_currRingUsed = 0;
+        }
+    }
+
+    void DescriptorAllocator::reclaim(uint64_t completedValue)
+    {
+        while (!m_pendingFrees.empty() && m_pendingFrees.front().fenceValue <= completedValue)
+        {
+            auto& range = m_pendingFrees.front().range;
+
+            insertFreeRange(range.offset, range.count);
+            m_persistentUsed -= range.count;
+
+            m_pendingFrees.pop_front();
+        }
+        while (!m_ringFrames.empty() && m_ringFrames.front().fenceValue <= completedValue)
+        {
+            auto count = m_ringFrames.front().count;
+
+            m_ringTail = (m_ringTail + count) % m_ringCapacity;
+            m_ringUsed -= count;
+
+            m_ringFrames.pop_front();
+        }
+    }
+
+    float DescriptorAllocator::Statistics::fragmentation() const
+    {
+        auto freeCount = persistentCapacity - persistentUsed;
+        if (freeCount == 0) return 0.0f;
+
+        return 1.0f - (float)largestFreeRange / (float)freeCount;
+    }
+
+    DescriptorAllocator::Statistics DescriptorAllocator::statistics() const
+    {
+        Statistics stats =
+        {
+            .persistentCapacity = m_capacity - m_ringCapacity,
+            .persistentUsed = m_persistentUsed,
+            .freeRangeCount = (uint32_t)m_freeRanges.size(),
+            .largestFreeRange = m_freeSizes.empty() ? 0 : m_freeSizes.rbegin()->first,
+            .ringCapacity = m_ringCapacity,
+            .ringUsed = m_ringUsed
+        };
+        for (auto& range : m_currFrees)
+        {
+            stats.pendingFree += range.count;
+        }
+        for (auto& pending : m_pendingFrees)
+        {
+            stats.pendingFree += pending.range.count;
+        }
+        return stats;
+    }
+
+    uint32_t DescriptorAllocator::capacity() const
+    {
+        return m_capacity;
+    }
+
+    uint32_t DescriptorAllocator::ringCapacity() const
+    {
+        return m_ringCapacity;
+    }
+}
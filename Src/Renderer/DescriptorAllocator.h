@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    // Manages the slots of a descriptor heap without touching the heap, so
+    // the policy can be tested with simulated fence values:
+    //
+    // [0, capacity - ringCapacity) is the persistent region for the views
+    // that live across frames (e.g. the textures), which is allocated with
+    // best fit from a free list and coalesced on release.
+    //
+    // [capacity - ringCapacity, capacity) is the ring region for the views
+    // used only in the current frame, which are allocated linearly and all
+    // released together once the frame has been completed.
+    //
+    // A freed persistent range may still be referenced by the commands in
+    // flight, so it is reused only after the frame it was freed in has been
+    // completed as well (i.e. the fence value passed to endFrame).
+    struct DescriptorAllocator
+    {
+        DescriptorAllocator(uint32_t capacity, uint32_t ringCapacity = 0);
+
+        struct Range
+        {
+            uint32_t offset = 0, count = 0;
+        };
+
+    protected:
+        uint32_t m_capacity = 0;
+        uint32_t m_ringCapacity = 0;
+
+        // offset -> count
+        std::map<uint32_t, uint32_t> m_freeRanges = {};
+        // (count, offset) for the best fit
+        std::set<std::pair<uint32_t, uint32_t>> m_freeSizes = {};
+
+        uint32_t m_persistentUsed = 0;
+
+        void insertFreeRange(uint32_t offset, uint32_t count);
+        void eraseFreeRange(std::map<uint32_t, uint32_t>::iterator itor);
+
+        // Freed in the current frame (i.e. not stamped with a fence value).
+        std::vector<Range> m_currFrees = {};
+
+        struct PendingFree
+        {
+            uint64_t fenceValue = 0;
+            Range range = {};
+        };
+        std::deque<PendingFree> m_pendingFrees = {};
+
+        // The offsets here are relative to the start of the ring region.
+        uint32_t m_ringHead = 0, m_ringTail = 0;
+        uint32_t m_ringUsed = 0;
+
+        // Including the skipped slots at the end when wrapping around.
+        uint32_t m_currRingUsed = 0;
+
+        struct RingFrame
+        {
+            uint64_t fenceValue = 0;
+            uint32_t count = 0;
+        };
+        std::deque<RingFrame> m_ringFrames = {};
+
+    public:
+        // Returns std::nullopt if there is no free range large enough.
+        Optional<Range> allocate(uint32_t count);
+
+        void free(const Range& range);
+
+        // The range is valid until the end of the current frame.
+        Optional<Range> allocateTransient(uint32_t count);
+
+        // The fence value should be signaled after the commands of the
+        // current frame, which finishes the transient ranges and the frees.
+        void endFrame(uint64_t fenceValue);
+
+        // Releases everything of the frames up to the completed value.
+        void reclaim(uint64_t completedValue);
+
+    public:
+        struct Statistics
+        {
+            uint32_t persistentCapacity = 0;
+            uint32_t persistentUsed = 0;
+
+            // Freed but still waiting for the fence.
+            uint32_t pendingFree = 0;
+
+            uint32_t freeRangeCount = 0;
+            uint32_t largestFreeRange = 0;
+
+            uint32_t ringCapacity = 0;
+            uint32_t ringUsed = 0;
+
+            // 0 if all the free slots are in one range, and close to 1 if
+            // they are scattered in many small ones.
+            float fragmentation() const;
+        };
+        Statistics statistics() const;
+
+        uint32_t capacity() const;
+        uint32_t ringCapacity() const;
+    };
+}
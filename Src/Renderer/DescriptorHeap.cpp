@@ -0,0 +1,97 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/DescriptorHeap.h"
+
+#include "Common/DirectXError.h"
+
+namespace d14engine::renderer
+{
+    DescriptorHeap::DescriptorHeap(
+        ID3D12Device* device,
+        D3D12_DESCRIPTOR_HEAP_TYPE type,
+        UINT capacity,
+        UINT ringCapacity,
+        bool shaderVisible)
+        :
+        m_allocator(capacity, ringCapacity)
+    {
+        D3D12_DESCRIPTOR_HEAP_DESC desc =
+        {
+            .Type = type,
+            .NumDescriptors = capacity,
+            .Flags = shaderVisible ?
+                D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE :
+                D3D12_DESCRIPTOR_HEAP_FLAG_NONE
+        };
+        THROW_IF_FAILED(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_heap)));
+
+        m_descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+    }
+
+    DescriptorHeap::Descriptor DescriptorHeap::descriptor(const DescriptorAllocator::Range& range) const
+    {
+        Descriptor descriptor = {};
+
+        descriptor.range = range;
+        descriptor.descriptorSize = m_descriptorSize;
+
+        descriptor.cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE
+        (
+            m_heap->GetCPUDescriptorHandleForHeapStart(), (INT)range.offset, m_descriptorSize
+        );
+        if (m_heap->GetDesc().Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+        {
+            descriptor.gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE
+            (
+                m_heap->GetGPUDescriptorHandleForHeapStart(), (INT)range.offset, m_descriptorSize
+            );
+        }
+        return descriptor;
+    }
+
+    ID3D12DescriptorHeap* DescriptorHeap::heap() const
+    {
+        return m_heap.Get();
+    }
+
+    UINT DescriptorHeap::descriptorSize() const
+    {
+        return m_descriptorSize;
+    }
+
+    Optional<DescriptorHeap::Descriptor> DescriptorHeap::allocate(UINT count)
+    {
+        auto range = m_allocator.allocate(count);
+        if (!range.has_value()) return std::nullopt;
+
+        return descriptor(range.value());
+    }
+
+    void DescriptorHeap::free(const Descriptor& descriptor)
+    {
+        m_allocator.free(descriptor.range);
+    }
+
+    Optional<DescriptorHeap::Descriptor> DescriptorHeap::allocateTransient(UINT count)
+    {
+        auto range = m_allocator.allocateTransient(count);
+        if (!range.has_value()) return std::nullopt;
+
+        return descriptor(range.value());
+    }
+
+    void DescriptorHeap::endFrame(UINT64 fenceValue)
+    {
+        m_allocator.endFrame(fenceValue);
+    }
+
+    void DescriptorHeap::reclaim(UINT64 completedValue)
+    {
+        m_allocator.reclaim(completedValue);
+    }
+
+    DescriptorAllocator::Statistics DescriptorHeap::statistics() const
+    {
+        return m_allocator.statistics();
+    }
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+#include "Renderer/DescriptorAllocator.h"
+
+namespace d14engine::renderer
+{
+    // A large descriptor heap shared by many objects instead of creating a
+    // small heap for each of them (see DescriptorAllocator for the policy).
+    // Binding one shader-visible heap for the whole frame also avoids the
+    // costly switches by SetDescriptorHeaps.
+    struct DescriptorHeap : cpp_lang_utils::NonCopyable
+    {
+        DescriptorHeap(
+            ID3D12Device* device,
+            D3D12_DESCRIPTOR_HEAP_TYPE type,
+            UINT capacity,
+            UINT ringCapacity = 0,
+            bool shaderVisible = false);
+
+        struct Descriptor
+        {
+            DescriptorAllocator::Range range = {};
+
+            D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = {};
+
+            // Valid only for a shader-visible heap.
+            D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {};
+
+            UINT descriptorSize = 0;
+
+            CD3DX12_CPU_DESCRIPTOR_HANDLE cpu(UINT index = 0) const
+            {
+                return { cpuHandle, (INT)index, descriptorSize };
+            }
+            CD3DX12_GPU_DESCRIPTOR_HANDLE gpu(UINT index = 0) const
+            {
+                return { gpuHandle, (INT)index, descriptorSize };
+            }
+        };
+
+    protected:
+        ComPtr<ID3D12DescriptorHeap> m_heap = {};
+
+        UINT m_descriptorSize = 0;
+
+        DescriptorAllocator m_allocator;
+
+        Descriptor descriptor(const DescriptorAllocator::Range& range) const;
+
+    public:
+        ID3D12DescriptorHeap* heap() const;
+
+        UINT descriptorSize() const;
+
+        // Returns std::nullopt if the heap is full.
+        Optional<Descriptor> allocate(UINT count = 1);
+
+        // The descriptors can be still used by the commands in flight,
+        // so they are reused after the current frame has been completed.
+        void free(const Descriptor& descriptor);
+
+        // Returns std::nullopt if the ring region is full.
+        Optional<Descriptor> allocateTransient(UINT count = 1);
+
+        // Called by Renderer after signaling the fence of each frame and
+        // after waiting for it respectively.
+        void endFrame(UINT64 fenceValue);
+        void reclaim(UINT64 completedValue);
+
+        DescriptorAllocator::Statistics statistics() const;
+    };
+}
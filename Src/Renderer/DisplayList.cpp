@@ -0,0 +1,367 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/DisplayList.h"
+
+namespace d14engine::renderer
+{
+    namespace
+    {
+        constexpr uint32_t g_magic = 0x4c343144; // "D14L"
+        constexpr uint32_t g_version = 2;
+
+        struct Header
+        {
+            uint32_t magic = g_magic;
+            uint32_t version = g_version;
+
+            uint32_t resourceCount = 0;
+            uint32_t commandCount = 0;
+
+            uint64_t nameSize = 0; // in characters
+            uint64_t payloadSize = 0;
+        };
+        struct ResourceRecord
+        {
+            DisplayList::ResourceType type = DisplayList::ResourceType::Brush;
+
+            DisplayList::Rect bounds = {};
+
+            uint32_t nameLength = 0;
+            float fontSize = 0.0f;
+        };
+        using Clock = std::chrono::steady_clock;
+
+        uint64_t elapsed(Clock::time_point start)
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        }
+    }
+
+    const char* DisplayList::nameOf(CommandType type)
+    {
+        switch (type)
+        {
+        case CommandType::SetTarget: return "SetTarget";
+        case CommandType::SetTransform: return "SetTransform";
+        case CommandType::Clear: return "Clear";
+        case CommandType::PushClip: return "PushClip";
+        case CommandType::PopClip: return "PopClip";
+        case CommandType::PushLayer: return "PushLayer";
+        case CommandType::PopLayer: return "PopLayer";
+        case CommandType::FillRect: return "FillRect";
+        case CommandType::DrawRect: return "DrawRect";
+        case CommandType::FillRoundedRect: return "FillRoundedRect";
+        case CommandType::DrawRoundedRect: return "DrawRoundedRect";
+        case CommandType::DrawLine: return "DrawLine";
+        case CommandType::DrawBitmap: return "DrawBitmap";
+        case CommandType::DrawTextLayout: return "DrawTextLayout";
+        case CommandType::FillGeometry: return "FillGeometry";
+        case CommandType::DrawGeometry: return "DrawGeometry";
+        case CommandType::DrawImage: return "DrawImage";
+        default: return "Unknown";
+        }
+    }
+
+    size_t DisplayList::payloadSizeOf(CommandType type)
+    {
+        switch (type)
+        {
+        case CommandType::SetTarget: return sizeof(SetTarget);
+        case CommandType::SetTransform: return sizeof(SetTransform);
+        case CommandType::Clear: return sizeof(Clear);
+        case CommandType::PushClip: return sizeof(PushClip);
+        case CommandType::PushLayer: return sizeof(PushLayer);
+        case CommandType::FillRect: return sizeof(FillRect);
+        case CommandType::DrawRect: return sizeof(DrawRect);
+        case CommandType::FillRoundedRect: return sizeof(FillRoundedRect);
+        case CommandType::DrawRoundedRect: return sizeof(DrawRoundedRect);
+        case CommandType::DrawLine: return sizeof(DrawLine);
+        case CommandType::DrawBitmap: return sizeof(DrawBitmap);
+        case CommandType::DrawTextLayout: return sizeof(DrawTextLayout);
+        case CommandType::FillGeometry: return sizeof(FillGeometry);
+        case CommandType::DrawGeometry: return sizeof(DrawGeometry);
+        case CommandType::DrawImage: return sizeof(DrawImage);
+        default: return 0; // PopClip, PopLayer
+        }
+    }
+
+    void DisplayList::clear()
+    {
+        m_resources.clear();
+        m_resourceKeys.clear();
+        m_records.clear();
+        m_payloads.clear();
+    }
+
+    bool DisplayList::empty() const
+    {
+        return m_records.empty();
+    }
+
+    size_t DisplayList::commandCount() const
+    {
+        return m_records.size();
+    }
+
+    DisplayList::CommandType DisplayList::typeOf(size_t index) const
+    {
+        return m_records[index].type;
+    }
+
+    uint64_t DisplayList::durationOf(size_t index) const
+    {
+        return m_records[index].duration;
+    }
+
+    const uint8_t* DisplayList::payloadOf(size_t index) const
+    {
+        return m_payloads.data() + m_records[index].offset;
+    }
+
+    void DisplayList::append(const DisplayList& other, size_t index)
+    {
+        auto& record = other.m_records[index];
+        auto size = payloadSizeOf(record.type);
+
+        auto offset = m_payloads.size();
+        m_payloads.insert(m_payloads.end(),
+            other.m_payloads.begin() + record.offset,
+            other.m_payloads.begin() + record.offset + size);
+
+        m_records.push_back({ record.type, 0, (uint32_t)offset, record.duration });
+    }
+
+    const std::vector<DisplayList::Resource>& DisplayList::resources() const
+    {
+        return m_resources;
+    }
+
+    void DisplayList::assignResources(const DisplayList& other)
+    {
+        m_resources = other.m_resources;
+        m_resourceKeys = other.m_resourceKeys;
+    }
+
+    const DisplayList::Resource* DisplayList::resource(ResourceID id) const
+    {
+        return id < m_resources.size() ? &m_resources[id] : nullptr;
+    }
+
+    Optional<DisplayList::ResourceID> DisplayList::findResource(const void* key) const
+    {
+        auto itor = m_resourceKeys.find(key);
+        if (itor != m_resourceKeys.end())
+        {
+            return itor->second;
+        }
+        return std::nullopt;
+    }
+
+    DisplayList::ResourceID DisplayList::addResource(const void* key, Resource resource)
+    {
+        auto id = (ResourceID)m_resources.size();
+        m_resources.push_back(std::move(resource));
+
+        if (key != nullptr)
+        {
+            m_resourceKeys[key] = id;
+        }
+        return id;
+    }
+
+    void DisplayList::replay(IBackend& backend) const
+    {
+        for (size_t i = 0; i < m_records.size(); ++i)
+        {
+            replayCommand(i, backend);
+        }
+    }
+
+    void DisplayList::replay(IBackend& backend, std::vector<uint64_t>& durations) const
+    {
+        durations.resize(m_records.size());
+
+        for (size_t i = 0; i < m_records.size(); ++i)
+        {
+            auto start = Clock::now();
+
+            replayCommand(i, backend);
+
+            durations[i] = elapsed(start);
+        }
+    }
+
+    void DisplayList::replayCommand(size_t index, IBackend& backend) const
+    {
+        auto payload = m_payloads.data() + m_records[index].offset;
+
+#define D14_REPLAY_COMMAND(Type, Method) \
+        case CommandType::Type: backend.Method(*(const Type*)payload); break
+
+        switch (m_records[index].type)
+        {
+        D14_REPLAY_COMMAND(SetTarget, setTarget);
+        D14_REPLAY_COMMAND(SetTransform, setTransform);
+        D14_REPLAY_COMMAND(Clear, clear);
+        D14_REPLAY_COMMAND(PushClip, pushClip);
+        D14_REPLAY_COMMAND(PushLayer, pushLayer);
+        D14_REPLAY_COMMAND(FillRect, fillRect);
+        D14_REPLAY_COMMAND(DrawRect, drawRect);
+        D14_REPLAY_COMMAND(FillRoundedRect, fillRoundedRect);
+        D14_REPLAY_COMMAND(DrawRoundedRect, drawRoundedRect);
+        D14_REPLAY_COMMAND(DrawLine, drawLine);
+        D14_REPLAY_COMMAND(DrawBitmap, drawBitmap);
+        D14_REPLAY_COMMAND(DrawTextLayout, drawTextLayout);
+        D14_REPLAY_COMMAND(FillGeometry, fillGeometry);
+        D14_REPLAY_COMMAND(DrawGeometry, drawGeometry);
+        D14_REPLAY_COMMAND(DrawImage, drawImage);
+
+        // The empty commands have no payloads.
+        case CommandType::PopClip: backend.popClip({}); break;
+        case CommandType::PopLayer: backend.popLayer({}); break;
+
+        default: break;
+        }
+#undef D14_REPLAY_COMMAND
+    }
+
+    DisplayList::Statistics DisplayList::statistics() const
+    {
+        Statistics stats = {};
+
+        for (auto& record : m_records)
+        {
+            auto& item = stats.commands[(size_t)record.type];
+
+            ++item.count;
+            item.totalDuration += record.duration;
+            item.maxDuration = std::max(item.maxDuration, record.duration);
+
+            stats.totalDuration += record.duration;
+        }
+        return stats;
+    }
+
+    bool DisplayList::save(const std::filesystem::path& path) const
+    {
+        Header header =
+        {
+            .resourceCount = (uint32_t)m_resources.size(),
+            .commandCount = (uint32_t)m_records.size(),
+            .payloadSize = m_payloads.size()
+        };
+        std::vector<ResourceRecord> resources = {};
+        resources.reserve(m_resources.size());
+
+        std::vector<uint32_t> names = {};
+
+        for (auto& resource : m_resources)
+        {
+            resources.push_back(
+            {
+                .type = resource.type,
+                .bounds = resource.bounds,
+                .nameLength = (uint32_t)resource.name.size(),
+                .fontSize = resource.fontSize
+            });
+            // wchar_t is 16 bits on Windows and 32 bits on the POSIX systems.
+            for (auto c : resource.name) names.push_back((uint32_t)c);
+        }
+        header.nameSize = names.size();
+
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+
+        stream.write((const char*)&header, sizeof(header));
+        stream.write((const char*)resources.data(), resources.size() * sizeof(ResourceRecord));
+        stream.write((const char*)names.data(), names.size() * sizeof(uint32_t));
+        stream.write((const char*)m_records.data(), m_records.size() * sizeof(Record));
+        stream.write((const char*)m_payloads.data(), m_payloads.size());
+
+        return stream.good();
+    }
+
+    bool DisplayList::load(const std::filesystem::path& path)
+    {
+        clear();
+
+        std::ifstream stream(path, std::ios::binary);
+
+        Header header = {};
+        if (!stream.read((char*)&header, sizeof(header)) ||
+            header.magic != g_magic || header.version != g_version)
+        {
+            return false;
+        }
+        // Rejects the sizes that can not come from a valid file before
+        // allocating anything.
+        std::error_code ec = {};
+        auto fileSize = (uint64_t)std::filesystem::file_size(path, ec);
+
+        auto expectedSize =
+            sizeof(Header) +
+            header.resourceCount * (uint64_t)sizeof(ResourceRecord) +
+            header.nameSize * sizeof(uint32_t) +
+            header.commandCount * (uint64_t)sizeof(Record) +
+            header.payloadSize;
+
+        if (ec || fileSize != expectedSize || header.payloadSize > UINT32_MAX)
+        {
+            return false;
+        }
+        std::vector<ResourceRecord> resources(header.resourceCount);
+        std::vector<uint32_t> names(header.nameSize);
+
+        m_records.resize(header.commandCount);
+        m_payloads.resize(header.payloadSize);
+
+        stream.read((char*)resources.data(), resources.size() * sizeof(ResourceRecord));
+        stream.read((char*)names.data(), names.size() * sizeof(uint32_t));
+        stream.read((char*)m_records.data(), m_records.size() * sizeof(Record));
+        stream.read((char*)m_payloads.data(), m_payloads.size());
+
+        auto valid = stream.good();
+
+        uint64_t nameOffset = 0;
+        for (auto& record : resources)
+        {
+            if (!valid) break;
+
+            if (record.type >= ResourceType::Count ||
+                nameOffset + record.nameLength > names.size())
+            {
+                valid = false; break;
+            }
+            Resource resource =
+            {
+                .type = record.type,
+                .bounds = record.bounds,
+                .fontSize = record.fontSize
+            };
+            resource.name.reserve(record.nameLength);
+
+            for (uint32_t i = 0; i < record.nameLength; ++i)
+            {
+                resource.name.push_back((wchar_t)names[nameOffset + i]);
+            }
+            nameOffset += record.nameLength;
+
+            m_resources.push_back(std::move(resource));
+        }
+        for (auto& record : m_records)
+        {
+            if (!valid) break;
+
+            if (record.type >= CommandType::Count ||
+                record.offset % 4 != 0 ||
+                record.offset + payloadSizeOf(record.type) > m_payloads.size())
+            {
+                valid = false;
+            }
+        }
+        if (!valid)
+        {
+            clear();
+        }
+        return valid;
+    }
+}
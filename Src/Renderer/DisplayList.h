@@ -0,0 +1,363 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    // Records the 2D draw commands of a frame in a backend-neutral form
+    // (see D2D1Recorder), which can be replayed to a backend or saved to
+    // a file, e.g. to reproduce a slow frame reported by a user.
+    //
+    // The commands refer to the resources (the bitmaps, the text layouts,
+    // the geometries...) by their indices in the resource table, where
+    // each one has a portable description and optionally the live object,
+    // which is only available in the process that records it.
+    //
+    // File layout (native endianness):
+    // header, the resource records, the names of the resources (each
+    // character stored as 32 bits), the command records (with the timing),
+    // the payloads of the commands.
+
+    struct DisplayList
+    {
+        struct Point
+        {
+            float x = 0.0f, y = 0.0f;
+        };
+        struct Rect
+        {
+            float left = 0.0f, top = 0.0f, right = 0.0f, bottom = 0.0f;
+        };
+        struct Color
+        {
+            float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+        };
+        struct Matrix
+        {
+            float m11 = 1.0f, m12 = 0.0f;
+            float m21 = 0.0f, m22 = 1.0f;
+            float dx = 0.0f, dy = 0.0f;
+        };
+
+    public:
+        using ResourceID = uint32_t;
+
+        constexpr static ResourceID g_nullResource = UINT32_MAX;
+
+        enum class ResourceType : uint32_t
+        {
+            Brush, StrokeStyle, Bitmap, TextLayout, Geometry, Image, Target, Count
+        };
+        struct Resource
+        {
+            ResourceType type = ResourceType::Brush;
+
+            // The size of the bitmap/target, the ink bounds of the text
+            // layout (the layout box with the overhangs) and the bounds of
+            // the geometry respectively.
+            Rect bounds = {};
+
+            // The font family of the text layout.
+            Wstring name = {};
+            float fontSize = 0.0f;
+
+            // The live object (e.g. ID2D1Bitmap), which is not saved.
+            SharedPtr<void> object = {};
+        };
+
+        // The solid brushes are stored by value since the shared ones are
+        // recolored before each draw (see resource_utils::solidColorBrush).
+        struct Brush
+        {
+            ResourceID resource = g_nullResource;
+
+            Color color = {};
+            float opacity = 1.0f;
+        };
+
+    public:
+        enum class CommandType : uint16_t
+        {
+            SetTarget, SetTransform, Clear,
+            PushClip, PopClip, PushLayer, PopLayer,
+            FillRect, DrawRect, FillRoundedRect, DrawRoundedRect, DrawLine,
+            DrawBitmap, DrawTextLayout, FillGeometry, DrawGeometry, DrawImage,
+            Count
+        };
+        static const char* nameOf(CommandType type);
+
+        // The null resource refers to the target of the frame.
+        struct SetTarget
+        {
+            constexpr static auto g_type = CommandType::SetTarget;
+
+            ResourceID target = g_nullResource;
+        };
+        struct SetTransform
+        {
+            constexpr static auto g_type = CommandType::SetTransform;
+
+            Matrix transform = {};
+        };
+        struct Clear
+        {
+            constexpr static auto g_type = CommandType::Clear;
+
+            Color color = {};
+        };
+        struct PushClip
+        {
+            constexpr static auto g_type = CommandType::PushClip;
+
+            Rect rect = {};
+            uint32_t antialiasMode = 0;
+        };
+        struct PopClip
+        {
+            constexpr static auto g_type = CommandType::PopClip;
+        };
+        struct PushLayer
+        {
+            constexpr static auto g_type = CommandType::PushLayer;
+
+            Rect bounds = {};
+            ResourceID mask = g_nullResource; // geometry
+            Matrix maskTransform = {};
+            float opacity = 1.0f;
+            ResourceID opacityBrush = g_nullResource;
+        };
+        struct PopLayer
+        {
+            constexpr static auto g_type = CommandType::PopLayer;
+        };
+        struct FillRect
+        {
+            constexpr static auto g_type = CommandType::FillRect;
+
+            Rect rect = {};
+            Brush brush = {};
+        };
+        struct DrawRect
+        {
+            constexpr static auto g_type = CommandType::DrawRect;
+
+            Rect rect = {};
+            Brush brush = {};
+            float strokeWidth = 1.0f;
+            ResourceID strokeStyle = g_nullResource;
+        };
+        struct FillRoundedRect
+        {
+            constexpr static auto g_type = CommandType::FillRoundedRect;
+
+            Rect rect = {};
+            float radiusX = 0.0f, radiusY = 0.0f;
+            Brush brush = {};
+        };
+        struct DrawRoundedRect
+        {
+            constexpr static auto g_type = CommandType::DrawRoundedRect;
+
+            Rect rect = {};
+            float radiusX = 0.0f, radiusY = 0.0f;
+            Brush brush = {};
+            float strokeWidth = 1.0f;
+            ResourceID strokeStyle = g_nullResource;
+        };
+        struct DrawLine
+        {
+            constexpr static auto g_type = CommandType::DrawLine;
+
+            Point point0 = {}, point1 = {};
+            Brush brush = {};
+            float strokeWidth = 1.0f;
+            ResourceID strokeStyle = g_nullResource;
+        };
+        struct DrawBitmap
+        {
+            constexpr static auto g_type = CommandType::DrawBitmap;
+
+            ResourceID bitmap = g_nullResource;
+            Rect destination = {};
+            float opacity = 1.0f;
+            uint32_t interpolationMode = 0;
+            // The whole bitmap is drawn if not specified.
+            uint32_t hasSource = 0;
+            Rect source = {};
+        };
+        struct DrawTextLayout
+        {
+            constexpr static auto g_type = CommandType::DrawTextLayout;
+
+            ResourceID layout = g_nullResource;
+            Point origin = {};
+            Brush brush = {};
+            uint32_t options = 0;
+        };
+        struct FillGeometry
+        {
+            constexpr static auto g_type = CommandType::FillGeometry;
+
+            ResourceID geometry = g_nullResource;
+            Brush brush = {};
+        };
+        struct DrawGeometry
+        {
+            constexpr static auto g_type = CommandType::DrawGeometry;
+
+            ResourceID geometry = g_nullResource;
+            Brush brush = {};
+            float strokeWidth = 1.0f;
+            ResourceID strokeStyle = g_nullResource;
+        };
+        struct DrawImage
+        {
+            constexpr static auto g_type = CommandType::DrawImage;
+
+            ResourceID image = g_nullResource;
+            Point offset = {};
+            // The output of the effect depends on its current inputs, so
+            // the bounds (offset included) are captured with each draw.
+            uint32_t hasBounds = 0;
+            Rect bounds = {};
+        };
+
+    protected:
+        std::vector<Resource> m_resources = {};
+
+        // Maps the live objects to their resources, so each one is added
+        // only once.  The keys can not be reused by other objects since the
+        // resources keep them alive.
+        std::unordered_map<const void*, ResourceID> m_resourceKeys = {};
+
+        struct Record
+        {
+            CommandType type = CommandType::Count;
+            uint16_t reserved = 0;
+
+            // In m_payloads, which is always aligned to 4 bytes.
+            uint32_t offset = 0;
+
+            // The time spent in issuing the command (in nanoseconds).
+            uint64_t duration = 0;
+        };
+        std::vector<Record> m_records = {};
+
+        std::vector<uint8_t> m_payloads = {};
+
+    public:
+        static size_t payloadSizeOf(CommandType type);
+
+        void clear();
+
+        bool empty() const;
+
+        size_t commandCount() const;
+
+        CommandType typeOf(size_t index) const;
+
+        uint64_t durationOf(size_t index) const;
+
+        // Of payloadSizeOf(typeOf(index)) bytes.
+        const uint8_t* payloadOf(size_t index) const;
+
+        // Returns null if the index or the type does not match.
+        template<typename Command_T>
+        const Command_T* commandAt(size_t index) const
+        {
+            if (index >= m_records.size() || m_records[index].type != Command_T::g_type)
+            {
+                return nullptr;
+            }
+            return (const Command_T*)(m_payloads.data() + m_records[index].offset);
+        }
+
+        template<typename Command_T>
+        void record(const Command_T& command, uint64_t duration = 0)
+        {
+            static_assert(std::is_trivially_copyable_v<Command_T>);
+            static_assert(sizeof(Command_T) % 4 == 0 || std::is_empty_v<Command_T>);
+
+            auto offset = m_payloads.size();
+            if constexpr (!std::is_empty_v<Command_T>)
+            {
+                m_payloads.resize(offset + sizeof(Command_T));
+                std::memcpy(m_payloads.data() + offset, &command, sizeof(Command_T));
+            }
+            m_records.push_back({ Command_T::g_type, 0, (uint32_t)offset, duration });
+        }
+
+        // Copies the command with its timing, e.g. to reorder the list.
+        void append(const DisplayList& other, size_t index);
+
+    public:
+        const std::vector<Resource>& resources() const;
+
+        // Replaces the resource table (the IDs are kept).
+        void assignResources(const DisplayList& other);
+
+        // Returns null if the ID is out of range (e.g. g_nullResource).
+        const Resource* resource(ResourceID id) const;
+
+        Optional<ResourceID> findResource(const void* key) const;
+
+        // The key is usually the address of the live object.
+        ResourceID addResource(const void* key, Resource resource);
+
+    public:
+        struct IBackend
+        {
+            virtual void setTarget(const SetTarget& command) { }
+            virtual void setTransform(const SetTransform& command) { }
+            virtual void clear(const Clear& command) { }
+
+            virtual void pushClip(const PushClip& command) { }
+            virtual void popClip(const PopClip& command) { }
+            virtual void pushLayer(const PushLayer& command) { }
+            virtual void popLayer(const PopLayer& command) { }
+
+            virtual void fillRect(const FillRect& command) { }
+            virtual void drawRect(const DrawRect& command) { }
+            virtual void fillRoundedRect(const FillRoundedRect& command) { }
+            virtual void drawRoundedRect(const DrawRoundedRect& command) { }
+            virtual void drawLine(const DrawLine& command) { }
+
+            virtual void drawBitmap(const DrawBitmap& command) { }
+            virtual void drawTextLayout(const DrawTextLayout& command) { }
+            virtual void fillGeometry(const FillGeometry& command) { }
+            virtual void drawGeometry(const DrawGeometry& command) { }
+            virtual void drawImage(const DrawImage& command) { }
+        };
+        void replay(IBackend& backend) const;
+
+        // Also measures each command, where durations[i] is of command i.
+        void replay(IBackend& backend, std::vector<uint64_t>& durations) const;
+
+    protected:
+        void replayCommand(size_t index, IBackend& backend) const;
+
+    public:
+        struct Statistics
+        {
+            struct Item
+            {
+                uint64_t count = 0;
+
+                uint64_t totalDuration = 0;
+                uint64_t maxDuration = 0;
+            };
+            std::array<Item, (size_t)CommandType::Count> commands = {};
+
+            uint64_t totalDuration = 0;
+        };
+        Statistics statistics() const;
+
+    public:
+        // The live objects are not saved, so the loaded resources only have
+        // the descriptions.  Returns false if the file can not be written
+        // or is corrupted respectively.
+        bool save(const std::filesystem::path& path) const;
+
+        bool load(const std::filesystem::path& path);
+    };
+}
@@ -0,0 +1,483 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/DisplayListBatcher.h"
+
+namespace d14engine::renderer
+{
+    namespace
+    {
+        using Rect = DisplayList::Rect;
+        using Matrix = DisplayList::Matrix;
+        using CommandType = DisplayList::CommandType;
+
+        Rect normalized(const Rect& rect)
+        {
+            return
+            {
+                std::min(rect.left, rect.right), std::min(rect.top, rect.bottom),
+                std::max(rect.left, rect.right), std::max(rect.top, rect.bottom)
+            };
+        }
+
+        Rect inflated(const Rect& rect, float value)
+        {
+            return { rect.left - value, rect.top - value, rect.right + value, rect.bottom + value };
+        }
+
+        Rect offset(const Rect& rect, const DisplayList::Point& point)
+        {
+            return { rect.left + point.x, rect.top + point.y, rect.right + point.x, rect.bottom + point.y };
+        }
+
+        Rect united(const Rect& a, const Rect& b)
+        {
+            return
+            {
+                std::min(a.left, b.left), std::min(a.top, b.top),
+                std::max(a.right, b.right), std::max(a.bottom, b.bottom)
+            };
+        }
+
+        bool overlaps(const Rect& a, const Rect& b)
+        {
+            return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+        }
+
+        bool isFinite(const Rect& rect)
+        {
+            return std::isfinite(rect.left) && std::isfinite(rect.top) &&
+                   std::isfinite(rect.right) && std::isfinite(rect.bottom);
+        }
+
+        // The bounding box of the transformed corners.
+        Rect transformed(const Rect& rect, const Matrix& m)
+        {
+            std::array<DisplayList::Point, 4> corners =
+            {{
+                { rect.left, rect.top }, { rect.right, rect.top },
+                { rect.left, rect.bottom }, { rect.right, rect.bottom }
+            }};
+            Rect result =
+            {
+                +INFINITY, +INFINITY, -INFINITY, -INFINITY
+            };
+            for (auto& p : corners)
+            {
+                auto x = p.x * m.m11 + p.y * m.m21 + m.dx;
+                auto y = p.x * m.m12 + p.y * m.m22 + m.dy;
+
+                result = united(result, { x, y, x, y });
+            }
+            return result;
+        }
+
+        bool equals(const Matrix& a, const Matrix& b)
+        {
+            return a.m11 == b.m11 && a.m12 == b.m12 &&
+                   a.m21 == b.m21 && a.m22 == b.m22 &&
+                   a.dx == b.dx && a.dy == b.dy;
+        }
+
+        bool equals(const Optional<Matrix>& a, const Optional<Matrix>& b)
+        {
+            if (a.has_value() != b.has_value()) return false;
+
+            return !a.has_value() || equals(a.value(), b.value());
+        }
+
+        bool equals(const DisplayList::Brush& a, const DisplayList::Brush& b)
+        {
+            return a.resource == b.resource && a.opacity == b.opacity &&
+                   a.color.r == b.color.r && a.color.g == b.color.g &&
+                   a.color.b == b.color.b && a.color.a == b.color.a;
+        }
+
+        // The commands depending on the current transform.
+        bool isTransformed(CommandType type)
+        {
+            return DisplayListBatcher::isDraw(type) ||
+                type == CommandType::PushClip || type == CommandType::PushLayer;
+        }
+    }
+
+    bool DisplayListBatcher::Key::operator==(const Key& other) const
+    {
+        return category == other.category && source == other.source && equals(brush, other.brush);
+    }
+
+    const DisplayListBatcher::Statistics& DisplayListBatcher::statistics() const
+    {
+        return m_statistics;
+    }
+
+    bool DisplayListBatcher::isDraw(CommandType type)
+    {
+        return type >= CommandType::FillRect && type <= CommandType::DrawImage;
+    }
+
+    Optional<Rect> DisplayListBatcher::localBoundsOf(const DisplayList& list, size_t index)
+    {
+        Optional<Rect> bounds = {};
+
+        // Covers the joins and the caps of the strokes.
+        auto stroked = [](const Rect& rect, float strokeWidth)
+        {
+            return inflated(normalized(rect), std::abs(strokeWidth));
+        };
+        switch (list.typeOf(index))
+        {
+        case CommandType::FillRect:
+        {
+            auto cmd = list.commandAt<DisplayList::FillRect>(index);
+            bounds = normalized(cmd->rect);
+            break;
+        }
+        case CommandType::DrawRect:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawRect>(index);
+            bounds = stroked(cmd->rect, cmd->strokeWidth);
+            break;
+        }
+        case CommandType::FillRoundedRect:
+        {
+            auto cmd = list.commandAt<DisplayList::FillRoundedRect>(index);
+            bounds = normalized(cmd->rect);
+            break;
+        }
+        case CommandType::DrawRoundedRect:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawRoundedRect>(index);
+            bounds = stroked(cmd->rect, cmd->strokeWidth);
+            break;
+        }
+        case CommandType::DrawLine:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawLine>(index);
+            bounds = stroked({ cmd->point0.x, cmd->point0.y, cmd->point1.x, cmd->point1.y }, cmd->strokeWidth);
+            break;
+        }
+        case CommandType::DrawBitmap:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawBitmap>(index);
+            bounds = normalized(cmd->destination);
+            break;
+        }
+        case CommandType::DrawTextLayout:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawTextLayout>(index);
+            if (auto layout = list.resource(cmd->layout))
+            {
+                bounds = offset(normalized(layout->bounds), cmd->origin);
+            }
+            break;
+        }
+        case CommandType::FillGeometry:
+        {
+            auto cmd = list.commandAt<DisplayList::FillGeometry>(index);
+            if (auto geometry = list.resource(cmd->geometry))
+            {
+                bounds = normalized(geometry->bounds);
+            }
+            break;
+        }
+        case CommandType::DrawGeometry:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawGeometry>(index);
+            if (auto geometry = list.resource(cmd->geometry))
+            {
+                bounds = stroked(geometry->bounds, cmd->strokeWidth);
+            }
+            break;
+        }
+        case CommandType::DrawImage:
+        {
+            auto cmd = list.commandAt<DisplayList::DrawImage>(index);
+            if (cmd->hasBounds)
+            {
+                bounds = normalized(cmd->bounds);
+            }
+            break;
+        }
+        default: break;
+        }
+        if (bounds.has_value() && !isFinite(bounds.value()))
+        {
+            bounds.reset();
+        }
+        return bounds;
+    }
+
+    Optional<DisplayListBatcher::Key> DisplayListBatcher::keyOf(const DisplayList& list, size_t index)
+    {
+        using Category = Key::Category;
+
+        switch (list.typeOf(index))
+        {
+        case CommandType::FillRect:
+            return Key{ .brush = list.commandAt<DisplayList::FillRect>(index)->brush };
+        case CommandType::DrawRect:
+            return Key{ .brush = list.commandAt<DisplayList::DrawRect>(index)->brush };
+        case CommandType::FillRoundedRect:
+            return Key{ .brush = list.commandAt<DisplayList::FillRoundedRect>(index)->brush };
+        case CommandType::DrawRoundedRect:
+            return Key{ .brush = list.commandAt<DisplayList::DrawRoundedRect>(index)->brush };
+        case CommandType::DrawLine:
+            return Key{ .brush = list.commandAt<DisplayList::DrawLine>(index)->brush };
+        case CommandType::FillGeometry:
+            return Key{ .brush = list.commandAt<DisplayList::FillGeometry>(index)->brush };
+        case CommandType::DrawGeometry:
+            return Key{ .brush = list.commandAt<DisplayList::DrawGeometry>(index)->brush };
+        case CommandType::DrawTextLayout:
+            return Key{ .category = Category::Text, .brush = list.commandAt<DisplayList::DrawTextLayout>(index)->brush };
+        case CommandType::DrawBitmap:
+            return Key{ .category = Category::Bitmap, .source = list.commandAt<DisplayList::DrawBitmap>(index)->bitmap };
+        case CommandType::DrawImage:
+            return Key{ .category = Category::Image, .source = list.commandAt<DisplayList::DrawImage>(index)->image };
+        default:
+            return std::nullopt;
+        }
+    }
+
+    void DisplayListBatcher::place(const Draw& draw)
+    {
+        auto bounds = inflated(draw.bounds, margin);
+
+        auto last = m_batches.size() > window ? m_batches.size() - window : 0;
+
+        // Finds the latest batch of the same key that the draw can be moved
+        // to, i.e. the draw overlaps none of the batches after it.
+        for (auto i = m_batches.size(); i-- > last; )
+        {
+            auto& batch = m_batches[i];
+            if (batch.key == draw.key)
+            {
+                batch.draws.push_back(draw);
+                batch.bounds = united(batch.bounds, bounds);
+                return;
+            }
+            if (overlaps(batch.bounds, bounds)) break;
+        }
+        m_batches.push_back({ draw.key, bounds, { draw } });
+    }
+
+    DisplayList DisplayListBatcher::run(const DisplayList& list, std::vector<size_t>* order)
+    {
+        m_statistics = {};
+        m_batches.clear();
+
+        DisplayList result = {};
+        result.assignResources(list);
+
+        if (order != nullptr) order->clear();
+
+        // Empty until the first SetTransform, i.e. inherited from the
+        // context, and then the bounds in the target space are unknown.
+        Optional<Matrix> current = {}, issued = {};
+
+        auto syncTransform = [&]
+        {
+            if (current.has_value() && !equals(current, issued))
+            {
+                result.record(DisplayList::SetTransform{ .transform = current.value() });
+                issued = current;
+            }
+        };
+        auto issue = [&](size_t index)
+        {
+            result.append(list, index);
+            if (order != nullptr) order->push_back(index);
+        };
+        size_t maxIssued = 0;
+
+        auto flush = [&]
+        {
+            for (auto& batch : m_batches)
+            {
+                for (auto& draw : batch.draws)
+                {
+                    if (!issued.has_value() || !equals(draw.transform, issued.value()))
+                    {
+                        result.record(DisplayList::SetTransform{ .transform = draw.transform });
+                        issued = draw.transform;
+                    }
+                    issue(draw.index);
+
+                    if (draw.index < maxIssued) ++m_statistics.movedDraws;
+                    maxIssued = std::max(maxIssued, draw.index);
+                }
+            }
+            m_statistics.batches += m_batches.size();
+            m_batches.clear();
+        };
+        for (size_t i = 0; i < list.commandCount(); ++i)
+        {
+            auto type = list.typeOf(i);
+
+            if (type == CommandType::SetTransform)
+            {
+                // The draws under the inherited transform are not moved
+                // across the first one.
+                if (!current.has_value()) flush();
+
+                current = list.commandAt<DisplayList::SetTransform>(i)->transform;
+                continue;
+            }
+            if (isDraw(type))
+            {
+                ++m_statistics.draws;
+
+                auto bounds = localBoundsOf(list, i);
+                if (current.has_value() && bounds.has_value())
+                {
+                    Draw draw =
+                    {
+                        .index = i,
+                        .transform = current.value(),
+                        .bounds = transformed(bounds.value(), current.value()),
+                        .key = keyOf(list, i).value()
+                    };
+                    if (isFinite(draw.bounds))
+                    {
+                        place(draw); continue;
+                    }
+                }
+            }
+            flush();
+            ++m_statistics.barriers;
+
+            if (isTransformed(type)) syncTransform();
+
+            issue(i);
+            maxIssued = std::max(maxIssued, i);
+        }
+        flush();
+
+        // Leaves the context in the same transform as the original list.
+        syncTransform();
+
+        return result;
+    }
+
+    size_t DisplayListBatcher::countStateChanges(const DisplayList& list)
+    {
+        size_t count = 0;
+
+        Optional<Key> lastKey = {};
+        Optional<Matrix> transform = {};
+
+        for (size_t i = 0; i < list.commandCount(); ++i)
+        {
+            if (list.typeOf(i) == CommandType::SetTransform)
+            {
+                auto& value = list.commandAt<DisplayList::SetTransform>(i)->transform;
+                if (!equals(transform, value))
+                {
+                    transform = value; ++count;
+                }
+            }
+            else if (auto key = keyOf(list, i); key.has_value())
+            {
+                if (lastKey.has_value() && !(lastKey.value() == key.value())) ++count;
+
+                lastKey = key;
+            }
+        }
+        return count;
+    }
+
+    bool DisplayListBatcher::verify(
+        const DisplayList& original,
+        const DisplayList& batched,
+        const std::vector<size_t>& order) const
+    {
+        // The transform of each command of the list.
+        auto transformsOf = [](const DisplayList& list)
+        {
+            std::vector<Optional<Matrix>> transforms(list.commandCount());
+
+            Optional<Matrix> current = {};
+            for (size_t i = 0; i < list.commandCount(); ++i)
+            {
+                if (list.typeOf(i) == CommandType::SetTransform)
+                {
+                    current = list.commandAt<DisplayList::SetTransform>(i)->transform;
+                }
+                transforms[i] = current;
+            }
+            return transforms;
+        };
+        auto originalTransforms = transformsOf(original);
+        auto batchedTransforms = transformsOf(batched);
+
+        // The final transforms must be the same.
+        if (!originalTransforms.empty() && !batchedTransforms.empty() &&
+            !equals(originalTransforms.back(), batchedTransforms.back()))
+        {
+            return false;
+        }
+        // The position of each original command in the output.
+        std::vector<size_t> positions(original.commandCount(), SIZE_MAX);
+
+        size_t k = 0;
+        for (size_t j = 0; j < batched.commandCount(); ++j)
+        {
+            auto type = batched.typeOf(j);
+            if (type == CommandType::SetTransform) continue;
+
+            if (k >= order.size()) return false;
+            auto i = order[k++];
+
+            if (i >= original.commandCount() || positions[i] != SIZE_MAX) return false;
+            positions[i] = j;
+
+            auto size = DisplayList::payloadSizeOf(type);
+            if (original.typeOf(i) != type ||
+                std::memcmp(original.payloadOf(i), batched.payloadOf(j), size) != 0)
+            {
+                return false;
+            }
+            if (isTransformed(type) && !equals(originalTransforms[i], batchedTransforms[j]))
+            {
+                return false;
+            }
+        }
+        if (k != order.size()) return false;
+
+        // The bounds of the reorderable draws in the target space.
+        std::vector<Optional<Rect>> bounds(original.commandCount());
+
+        for (size_t i = 0; i < original.commandCount(); ++i)
+        {
+            auto type = original.typeOf(i);
+            if (type == CommandType::SetTransform) continue;
+
+            // Every command other than SetTransform must be issued.
+            if (positions[i] == SIZE_MAX) return false;
+
+            if (isDraw(type) && originalTransforms[i].has_value())
+            {
+                if (auto local = localBoundsOf(original, i); local.has_value())
+                {
+                    auto rect = transformed(local.value(), originalTransforms[i].value());
+                    if (isFinite(rect)) bounds[i] = inflated(rect, margin);
+                }
+            }
+        }
+        for (size_t i = 0; i < original.commandCount(); ++i)
+        {
+            if (positions[i] == SIZE_MAX) continue;
+
+            for (size_t j = i + 1; j < original.commandCount(); ++j)
+            {
+                if (positions[j] == SIZE_MAX) continue;
+
+                // Only the disjoint draws can be swapped.
+                auto swappable = bounds[i].has_value() && bounds[j].has_value() &&
+                    !overlaps(bounds[i].value(), bounds[j].value());
+
+                if (!swappable && positions[i] > positions[j]) return false;
+            }
+        }
+        return true;
+    }
+}
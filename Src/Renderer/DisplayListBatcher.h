@@ -0,0 +1,118 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Renderer/DisplayList.h"
+
+namespace d14engine::renderer
+{
+    // Reorders the draws of a display list so that those sharing the same
+    // state (the brush of the shapes and the texts, the source of the
+    // bitmaps) are issued together, which saves the state changes (e.g.
+    // recoloring the shared brush) and lets D2D1 batch them.
+    //
+    // A draw is only moved before the draws it does not overlap (with the
+    // margin of the antialiasing), so the output is the same as that in
+    // the original order.  The other commands (the targets, the clips, the
+    // layers...) are kept in place and close the current batches, and the
+    // transforms are folded into the draws and set again only when needed.
+    //
+    // D2D1Recorder runs it on the commands deferred in each draw of the
+    // frame (see D2D1Recorder::batching), and DisplayListReplay on the
+    // captured lists.
+    struct DisplayListBatcher
+    {
+        // The bounds are inflated by the margin (in DIPs) before testing
+        // the overlaps, since the antialiased edges of the adjacent draws
+        // blend into the same pixels.
+        float margin = 1.0f;
+
+        // Count of the latest batches a draw is tested against, which
+        // bounds the time of the pass to linear.
+        size_t window = 64;
+
+        struct Statistics
+        {
+            size_t draws = 0;
+            size_t batches = 0;
+
+            // The draws issued after any of their successors.
+            size_t movedDraws = 0;
+
+            // The commands that close the batches (see above).
+            size_t barriers = 0;
+        };
+        const Statistics& statistics() const;
+
+        // The state a draw depends on, where the draws of the same key can
+        // share a batch.
+        struct Key
+        {
+            enum class Category : uint32_t
+            {
+                Shape, Text, Bitmap, Image
+            }
+            category = Category::Shape;
+
+            // Of the shapes and the texts.
+            DisplayList::Brush brush = {};
+
+            // Of the bitmaps and the images.
+            DisplayList::ResourceID source = DisplayList::g_nullResource;
+
+            bool operator==(const Key& other) const;
+        };
+
+    protected:
+        Statistics m_statistics = {};
+
+        struct Draw
+        {
+            size_t index = 0;
+
+            DisplayList::Matrix transform = {};
+
+            // Transformed to the target space.
+            DisplayList::Rect bounds = {};
+
+            Key key = {};
+        };
+        struct Batch
+        {
+            Key key = {};
+
+            DisplayList::Rect bounds = {};
+
+            std::vector<Draw> draws = {};
+        };
+        std::vector<Batch> m_batches = {};
+
+        void place(const Draw& draw);
+
+    public:
+        // Returns the reordered list, which shares the resources with the
+        // original one.  The order receives the index of the original
+        // command of each one in the output (the synthesized transforms
+        // excluded), which verify takes.
+        DisplayList run(const DisplayList& list, std::vector<size_t>* order = nullptr);
+
+    public:
+        // The bounds of the draw in its local space, or empty if unknown,
+        // in which case the draw is treated as a barrier.
+        static Optional<DisplayList::Rect> localBoundsOf(const DisplayList& list, size_t index);
+
+        static Optional<Key> keyOf(const DisplayList& list, size_t index);
+
+        static bool isDraw(DisplayList::CommandType type);
+
+        // Counts the changes of the brushes, the bitmaps and the transforms
+        // between the consecutive draws, i.e. the work the batching saves.
+        static size_t countStateChanges(const DisplayList& list);
+
+        // Checks the output of run against the original order: the same
+        // commands under the same transforms, the barriers in place, and
+        // every pair of the overlapping draws in the original order.  This
+        // tests all the pairs (quadratic), so it is meant for the tests.
+        bool verify(const DisplayList& original, const DisplayList& batched, const std::vector<size_t>& order) const;
+    };
+}
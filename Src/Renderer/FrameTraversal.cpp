@@ -0,0 +1,123 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/FrameTraversal.h"
+
+#include "Renderer/Interfaces/ICullingCamera.h"
+
+namespace d14engine::renderer
+{
+    void FrameTraversal::update(const DrawTarget& target, IBackend& backend)
+    {
+        if (std::holds_alternative<D3D12Target>(target))
+        {
+            for (auto& elem : std::get<D3D12Target>(target))
+            {
+                if (elem.first->isD3d12LayerVisible())
+                {
+                    backend.updateD3d12Layer(elem.first.get());
+                }
+                for (auto& obj : elem.second)
+                {
+                    if (obj->isD3d12ObjectVisible())
+                    {
+                        backend.updateD3d12Object(obj.get());
+                    }
+                }
+            }
+        }
+        else if (std::holds_alternative<D2D1Target>(target))
+        {
+            for (auto& elem : std::get<D2D1Target>(target))
+            {
+                if (elem->isD2d1ObjectVisible())
+                {
+                    backend.updateD2d1Object(elem.get());
+                }
+            }
+        }
+    }
+
+    void FrameTraversal::draw(const DrawTarget& target, IBackend& backend)
+    {
+        if (std::holds_alternative<D3D12Target>(target))
+        {
+            drawD3d12Target(std::get<D3D12Target>(target), backend);
+        }
+        if (std::holds_alternative<D2D1Target>(target))
+        {
+            drawD2d1Target(std::get<D2D1Target>(target), backend);
+        }
+    }
+
+    void FrameTraversal::drawD3d12Target(const D3D12Target& target, IBackend& backend)
+    {
+        backend.beginD3d12Target();
+
+        for (auto& layer : target)
+        {
+            if (layer.first->isD3d12LayerVisible())
+            {
+                backend.drawD3d12Layer(layer.first.get());
+            }
+            auto camera = layer.first->d3d12CullingCamera();
+            if (camera == nullptr)
+            {
+                for (auto& obj : layer.second)
+                {
+                    if (obj->isD3d12ObjectVisible())
+                    {
+                        backend.drawD3d12Object(obj.get());
+                    }
+                }
+                continue;
+            }
+            // The bounds of all the objects are tested at once (in batches)
+            // before any of them is recorded.
+            m_cullingObjects.clear();
+            for (auto& obj : layer.second)
+            {
+                if (obj->isD3d12ObjectVisible())
+                {
+                    m_cullingObjects.push_back(obj.get());
+                }
+            }
+            camera->cullD3d12Objects(m_cullingObjects, m_cullingResults);
+
+            size_t culledCount = 0;
+            for (size_t i = 0; i < m_cullingObjects.size(); ++i)
+            {
+                if (m_cullingResults[i])
+                {
+                    backend.drawD3d12Object(m_cullingObjects[i]);
+                }
+                else ++culledCount;
+            }
+            if (culledCount > 0)
+            {
+                backend.cullD3d12Objects(layer.first.get(), culledCount);
+            }
+        }
+        backend.endD3d12Target();
+    }
+
+    void FrameTraversal::drawD2d1Target(const D2D1Target& target, IBackend& backend)
+    {
+        for (auto& obj2d : target)
+        {
+            if (obj2d->isD2d1ObjectVisible())
+            {
+                backend.drawD2d1Layer(obj2d.get());
+            }
+        }
+        backend.beginD2d1Target();
+
+        for (auto& obj2d : target)
+        {
+            if (obj2d->isD2d1ObjectVisible())
+            {
+                backend.drawD2d1Object(obj2d.get());
+            }
+        }
+        backend.endD2d1Target();
+    }
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Renderer/Interfaces/IDrawLayer.h"
+#include "Renderer/Interfaces/IDrawObject.h"
+#include "Renderer/Interfaces/IDrawObject2D.h"
+
+namespace d14engine::renderer
+{
+    // Visits the objects of a command layer in the order of renderNextFrame
+    // (the visibility tests and the culling included), while the backend
+    // decides what to do with each of them: Renderer records the commands
+    // and NullRenderer only counts them.
+    struct FrameTraversal
+    {
+        using DrawObjectSet = ISortable<IDrawObject>::ShrdPrioritySet;
+
+        using DrawObjectLayerMap = ISortable<IDrawLayer>::ShrdPriorityMap<DrawObjectSet>;
+
+        using D3D12Target = DrawObjectLayerMap;
+
+        using DrawObject2DSet = ISortable<IDrawObject2D>::ShrdPrioritySet;
+
+        using D2D1Target = DrawObject2DSet;
+
+        using DrawTarget = Variant<std::monostate, D3D12Target, D2D1Target>;
+
+        struct IBackend
+        {
+            virtual void updateD3d12Layer(IDrawLayer* layer) = 0;
+            virtual void updateD3d12Object(IDrawObject* obj) = 0;
+            virtual void updateD2d1Object(IDrawObject2D* obj) = 0;
+
+            // Called around the draws of each D3D12Target.
+            virtual void beginD3d12Target() { }
+            virtual void endD3d12Target() { }
+
+            virtual void drawD3d12Layer(IDrawLayer* layer) = 0;
+            virtual void drawD3d12Object(IDrawObject* obj) = 0;
+
+            // The objects of the layer rejected by the culling camera.
+            virtual void cullD3d12Objects(IDrawLayer* layer, size_t count) { }
+
+            // The layers of D2D1Target are drawn before beginD2d1Target.
+            virtual void drawD2d1Layer(IDrawObject2D* obj) = 0;
+
+            virtual void beginD2d1Target() { }
+            virtual void endD2d1Target() { }
+
+            virtual void drawD2d1Object(IDrawObject2D* obj) = 0;
+        };
+
+    protected:
+        // Reused by the layers with the culling cameras in each frame.
+        std::vector<IDrawObject*> m_cullingObjects = {};
+        std::vector<uint8_t> m_cullingResults = {};
+
+        void drawD3d12Target(const D3D12Target& target, IBackend& backend);
+
+        void drawD2d1Target(const D2D1Target& target, IBackend& backend);
+
+    public:
+        void update(const DrawTarget& target, IBackend& backend);
+
+        void draw(const DrawTarget& target, IBackend& backend);
+    };
+}
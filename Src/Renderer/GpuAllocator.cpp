@@ -0,0 +1,317 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/GpuAllocator.h"
+
+#include "Common/DirectXError.h"
+
+namespace d14engine::renderer
+{
+    GpuAllocator::Allocation::Allocation(Allocation&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    GpuAllocator::Allocation& GpuAllocator::Allocation::operator=(Allocation&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+
+            resource = std::move(other.resource);
+            m_allocator = std::move(other.m_allocator);
+            m_poolType = other.m_poolType;
+            m_range = other.m_range;
+            m_state = other.m_state;
+
+            other.m_range = {};
+
+            if (m_allocator)
+            {
+                auto& pool = m_allocator->m_pools[(size_t)m_poolType];
+                pool->owners[ownerKey(m_range)] = this;
+            }
+        }
+        return *this;
+    }
+
+    GpuAllocator::Allocation::~Allocation()
+    {
+        reset();
+    }
+
+    bool GpuAllocator::Allocation::isPlaced() const
+    {
+        return m_allocator != nullptr;
+    }
+
+    void GpuAllocator::Allocation::reset()
+    {
+        if (m_allocator)
+        {
+            m_allocator->release(*this);
+            m_allocator.reset();
+        }
+        resource.Reset();
+        m_range = {};
+    }
+
+    GpuAllocator::GpuAllocator(ID3D12Device* device, IDXGIAdapter* adapter, UINT64 heapSize)
+        :
+        m_device(device)
+    {
+        if (adapter != nullptr)
+        {
+            // Leaves it empty if IDXGIAdapter3 is not supported.
+            adapter->QueryInterface(IID_PPV_ARGS(&m_adapter));
+        }
+        for (size_t i = 0; i < m_pools.size(); ++i)
+        {
+            auto type = (PoolType)i;
+
+            // The MSAA render targets require the 4MB alignment.
+            UINT64 alignment = type == PoolType::TargetTexture ?
+                D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT :
+                D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            m_pools[i] = std::make_unique<Pool>(Pool
+            {
+                .heapPool = HeapPool(heapSize, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+            });
+            auto pool = m_pools[i].get();
+
+            pool->heapPool.f_onCreateHeap = [this, pool, type, alignment]
+            (uint32_t index, uint64_t size)
+            {
+                D3D12_HEAP_DESC desc =
+                {
+                    .SizeInBytes = size,
+                    .Properties =
+                    {
+                        .Type = type == PoolType::UploadBuffer ?
+                            D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT
+                    },
+                    .Alignment = alignment
+                };
+                switch (type)
+                {
+                case PoolType::DefaultBuffer:
+                case PoolType::UploadBuffer:
+                    desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS; break;
+                case PoolType::Texture:
+                    desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES; break;
+                default:
+                    desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES; break;
+                }
+                ComPtr<ID3D12Heap> heap = {};
+                if (FAILED(m_device->CreateHeap(&desc, IID_PPV_ARGS(&heap))))
+                {
+                    return false;
+                }
+                if (index >= pool->heaps.size()) pool->heaps.resize(index + 1);
+                pool->heaps[index] = heap;
+
+                return true;
+            };
+            pool->heapPool.f_onReleaseHeap = [pool](uint32_t index)
+            {
+                pool->heaps[index].Reset();
+            };
+        }
+    }
+
+    GpuAllocator::PoolType GpuAllocator::poolTypeOf(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc)
+    {
+        if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            return heapType == D3D12_HEAP_TYPE_UPLOAD ? PoolType::UploadBuffer : PoolType::DefaultBuffer;
+        }
+        auto targetFlags =
+            D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+            D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+        return (desc.Flags & targetFlags) ? PoolType::TargetTexture : PoolType::Texture;
+    }
+
+    uint64_t GpuAllocator::ownerKey(const HeapPool::Allocation& range)
+    {
+        return ((uint64_t)range.heap << 32) | range.range.block;
+    }
+
+    void GpuAllocator::release(Allocation& allocation)
+    {
+        auto& pool = m_pools[(size_t)allocation.m_poolType];
+
+        pool->owners.erase(ownerKey(allocation.m_range));
+        pool->heapPool.free(allocation.m_range);
+
+        if (allocation.resource)
+        {
+            m_currRetired.push_back(std::move(allocation.resource));
+        }
+    }
+
+    GpuAllocator::Allocation GpuAllocator::createResource(
+        D3D12_HEAP_TYPE heapType,
+        const D3D12_RESOURCE_DESC& desc,
+        D3D12_RESOURCE_STATES initialState,
+        const D3D12_CLEAR_VALUE* clearValue)
+    {
+        Allocation allocation = {};
+        allocation.m_state = initialState;
+
+        if (heapType == D3D12_HEAP_TYPE_DEFAULT || heapType == D3D12_HEAP_TYPE_UPLOAD)
+        {
+            auto type = poolTypeOf(heapType, desc);
+
+            // The placement is not allowed for the combination, e.g. the
+            // upload heap only supports the buffers.
+            bool placeable = heapType == D3D12_HEAP_TYPE_DEFAULT || type == PoolType::UploadBuffer;
+
+            auto info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+            auto& pool = m_pools[(size_t)type];
+
+            auto range = placeable ? pool->heapPool.allocate(info.SizeInBytes, info.Alignment) : std::nullopt;
+            if (range.has_value())
+            {
+                auto hr = m_device->CreatePlacedResource
+                (
+                /* pHeap                */ pool->heaps[range->heap].Get(),
+                /* HeapOffset           */ range->range.offset,
+                /* pDesc                */ &desc,
+                /* InitialState         */ initialState,
+                /* pOptimizedClearValue */ clearValue,
+                /* riidResource         */
+                /* ppvResource          */ IID_PPV_ARGS(&allocation.resource)
+                );
+                if (SUCCEEDED(hr))
+                {
+                    allocation.m_allocator = shared_from_this();
+                    allocation.m_poolType = type;
+                    allocation.m_range = range.value();
+
+                    pool->owners[ownerKey(allocation.m_range)] = &allocation;
+
+                    return allocation;
+                }
+                // The range has never been used by the GPU.
+                pool->heapPool.free(range.value());
+            }
+        }
+        auto prop = CD3DX12_HEAP_PROPERTIES(heapType);
+
+        THROW_IF_FAILED(m_device->CreateCommittedResource
+        (
+        /* pHeapProperties      */ &prop,
+        /* HeapFlags            */ D3D12_HEAP_FLAG_NONE,
+        /* pDesc                */ &desc,
+        /* InitialResourceState */ initialState,
+        /* pOptimizedClearValue */ clearValue,
+        /* riidResource         */
+        /* ppvResource          */ IID_PPV_ARGS(&allocation.resource)
+        ));
+        return allocation;
+    }
+
+    void GpuAllocator::endFrame(UINT64 fenceValue)
+    {
+        for (auto& pool : m_pools)
+        {
+            pool->heapPool.endFrame(fenceValue);
+        }
+        for (auto& resource : m_currRetired)
+        {
+            m_pendingRetired.emplace_back(fenceValue, std::move(resource));
+        }
+        m_currRetired.clear();
+    }
+
+    void GpuAllocator::reclaim(UINT64 completedValue)
+    {
+        for (auto& pool : m_pools)
+        {
+            pool->heapPool.reclaim(completedValue);
+        }
+        while (!m_pendingRetired.empty() && m_pendingRetired.front().first <= completedValue)
+        {
+            m_pendingRetired.pop_front();
+        }
+    }
+
+    void GpuAllocator::trim()
+    {
+        for (auto& pool : m_pools)
+        {
+            pool->heapPool.trim();
+        }
+    }
+
+    void GpuAllocator::setBudget(PoolType type, UINT64 value)
+    {
+        m_pools[(size_t)type]->heapPool.setBudget(value);
+    }
+
+    size_t GpuAllocator::defragment(
+        PoolType type,
+        FuncRefer<bool(const Allocation& owner, ID3D12Resource* newResource)> relocate,
+        size_t maxMoves)
+    {
+        auto& pool = m_pools[(size_t)type];
+
+        return pool->heapPool.defragment([&](const HeapPool::Move& move)
+        {
+            auto itor = pool->owners.find(ownerKey(move.source));
+            if (itor == pool->owners.end()) return false;
+
+            auto owner = itor->second;
+            auto desc = owner->resource->GetDesc();
+
+            ComPtr<ID3D12Resource> resource = {};
+            auto hr = m_device->CreatePlacedResource
+            (
+            /* pHeap                */ pool->heaps[move.destination.heap].Get(),
+            /* HeapOffset           */ move.destination.range.offset,
+            /* pDesc                */ &desc,
+            /* InitialState         */ owner->m_state,
+            /* pOptimizedClearValue */ nullptr,
+            /* riidResource         */
+            /* ppvResource          */ IID_PPV_ARGS(&resource)
+            );
+            if (FAILED(hr) || !relocate(*owner, resource.Get()))
+            {
+                return false;
+            }
+            // The source range is freed by the pool after returning.
+            pool->owners.erase(itor);
+
+            m_currRetired.push_back(std::move(owner->resource));
+
+            owner->resource = std::move(resource);
+            owner->m_range = move.destination;
+
+            pool->owners[ownerKey(owner->m_range)] = owner;
+
+            return true;
+        },
+        maxMoves);
+    }
+
+    GpuAllocator::Statistics GpuAllocator::statistics() const
+    {
+        Statistics stats = {};
+
+        for (size_t i = 0; i < m_pools.size(); ++i)
+        {
+            auto& pool = stats.pools[i];
+            pool = m_pools[i]->heapPool.statistics();
+
+            stats.reservedSize += pool.reservedSize;
+            stats.usedSize += pool.usedSize;
+        }
+        if (m_adapter)
+        {
+            m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &stats.localMemory);
+            m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &stats.nonLocalMemory);
+        }
+        return stats;
+    }
+}
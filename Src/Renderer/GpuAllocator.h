@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+#include "Renderer/HeapAllocator.h"
+
+namespace d14engine::renderer
+{
+    // Places the buffers and textures in large heaps (see HeapPool) instead
+    // of creating a committed resource with an implicit heap for each one.
+    //
+    // The resources of a freed allocation are kept alive and their ranges
+    // are not reused until the current frame has been completed, so the
+    // owners can release them at any time (see Renderer::gpuAllocator).
+    struct GpuAllocator : cpp_lang_utils::NonCopyable, std::enable_shared_from_this<GpuAllocator>
+    {
+        constexpr static UINT64 g_defaultHeapSize = 64 * 1024 * 1024;
+
+        // The adapter is only used to query the video memory info.
+        GpuAllocator(ID3D12Device* device, IDXGIAdapter* adapter = nullptr, UINT64 heapSize = g_defaultHeapSize);
+
+        // Some devices (resource heap tier 1) can not place the different
+        // kinds of resources in the same heap, so each has its own pool.
+        enum class PoolType
+        {
+            DefaultBuffer, UploadBuffer, Texture, TargetTexture, Count
+        };
+        static PoolType poolTypeOf(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc);
+
+        struct Allocation
+        {
+            friend GpuAllocator;
+
+            Allocation() = default;
+
+            Allocation(Allocation&& other) noexcept;
+            Allocation& operator=(Allocation&& other) noexcept;
+
+            ~Allocation();
+
+            ComPtr<ID3D12Resource> resource = {};
+
+        protected:
+            // Null for a committed resource (e.g. the pool is out of budget).
+            SharedPtr<GpuAllocator> m_allocator = {};
+
+            PoolType m_poolType = PoolType::DefaultBuffer;
+            HeapPool::Allocation m_range = {};
+
+            // The state the resource is created in and expected to be in
+            // between the frames, with which it is recreated when moved.
+            D3D12_RESOURCE_STATES m_state = D3D12_RESOURCE_STATE_COMMON;
+
+        public:
+            bool isPlaced() const;
+
+            // Frees the range after the current frame has been completed.
+            void reset();
+        };
+
+    protected:
+        ComPtr<ID3D12Device> m_device = {};
+        ComPtr<IDXGIAdapter3> m_adapter = {};
+
+        struct Pool
+        {
+            HeapPool heapPool;
+
+            std::vector<ComPtr<ID3D12Heap>> heaps = {};
+
+            // Finds the owner of each range for the defragmentation.
+            std::unordered_map<uint64_t, Allocation*> owners = {};
+        };
+        std::array<UniquePtr<Pool>, (size_t)PoolType::Count> m_pools = {};
+
+        static uint64_t ownerKey(const HeapPool::Allocation& range);
+
+        void release(Allocation& allocation);
+
+        // The resources released in the current frame and the pending ones.
+        std::vector<ComPtr<ID3D12Resource>> m_currRetired = {};
+        std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> m_pendingRetired = {};
+
+    public:
+        // Falls back to a committed resource if the resource can not be
+        // placed (e.g. the budget of the pool is exhausted).
+        Allocation createResource(
+            D3D12_HEAP_TYPE heapType,
+            const D3D12_RESOURCE_DESC& desc,
+            D3D12_RESOURCE_STATES initialState,
+            const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+        // Called by Renderer after signaling the fence of each frame and
+        // after waiting for it respectively.
+        void endFrame(UINT64 fenceValue);
+        void reclaim(UINT64 completedValue);
+
+        // Releases the empty heaps.
+        void trim();
+
+        void setBudget(PoolType type, UINT64 value);
+
+    public:
+        // Moves the resources out of the sparsest heaps of the pool so that
+        // they can be trimmed.  For each one, relocate receives the owner
+        // and the new resource (in the same state), and should record the
+        // copy and update the references (e.g. the views), or return false
+        // to skip it.  The resource of the owner is then replaced, and the
+        // old one is released after the current frame has been completed.
+        // Returns the count of the moved resources.
+        size_t defragment(
+            PoolType type,
+            FuncRefer<bool(const Allocation& owner, ID3D12Resource* newResource)> relocate,
+            size_t maxMoves = SIZE_MAX);
+
+    public:
+        struct Statistics
+        {
+            std::array<HeapPool::Statistics, (size_t)PoolType::Count> pools = {};
+
+            UINT64 reservedSize = 0, usedSize = 0;
+
+            // The budget and usage reported by the OS, which are empty if
+            // the adapter is not provided.
+            DXGI_QUERY_VIDEO_MEMORY_INFO localMemory = {};
+            DXGI_QUERY_VIDEO_MEMORY_INFO nonLocalMemory = {};
+        };
+        Statistics statistics() const;
+    };
+}
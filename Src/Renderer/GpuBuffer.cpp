@@ -10,54 +10,86 @@ namespace d14engine::renderer
 {
     ID3D12Resource* GpuBuffer::resource() const { return m_resource.Get(); }
 
-    DefaultBuffer::DefaultBuffer(ID3D12Device* device, UINT64 byteSize)
+    void GpuBuffer::createBuffer(
+        ID3D12Device* device,
+        GpuAllocator* allocator,
+        D3D12_HEAP_TYPE heapType,
+        UINT64 byteSize,
+        D3D12_RESOURCE_STATES initialState,
+        ComPtr<ID3D12Resource>& resource,
+        GpuAllocator::Allocation& allocation)
     {
-        auto resourceProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        auto resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+        auto desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
 
-        THROW_IF_FAILED(device->CreateCommittedResource
-        (
-        /* pHeapProperties      */ &resourceProp,
-        /* HeapFlags            */ D3D12_HEAP_FLAG_NONE,
-        /* pDesc                */ &resourceDesc,
-        /* InitialResourceState */ D3D12_RESOURCE_STATE_GENERIC_READ,
-        /* pOptimizedClearValue */ nullptr,
-        /* riidResource         */
-        /* ppvResource          */ IID_PPV_ARGS(&m_resource)
-        ));
-        auto intermediateProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        auto intermediateDesc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+        if (allocator != nullptr)
+        {
+            allocation = allocator->createResource(heapType, desc, initialState);
+            resource = allocation.resource;
+            return;
+        }
+        auto prop = CD3DX12_HEAP_PROPERTIES(heapType);
 
         THROW_IF_FAILED(device->CreateCommittedResource
         (
-        /* pHeapProperties      */ &intermediateProp,
+        /* pHeapProperties      */ &prop,
         /* HeapFlags            */ D3D12_HEAP_FLAG_NONE,
-        /* pDesc                */ &intermediateDesc,
-        /* InitialResourceState */ D3D12_RESOURCE_STATE_GENERIC_READ,
+        /* pDesc                */ &desc,
+        /* InitialResourceState */ initialState,
         /* pOptimizedClearValue */ nullptr,
         /* riidResource         */
-        /* ppvResource          */ IID_PPV_ARGS(&m_intermediate)
+        /* ppvResource          */ IID_PPV_ARGS(&resource)
         ));
     }
 
+    DefaultBuffer::DefaultBuffer(
+        ID3D12Device* device,
+        UINT64 byteSize,
+        D3D12_RESOURCE_STATES readState,
+        GpuAllocator* allocator)
+        :
+        m_device(device), m_byteSize(byteSize), m_readState(readState)
+    {
+        if (allocator != nullptr) m_allocator = allocator->weak_from_this();
+
+        createBuffer(device, allocator, D3D12_HEAP_TYPE_DEFAULT, byteSize, readState, m_resource, m_allocation);
+    }
+
+    DefaultBuffer::~DefaultBuffer()
+    {
+        if (m_intermediate) m_intermediate->Unmap(0, nullptr);
+    }
+
+    void DefaultBuffer::createIntermediate()
+    {
+        // Falls back to a committed buffer if the allocator has gone.
+        auto allocator = m_allocator.lock();
+
+        // The UPLOAD heap requires GENERIC_READ.
+        createBuffer(m_device.Get(), allocator.get(), D3D12_HEAP_TYPE_UPLOAD, m_byteSize,
+                     D3D12_RESOURCE_STATE_GENERIC_READ, m_intermediate, m_intermediateAllocation);
+
+        THROW_IF_FAILED(m_intermediate->Map(0, nullptr, (void**)&m_intermediateMapped));
+    }
+
+    D3D12_RESOURCE_STATES DefaultBuffer::readState() const { return m_readState; }
+
     ID3D12Resource* DefaultBuffer::intermediate() const { return m_intermediate.Get(); }
 
     void DefaultBuffer::copyDataCPU(void* pSrc, UINT64 byteSize)
     {
-        BYTE* mapped = nullptr;
-        THROW_IF_FAILED(m_intermediate->Map(0, nullptr, (void**)&mapped));
-
-        memcpy(mapped, pSrc, (size_t)byteSize);
+        if (!m_intermediate) createIntermediate();
 
-        m_intermediate->Unmap(0, nullptr);
+        memcpy(m_intermediateMapped, pSrc, (size_t)byteSize);
     }
 
     void DefaultBuffer::copyDataGPU(ID3D12GraphicsCommandList* cmdList, UINT64 byteSize)
     {
+        if (!m_intermediate) createIntermediate();
+
         auto barrier = CD3DX12_RESOURCE_BARRIER::Transition
         (
             m_resource.Get(),
-            D3D12_RESOURCE_STATE_GENERIC_READ,
+            m_readState,
             D3D12_RESOURCE_STATE_COPY_DEST
         );
         cmdList->ResourceBarrier(1, &barrier);
@@ -68,22 +100,17 @@ namespace d14engine::renderer
         cmdList->ResourceBarrier(1, &barrier);
     }
 
-    UploadBuffer::UploadBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize)
+    UploadQueue::Ticket DefaultBuffer::uploadData(UploadQueue* queue, const void* pSrc, UINT64 byteSize)
+    {
+        return queue->enqueue(m_resource.Get(), 0, pSrc, byteSize);
+    }
+
+    UploadBuffer::UploadBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize, GpuAllocator* allocator)
         : m_elemCount(elemCount), m_elemByteSize(elemByteSize)
     {
-        auto prop = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        auto desc = CD3DX12_RESOURCE_DESC::Buffer(elemCount * elemByteSize);
+        createBuffer(device, allocator, D3D12_HEAP_TYPE_UPLOAD, elemCount * elemByteSize,
+                     D3D12_RESOURCE_STATE_GENERIC_READ, m_resource, m_allocation);
 
-        THROW_IF_FAILED(device->CreateCommittedResource
-        (
-        /* pHeapProperties      */ &prop,
-        /* HeapFlags            */ D3D12_HEAP_FLAG_NONE,
-        /* pDesc                */ &desc,
-        /* InitialResourceState */ D3D12_RESOURCE_STATE_GENERIC_READ,
-        /* pOptimizedClearValue */ nullptr,
-        /* riidResource         */
-        /* ppvResource          */ IID_PPV_ARGS(&m_resource)
-        ));
         THROW_IF_FAILED(m_resource->Map(0, nullptr, (void**)&m_mapped));
     }
 
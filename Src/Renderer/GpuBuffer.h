@@ -2,6 +2,9 @@
 
 #include "Common/Precompile.h"
 
+#include "Renderer/GpuAllocator.h"
+#include "Renderer/UploadQueue.h"
+
 namespace d14engine::renderer
 {
     ////////////////
@@ -13,6 +16,19 @@ namespace d14engine::renderer
     protected:
         ComPtr<ID3D12Resource> m_resource = {};
 
+        // Holds the range of m_resource if it is placed by GpuAllocator.
+        GpuAllocator::Allocation m_allocation = {};
+
+        // Creates a committed buffer if allocator is null.
+        static void createBuffer(
+            ID3D12Device* device,
+            GpuAllocator* allocator,
+            D3D12_HEAP_TYPE heapType,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES initialState,
+            ComPtr<ID3D12Resource>& resource,
+            GpuAllocator::Allocation& allocation);
+
     public:
         ID3D12Resource* resource() const;
     };
@@ -26,12 +42,42 @@ namespace d14engine::renderer
     // Cons: immutable at runtime, isolated between CPU and GPU.
     struct DefaultBuffer : GpuBuffer
     {
-        DefaultBuffer(ID3D12Device* device, UINT64 byteSize);
+        // The buffer is created in readState (e.g. VERTEX_AND_CONSTANT_BUFFER
+        // or INDEX_BUFFER), which it stays in between the copies.
+        DefaultBuffer(
+            ID3D12Device* device,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES readState,
+            GpuAllocator* allocator = nullptr);
+
+        virtual ~DefaultBuffer();
 
     protected:
+        ComPtr<ID3D12Device> m_device = {};
+
+        WeakPtr<GpuAllocator> m_allocator = {};
+
+        UINT64 m_byteSize = 0;
+
+        D3D12_RESOURCE_STATES m_readState = D3D12_RESOURCE_STATE_COMMON;
+
+        // The intermediate buffer is created on the first copyDataCPU (or
+        // copyDataGPU), so the buffers only uploaded through UploadQueue
+        // never take the UPLOAD memory of the same size.
         ComPtr<ID3D12Resource> m_intermediate = {};
 
+        GpuAllocator::Allocation m_intermediateAllocation = {};
+
+        // The intermediate buffer is kept mapped instead of being mapped
+        // and unmapped for each copy.
+        BYTE* m_intermediateMapped = nullptr;
+
+        void createIntermediate();
+
     public:
+        D3D12_RESOURCE_STATES readState() const;
+
+        // Returns nullptr if the intermediate buffer has not been created.
         ID3D12Resource* intermediate() const;
 
     public:
@@ -52,7 +98,8 @@ namespace d14engine::renderer
         void copyDataCPU(void* pSrc, UINT64 byteSize);
 
         // GPU Commands Required
-        // Copy from intermediate buffer to GPU buffer.
+        // Copy from intermediate buffer to GPU buffer,
+        // which is transitioned from/back to readState.
         void copyDataGPU(ID3D12GraphicsCommandList* cmdList, UINT64 byteSize);
 
         // GPU Commands Required
@@ -62,6 +109,12 @@ namespace d14engine::renderer
             copyDataCPU(pSrc, byteSize);
             copyDataGPU(cmdList, byteSize);
         }
+
+        // Copies the data through the staging buffer of the queue instead
+        // of the intermediate buffer, and the copy is executed on the copy
+        // queue without recording any commands in the current command list.
+        // The returned ticket can be waited for (see UploadQueue::flush).
+        UploadQueue::Ticket uploadData(UploadQueue* queue, const void* pSrc, UINT64 byteSize);
     };
 
     ///////////////////
@@ -73,7 +126,7 @@ namespace d14engine::renderer
     // Cons: wouldn't work at the best performance of GPU device.
     struct UploadBuffer : GpuBuffer
     {
-        UploadBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize);
+        UploadBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize, GpuAllocator* allocator = nullptr);
 
         virtual ~UploadBuffer();
 
@@ -106,8 +159,8 @@ namespace d14engine::renderer
     // is aligned by the minimum hardware allocation size (usually 256-byte).
     struct ConstantBuffer : UploadBuffer
     {
-        ConstantBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize)
-            : UploadBuffer(device, elemCount, calcElemSize(elemByteSize)) { }
+        ConstantBuffer(ID3D12Device* device, UINT elemCount, UINT64 elemByteSize, GpuAllocator* allocator = nullptr)
+            : UploadBuffer(device, elemCount, calcElemSize(elemByteSize), allocator) { }
 
     private:
         constexpr static UINT64 calcElemSize(UINT64 rawByteSize)
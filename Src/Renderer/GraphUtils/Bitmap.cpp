@@ -2,6 +2,8 @@
 
 #include "Renderer/GraphUtils/Bitmap.h"
 
+#include "Common/AssetArchive.h"
+#include "Common/CppLangUtils/FinallySemantic.h"
 #include "Common/DirectXError.h"
 
 namespace d14engine::renderer::graph_utils
@@ -27,6 +29,17 @@ namespace d14engine::renderer::graph_utils
             ));
         }
 
+        void initializeWorkerThread()
+        {
+            struct ComScope
+            {
+                HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+                ~ComScope() { if (SUCCEEDED(hr)) CoUninitialize(); }
+            };
+            thread_local ComScope comScope = {};
+        }
+
         IWICImagingFactory2* factory()
         {
             return g_factory.Get();
@@ -59,6 +72,18 @@ namespace d14engine::renderer::graph_utils
 
         ComPtr<IWICBitmapSource> load(WstrRefer imagePath, REFWICPixelFormatGUID format)
         {
+            // The mounted asset archives take precedence over the loose files.
+            auto asset = AssetArchive::resolve(imagePath);
+            if (asset.has_value())
+            {
+                // The stream holds a copy since the source decodes lazily.
+                auto stream = SHCreateMemStream(asset->data(), (UINT)asset->size());
+                THROW_IF_NULL(stream);
+
+                auto release = cpp_lang_utils::finally([&] { stream->Release(); });
+
+                return load(stream, format);
+            }
             ComPtr<IWICBitmapDecoder> decoder = {};
             THROW_IF_FAILED(g_factory->CreateDecoderFromFilename
             (
@@ -8,6 +8,11 @@ namespace d14engine::renderer::graph_utils
     {
         void initialize();
 
+        // The factory is free-threaded, but COM must be initialized in each
+        // thread that uses it.  Call this at the beginning of the work in a
+        // worker thread, and COM is uninitialized when the thread exits.
+        void initializeWorkerThread();
+
         // Contrast to loading bitmap from file, saving bitmap to file
         // depends on more specific settings. So we expose the factory
         // instance and allow users to implement custom saving process.
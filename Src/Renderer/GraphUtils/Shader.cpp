@@ -2,6 +2,7 @@
 
 #include "Renderer/GraphUtils/Shader.h"
 
+#include "Common/AssetArchive.h"
 #include "Common/DirectXError.h"
 
 namespace d14engine::renderer::graph_utils
@@ -21,6 +22,14 @@ namespace d14engine::renderer::graph_utils
 
         ComPtr<IDxcBlob> load(WstrRefer fileName)
         {
+            // The mounted asset archives take precedence over the loose files.
+            auto asset = AssetArchive::resolve(fileName);
+            if (asset.has_value())
+            {
+                ComPtr<IDxcBlobEncoding> blob = {};
+                THROW_IF_FAILED(g_utils->CreateBlob(asset->data(), (UINT32)asset->size(), DXC_CP_ACP, &blob));
+                return blob; // copied, so the asset can be released
+            }
             ComPtr<IDxcBlobEncoding> cso = {};
             THROW_IF_FAILED(g_utils->LoadFile(fileName.c_str(), nullptr, &cso));
             return cso; // no encoding for binary data
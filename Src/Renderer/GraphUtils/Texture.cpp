@@ -3,8 +3,10 @@
 #include "Renderer/GraphUtils/Texture.h"
 
 #include "Common/DirectXError.h"
+#include "Common/PixelUtils/MipChain.h"
 
 #include "Renderer/GpuBuffer.h"
+#include "Renderer/GraphUtils/Barrier.h"
 #include "Renderer/GraphUtils/Bitmap.h"
 #include "Renderer/Renderer.h"
 
@@ -20,8 +22,97 @@ namespace d14engine::renderer::graph_utils
             BYTE* ptr = nullptr;
             THROW_IF_FAILED(data->GetDataPointer(&size, &ptr));
 
-            auto texture = std::make_unique<DefaultBuffer>(rndr->d3d12Device(), size);
-            texture->uploadData(rndr->cmdList(), ptr, size);
+            auto texture = std::make_unique<DefaultBuffer>
+            (
+                rndr->d3d12Device(), size,
+                D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE,
+                rndr->gpuAllocator().get()
+            );
+            texture->uploadData(rndr->uploadQueue().get(), ptr, size);
+
+            return texture;
+        }
+
+        MipmappedTexture loadMipmapped(Renderer* rndr, IWICBitmapSource* source, pixel_utils::Filter filter)
+        {
+            auto data = graph_utils::bitmap::map(source);
+
+            UINT width = 0, height = 0, stride = 0, size = 0;
+            THROW_IF_FAILED(data->GetSize(&width, &height));
+            THROW_IF_FAILED(data->GetStride(&stride));
+
+            BYTE* ptr = nullptr;
+            THROW_IF_FAILED(data->GetDataPointer(&size, &ptr));
+
+            pixel_utils::ImageView base = { ptr, width, height, stride };
+            auto levels = pixel_utils::generateMipChain(base, filter);
+
+            ///////////////////////
+            // Create resources. //
+            ///////////////////////
+
+            MipmappedTexture texture = {};
+
+            auto mipCount = (UINT16)(levels.size() + 1);
+
+            auto resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(Renderer::g_renderTargetFormat, width, height, 1, mipCount);
+
+            // Created in the state that it stays in between the frames, which
+            // it is also recreated with when moved by the defragmentation.
+            texture.allocation = rndr->gpuAllocator()->createResource
+            (
+                D3D12_HEAP_TYPE_DEFAULT,
+                resourceDesc,
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+            );
+            texture.resource = texture.allocation.resource;
+
+            auto intermediateSize = GetRequiredIntermediateSize(texture.resource.Get(), 0, mipCount);
+
+            auto intermediate = rndr->gpuAllocator()->createResource
+            (
+                D3D12_HEAP_TYPE_UPLOAD,
+                CD3DX12_RESOURCE_DESC::Buffer(intermediateSize),
+                D3D12_RESOURCE_STATE_GENERIC_READ
+            );
+
+            ////////////////////
+            // Upload levels. //
+            ////////////////////
+
+            std::vector<D3D12_SUBRESOURCE_DATA> subresources = {};
+            subresources.reserve(mipCount);
+
+            subresources.push_back({ ptr, (LONG_PTR)stride, (LONG_PTR)stride * height });
+            for (auto& level : levels)
+            {
+                auto pitch = (LONG_PTR)level.pitch();
+                subresources.push_back({ level.pixels.data(), pitch, pitch * level.height });
+            }
+            auto barrier = CD3DX12_RESOURCE_BARRIER::Transition
+            (
+                texture.resource.Get(),
+                D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                D3D12_RESOURCE_STATE_COPY_DEST
+            );
+            rndr->cmdList()->ResourceBarrier(1, &barrier);
+
+            UpdateSubresources
+            (
+            /* pCmdList             */ rndr->cmdList(),
+            /* pDestinationResource */ texture.resource.Get(),
+            /* pIntermediate        */ intermediate.resource.Get(),
+            /* IntermediateOffset   */ 0,
+            /* FirstSubresource     */ 0,
+            /* NumSubresources      */ mipCount,
+            /* pSrcData             */ subresources.data()
+            );
+            graph_utils::revertBarrier(1, &barrier);
+            rndr->cmdList()->ResourceBarrier(1, &barrier);
+
+            // The copy commands read the intermediate until the current frame
+            // completes, after which its range is reused (see GpuAllocator).
+            rndr->retire(ComPtr<IUnknown>(intermediate.resource));
 
             return texture;
         }
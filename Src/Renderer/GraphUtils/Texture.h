@@ -2,6 +2,10 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/PixelUtils/Resample.h"
+
+#include "Renderer/GpuAllocator.h"
+
 namespace d14engine::renderer
 {
     struct DefaultBuffer;
@@ -13,5 +17,27 @@ namespace d14engine::renderer::graph_utils
     {
         // GPU Commands Required
         SharedPtr<DefaultBuffer> load(Renderer* rndr, IWICBitmapSource* source);
+
+        struct MipmappedTexture
+        {
+            ComPtr<ID3D12Resource> resource = {};
+
+            // Holds the range of the resource placed by GpuAllocator, so it
+            // must be kept as long as the resource is in use.
+            GpuAllocator::Allocation allocation = {};
+        };
+        // GPU Commands Required
+        // The source is expected to be 32bppPRGBA (the default format of
+        // bitmap::load), and the mip chain is generated in the CPU, then
+        // all levels are uploaded at once and the resource is left in the
+        // PIXEL_SHADER_RESOURCE state.
+        //
+        // The texture is placed by Renderer::gpuAllocator, and the upload
+        // buffer holding the levels is retired after the copy commands of
+        // the current frame instead of living as long as the texture.
+        MipmappedTexture loadMipmapped(
+            Renderer* rndr,
+            IWICBitmapSource* source,
+            pixel_utils::Filter filter = pixel_utils::Filter::Box);
     }
 }
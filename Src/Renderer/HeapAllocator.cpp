@@ -0,0 +1,540 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/HeapAllocator.h"
+
+namespace d14engine::renderer
+{
+    ////////////////////
+    // TLSF Allocator //
+    ////////////////////
+
+    TlsfAllocator::TlsfAllocator(uint64_t size, uint64_t granularity)
+        :
+        m_granularity(std::max(granularity, (uint64_t)1))
+    {
+        for (auto& heads : m_freeHeads)
+        {
+            heads.fill(g_invalidBlock);
+        }
+        auto units = size / m_granularity;
+        m_size = units * m_granularity;
+
+        if (units > 0)
+        {
+            insertFreeBlock(createBlock(0, units));
+        }
+    }
+
+    TlsfAllocator::BlockID TlsfAllocator::createBlock(uint64_t offset, uint64_t size)
+    {
+        BlockID id = {};
+        if (!m_unusedBlocks.empty())
+        {
+            id = m_unusedBlocks.back();
+            m_unusedBlocks.pop_back();
+
+            m_blocks[id] = {};
+        }
+        else // allocate a new one
+        {
+            id = (BlockID)m_blocks.size();
+            m_blocks.emplace_back();
+        }
+        m_blocks[id].offset = offset;
+        m_blocks[id].size = size;
+
+        return id;
+    }
+
+    void TlsfAllocator::destroyBlock(BlockID id)
+    {
+        m_unusedBlocks.push_back(id);
+    }
+
+    std::pair<int, int> TlsfAllocator::mapping(uint64_t size)
+    {
+        if (size < g_slCount)
+        {
+            return { 0, (int)size };
+        }
+        int msb = std::bit_width(size) - 1;
+
+        int fl = msb - g_slBits + 1;
+        int sl = (int)(size >> (msb - g_slBits)) & (g_slCount - 1);
+
+        return { fl, sl };
+    }
+
+    void TlsfAllocator::insertFreeBlock(BlockID id)
+    {
+        auto& block = m_blocks[id];
+        auto [fl, sl] = mapping(block.size);
+
+        auto& head = m_freeHeads[fl][sl];
+
+        block.free = true;
+        block.prevFree = g_invalidBlock;
+        block.nextFree = head;
+
+        if (head != g_invalidBlock)
+        {
+            m_blocks[head].prevFree = id;
+        }
+        head = id;
+
+        m_flBitmap |= 1ull << fl;
+        m_slBitmaps[fl] |= 1u << sl;
+
+        ++m_freeBlockCount;
+    }
+
+    void TlsfAllocator::removeFreeBlock(BlockID id)
+    {
+        auto& block = m_blocks[id];
+        auto [fl, sl] = mapping(block.size);
+
+        if (block.prevFree != g_invalidBlock)
+        {
+            m_blocks[block.prevFree].nextFree = block.nextFree;
+        }
+        else m_freeHeads[fl][sl] = block.nextFree;
+
+        if (block.nextFree != g_invalidBlock)
+        {
+            m_blocks[block.nextFree].prevFree = block.prevFree;
+        }
+        if (m_freeHeads[fl][sl] == g_invalidBlock)
+        {
+            m_slBitmaps[fl] &= ~(1u << sl);
+            if (m_slBitmaps[fl] == 0)
+            {
+                m_flBitmap &= ~(1ull << fl);
+            }
+        }
+        block.free = false;
+        block.prevFree = block.nextFree = g_invalidBlock;
+
+        --m_freeBlockCount;
+    }
+
+    TlsfAllocator::BlockID TlsfAllocator::findFreeBlock(uint64_t size) const
+    {
+        // Rounds the size up to the next class so that any block in the
+        // found list is large enough (instead of searching the list).
+        auto rounded = size;
+        if (size >= g_slCount)
+        {
+            int msb = std::bit_width(size) - 1;
+            rounded += (1ull << (msb - g_slBits)) - 1;
+        }
+        if (rounded >= size)
+        {
+            auto [fl, sl] = mapping(rounded);
+
+            uint32_t slMap = m_slBitmaps[fl] & (~0u << sl);
+            if (slMap == 0)
+            {
+                uint64_t flMap = fl + 1 < g_flCount ? m_flBitmap & (~0ull << (fl + 1)) : 0;
+                if (flMap != 0)
+                {
+                    fl = std::countr_zero(flMap);
+                    slMap = m_slBitmaps[fl];
+                }
+            }
+            if (slMap != 0) return m_freeHeads[fl][std::countr_zero(slMap)];
+        }
+        // Falls back to the list of the exact class, which may still have a
+        // large enough block (e.g. the only block of a dedicated heap).
+        auto [fl, sl] = mapping(size);
+
+        for (auto id = m_freeHeads[fl][sl]; id != g_invalidBlock; id = m_blocks[id].nextFree)
+        {
+            if (m_blocks[id].size >= size) return id;
+        }
+        return g_invalidBlock;
+    }
+
+    void TlsfAllocator::splitBlock(BlockID id, uint64_t size)
+    {
+        auto& block = m_blocks[id];
+        if (block.size <= size) return;
+
+        auto rest = createBlock(block.offset + size, block.size - size);
+
+        // The reference may be invalidated by createBlock.
+        auto& curr = m_blocks[id];
+        auto& next = m_blocks[rest];
+
+        next.prevPhys = id;
+        next.nextPhys = curr.nextPhys;
+
+        if (curr.nextPhys != g_invalidBlock)
+        {
+            m_blocks[curr.nextPhys].prevPhys = rest;
+        }
+        curr.nextPhys = rest;
+        curr.size = size;
+
+        insertFreeBlock(rest);
+    }
+
+    Optional<TlsfAllocator::Allocation> TlsfAllocator::allocate(uint64_t size, uint64_t alignment, uint64_t userData)
+    {
+        auto units = (size + m_granularity - 1) / m_granularity;
+        if (units == 0) units = 1;
+
+        auto alignUnits = std::max((alignment + m_granularity - 1) / m_granularity, (uint64_t)1);
+
+        // The worst padding before the aligned offset is reserved.
+        auto id = findFreeBlock(units + alignUnits - 1);
+        if (id == g_invalidBlock) return std::nullopt;
+
+        removeFreeBlock(id);
+
+        auto offset = m_blocks[id].offset;
+        auto padding = (offset + alignUnits - 1) / alignUnits * alignUnits - offset;
+
+        if (padding > 0)
+        {
+            // The padding becomes a free block before the allocated one,
+            // which can not be merged as the previous one is in use.
+            splitBlock(id, padding);
+
+            auto front = id;
+            id = m_blocks[front].nextPhys;
+
+            removeFreeBlock(id);
+            insertFreeBlock(front);
+        }
+        splitBlock(id, units);
+
+        auto& block = m_blocks[id];
+        block.userData = userData;
+
+        m_usedSize += block.size;
+        ++m_allocationCount;
+
+        return Allocation{ id, block.offset * m_granularity, block.size * m_granularity };
+    }
+
+    void TlsfAllocator::free(BlockID id)
+    {
+        auto& block = m_blocks[id];
+
+        m_usedSize -= block.size;
+        --m_allocationCount;
+
+        auto prev = block.prevPhys;
+        if (prev != g_invalidBlock && m_blocks[prev].free)
+        {
+            removeFreeBlock(prev);
+
+            auto& prevBlock = m_blocks[prev];
+            prevBlock.size += m_blocks[id].size;
+            prevBlock.nextPhys = m_blocks[id].nextPhys;
+
+            if (prevBlock.nextPhys != g_invalidBlock)
+            {
+                m_blocks[prevBlock.nextPhys].prevPhys = prev;
+            }
+            destroyBlock(id);
+            id = prev;
+        }
+        auto next = m_blocks[id].nextPhys;
+        if (next != g_invalidBlock && m_blocks[next].free)
+        {
+            removeFreeBlock(next);
+
+            auto& currBlock = m_blocks[id];
+            currBlock.size += m_blocks[next].size;
+            currBlock.nextPhys = m_blocks[next].nextPhys;
+
+            if (currBlock.nextPhys != g_invalidBlock)
+            {
+                m_blocks[currBlock.nextPhys].prevPhys = id;
+            }
+            destroyBlock(next);
+        }
+        insertFreeBlock(id);
+    }
+
+    uint64_t TlsfAllocator::size() const
+    {
+        return m_size;
+    }
+
+    uint64_t TlsfAllocator::granularity() const
+    {
+        return m_granularity;
+    }
+
+    uint64_t TlsfAllocator::usedSize() const
+    {
+        return m_usedSize * m_granularity;
+    }
+
+    uint64_t TlsfAllocator::largestFreeBlock() const
+    {
+        if (m_flBitmap == 0) return 0;
+
+        int fl = std::bit_width(m_flBitmap) - 1;
+        int sl = std::bit_width(m_slBitmaps[fl]) - 1;
+
+        // The blocks in the same list differ in sizes.
+        uint64_t size = 0;
+        for (auto id = m_freeHeads[fl][sl]; id != g_invalidBlock; id = m_blocks[id].nextFree)
+        {
+            size = std::max(size, m_blocks[id].size);
+        }
+        return size * m_granularity;
+    }
+
+    size_t TlsfAllocator::allocationCount() const
+    {
+        return m_allocationCount;
+    }
+
+    size_t TlsfAllocator::freeBlockCount() const
+    {
+        return m_freeBlockCount;
+    }
+
+    void TlsfAllocator::forEachAllocation(FuncRefer<void(const Allocation&, uint64_t userData)> func) const
+    {
+        if (m_blocks.empty()) return;
+
+        // The first block is never merged into a previous one.
+        for (BlockID id = 0; id != g_invalidBlock; id = m_blocks[id].nextPhys)
+        {
+            auto& block = m_blocks[id];
+            if (!block.free)
+            {
+                func({ id, block.offset * m_granularity, block.size * m_granularity }, block.userData);
+            }
+        }
+    }
+
+    ///////////////
+    // Heap Pool //
+    ///////////////
+
+    HeapPool::HeapPool(uint64_t heapSize, uint64_t granularity)
+        :
+        m_granularity(std::max(granularity, (uint64_t)1))
+    {
+        m_heapSize = (heapSize + m_granularity - 1) / m_granularity * m_granularity;
+    }
+
+    Optional<uint32_t> HeapPool::createHeap(uint64_t size, bool dedicated)
+    {
+        if (m_reservedSize + size > m_budget) return std::nullopt;
+
+        uint32_t index = 0;
+        while (index < m_heaps.size() && m_heaps[index].has_value())
+        {
+            ++index;
+        }
+        if (f_onCreateHeap && !f_onCreateHeap(index, size))
+        {
+            return std::nullopt;
+        }
+        if (index == m_heaps.size()) m_heaps.emplace_back();
+
+        m_heaps[index].emplace(Heap{ TlsfAllocator(size, m_granularity), dedicated });
+        m_reservedSize += size;
+
+        return index;
+    }
+
+    void HeapPool::releaseHeap(uint32_t index)
+    {
+        m_reservedSize -= m_heaps[index]->allocator.size();
+        m_heaps[index].reset();
+
+        if (f_onReleaseHeap) f_onReleaseHeap(index);
+    }
+
+    void HeapPool::release(const Allocation& allocation)
+    {
+        auto& heap = m_heaps[allocation.heap];
+        heap->allocator.free(allocation.range.block);
+
+        if (heap->dedicated) releaseHeap(allocation.heap);
+    }
+
+    Optional<HeapPool::Allocation> HeapPool::allocate(uint64_t size, uint64_t alignment, uint64_t userData)
+    {
+        if (size > m_heapSize)
+        {
+            auto heapSize = (size + m_granularity - 1) / m_granularity * m_granularity;
+
+            auto index = createHeap(heapSize, true);
+            if (!index.has_value()) return std::nullopt;
+
+            auto range = m_heaps[index.value()]->allocator.allocate(size, 0, userData);
+            return Allocation{ index.value(), range.value() };
+        }
+        for (uint32_t index = 0; index < m_heaps.size(); ++index)
+        {
+            auto& heap = m_heaps[index];
+            if (!heap.has_value() || heap->dedicated) continue;
+
+            auto range = heap->allocator.allocate(size, alignment, userData);
+            if (range.has_value()) return Allocation{ index, range.value() };
+        }
+        auto index = createHeap(m_heapSize, false);
+        if (!index.has_value()) return std::nullopt;
+
+        auto range = m_heaps[index.value()]->allocator.allocate(size, alignment, userData);
+        if (!range.has_value()) return std::nullopt;
+
+        return Allocation{ index.value(), range.value() };
+    }
+
+    void HeapPool::free(const Allocation& allocation)
+    {
+        if (allocation.heap != UINT32_MAX) m_currFrees.push_back(allocation);
+    }
+
+    void HeapPool::endFrame(uint64_t fenceValue)
+    {
+        for (auto& allocation : m_currFrees)
+        {
+            m_pendingFrees.push_back({ fenceValue, allocation });
+        }
+        m_currFrees.clear();
+    }
+
+    void HeapPool::reclaim(uint64_t completedValue)
+    {
+        while (!m_pendingFrees.empty() && m_pendingFrees.front().fenceValue <= completedValue)
+        {
+            release(m_pendingFrees.front().allocation);
+            m_pendingFrees.pop_front();
+        }
+    }
+
+    void HeapPool::trim()
+    {
+        for (uint32_t index = 0; index < m_heaps.size(); ++index)
+        {
+            auto& heap = m_heaps[index];
+            if (heap.has_value() && heap->allocator.allocationCount() == 0)
+            {
+                releaseHeap(index);
+            }
+        }
+    }
+
+    uint64_t HeapPool::heapSize() const
+    {
+        return m_heapSize;
+    }
+
+    uint64_t HeapPool::budget() const
+    {
+        return m_budget;
+    }
+
+    void HeapPool::setBudget(uint64_t value)
+    {
+        m_budget = value;
+    }
+
+    size_t HeapPool::defragment(FuncRefer<bool(const Move&)> relocate, size_t maxMoves)
+    {
+        // The pending frees are not counted, so a heap that is about to be
+        // empty is not chosen as a destination unnecessarily.
+
+        std::vector<uint32_t> order = {};
+        for (uint32_t index = 0; index < m_heaps.size(); ++index)
+        {
+            auto& heap = m_heaps[index];
+            if (heap.has_value() && !heap->dedicated && heap->allocator.allocationCount() > 0)
+            {
+                order.push_back(index);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+        {
+            return m_heaps[a]->allocator.usedSize() < m_heaps[b]->allocator.usedSize();
+        });
+        size_t moveCount = 0;
+
+        std::vector<std::pair<TlsfAllocator::Allocation, uint64_t>> sources = {};
+
+        for (size_t i = 0; i + 1 < order.size() && moveCount < maxMoves; ++i)
+        {
+            auto& source = m_heaps[order[i]]->allocator;
+
+            sources.clear();
+            source.forEachAllocation([&](const TlsfAllocator::Allocation& range, uint64_t userData)
+            {
+                sources.emplace_back(range, userData);
+            });
+            for (auto& [range, userData] : sources)
+            {
+                if (moveCount >= maxMoves) break;
+
+                // Only the denser heaps are the destinations.
+                for (size_t j = i + 1; j < order.size(); ++j)
+                {
+                    auto& target = m_heaps[order[j]]->allocator;
+
+                    auto destination = target.allocate(range.size, 0, userData);
+                    if (!destination.has_value()) continue;
+
+                    Move move =
+                    {
+                        .source = { order[i], range },
+                        .destination = { order[j], destination.value() },
+                        .userData = userData
+                    };
+                    if (relocate(move))
+                    {
+                        free(move.source);
+                        ++moveCount;
+                    }
+                    // The destination has never been used by the GPU.
+                    else target.free(destination->block);
+
+                    break;
+                }
+            }
+        }
+        return moveCount;
+    }
+
+    HeapPool::Statistics HeapPool::statistics() const
+    {
+        Statistics stats = {};
+
+        stats.reservedSize = m_reservedSize;
+        stats.budget = m_budget;
+
+        for (auto& heap : m_heaps)
+        {
+            if (!heap.has_value()) continue;
+
+            ++stats.heapCount;
+            if (heap->dedicated) ++stats.dedicatedHeapCount;
+
+            stats.usedSize += heap->allocator.usedSize();
+            stats.allocationCount += heap->allocator.allocationCount();
+
+            if (!heap->dedicated)
+            {
+                stats.largestFreeBlock = std::max(stats.largestFreeBlock, heap->allocator.largestFreeBlock());
+            }
+        }
+        for (auto& allocation : m_currFrees)
+        {
+            stats.pendingFreeSize += allocation.range.size;
+        }
+        for (auto& pending : m_pendingFrees)
+        {
+            stats.pendingFreeSize += pending.allocation.range.size;
+        }
+        return stats;
+    }
+}
@@ -0,0 +1,208 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    ////////////////////
+    // TLSF Allocator //
+    ////////////////////
+
+    // Two-Level Segregated Fit: the free blocks are kept in the lists of
+    // the size classes (64 power-of-2 ranges, each split into 16 linear
+    // ones), and the bitmaps of the non-empty lists find a fitting block
+    // in constant time.  The adjacent free blocks are merged on release.
+    //
+    // Only the offsets are managed, so it works for any kind of memory,
+    // and the sizes and offsets are rounded up to the granularity.
+    struct TlsfAllocator
+    {
+        explicit TlsfAllocator(uint64_t size, uint64_t granularity = 1);
+
+        using BlockID = uint32_t;
+
+        constexpr static BlockID g_invalidBlock = UINT32_MAX;
+
+        struct Allocation
+        {
+            BlockID block = g_invalidBlock;
+
+            uint64_t offset = 0, size = 0;
+        };
+
+    protected:
+        uint64_t m_size = 0;
+        uint64_t m_granularity = 1;
+
+        constexpr static int g_slBits = 4;
+        constexpr static int g_slCount = 1 << g_slBits;
+        constexpr static int g_flCount = 64;
+
+        // The offsets and sizes here are in the units of granularity.
+        struct Block
+        {
+            uint64_t offset = 0, size = 0;
+
+            // Physical neighbors in the order of offsets.
+            BlockID prevPhys = g_invalidBlock, nextPhys = g_invalidBlock;
+
+            // Neighbors in the free list (only valid for the free ones).
+            BlockID prevFree = g_invalidBlock, nextFree = g_invalidBlock;
+
+            bool free = false;
+
+            uint64_t userData = 0;
+        };
+        std::vector<Block> m_blocks = {};
+        std::vector<BlockID> m_unusedBlocks = {};
+
+        uint64_t m_flBitmap = 0;
+        std::array<uint32_t, g_flCount> m_slBitmaps = {};
+        std::array<std::array<BlockID, g_slCount>, g_flCount> m_freeHeads = {};
+
+        uint64_t m_usedSize = 0;
+        size_t m_allocationCount = 0;
+        size_t m_freeBlockCount = 0;
+
+        BlockID createBlock(uint64_t offset, uint64_t size);
+        void destroyBlock(BlockID id);
+
+        static std::pair<int, int> mapping(uint64_t size);
+
+        void insertFreeBlock(BlockID id);
+        void removeFreeBlock(BlockID id);
+
+        BlockID findFreeBlock(uint64_t size) const;
+
+        // Splits the tail after size from the block as a free block.
+        void splitBlock(BlockID id, uint64_t size);
+
+    public:
+        // Returns std::nullopt if no free block is large enough.
+        Optional<Allocation> allocate(uint64_t size, uint64_t alignment = 0, uint64_t userData = 0);
+
+        void free(BlockID block);
+
+        uint64_t size() const;
+        uint64_t granularity() const;
+
+        uint64_t usedSize() const;
+        uint64_t largestFreeBlock() const;
+
+        size_t allocationCount() const;
+        size_t freeBlockCount() const;
+
+        // Visits the allocated blocks in the order of offsets.
+        void forEachAllocation(FuncRefer<void(const Allocation&, uint64_t userData)> func) const;
+    };
+
+    ///////////////
+    // Heap Pool //
+    ///////////////
+
+    // Sub-allocates from a growing set of heaps (each with a TlsfAllocator),
+    // where the backend creates the actual heap of each index on request.
+    //
+    // The allocations larger than the heap size get dedicated heaps, which
+    // are released as soon as they are freed.  The freed ranges are reused
+    // only after the fence value of the frame they were freed in completes,
+    // since the GPU may still be accessing them.
+    struct HeapPool
+    {
+        HeapPool(uint64_t heapSize, uint64_t granularity);
+
+        // Returns false if the heap can not be created.
+        Function<bool(uint32_t index, uint64_t size)> f_onCreateHeap = {};
+
+        Function<void(uint32_t index)> f_onReleaseHeap = {};
+
+        struct Allocation
+        {
+            uint32_t heap = UINT32_MAX;
+
+            TlsfAllocator::Allocation range = {};
+        };
+
+    protected:
+        uint64_t m_heapSize = 0;
+        uint64_t m_granularity = 1;
+
+        // No more heaps are created beyond this reserved size.
+        uint64_t m_budget = UINT64_MAX;
+
+        struct Heap
+        {
+            TlsfAllocator allocator;
+
+            bool dedicated = false;
+        };
+        // A released heap leaves an empty slot to keep the indices.
+        std::vector<Optional<Heap>> m_heaps = {};
+
+        uint64_t m_reservedSize = 0;
+
+        Optional<uint32_t> createHeap(uint64_t size, bool dedicated);
+        void releaseHeap(uint32_t index);
+
+        void release(const Allocation& allocation);
+
+        std::vector<Allocation> m_currFrees = {};
+
+        struct PendingFree
+        {
+            uint64_t fenceValue = 0;
+            Allocation allocation = {};
+        };
+        std::deque<PendingFree> m_pendingFrees = {};
+
+    public:
+        Optional<Allocation> allocate(uint64_t size, uint64_t alignment = 0, uint64_t userData = 0);
+
+        void free(const Allocation& allocation);
+
+        void endFrame(uint64_t fenceValue);
+        void reclaim(uint64_t completedValue);
+
+        // Releases the empty heaps (not including the pending frees).
+        void trim();
+
+        uint64_t heapSize() const;
+
+        uint64_t budget() const;
+        void setBudget(uint64_t value);
+
+    public:
+        struct Move
+        {
+            Allocation source = {}, destination = {};
+
+            uint64_t userData = 0;
+        };
+        // Moves the allocations from the sparsest heaps into the denser ones
+        // so that the former can be trimmed later.  For each move, relocate
+        // should copy the data to the destination and return true, after
+        // which the source is freed as usual (or return false to skip it).
+        // Returns the count of the moves done.
+        size_t defragment(FuncRefer<bool(const Move&)> relocate, size_t maxMoves = SIZE_MAX);
+
+    public:
+        struct Statistics
+        {
+            uint32_t heapCount = 0;
+            uint32_t dedicatedHeapCount = 0;
+
+            uint64_t reservedSize = 0;
+            uint64_t usedSize = 0;
+
+            // Freed but still waiting for the fence.
+            uint64_t pendingFreeSize = 0;
+
+            size_t allocationCount = 0;
+
+            uint64_t largestFreeBlock = 0;
+
+            uint64_t budget = UINT64_MAX;
+        };
+        Statistics statistics() const;
+    };
+}
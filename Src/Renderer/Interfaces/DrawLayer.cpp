@@ -24,6 +24,11 @@ namespace d14engine::renderer
         m_visible = value;
     }
 
+    ICullingCamera* DrawLayer::d3d12CullingCamera() const
+    {
+        return cullingCamera.get();
+    }
+
     void DrawLayer::onRendererUpdateLayer(Renderer* rndr)
     {
         if (f_onRendererUpdateLayerBefore)
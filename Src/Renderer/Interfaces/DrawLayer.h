@@ -2,6 +2,7 @@
 
 #include "Common/Precompile.h"
 
+#include "ICamera.h"
 #include "IDrawLayer.h"
 
 namespace d14engine::renderer
@@ -19,6 +20,10 @@ namespace d14engine::renderer
 
         void setD3d12LayerVisible(bool value) override;
 
+        SharedPtr<ICamera> cullingCamera = {};
+
+        ICullingCamera* d3d12CullingCamera() const override;
+
         void onRendererUpdateLayer(Renderer* rndr) override;
 
         Function<void(DrawLayer*, Renderer*)>
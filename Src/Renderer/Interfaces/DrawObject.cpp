@@ -24,6 +24,11 @@ namespace d14engine::renderer
         m_visible = value;
     }
 
+    Optional<cull_utils::Bounds> DrawObject::d3d12ObjectBounds() const
+    {
+        return bounds;
+    }
+
     void DrawObject::onRendererUpdateObject(Renderer* rndr)
     {
         if (f_onRendererUpdateObjectBefore)
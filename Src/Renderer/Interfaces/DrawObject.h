@@ -19,6 +19,11 @@ namespace d14engine::renderer
 
         void setD3d12ObjectVisible(bool value) override;
 
+        // Kept in the world space by the owner, e.g. after moving the object.
+        Optional<cull_utils::Bounds> bounds = {};
+
+        Optional<cull_utils::Bounds> d3d12ObjectBounds() const override;
+
         void onRendererUpdateObject(Renderer* rndr) override;
 
         Function<void(DrawObject*, Renderer*)>
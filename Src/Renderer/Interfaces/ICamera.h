@@ -2,9 +2,11 @@
 
 #include "Common/Precompile.h"
 
+#include "Renderer/Interfaces/ICullingCamera.h"
+
 namespace d14engine::renderer
 {
-    struct ICamera
+    struct ICamera : ICullingCamera
     {
         using Viewport = D3D12_VIEWPORT;
         using Scissors = D3D12_RECT;
@@ -0,0 +1,17 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    struct IDrawObject;
+
+    // The part of ICamera used by FrameTraversal, which does not depend on
+    // D3D12 so that the traversal can also be built for the POSIX systems.
+    struct ICullingCamera
+    {
+        // Writes 1 to results[i] if objects[i] is in the view (or has no
+        // bounds) and 0 otherwise, and results is resized to fit.
+        virtual void cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results) = 0;
+    };
+}
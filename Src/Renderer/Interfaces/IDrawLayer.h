@@ -6,6 +6,7 @@
 
 namespace d14engine::renderer
 {
+    struct ICullingCamera;
     struct Renderer;
 
     struct IDrawLayer : ISortable<IDrawLayer>
@@ -14,6 +15,10 @@ namespace d14engine::renderer
 
         virtual void setD3d12LayerVisible(bool value) = 0;
 
+        // The objects of the layer are culled by the camera before drawn,
+        // and all of them are drawn if it returns nullptr.
+        virtual ICullingCamera* d3d12CullingCamera() const = 0;
+
         virtual void onRendererUpdateLayer(Renderer* rndr) = 0;
 
         virtual void onRendererDrawD3d12Layer(Renderer* rndr) = 0;
@@ -2,6 +2,7 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/CullUtils/Frustum.h"
 #include "Common/Interfaces/ISortable.h"
 
 namespace d14engine::renderer
@@ -14,6 +15,10 @@ namespace d14engine::renderer
 
         virtual void setD3d12ObjectVisible(bool value) = 0;
 
+        // Returns the bounding volume in the world space, which is tested
+        // against the culling camera of the layer (never culled if empty).
+        virtual Optional<cull_utils::Bounds> d3d12ObjectBounds() const = 0;
+
         virtual void onRendererUpdateObject(Renderer* rndr) = 0;
 
         virtual void onRendererDrawD3d12Object(Renderer* rndr) = 0;
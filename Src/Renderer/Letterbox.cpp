@@ -5,11 +5,11 @@
 #include "Common/DirectXError.h"
 
 #include "Renderer/GpuBuffer.h"
-#include "Renderer/GraphUtils/Barrier.h"
 #include "Renderer/GraphUtils/ParamHelper.h"
 #include "Renderer/GraphUtils/PSO.h"
 #include "Renderer/GraphUtils/Shader.h"
 #include "Renderer/GraphUtils/StaticSampler.h"
+#include "Renderer/RenderGraph/D3D12RenderGraph.h"
 #include "Renderer/Renderer.h"
 
 namespace d14engine::renderer
@@ -57,6 +57,8 @@ namespace d14engine::renderer
                 m_vertexBuffer.reset();
                 m_vertexBufferView = {};
             }
+            // Rebuilt with the pass of the new mode in the next present.
+            m_presentGraph.reset();
         }
     }
 
@@ -195,8 +197,13 @@ namespace d14engine::renderer
         /* Bottom Left  */ { { -1.0f, -1.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } },
         /* Bottom Right */ { { +1.0f, -1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } }
         };
-        m_vertexBuffer = std::make_unique<DefaultBuffer>(rndr->d3d12Device(), sizeof(quad));
-        m_vertexBuffer->uploadData(rndr->cmdList(), quad, sizeof(quad));
+        m_vertexBuffer = std::make_unique<DefaultBuffer>
+        (
+            rndr->d3d12Device(), sizeof(quad),
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER,
+            rndr->gpuAllocator().get()
+        );
+        m_vertexBuffer->uploadData(rndr->uploadQueue().get(), quad, sizeof(quad));
 
         m_vertexBufferView.BufferLocation = m_vertexBuffer->resource()->GetGPUVirtualAddress();
         m_vertexBufferView.SizeInBytes = sizeof(quad);
@@ -207,11 +214,14 @@ namespace d14engine::renderer
     {
         rndr->resetCmdList(cmdAlloc());
 
-        if (m_enabled)
-        {
-            postSceneToBackBuffer();
-        }
-        else copySceneToBackBuffer();
+        if (!m_presentGraph) createPresentGraph();
+
+        // The scene buffer is recreated with the window, and the back buffer
+        // changes in each frame, while both are in the same states.
+        m_presentGraph->bindResource(m_sceneBufferID, rndr->sceneBuffer().value());
+        m_presentGraph->bindResource(m_backBufferID, rndr->currBackBuffer().value());
+
+        m_presentGraph->execute(rndr->cmdList());
 
         rndr->submitCmdList();
     }
@@ -221,26 +231,45 @@ namespace d14engine::renderer
 // are guaranteed to be valid when composition=False.
 #pragma warning(disable : 26815)
 
-    void Letterbox::copySceneToBackBuffer()
+    void Letterbox::createPresentGraph()
     {
-        auto currBackBuffer = rndr->currBackBuffer().value();
-        auto sceneBuffer = rndr->sceneBuffer().value();
+        using namespace render_graph;
 
-        D3D12_RESOURCE_BARRIER barriers[] =
-        {
-        CD3DX12_RESOURCE_BARRIER::Transition
+        m_presentGraph = std::make_unique<D3D12RenderGraph>(rndr->d3d12Device());
+
+        m_sceneBufferID = m_presentGraph->importResource
         (
-            currBackBuffer,
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_COPY_DEST
-        ),
-        CD3DX12_RESOURCE_BARRIER::Transition
+        /* name         */ L"Scene Buffer",
+        /* resource     */ rndr->sceneBuffer().value(),
+        /* initialState */ D3D12_RESOURCE_STATE_COMMON,
+        /* finalState   */ D3D12_RESOURCE_STATE_COMMON
+        );
+        m_backBufferID = m_presentGraph->importResource
         (
-            sceneBuffer,
-            D3D12_RESOURCE_STATE_COMMON,
-            D3D12_RESOURCE_STATE_COPY_SOURCE
-        )};
-        rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
+        /* name         */ L"Back Buffer",
+        /* resource     */ rndr->currBackBuffer().value(),
+        /* initialState */ D3D12_RESOURCE_STATE_PRESENT,
+        /* finalState   */ D3D12_RESOURCE_STATE_PRESENT
+        );
+        if (m_enabled)
+        {
+            m_presentGraph->graph.addPass(L"Post", [this] { postSceneToBackBuffer(); })
+                .read(m_sceneBufferID, ResourceState::PixelShaderResource)
+                .write(m_backBufferID, ResourceState::RenderTarget);
+        }
+        else // copy directly
+        {
+            m_presentGraph->graph.addPass(L"Copy", [this] { copySceneToBackBuffer(); })
+                .read(m_sceneBufferID, ResourceState::CopySource)
+                .write(m_backBufferID, ResourceState::CopyDest);
+        }
+        m_presentGraph->compile();
+    }
+
+    void Letterbox::copySceneToBackBuffer()
+    {
+        auto currBackBuffer = rndr->currBackBuffer().value();
+        auto sceneBuffer = rndr->sceneBuffer().value();
 
         CD3DX12_TEXTURE_COPY_LOCATION src(sceneBuffer);
         CD3DX12_BOX srcBox(0, 0, rndr->getSceneWidth(), rndr->getSceneHeight());
@@ -252,29 +281,10 @@ namespace d14engine::renderer
         //////////////////
 
         rndr->cmdList()->CopyTextureRegion(&dst, 0, 0, 0, &src, &srcBox);
-
-        graph_utils::revertBarrier(NUM_ARR_ARGS(barriers));
-        rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
     }
 
     void Letterbox::postSceneToBackBuffer()
     {
-        D3D12_RESOURCE_BARRIER barriers[] =
-        {
-        CD3DX12_RESOURCE_BARRIER::Transition
-        (
-            rndr->currBackBuffer().value(),
-            D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATE_RENDER_TARGET
-        ),
-        CD3DX12_RESOURCE_BARRIER::Transition
-        (
-            rndr->sceneBuffer().value(),
-            D3D12_RESOURCE_STATE_COMMON,
-            D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-        )};
-        rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
-
         ///////////////////
         // Output Merger //
         ///////////////////
@@ -319,8 +329,6 @@ namespace d14engine::renderer
         /* StartVertexLocation    */ 0,
         /* StartInstanceLocation  */ 0
         );
-        graph_utils::revertBarrier(NUM_ARR_ARGS(barriers));
-        rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
     }
 #pragma warning(pop)
 }
@@ -6,12 +6,15 @@
 
 #include "Renderer/FrameData/FrameResource.h"
 #include "Renderer/Interfaces/ICamera.h"
+#include "Renderer/RenderGraph/RenderGraph.h"
 
 namespace d14engine::renderer
 {
     struct DefaultBuffer;
     struct Renderer;
 
+    namespace render_graph { struct D3D12RenderGraph; }
+
     struct Letterbox : PasskeyIdiom<Renderer>
     {
         friend Renderer;
@@ -81,6 +84,15 @@ namespace d14engine::renderer
         void present();
 
     private:
+        // Issues the barriers of the scene buffer and the back buffer around
+        // the pass of the current mode (copy or post).
+        UniquePtr<render_graph::D3D12RenderGraph> m_presentGraph = {};
+
+        render_graph::ResourceID m_sceneBufferID = {};
+        render_graph::ResourceID m_backBufferID = {};
+
+        void createPresentGraph();
+
         void copySceneToBackBuffer();
         void postSceneToBackBuffer();
     };
@@ -0,0 +1,102 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/NullRenderer.h"
+
+namespace d14engine::renderer
+{
+    void NullRenderer::renderNextFrame()
+    {
+        displayList.clear();
+
+        for (auto& layer : cmdLayers)
+        {
+            m_traversal.update(layer->drawTarget, *this);
+        }
+        for (auto& layer : cmdLayers)
+        {
+            if (layer->enabled)
+            {
+                m_traversal.draw(layer->drawTarget, *this);
+
+                ++m_counters.layerSubmissions;
+            }
+        }
+        ++m_counters.frameCount;
+    }
+
+    const NullRenderer::Counters& NullRenderer::counters() const
+    {
+        return m_counters;
+    }
+
+    void NullRenderer::resetCounters()
+    {
+        m_counters = {};
+    }
+
+    void NullRenderer::updateD3d12Layer(IDrawLayer* layer)
+    {
+        ++m_counters.layerUpdates;
+
+        if (invokeUpdates) layer->onRendererUpdateLayer(context);
+    }
+
+    void NullRenderer::updateD3d12Object(IDrawObject* obj)
+    {
+        ++m_counters.objectUpdates;
+
+        if (invokeUpdates) obj->onRendererUpdateObject(context);
+    }
+
+    void NullRenderer::updateD2d1Object(IDrawObject2D* obj)
+    {
+        ++m_counters.object2DUpdates;
+
+        if (invokeUpdates) obj->onRendererUpdateObject2D(context);
+    }
+
+    void NullRenderer::beginD3d12Target()
+    {
+        ++m_counters.d3d12Targets;
+    }
+
+    void NullRenderer::drawD3d12Layer(IDrawLayer* layer)
+    {
+        ++m_counters.d3d12LayerDraws;
+
+        if (invokeDraws) layer->onRendererDrawD3d12Layer(context);
+    }
+
+    void NullRenderer::drawD3d12Object(IDrawObject* obj)
+    {
+        ++m_counters.d3d12ObjectDraws;
+
+        if (invokeDraws) obj->onRendererDrawD3d12Object(context);
+    }
+
+    void NullRenderer::cullD3d12Objects(IDrawLayer* layer, size_t count)
+    {
+        m_counters.culledObjects += count;
+    }
+
+    void NullRenderer::drawD2d1Layer(IDrawObject2D* obj)
+    {
+        ++m_counters.d2d1LayerDraws;
+
+        if (invokeDraws) obj->onRendererDrawD2d1Layer(context);
+    }
+
+    void NullRenderer::beginD2d1Target()
+    {
+        ++m_counters.d2d1Targets;
+
+        displayList.record(DisplayList::SetTarget{});
+    }
+
+    void NullRenderer::drawD2d1Object(IDrawObject2D* obj)
+    {
+        ++m_counters.d2d1ObjectDraws;
+
+        if (invokeDraws) obj->onRendererDrawD2d1Object(context);
+    }
+}
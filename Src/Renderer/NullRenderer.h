@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+#include "Common/Interfaces/ISortable.h"
+
+#include "Renderer/DisplayList.h"
+#include "Renderer/FrameTraversal.h"
+
+namespace d14engine::renderer
+{
+    struct Renderer;
+
+    // Runs the same traversal as Renderer::renderNextFrame (the updates,
+    // the layer draws and the 2D draws) without any window or device, and
+    // counts the draws as well, so that the frame time and the allocations
+    // of the object trees can be measured headless.
+    //
+    // The callbacks are invoked with context as the renderer (null by
+    // default), which only works for the objects that do not touch it.
+    // Instead of the device context, such objects record their 2D draws
+    // into displayList (e.g. those of FrameBench), which is cleared at the
+    // beginning of each frame, so the draws are measured as well.
+    struct NullRenderer : cpp_lang_utils::NonCopyable, private FrameTraversal::IBackend
+    {
+        struct CommandLayer : ISortable<CommandLayer>
+        {
+            bool enabled = true;
+
+            FrameTraversal::DrawTarget drawTarget = {};
+        };
+        using CommandLayerSet = ISortable<CommandLayer>::ShrdPrioritySet;
+
+        CommandLayerSet cmdLayers = {};
+
+        Renderer* context = nullptr;
+
+        bool invokeUpdates = true;
+        bool invokeDraws = true;
+
+        void renderNextFrame();
+
+        // The 2D draws of the current frame, where SetTarget of the frame
+        // target (the null resource as D2D1Recorder captures) is recorded
+        // before the objects of each D2D1Target, while the layers record
+        // their own targets.
+        DisplayList displayList = {};
+
+    public:
+        struct Counters
+        {
+            uint64_t frameCount = 0;
+
+            uint64_t layerUpdates = 0;
+            uint64_t objectUpdates = 0;
+            uint64_t object2DUpdates = 0;
+
+            // Each enabled layer is submitted once per frame.
+            uint64_t layerSubmissions = 0;
+
+            uint64_t d3d12Targets = 0;
+            uint64_t d3d12LayerDraws = 0;
+            uint64_t d3d12ObjectDraws = 0;
+            // Rejected by the culling cameras.
+            uint64_t culledObjects = 0;
+
+            uint64_t d2d1Targets = 0;
+            uint64_t d2d1LayerDraws = 0;
+            uint64_t d2d1ObjectDraws = 0;
+        };
+        const Counters& counters() const;
+
+        void resetCounters();
+
+    private:
+        FrameTraversal m_traversal = {};
+
+        Counters m_counters = {};
+
+        // Override FrameTraversal::IBackend
+        void updateD3d12Layer(IDrawLayer* layer) override;
+        void updateD3d12Object(IDrawObject* obj) override;
+        void updateD2d1Object(IDrawObject2D* obj) override;
+
+        void beginD3d12Target() override;
+
+        void drawD3d12Layer(IDrawLayer* layer) override;
+        void drawD3d12Object(IDrawObject* obj) override;
+
+        void cullD3d12Objects(IDrawLayer* layer, size_t count) override;
+
+        void drawD2d1Layer(IDrawObject2D* obj) override;
+
+        void beginD2d1Target() override;
+
+        void drawD2d1Object(IDrawObject2D* obj) override;
+    };
+}
@@ -0,0 +1,221 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/RenderGraph/D3D12RenderGraph.h"
+
+#include "Common/DirectXError.h"
+
+namespace d14engine::renderer::render_graph
+{
+    namespace
+    {
+        // Some devices (resource heap tier 1) can not place the buffers,
+        // the RT/DS textures and the other textures in the same heap.
+
+        enum HeapGroup : uint32_t
+        {
+            BufferHeap, TargetTextureHeap, OtherTextureHeap
+        };
+        uint32_t heapGroupOf(const D3D12_RESOURCE_DESC& desc)
+        {
+            if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            {
+                return BufferHeap;
+            }
+            auto targetFlags =
+                D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET |
+                D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+            if (desc.Flags & targetFlags)
+            {
+                return TargetTextureHeap;
+            }
+            return OtherTextureHeap;
+        }
+
+        D3D12_HEAP_FLAGS heapFlagsOf(uint32_t group)
+        {
+            switch (group)
+            {
+            case BufferHeap: return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+            case TargetTextureHeap: return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+            default: return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+            }
+        }
+    }
+
+    D3D12RenderGraph::D3D12RenderGraph(ID3D12Device* device)
+        :
+        m_device(device) { }
+
+    D3D12RenderGraph::Resource& D3D12RenderGraph::d3d12Resource(ResourceID id)
+    {
+        if (id >= m_resources.size()) m_resources.resize(id + 1);
+
+        return m_resources[id];
+    }
+
+    ResourceID D3D12RenderGraph::importResource(
+        WstrRefer name,
+        ID3D12Resource* resource,
+        D3D12_RESOURCE_STATES initialState,
+        D3D12_RESOURCE_STATES finalState)
+    {
+        auto id = graph.importResource(name, initialState, finalState);
+
+        d3d12Resource(id).external = resource;
+
+        return id;
+    }
+
+    void D3D12RenderGraph::bindResource(ResourceID id, ID3D12Resource* resource)
+    {
+        d3d12Resource(id).external = resource;
+    }
+
+    ResourceID D3D12RenderGraph::createTransient(
+        WstrRefer name,
+        const D3D12_RESOURCE_DESC& desc,
+        const D3D12_CLEAR_VALUE* clearValue)
+    {
+        auto info = m_device->GetResourceAllocationInfo(0, 1, &desc);
+
+        TransientDesc transientDesc =
+        {
+            .size = info.SizeInBytes,
+            .alignment = info.Alignment,
+            .heapGroup = heapGroupOf(desc)
+        };
+        auto id = graph.createTransient(name, transientDesc);
+
+        auto& resource = d3d12Resource(id);
+
+        resource.desc = desc;
+        if (clearValue != nullptr) resource.clearValue = *clearValue;
+
+        return id;
+    }
+
+    ID3D12Resource* D3D12RenderGraph::resource(ResourceID id) const
+    {
+        if (id >= m_resources.size()) return nullptr;
+
+        auto& resource = m_resources[id];
+        return resource.external != nullptr ? resource.external : resource.placed.Get();
+    }
+
+    void D3D12RenderGraph::compile()
+    {
+        graph.compile();
+
+        for (auto& resource : m_resources)
+        {
+            resource.placed.Reset();
+        }
+        m_heaps.clear();
+        m_heaps.resize(graph.heapSizes().size());
+
+        for (uint32_t group = 0; group < (uint32_t)m_heaps.size(); ++group)
+        {
+            auto size = graph.heapSizes()[group];
+            if (size == 0) continue;
+
+            // The MSAA textures require 4MB alignment instead of 64KB.
+            UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            for (ResourceID id = 0; id < (ResourceID)graph.resourceCount(); ++id)
+            {
+                if (graph.heapOffset(id).has_value() && graph.heapGroup(id) == group)
+                {
+                    alignment = std::max(alignment, m_device->GetResourceAllocationInfo(0, 1, &m_resources[id].desc).Alignment);
+                }
+            }
+            D3D12_HEAP_DESC desc =
+            {
+                .SizeInBytes = size,
+                .Properties = { .Type = D3D12_HEAP_TYPE_DEFAULT },
+                .Alignment = alignment,
+                .Flags = heapFlagsOf(group)
+            };
+            THROW_IF_FAILED(m_device->CreateHeap(&desc, IID_PPV_ARGS(&m_heaps[group])));
+        }
+        for (ResourceID id = 0; id < (ResourceID)graph.resourceCount(); ++id)
+        {
+            auto offset = graph.heapOffset(id);
+            if (!offset.has_value()) continue;
+
+            auto& resource = d3d12Resource(id);
+
+            THROW_IF_FAILED(m_device->CreatePlacedResource
+            (
+            /* pHeap                */ m_heaps[graph.heapGroup(id)].Get(),
+            /* HeapOffset           */ offset.value(),
+            /* pDesc                */ &resource.desc,
+            /* InitialState         */ (D3D12_RESOURCE_STATES)graph.initialState(id),
+            /* pOptimizedClearValue */ resource.clearValue.has_value() ? &resource.clearValue.value() : nullptr,
+            /* riidResource         */
+            /* ppvResource          */ IID_PPV_ARGS(&resource.placed)
+            ));
+            resource.placed->SetName(graph.resourceName(id).c_str());
+        }
+    }
+
+    UINT64 D3D12RenderGraph::heapSize() const
+    {
+        UINT64 size = 0;
+        for (auto heapSize : graph.heapSizes())
+        {
+            size += heapSize;
+        }
+        return size;
+    }
+
+    void D3D12RenderGraph::submitBarriers(const Barrier* barriers, size_t count)
+    {
+        m_barriers.clear();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto& barrier = barriers[i];
+            switch (barrier.type)
+            {
+            case Barrier::Type::Transition:
+            {
+                m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition
+                (
+                    resource(barrier.resource),
+                    (D3D12_RESOURCE_STATES)barrier.before,
+                    (D3D12_RESOURCE_STATES)barrier.after
+                ));
+                break;
+            }
+            case Barrier::Type::Aliasing:
+            {
+                m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing
+                (
+                    nullptr, resource(barrier.resource)
+                ));
+                break;
+            }
+            case Barrier::Type::UAV:
+            {
+                m_barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV
+                (
+                    resource(barrier.resource)
+                ));
+                break;
+            }
+            default: break;
+            }
+        }
+        m_cmdList->ResourceBarrier((UINT)m_barriers.size(), m_barriers.data());
+    }
+
+    void D3D12RenderGraph::execute(ID3D12GraphicsCommandList* cmdList)
+    {
+        if (!graph.isCompiled()) compile();
+
+        m_cmdList = cmdList;
+        graph.execute(*this);
+        m_cmdList = nullptr;
+    }
+}
@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Renderer/RenderGraph/RenderGraph.h"
+
+namespace d14engine::renderer::render_graph
+{
+    // Maps the render graph to Direct3D 12: the transient resources are
+    // created as the placed ones in the heaps sized by the graph, and the
+    // barriers are recorded to the command list in batches.
+    //
+    // The passes are added to the graph directly, and they can look up
+    // the actual resources with resource() while executing, e.g.
+    //
+    // auto scene = rg.createTransient(L"Scene", sceneDesc, &clearValue);
+    // rg.graph.addPass(L"Scene", [&] { clear(rg.resource(scene)); ... })
+    //     .write(scene, ResourceState::RenderTarget);
+    struct D3D12RenderGraph : cpp_lang_utils::NonCopyable, protected IBackend
+    {
+        explicit D3D12RenderGraph(ID3D12Device* device);
+
+        RenderGraph graph = {};
+
+    protected:
+        ComPtr<ID3D12Device> m_device = {};
+
+        struct Resource
+        {
+            // Imported
+            ID3D12Resource* external = nullptr;
+
+            // Transient
+            ComPtr<ID3D12Resource> placed = {};
+
+            D3D12_RESOURCE_DESC desc = {};
+            Optional<D3D12_CLEAR_VALUE> clearValue = {};
+        };
+        std::vector<Resource> m_resources = {};
+
+        Resource& d3d12Resource(ResourceID id);
+
+        // Indexed by the heap groups of the graph.
+        std::vector<ComPtr<ID3D12Heap>> m_heaps = {};
+
+    public:
+        ResourceID importResource(
+            WstrRefer name,
+            ID3D12Resource* resource,
+            D3D12_RESOURCE_STATES initialState,
+            D3D12_RESOURCE_STATES finalState);
+
+        // Rebinds an imported resource, e.g. to the back buffer of the
+        // current frame, which must be in the same initial state.
+        void bindResource(ResourceID id, ID3D12Resource* resource);
+
+        ResourceID createTransient(
+            WstrRefer name,
+            const D3D12_RESOURCE_DESC& desc,
+            const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+        // Returns nullptr for an unused transient resource.
+        ID3D12Resource* resource(ResourceID id) const;
+
+        // Recreates all the heaps and the placed resources, so it should be
+        // called only after the graph changes (e.g. the window is resized),
+        // and the GPU must have finished using the previous ones.
+        void compile();
+
+        // Returns the total size of the heaps for the transient resources.
+        UINT64 heapSize() const;
+
+    protected:
+        ID3D12GraphicsCommandList* m_cmdList = nullptr;
+
+        std::vector<D3D12_RESOURCE_BARRIER> m_barriers = {};
+
+        void submitBarriers(const Barrier* barriers, size_t count) override;
+
+    public:
+        // GPU Commands Required
+        void execute(ID3D12GraphicsCommandList* cmdList);
+    };
+}
@@ -0,0 +1,520 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/RenderGraph/RenderGraph.h"
+
+namespace d14engine::renderer::render_graph
+{
+    RenderGraph::PassBuilder::PassBuilder(RenderGraph* graph, size_t passIndex)
+        :
+        m_graph(graph), m_passIndex(passIndex) { }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceID resource, State state)
+    {
+        m_graph->access(m_passIndex, resource).state |= state;
+
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceID resource, State state)
+    {
+        auto& access = m_graph->access(m_passIndex, resource);
+
+        access.state |= state;
+        access.write = true;
+
+        return *this;
+    }
+
+    RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect()
+    {
+        m_graph->m_passes[m_passIndex].sideEffect = true;
+
+        return *this;
+    }
+
+    ResourceID RenderGraph::importResource(WstrRefer name, State initialState, State finalState)
+    {
+        m_compiled = false;
+
+        auto& resource = m_resources.emplace_back();
+
+        resource.name = name;
+        resource.imported = true;
+        resource.initialState = initialState;
+        resource.finalState = finalState;
+
+        return (ResourceID)(m_resources.size() - 1);
+    }
+
+    ResourceID RenderGraph::createTransient(WstrRefer name, const TransientDesc& desc)
+    {
+        m_compiled = false;
+
+        auto& resource = m_resources.emplace_back();
+
+        resource.name = name;
+        resource.desc = desc;
+
+        return (ResourceID)(m_resources.size() - 1);
+    }
+
+    RenderGraph::PassBuilder RenderGraph::addPass(WstrRefer name, FuncRefer<void()> execute)
+    {
+        m_compiled = false;
+
+        auto& pass = m_passes.emplace_back();
+
+        pass.name = name;
+        pass.execute = execute;
+
+        return { this, m_passes.size() - 1 };
+    }
+
+    void RenderGraph::clear()
+    {
+        m_compiled = false;
+
+        m_resources.clear();
+        m_passes.clear();
+
+        m_heapSizes.clear();
+        m_batches.clear();
+        m_barriers.clear();
+    }
+
+    RenderGraph::Access& RenderGraph::access(size_t passIndex, ResourceID resource)
+    {
+        m_compiled = false;
+
+        auto& accesses = m_passes[passIndex].accesses;
+        for (auto& access : accesses)
+        {
+            if (access.resource == resource) return access;
+        }
+        auto& access = accesses.emplace_back();
+        access.resource = resource;
+
+        return access;
+    }
+
+    void RenderGraph::cullPasses()
+    {
+        // Each pass depends on the last writers of the resources it uses,
+        // and the passes are kept from the ones that write the imported
+        // resources or have side effects by following the dependencies.
+
+        std::vector<std::vector<size_t>> dependencies(m_passes.size());
+        std::vector<size_t> lastWriters(m_resources.size(), SIZE_MAX);
+
+        std::vector<size_t> pending = {};
+
+        for (size_t p = 0; p < m_passes.size(); ++p)
+        {
+            auto& pass = m_passes[p];
+            pass.live = false;
+
+            bool output = pass.sideEffect;
+            for (auto& access : pass.accesses)
+            {
+                auto writer = lastWriters[access.resource];
+                if (writer != SIZE_MAX) dependencies[p].push_back(writer);
+
+                if (access.write && m_resources[access.resource].imported)
+                {
+                    output = true;
+                }
+            }
+            for (auto& access : pass.accesses)
+            {
+                if (access.write) lastWriters[access.resource] = p;
+            }
+            if (output) pending.push_back(p);
+        }
+        while (!pending.empty())
+        {
+            auto p = pending.back();
+            pending.pop_back();
+
+            if (m_passes[p].live) continue;
+            m_passes[p].live = true;
+
+            pending.insert(pending.end(), dependencies[p].begin(), dependencies[p].end());
+        }
+    }
+
+    void RenderGraph::placeTransients()
+    {
+        std::vector<ResourceID> transients = {};
+
+        for (ResourceID r = 0; r < (ResourceID)m_resources.size(); ++r)
+        {
+            auto& resource = m_resources[r];
+
+            resource.firstPass = SIZE_MAX;
+            resource.lastPass = 0;
+            resource.heapOffset.reset();
+            resource.aliased = false;
+        }
+        for (size_t p = 0; p < m_passes.size(); ++p)
+        {
+            if (!m_passes[p].live) continue;
+
+            for (auto& access : m_passes[p].accesses)
+            {
+                auto& resource = m_resources[access.resource];
+
+                resource.firstPass = std::min(resource.firstPass, p);
+                resource.lastPass = std::max(resource.lastPass, p);
+            }
+        }
+        uint32_t groupCount = 0;
+        for (ResourceID r = 0; r < (ResourceID)m_resources.size(); ++r)
+        {
+            auto& resource = m_resources[r];
+            if (!resource.imported && resource.firstPass != SIZE_MAX)
+            {
+                transients.push_back(r);
+                groupCount = std::max(groupCount, resource.desc.heapGroup + 1);
+            }
+        }
+        m_heapSizes.assign(groupCount, 0);
+
+        // Places the larger ones first, each at the lowest offset that does
+        // not overlap the memory of the placed ones alive at the same time.
+
+        std::stable_sort(transients.begin(), transients.end(), [this](ResourceID a, ResourceID b)
+        {
+            return m_resources[a].desc.size > m_resources[b].desc.size;
+        });
+        std::vector<ResourceID> placed = {};
+        std::vector<std::pair<uint64_t, uint64_t>> ranges = {};
+
+        for (auto r : transients)
+        {
+            auto& resource = m_resources[r];
+            auto alignment = std::max(resource.desc.alignment, (uint64_t)1);
+
+            auto alignUp = [&](uint64_t offset)
+            {
+                return (offset + alignment - 1) / alignment * alignment;
+            };
+            ranges.clear();
+            for (auto q : placed)
+            {
+                auto& other = m_resources[q];
+                if (other.desc.heapGroup == resource.desc.heapGroup &&
+                    other.firstPass <= resource.lastPass && resource.firstPass <= other.lastPass)
+                {
+                    ranges.emplace_back(other.heapOffset.value(), other.heapOffset.value() + other.desc.size);
+                }
+            }
+            std::sort(ranges.begin(), ranges.end());
+
+            uint64_t offset = 0;
+            for (auto& range : ranges)
+            {
+                if (alignUp(offset) + resource.desc.size <= range.first) break;
+
+                offset = std::max(offset, range.second);
+            }
+            resource.heapOffset = alignUp(offset);
+            placed.push_back(r);
+
+            auto& heapSize = m_heapSizes[resource.desc.heapGroup];
+            heapSize = std::max(heapSize, resource.heapOffset.value() + resource.desc.size);
+        }
+        for (size_t i = 0; i < placed.size(); ++i)
+        {
+            auto& a = m_resources[placed[i]];
+            for (size_t j = i + 1; j < placed.size(); ++j)
+            {
+                auto& b = m_resources[placed[j]];
+                if (a.desc.heapGroup == b.desc.heapGroup &&
+                    a.heapOffset.value() < b.heapOffset.value() + b.desc.size &&
+                    b.heapOffset.value() < a.heapOffset.value() + a.desc.size)
+                {
+                    a.aliased = b.aliased = true;
+                }
+            }
+        }
+    }
+
+    void RenderGraph::buildBarriers()
+    {
+        // The uses of each resource by the live passes in order, in which
+        // the state of a read is combined with the following reads until
+        // the next write, so that a single transition covers all of them.
+
+        struct Use
+        {
+            State state = ResourceState::Common;
+            bool write = false;
+        };
+        std::vector<std::vector<Use>> uses(m_resources.size());
+
+        for (auto& pass : m_passes)
+        {
+            if (!pass.live) continue;
+
+            for (auto& access : pass.accesses)
+            {
+                uses[access.resource].push_back({ access.state, access.write });
+            }
+        }
+        for (auto& resourceUses : uses)
+        {
+            for (size_t i = resourceUses.size(); i-- > 1; )
+            {
+                auto& curr = resourceUses[i - 1];
+                auto& next = resourceUses[i];
+
+                if (!curr.write && !next.write && curr.state != ResourceState::Common)
+                {
+                    if (next.state != ResourceState::Common) curr.state |= next.state;
+                }
+            }
+        }
+        struct Tracker
+        {
+            State state = ResourceState::Common;
+            size_t nextUse = 0;
+            bool unorderedWrite = false;
+        };
+        std::vector<Tracker> trackers(m_resources.size());
+
+        std::vector<Barrier> aliasings = {}, transitions = {};
+
+        // The transient resources are first simulated from the states they
+        // are first used in to find out the states they end with, and then
+        // they start in these states so that the frames connect seamlessly.
+
+        auto simulate = [&](bool record)
+        {
+            for (ResourceID r = 0; r < (ResourceID)m_resources.size(); ++r)
+            {
+                auto& resource = m_resources[r];
+                auto& tracker = trackers[r];
+
+                tracker.nextUse = 0;
+                tracker.unorderedWrite = false;
+
+                if (!resource.imported && !uses[r].empty() && !record)
+                {
+                    resource.initialState = uses[r].front().state;
+                }
+                tracker.state = resource.initialState;
+            }
+            for (size_t p = 0; p < m_passes.size(); ++p)
+            {
+                auto& pass = m_passes[p];
+                if (!pass.live) continue;
+
+                aliasings.clear();
+                transitions.clear();
+
+                for (auto& access : pass.accesses)
+                {
+                    auto& resource = m_resources[access.resource];
+                    auto& tracker = trackers[access.resource];
+
+                    if (resource.aliased && tracker.nextUse == 0)
+                    {
+                        aliasings.push_back({ Barrier::Type::Aliasing, access.resource });
+                    }
+                    auto& use = uses[access.resource][tracker.nextUse++];
+
+                    bool covered = false;
+                    if (!access.write && access.state != ResourceState::Common &&
+                        tracker.state != ResourceState::Common &&
+                        (tracker.state & ResourceState::WriteMask) == 0)
+                    {
+                        covered = (tracker.state & access.state) == access.state;
+                    }
+                    if (tracker.state != use.state && !covered)
+                    {
+                        transitions.push_back(
+                        {
+                            Barrier::Type::Transition,
+                            access.resource,
+                            tracker.state,
+                            use.state
+                        });
+                        tracker.state = use.state;
+                    }
+                    else if (tracker.unorderedWrite && (access.state & ResourceState::UnorderedAccess))
+                    {
+                        transitions.push_back({ Barrier::Type::UAV, access.resource });
+                    }
+                    tracker.unorderedWrite = access.write && (access.state & ResourceState::UnorderedAccess);
+                }
+                if (record && (!aliasings.empty() || !transitions.empty()))
+                {
+                    auto& batch = m_batches.emplace_back();
+
+                    batch.pass = p;
+                    batch.firstBarrier = m_barriers.size();
+                    batch.barrierCount = aliasings.size() + transitions.size();
+
+                    m_barriers.insert(m_barriers.end(), aliasings.begin(), aliasings.end());
+                    m_barriers.insert(m_barriers.end(), transitions.begin(), transitions.end());
+                }
+            }
+            transitions.clear();
+
+            for (ResourceID r = 0; r < (ResourceID)m_resources.size(); ++r)
+            {
+                auto& resource = m_resources[r];
+                auto& tracker = trackers[r];
+
+                if (!resource.imported)
+                {
+                    if (!record) resource.initialState = tracker.state;
+                }
+                else if (record && tracker.state != resource.finalState)
+                {
+                    transitions.push_back(
+                    {
+                        Barrier::Type::Transition,
+                        r,
+                        tracker.state,
+                        resource.finalState
+                    });
+                }
+            }
+        };
+        simulate(false);
+
+        m_batches.clear();
+        m_barriers.clear();
+
+        simulate(true);
+
+        if (!transitions.empty())
+        {
+            auto& batch = m_batches.emplace_back();
+
+            batch.firstBarrier = m_barriers.size();
+            batch.barrierCount = transitions.size();
+
+            m_barriers.insert(m_barriers.end(), transitions.begin(), transitions.end());
+        }
+    }
+
+    void RenderGraph::compile()
+    {
+        cullPasses();
+        placeTransients();
+        buildBarriers();
+
+        m_compiled = true;
+    }
+
+    void RenderGraph::execute(IBackend& backend)
+    {
+        if (!m_compiled) compile();
+
+        size_t batchIndex = 0;
+        for (size_t p = 0; p < m_passes.size(); ++p)
+        {
+            auto& pass = m_passes[p];
+            if (!pass.live) continue;
+
+            if (batchIndex < m_batches.size() && m_batches[batchIndex].pass == p)
+            {
+                auto& batch = m_batches[batchIndex++];
+                backend.submitBarriers(m_barriers.data() + batch.firstBarrier, batch.barrierCount);
+            }
+            backend.beginPass(pass.name);
+
+            if (pass.execute) pass.execute();
+
+            backend.endPass();
+        }
+        if (batchIndex < m_batches.size())
+        {
+            auto& batch = m_batches[batchIndex];
+            backend.submitBarriers(m_barriers.data() + batch.firstBarrier, batch.barrierCount);
+        }
+    }
+
+    bool RenderGraph::isCompiled() const
+    {
+        return m_compiled;
+    }
+
+    size_t RenderGraph::resourceCount() const
+    {
+        return m_resources.size();
+    }
+
+    size_t RenderGraph::passCount() const
+    {
+        return m_passes.size();
+    }
+
+    WstrRefer RenderGraph::resourceName(ResourceID resource) const
+    {
+        return m_resources[resource].name;
+    }
+
+    bool RenderGraph::isImported(ResourceID resource) const
+    {
+        return m_resources[resource].imported;
+    }
+
+    bool RenderGraph::isPassLive(size_t passIndex) const
+    {
+        return m_passes[passIndex].live;
+    }
+
+    size_t RenderGraph::livePassCount() const
+    {
+        return (size_t)std::count_if(m_passes.begin(), m_passes.end(),
+            [](const Pass& pass) { return pass.live; });
+    }
+
+    bool RenderGraph::isResourceUsed(ResourceID resource) const
+    {
+        return m_resources[resource].firstPass != SIZE_MAX;
+    }
+
+    State RenderGraph::initialState(ResourceID resource) const
+    {
+        return m_resources[resource].initialState;
+    }
+
+    Optional<uint64_t> RenderGraph::heapOffset(ResourceID resource) const
+    {
+        return m_resources[resource].heapOffset;
+    }
+
+    uint32_t RenderGraph::heapGroup(ResourceID resource) const
+    {
+        return m_resources[resource].desc.heapGroup;
+    }
+
+    const std::vector<uint64_t>& RenderGraph::heapSizes() const
+    {
+        return m_heapSizes;
+    }
+
+    uint64_t RenderGraph::transientSize() const
+    {
+        uint64_t size = 0;
+        for (auto& resource : m_resources)
+        {
+            if (resource.heapOffset.has_value()) size += resource.desc.size;
+        }
+        return size;
+    }
+
+    size_t RenderGraph::barrierCount() const
+    {
+        return m_barriers.size();
+    }
+
+    size_t RenderGraph::batchCount() const
+    {
+        return m_batches.size();
+    }
+}
@@ -0,0 +1,239 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+namespace d14engine::renderer::render_graph
+{
+    // The render graph only deals with the IDs and the states, and the
+    // backend (e.g. D3D12RenderGraph) maps them to the actual resources,
+    // so the compilation can be tested without any GPU device.
+
+    using ResourceID = uint32_t;
+
+    constexpr ResourceID g_anyResource = UINT32_MAX;
+
+    // The values equal those of D3D12_RESOURCE_STATES, and the read states
+    // can be combined with each other as Direct3D 12 allows.
+    struct ResourceState
+    {
+        enum : uint32_t
+        {
+            Common = 0,
+            VertexAndConstantBuffer = 0x1,
+            IndexBuffer = 0x2,
+            RenderTarget = 0x4,
+            UnorderedAccess = 0x8,
+            DepthWrite = 0x10,
+            DepthRead = 0x20,
+            NonPixelShaderResource = 0x40,
+            PixelShaderResource = 0x80,
+            IndirectArgument = 0x200,
+            CopyDest = 0x400,
+            CopySource = 0x800,
+            ResolveDest = 0x1000,
+            ResolveSource = 0x2000,
+            Present = Common
+        };
+        // The states that can not be combined with any other one.
+        static constexpr uint32_t WriteMask =
+            RenderTarget | UnorderedAccess | DepthWrite | CopyDest | ResolveDest;
+    };
+    using State = uint32_t;
+
+    struct Barrier
+    {
+        enum class Type
+        {
+            Transition, Aliasing, UAV
+        }
+        type = Type::Transition;
+
+        // For Aliasing, this is the resource to be activated in the memory,
+        // and the previous one is not tracked (i.e. NULL in Direct3D 12).
+        ResourceID resource = g_anyResource;
+
+        State before = ResourceState::Common;
+        State after = ResourceState::Common;
+    };
+
+    struct IBackend
+    {
+        // The barriers before each pass are submitted in one call, with the
+        // aliasing ones first.
+        virtual void submitBarriers(const Barrier* barriers, size_t count) = 0;
+
+        virtual void beginPass(WstrRefer name) { }
+        virtual void endPass() { }
+    };
+
+    // The transient resources are owned by the graph (i.e. the backend),
+    // and the ones with the disjoint lifetimes share the same memory.
+    struct TransientDesc
+    {
+        uint64_t size = 0;
+        uint64_t alignment = 65536;
+
+        // Only the resources of the same group can be aliased, e.g. the
+        // buffers and the textures need different heaps on some devices.
+        uint32_t heapGroup = 0;
+    };
+
+    // Records the passes once and executes them every frame in the order
+    // they were added, during which the graph issues all the barriers:
+    //
+    // 1. The passes that contribute nothing to the imported resources
+    //    (and are not marked with sideEffect) are culled.
+    // 2. A resource read by several passes in a row is transitioned once
+    //    to the combined read state instead of before each of them.
+    // 3. The imported resources are transitioned from their initial states
+    //    and back to their final states at the end.
+    // 4. A transient resource starts in the state it ends with, so it
+    //    needs no barrier at the end of the frame.
+    //
+    // The first pass that uses an aliased transient resource must fully
+    // initialize it (e.g. Clear or DiscardResource for a render target),
+    // since its memory has been overwritten by the others.
+    struct RenderGraph : cpp_lang_utils::NonCopyable
+    {
+        struct PassBuilder
+        {
+            PassBuilder(RenderGraph* graph, size_t passIndex);
+
+        protected:
+            RenderGraph* m_graph = nullptr;
+            size_t m_passIndex = 0;
+
+        public:
+            // A pass that writes a resource also depends on its previous
+            // contents, so the earlier writers are kept as well.
+
+            PassBuilder& read(ResourceID resource, State state);
+            PassBuilder& write(ResourceID resource, State state);
+
+            // Keeps the pass even if none of its outputs are used.
+            PassBuilder& sideEffect();
+        };
+        ResourceID importResource(WstrRefer name, State initialState, State finalState);
+
+        ResourceID createTransient(WstrRefer name, const TransientDesc& desc);
+
+        PassBuilder addPass(WstrRefer name, FuncRefer<void()> execute);
+
+        // Removes all the passes and the resources.
+        void clear();
+
+    protected:
+        struct Resource
+        {
+            Wstring name = {};
+
+            bool imported = false;
+
+            // For the transient ones, the initial state is found out when
+            // compiling and equals the state at the end of the frame.
+            State initialState = ResourceState::Common;
+            State finalState = ResourceState::Common;
+
+            TransientDesc desc = {};
+
+            // The indices of the first and last passes that use it, which
+            // are valid only if the resource is used by any live pass.
+            size_t firstPass = SIZE_MAX, lastPass = 0;
+
+            Optional<uint64_t> heapOffset = {};
+
+            bool aliased = false;
+        };
+        std::vector<Resource> m_resources = {};
+
+        struct Access
+        {
+            ResourceID resource = g_anyResource;
+
+            // Combined from all the reads and writes of the resource.
+            State state = ResourceState::Common;
+
+            bool write = false;
+        };
+        struct Pass
+        {
+            Wstring name = {};
+
+            Function<void()> execute = {};
+
+            std::vector<Access> accesses = {};
+
+            bool sideEffect = false;
+
+            bool live = false;
+        };
+        std::vector<Pass> m_passes = {};
+
+        Access& access(size_t passIndex, ResourceID resource);
+
+    protected:
+        bool m_compiled = false;
+
+        std::vector<uint64_t> m_heapSizes = {};
+
+        // The barriers are stored in batches, and each batch is submitted
+        // before the pass (or at the end if pass equals SIZE_MAX).
+        struct Batch
+        {
+            size_t pass = SIZE_MAX;
+            size_t firstBarrier = 0, barrierCount = 0;
+        };
+        std::vector<Batch> m_batches = {};
+
+        std::vector<Barrier> m_barriers = {};
+
+        void cullPasses();
+        void placeTransients();
+        void buildBarriers();
+
+    public:
+        // Called by execute if anything has been changed since the last
+        // compilation, but it can also be called in advance so that the
+        // backend can create the transient resources.
+        void compile();
+
+        void execute(IBackend& backend);
+
+    public:
+        bool isCompiled() const;
+
+        size_t resourceCount() const;
+        size_t passCount() const;
+
+        WstrRefer resourceName(ResourceID resource) const;
+        bool isImported(ResourceID resource) const;
+
+        // The followings are available after compiling.
+
+        bool isPassLive(size_t passIndex) const;
+        size_t livePassCount() const;
+
+        // Returns false for a transient resource used by no live pass,
+        // which needs not to be created.
+        bool isResourceUsed(ResourceID resource) const;
+
+        // The state that a transient resource should be created in.
+        State initialState(ResourceID resource) const;
+
+        // Returns std::nullopt for the imported or unused resources.
+        Optional<uint64_t> heapOffset(ResourceID resource) const;
+        uint32_t heapGroup(ResourceID resource) const;
+
+        // Indexed by the heap groups.
+        const std::vector<uint64_t>& heapSizes() const;
+
+        // The sum of the sizes of the used transient resources, which is
+        // how much memory they would take without aliasing.
+        uint64_t transientSize() const;
+
+        size_t barrierCount() const;
+        size_t batchCount() const;
+    };
+}
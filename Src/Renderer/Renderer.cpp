@@ -6,7 +6,8 @@
 #include "Common/DirectXError.h"
 #include "Common/MathUtils/GDI.h"
 
-#include "Renderer/GraphUtils/Barrier.h"
+#include "Renderer/DescriptorHeap.h"
+#include "Renderer/GpuAllocator.h"
 #include "Renderer/GraphUtils/Bitmap.h"
 #include "Renderer/GraphUtils/ParamHelper.h"
 #include "Renderer/GraphUtils/Shader.h"
@@ -15,7 +16,9 @@
 #include "Renderer/Interfaces/IDrawObject.h"
 #include "Renderer/Interfaces/IDrawObject2D.h"
 #include "Renderer/Letterbox.h"
+#include "Renderer/RenderGraph/D3D12RenderGraph.h"
 #include "Renderer/TickTimer.h"
+#include "Renderer/UploadQueue.h"
 
 #ifdef _DEBUG
 #include "Renderer/DebugUtils.h"
@@ -54,6 +57,10 @@ namespace d14engine::renderer
     Renderer::~Renderer()
     {
         waitGpuCommand();
+
+        m_retirementQueue.releaseAll();
+
+        if (m_fenceEvent != nullptr) CloseHandle(m_fenceEvent);
     }
 
     RECT Renderer::queryDesktopRectGDI()
@@ -267,6 +274,11 @@ namespace d14engine::renderer
 
         submitCmdList();
 
+        if (m_pendingCapture2D)
+        {
+            m_recorder2D->beginCapture(m_pendingCapture2D, m_renderTarget.Get());
+            m_pendingCapture2D.reset();
+        }
         for (auto& layer : cmdLayers)
         {
             if (layer->enabled)
@@ -274,19 +286,24 @@ namespace d14engine::renderer
                 // Draw Commands
                 layer->resetCmdList(m_cmdList.Get(), m_currFrameIndex);
 
-                if (std::holds_alternative<CommandLayer::D3D12Target>(layer->drawTarget))
-                {
-                    drawD3d12Target(std::get<CommandLayer::D3D12Target>(layer->drawTarget));
-                }
-                if (std::holds_alternative<CommandLayer::D2D1Target>(layer->drawTarget))
+                // The D3D12 draws need the scene buffer as the render target.
+                if (!m_composition && std::holds_alternative<CommandLayer::D3D12Target>(layer->drawTarget))
                 {
-                    drawD2d1Target(std::get<CommandLayer::D2D1Target>(layer->drawTarget));
+                    recordSceneCommands([&] { m_traversal.draw(layer->drawTarget, *this); });
                 }
+                else m_traversal.draw(layer->drawTarget, *this);
+
                 submitCmdList();
             }
         }
+        if (m_recorder2D->isCapturing())
+        {
+            m_recorder2D->endCapture();
+        }
         present();
 
+        ++m_frameCount;
+
         m_timer->tick();
     }
 
@@ -332,6 +349,9 @@ namespace d14engine::renderer
         rndr->createFence();
         rndr->createCommandObjects();
         rndr->createFrameResources();
+        rndr->createDescriptorHeaps();
+        rndr->createGpuAllocator();
+        rndr->createUploadQueue();
 
         rndr->createD3d11On12Objects();
         rndr->createD2d1Objects();
@@ -936,6 +956,20 @@ do { \
         /* riid         */
         /* ppFence      */ IID_PPV_ARGS(&m_fence)
         ));
+        if (m_fenceEvent == nullptr)
+        {
+            m_fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+            THROW_IF_NULL(m_fenceEvent);
+        }
+    }
+
+    void Renderer::waitFenceValue(UINT64 value)
+    {
+        if (m_fence->GetCompletedValue() < value)
+        {
+            THROW_IF_FAILED(m_fence->SetEventOnCompletion(value, m_fenceEvent));
+            WaitForSingleObject(m_fenceEvent, INFINITE);
+        }
     }
 
     ID3D12CommandQueue* Renderer::cmdQueue() const
@@ -1008,6 +1042,109 @@ do { \
         }
     }
 
+    const SharedPtr<DescriptorHeap>& Renderer::srvDescriptors() const
+    {
+        return m_srvDescriptors;
+    }
+
+    const SharedPtr<DescriptorHeap>& Renderer::rtvDescriptors() const
+    {
+        return m_rtvDescriptors;
+    }
+
+    const SharedPtr<DescriptorHeap>& Renderer::dsvDescriptors() const
+    {
+        return m_dsvDescriptors;
+    }
+
+    void Renderer::createDescriptorHeaps()
+    {
+        auto device = m_d3d12Device.Get();
+
+        m_srvDescriptors = std::make_shared<DescriptorHeap>
+        (
+        /* device        */ device,
+        /* type          */ D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+        /* capacity      */ g_srvDescriptorCount,
+        /* ringCapacity  */ g_srvTransientCount,
+        /* shaderVisible */ true
+        );
+        m_rtvDescriptors = std::make_shared<DescriptorHeap>
+        (
+            device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, g_rtvDescriptorCount
+        );
+        m_dsvDescriptors = std::make_shared<DescriptorHeap>
+        (
+            device, D3D12_DESCRIPTOR_HEAP_TYPE_DSV, g_dsvDescriptorCount
+        );
+    }
+
+    const SharedPtr<GpuAllocator>& Renderer::gpuAllocator() const
+    {
+        return m_gpuAllocator;
+    }
+
+    void Renderer::createGpuAllocator()
+    {
+        m_gpuAllocator = std::make_shared<GpuAllocator>
+        (
+            m_d3d12Device.Get(), m_dxgiFactoryInfo.setting.adapter()
+        );
+    }
+
+    const SharedPtr<UploadQueue>& Renderer::uploadQueue() const
+    {
+        return m_uploadQueue;
+    }
+
+    void Renderer::createUploadQueue()
+    {
+        m_uploadQueue = std::make_shared<UploadQueue>(m_d3d12Device.Get());
+
+        // The copies wait for the draws that may still read the buffers.
+        m_uploadQueue->setReadingQueue(m_cmdQueue.Get());
+    }
+
+    void Renderer::retire(SharedPtr<void> object)
+    {
+        m_retirementQueue.retire(std::move(object));
+    }
+
+    void Renderer::retire(ComPtr<IUnknown> object)
+    {
+        if (object)
+        {
+            m_retirementQueue.retire(SharedPtr<void>(object.Detach(), [](void* ptr)
+            {
+                ((IUnknown*)ptr)->Release();
+            }));
+        }
+    }
+
+    void Renderer::endFrameResources()
+    {
+        for (auto heap : { m_srvDescriptors.get(), m_rtvDescriptors.get(), m_dsvDescriptors.get() })
+        {
+            if (heap != nullptr) heap->endFrame(m_fenceValue);
+        }
+        if (m_gpuAllocator) m_gpuAllocator->endFrame(m_fenceValue);
+
+        m_retirementQueue.endFrame(m_fenceValue);
+    }
+
+    void Renderer::reclaimResources()
+    {
+        auto completedValue = m_fence->GetCompletedValue();
+
+        for (auto heap : { m_srvDescriptors.get(), m_rtvDescriptors.get(), m_dsvDescriptors.get() })
+        {
+            if (heap != nullptr) heap->reclaim(completedValue);
+        }
+        if (m_gpuAllocator) m_gpuAllocator->reclaim(completedValue);
+
+        m_retirementQueue.reclaim(completedValue);
+    }
+
     ID3D11Device1* Renderer::d3d11Device() const
     {
         return m_d3d11Device.Get();
@@ -1095,6 +1232,8 @@ do { \
         /* options       */ D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
         /* deviceContext */ &m_d2d1DeviceContext)
         );
+        m_recorder2D = std::make_unique<D2D1Recorder>(m_d2d1DeviceContext.Get());
+
         THROW_IF_FAILED(DWriteCreateFactory
         (
         /* factoryType */ DWRITE_FACTORY_TYPE_SHARED,
@@ -1103,6 +1242,16 @@ do { \
         );
     }
 
+    D2D1Recorder* Renderer::recorder2D() const
+    {
+        return m_recorder2D.get();
+    }
+
+    void Renderer::captureNextFrame2D(ShrdPtrRefer<DisplayList> list)
+    {
+        m_pendingCapture2D = list;
+    }
+
     bool Renderer::composition() const
     {
         return m_composition;
@@ -1523,6 +1672,7 @@ check_result:
         if (m_composition)
         {
             m_sceneBuffer.Reset();
+            m_sceneGraph.reset();
             m_wrappedBuffer.Reset();
 
             createRenderTarget();
@@ -1745,6 +1895,32 @@ check_result:
             /* DestDescriptor */ sceneSrvhandle().value()
             );
         }
+        createSceneGraph();
+    }
+
+    void Renderer::createSceneGraph()
+    {
+        // Recreated with the scene buffer, which may also come with a new device.
+        m_sceneGraph = std::make_unique<render_graph::D3D12RenderGraph>(m_d3d12Device.Get());
+
+        auto scene = m_sceneGraph->importResource
+        (
+        /* name         */ L"Scene",
+        /* resource     */ m_sceneBuffer.Get(),
+        /* initialState */ D3D12_RESOURCE_STATE_COMMON,
+        /* finalState   */ D3D12_RESOURCE_STATE_COMMON
+        );
+        m_sceneGraph->graph.addPass(L"Scene", [this] { m_sceneCommands(); })
+            .write(scene, render_graph::ResourceState::RenderTarget);
+
+        m_sceneGraph->compile();
+    }
+
+    void Renderer::recordSceneCommands(FuncRefer<void()> commands)
+    {
+        m_sceneCommands = commands;
+        m_sceneGraph->execute(m_cmdList.Get());
+        m_sceneCommands = {};
     }
 
     void Renderer::createWrappedBuffer()
@@ -1840,6 +2016,10 @@ check_result:
     void Renderer::submitCmdList()
     {
         THROW_IF_FAILED(m_cmdList->Close());
+
+        // The commands may read the buffers being uploaded.
+        if (m_uploadQueue) m_uploadQueue->flush(m_cmdQueue.Get());
+
         ID3D12CommandList* ppCmdList[] = { m_cmdList.Get() };
         m_cmdQueue->ExecuteCommandLists(NUM_ARR_ARGS(ppCmdList));
     }
@@ -1849,15 +2029,10 @@ check_result:
         ++m_fenceValue;
         THROW_IF_FAILED(m_cmdQueue->Signal(m_fence.Get(), m_fenceValue));
 
-        if (m_fence->GetCompletedValue() < m_fenceValue)
-        {
-            auto hEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-            THROW_IF_NULL(hEvent);
-            // m_fenceValue ==> wait all submitted commands
-            THROW_IF_FAILED(m_fence->SetEventOnCompletion(m_fenceValue, hEvent));
-            WaitForSingleObject(hEvent, INFINITE);
-            CloseHandle(hEvent);
-        }
+        // m_fenceValue ==> wait all submitted commands
+        waitFenceValue(m_fenceValue);
+
+        reclaimResources();
     }
 
     void Renderer::beginGpuCommand()
@@ -1879,49 +2054,17 @@ check_result:
 
     void Renderer::waitCurrFrameResource()
     {
-        if (currFrameResource()->m_fenceValue != 0 &&
-            m_fence->GetCompletedValue() < currFrameResource()->m_fenceValue)
-        {
-            auto hEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-            THROW_IF_NULL(hEvent);
-            // FrameResource::m_fenceValue ==> wait commands submitted in previous render pass
-            THROW_IF_FAILED(m_fence->SetEventOnCompletion(currFrameResource()->m_fenceValue, hEvent));
-            WaitForSingleObject(hEvent, INFINITE);
-            CloseHandle(hEvent);
-        }
+        // FrameResource::m_fenceValue ==> wait commands submitted in previous render pass
+        waitFenceValue(currFrameResource()->m_fenceValue);
+
+        reclaimResources();
     }
 
     void Renderer::update()
     {
         for (auto& layer : cmdLayers)
         {
-            if (std::holds_alternative<CommandLayer::D3D12Target>(layer->drawTarget))
-            {
-                for (auto& elem : std::get<CommandLayer::D3D12Target>(layer->drawTarget))
-                {
-                    if (elem.first->isD3d12LayerVisible())
-                    {
-                        elem.first->onRendererUpdateLayer(this);
-                    }
-                    for (auto& obj : elem.second)
-                    {
-                        if (obj->isD3d12ObjectVisible())
-                        {
-                            obj->onRendererUpdateObject(this);
-                        }
-                    }
-                }
-            }
-            else if (std::holds_alternative<CommandLayer::D2D1Target>(layer->drawTarget))
-            {
-                for (auto& elem : std::get<CommandLayer::D2D1Target>(layer->drawTarget))
-                {
-                    if (elem->isD2d1ObjectVisible())
-                    {
-                        elem->onRendererUpdateObject2D(this);
-                    }
-                }
-            }
+            m_traversal.update(layer->drawTarget, *this);
         }
     }
 
@@ -1949,27 +2092,21 @@ check_result:
         currFrameResource()->m_fenceValue = ++m_fenceValue;
         THROW_IF_FAILED(m_cmdQueue->Signal(m_fence.Get(), m_fenceValue));
 
+        endFrameResources();
+
         m_currFrameIndex = m_swapChain->GetCurrentBackBufferIndex();
     }
 
     void Renderer::clearSceneBuffer()
     {
-        auto barrier = CD3DX12_RESOURCE_BARRIER::Transition
-        (
-            m_sceneBuffer.Get(),
-            D3D12_RESOURCE_STATE_COMMON,
-            D3D12_RESOURCE_STATE_RENDER_TARGET
-        );
-        m_cmdList->ResourceBarrier(1, &barrier);
-
-        // sceneRtvHandle is guaranteed to be valid when composition=False
-        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = sceneRtvHandle().value();
-
-        m_cmdList->OMSetRenderTargets(1, &rtvHandle, TRUE, nullptr);
-        m_cmdList->ClearRenderTargetView(rtvHandle, m_sceneColor, 0, nullptr);
+        recordSceneCommands([this]
+        {
+            // sceneRtvHandle is guaranteed to be valid when composition=False
+            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = sceneRtvHandle().value();
 
-        graph_utils::revertBarrier(1, &barrier);
-        m_cmdList->ResourceBarrier(1, &barrier);
+            m_cmdList->OMSetRenderTargets(1, &rtvHandle, TRUE, nullptr);
+            m_cmdList->ClearRenderTargetView(rtvHandle, m_sceneColor, 0, nullptr);
+        });
     }
 
     void Renderer::clearLayerBuffer()
@@ -2026,6 +2163,11 @@ check_result:
         m_layerColor = color;
     }
 
+    UINT64 Renderer::frameCount() const
+    {
+        return m_frameCount;
+    }
+
     TickTimer* Renderer::timer() const
     {
         return m_timer.get();
@@ -2061,49 +2203,38 @@ check_result:
         cmdList->Reset(cmdAlloc.Get(), nullptr);
     }
 
-    void Renderer::drawD3d12Target(CommandLayer::D3D12Target& target)
+    void Renderer::updateD3d12Layer(IDrawLayer* layer)
     {
-        D3D12_RESOURCE_BARRIER barrier = {};
-        if (!m_composition)
-        {
-            barrier = CD3DX12_RESOURCE_BARRIER::Transition
-            (
-                m_sceneBuffer.Get(),
-                D3D12_RESOURCE_STATE_COMMON,
-                D3D12_RESOURCE_STATE_RENDER_TARGET
-            );
-            m_cmdList->ResourceBarrier(1, &barrier);
-        }
-        for (auto& layer : target)
-        {
-            if (layer.first->isD3d12LayerVisible())
-            {
-                layer.first->onRendererDrawD3d12Layer(this);
-            }
-            for (auto& obj : layer.second)
-            {
-                if (obj->isD3d12ObjectVisible())
-                {
-                    obj->onRendererDrawD3d12Object(this);
-                }
-            }
-        }
-        if (!m_composition)
-        {
-            graph_utils::revertBarrier(1, &barrier);
-            m_cmdList->ResourceBarrier(1, &barrier);
-        }
+        layer->onRendererUpdateLayer(this);
     }
 
-    void Renderer::drawD2d1Target(CommandLayer::D2D1Target& target)
+    void Renderer::updateD3d12Object(IDrawObject* obj)
+    {
+        obj->onRendererUpdateObject(this);
+    }
+
+    void Renderer::updateD2d1Object(IDrawObject2D* obj)
+    {
+        obj->onRendererUpdateObject2D(this);
+    }
+
+    void Renderer::drawD3d12Layer(IDrawLayer* layer)
+    {
+        layer->onRendererDrawD3d12Layer(this);
+    }
+
+    void Renderer::drawD3d12Object(IDrawObject* obj)
+    {
+        obj->onRendererDrawD3d12Object(this);
+    }
+
+    void Renderer::drawD2d1Layer(IDrawObject2D* obj)
+    {
+        obj->onRendererDrawD2d1Layer(this);
+    }
+
+    void Renderer::beginD2d1Target()
     {
-        for (auto& obj2d : target)
-        {
-            if (obj2d->isD2d1ObjectVisible())
-            {
-                obj2d->onRendererDrawD2d1Layer(this);
-            }
-        }
         if (!m_composition)
         {
             m_d3d11On12Device->AcquireWrappedResources(m_wrappedBuffer.GetAddressOf(), 1);
@@ -2111,19 +2242,16 @@ check_result:
         // It is recommended to call SetTarget before BeginDraw.
         // The program may crash if the previous target is a synchronized
         // resource and still bound to the context when calling BeginDraw.
-        m_d2d1DeviceContext->SetTarget(m_renderTarget.Get());
+        m_recorder2D->SetTarget(m_renderTarget.Get());
 
-        m_d2d1DeviceContext->BeginDraw();
-        m_d2d1DeviceContext->SetTransform(D2D1::Matrix3x2F::Identity());
+        m_recorder2D->BeginDraw();
+        m_recorder2D->SetTransform(D2D1::Matrix3x2F::Identity());
+    }
 
-        for (auto& obj2d : target)
-        {
-            if (obj2d->isD2d1ObjectVisible())
-            {
-                obj2d->onRendererDrawD2d1Object(this);
-            }
-        }
-        THROW_IF_FAILED(m_d2d1DeviceContext->EndDraw());
+    void Renderer::endD2d1Target()
+    {
+        // Issues the deferred 2D commands before ending the draw.
+        THROW_IF_FAILED(m_recorder2D->EndDraw());
 
         if (!m_composition)
         {
@@ -2133,6 +2261,11 @@ check_result:
         m_d3d11DeviceContext->Flush();
     }
 
+    void Renderer::drawD2d1Object(IDrawObject2D* obj)
+    {
+        obj->onRendererDrawD2d1Object(this);
+    }
+
     D2D1_ANTIALIAS_MODE Renderer::getAntialiasMode2D() const
     {
         return m_d2d1DeviceContext->GetAntialiasMode();
@@ -5,17 +5,25 @@
 #include "Common/CppLangUtils/EnableMasterPtr.h"
 #include "Common/Interfaces/ISortable.h"
 
+#include "Renderer/D2D1Recorder.h"
 #include "Renderer/FrameData/FrameResource.h"
+#include "Renderer/FrameTraversal.h"
+#include "Renderer/RetirementQueue.h"
 
 namespace d14engine::renderer
 {
+    struct DescriptorHeap;
+    struct GpuAllocator;
+    struct UploadQueue;
     struct IDrawLayer;
     struct IDrawObject;
     struct IDrawObject2D;
     struct Letterbox;
     struct TickTimer;
 
-    struct Renderer : cpp_lang_utils::NonCopyable
+    namespace render_graph { struct D3D12RenderGraph; }
+
+    struct Renderer : cpp_lang_utils::NonCopyable, private FrameTraversal::IBackend
     {
         struct CreateInfo
         {
@@ -394,6 +402,9 @@ namespace d14engine::renderer
 
         UINT64 m_fenceValue = 0;
 
+        // Reused by all the waits instead of creating one for each call.
+        HANDLE m_fenceEvent = nullptr;
+
     public:
         ID3D12Fence* fence() const;
 
@@ -402,6 +413,9 @@ namespace d14engine::renderer
     private:
         void createFence();
 
+        // Blocks until the fence reaches the value.
+        void waitFenceValue(UINT64 value);
+
     private:
         ComPtr<ID3D12CommandQueue> m_cmdQueue = {};
 
@@ -435,6 +449,71 @@ namespace d14engine::renderer
     private:
         void createFrameResources();
 
+    private:
+        SharedPtr<DescriptorHeap> m_srvDescriptors = {};
+        SharedPtr<DescriptorHeap> m_rtvDescriptors = {};
+        SharedPtr<DescriptorHeap> m_dsvDescriptors = {};
+
+    public:
+        // The descriptor heaps shared by the objects instead of creating
+        // their own ones, and the freed descriptors are reused after the
+        // frames referencing them have been completed.
+
+        constexpr static UINT g_srvDescriptorCount = 16384;
+        // The last part of the SRV heap is the ring region for the views
+        // used only in a single frame (see allocateTransient).
+        constexpr static UINT g_srvTransientCount = 4096;
+
+        constexpr static UINT g_rtvDescriptorCount = 1024;
+        constexpr static UINT g_dsvDescriptorCount = 256;
+
+        // Shader-visible CBV/SRV/UAV heap.
+        const SharedPtr<DescriptorHeap>& srvDescriptors() const;
+
+        const SharedPtr<DescriptorHeap>& rtvDescriptors() const;
+        const SharedPtr<DescriptorHeap>& dsvDescriptors() const;
+
+    private:
+        void createDescriptorHeaps();
+
+    private:
+        SharedPtr<GpuAllocator> m_gpuAllocator = {};
+
+    public:
+        // Places the buffers in the shared heaps (see GpuAllocator), which
+        // can be passed to the constructors of DefaultBuffer etc.
+        const SharedPtr<GpuAllocator>& gpuAllocator() const;
+
+    private:
+        void createGpuAllocator();
+
+    private:
+        SharedPtr<UploadQueue> m_uploadQueue = {};
+
+    public:
+        // Uploads the buffer data on a copy queue (see UploadQueue), and the
+        // pending copies are flushed before each submission of cmdList with
+        // the command queue waiting for them on the GPU.
+        const SharedPtr<UploadQueue>& uploadQueue() const;
+
+    private:
+        void createUploadQueue();
+
+    private:
+        RetirementQueue m_retirementQueue = {};
+
+    public:
+        // Keeps the object alive until the commands of the current frame
+        // complete instead of waiting for the GPU before releasing it.
+        void retire(SharedPtr<void> object);
+        void retire(ComPtr<IUnknown> object);
+
+    private:
+        // Stamps the descriptors, heap ranges and objects released in this
+        // frame with the fence value, and reclaims them after it completes.
+        void endFrameResources();
+        void reclaimResources();
+
 #pragma endregion
 
 #pragma region D3D11On12 & D2D1 Components
@@ -477,6 +556,20 @@ namespace d14engine::renderer
     private:
         void createD2d1Objects();
 
+    private:
+        UniquePtr<D2D1Recorder> m_recorder2D = {};
+
+        SharedPtr<DisplayList> m_pendingCapture2D = {};
+
+    public:
+        // The objects should issue the 2D draw calls through the recorder
+        // instead of d2d1DeviceContext so that they can be captured.
+        D2D1Recorder* recorder2D() const;
+
+        // Records the 2D draw calls of the next frame into the list, which
+        // is filled when renderNextFrame returns.
+        void captureNextFrame2D(ShrdPtrRefer<DisplayList> list);
+
 #pragma endregion
 
 #pragma region DComposition Components
@@ -643,6 +736,14 @@ namespace d14engine::renderer
         const D2D1_COLOR_F& layerColor() const;
         void setLayerColor(const D2D1_COLOR_F& color);
 
+    private:
+        UINT64 m_frameCount = 0;
+
+    public:
+        // The count of the frames rendered so far, which stays the same
+        // during each frame and thus can stamp the per-frame states.
+        UINT64 frameCount() const;
+
     private:
         UniquePtr<TickTimer> m_timer = {};
 
@@ -666,17 +767,17 @@ namespace d14engine::renderer
             bool enabled = true;
 
         public:
-            using DrawObjectSet = ISortable<IDrawObject>::ShrdPrioritySet;
+            using DrawObjectSet = FrameTraversal::DrawObjectSet;
 
-            using DrawObjectLayerMap = ISortable<IDrawLayer>::ShrdPriorityMap<DrawObjectSet>;
+            using DrawObjectLayerMap = FrameTraversal::DrawObjectLayerMap;
 
-            using D3D12Target = DrawObjectLayerMap;
+            using D3D12Target = FrameTraversal::D3D12Target;
 
-            using DrawObject2DSet = ISortable<IDrawObject2D>::ShrdPrioritySet;
+            using DrawObject2DSet = FrameTraversal::DrawObject2DSet;
 
-            using D2D1Target = DrawObject2DSet;
+            using D2D1Target = FrameTraversal::D2D1Target;
 
-            using DrawTarget = Variant<std::monostate, D3D12Target, D2D1Target>;
+            using DrawTarget = FrameTraversal::DrawTarget;
 
             DrawTarget drawTarget = {};
 
@@ -691,9 +792,33 @@ namespace d14engine::renderer
         CommandLayerSet cmdLayers = {};
 
     private:
-        void drawD3d12Target(CommandLayer::D3D12Target& target);
+        FrameTraversal m_traversal = {};
+
+        // Override FrameTraversal::IBackend
+        void updateD3d12Layer(IDrawLayer* layer) override;
+        void updateD3d12Object(IDrawObject* obj) override;
+        void updateD2d1Object(IDrawObject2D* obj) override;
+
+        // A graph of one pass that writes the scene buffer, which issues
+        // the transitions around the clearing and the D3D12 draws.
+        UniquePtr<render_graph::D3D12RenderGraph> m_sceneGraph = {};
+
+        // Recorded by the pass of m_sceneGraph.
+        Function<void()> m_sceneCommands = {};
+
+        void createSceneGraph();
+
+        void recordSceneCommands(FuncRefer<void()> commands);
+
+        void drawD3d12Layer(IDrawLayer* layer) override;
+        void drawD3d12Object(IDrawObject* obj) override;
+
+        void drawD2d1Layer(IDrawObject2D* obj) override;
+
+        void beginD2d1Target() override;
+        void endD2d1Target() override;
 
-        void drawD2d1Target(CommandLayer::D2D1Target& target);
+        void drawD2d1Object(IDrawObject2D* obj) override;
 
 #pragma endregion
 
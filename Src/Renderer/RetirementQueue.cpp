@@ -0,0 +1,57 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/RetirementQueue.h"
+
+namespace d14engine::renderer
+{
+    void RetirementQueue::retire(SharedPtr<void> object)
+    {
+        if (object) m_currObjects.push_back(std::move(object));
+    }
+
+    void RetirementQueue::retire(uint64_t fenceValue, SharedPtr<void> object)
+    {
+        if (object) m_pendingObjects.push_back({ fenceValue, std::move(object) });
+    }
+
+    void RetirementQueue::endFrame(uint64_t fenceValue)
+    {
+        for (auto& object : m_currObjects)
+        {
+            m_pendingObjects.push_back({ fenceValue, std::move(object) });
+        }
+        m_currObjects.clear();
+    }
+
+    size_t RetirementQueue::reclaim(uint64_t completedValue)
+    {
+        // Moved out before being released since the destructors may modify
+        // the queue by retiring other objects.
+        std::vector<SharedPtr<void>> completed = {};
+
+        while (!m_pendingObjects.empty() && m_pendingObjects.front().fenceValue <= completedValue)
+        {
+            completed.push_back(std::move(m_pendingObjects.front().object));
+            m_pendingObjects.pop_front();
+        }
+        return completed.size();
+    }
+
+    size_t RetirementQueue::releaseAll()
+    {
+        size_t count = 0;
+
+        // The released objects may retire other ones in turn.
+        while (!m_currObjects.empty() || !m_pendingObjects.empty())
+        {
+            endFrame(UINT64_MAX);
+            count += reclaim(UINT64_MAX);
+        }
+        return count;
+    }
+
+    size_t RetirementQueue::retiredCount() const
+    {
+        return m_currObjects.size() + m_pendingObjects.size();
+    }
+}
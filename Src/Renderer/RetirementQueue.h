@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    // Keeps the objects referenced by the commands in flight alive until the
+    // fence value of the last frame using them completes, so that they can
+    // be released without waiting for the GPU.
+    //
+    // The objects retired during a frame are stamped with the fence value
+    // passed to endFrame, after which reclaim releases them in order once
+    // the completed value reaches it.  Only the fence values are involved,
+    // so it can be tested with a simulated fence.
+    struct RetirementQueue
+    {
+    protected:
+        // Retired in the current frame (i.e. not stamped with a fence value).
+        std::vector<SharedPtr<void>> m_currObjects = {};
+
+        struct PendingObject
+        {
+            uint64_t fenceValue = 0;
+            SharedPtr<void> object = {};
+        };
+        std::deque<PendingObject> m_pendingObjects = {};
+
+    public:
+        void retire(SharedPtr<void> object);
+
+        // For an object whose last use is known to be covered by fenceValue,
+        // which must not be less than that of the objects retired before.
+        void retire(uint64_t fenceValue, SharedPtr<void> object);
+
+        void endFrame(uint64_t fenceValue);
+
+        // The destructors of the released objects may retire other ones,
+        // which are queued as usual.  Returns the count of the released.
+        size_t reclaim(uint64_t completedValue);
+
+        // Called after all the commands have been completed.
+        size_t releaseAll();
+
+        size_t retiredCount() const;
+    };
+}
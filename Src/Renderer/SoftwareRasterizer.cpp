@@ -0,0 +1,1289 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/SoftwareRasterizer.h"
+
+#include "Common/PixelUtils/Blur.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_SOFTWARE_RASTERIZER_SSE2 true
+#else
+#define _D14_SOFTWARE_RASTERIZER_SSE2 false
+#endif
+
+namespace d14engine::renderer
+{
+    namespace
+    {
+        using Point = DisplayList::Point;
+        using Rect = DisplayList::Rect;
+        using Matrix = DisplayList::Matrix;
+
+        constexpr float g_inv255 = 1.0f / 255.0f;
+
+        // Beyond which the coordinates are treated as infinite (e.g. the
+        // content bounds of the layers), so the transforms never produce
+        // NaN from them.
+        constexpr float g_maxCoordinate = 1.0e6f;
+
+        // Same as _mm_max_ps and _mm_min_ps (which differ from std::max and
+        // std::min on the signed zeros), so the scalar path matches.
+        float maxOf(float a, float b) { return a > b ? a : b; }
+        float minOf(float a, float b) { return a < b ? a : b; }
+
+        float saturate(float value) { return minOf(maxOf(value, 0.0f), 1.0f); }
+
+        Rect normalized(const Rect& rect)
+        {
+            return
+            {
+                std::min(rect.left, rect.right), std::min(rect.top, rect.bottom),
+                std::max(rect.left, rect.right), std::max(rect.top, rect.bottom)
+            };
+        }
+
+        Rect inflated(const Rect& rect, float value)
+        {
+            return { rect.left - value, rect.top - value, rect.right + value, rect.bottom + value };
+        }
+
+        Rect intersected(const Rect& a, const Rect& b)
+        {
+            return
+            {
+                std::max(a.left, b.left), std::max(a.top, b.top),
+                std::min(a.right, b.right), std::min(a.bottom, b.bottom)
+            };
+        }
+
+        bool isEmpty(const Rect& rect)
+        {
+            return !(rect.left < rect.right && rect.top < rect.bottom);
+        }
+
+        Rect clamped(const Rect& rect)
+        {
+            auto clamp = [](float value)
+            {
+                return std::isnan(value) ? 0.0f : std::clamp(value, -g_maxCoordinate, g_maxCoordinate);
+            };
+            return { clamp(rect.left), clamp(rect.top), clamp(rect.right), clamp(rect.bottom) };
+        }
+
+        Point transformed(const Point& p, const Matrix& m)
+        {
+            return { p.x * m.m11 + p.y * m.m21 + m.dx, p.x * m.m12 + p.y * m.m22 + m.dy };
+        }
+
+        // Applies a and then b.
+        Matrix multiplied(const Matrix& a, const Matrix& b)
+        {
+            return
+            {
+                a.m11 * b.m11 + a.m12 * b.m21, a.m11 * b.m12 + a.m12 * b.m22,
+                a.m21 * b.m11 + a.m22 * b.m21, a.m21 * b.m12 + a.m22 * b.m22,
+                a.dx * b.m11 + a.dy * b.m21 + b.dx, a.dx * b.m12 + a.dy * b.m22 + b.dy
+            };
+        }
+
+        float determinantOf(const Matrix& m)
+        {
+            return m.m11 * m.m22 - m.m12 * m.m21;
+        }
+
+        Optional<Matrix> inverseOf(const Matrix& m)
+        {
+            auto det = determinantOf(m);
+            if (det == 0.0f || !std::isfinite(det)) return std::nullopt;
+
+            Matrix result =
+            {
+                m.m22 / det, -m.m12 / det,
+                -m.m21 / det, m.m11 / det
+            };
+            result.dx = -(m.dx * result.m11 + m.dy * result.m21);
+            result.dy = -(m.dx * result.m12 + m.dy * result.m22);
+            return result;
+        }
+
+        bool isAligned(const Matrix& m)
+        {
+            return m.m12 == 0.0f && m.m21 == 0.0f;
+        }
+
+        // The fraction of the pixel column [x, x + 1) inside [left, right).
+        float spanCoverage(float x, float left, float right)
+        {
+            return saturate(minOf(x + 1.0f, right) - maxOf(x, left));
+        }
+
+        // d = d * (1 - s.a * c) + s * c, i.e. source-over of premultiplied
+        // colors with the coverage.
+        template<bool Simd>
+        void blendPixel(float* destination, const float* source, float coverage)
+        {
+            auto inverse = 1.0f - source[3] * coverage;
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto d = _mm_loadu_ps(destination);
+                auto s = _mm_loadu_ps(source);
+                d = _mm_add_ps(_mm_mul_ps(d, _mm_set1_ps(inverse)), _mm_mul_ps(s, _mm_set1_ps(coverage)));
+                _mm_storeu_ps(destination, d);
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i)
+            {
+                destination[i] = destination[i] * inverse + source[i] * coverage;
+            }
+        }
+
+        // d = d * (1 - c) + s * c, i.e. replacing with the coverage.
+        template<bool Simd>
+        void replacePixel(float* destination, const float* source, float coverage)
+        {
+            auto inverse = 1.0f - coverage;
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto d = _mm_loadu_ps(destination);
+                auto s = _mm_loadu_ps(source);
+                d = _mm_add_ps(_mm_mul_ps(d, _mm_set1_ps(inverse)), _mm_mul_ps(s, _mm_set1_ps(coverage)));
+                _mm_storeu_ps(destination, d);
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i)
+            {
+                destination[i] = destination[i] * inverse + source[i] * coverage;
+            }
+        }
+
+        // The coverage of the clip (or of an AlignedBox) of 4 pixels.
+        template<bool Simd>
+        void areaCoverage4(int32_t x, float rowCoverage, const Rect& rect, float* coverage)
+        {
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto zero = _mm_setzero_ps();
+                auto one = _mm_set1_ps(1.0f);
+
+                auto left = _mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3));
+                auto span = _mm_sub_ps(
+                    _mm_min_ps(_mm_add_ps(left, one), _mm_set1_ps(rect.right)),
+                    _mm_max_ps(left, _mm_set1_ps(rect.left)));
+
+                span = _mm_min_ps(_mm_max_ps(span, zero), one);
+                _mm_storeu_ps(coverage, _mm_mul_ps(span, _mm_set1_ps(rowCoverage)));
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i)
+            {
+                coverage[i] = spanCoverage((float)(x + i), rect.left, rect.right) * rowCoverage;
+            }
+        }
+
+        // The signed distances of 4 pixels to the outline of the shape.
+        template<bool Simd>
+        void distance4(
+            int32_t x, int32_t y, const Matrix& map,
+            float halfWidth, float halfHeight, float radius, bool rounded,
+            float* distance)
+        {
+            auto py = (float)y + 0.5f;
+            auto rowX = py * map.m21 + map.dx;
+            auto rowY = py * map.m22 + map.dy;
+
+            auto insetX = halfWidth - radius;
+            auto insetY = halfHeight - radius;
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto zero = _mm_setzero_ps();
+                auto sign = _mm_set1_ps(-0.0f);
+
+                auto px = _mm_add_ps(_mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)), _mm_set1_ps(0.5f));
+                auto qx = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(map.m11)), _mm_set1_ps(rowX));
+                auto qy = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(map.m12)), _mm_set1_ps(rowY));
+
+                auto ax = _mm_sub_ps(_mm_andnot_ps(sign, qx), _mm_set1_ps(insetX));
+                auto ay = _mm_sub_ps(_mm_andnot_ps(sign, qy), _mm_set1_ps(insetY));
+
+                __m128 d = {};
+                if (rounded)
+                {
+                    auto ox = _mm_max_ps(ax, zero);
+                    auto oy = _mm_max_ps(ay, zero);
+                    auto outside = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)));
+                    auto inside = _mm_min_ps(_mm_max_ps(ax, ay), zero);
+
+                    d = _mm_sub_ps(_mm_add_ps(outside, inside), _mm_set1_ps(radius));
+                }
+                else d = _mm_max_ps(ax, ay);
+
+                _mm_storeu_ps(distance, d);
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i)
+            {
+                auto px = (float)(x + i) + 0.5f;
+                auto qx = px * map.m11 + rowX;
+                auto qy = px * map.m12 + rowY;
+
+                auto ax = std::fabs(qx) - insetX;
+                auto ay = std::fabs(qy) - insetY;
+
+                if (rounded)
+                {
+                    auto ox = maxOf(ax, 0.0f);
+                    auto oy = maxOf(ay, 0.0f);
+                    auto outside = std::sqrt(ox * ox + oy * oy);
+                    auto inside = minOf(maxOf(ax, ay), 0.0f);
+
+                    distance[i] = (outside + inside) - radius;
+                }
+                else distance[i] = maxOf(ax, ay);
+            }
+        }
+
+        // Of the fill (or the stroke) from the signed distances, where each
+        // edge is treated as a straight one of the width of a pixel.
+        template<bool Simd>
+        void distanceCoverage4(const float* distance, float scale, float halfStroke, float* coverage)
+        {
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto zero = _mm_setzero_ps();
+                auto one = _mm_set1_ps(1.0f);
+                auto half = _mm_set1_ps(0.5f);
+                auto s = _mm_set1_ps(scale);
+
+                auto fill = [&](__m128 d)
+                {
+                    auto value = _mm_sub_ps(half, _mm_mul_ps(d, s));
+                    return _mm_min_ps(_mm_max_ps(value, zero), one);
+                };
+                auto d = _mm_loadu_ps(distance);
+                if (halfStroke >= 0.0f)
+                {
+                    auto h = _mm_set1_ps(halfStroke);
+                    _mm_storeu_ps(coverage, _mm_sub_ps(fill(_mm_sub_ps(d, h)), fill(_mm_add_ps(d, h))));
+                }
+                else _mm_storeu_ps(coverage, fill(d));
+                return;
+            }
+#endif
+            auto fill = [&](float d) { return saturate(0.5f - d * scale); };
+
+            for (int i = 0; i < 4; ++i)
+            {
+                if (halfStroke >= 0.0f)
+                {
+                    coverage[i] = fill(distance[i] - halfStroke) - fill(distance[i] + halfStroke);
+                }
+                else coverage[i] = fill(distance[i]);
+            }
+        }
+
+        template<bool Simd>
+        void multiply4(float* coverage, const float* factor)
+        {
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                _mm_storeu_ps(coverage, _mm_mul_ps(_mm_loadu_ps(coverage), _mm_loadu_ps(factor)));
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i) coverage[i] = coverage[i] * factor[i];
+        }
+
+        // The premultiplied texel (clamped to the source) in [0, 1].
+        void fetchTexel(const pixel_utils::ImageView& bitmap, int32_t x, int32_t y, float* texel)
+        {
+            auto p = bitmap.row((uint32_t)y) + (size_t)x * 4;
+            for (int i = 0; i < 4; ++i) texel[i] = (float)p[i] * g_inv255;
+        }
+
+        template<bool Simd>
+        void sampleBitmap(
+            const pixel_utils::ImageView& bitmap,
+            const int32_t* source, // left, top, right, bottom
+            bool linear, float u, float v, float* color)
+        {
+            auto clampX = [&](int32_t x) { return std::clamp(x, source[0], source[2] - 1); };
+            auto clampY = [&](int32_t y) { return std::clamp(y, source[1], source[3] - 1); };
+
+            if (!linear)
+            {
+                fetchTexel(bitmap, clampX((int32_t)std::floor(u)), clampY((int32_t)std::floor(v)), color);
+                return;
+            }
+            u -= 0.5f; v -= 0.5f;
+
+            auto fu = std::floor(u), fv = std::floor(v);
+            auto wx = u - fu, wy = v - fv;
+
+            auto x0 = clampX((int32_t)fu), x1 = clampX((int32_t)fu + 1);
+            auto y0 = clampY((int32_t)fv), y1 = clampY((int32_t)fv + 1);
+
+            alignas(16) float t[4][4] = {};
+            fetchTexel(bitmap, x0, y0, t[0]);
+            fetchTexel(bitmap, x1, y0, t[1]);
+            fetchTexel(bitmap, x0, y1, t[2]);
+            fetchTexel(bitmap, x1, y1, t[3]);
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto ix = _mm_set1_ps(1.0f - wx), jx = _mm_set1_ps(wx);
+                auto iy = _mm_set1_ps(1.0f - wy), jy = _mm_set1_ps(wy);
+
+                auto top = _mm_add_ps(_mm_mul_ps(_mm_load_ps(t[0]), ix), _mm_mul_ps(_mm_load_ps(t[1]), jx));
+                auto bottom = _mm_add_ps(_mm_mul_ps(_mm_load_ps(t[2]), ix), _mm_mul_ps(_mm_load_ps(t[3]), jx));
+
+                _mm_storeu_ps(color, _mm_add_ps(_mm_mul_ps(top, iy), _mm_mul_ps(bottom, jy)));
+                return;
+            }
+#endif
+            for (int i = 0; i < 4; ++i)
+            {
+                auto top = t[0][i] * (1.0f - wx) + t[1][i] * wx;
+                auto bottom = t[2][i] * (1.0f - wx) + t[3][i] * wx;
+
+                color[i] = top * (1.0f - wy) + bottom * wy;
+            }
+        }
+
+        template<bool Simd>
+        void loadRow(const uint8_t* source, size_t count, float* destination)
+        {
+            size_t i = 0;
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto zero = _mm_setzero_si128();
+                auto scale = _mm_set1_ps(g_inv255);
+
+                for (; i < count; ++i) // count of the pixels
+                {
+                    int32_t value = 0;
+                    std::memcpy(&value, source + i * 4, 4);
+
+                    auto p = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+                    _mm_storeu_ps(destination + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(p), scale));
+                }
+                return;
+            }
+#endif
+            for (; i < count * 4; ++i) destination[i] = (float)source[i] * g_inv255;
+        }
+
+        template<bool Simd>
+        void storeRow(const float* source, size_t count, uint8_t* destination)
+        {
+            size_t i = 0;
+#if _D14_SOFTWARE_RASTERIZER_SSE2
+            if constexpr (Simd)
+            {
+                auto zero = _mm_setzero_ps();
+                auto scale = _mm_set1_ps(255.0f), max = _mm_set1_ps(255.0f);
+
+                for (; i < count; ++i)
+                {
+                    auto v = _mm_mul_ps(_mm_loadu_ps(source + i * 4), scale);
+                    auto p = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(v, zero), max));
+
+                    p = _mm_packus_epi16(_mm_packs_epi32(p, p), p);
+                    auto value = _mm_cvtsi128_si32(p);
+                    std::memcpy(destination + i * 4, &value, 4);
+                }
+                return;
+            }
+#endif
+            for (; i < count * 4; ++i)
+            {
+                destination[i] = (uint8_t)std::nearbyint(minOf(maxOf(source[i] * 255.0f, 0.0f), 255.0f));
+            }
+        }
+    }
+
+    SoftwareRasterizer::SoftwareRasterizer(uint32_t width, uint32_t height)
+        :
+        m_target(width, height) { }
+
+    const pixel_utils::Image& SoftwareRasterizer::target() const
+    {
+        return m_target;
+    }
+
+    const SoftwareRasterizer::Matrix& SoftwareRasterizer::transform() const
+    {
+        return m_transform;
+    }
+
+    void SoftwareRasterizer::setTransform(const Matrix& transform)
+    {
+        m_transform = transform;
+    }
+
+    SoftwareRasterizer::Rect SoftwareRasterizer::deviceBoundsOf(const Rect& rect) const
+    {
+        auto source = clamped(rect);
+
+        std::array<Point, 4> corners =
+        {{
+            { source.left, source.top }, { source.right, source.top },
+            { source.left, source.bottom }, { source.right, source.bottom }
+        }};
+        constexpr auto max = std::numeric_limits<float>::max();
+
+        Rect result = { max, max, -max, -max };
+        for (auto& corner : corners)
+        {
+            auto p = transformed(corner, m_transform);
+
+            result.left = std::min(result.left, p.x);
+            result.top = std::min(result.top, p.y);
+            result.right = std::max(result.right, p.x);
+            result.bottom = std::max(result.bottom, p.y);
+        }
+        return result;
+    }
+
+    Optional<SoftwareRasterizer::Op> SoftwareRasterizer::shapeOf(const Rect& rect, float radiusX, float radiusY) const
+    {
+        auto source = normalized(clamped(rect));
+
+        auto halfWidth = (source.right - source.left) * 0.5f;
+        auto halfHeight = (source.bottom - source.top) * 0.5f;
+
+        radiusX = std::min(std::fabs(radiusX), halfWidth);
+        radiusY = std::min(std::fabs(radiusY), halfHeight);
+
+        bool rounded = radiusX > 0.0f && radiusY > 0.0f;
+
+        Op op = {};
+        op.bounds = inflated(deviceBoundsOf(source), g_margin);
+
+        if (!rounded && isAligned(m_transform))
+        {
+            op.type = Op::Type::AlignedBox;
+            op.outer = deviceBoundsOf(source);
+            return op;
+        }
+        auto inverse = inverseOf(m_transform);
+        if (!inverse.has_value()) return std::nullopt;
+
+        Matrix center = {};
+        center.dx = -(source.left + halfWidth);
+        center.dy = -(source.top + halfHeight);
+
+        op.map = multiplied(inverse.value(), center);
+        op.halfWidth = halfWidth;
+        op.halfHeight = halfHeight;
+        op.scale = std::sqrt(std::fabs(determinantOf(m_transform)));
+
+        if (rounded)
+        {
+            op.type = Op::Type::RoundedBox;
+
+            auto ratio = radiusX / radiusY;
+            op.map.m12 *= ratio;
+            op.map.m22 *= ratio;
+            op.map.dy *= ratio;
+            op.halfHeight *= ratio;
+            op.radius = radiusX;
+        }
+        else op.type = Op::Type::Box;
+
+        return op;
+    }
+
+    void SoftwareRasterizer::clear(const Color& color)
+    {
+        Op op = { .type = Op::Type::Clear };
+
+        op.color = { color.r * color.a, color.g * color.a, color.b * color.a, color.a };
+        op.bounds = { 0.0f, 0.0f, (float)m_target.width, (float)m_target.height };
+
+        m_ops.push_back(op);
+    }
+
+    void SoftwareRasterizer::pushClip(const Rect& rect, bool antialiased)
+    {
+        Op op = { .type = Op::Type::PushClip };
+
+        op.outer = deviceBoundsOf(normalized(rect));
+        if (!antialiased)
+        {
+            op.outer =
+            {
+                std::round(op.outer.left), std::round(op.outer.top),
+                std::round(op.outer.right), std::round(op.outer.bottom)
+            };
+        }
+        m_ops.push_back(op);
+    }
+
+    void SoftwareRasterizer::popClip()
+    {
+        m_ops.push_back({ .type = Op::Type::PopClip });
+    }
+
+    void SoftwareRasterizer::pushLayer(const Rect& bounds, float opacity)
+    {
+        Op op = { .type = Op::Type::PushLayer };
+
+        op.outer = deviceBoundsOf(normalized(bounds));
+        op.opacity = std::clamp(opacity, 0.0f, 1.0f);
+
+        m_ops.push_back(op);
+    }
+
+    void SoftwareRasterizer::popLayer()
+    {
+        m_ops.push_back({ .type = Op::Type::PopLayer });
+    }
+
+    namespace
+    {
+        std::array<float, 4> premultiplied(const DisplayList::Color& color)
+        {
+            auto a = std::clamp(color.a, 0.0f, 1.0f);
+            return { color.r * a, color.g * a, color.b * a, a };
+        }
+    }
+
+    void SoftwareRasterizer::fillRect(const Rect& rect, const Color& color)
+    {
+        auto op = shapeOf(rect, 0.0f, 0.0f);
+        if (!op.has_value()) return;
+
+        op->color = premultiplied(color);
+        m_ops.push_back(op.value());
+    }
+
+    void SoftwareRasterizer::drawRect(const Rect& rect, const Color& color, float strokeWidth)
+    {
+        auto halfStroke = std::fabs(strokeWidth) * 0.5f;
+        auto source = normalized(rect);
+
+        auto op = shapeOf(source, 0.0f, 0.0f);
+        if (!op.has_value()) return;
+
+        op->color = premultiplied(color);
+
+        if (op->type == Op::Type::AlignedBox)
+        {
+            op->outer = deviceBoundsOf(inflated(source, halfStroke));
+
+            auto inner = inflated(source, -halfStroke);
+            op->inner = isEmpty(inner) ? Rect{} : deviceBoundsOf(inner);
+        }
+        else op->halfStroke = halfStroke;
+
+        op->bounds = inflated(deviceBoundsOf(inflated(source, halfStroke)), g_margin);
+        m_ops.push_back(op.value());
+    }
+
+    void SoftwareRasterizer::fillRoundedRect(const Rect& rect, float radiusX, float radiusY, const Color& color)
+    {
+        auto op = shapeOf(rect, radiusX, radiusY);
+        if (!op.has_value()) return;
+
+        op->color = premultiplied(color);
+        m_ops.push_back(op.value());
+    }
+
+    void SoftwareRasterizer::drawRoundedRect(
+        const Rect& rect, float radiusX, float radiusY,
+        const Color& color, float strokeWidth)
+    {
+        auto op = shapeOf(rect, radiusX, radiusY);
+        if (!op.has_value()) return;
+
+        if (op->type == Op::Type::AlignedBox)
+        {
+            drawRect(rect, color, strokeWidth); return;
+        }
+        auto halfStroke = std::fabs(strokeWidth) * 0.5f;
+
+        op->color = premultiplied(color);
+        op->halfStroke = halfStroke;
+        op->bounds = inflated(deviceBoundsOf(inflated(normalized(rect), halfStroke)), g_margin);
+
+        m_ops.push_back(op.value());
+    }
+
+    void SoftwareRasterizer::drawLine(Point point0, Point point1, const Color& color, float strokeWidth)
+    {
+        auto p0 = transformed(point0, m_transform);
+        auto p1 = transformed(point1, m_transform);
+
+        auto dx = p1.x - p0.x, dy = p1.y - p0.y;
+        auto length = std::sqrt(dx * dx + dy * dy);
+        if (length == 0.0f || !std::isfinite(length)) return;
+
+        auto halfStroke = std::fabs(strokeWidth) * 0.5f *
+            std::sqrt(std::fabs(determinantOf(m_transform)));
+
+        Op op = {};
+        op.color = premultiplied(color);
+
+        // The lines along the axes (e.g. the separators) are exact.
+        if (dx == 0.0f || dy == 0.0f)
+        {
+            op.type = Op::Type::AlignedBox;
+            op.outer = inflated(normalized({ p0.x, p0.y, p1.x, p1.y }), halfStroke);
+            if (dx == 0.0f)
+            {
+                op.outer.top += halfStroke; op.outer.bottom -= halfStroke;
+            }
+            else // dy == 0
+            {
+                op.outer.left += halfStroke; op.outer.right -= halfStroke;
+            }
+            op.bounds = inflated(op.outer, g_margin);
+
+            m_ops.push_back(op);
+            return;
+        }
+        Point axis = { dx / length, dy / length };
+        Point normal = { -axis.y, axis.x };
+        Point center = { (p0.x + p1.x) * 0.5f, (p0.y + p1.y) * 0.5f };
+
+        op.type = Op::Type::Box;
+        op.map =
+        {
+            axis.x, normal.x,
+            axis.y, normal.y,
+            -(center.x * axis.x + center.y * axis.y),
+            -(center.x * normal.x + center.y * normal.y)
+        };
+        op.halfWidth = length * 0.5f;
+        op.halfHeight = halfStroke;
+
+        auto extent = halfStroke + g_margin;
+        op.bounds = inflated(normalized({ p0.x, p0.y, p1.x, p1.y }), extent);
+
+        m_ops.push_back(op);
+    }
+
+    void SoftwareRasterizer::drawBitmap(
+        const pixel_utils::ImageView& bitmap,
+        const Rect& destination,
+        float opacity,
+        bool linear,
+        const Rect* source)
+    {
+        if (bitmap.data == nullptr || bitmap.width == 0 || bitmap.height == 0) return;
+
+        Rect texels = { 0.0f, 0.0f, (float)bitmap.width, (float)bitmap.height };
+        if (source != nullptr) texels = intersected(normalized(*source), texels);
+
+        if (isEmpty(texels)) return;
+
+        auto dest = normalized(clamped(destination));
+        if (isEmpty(dest)) return;
+
+        auto op = shapeOf(dest, 0.0f, 0.0f);
+        auto inverse = inverseOf(m_transform);
+        if (!op.has_value() || !inverse.has_value()) return;
+
+        op->aligned = op->type == Op::Type::AlignedBox;
+        op->type = Op::Type::Bitmap;
+        op->bitmap = bitmap;
+        op->linear = linear;
+        op->opacity = std::clamp(opacity, 0.0f, 1.0f);
+
+        op->source =
+        {
+            std::floor(texels.left), std::floor(texels.top),
+            std::ceil(texels.right), std::ceil(texels.bottom)
+        };
+        // From the destination to the texels of the source.
+        Matrix scale =
+        {
+            (texels.right - texels.left) / (dest.right - dest.left), 0.0f,
+            0.0f, (texels.bottom - texels.top) / (dest.bottom - dest.top)
+        };
+        scale.dx = texels.left - dest.left * scale.m11;
+        scale.dy = texels.top - dest.top * scale.m22;
+
+        op->texels = multiplied(inverse.value(), scale);
+
+        m_ops.push_back(op.value());
+    }
+
+    void SoftwareRasterizer::drawMask(const pixel_utils::Mask& mask, Point origin, const Color& color)
+    {
+        if (mask.width == 0 || mask.height == 0) return;
+
+        auto p = transformed(origin, m_transform);
+        if (!std::isfinite(p.x) || !std::isfinite(p.y)) return;
+
+        Op op = { .type = Op::Type::Mask };
+
+        op.color = premultiplied(color);
+        op.originX = (int32_t)std::round(std::clamp(p.x, -g_maxCoordinate, g_maxCoordinate));
+        op.originY = (int32_t)std::round(std::clamp(p.y, -g_maxCoordinate, g_maxCoordinate));
+        op.bounds =
+        {
+            (float)op.originX, (float)op.originY,
+            (float)op.originX + mask.width, (float)op.originY + mask.height
+        };
+        op.mask = m_masks.size();
+        m_masks.push_back(mask);
+
+        m_ops.push_back(op);
+    }
+
+    void SoftwareRasterizer::drawShadow(const pixel_utils::Mask& mask, Point origin, float stdDev, const Color& color)
+    {
+        auto radius = (float)pixel_utils::gaussianRadius(stdDev);
+
+        auto blurred = settings.useSimd ?
+            pixel_utils::gaussianBlur(mask, stdDev) :
+            pixel_utils::gaussianBlurScalar(mask, stdDev);
+
+        // The mask is padded by the radius, which is in the pixels.
+        auto p = transformed(origin, m_transform);
+        p.x -= radius; p.y -= radius;
+
+        auto transform = m_transform;
+        m_transform = Matrix{};
+
+        drawMask(blurred, p, color);
+
+        m_transform = transform;
+    }
+
+    void SoftwareRasterizer::drawShadow(
+        const Rect& rect, float radiusX, float radiusY,
+        float stdDev, const Color& color)
+    {
+        auto op = shapeOf(rect, radiusX, radiusY);
+        if (!op.has_value()) return;
+
+        auto bounds = intersected(op->bounds, inflated(
+            { 0.0f, 0.0f, (float)m_target.width, (float)m_target.height },
+            (float)pixel_utils::gaussianRadius(stdDev)));
+
+        if (isEmpty(bounds)) return;
+
+        auto left = (int32_t)std::floor(bounds.left);
+        auto top = (int32_t)std::floor(bounds.top);
+        auto right = (int32_t)std::ceil(bounds.right);
+        auto bottom = (int32_t)std::ceil(bounds.bottom);
+
+        // Rasterizes the shape to a mask of the opaque coverage.
+        pixel_utils::Mask mask((uint32_t)(right - left), (uint32_t)(bottom - top));
+
+        for (uint32_t y = 0; y < mask.height; ++y)
+        {
+            auto row = mask.row(y);
+            for (uint32_t x = 0; x < mask.width; x += 4)
+            {
+                float coverage[4] = {};
+                if (settings.useSimd)
+                {
+                    coverage4<true>(op.value(), left + (int32_t)x, top + (int32_t)y, coverage);
+                }
+                else coverage4<false>(op.value(), left + (int32_t)x, top + (int32_t)y, coverage);
+
+                for (uint32_t i = 0; i < 4 && x + i < mask.width; ++i)
+                {
+                    row[x + i] = (uint8_t)std::nearbyint(saturate(coverage[i]) * 255.0f);
+                }
+            }
+        }
+        auto transform = m_transform;
+        m_transform = Matrix{};
+
+        drawShadow(mask, { (float)left, (float)top }, stdDev, color);
+
+        m_transform = transform;
+    }
+
+    template<bool Simd>
+    void SoftwareRasterizer::coverage4(const Op& op, int32_t x, int32_t y, float* coverage) const
+    {
+        switch (op.type)
+        {
+        case Op::Type::AlignedBox:
+        {
+            areaCoverage4<Simd>(x, spanCoverage((float)y, op.outer.top, op.outer.bottom), op.outer, coverage);
+
+            auto innerRow = spanCoverage((float)y, op.inner.top, op.inner.bottom);
+            if (innerRow > 0.0f)
+            {
+                float inner[4] = {};
+                areaCoverage4<Simd>(x, innerRow, op.inner, inner);
+
+                for (int i = 0; i < 4; ++i) coverage[i] = saturate(coverage[i] - inner[i]);
+            }
+            break;
+        }
+        case Op::Type::Box:
+        case Op::Type::RoundedBox:
+        case Op::Type::Bitmap:
+        {
+            if (op.type == Op::Type::Bitmap && op.aligned)
+            {
+                areaCoverage4<Simd>(x, spanCoverage((float)y, op.outer.top, op.outer.bottom), op.outer, coverage);
+                break;
+            }
+            float distance[4] = {};
+            distance4<Simd>(
+                x, y, op.map, op.halfWidth, op.halfHeight,
+                op.radius, op.type == Op::Type::RoundedBox, distance);
+
+            distanceCoverage4<Simd>(distance, op.scale, op.halfStroke, coverage);
+            break;
+        }
+        case Op::Type::Mask:
+        {
+            auto& mask = m_masks[op.mask];
+
+            auto my = y - op.originY;
+            for (int i = 0; i < 4; ++i)
+            {
+                auto mx = x + i - op.originX;
+                bool inside = mx >= 0 && my >= 0 && mx < (int32_t)mask.width && my < (int32_t)mask.height;
+
+                coverage[i] = inside ? (float)mask.row((uint32_t)my)[mx] * g_inv255 : 0.0f;
+            }
+            break;
+        }
+        default:
+        {
+            for (int i = 0; i < 4; ++i) coverage[i] = 0.0f;
+            break;
+        }
+        }
+    }
+
+    struct SoftwareRasterizer::TileContext
+    {
+        int32_t left = 0, top = 0;
+        uint32_t width = 0, height = 0;
+
+        // The floats of each row, which holds the width rounded up to the
+        // groups of 4 pixels.
+        size_t stride = 0;
+
+        std::vector<float> pixels = {};
+
+        // The clips intersected, including those of the layers.
+        std::vector<Rect> clips = {};
+
+        struct Layer
+        {
+            std::vector<float> backdrop = {};
+
+            float opacity = 1.0f;
+        };
+        std::vector<Layer> layers = {};
+
+        const std::vector<uint32_t>* ops = nullptr;
+    };
+
+    template<bool Simd>
+    void SoftwareRasterizer::drawOp(TileContext& context, const Op& op) const
+    {
+        auto& clip = context.clips.back();
+        auto area = intersected(op.bounds, clip);
+
+        auto x0 = std::max((int32_t)std::floor(std::max(area.left, -g_maxCoordinate)), context.left);
+        auto y0 = std::max((int32_t)std::floor(std::max(area.top, -g_maxCoordinate)), context.top);
+        auto x1 = std::min((int32_t)std::ceil(std::min(area.right, g_maxCoordinate)), context.left + (int32_t)context.width);
+        auto y1 = std::min((int32_t)std::ceil(std::min(area.bottom, g_maxCoordinate)), context.top + (int32_t)context.height);
+
+        if (x0 >= x1 || y0 >= y1) return;
+
+        // The groups of 4 pixels from the left of the tile.
+        x0 = context.left + ((x0 - context.left) & ~3);
+
+        int32_t bitmapSource[4] = {};
+        if (op.type == Op::Type::Bitmap)
+        {
+            bitmapSource[0] = (int32_t)op.source.left;
+            bitmapSource[1] = (int32_t)op.source.top;
+            bitmapSource[2] = (int32_t)op.source.right;
+            bitmapSource[3] = (int32_t)op.source.bottom;
+        }
+        for (int32_t y = y0; y < y1; ++y)
+        {
+            auto row = context.pixels.data() + (size_t)(y - context.top) * context.stride;
+            auto clipRow = spanCoverage((float)y, clip.top, clip.bottom);
+
+            auto py = (float)y + 0.5f;
+            auto rowU = py * op.texels.m21 + op.texels.dx;
+            auto rowV = py * op.texels.m22 + op.texels.dy;
+
+            for (int32_t x = x0; x < x1; x += 4)
+            {
+                auto pixels = row + (size_t)(x - context.left) * 4;
+
+                float clipCoverage[4] = {};
+                areaCoverage4<Simd>(x, clipRow, clip, clipCoverage);
+
+                if (op.type == Op::Type::Clear)
+                {
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        replacePixel<Simd>(pixels + i * 4, op.color.data(), clipCoverage[i]);
+                    }
+                    continue;
+                }
+                float coverage[4] = {};
+                coverage4<Simd>(op, x, y, coverage);
+                multiply4<Simd>(coverage, clipCoverage);
+
+                if (op.type == Op::Type::Bitmap)
+                {
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        auto c = coverage[i] * op.opacity;
+                        if (c <= 0.0f) continue;
+
+                        auto px = (float)(x + i) + 0.5f;
+                        auto u = px * op.texels.m11 + rowU;
+                        auto v = px * op.texels.m12 + rowV;
+
+                        alignas(16) float color[4] = {};
+                        sampleBitmap<Simd>(op.bitmap, bitmapSource, op.linear, u, v, color);
+
+                        blendPixel<Simd>(pixels + i * 4, color, c);
+                    }
+                    continue;
+                }
+                for (int i = 0; i < 4; ++i)
+                {
+                    if (coverage[i] > 0.0f)
+                    {
+                        blendPixel<Simd>(pixels + i * 4, op.color.data(), coverage[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    template<bool Simd>
+    void SoftwareRasterizer::rasterizeTile(TileContext& context)
+    {
+        context.stride = (size_t)((context.width + 3) & ~3u) * 4;
+        context.pixels.assign(context.stride * context.height, 0.0f);
+
+        for (uint32_t y = 0; y < context.height; ++y)
+        {
+            loadRow<Simd>(
+                m_target.pixels.data() + ((size_t)(context.top + y) * m_target.width + context.left) * 4,
+                context.width, context.pixels.data() + y * context.stride);
+        }
+        context.clips.assign(1, { 0.0f, 0.0f, (float)m_target.width, (float)m_target.height });
+        context.layers.clear();
+
+        auto popLayer = [&]
+        {
+            auto layer = std::move(context.layers.back());
+            context.layers.pop_back();
+
+            // Composites the layer onto its backdrop.
+            for (size_t i = 0; i < context.pixels.size(); i += 4)
+            {
+                blendPixel<Simd>(layer.backdrop.data() + i, context.pixels.data() + i, layer.opacity);
+            }
+            context.pixels = std::move(layer.backdrop);
+
+            if (context.clips.size() > 1) context.clips.pop_back();
+        };
+        for (auto index : *context.ops)
+        {
+            auto& op = m_ops[index];
+            switch (op.type)
+            {
+            case Op::Type::PushClip:
+            {
+                context.clips.push_back(intersected(context.clips.back(), op.outer));
+                break;
+            }
+            case Op::Type::PopClip:
+            {
+                if (context.clips.size() > 1) context.clips.pop_back();
+                break;
+            }
+            case Op::Type::PushLayer:
+            {
+                context.layers.push_back({ std::move(context.pixels), op.opacity });
+                context.pixels.assign(context.stride * context.height, 0.0f);
+
+                context.clips.push_back(intersected(context.clips.back(), op.outer));
+                break;
+            }
+            case Op::Type::PopLayer:
+            {
+                if (!context.layers.empty()) popLayer();
+                break;
+            }
+            default: drawOp<Simd>(context, op); break;
+            }
+        }
+        while (!context.layers.empty()) popLayer();
+
+        for (uint32_t y = 0; y < context.height; ++y)
+        {
+            storeRow<Simd>(
+                context.pixels.data() + y * context.stride, context.width,
+                m_target.pixels.data() + ((size_t)(context.top + y) * m_target.width + context.left) * 4);
+        }
+    }
+
+    void SoftwareRasterizer::flush()
+    {
+        if (m_target.width == 0 || m_target.height == 0 || m_ops.empty())
+        {
+            m_ops.clear(); m_masks.clear(); return;
+        }
+        auto tileSize = (std::max(settings.tileSize, 4u) + 3) & ~3u;
+
+        auto columns = (m_target.width + tileSize - 1) / tileSize;
+        auto rows = (m_target.height + tileSize - 1) / tileSize;
+
+        // The ops of each tile in order, where the state changes go to all
+        // the tiles and the draws only to those they intersect.
+        std::vector<std::vector<uint32_t>> bins((size_t)columns * rows);
+
+        for (uint32_t i = 0; i < m_ops.size(); ++i)
+        {
+            auto& op = m_ops[i];
+
+            bool isDraw = op.type != Op::Type::Clear &&
+                op.type != Op::Type::PushClip && op.type != Op::Type::PopClip &&
+                op.type != Op::Type::PushLayer && op.type != Op::Type::PopLayer;
+
+            uint32_t c0 = 0, r0 = 0, c1 = columns, r1 = rows;
+            if (isDraw)
+            {
+                auto b = intersected(op.bounds, { 0.0f, 0.0f, (float)m_target.width, (float)m_target.height });
+                if (isEmpty(b)) continue;
+
+                c0 = (uint32_t)b.left / tileSize;
+                r0 = (uint32_t)b.top / tileSize;
+                c1 = std::min(((uint32_t)std::ceil(b.right) + tileSize - 1) / tileSize, columns);
+                r1 = std::min(((uint32_t)std::ceil(b.bottom) + tileSize - 1) / tileSize, rows);
+            }
+            for (uint32_t r = r0; r < r1; ++r)
+            {
+                for (uint32_t c = c0; c < c1; ++c) bins[(size_t)r * columns + c].push_back(i);
+            }
+        }
+        std::atomic<size_t> next = 0;
+
+        auto work = [&]
+        {
+            TileContext context = {};
+            for (size_t index = next++; index < bins.size(); index = next++)
+            {
+                if (bins[index].empty()) continue;
+
+                auto column = (uint32_t)(index % columns);
+                auto row = (uint32_t)(index / columns);
+
+                context.left = (int32_t)(column * tileSize);
+                context.top = (int32_t)(row * tileSize);
+                context.width = std::min(tileSize, m_target.width - column * tileSize);
+                context.height = std::min(tileSize, m_target.height - row * tileSize);
+                context.ops = &bins[index];
+
+                if (settings.useSimd)
+                {
+                    rasterizeTile<true>(context);
+                }
+                else rasterizeTile<false>(context);
+            }
+        };
+        size_t threadCount = settings.threadCount;
+        if (threadCount == 0)
+        {
+            threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+        threadCount = std::min(threadCount, bins.size());
+
+        std::vector<std::thread> threads = {};
+        for (size_t i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(work);
+        }
+        work();
+
+        for (auto& thread : threads) thread.join();
+
+        m_ops.clear();
+        m_masks.clear();
+    }
+
+    SoftwareReplayer::SoftwareReplayer(SoftwareRasterizer& rasterizer, const DisplayList& list)
+        :
+        m_rasterizer(rasterizer), m_list(list) { }
+
+    DisplayList::Color SoftwareReplayer::colorOf(const DisplayList::Brush& brush)
+    {
+        auto color = brush.color;
+        color.a *= brush.opacity;
+        return color;
+    }
+
+    void SoftwareReplayer::drawPlaceholder(const DisplayList::Rect& bounds, const DisplayList::Color& color)
+    {
+        auto placeholder = color;
+        placeholder.a *= 0.25f;
+
+        m_rasterizer.fillRect(bounds, placeholder);
+    }
+
+    void SoftwareReplayer::setTarget(const DisplayList::SetTarget& command)
+    {
+        m_frameTarget = command.target == DisplayList::g_nullResource;
+    }
+
+    void SoftwareReplayer::setTransform(const DisplayList::SetTransform& command)
+    {
+        m_rasterizer.setTransform(command.transform);
+    }
+
+    void SoftwareReplayer::clear(const DisplayList::Clear& command)
+    {
+        if (m_frameTarget) m_rasterizer.clear(command.color);
+    }
+
+    void SoftwareReplayer::pushClip(const DisplayList::PushClip& command)
+    {
+        // D2D1_ANTIALIAS_MODE_PER_PRIMITIVE is 0.
+        if (m_frameTarget) m_rasterizer.pushClip(command.rect, command.antialiasMode == 0);
+    }
+
+    void SoftwareReplayer::popClip(const DisplayList::PopClip& command)
+    {
+        if (m_frameTarget) m_rasterizer.popClip();
+    }
+
+    void SoftwareReplayer::pushLayer(const DisplayList::PushLayer& command)
+    {
+        // The geometric masks and the opacity brushes are not supported.
+        if (m_frameTarget) m_rasterizer.pushLayer(command.bounds, command.opacity);
+    }
+
+    void SoftwareReplayer::popLayer(const DisplayList::PopLayer& command)
+    {
+        if (m_frameTarget) m_rasterizer.popLayer();
+    }
+
+    void SoftwareReplayer::fillRect(const DisplayList::FillRect& command)
+    {
+        if (m_frameTarget) m_rasterizer.fillRect(command.rect, colorOf(command.brush));
+    }
+
+    void SoftwareReplayer::drawRect(const DisplayList::DrawRect& command)
+    {
+        if (m_frameTarget) m_rasterizer.drawRect(command.rect, colorOf(command.brush), command.strokeWidth);
+    }
+
+    void SoftwareReplayer::fillRoundedRect(const DisplayList::FillRoundedRect& command)
+    {
+        if (m_frameTarget)
+        {
+            m_rasterizer.fillRoundedRect(command.rect, command.radiusX, command.radiusY, colorOf(command.brush));
+        }
+    }
+
+    void SoftwareReplayer::drawRoundedRect(const DisplayList::DrawRoundedRect& command)
+    {
+        if (m_frameTarget)
+        {
+            m_rasterizer.drawRoundedRect(
+                command.rect, command.radiusX, command.radiusY,
+                colorOf(command.brush), command.strokeWidth);
+        }
+    }
+
+    void SoftwareReplayer::drawLine(const DisplayList::DrawLine& command)
+    {
+        if (m_frameTarget)
+        {
+            m_rasterizer.drawLine(command.point0, command.point1, colorOf(command.brush), command.strokeWidth);
+        }
+    }
+
+    void SoftwareReplayer::drawBitmap(const DisplayList::DrawBitmap& command)
+    {
+        if (!m_frameTarget) return;
+
+        Optional<pixel_utils::ImageView> bitmap = {};
+        if (bitmapProvider) bitmap = bitmapProvider(command.bitmap);
+
+        if (bitmap.has_value())
+        {
+            // D2D1_INTERPOLATION_MODE_NEAREST_NEIGHBOR is 0.
+            m_rasterizer.drawBitmap(
+                bitmap.value(), command.destination, command.opacity,
+                command.interpolationMode != 0,
+                command.hasSource ? &command.source : nullptr);
+        }
+        else drawPlaceholder(command.destination, { 0.5f, 0.5f, 0.5f, command.opacity });
+    }
+
+    void SoftwareReplayer::drawTextLayout(const DisplayList::DrawTextLayout& command)
+    {
+        if (!m_frameTarget) return;
+
+        const TextMask* text = nullptr;
+        if (textProvider) text = textProvider(command.layout);
+
+        if (text != nullptr)
+        {
+            DisplayList::Point origin = { command.origin.x + text->offset.x, command.origin.y + text->offset.y };
+            m_rasterizer.drawMask(text->coverage, origin, colorOf(command.brush));
+        }
+        else if (auto resource = m_list.resource(command.layout))
+        {
+            auto& b = resource->bounds;
+            drawPlaceholder(
+            {
+                command.origin.x + b.left, command.origin.y + b.top,
+                command.origin.x + b.right, command.origin.y + b.bottom
+            },
+            colorOf(command.brush));
+        }
+    }
+
+    void SoftwareReplayer::fillGeometry(const DisplayList::FillGeometry& command)
+    {
+        auto resource = m_list.resource(command.geometry);
+        if (m_frameTarget && resource != nullptr)
+        {
+            drawPlaceholder(resource->bounds, colorOf(command.brush));
+        }
+    }
+
+    void SoftwareReplayer::drawGeometry(const DisplayList::DrawGeometry& command)
+    {
+        auto resource = m_list.resource(command.geometry);
+        if (m_frameTarget && resource != nullptr)
+        {
+            drawPlaceholder(inflated(resource->bounds, command.strokeWidth * 0.5f), colorOf(command.brush));
+        }
+    }
+
+    void SoftwareReplayer::drawImage(const DisplayList::DrawImage& command)
+    {
+        if (m_frameTarget && command.hasBounds)
+        {
+            drawPlaceholder(command.bounds, { 0.5f, 0.5f, 0.5f, 1.0f });
+        }
+    }
+}
@@ -0,0 +1,268 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+#include "Common/PixelUtils/Image.h"
+
+#include "Renderer/DisplayList.h"
+
+namespace d14engine::renderer
+{
+    // Rasterizes the 2D drawing vocabulary of the UI on the CPU, e.g. to
+    // render the panel trees on the servers (the thumbnails, the tests of
+    // the images) where no GPU device is available:
+    //
+    // the antialiased rectangles, the rounded rectangles and the lines
+    // (filled or stroked with the solid colors), the bitmaps, the clips,
+    // the opacity layers, the Gaussian shadows and the coverage masks of
+    // the glyphs (which the caller rasterizes with its font engine).
+    //
+    // The draw calls are recorded and rasterized by flush, which splits
+    // the target into tiles and renders them in parallel, each with its
+    // own clips and layers, so the result never depends on the count of
+    // the threads.  The coverage and the blending of the pixels are done
+    // 4 at a time with SSE2, and the scalar path produces the identical
+    // result as the reference.
+    //
+    // The target is premultiplied RGBA8, and the colors are straight (as
+    // those of D2D1_COLOR_F) and premultiplied when drawn.
+
+    struct SoftwareRasterizer : cpp_lang_utils::NonCopyable
+    {
+        using Point = DisplayList::Point;
+        using Rect = DisplayList::Rect;
+        using Color = DisplayList::Color;
+        using Matrix = DisplayList::Matrix;
+
+        SoftwareRasterizer(uint32_t width, uint32_t height);
+
+        struct Settings
+        {
+            uint32_t tileSize = 64;
+
+            // 0 for the count of the hardware threads.
+            uint32_t threadCount = 0;
+
+            bool useSimd = true;
+        }
+        settings = {};
+
+        // Valid after flush.
+        const pixel_utils::Image& target() const;
+
+    public:
+        const Matrix& transform() const;
+
+        // The transform of the later draws, which maps their DIPs to the
+        // pixels of the target.
+        void setTransform(const Matrix& transform);
+
+        // Replaces the pixels inside the clips (the transform is ignored).
+        void clear(const Color& color);
+
+        // The bounds of the transformed rectangle are the clip, and their
+        // edges are rounded to the pixels when aliased.
+        void pushClip(const Rect& rect, bool antialiased = true);
+
+        void popClip();
+
+        // The draws till popLayer are composited with the opacity as one,
+        // and also clipped by the bounds.
+        void pushLayer(const Rect& bounds, float opacity);
+
+        void popLayer();
+
+    public:
+        void fillRect(const Rect& rect, const Color& color);
+
+        // The strokes are centered on the outlines with the miter joins.
+        void drawRect(const Rect& rect, const Color& color, float strokeWidth = 1.0f);
+
+        void fillRoundedRect(const Rect& rect, float radiusX, float radiusY, const Color& color);
+
+        void drawRoundedRect(
+            const Rect& rect, float radiusX, float radiusY,
+            const Color& color, float strokeWidth = 1.0f);
+
+        // With the flat caps.
+        void drawLine(Point point0, Point point1, const Color& color, float strokeWidth = 1.0f);
+
+        // The pixels of the bitmap should be premultiplied, and they are
+        // only read by flush, so they must outlive the call of flush.
+        void drawBitmap(
+            const pixel_utils::ImageView& bitmap,
+            const Rect& destination,
+            float opacity = 1.0f,
+            bool linear = true,
+            const Rect* source = nullptr);
+
+        // Draws the coverage (e.g. of a run of the glyphs) with the color,
+        // and the mask is placed at the transformed origin rounded to the
+        // pixels without being scaled.
+        void drawMask(const pixel_utils::Mask& mask, Point origin, const Color& color);
+
+        // Blurs the mask with the Gaussian of the standard deviation (in
+        // pixels) and draws it with the color, where the origin is that of
+        // the unblurred mask.
+        void drawShadow(const pixel_utils::Mask& mask, Point origin, float stdDev, const Color& color);
+
+        // The shadow of a rounded rectangle, e.g. that of a panel.
+        void drawShadow(
+            const Rect& rect, float radiusX, float radiusY,
+            float stdDev, const Color& color);
+
+        // Rasterizes the recorded draws to the target, and closes the clips
+        // and the layers left open.
+        void flush();
+
+    protected:
+        pixel_utils::Image m_target = {};
+
+        Matrix m_transform = {};
+
+        // The premultiplied color with the alpha in the last channel.
+        using Pixel = std::array<float, 4>;
+
+        struct Op
+        {
+            enum class Type
+            {
+                Clear, PushClip, PopClip, PushLayer, PopLayer,
+                // The rectangles not rotated or skewed, whose coverage is
+                // the exact area of each pixel inside the outer rectangle
+                // and outside the inner one.
+                AlignedBox,
+                // The other shapes, whose coverage is estimated from the
+                // signed distance to the outline.
+                Box, RoundedBox,
+                Bitmap, Mask
+            }
+            type = Type::Clear;
+
+            Pixel color = {};
+
+            // In the pixels, where the ops of the draws only touch the
+            // tiles that intersect the bounds.
+            Rect bounds = {};
+
+            // Of AlignedBox (and Bitmap when aligned), where the inner one
+            // is empty for the fills.
+            Rect outer = {}, inner = {};
+
+            // Maps the centers of the pixels to the space of the shape (of
+            // Box, RoundedBox and Bitmap), where the shape is centered at 0.
+            Matrix map = {};
+
+            float halfWidth = 0.0f, halfHeight = 0.0f;
+
+            // The elliptic corners are made circular by scaling the map.
+            float radius = 0.0f;
+
+            // The pixels per unit of the space of the shape.
+            float scale = 1.0f;
+
+            // Half the width of the stroke, or negative for the fills.
+            float halfStroke = -1.0f;
+
+            // Of Bitmap, which is clipped by the transformed destination
+            // (exactly when aligned and as a Box otherwise).
+            pixel_utils::ImageView bitmap = {};
+            Matrix texels = {};
+            Rect source = {};
+            bool linear = true;
+            bool aligned = false;
+
+            // Of Mask, whose top-left corner is at the origin.
+            size_t mask = 0;
+            int32_t originX = 0, originY = 0;
+
+            // Of PushLayer and Bitmap.
+            float opacity = 1.0f;
+        };
+        std::vector<Op> m_ops = {};
+
+        std::vector<pixel_utils::Mask> m_masks = {};
+
+        Rect deviceBoundsOf(const Rect& rect) const;
+
+        // Of the rectangle, or empty if the transform is degenerate.
+        Optional<Op> shapeOf(const Rect& rect, float radiusX, float radiusY) const;
+
+        // Of the antialiased edges.
+        constexpr static float g_margin = 1.0f;
+
+        // The coverage of the draw of 4 pixels from (x, y) in the row.
+        template<bool Simd>
+        void coverage4(const Op& op, int32_t x, int32_t y, float* coverage) const;
+
+        struct TileContext;
+
+        template<bool Simd>
+        void rasterizeTile(TileContext& context);
+
+        template<bool Simd>
+        void drawOp(TileContext& context, const Op& op) const;
+    };
+
+    // Replays a display list with the software rasterizer, where only the
+    // commands to the frame target are drawn (those to the other targets
+    // have no pixels to read back).  The commands whose contents are not
+    // available (the bitmaps and the texts without the providers below,
+    // the geometries and the effects) are drawn as the translucent boxes
+    // of their bounds, so the layout still shows.
+    struct SoftwareReplayer : DisplayList::IBackend
+    {
+        SoftwareReplayer(SoftwareRasterizer& rasterizer, const DisplayList& list);
+
+        // Returns the premultiplied pixels of the bitmap, which must stay
+        // valid till the rasterizer is flushed.
+        Function<Optional<pixel_utils::ImageView>(DisplayList::ResourceID)> bitmapProvider = {};
+
+        struct TextMask
+        {
+            pixel_utils::Mask coverage = {};
+
+            // Of the top-left corner of the coverage from the origin of the
+            // layout, in pixels.
+            DisplayList::Point offset = {};
+        };
+        // Returns the coverage of the glyphs of the layout.
+        Function<const TextMask*(DisplayList::ResourceID)> textProvider = {};
+
+    protected:
+        SoftwareRasterizer& m_rasterizer;
+
+        const DisplayList& m_list;
+
+        bool m_frameTarget = true;
+
+        // Of the brush with its opacity.
+        static DisplayList::Color colorOf(const DisplayList::Brush& brush);
+
+        void drawPlaceholder(const DisplayList::Rect& bounds, const DisplayList::Color& color);
+
+    public:
+        // Override DisplayList::IBackend
+        void setTarget(const DisplayList::SetTarget& command) override;
+        void setTransform(const DisplayList::SetTransform& command) override;
+        void clear(const DisplayList::Clear& command) override;
+
+        void pushClip(const DisplayList::PushClip& command) override;
+        void popClip(const DisplayList::PopClip& command) override;
+        void pushLayer(const DisplayList::PushLayer& command) override;
+        void popLayer(const DisplayList::PopLayer& command) override;
+
+        void fillRect(const DisplayList::FillRect& command) override;
+        void drawRect(const DisplayList::DrawRect& command) override;
+        void fillRoundedRect(const DisplayList::FillRoundedRect& command) override;
+        void drawRoundedRect(const DisplayList::DrawRoundedRect& command) override;
+        void drawLine(const DisplayList::DrawLine& command) override;
+
+        void drawBitmap(const DisplayList::DrawBitmap& command) override;
+        void drawTextLayout(const DisplayList::DrawTextLayout& command) override;
+        void fillGeometry(const DisplayList::FillGeometry& command) override;
+        void drawGeometry(const DisplayList::DrawGeometry& command) override;
+        void drawImage(const DisplayList::DrawImage& command) override;
+    };
+}
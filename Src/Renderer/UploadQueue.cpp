@@ -0,0 +1,232 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/UploadQueue.h"
+
+#include "Common/DirectXError.h"
+
+#include "Renderer/GraphUtils/ParamHelper.h"
+
+namespace d14engine::renderer
+{
+    UploadQueue::UploadQueue(ID3D12Device* device, UINT64 capacity)
+        :
+        m_device(device)
+    {
+        D3D12_COMMAND_QUEUE_DESC desc =
+        {
+            .Type = D3D12_COMMAND_LIST_TYPE_COPY,
+            .Flags = D3D12_COMMAND_QUEUE_FLAG_NONE
+        };
+        THROW_IF_FAILED(m_device->CreateCommandQueue
+        (
+        /* pDesc          */ &desc,
+        /* riid           */
+        /* ppCommandQueue */ IID_PPV_ARGS(&m_copyQueue)
+        ));
+        THROW_IF_FAILED(m_device->CreateCommandAllocator
+        (
+        /* type               */ desc.Type,
+        /* riid               */
+        /* ppCommandAllocator */ IID_PPV_ARGS(&m_currCmdAlloc)
+        ));
+        THROW_IF_FAILED(m_device->CreateCommandList
+        (
+        /* nodeMask          */ 0,
+        /* type              */ desc.Type,
+        /* pCommandAllocator */ m_currCmdAlloc.Get(),
+        /* pInitialState     */ nullptr,
+        /* riid              */
+        /* ppCommandList     */ IID_PPV_ARGS(&m_cmdList)
+        ));
+        // Reset again when the first copy of the next batch is recorded.
+        THROW_IF_FAILED(m_cmdList->Close());
+        m_currCmdAlloc.Reset();
+
+        THROW_IF_FAILED(m_device->CreateFence
+        (
+        /* InitialValue */ 0,
+        /* Flags        */ D3D12_FENCE_FLAG_NONE,
+        /* riid         */
+        /* ppFence      */ IID_PPV_ARGS(&m_fence)
+        ));
+        m_fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+        THROW_IF_NULL(m_fenceEvent);
+
+        auto prop = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+        auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+
+        THROW_IF_FAILED(m_device->CreateCommittedResource
+        (
+        /* pHeapProperties      */ &prop,
+        /* HeapFlags            */ D3D12_HEAP_FLAG_NONE,
+        /* pDesc                */ &bufferDesc,
+        /* InitialResourceState */ D3D12_RESOURCE_STATE_GENERIC_READ,
+        /* pOptimizedClearValue */ nullptr,
+        /* riidResource         */
+        /* ppvResource          */ IID_PPV_ARGS(&m_staging)
+        ));
+        // The upload heap can be kept mapped for the lifetime of the buffer.
+        THROW_IF_FAILED(m_staging->Map(0, nullptr, (void**)&m_mapped));
+
+        m_ring = std::make_unique<UploadRing>(this, m_mapped, capacity);
+    }
+
+    UploadQueue::~UploadQueue()
+    {
+        m_ring->wait(m_ring->flush());
+
+        m_staging->Unmap(0, nullptr);
+
+        CloseHandle(m_fenceEvent);
+    }
+
+    void UploadQueue::releaseCompleted(UINT64 completedValue)
+    {
+        while (!m_pendingDestinations.empty() && m_pendingDestinations.front().first <= completedValue)
+        {
+            m_pendingDestinations.pop_front();
+        }
+    }
+
+    void UploadQueue::copyBuffer(void* destination, uint64_t dstOffset, uint64_t srcOffset, uint64_t size)
+    {
+        if (!m_currCmdAlloc)
+        {
+            if (!m_pendingCmdAllocs.empty() &&
+                m_pendingCmdAllocs.front().first <= m_fence->GetCompletedValue())
+            {
+                m_currCmdAlloc = std::move(m_pendingCmdAllocs.front().second);
+                m_pendingCmdAllocs.pop_front();
+
+                THROW_IF_FAILED(m_currCmdAlloc->Reset());
+            }
+            else // all in flight
+            {
+                THROW_IF_FAILED(m_device->CreateCommandAllocator
+                (
+                /* type               */ D3D12_COMMAND_LIST_TYPE_COPY,
+                /* riid               */
+                /* ppCommandAllocator */ IID_PPV_ARGS(&m_currCmdAlloc)
+                ));
+            }
+            THROW_IF_FAILED(m_cmdList->Reset(m_currCmdAlloc.Get(), nullptr));
+        }
+        m_cmdList->CopyBufferRegion
+        (
+        /* pDstBuffer */ (ID3D12Resource*)destination,
+        /* DstOffset  */ dstOffset,
+        /* pSrcBuffer */ m_staging.Get(),
+        /* SrcOffset  */ srcOffset,
+        /* NumBytes   */ size
+        );
+    }
+
+    void UploadQueue::submitBatch(uint64_t fenceValue)
+    {
+        THROW_IF_FAILED(m_cmdList->Close());
+
+        // Waits for the commands submitted to the reading queue so far,
+        // which may still be reading the destinations of the batch.
+        if (m_readingQueue)
+        {
+            THROW_IF_FAILED(m_readingQueue->Signal(m_readingFence.Get(), ++m_readingFenceValue));
+            THROW_IF_FAILED(m_copyQueue->Wait(m_readingFence.Get(), m_readingFenceValue));
+        }
+        ID3D12CommandList* ppCmdList[] = { m_cmdList.Get() };
+        m_copyQueue->ExecuteCommandLists(NUM_ARR_ARGS(ppCmdList));
+
+        THROW_IF_FAILED(m_copyQueue->Signal(m_fence.Get(), fenceValue));
+
+        m_pendingCmdAllocs.emplace_back(fenceValue, std::move(m_currCmdAlloc));
+
+        for (auto& destination : m_currDestinations)
+        {
+            m_pendingDestinations.emplace_back(fenceValue, std::move(destination));
+        }
+        m_currDestinations.clear();
+    }
+
+    uint64_t UploadQueue::completedValue()
+    {
+        return m_fence->GetCompletedValue();
+    }
+
+    void UploadQueue::waitForValue(uint64_t fenceValue)
+    {
+        if (m_fence->GetCompletedValue() < fenceValue)
+        {
+            THROW_IF_FAILED(m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent));
+            WaitForSingleObject(m_fenceEvent, INFINITE);
+        }
+        releaseCompleted(fenceValue);
+    }
+
+    ID3D12CommandQueue* UploadQueue::copyQueue() const
+    {
+        return m_copyQueue.Get();
+    }
+
+    ID3D12Fence* UploadQueue::fence() const
+    {
+        return m_fence.Get();
+    }
+
+    void UploadQueue::setReadingQueue(ID3D12CommandQueue* queue)
+    {
+        m_readingQueue = queue;
+
+        if (m_readingQueue && !m_readingFence)
+        {
+            THROW_IF_FAILED(m_device->CreateFence
+            (
+            /* InitialValue */ m_readingFenceValue,
+            /* Flags        */ D3D12_FENCE_FLAG_NONE,
+            /* riid         */
+            /* ppFence      */ IID_PPV_ARGS(&m_readingFence)
+            ));
+        }
+    }
+
+    UploadQueue::Ticket UploadQueue::enqueue(ID3D12Resource* destination, UINT64 dstOffset, const void* data, UINT64 size)
+    {
+        auto ticket = m_ring->enqueue(destination, dstOffset, data, size);
+
+        // Stamped with the next batch, which is not earlier than any chunk.
+        m_currDestinations.emplace_back(destination);
+
+        return ticket;
+    }
+
+    UploadQueue::Ticket UploadQueue::flush(ID3D12CommandQueue* waitingQueue)
+    {
+        auto ticket = m_ring->flush();
+
+        if (waitingQueue != nullptr && ticket > m_waitedTicket)
+        {
+            if (!m_ring->isComplete(ticket))
+            {
+                THROW_IF_FAILED(waitingQueue->Wait(m_fence.Get(), ticket));
+            }
+            m_waitedTicket = ticket;
+        }
+        m_ring->reclaim();
+        releaseCompleted(m_fence->GetCompletedValue());
+
+        return ticket;
+    }
+
+    bool UploadQueue::isComplete(Ticket ticket)
+    {
+        return m_ring->isComplete(ticket);
+    }
+
+    void UploadQueue::wait(Ticket ticket)
+    {
+        m_ring->wait(ticket);
+    }
+
+    UploadRing::Statistics UploadQueue::statistics() const
+    {
+        return m_ring->statistics();
+    }
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+#include "Renderer/UploadRing.h"
+
+namespace d14engine::renderer
+{
+    // Uploads the buffer data through a persistently mapped staging buffer
+    // (see UploadRing for the policy) on a dedicated copy queue, so that the
+    // copies run in parallel with the drawing instead of being recorded in
+    // the command list of the frame.
+    //
+    // The destination buffers are promoted to COPY_DEST implicitly on the
+    // copy queue and decay to COMMON afterwards, so no barriers are needed.
+    // The queue reading them should wait for the ticket on the GPU timeline
+    // (see flush), which Renderer does before each submission.
+    //
+    // Conversely, a copy must not overwrite a buffer that the commands
+    // submitted earlier are still reading, so each batch waits for the
+    // reading queue to reach the point where it is submitted (see
+    // setReadingQueue).
+    struct UploadQueue : cpp_lang_utils::NonCopyable, protected UploadRing::IBackend
+    {
+        constexpr static UINT64 g_defaultCapacity = 32 * 1024 * 1024;
+
+        UploadQueue(ID3D12Device* device, UINT64 capacity = g_defaultCapacity);
+
+        virtual ~UploadQueue();
+
+        using Ticket = UploadRing::Ticket;
+
+    protected:
+        ComPtr<ID3D12Device> m_device = {};
+
+        ComPtr<ID3D12CommandQueue> m_copyQueue = {};
+        ComPtr<ID3D12GraphicsCommandList> m_cmdList = {};
+
+        // The allocator of the recording batch and the ones in flight,
+        // which are reused after their fence values complete.
+        ComPtr<ID3D12CommandAllocator> m_currCmdAlloc = {};
+        std::deque<std::pair<UINT64, ComPtr<ID3D12CommandAllocator>>> m_pendingCmdAllocs = {};
+
+        ComPtr<ID3D12Fence> m_fence = {};
+        HANDLE m_fenceEvent = nullptr;
+
+        ComPtr<ID3D12Resource> m_staging = {};
+        BYTE* m_mapped = nullptr;
+
+        UniquePtr<UploadRing> m_ring = {};
+
+        // The destinations are kept alive until their copies complete.
+        std::vector<ComPtr<ID3D12Resource>> m_currDestinations = {};
+        std::deque<std::pair<UINT64, ComPtr<ID3D12Resource>>> m_pendingDestinations = {};
+
+        // The last ticket that the waiting queue has been told to wait for.
+        Ticket m_waitedTicket = 0;
+
+        // Signaled on the reading queue before each batch, and the copy
+        // queue waits for the value before executing the batch.
+        ComPtr<ID3D12CommandQueue> m_readingQueue = {};
+        ComPtr<ID3D12Fence> m_readingFence = {};
+        UINT64 m_readingFenceValue = 0;
+
+        void releaseCompleted(UINT64 completedValue);
+
+    protected:
+        // Override UploadRing::IBackend
+        void copyBuffer(void* destination, uint64_t dstOffset, uint64_t srcOffset, uint64_t size) override;
+
+        void submitBatch(uint64_t fenceValue) override;
+
+        uint64_t completedValue() override;
+
+        void waitForValue(uint64_t fenceValue) override;
+
+    public:
+        ID3D12CommandQueue* copyQueue() const;
+
+        ID3D12Fence* fence() const;
+
+        // Without a reading queue, the caller must make sure that the GPU
+        // has finished reading the destinations before uploading to them.
+        void setReadingQueue(ID3D12CommandQueue* queue);
+
+        // The data is copied into the staging buffer before returning.
+        Ticket enqueue(ID3D12Resource* destination, UINT64 dstOffset, const void* data, UINT64 size);
+
+        // Submits the pending copies, and if waitingQueue is not null, makes
+        // it wait (on the GPU) for them before executing the later commands.
+        Ticket flush(ID3D12CommandQueue* waitingQueue = nullptr);
+
+        bool isComplete(Ticket ticket);
+
+        // Blocks the CPU until the copies of the ticket complete.
+        void wait(Ticket ticket);
+
+        UploadRing::Statistics statistics() const;
+    };
+}
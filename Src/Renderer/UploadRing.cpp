@@ -0,0 +1,180 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/UploadRing.h"
+
+namespace d14engine::renderer
+{
+    UploadRing::UploadRing(IBackend* backend, uint8_t* mapped, uint64_t capacity, uint64_t alignment)
+        :
+        m_backend(backend),
+        m_mapped(mapped),
+        m_alignment(std::max<uint64_t>(alignment, 1))
+    {
+        m_capacity = capacity / m_alignment * m_alignment;
+    }
+
+    Optional<uint64_t> UploadRing::allocate(uint64_t size)
+    {
+        // Keeps the head aligned after each allocation.
+        size = (size + m_alignment - 1) / m_alignment * m_alignment;
+
+        if (size == 0 || size > m_capacity) return std::nullopt;
+
+        if (m_used == 0)
+        {
+            m_head = m_tail = 0;
+        }
+        // The free space is [head, capacity) + [0, tail) if the head is
+        // not behind the tail, or [head, tail) otherwise.
+
+        uint64_t skipped = 0;
+        if (m_used == 0 || m_head > m_tail)
+        {
+            if (m_head + size > m_capacity)
+            {
+                if (size > m_tail) return std::nullopt;
+
+                skipped = m_capacity - m_head;
+                m_head = 0;
+            }
+        }
+        else if (m_head + size > m_tail)
+        {
+            return std::nullopt;
+        }
+        auto offset = m_head;
+
+        m_head = (m_head + size) % m_capacity;
+        m_used += skipped + size;
+        m_currUsed += skipped + size;
+
+        return offset;
+    }
+
+    void UploadRing::makeRoom()
+    {
+        flush();
+
+        if (!m_batches.empty())
+        {
+            ++m_counters.stallCount;
+
+            m_backend->waitForValue(m_batches.front().fenceValue);
+        }
+        reclaim();
+    }
+
+    UploadRing::Ticket UploadRing::enqueue(void* destination, uint64_t dstOffset, const void* data, uint64_t size)
+    {
+        if (size == 0) return lastSubmitted();
+
+        auto src = (const uint8_t*)data;
+
+        while (size > 0)
+        {
+            auto chunkSize = std::min(size, m_capacity);
+
+            auto offset = allocate(chunkSize);
+            while (!offset.has_value())
+            {
+                makeRoom();
+                offset = allocate(chunkSize);
+            }
+            memcpy(m_mapped + offset.value(), src, (size_t)chunkSize);
+
+            ++m_counters.copyCount;
+            m_counters.uploadedSize += chunkSize;
+
+            auto last = m_pendingCopies.empty() ? nullptr : &m_pendingCopies.back();
+            if (last != nullptr &&
+                last->destination == destination &&
+                last->dstOffset + last->size == dstOffset &&
+                last->srcOffset + last->size == offset.value())
+            {
+                last->size += chunkSize;
+                ++m_counters.mergedCount;
+            }
+            else m_pendingCopies.push_back({ destination, dstOffset, offset.value(), chunkSize });
+
+            src += chunkSize;
+            dstOffset += chunkSize;
+            size -= chunkSize;
+        }
+        return m_nextFenceValue;
+    }
+
+    UploadRing::Ticket UploadRing::flush()
+    {
+        if (!m_pendingCopies.empty())
+        {
+            for (auto& copy : m_pendingCopies)
+            {
+                m_backend->copyBuffer(copy.destination, copy.dstOffset, copy.srcOffset, copy.size);
+            }
+            m_pendingCopies.clear();
+
+            m_backend->submitBatch(m_nextFenceValue);
+
+            m_batches.push_back({ m_nextFenceValue, m_currUsed });
+            m_currUsed = 0;
+
+            ++m_nextFenceValue;
+            ++m_counters.batchCount;
+        }
+        return lastSubmitted();
+    }
+
+    bool UploadRing::isComplete(Ticket ticket)
+    {
+        if (ticket == m_nextFenceValue && !m_pendingCopies.empty())
+        {
+            return false;
+        }
+        return ticket <= m_backend->completedValue();
+    }
+
+    void UploadRing::wait(Ticket ticket)
+    {
+        if (ticket == m_nextFenceValue) flush();
+
+        m_backend->waitForValue(std::min(ticket, lastSubmitted()));
+
+        reclaim();
+    }
+
+    void UploadRing::reclaim()
+    {
+        auto completedValue = m_backend->completedValue();
+
+        while (!m_batches.empty() && m_batches.front().fenceValue <= completedValue)
+        {
+            auto size = m_batches.front().size;
+
+            m_tail = (m_tail + size) % m_capacity;
+            m_used -= size;
+
+            m_batches.pop_front();
+        }
+    }
+
+    UploadRing::Ticket UploadRing::lastSubmitted() const
+    {
+        return m_nextFenceValue - 1;
+    }
+
+    UploadRing::Statistics UploadRing::statistics() const
+    {
+        return
+        {
+            .capacity = m_capacity,
+            .used = m_used,
+            .pendingCopyCount = m_pendingCopies.size(),
+            .batchesInFlight = m_batches.size(),
+            .copyCount = m_counters.copyCount,
+            .mergedCount = m_counters.mergedCount,
+            .batchCount = m_counters.batchCount,
+            .uploadedSize = m_counters.uploadedSize,
+            .stallCount = m_counters.stallCount
+        };
+    }
+}
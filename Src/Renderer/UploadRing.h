@@ -0,0 +1,129 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::renderer
+{
+    // Stages the uploads in a persistently mapped ring buffer and batches
+    // the copies to their destinations, which are executed by the backend
+    // (e.g. a copy queue) and completed with increasing fence values.
+    //
+    // The space of a batch is reused once its fence value completes, and
+    // the enqueue stalls only when the ring is full (waiting for the oldest
+    // batch in flight).  Uploads larger than the ring are split into chunks.
+    //
+    // Only the offsets and fence values are managed here, so the policy
+    // can be tested with a simulated queue.
+    struct UploadRing
+    {
+        struct IBackend
+        {
+            virtual ~IBackend() = default;
+
+            // Records a copy from the staging memory to the destination.
+            virtual void copyBuffer(void* destination, uint64_t dstOffset, uint64_t srcOffset, uint64_t size) = 0;
+
+            // Executes the recorded copies and signals the fence value when
+            // they are completed.
+            virtual void submitBatch(uint64_t fenceValue) = 0;
+
+            virtual uint64_t completedValue() = 0;
+
+            // Blocks until the fence value is completed.
+            virtual void waitForValue(uint64_t fenceValue) = 0;
+        };
+
+        // The capacity is rounded down to the alignment of the offsets.
+        UploadRing(IBackend* backend, uint8_t* mapped, uint64_t capacity, uint64_t alignment = 16);
+
+        // The fence value of the batch that an upload is submitted with.
+        using Ticket = uint64_t;
+
+    protected:
+        IBackend* m_backend = nullptr;
+
+        uint8_t* m_mapped = nullptr;
+
+        uint64_t m_capacity = 0;
+        uint64_t m_alignment = 1;
+
+        uint64_t m_head = 0, m_tail = 0;
+        uint64_t m_used = 0;
+
+        // Including the skipped space at the end when wrapping around.
+        uint64_t m_currUsed = 0;
+
+        struct Batch
+        {
+            uint64_t fenceValue = 0;
+            uint64_t size = 0;
+        };
+        std::deque<Batch> m_batches = {};
+
+        Optional<uint64_t> allocate(uint64_t size);
+
+        // Submits the pending copies and waits for the oldest batch.
+        void makeRoom();
+
+        struct Copy
+        {
+            void* destination = nullptr;
+
+            uint64_t dstOffset = 0, srcOffset = 0, size = 0;
+        };
+        // Recorded to the backend on flush so that the adjacent ones can be
+        // merged into a single copy.
+        std::vector<Copy> m_pendingCopies = {};
+
+        Ticket m_nextFenceValue = 1;
+
+        struct Counters
+        {
+            uint64_t copyCount = 0;
+            uint64_t mergedCount = 0;
+            uint64_t batchCount = 0;
+            uint64_t uploadedSize = 0;
+            uint64_t stallCount = 0;
+        }
+        m_counters = {};
+
+    public:
+        // Copies the data into the staging memory at once, so the source
+        // can be released after returning.  The copies to the destination
+        // are submitted on the next flush (or earlier if the ring is full).
+        Ticket enqueue(void* destination, uint64_t dstOffset, const void* data, uint64_t size);
+
+        // Returns the ticket of the last submitted batch (0 if none).
+        Ticket flush();
+
+        // A ticket is complete after its batch is submitted and executed.
+        bool isComplete(Ticket ticket);
+
+        // Submits the batch of the ticket if needed and blocks until done.
+        void wait(Ticket ticket);
+
+        void reclaim();
+
+        Ticket lastSubmitted() const;
+
+    public:
+        struct Statistics
+        {
+            uint64_t capacity = 0;
+            uint64_t used = 0;
+
+            size_t pendingCopyCount = 0;
+            size_t batchesInFlight = 0;
+
+            // Accumulated since the ring is created.
+            uint64_t copyCount = 0;
+            // The copies appended to the previous adjacent ones.
+            uint64_t mergedCount = 0;
+            uint64_t batchCount = 0;
+            uint64_t uploadedSize = 0;
+            // How many times the enqueue waited for the backend.
+            uint64_t stallCount = 0;
+        };
+        Statistics statistics() const;
+    };
+}
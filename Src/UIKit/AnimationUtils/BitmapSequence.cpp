@@ -16,7 +16,7 @@ namespace d14engine::uikit::animation_utils
                 auto& f = fanim.frames[index.value()];
                 if (f.data)
                 {
-                    rndr->d2d1DeviceContext()->DrawBitmap
+                    rndr->recorder2D()->DrawBitmap
                     (
                     /* bitmap               */ f.data.Get(),
                     /* destinationRectangle */ rect,
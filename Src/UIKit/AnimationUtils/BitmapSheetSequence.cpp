@@ -0,0 +1,68 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/AnimationUtils/BitmapSheetSequence.h"
+
+using namespace d14engine::renderer;
+
+namespace d14engine::uikit::animation_utils
+{
+    void BitmapSheetSequence::setSheet(BmpObjParam sheet, size_t frameCount)
+    {
+        this->sheet = sheet;
+
+        fanim.frames.clear();
+        if (sheet.data && frameCount > 0)
+        {
+            auto size = sheet.data->GetSize();
+            auto frameWidth = size.width / frameCount;
+
+            for (size_t i = 0; i < frameCount; ++i)
+            {
+                fanim.frames.push_back(
+                {
+                    i * frameWidth, 0.0f, (i + 1) * frameWidth, size.height
+                });
+            }
+        }
+        fanim.restore();
+    }
+
+    void BitmapSheetSequence::setSheet(BmpObjParam sheet, const std::vector<atlas_utils::UVRect>& frames)
+    {
+        this->sheet = sheet;
+
+        fanim.frames.clear();
+        if (sheet.data)
+        {
+            auto size = sheet.data->GetSize();
+            for (auto& uv : frames)
+            {
+                fanim.frames.push_back(
+                {
+                    uv.left * size.width, uv.top * size.height,
+                    uv.right * size.width, uv.bottom * size.height
+                });
+            }
+        }
+        fanim.restore();
+    }
+
+    void BitmapSheetSequence::draw(Renderer* rndr, const D2D1_RECT_F& rect)
+    {
+        if (visible && sheet.data)
+        {
+            auto index = fanim.currFrameIndex();
+            if (index.has_value())
+            {
+                rndr->recorder2D()->DrawBitmap
+                (
+                /* bitmap               */ sheet.data.Get(),
+                /* destinationRectangle */ rect,
+                /* opacity              */ sheet.opacity,
+                /* interpolationMode    */ sheet.getInterpolationMode(),
+                /* sourceRectangle      */ &fanim.frames[index.value()]
+                );
+            }
+        }
+    }
+}
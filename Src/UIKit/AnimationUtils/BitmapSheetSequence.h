@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/AtlasUtils/TextureAtlas.h"
+
+#include "Renderer/FrameData/FrameSequence.h"
+
+#include "UIKit/BitmapObject.h"
+
+namespace d14engine::uikit::animation_utils
+{
+    // The frames are the source rectangles (in DIPs) in one sheet bitmap,
+    // so that an animation takes a single bitmap instead of one per frame
+    // (or shares a texture atlas with the other animations).
+
+    struct BitmapSheetSequence : renderer::FrameSequence<D2D1_RECT_F>
+    {
+        BitmapObject sheet = {};
+
+        // Splits the sheet into the frames of equal width from left to right.
+        void setSheet(BmpObjParam sheet, size_t frameCount);
+
+        // Takes the frames from the regions of the atlas in order.
+        void setSheet(BmpObjParam sheet, const std::vector<atlas_utils::UVRect>& frames);
+
+        void draw(renderer::Renderer* rndr, const D2D1_RECT_F& rect);
+    };
+}
@@ -7,6 +7,8 @@ namespace d14engine::uikit::appearance
     LabelArea::Appearance::Appearance()
     {
         hiliteRange.stroke.opacity = 0.0f;
+
+        searchMatch.background.opacity = 0.5f;
     }
 
     void LabelArea::Appearance::initialize()
@@ -14,11 +16,13 @@ namespace d14engine::uikit::appearance
         auto& light = (g_themeData[L"Light"] = {});
         {
             light.hiliteRange.background.color = D2D1::ColorF{ 0xadd6ff };
+            light.searchMatch.background.color = D2D1::ColorF{ 0xf8c05c };
             light.indicator.background.color = D2D1::ColorF{ 0x000000 };
         }
         auto& dark = (g_themeData[L"Dark"] = {});
         {
             dark.hiliteRange.background.color = D2D1::ColorF{ 0x264f78 };
+            dark.searchMatch.background.color = D2D1::ColorF{ 0x9e6a03 };
             dark.indicator.background.color = D2D1::ColorF{ 0xffffff };
         }
     }
@@ -28,6 +32,7 @@ namespace d14engine::uikit::appearance
         _D14_FIND_THEME_DATA(themeName);
 
         _D14_UPDATE_THEME_DATA_1(hiliteRange.background.color);
+        _D14_UPDATE_THEME_DATA_1(searchMatch.background.color);
         _D14_UPDATE_THEME_DATA_1(indicator.background.color);
     }
     _D14_SET_THEME_DATA_MAP_IMPL(LabelArea)
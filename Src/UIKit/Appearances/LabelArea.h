@@ -24,6 +24,12 @@ namespace d14engine::uikit::appearance
             }
             hiliteRange = {};
 
+            struct SearchMatch
+            {
+                SolidStyle background = {};
+            }
+            searchMatch = {};
+
             struct Indicator
             {
                 bool visibility = true;
@@ -54,6 +60,16 @@ namespace d14engine::uikit::appearance
                 }
                 hiliteRange = {};
 
+                struct SearchMatch
+                {
+                    struct Background
+                    {
+                        D2D1_COLOR_F color = {};
+                    }
+                    background = {};
+                }
+                searchMatch = {};
+
                 struct Indicator
                 {
                     struct Background
@@ -2,6 +2,7 @@
 
 #include "UIKit/Application.h"
 
+#include "Common/AssetArchive.h"
 #include "Common/CppLangUtils/PointerCompare.h"
 #include "Common/DirectXError.h"
 #include "Common/MathUtils/GDI.h"
@@ -52,6 +53,20 @@ namespace d14engine::uikit
             // Special note: AddDllDirectory only accepts absolute paths!
             THROW_IF_NULL(AddDllDirectory((exePath + libPath).c_str()));
         }
+        ///////////////////
+        // Asset Archive //
+        ///////////////////
+
+        if (!info.assetArchivePath.empty())
+        {
+            auto archive = std::make_shared<AssetArchive>();
+
+            // Falls back to the loose files if the archive is unavailable.
+            if (archive->open(info.assetArchivePath))
+            {
+                AssetArchive::mount(info.binaryPath, archive);
+            }
+        }
         ////////////////////
         // Initialization //
         ////////////////////
@@ -74,6 +89,11 @@ namespace d14engine::uikit
         // objects decide whether there's need to do the clearing.
 
         g_app = nullptr;
+
+        if (!createInfo.assetArchivePath.empty())
+        {
+            AssetArchive::unmount(createInfo.binaryPath);
+        }
     }
 
     void Application::initWin32Window()
@@ -227,6 +247,10 @@ namespace d14engine::uikit
         ShowWindow(m_win32Window, SW_SHOW);
         UpdateWindow(m_win32Window);
 
+        // The cursor icons shown so far are loaded on demand, and the rest
+        // (including the other themes) are decoded in the background.
+        m_cursor->preloadBasicIcons();
+
         MSG msg = {};
         while (true)
         {
@@ -917,6 +941,11 @@ if (app != nullptr) \
                 if (callback != app->m_threadCallbacks.end())
                 {
                     callback->second((ThreadEventData)lParam);
+
+                    // The callback usually updates the UI with the results
+                    // of the thread, which must be presented without waiting
+                    // for the next input event.
+                    InvalidateRect(hwnd, nullptr, FALSE);
                 }
             }
             return 0;
@@ -1161,6 +1190,11 @@ if (app != nullptr) \
         }
     }
 
+    LayerCache& Application::layerCache()
+    {
+        return m_layerCache;
+    }
+
     const Application::UIObjectSet& Application::uiObjects() const
     {
         return m_uiObjects;
@@ -7,6 +7,7 @@
 #include "Renderer/Renderer.h"
 
 #include "UIKit/Appearances/Appearance.h"
+#include "UIKit/LayerCache.h"
 
 namespace d14engine::uikit
 {
@@ -43,6 +44,14 @@ namespace d14engine::uikit
             {
                 return binaryPath + L"Cursors/";
             }
+            // The asset archive (if any) is mounted at the binary path, so the
+            // resources are read from it first and then from the loose files.
+            Wstring assetArchivePath = {};
+
+            // The enumerated system fonts are cached in this file and reused
+            // until a font is installed or removed (empty to disable the cache).
+            Wstring fontCachePath = {};
+
             Optional<float> dpi = {};
 
             // In Device-Independent-Pixel
@@ -191,6 +200,17 @@ namespace d14engine::uikit
         void increaseAnimationCount();
         void decreaseAnimationCount();
 
+        //------------------------------------------------------------------
+        // Layer Cache
+        //------------------------------------------------------------------
+    private:
+        LayerCache m_layerCache = {};
+
+    public:
+        // The surfaces of the panels in the cached-layer mode share the
+        // budget of this cache (see Panel::setCachedLayer).
+        LayerCache& layerCache();
+
         ////////////////////
         // UI Object Tree //
         ////////////////////
@@ -4,6 +4,7 @@
 
 #include "Common/CppLangUtils/FinallySemantic.h"
 #include "Common/DirectXError.h"
+#include "Common/PixelUtils/Premultiply.h"
 #include "Common/ResourcePack.h"
 
 #include "Renderer/GraphUtils/Bitmap.h"
@@ -177,4 +178,47 @@ namespace d14engine::uikit::bitmap_utils
         ));
         return bitmap;
     }
+
+    pixel_utils::Image decodeImage(WstrRefer imagePath)
+    {
+        // The straight alpha is decoded and premultiplied with SIMD here,
+        // which is cheaper than the conversion to PRGBA in WIC.
+        auto source = graph_utils::bitmap::load(imagePath, GUID_WICPixelFormat32bppRGBA);
+
+        pixel_utils::Image image = {};
+        THROW_IF_FAILED(source->GetSize(&image.width, &image.height));
+
+        image.pixels.resize(image.pitch() * image.height);
+
+        // The actual decoding happens here since the source is lazy.
+        THROW_IF_FAILED(source->CopyPixels
+        (
+        /* prc          */ nullptr,
+        /* cbStride     */ (UINT)image.pitch(),
+        /* cbBufferSize */ (UINT)image.pixels.size(),
+        /* pbBuffer     */ image.pixels.data()
+        ));
+        pixel_utils::premultiply(image.pixels.data(), (size_t)image.width * image.height);
+
+        return image;
+    }
+
+    pixel_utils::Image decodeThumbnail(WstrRefer imagePath, UINT maxWidth, UINT maxHeight, pixel_utils::Filter filter)
+    {
+        auto image = decodeImage(imagePath);
+
+        auto size = pixel_utils::fitSize(image.width, image.height, maxWidth, maxHeight);
+        if (size.first == image.width && size.second == image.height)
+        {
+            return image;
+        }
+        return pixel_utils::resample(image.view(), size.first, size.second, filter);
+    }
+
+    ComPtr<ID2D1Bitmap1> loadThumbnail(WstrRefer imagePath, UINT maxWidth, UINT maxHeight, pixel_utils::Filter filter, D2D1_BITMAP_OPTIONS options)
+    {
+        auto image = decodeThumbnail(imagePath, maxWidth, maxHeight, filter);
+
+        return loadBitmap(image.width, image.height, image.pixels.data(), options);
+    }
 }
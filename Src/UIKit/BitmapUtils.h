@@ -2,6 +2,9 @@
 
 #include "Common/Precompile.h"
 
+#include "Common/PixelUtils/Image.h"
+#include "Common/PixelUtils/Resample.h"
+
 namespace d14engine::uikit::bitmap_utils
 {
     void saveBitmap(ID2D1Bitmap1* image, WstrRefer imagePath, const GUID& format = GUID_ContainerFormatPng);
@@ -11,4 +14,26 @@ namespace d14engine::uikit::bitmap_utils
     ComPtr<ID2D1Bitmap1> loadBitmap(WstrRefer imagePath, D2D1_BITMAP_OPTIONS options = D2D1_BITMAP_OPTIONS_NONE);
 
     ComPtr<ID2D1Bitmap1> loadPackedBitmap(WstrRefer resName, WstrRefer resType = L"PNG", D2D1_BITMAP_OPTIONS options = D2D1_BITMAP_OPTIONS_NONE);
+
+    // Decodes the image into premultiplied R8G8B8A8 pixels, which never
+    // touches the renderer either (see decodeThumbnail).
+    pixel_utils::Image decodeImage(WstrRefer imagePath);
+
+    // Decodes the image and scales it down to fit in the bounds (keeping
+    // the aspect ratio), and the pixels are premultiplied R8G8B8A8.
+    //
+    // This never touches the renderer, so it can be called in a worker
+    // thread (after graph_utils::bitmap::initializeWorkerThread).
+    pixel_utils::Image decodeThumbnail(
+        WstrRefer imagePath,
+        UINT maxWidth,
+        UINT maxHeight,
+        pixel_utils::Filter filter = pixel_utils::Filter::Mitchell);
+
+    ComPtr<ID2D1Bitmap1> loadThumbnail(
+        WstrRefer imagePath,
+        UINT maxWidth,
+        UINT maxHeight,
+        pixel_utils::Filter filter = pixel_utils::Filter::Mitchell,
+        D2D1_BITMAP_OPTIONS options = D2D1_BITMAP_OPTIONS_NONE);
 }
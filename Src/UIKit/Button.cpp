@@ -114,7 +114,7 @@ namespace d14engine::uikit
         auto rect = math_utils::inner(m_absoluteRect, stroke.width);
         D2D1_ROUNDED_RECT roundedRect = { rect, roundRadiusX, roundRadiusY };
 
-        rndr->d2d1DeviceContext()->DrawRoundedRectangle
+        rndr->recorder2D()->DrawRoundedRectangle
         (
         /* roundedRect */ roundedRect,
         /* brush       */ resource_utils::solidColorBrush(),
@@ -76,6 +76,8 @@ namespace d14engine::uikit
 
     void CheckBox::setCheckState(CheckState state)
     {
+        if (m_state.activeFlag != state) invalidate();
+
         m_state.activeFlag = state;
 
         StatefulObject::Event soe = {};
@@ -90,6 +92,8 @@ namespace d14engine::uikit
 
     void CheckBox::setCheckStateSilently(CheckState state)
     {
+        if (m_state.activeFlag != state) invalidate();
+
         m_state.activeFlag = state;
         m_stateDetail.flag = m_state.activeFlag;
     }
@@ -161,7 +165,7 @@ namespace d14engine::uikit
             resource_utils::solidColorBrush()->SetColor(background.color);
             resource_utils::solidColorBrush()->SetOpacity(background.opacity);
 
-            rndr->d2d1DeviceContext()->FillRectangle
+            rndr->recorder2D()->FillRectangle
             (
             /* rect  */ math_utils::centered(m_absoluteRect, geoSetting.size),
             /* brush */ resource_utils::solidColorBrush()
@@ -178,7 +182,7 @@ namespace d14engine::uikit
 
             auto iconLeftTop = absolutePosition();
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(iconLeftTop, geoSetting.tickLine0.point0),
             /* point1      */ math_utils::offset(iconLeftTop, geoSetting.tickLine0.point1),
@@ -186,7 +190,7 @@ namespace d14engine::uikit
             /* strokeWidth */ geoSetting.strokeWidth,
             /* strokeStyle */ checkedIcon.strokeStyle.Get()
             );
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(iconLeftTop, geoSetting.tickLine1.point0),
             /* point1      */ math_utils::offset(iconLeftTop, geoSetting.tickLine1.point1),
@@ -210,7 +214,7 @@ namespace d14engine::uikit
         auto rect = math_utils::inner(m_absoluteRect, stroke.width);
         D2D1_ROUNDED_RECT roundedRect = { rect, roundRadiusX, roundRadiusY };
 
-        rndr->d2d1DeviceContext()->DrawRoundedRectangle
+        rndr->recorder2D()->DrawRoundedRectangle
         (
         /* roundedRect */ roundedRect,
         /* brush       */ resource_utils::solidColorBrush(),
@@ -6,6 +6,8 @@ namespace d14engine::uikit
 {
     void ClickablePanel::onMouseButtonPress(Event& e)
     {
+        invalidate();
+
         onMouseButtonPressHelper(e);
 
         if (f_onMouseButtonPress) f_onMouseButtonPress(this, e);
@@ -13,6 +15,8 @@ namespace d14engine::uikit
 
     void ClickablePanel::onMouseButtonRelease(Event& e)
     {
+        invalidate();
+
         onMouseButtonReleaseHelper(e);
 
         if (f_onMouseButtonRelease) f_onMouseButtonRelease(this, e);
@@ -153,7 +153,7 @@ namespace d14engine::uikit
 
         auto arrowOrigin = math_utils::rightTop(m_absoluteRect);
 
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ math_utils::offset(arrowOrigin, arrowGeometry.line0.point0),
         /* point1      */ math_utils::offset(arrowOrigin, arrowGeometry.line0.point1),
@@ -161,7 +161,7 @@ namespace d14engine::uikit
         /* strokeWidth */ arrowSetting.strokeWidth,
         /* strokeStyle */ arrowIcon.strokeStyle.Get()
         );
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ math_utils::offset(arrowOrigin, arrowGeometry.line1.point0),
         /* point1      */ math_utils::offset(arrowOrigin, arrowGeometry.line1.point1),
@@ -5,6 +5,8 @@
 #include "Common/MathUtils/2D.h"
 #include "Common/RuntimeError.h"
 
+#include "Renderer/GraphUtils/Bitmap.h"
+
 #include "UIKit/Application.h"
 #include "UIKit/BitmapUtils.h"
 #include "UIKit/FileSystemUtils.h"
@@ -14,10 +16,46 @@ using namespace fanim_literals;
 
 namespace d14engine::uikit
 {
+    namespace
+    {
+        struct BasicIconInfo
+        {
+            // A dynamic icon is named after the directory of the frames.
+            const WCHAR* name = nullptr;
+            D2D1_POINT_2F hotSpotOffset = {};
+        };
+        // In the order of StaticIconIndex.
+        const BasicIconInfo g_staticIconInfos[] =
+        {
+            { L"Alternate", { 30.0f, 0.0f } },
+            { L"Arrow",     { 2.0f, 0.0f } },
+            { L"BackDiag",  { 16.0f, 16.0f } },
+            { L"Hand",      { 3.0f, 3.0f } },
+            { L"Help",      { 3.0f, 3.0f } },
+            { L"HorzSize",  { 16.0f, 16.0f } },
+            { L"MainDiag",  { 16.0f, 16.0f } },
+            { L"Move",      { 16.0f, 16.0f } },
+            { L"Person",    { 2.0f, 0.0f } },
+            { L"Pin",       { 2.0f, 0.0f } },
+            { L"Select",    { 16.0f, 16.0f } },
+            { L"Stop",      { 2.0f, 0.0f } },
+            { L"Text",      { 16.0f, 16.0f } },
+            { L"VertSize",  { 16.0f, 16.0f } }
+        };
+        // In the order of DynamicIconIndex.
+        const BasicIconInfo g_dynamicIconInfos[] =
+        {
+            { L"Busy/",    { 16.0f, 16.0f } },
+            { L"Working/", { 2.0f, 0.0f } }
+        };
+        const WCHAR* g_basicThemeNames[] = { L"Light", L"Dark" };
+    }
+
     Cursor::Cursor(const BasicIconThemeMap& icons, const D2D1_RECT_F& rect)
         :
         Panel(rect),
-        m_classifiedBasicIcons(icons)
+        m_classifiedBasicIcons(icons),
+        m_basicIconCache(makeBasicIconSource())
     {
         // Keep the cursor always displayed at the top.
         ISortable<IDrawObject2D>::m_priority = INT_MAX;
@@ -43,116 +81,110 @@ namespace d14engine::uikit
         // since the cursor should always be displayed at the top.
     }
 
-    Cursor::BasicIconThemeMap Cursor::loadBasicIcons()
+    image_utils::IconCache::Source Cursor::makeBasicIconSource()
     {
-        return
+        THROW_IF_NULL(Application::g_app);
+
+        return [cursorPath = Application::g_app->createInfo.cursorPath()]
+        (WstrRefer themeName, WstrRefer iconName)
         {
-            { L"Light", loadBasicIconSeries(L"Light") },
-            { L"Dark", loadBasicIconSeries(L"Dark") }
+            return loadBasicIconImage(cursorPath + themeName + L"/" + iconName);
         };
     }
 
-    Cursor::IconSeries Cursor::loadBasicIconSeries(WstrRefer themeName)
+    Optional<image_utils::IconCache::Icon> Cursor::loadBasicIconImage(WstrRefer iconPath)
     {
-        THROW_IF_NULL(Application::g_app);
+        // This is also called in the worker thread of the preload, and it
+        // has no effect on the UI thread that has initialized COM already.
+        graph_utils::bitmap::initializeWorkerThread();
 
-        IconSeries icons = {};
+        if (!iconPath.ends_with(L'/'))
+        {
+            return image_utils::IconCache::Icon{ bitmap_utils::decodeImage(iconPath + L".png") };
+        }
+        // The frames are named after the indices (starting from 1).
+        std::map<int, pixel_utils::Image> frames = {};
 
-        auto cursorPath = Application::g_app->createInfo.cursorPath() + themeName + L"/";
+        file_system_utils::foreachFileInDir
+        (iconPath, L"*.png", [&](WstrRefer path)
+        {
+            auto name = file_system_utils::extractFilePrefix(
+                        file_system_utils::extractFileName(path));
 
-        ////////////////////////
-        // Load static icons. //
-        ////////////////////////
+            frames[std::stoi(name)] = bitmap_utils::decodeImage(path);
 
-#define DEF_STATIC_ICON(Name, ...) { StaticIconIndex::Name, L#Name L".png ", __VA_ARGS__ }
+            return false;
+        });
+        if (frames.empty()) return std::nullopt;
 
-        std::tuple<StaticIconIndex, Wstring, D2D1_POINT_2F> staticIconPaths[] =
+        std::vector<pixel_utils::Image> sequence = {};
+        for (auto& f : frames)
         {
-            DEF_STATIC_ICON(Alternate, { 30.0f, 0.0f }),
-            DEF_STATIC_ICON(Arrow,     { 2.0f, 0.0f }),
-            DEF_STATIC_ICON(BackDiag,  { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(Hand,      { 3.0f, 3.0f }),
-            DEF_STATIC_ICON(Help,      { 3.0f, 3.0f }),
-            DEF_STATIC_ICON(HorzSize,  { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(MainDiag,  { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(Move,      { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(Person,    { 2.0f, 0.0f }),
-            DEF_STATIC_ICON(Pin,       { 2.0f, 0.0f }),
-            DEF_STATIC_ICON(Select,    { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(Stop,      { 2.0f, 0.0f }),
-            DEF_STATIC_ICON(Text,      { 16.0f, 16.0f }),
-            DEF_STATIC_ICON(VertSize,  { 16.0f, 16.0f })
-        };
-
-#undef DEF_STATIC_ICON
+            sequence.push_back(std::move(f.second));
+        }
+        return image_utils::IconCache::packFrames(sequence);
+    }
 
-        for (auto& path : staticIconPaths)
+    Cursor::StaticIcon& Cursor::getBasicIcon(WstrRefer themeName, StaticIconIndex index)
+    {
+        auto& icon = m_classifiedBasicIcons[themeName].staticIcons[(size_t)index];
+        if (!icon.bitmapData.data)
         {
-            icons.staticIcons[(size_t)std::get<0>(path)] =
+            auto& info = g_staticIconInfos[(size_t)index];
+
+            auto image = m_basicIconCache.find(themeName, info.name);
+            if (image != nullptr)
             {
-                bitmap_utils::loadBitmap(cursorPath + std::get<1>(path)),
-                std::get<2>(path) // hot spot offset
-            };
+                auto& sheet = image->sheet;
+                icon.bitmapData = bitmap_utils::loadBitmap(sheet.width, sheet.height, (BYTE*)sheet.pixels.data());
+                icon.hotSpotOffset = info.hotSpotOffset;
+            }
         }
-
-        /////////////////////////
-        // Load dynamic icons. //
-        /////////////////////////
-
-#define LOAD_DYNAMIC_ICON(Name, ...) \
-do { \
-    auto frames = loadBasicIconFrames(cursorPath + L#Name L"/"); \
-    frames.hotSpotOffset = __VA_ARGS__; \
-    icons.dynamicIcons[(size_t)DynamicIconIndex::Name] = std::move(frames); \
-} while (0)
-
-        LOAD_DYNAMIC_ICON(Busy,    { 16.0f, 16.0f });
-        LOAD_DYNAMIC_ICON(Working, { 2.0f, 0.0f });
-
-#undef LOAD_DYNAMIC_ICON
-
-        return icons;
+        return icon;
     }
 
-    Cursor::DynamicIcon Cursor::loadBasicIconFrames(WstrRefer framesPath)
+    Cursor::DynamicIcon& Cursor::getBasicIcon(WstrRefer themeName, DynamicIconIndex index)
     {
-        DynamicIcon icon = {};
-
-        /////////////////
-        // Load Images //
-        /////////////////
-
-        animation_utils::BitmapSequence::FramePackage frames = {};
-
-        file_system_utils::foreachFileInDir
-        (framesPath, L"*.png", [&](WstrRefer path)
+        auto& icon = m_classifiedBasicIcons[themeName].dynamicIcons[(size_t)index];
+        if (!icon.bitmapData.sheet.data)
         {
-            auto name = file_system_utils::extractFilePrefix(
-                        file_system_utils::extractFileName(path));
+            auto& info = g_dynamicIconInfos[(size_t)index];
 
-            frames[name] = bitmap_utils::loadBitmap(path);
-
-            return false;
-        });
+            auto image = m_basicIconCache.find(themeName, info.name);
+            if (image != nullptr)
+            {
+                auto& sheet = image->sheet;
+                icon.bitmapData.setSheet(bitmap_utils::loadBitmap(sheet.width, sheet.height, (BYTE*)sheet.pixels.data()), image->frameCount);
+                icon.bitmapData.fanim.timeSpanDataInSecs = 2_jf;
+                icon.hotSpotOffset = info.hotSpotOffset;
+            }
+        }
+        return icon;
+    }
 
-        //////////////////
-        // Setup Frames //
-        //////////////////
+    void Cursor::preloadBasicIcons()
+    {
+        THROW_IF_NULL(Application::g_app);
 
-        auto& fanim = icon.bitmapData.fanim;
+        std::vector<Wstring> iconNames = {};
+        for (auto& info : g_staticIconInfos)
+        {
+            iconNames.push_back(info.name);
+        }
+        for (auto& info : g_dynamicIconInfos)
+        {
+            iconNames.push_back(info.name);
+        }
+        auto& currThemeName = Application::g_app->themeStyle().name;
+        m_basicIconCache.preload(currThemeName, iconNames);
 
-        fanim.frames.resize(frames.size());
-        for (auto& f : frames)
+        for (auto& themeName : g_basicThemeNames)
         {
-            auto index = (size_t)(std::stoi(f.first) - 1);
-            if (index >= 0_uz && index < fanim.frames.size())
+            if (themeName != currThemeName)
             {
-                fanim.frames[index] = f.second;
+                m_basicIconCache.preload(themeName, iconNames);
             }
         }
-        fanim.timeSpanDataInSecs = 2_jf;
-
-        return icon;
     }
 
     void Cursor::registerIcon(WstrRefer themeName, StaticIconIndex index, const StaticIcon& icon)
@@ -302,10 +334,9 @@ do { \
         THROW_IF_NULL(Application::g_app);
 
         auto& iconID = std::get<g_staticIconSeat>(m_selectedIconID);
-        auto& basicIcons = m_classifiedBasicIcons.at(Application::g_app->themeStyle().name);
 
         return (iconID.index() == g_basicIconSeat) ?
-            basicIcons.staticIcons[(size_t)std::get<g_basicIconSeat>(iconID)] :
+            getBasicIcon(Application::g_app->themeStyle().name, std::get<g_basicIconSeat>(iconID)) :
             m_customIcons.staticIcons[std::get<g_customIconSeat>(iconID)];
     }
 
@@ -314,10 +345,9 @@ do { \
         THROW_IF_NULL(Application::g_app);
 
         auto& iconID = std::get<g_dynamicIconSeat>(m_selectedIconID);
-        auto& basicIcons = m_classifiedBasicIcons.at(Application::g_app->themeStyle().name);
 
         return (iconID.index() == g_basicIconSeat) ?
-            basicIcons.dynamicIcons[(size_t)std::get<g_basicIconSeat>(iconID)] :
+            getBasicIcon(Application::g_app->themeStyle().name, std::get<g_basicIconSeat>(iconID)) :
             m_customIcons.dynamicIcons[std::get<g_customIconSeat>(iconID)];
     }
 
@@ -357,13 +387,16 @@ do { \
                 auto rect = math_utils::offset(m_absoluteRect, hs);
 
                 auto& bmpobj = icon.bitmapData;
-                rndr->d2d1DeviceContext()->DrawBitmap
-                (
-                /* bitmap               */ bmpobj.data.Get(),
-                /* destinationRectangle */ rect,
-                /* opacity              */ bmpobj.opacity,
-                /* interpolationMode    */ bmpobj.getInterpolationMode()
-                );
+                if (bmpobj.data)
+                {
+                    rndr->recorder2D()->DrawBitmap
+                    (
+                    /* bitmap               */ bmpobj.data.Get(),
+                    /* destinationRectangle */ rect,
+                    /* opacity              */ bmpobj.opacity,
+                    /* interpolationMode    */ bmpobj.getInterpolationMode()
+                    );
+                }
             }
             else if (m_selectedIconID.index() == g_dynamicIconSeat)
             {
@@ -4,7 +4,8 @@
 
 #include "Common/CppLangUtils/EnumMagic.h"
 
-#include "UIKit/AnimationUtils/BitmapSequence.h"
+#include "UIKit/AnimationUtils/BitmapSheetSequence.h"
+#include "UIKit/ImageUtils/IconCache.h"
 #include "UIKit/Panel.h"
 
 namespace d14engine::uikit
@@ -55,7 +56,7 @@ namespace d14engine::uikit
             D2D1_POINT_2F hotSpotOffset = {};
         };
         using StaticIcon = Icon<BitmapObject>;
-        using DynamicIcon = Icon<animation_utils::BitmapSequence>;
+        using DynamicIcon = Icon<animation_utils::BitmapSheetSequence>;
 
         using StaticIconMap = cpp_lang_utils::EnumMap<StaticIconIndex, StaticIcon>;
         using DynamicIconMap = cpp_lang_utils::EnumMap<DynamicIconIndex, DynamicIcon>;
@@ -67,20 +68,33 @@ namespace d14engine::uikit
         };
         using BasicIconThemeMap = std::unordered_map<Wstring, IconSeries>;
 
+        // The basic icons missing in the map are loaded from the cursor
+        // path on demand, i.e. when each of them is shown for the first time.
         Cursor(
-            const BasicIconThemeMap& icons = loadBasicIcons(),
+            const BasicIconThemeMap& icons = {},
             const D2D1_RECT_F& rect = { 0.0f, 0.0f, 32.0f, 32.0f });
 
         void onInitializeFinish() override;
 
     protected:
-        static BasicIconThemeMap loadBasicIcons();
+        BasicIconThemeMap m_classifiedBasicIcons = {};
 
-        static IconSeries loadBasicIconSeries(WstrRefer themeName);
-        static DynamicIcon loadBasicIconFrames(WstrRefer framesPath);
+        // Holds the decoded pixels of the basic icons, and the bitmaps are
+        // created from them in m_classifiedBasicIcons on the UI thread.
+        image_utils::IconCache m_basicIconCache;
 
-    protected:
-        BasicIconThemeMap m_classifiedBasicIcons = {};
+        static image_utils::IconCache::Source makeBasicIconSource();
+
+        // The path of a dynamic icon is the directory of the frames.
+        static Optional<image_utils::IconCache::Icon> loadBasicIconImage(WstrRefer iconPath);
+
+        StaticIcon& getBasicIcon(WstrRefer themeName, StaticIconIndex index);
+        DynamicIcon& getBasicIcon(WstrRefer themeName, DynamicIconIndex index);
+
+    public:
+        // Decodes the basic icons of all the themes in a worker thread (the
+        // current theme first), which is started after the first frame.
+        void preloadBasicIcons();
 
         template<typename T>
         using IconLibrary = std::unordered_map<Wstring, T>;
@@ -36,7 +36,7 @@ namespace d14engine::uikit
     {
         FilledButton::onRendererDrawD2d1LayerHelper(rndr);
 
-        shadow.beginDraw(rndr->d2d1DeviceContext());
+        shadow.beginDraw(rndr->recorder2D());
         {
             auto& shadowSetting = appearance().shadow;
 
@@ -47,13 +47,13 @@ namespace d14engine::uikit
                 math_utils::moveVertex(selfCoordRect(), shadowSetting.offset),
                 roundRadiusX, roundRadiusY
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
             );
         }
-        shadow.endDraw(rndr->d2d1DeviceContext());
+        shadow.endDraw(rndr->recorder2D());
     }
 
     void ElevatedButton::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
@@ -69,7 +69,7 @@ namespace d14engine::uikit
 
         shadow.configEffectInput(resource_utils::shadowEffect());
 
-        rndr->d2d1DeviceContext()->DrawImage
+        rndr->recorder2D()->DrawImage
         (
         /* effect       */ resource_utils::shadowEffect(),
         /* targetOffset */ absolutePosition()
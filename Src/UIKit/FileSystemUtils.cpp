@@ -2,6 +2,8 @@
 
 #include "UIKit/FileSystemUtils.h"
 
+#include "Common/AssetArchive.h"
+
 namespace d14engine::file_system_utils
 {
     Wstring extractFileName(WstrRefer path)
@@ -44,6 +46,22 @@ namespace d14engine::file_system_utils
 
     bool foreachFileInDir(WstrRefer dir, WstrRefer wildcard, const FileOperationFunc& func)
     {
+        // The mounted asset archives take precedence over the loose files,
+        // and only the files directly in the directory are matched.
+        auto archivedNames = AssetArchive::resolveList(dir);
+        if (!archivedNames.empty())
+        {
+            for (auto& fileName : archivedNames)
+            {
+                if (fileName.find(L'/') != Wstring::npos) continue;
+
+                if (PathMatchSpecW(fileName.c_str(), wildcard.c_str()))
+                {
+                    if (func(dir + fileName)) break;
+                }
+            }
+            return true;
+        }
         WIN32_FIND_DATA findData = {};
         auto handle = FindFirstFileW((dir + wildcard).c_str(), &findData);
         if (handle == INVALID_HANDLE_VALUE)
@@ -309,7 +309,7 @@ namespace d14engine::uikit
 
         if (icon.bitmap.data)
         {
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ icon.bitmap.data.Get(),
             /* destinationRectangle */ selfCoordToAbsolute(icon.rect),
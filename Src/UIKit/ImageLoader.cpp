@@ -0,0 +1,190 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageLoader.h"
+
+#include "Common/DirectXError.h"
+
+#include "Renderer/GraphUtils/Bitmap.h"
+
+#include "UIKit/Application.h"
+#include "UIKit/BitmapUtils.h"
+#include "UIKit/Panel.h"
+
+using namespace d14engine::renderer;
+
+namespace d14engine::uikit
+{
+    ImageLoader::ImageLoader(size_t threadCount)
+        :
+        m_queue([this](const image_utils::DecodeQueue::Request& request)
+        {
+            return decode(request);
+        },
+        threadCount, [this]
+        {
+            // Called in the worker threads.
+            auto app = Application::g_app;
+            if (app != nullptr)
+            {
+                app->triggerThreadEvent((Application::ThreadEventID)this);
+            }
+        })
+    {
+        THROW_IF_NULL(Application::g_app);
+
+        Application::g_app->registerThreadCallback(
+            (Application::ThreadEventID)this,
+            [this](Application::ThreadEventData data)
+        {
+            deliverResults();
+        });
+    }
+
+    ImageLoader::~ImageLoader()
+    {
+        if (Application::g_app != nullptr)
+        {
+            Application::g_app->unregisterThreadCallback((Application::ThreadEventID)this);
+        }
+        // The workers only finish the images being decoded before exiting.
+        m_queue.cancelAll();
+    }
+
+    size_t ImageLoader::defaultThreadCount()
+    {
+        // Leaves some cores for the UI thread and the renderer.
+        return std::max(std::thread::hardware_concurrency() / 2, 1u);
+    }
+
+    ImageLoader::Ticket ImageLoader::load(WstrRefer imagePath, const Callback& callback, Priority priority)
+    {
+        auto ticket = m_queue.submit({ imagePath }, priority);
+        m_callbacks[ticket] = callback;
+        return ticket;
+    }
+
+    ImageLoader::Ticket ImageLoader::load(
+        WstrRefer imagePath,
+        ShrdPtrRefer<Panel> target,
+        ComPtrParam<ID2D1Bitmap1> placeholder,
+        Priority priority)
+    {
+        if (placeholder) target->bitmap = placeholder;
+
+        return load(imagePath, [target = (WeakPtr<Panel>)target]
+        (ComPtrParam<ID2D1Bitmap1> bitmap)
+        {
+            if (bitmap && !target.expired())
+            {
+                target.lock()->bitmap = bitmap;
+            }
+        },
+        priority);
+    }
+
+    ImageLoader::Ticket ImageLoader::loadThumbnail(
+        WstrRefer imagePath,
+        UINT maxWidth,
+        UINT maxHeight,
+        const Callback& callback,
+        Priority priority)
+    {
+        // Keeps the region nonzero even for the degenerated bounds.
+        maxWidth = std::max(maxWidth, 1u);
+        maxHeight = std::max(maxHeight, 1u);
+
+        auto region = (uint64_t)maxWidth << 32 | maxHeight;
+
+        auto ticket = m_queue.submit({ imagePath, region }, priority);
+        m_callbacks[ticket] = callback;
+        return ticket;
+    }
+
+    bool ImageLoader::setPriority(Ticket ticket, Priority priority)
+    {
+        return m_queue.setPriority(ticket, priority);
+    }
+
+    void ImageLoader::cancel(Ticket ticket)
+    {
+        m_queue.cancel(ticket);
+        m_callbacks.erase(ticket);
+    }
+
+    void ImageLoader::cancelAll()
+    {
+        m_queue.cancelAll();
+        m_callbacks.clear();
+    }
+
+    image_utils::DecodeQueue::Image ImageLoader::decode(const image_utils::DecodeQueue::Request& request)
+    {
+        graph_utils::bitmap::initializeWorkerThread();
+
+        if (request.region != 0)
+        {
+            auto maxWidth = (UINT)(request.region >> 32);
+            auto maxHeight = (UINT)request.region;
+
+            Optional<image_utils::ThumbnailStore::Key> key = {};
+            if (thumbnailStore)
+            {
+                key = image_utils::ThumbnailStore::makeKey(request.path, maxWidth, maxHeight);
+            }
+            Optional<pixel_utils::Image> thumbnail = {};
+            if (key.has_value())
+            {
+                thumbnail = thumbnailStore->find(key.value());
+            }
+            if (!thumbnail.has_value())
+            {
+                thumbnail = bitmap_utils::decodeThumbnail(request.path, maxWidth, maxHeight);
+
+                if (key.has_value())
+                {
+                    thumbnailStore->insert(key.value(), thumbnail->view());
+                }
+            }
+            return { thumbnail->width, thumbnail->height, std::move(thumbnail->pixels) };
+        }
+        // Uses the same pixel format as bitmap_utils::loadBitmap.
+        auto source = graph_utils::bitmap::load(request.path);
+
+        image_utils::DecodeQueue::Image image = {};
+        THROW_IF_FAILED(source->GetSize(&image.width, &image.height));
+
+        auto pitch = 4 * image.width;
+        image.pixels.resize((size_t)pitch * image.height);
+
+        // The actual decoding happens here since the source is lazy.
+        THROW_IF_FAILED(source->CopyPixels
+        (
+        /* prc          */ nullptr,
+        /* cbStride     */ pitch,
+        /* cbBufferSize */ (UINT)image.pixels.size(),
+        /* pbBuffer     */ image.pixels.data()
+        ));
+        return image;
+    }
+
+    void ImageLoader::deliverResults()
+    {
+        for (auto& result : m_queue.takeResults())
+        {
+            auto itor = m_callbacks.find(result.ticket);
+            if (itor == m_callbacks.end()) continue;
+
+            // The callback may load or cancel other images.
+            auto callback = std::move(itor->second);
+            m_callbacks.erase(itor);
+
+            ComPtr<ID2D1Bitmap1> bitmap = {};
+            if (result.image.has_value())
+            {
+                auto& image = result.image.value();
+                bitmap = bitmap_utils::loadBitmap(image.width, image.height, image.pixels.data());
+            }
+            if (callback) callback(bitmap);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/DecodeQueue.h"
+#include "UIKit/ImageUtils/ThumbnailStore.h"
+
+namespace d14engine::uikit
+{
+    struct Panel;
+
+    // Loads images without blocking the UI thread: the files are decoded
+    // in a pool of worker threads, and the bitmaps are created and handed
+    // over to the callbacks in the UI thread as the decoded pixels arrive.
+    //
+    // Typical usage for a list of thumbnails: load each item with a low
+    // priority, boost the ones on the screen with g_visiblePriority, and
+    // cancel the ones that scroll away before they are decoded.
+
+    struct ImageLoader : cpp_lang_utils::NonCopyable
+    {
+        explicit ImageLoader(size_t threadCount = defaultThreadCount());
+
+        virtual ~ImageLoader();
+
+        static size_t defaultThreadCount();
+
+        using Ticket = image_utils::DecodeQueue::Ticket;
+        using Priority = image_utils::DecodeQueue::Priority;
+
+        constexpr static Priority g_visiblePriority = 100;
+
+        // Called in the UI thread, and the bitmap is nullptr if failed.
+        using Callback = Function<void(ComPtrParam<ID2D1Bitmap1> bitmap)>;
+
+        Ticket load(WstrRefer imagePath, const Callback& callback, Priority priority = 0);
+
+        // The placeholder (if any) is shown in the panel at once, and is
+        // replaced by the decoded image if the panel is still alive then.
+        Ticket load(
+            WstrRefer imagePath,
+            ShrdPtrRefer<Panel> target,
+            ComPtrParam<ID2D1Bitmap1> placeholder = nullptr,
+            Priority priority = 0);
+
+        // Looked up (and filled) by the thumbnail loading in the workers,
+        // so it should be set before loading any thumbnail.
+        SharedPtr<image_utils::ThumbnailStore> thumbnailStore = {};
+
+        // The image is scaled down to fit in the bounds in the worker thread
+        // (see bitmap_utils::decodeThumbnail), which suits the list items.
+        Ticket loadThumbnail(
+            WstrRefer imagePath,
+            UINT maxWidth,
+            UINT maxHeight,
+            const Callback& callback,
+            Priority priority = 0);
+
+        // Returns false if the image is being decoded or decoded already.
+        bool setPriority(Ticket ticket, Priority priority);
+
+        // The callback of a cancelled ticket is never called.
+        void cancel(Ticket ticket);
+        void cancelAll();
+
+    protected:
+        image_utils::DecodeQueue m_queue;
+
+        std::unordered_map<Ticket, Callback> m_callbacks = {};
+
+        // The region of a thumbnail request packs the bounds, i.e.
+        // (maxWidth << 32 | maxHeight), and 0 stands for the full image.
+        image_utils::DecodeQueue::Image decode(const image_utils::DecodeQueue::Request& request);
+
+        // Called in the UI thread when some results are available.
+        void deliverResults();
+    };
+}
@@ -0,0 +1,195 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/DecodeQueue.h"
+
+namespace d14engine::uikit::image_utils
+{
+    DecodeQueue::DecodeQueue(const Decoder& decoder, size_t threadCount, const Notifier& notifier)
+        :
+        m_decoder(decoder),
+        m_notifier(notifier)
+    {
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            m_workers.emplace_back([this]
+            {
+                while (true)
+                {
+                    Optional<std::pair<Ticket, Request>> task = {};
+                    {
+                        std::unique_lock lock(m_mutex);
+
+                        m_condition.wait(lock, [this]
+                        {
+                            return m_stopped || !m_queue.empty();
+                        });
+                        if (m_stopped) break;
+                    }
+                    // Another worker may have taken the task in between.
+                    if ((task = popTask()).has_value())
+                    {
+                        runTask(task->first, task->second);
+                    }
+                }
+            });
+        }
+    }
+
+    DecodeQueue::~DecodeQueue()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+
+            m_stopped = true;
+            m_queue.clear();
+        }
+        m_condition.notify_all();
+
+        for (auto& worker : m_workers)
+        {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    Optional<std::pair<DecodeQueue::Ticket, DecodeQueue::Request>> DecodeQueue::popTask()
+    {
+        std::lock_guard lock(m_mutex);
+
+        if (m_queue.empty()) return std::nullopt;
+
+        auto ticket = m_queue.begin()->second;
+        m_queue.erase(m_queue.begin());
+
+        auto& task = m_tasks.at(ticket);
+        task.state = State::Decoding;
+
+        return std::make_pair(ticket, task.request);
+    }
+
+    void DecodeQueue::runTask(Ticket ticket, const Request& request)
+    {
+        Result result = { ticket, request };
+        try
+        {
+            result.image = m_decoder(request);
+        }
+        catch (...)
+        {
+            result.error = std::current_exception();
+        }
+        {
+            std::lock_guard lock(m_mutex);
+
+            // The task has been cancelled while being decoded.
+            auto itor = m_tasks.find(ticket);
+            if (itor == m_tasks.end()) return;
+
+            itor->second.state = State::Finished;
+            m_results.push_back(std::move(result));
+        }
+        if (m_notifier) m_notifier();
+    }
+
+    DecodeQueue::Ticket DecodeQueue::submit(const Request& request, Priority priority)
+    {
+        Ticket ticket = {};
+        {
+            std::lock_guard lock(m_mutex);
+
+            ticket = ++m_lastTicket;
+
+            m_tasks[ticket] = { request, priority };
+            m_queue.insert({ priority, ticket });
+        }
+        m_condition.notify_one();
+
+        return ticket;
+    }
+
+    bool DecodeQueue::setPriority(Ticket ticket, Priority priority)
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto itor = m_tasks.find(ticket);
+        if (itor == m_tasks.end() || itor->second.state != State::Pending)
+        {
+            return false;
+        }
+        auto& task = itor->second;
+
+        m_queue.erase({ task.priority, ticket });
+        task.priority = priority;
+        m_queue.insert({ task.priority, ticket });
+
+        return true;
+    }
+
+    void DecodeQueue::cancel(Ticket ticket)
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto itor = m_tasks.find(ticket);
+        if (itor == m_tasks.end()) return;
+
+        auto& task = itor->second;
+        if (task.state == State::Pending)
+        {
+            m_queue.erase({ task.priority, ticket });
+        }
+        else if (task.state == State::Finished)
+        {
+            std::erase_if(m_results, [&](const Result& result)
+            {
+                return result.ticket == ticket;
+            });
+        }
+        // A decoding task finds itself missing when it finishes.
+        m_tasks.erase(itor);
+    }
+
+    void DecodeQueue::cancelAll()
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_tasks.clear();
+        m_queue.clear();
+        m_results.clear();
+    }
+
+    DecodeQueue::State DecodeQueue::state(Ticket ticket) const
+    {
+        std::lock_guard lock(m_mutex);
+
+        auto itor = m_tasks.find(ticket);
+        return itor != m_tasks.end() ? itor->second.state : State::Unknown;
+    }
+
+    size_t DecodeQueue::pendingCount() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return m_queue.size();
+    }
+
+    DecodeQueue::ResultArray DecodeQueue::takeResults()
+    {
+        std::lock_guard lock(m_mutex);
+
+        for (auto& result : m_results)
+        {
+            m_tasks.erase(result.ticket);
+        }
+        return std::exchange(m_results, {});
+    }
+
+    bool DecodeQueue::decodeNext()
+    {
+        auto task = popTask();
+        if (task.has_value())
+        {
+            runTask(task->first, task->second);
+            return true;
+        }
+        return false;
+    }
+}
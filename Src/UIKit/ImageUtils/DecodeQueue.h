@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+namespace d14engine::uikit::image_utils
+{
+    // Decodes images in a pool of worker threads in the order of priority
+    // (then submission), so that submitting returns a ticket immediately
+    // and the caller collects the decoded pixels later with takeResults.
+    //
+    // The priority of a pending task can be changed at any time (e.g. an
+    // item scrolls into view), and a cancelled task is dropped before it
+    // starts, or its result is discarded if it is being decoded already.
+    //
+    // With threadCount == 0 no worker is created, and the tasks are only
+    // decoded in decodeNext, which makes the scheduling deterministic.
+
+    struct DecodeQueue : cpp_lang_utils::NonCopyable
+    {
+        struct Image
+        {
+            uint32_t width = 0, height = 0;
+
+            // Tightly packed 32bpp pixels (4 * width bytes per scanline).
+            std::vector<uint8_t> pixels = {};
+        };
+        struct Request
+        {
+            Wstring path = {};
+
+            // Identifies the part of the image to decode (e.g. a tile),
+            // which is interpreted by the decoder and 0 for the whole.
+            uint64_t region = 0;
+        };
+        // Called in the worker threads concurrently, and throws on failure.
+        using Decoder = Function<Image(const Request& request)>;
+
+        // Called in the worker thread after each result becomes available,
+        // which is expected to wake up the UI thread to take the results.
+        using Notifier = Function<void()>;
+
+        DecodeQueue(const Decoder& decoder, size_t threadCount, const Notifier& notifier = {});
+
+        // Drops the pending tasks and waits for the running ones.
+        ~DecodeQueue();
+
+        // 0 is never returned as a valid ticket.
+        using Ticket = uint64_t;
+
+        // Larger values are decoded first.
+        using Priority = int;
+
+        enum class State { Unknown, Pending, Decoding, Finished };
+
+        struct Result
+        {
+            Ticket ticket = {};
+            Request request = {};
+
+            // Empty if the decoder has thrown the error.
+            Optional<Image> image = {};
+            std::exception_ptr error = {};
+        };
+        using ResultArray = std::vector<Result>;
+
+    protected:
+        Decoder m_decoder = {};
+        Notifier m_notifier = {};
+
+        struct Task
+        {
+            Request request = {};
+            Priority priority = {};
+            State state = State::Pending;
+        };
+        std::unordered_map<Ticket, Task> m_tasks = {};
+
+        struct QueueOrder
+        {
+            using Key = std::pair<Priority, Ticket>;
+
+            bool operator()(const Key& lhs, const Key& rhs) const
+            {
+                // Higher priority first, then the earlier submitted one.
+                if (lhs.first != rhs.first) return lhs.first > rhs.first;
+                return lhs.second < rhs.second;
+            }
+        };
+        std::set<QueueOrder::Key, QueueOrder> m_queue = {};
+
+        ResultArray m_results = {};
+
+        Ticket m_lastTicket = 0;
+
+        bool m_stopped = false;
+
+        mutable std::mutex m_mutex = {};
+        std::condition_variable m_condition = {};
+
+        std::vector<Thread> m_workers = {};
+
+        // Pops the top pending task and marks it as decoding.
+        Optional<std::pair<Ticket, Request>> popTask();
+
+        void runTask(Ticket ticket, const Request& request);
+
+    public:
+        Ticket submit(const Request& request, Priority priority = 0);
+
+        // Returns false if the task is not pending (i.e. started already).
+        bool setPriority(Ticket ticket, Priority priority);
+
+        void cancel(Ticket ticket);
+        void cancelAll();
+
+        State state(Ticket ticket) const;
+
+        size_t pendingCount() const;
+
+        // Returns and clears the results finished since the last call,
+        // after which the tickets of them become unknown.
+        ResultArray takeResults();
+
+        // Decodes the top pending task in the calling thread,
+        // and returns false if there is no pending task.
+        bool decodeNext();
+    };
+}
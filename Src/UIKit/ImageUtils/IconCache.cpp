@@ -0,0 +1,146 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/IconCache.h"
+
+namespace d14engine::uikit::image_utils
+{
+    IconCache::IconCache(const Source& source) : m_source(source) { }
+
+    IconCache::~IconCache()
+    {
+        m_stopped = true;
+        waitForPreload();
+    }
+
+    Wstring IconCache::makeKey(WstrRefer theme, WstrRefer name)
+    {
+        // The theme names never contain '|' (nor the file names).
+        return theme + L'|' + name;
+    }
+
+    Optional<IconCache::Icon> IconCache::load(WstrRefer theme, WstrRefer name)
+    {
+        ++m_sourceCallCount;
+        try
+        {
+            return m_source(theme, name);
+        }
+        catch (...)
+        {
+            return std::nullopt;
+        }
+    }
+
+    const IconCache::Icon* IconCache::resolve(Entry& entry, WstrRefer theme, WstrRefer name)
+    {
+        auto icon = load(theme, name);
+
+        std::unique_lock lock(m_mutex);
+
+        entry.icon = std::move(icon);
+        entry.resolved = true;
+
+        m_resolvedCondition.notify_all();
+
+        return entry.icon.has_value() ? &entry.icon.value() : nullptr;
+    }
+
+    const IconCache::Icon* IconCache::find(WstrRefer theme, WstrRefer name)
+    {
+        std::unique_lock lock(m_mutex);
+
+        auto result = m_entries.try_emplace(makeKey(theme, name));
+        auto& entry = result.first->second;
+
+        if (result.second)
+        {
+            lock.unlock();
+            return resolve(entry, theme, name);
+        }
+        // The worker of the preload is resolving it right now.
+        m_resolvedCondition.wait(lock, [&] { return entry.resolved; });
+
+        return entry.icon.has_value() ? &entry.icon.value() : nullptr;
+    }
+
+    bool IconCache::isResolved(WstrRefer theme, WstrRefer name) const
+    {
+        std::unique_lock lock(m_mutex);
+
+        auto itor = m_entries.find(makeKey(theme, name));
+        return itor != m_entries.end() && itor->second.resolved;
+    }
+
+    void IconCache::preload(WstrRefer theme, const std::vector<Wstring>& names)
+    {
+        std::erase_if(m_preloads, [](std::future<void>& preload)
+        {
+            return preload.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        m_preloads.push_back(std::async(std::launch::async, [this, theme, names]
+        {
+            for (auto& name : names)
+            {
+                if (m_stopped) break;
+
+                std::unique_lock lock(m_mutex);
+
+                auto result = m_entries.try_emplace(makeKey(theme, name));
+                if (!result.second) continue;
+
+                lock.unlock();
+                resolve(result.first->second, theme, name);
+            }
+        }));
+    }
+
+    bool IconCache::isPreloading()
+    {
+        for (auto& preload : m_preloads)
+        {
+            if (preload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void IconCache::waitForPreload()
+    {
+        for (auto& preload : m_preloads)
+        {
+            preload.wait();
+        }
+        m_preloads.clear();
+    }
+
+    size_t IconCache::sourceCallCount() const
+    {
+        return m_sourceCallCount;
+    }
+
+    IconCache::Icon IconCache::packFrames(const std::vector<pixel_utils::Image>& frames)
+    {
+        uint32_t cellWidth = 0, cellHeight = 0;
+        for (auto& frame : frames)
+        {
+            cellWidth = std::max(cellWidth, frame.width);
+            cellHeight = std::max(cellHeight, frame.height);
+        }
+        Icon icon = {};
+
+        icon.sheet = pixel_utils::Image(cellWidth * (uint32_t)frames.size(), cellHeight);
+        icon.frameCount = (uint32_t)frames.size();
+
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            auto& frame = frames[i];
+            for (uint32_t y = 0; y < frame.height; ++y)
+            {
+                std::memcpy(icon.sheet.row(y) + i * cellWidth * 4, frame.view().row(y), frame.pitch());
+            }
+        }
+        return icon;
+    }
+}
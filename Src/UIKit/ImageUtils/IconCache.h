@@ -0,0 +1,93 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+#include "Common/PixelUtils/Image.h"
+
+namespace d14engine::uikit::image_utils
+{
+    // Resolves the icons of the themes lazily: an icon is decoded by the
+    // source on its first request, and the result (including a missing
+    // one) is kept so that the source is never asked twice for it.
+    //
+    // A theme can be preloaded in a worker thread (e.g. the other theme
+    // after the first frame is presented), which resolves the icons one by
+    // one, so a request of the UI thread waits at most for the icon being
+    // resolved by the worker right now instead of the whole theme.
+    //
+    // The source is the only part that touches the files, so the caching
+    // works with a fake source on any platform.
+
+    struct IconCache : cpp_lang_utils::NonCopyable
+    {
+        struct Icon
+        {
+            // The frames of an animated icon are packed left to right in
+            // one sheet, and a static icon is a sheet of a single frame.
+            pixel_utils::Image sheet = {};
+
+            uint32_t frameCount = 1;
+
+            uint32_t frameWidth() const
+            {
+                return frameCount != 0 ? sheet.width / frameCount : 0;
+            }
+        };
+        // Also called in the worker thread of the preload, and returns
+        // std::nullopt (or throws) if the icon is missing.
+        using Source = Function<Optional<Icon>(WstrRefer theme, WstrRefer name)>;
+
+        explicit IconCache(const Source& source);
+
+        // Skips the icons not preloaded yet and waits for the worker.
+        ~IconCache();
+
+    protected:
+        Source m_source = {};
+
+        struct Entry
+        {
+            bool resolved = false;
+            Optional<Icon> icon = {};
+        };
+        // The references to the entries stay valid on rehashing.
+        std::unordered_map<Wstring, Entry> m_entries = {};
+
+        mutable std::mutex m_mutex = {};
+        std::condition_variable m_resolvedCondition = {};
+
+        std::vector<std::future<void>> m_preloads = {};
+        std::atomic<bool> m_stopped = false;
+
+        std::atomic<size_t> m_sourceCallCount = 0;
+
+        static Wstring makeKey(WstrRefer theme, WstrRefer name);
+
+        Optional<Icon> load(WstrRefer theme, WstrRefer name);
+
+        // Resolves the entry claimed by the calling thread.
+        const Icon* resolve(Entry& entry, WstrRefer theme, WstrRefer name);
+
+    public:
+        // Returns nullptr if the icon is missing, and the returned icon
+        // stays valid as long as the cache.
+        const Icon* find(WstrRefer theme, WstrRefer name);
+
+        bool isResolved(WstrRefer theme, WstrRefer name) const;
+
+        // The icons requested (or preloaded) already are skipped.
+        void preload(WstrRefer theme, const std::vector<Wstring>& names);
+
+        bool isPreloading();
+
+        void waitForPreload();
+
+        // For the statistics and the tests.
+        size_t sourceCallCount() const;
+
+        // Places the frames in the cells of the largest frame size, which
+        // are aligned to the top-left corners.
+        static Icon packFrames(const std::vector<pixel_utils::Image>& frames);
+    };
+}
@@ -0,0 +1,490 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/ThumbnailStore.h"
+
+namespace d14engine::uikit::image_utils
+{
+    namespace
+    {
+        // Pack file layout (native endianness):
+        // magic, version, generation, padded to g_packHeaderSize,
+        // followed by the raw pixels of each record (16-byte aligned).
+        //
+        // Index file layout (native endianness):
+        // magic, version, sizeof(wchar_t), generation, pack end, clock,
+        // entry count, followed by each entry:
+        // file size, modified time, max width, max height,
+        // width, height, offset, last access, length-prefixed path.
+
+        constexpr uint32_t g_packMagic = 0x4b504854; // "THPK"
+        constexpr uint32_t g_indexMagic = 0x58494854; // "THIX"
+        constexpr uint32_t g_version = 1;
+
+        constexpr uint64_t g_packHeaderSize = 64;
+        constexpr uint64_t g_recordAlignment = 16;
+
+        constexpr uint64_t g_initialCapacity = 1024 * 1024;
+
+        // Prevents a corrupted length from causing a huge allocation.
+        constexpr uint32_t g_maxPathLength = 32768;
+
+        uint64_t alignRecord(uint64_t offset)
+        {
+            return (offset + g_recordAlignment - 1) & ~(g_recordAlignment - 1);
+        }
+
+        template<typename T>
+        bool readValue(std::istream& stream, T& value)
+        {
+            return (bool)stream.read((char*)&value, sizeof(T));
+        }
+
+        template<typename T>
+        void writeValue(std::ostream& stream, const T& value)
+        {
+            stream.write((const char*)&value, sizeof(T));
+        }
+
+        bool readString(std::istream& stream, Wstring& str)
+        {
+            uint32_t length = {};
+            if (!readValue(stream, length) || length > g_maxPathLength)
+            {
+                return false;
+            }
+            str.resize(length);
+            return (bool)stream.read((char*)str.data(), length * sizeof(wchar_t));
+        }
+
+        void writeString(std::ostream& stream, const Wstring& str)
+        {
+            writeValue(stream, (uint32_t)str.size());
+            stream.write((const char*)str.data(), str.size() * sizeof(wchar_t));
+        }
+    }
+
+    size_t ThumbnailStore::KeyHash::operator()(const Key& key) const
+    {
+        size_t seed = std::hash<Wstring>{}(key.path);
+
+        auto combine = [&](uint64_t value)
+        {
+            seed ^= (size_t)value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        combine(key.fileSize);
+        combine((uint64_t)key.modifiedTime);
+        combine((uint64_t)key.maxWidth << 32 | key.maxHeight);
+
+        return seed;
+    }
+
+    Optional<ThumbnailStore::Key> ThumbnailStore::makeKey(WstrRefer path, uint32_t maxWidth, uint32_t maxHeight)
+    {
+        std::error_code error = {};
+
+        auto fileSize = std::filesystem::file_size(path, error);
+        if (error) return std::nullopt;
+
+        auto modifiedTime = std::filesystem::last_write_time(path, error);
+        if (error) return std::nullopt;
+
+        return Key
+        {
+            .path = path,
+            .fileSize = (uint64_t)fileSize,
+            .modifiedTime = (int64_t)modifiedTime.time_since_epoch().count(),
+            .maxWidth = maxWidth,
+            .maxHeight = maxHeight
+        };
+    }
+
+    ThumbnailStore::ThumbnailStore(WstrRefer directory, size_t budget)
+        :
+        m_directory(directory),
+        m_budget(budget)
+    {
+        std::error_code error = {};
+        std::filesystem::create_directories(m_directory, error);
+
+        // The store stays empty (and rejects the insertions) if the pack
+        // file is not writable, which only costs the decoding.
+        if (!loadIndex()) reset();
+    }
+
+    ThumbnailStore::~ThumbnailStore()
+    {
+        flush();
+    }
+
+    std::filesystem::path ThumbnailStore::packPath() const
+    {
+        return m_directory / L"thumbnails.pack";
+    }
+
+    std::filesystem::path ThumbnailStore::indexPath() const
+    {
+        return m_directory / L"thumbnails.index";
+    }
+
+    bool ThumbnailStore::loadIndex()
+    {
+        if (!m_pack.open(packPath(), MappedFile::Mode::ReadWrite) ||
+            m_pack.size() < g_packHeaderSize)
+        {
+            return false;
+        }
+        uint32_t packMagic = {}, packVersion = {};
+        std::memcpy(&packMagic, m_pack.data(), sizeof(packMagic));
+        std::memcpy(&packVersion, m_pack.data() + 4, sizeof(packVersion));
+        std::memcpy(&m_generation, m_pack.data() + 8, sizeof(m_generation));
+
+        if (packMagic != g_packMagic || packVersion != g_version)
+        {
+            return false;
+        }
+        std::ifstream stream(indexPath(), std::ios::binary);
+        if (!stream) return false;
+
+        uint32_t magic = {}, version = {}, charSize = {};
+        uint64_t generation = {}, packEnd = {}, clock = {}, count = {};
+
+        if (!readValue(stream, magic) || magic != g_indexMagic ||
+            !readValue(stream, version) || version != g_version ||
+            !readValue(stream, charSize) || charSize != sizeof(wchar_t) ||
+            !readValue(stream, generation) || generation != m_generation ||
+            !readValue(stream, packEnd) || packEnd < g_packHeaderSize || packEnd > m_pack.size() ||
+            !readValue(stream, clock) ||
+            !readValue(stream, count))
+        {
+            return false;
+        }
+        m_entries.clear();
+        m_usage = 0;
+
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            Key key = {};
+            uint32_t width = {}, height = {};
+            uint64_t offset = {}, lastAccess = {};
+
+            if (!readValue(stream, key.fileSize) ||
+                !readValue(stream, key.modifiedTime) ||
+                !readValue(stream, key.maxWidth) ||
+                !readValue(stream, key.maxHeight) ||
+                !readValue(stream, width) ||
+                !readValue(stream, height) ||
+                !readValue(stream, offset) ||
+                !readValue(stream, lastAccess) ||
+                !readString(stream, key.path))
+            {
+                return false;
+            }
+            auto byteSize = (uint64_t)width * height * 4;
+            if (byteSize == 0 || offset < g_packHeaderSize || offset > packEnd || byteSize > packEnd - offset)
+            {
+                return false;
+            }
+            auto& entry = m_entries[key];
+
+            // The later duplicate (if any) wins.
+            m_usage -= (size_t)entry.byteSize();
+
+            entry.width = width;
+            entry.height = height;
+            entry.offset = offset;
+            entry.lastAccess = lastAccess;
+
+            m_usage += (size_t)byteSize;
+        }
+        m_packEnd = packEnd;
+        m_clock = clock;
+
+        evict(m_budget);
+        return true;
+    }
+
+    bool ThumbnailStore::writeIndex() const
+    {
+        auto target = indexPath();
+
+        auto temporary = target;
+        temporary += L".tmp";
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+            if (!stream) return false;
+
+            writeValue(stream, g_indexMagic);
+            writeValue(stream, g_version);
+            writeValue(stream, (uint32_t)sizeof(wchar_t));
+            writeValue(stream, m_generation);
+            writeValue(stream, m_packEnd);
+            writeValue(stream, m_clock.load());
+            writeValue(stream, (uint64_t)m_entries.size());
+
+            for (auto& [key, entry] : m_entries)
+            {
+                writeValue(stream, key.fileSize);
+                writeValue(stream, key.modifiedTime);
+                writeValue(stream, key.maxWidth);
+                writeValue(stream, key.maxHeight);
+                writeValue(stream, entry.width);
+                writeValue(stream, entry.height);
+                writeValue(stream, entry.offset);
+                writeValue(stream, entry.lastAccess.load());
+                writeString(stream, key.path);
+            }
+            if (!stream.flush()) return false;
+        }
+        std::error_code error = {};
+        std::filesystem::rename(temporary, target, error);
+
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    bool ThumbnailStore::reset()
+    {
+        m_entries.clear();
+        m_usage = 0;
+        m_clock = 0;
+
+        if (!m_pack.isOpen() && !m_pack.open(packPath(), MappedFile::Mode::ReadWrite))
+        {
+            return false;
+        }
+        if (!m_pack.resize(g_initialCapacity)) return false;
+
+        // Any index left on the disk refers to the previous generation.
+        auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        m_generation = (m_generation + 1) ^ ((uint64_t)now << 16);
+
+        std::memset(m_pack.data(), 0, (size_t)g_packHeaderSize);
+        std::memcpy(m_pack.data(), &g_packMagic, sizeof(g_packMagic));
+        std::memcpy(m_pack.data() + 4, &g_version, sizeof(g_version));
+        std::memcpy(m_pack.data() + 8, &m_generation, sizeof(m_generation));
+
+        m_packEnd = g_packHeaderSize;
+        return true;
+    }
+
+    void ThumbnailStore::evict(size_t targetUsage)
+    {
+        if (m_usage <= targetUsage) return;
+
+        using Iterator = decltype(m_entries)::iterator;
+
+        std::vector<Iterator> candidates = {};
+        candidates.reserve(m_entries.size());
+
+        for (auto itor = m_entries.begin(); itor != m_entries.end(); ++itor)
+        {
+            candidates.push_back(itor);
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Iterator& a, const Iterator& b)
+        {
+            return a->second.lastAccess.load() < b->second.lastAccess.load();
+        });
+        for (auto& itor : candidates)
+        {
+            if (m_usage <= targetUsage) break;
+
+            m_usage -= (size_t)itor->second.byteSize();
+            m_entries.erase(itor);
+        }
+    }
+
+    void ThumbnailStore::compactUnlocked()
+    {
+        if (m_pack.data() == nullptr) return;
+
+        // The records are about to move, so the index on the disk must not
+        // match the pack file any more even if a crash happens halfway.
+        m_generation = (m_generation + 1) ^ ((uint64_t)m_packEnd << 32);
+        std::memcpy(m_pack.data() + 8, &m_generation, sizeof(m_generation));
+        m_pack.flush();
+
+        std::vector<Entry*> entries = {};
+        entries.reserve(m_entries.size());
+
+        for (auto& [key, entry] : m_entries)
+        {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(), [](Entry* a, Entry* b)
+        {
+            return a->offset < b->offset;
+        });
+        // The records only move towards the front, so the ones not moved
+        // yet are never overwritten.
+        uint64_t cursor = g_packHeaderSize;
+        for (auto entry : entries)
+        {
+            cursor = alignRecord(cursor);
+            if (entry->offset != cursor)
+            {
+                std::memmove(m_pack.data() + cursor, m_pack.data() + entry->offset, (size_t)entry->byteSize());
+                entry->offset = cursor;
+            }
+            cursor += entry->byteSize();
+        }
+        m_packEnd = cursor;
+
+        auto capacity = std::max(g_initialCapacity, alignRecord(m_packEnd + m_packEnd / 2));
+        if (m_pack.size() > capacity * 2) m_pack.resize(capacity);
+
+        m_pack.flush();
+        writeIndex();
+    }
+
+    const std::filesystem::path& ThumbnailStore::directory() const
+    {
+        return m_directory;
+    }
+
+    size_t ThumbnailStore::budget() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_budget;
+    }
+
+    void ThumbnailStore::setBudget(size_t bytes)
+    {
+        std::unique_lock lock(m_mutex);
+
+        m_budget = bytes;
+        evict(m_budget);
+    }
+
+    size_t ThumbnailStore::usage() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_usage;
+    }
+
+    size_t ThumbnailStore::size() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_entries.size();
+    }
+
+    uint64_t ThumbnailStore::packSize() const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_pack.size();
+    }
+
+    bool ThumbnailStore::contains(const Key& key) const
+    {
+        std::shared_lock lock(m_mutex);
+        return m_entries.contains(key);
+    }
+
+    Optional<pixel_utils::Image> ThumbnailStore::find(const Key& key) const
+    {
+        std::shared_lock lock(m_mutex);
+
+        auto itor = m_entries.find(key);
+        if (itor == m_entries.end()) return std::nullopt;
+
+        auto& entry = itor->second;
+        entry.lastAccess = ++m_clock;
+
+        pixel_utils::Image image(entry.width, entry.height);
+        std::memcpy(image.pixels.data(), m_pack.data() + entry.offset, image.pixels.size());
+
+        return image;
+    }
+
+    bool ThumbnailStore::insert(const Key& key, const pixel_utils::ImageView& image)
+    {
+        auto byteSize = (uint64_t)image.width * image.height * 4;
+
+        std::unique_lock lock(m_mutex);
+
+        if (byteSize == 0 || byteSize > m_budget || !m_pack.isOpen())
+        {
+            return false;
+        }
+        auto itor = m_entries.find(key);
+        if (itor != m_entries.end())
+        {
+            m_usage -= (size_t)itor->second.byteSize();
+            m_entries.erase(itor);
+        }
+        // Evicts an extra 1/8 of the budget at once, which saves sorting
+        // the entries for each insertion when the store is full.
+        if (m_usage + byteSize > m_budget)
+        {
+            auto target = m_budget - (size_t)byteSize;
+            evict(target - std::min(target, m_budget / 8));
+        }
+        auto deadSize = m_packEnd - g_packHeaderSize - m_usage;
+        if (deadSize > m_usage && deadSize > g_initialCapacity)
+        {
+            compactUnlocked();
+        }
+        auto offset = alignRecord(m_packEnd);
+        if (offset + byteSize > m_pack.size())
+        {
+            auto capacity = std::max(offset + byteSize, m_pack.size() * 2);
+            if (!m_pack.resize(capacity)) return false;
+        }
+        auto rowSize = (size_t)image.width * 4;
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            std::memcpy(m_pack.data() + offset + y * rowSize, image.row(y), rowSize);
+        }
+        auto& entry = m_entries[key];
+
+        entry.width = image.width;
+        entry.height = image.height;
+        entry.offset = offset;
+        entry.lastAccess = ++m_clock;
+
+        m_usage += (size_t)byteSize;
+        m_packEnd = offset + byteSize;
+
+        return true;
+    }
+
+    void ThumbnailStore::erase(const Key& key)
+    {
+        std::unique_lock lock(m_mutex);
+
+        auto itor = m_entries.find(key);
+        if (itor != m_entries.end())
+        {
+            m_usage -= (size_t)itor->second.byteSize();
+            m_entries.erase(itor);
+        }
+    }
+
+    void ThumbnailStore::clear()
+    {
+        std::unique_lock lock(m_mutex);
+
+        reset();
+        writeIndex();
+    }
+
+    void ThumbnailStore::compact()
+    {
+        std::unique_lock lock(m_mutex);
+
+        compactUnlocked();
+    }
+
+    bool ThumbnailStore::flush()
+    {
+        std::unique_lock lock(m_mutex);
+
+        if (!m_pack.isOpen()) return false;
+
+        // The pixels must reach the disk before the index refers to them.
+        return m_pack.flush() && writeIndex();
+    }
+}
@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+#include "Common/MappedFile.h"
+#include "Common/PixelUtils/Image.h"
+
+namespace d14engine::uikit::image_utils
+{
+    // Keeps the thumbnails on the disk across the launches so that the
+    // source images need not be decoded and scaled again.
+    //
+    // The pixels are appended to a memory-mapped pack file, and an index
+    // file (rewritten atomically on flush) locates them.  The store is
+    // bounded by the total pixel bytes and evicts the least recently used
+    // thumbnails, and the pack file is compacted once half of it is dead.
+    //
+    // The lookups take a shared lock and can run concurrently (e.g. in the
+    // decoding workers), while the insertions and removals are exclusive.
+    // A store directory should be owned by one instance at a time.
+
+    struct ThumbnailStore : cpp_lang_utils::NonCopyable
+    {
+        struct Key
+        {
+            Wstring path = {};
+
+            // Any change of the file invalidates the thumbnails.
+            uint64_t fileSize = 0;
+            int64_t modifiedTime = 0;
+
+            // The bounds requested (rather than the actual size).
+            uint32_t maxWidth = 0, maxHeight = 0;
+
+            bool operator==(const Key& other) const = default;
+        };
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const;
+        };
+        // Returns std::nullopt if the file is missing.
+        static Optional<Key> makeKey(WstrRefer path, uint32_t maxWidth, uint32_t maxHeight);
+
+        // The files are created in the directory if they do not exist,
+        // and any corrupted or mismatched store starts over empty.
+        explicit ThumbnailStore(WstrRefer directory, size_t budget = 64 * 1024 * 1024);
+
+        // Flushes the store.
+        virtual ~ThumbnailStore();
+
+    protected:
+        const std::filesystem::path m_directory = {};
+
+        size_t m_budget = {};
+
+        mutable std::shared_mutex m_mutex = {};
+
+        MappedFile m_pack = {};
+
+        // Changed whenever the records move in the pack file, so that the
+        // index of another generation is never trusted.
+        uint64_t m_generation = 0;
+
+        // The end of the records (the file may have unused capacity).
+        uint64_t m_packEnd = 0;
+
+        struct Entry
+        {
+            uint32_t width = 0, height = 0;
+
+            uint64_t offset = 0;
+
+            // Touched under the shared lock.
+            mutable std::atomic<uint64_t> lastAccess = 0;
+
+            uint64_t byteSize() const { return (uint64_t)width * height * 4; }
+        };
+        std::unordered_map<Key, Entry, KeyHash> m_entries = {};
+
+        size_t m_usage = 0;
+
+        mutable std::atomic<uint64_t> m_clock = 0;
+
+        std::filesystem::path packPath() const;
+        std::filesystem::path indexPath() const;
+
+        bool loadIndex();
+        bool writeIndex() const;
+
+        // Creates an empty pack file of a new generation.
+        bool reset();
+
+        // Evicts the LRU entries until the usage fits in the target.
+        void evict(size_t targetUsage);
+
+        // Moves the live records to the front of the pack file.
+        void compactUnlocked();
+
+    public:
+        const std::filesystem::path& directory() const;
+
+        size_t budget() const;
+        void setBudget(size_t bytes);
+
+        // The total bytes of the pixels in the store.
+        size_t usage() const;
+
+        size_t size() const;
+
+        // The bytes of the pack file (including the dead records).
+        uint64_t packSize() const;
+
+        bool contains(const Key& key) const;
+
+        // Returns a copy of the premultiplied pixels.
+        Optional<pixel_utils::Image> find(const Key& key) const;
+
+        // Replaces the existing thumbnail of the key, and returns false if
+        // the image is larger than the budget or the disk is not writable.
+        bool insert(const Key& key, const pixel_utils::ImageView& image);
+
+        void erase(const Key& key);
+        void clear();
+
+        void compact();
+
+        // Writes the index and the pack file back to the disk, and the
+        // thumbnails inserted after the last flush are lost on a crash.
+        bool flush();
+    };
+}
@@ -0,0 +1,107 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/TilePyramid.h"
+
+namespace d14engine::uikit::image_utils
+{
+    // Keeps the most recently used tiles under a memory budget in bytes,
+    // where the size of each tile is reported by the caller on insertion
+    // (e.g. 4 * width * height for a 32bpp bitmap).
+    //
+    // The newest tile is never evicted by its own insertion, so a tile
+    // larger than the whole budget is still kept until the next insertion.
+
+    template<typename Tile_T>
+    struct TileCache
+    {
+        explicit TileCache(size_t budget = 256 * 1024 * 1024) : m_budget(budget) { }
+
+    protected:
+        struct Entry
+        {
+            uint64_t key = {};
+            Tile_T tile = {};
+            size_t bytes = {};
+        };
+        // The front is the most recently used one.
+        std::list<Entry> m_entries = {};
+
+        std::unordered_map<uint64_t, typename std::list<Entry>::iterator> m_index = {};
+
+        size_t m_budget = {};
+        size_t m_usage = 0;
+
+        void evict(size_t keepCount)
+        {
+            while (m_usage > m_budget && m_entries.size() > keepCount)
+            {
+                auto& entry = m_entries.back();
+
+                m_usage -= entry.bytes;
+                m_index.erase(entry.key);
+
+                m_entries.pop_back();
+            }
+        }
+
+    public:
+        size_t budget() const { return m_budget; }
+
+        void setBudget(size_t budget)
+        {
+            m_budget = budget;
+            evict(0);
+        }
+
+        size_t usage() const { return m_usage; }
+
+        size_t size() const { return m_entries.size(); }
+
+        bool contains(const TileKey& key) const
+        {
+            return m_index.find(key.packed()) != m_index.end();
+        }
+
+        // Returns nullptr if missing, and marks the tile as the newest.
+        Tile_T* find(const TileKey& key)
+        {
+            auto itor = m_index.find(key.packed());
+            if (itor == m_index.end()) return nullptr;
+
+            m_entries.splice(m_entries.begin(), m_entries, itor->second);
+            return &itor->second->tile;
+        }
+
+        void insert(const TileKey& key, Tile_T tile, size_t bytes)
+        {
+            erase(key);
+
+            m_entries.push_front({ key.packed(), std::move(tile), bytes });
+            m_index[key.packed()] = m_entries.begin();
+
+            m_usage += bytes;
+            evict(1);
+        }
+
+        void erase(const TileKey& key)
+        {
+            auto itor = m_index.find(key.packed());
+            if (itor == m_index.end()) return;
+
+            m_usage -= itor->second->bytes;
+            m_entries.erase(itor->second);
+
+            m_index.erase(itor);
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_index.clear();
+
+            m_usage = 0;
+        }
+    };
+}
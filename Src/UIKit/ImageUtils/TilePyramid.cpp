@@ -0,0 +1,164 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/TilePyramid.h"
+
+namespace d14engine::uikit::image_utils
+{
+    uint64_t TileKey::packed() const
+    {
+        return ((uint64_t)(level & 0xffff) << 48) |
+               ((uint64_t)(x & 0xffffff) << 24) |
+               ((uint64_t)(y & 0xffffff));
+    }
+
+    TileKey TileKey::unpack(uint64_t packed)
+    {
+        return
+        {
+            .level = (uint32_t)(packed >> 48) & 0xffff,
+            .x = (uint32_t)(packed >> 24) & 0xffffff,
+            .y = (uint32_t)(packed) & 0xffffff
+        };
+    }
+
+    TilePyramid::TilePyramid(uint32_t imageWidth, uint32_t imageHeight, uint32_t tileSize)
+        :
+        m_imageSize({ imageWidth, imageHeight }),
+        m_tileSize(std::max(tileSize, 1u))
+    {
+        if (imageWidth == 0 || imageHeight == 0) return;
+
+        m_levelCount = 1;
+        while (true)
+        {
+            auto size = levelSize(m_levelCount - 1);
+            if (size.width <= m_tileSize && size.height <= m_tileSize) break;
+
+            ++m_levelCount;
+        }
+    }
+
+    const TilePyramid::Size& TilePyramid::imageSize() const
+    {
+        return m_imageSize;
+    }
+
+    uint32_t TilePyramid::tileSize() const
+    {
+        return m_tileSize;
+    }
+
+    uint32_t TilePyramid::levelCount() const
+    {
+        return m_levelCount;
+    }
+
+    TilePyramid::Size TilePyramid::levelSize(uint32_t level) const
+    {
+        // Rounds up so that the last column/row of pixels is never lost.
+        auto divide = [&](uint32_t length) -> uint32_t
+        {
+            auto scaled = ((uint64_t)length + ((uint64_t)1 << level) - 1) >> level;
+            return (uint32_t)std::max(scaled, (uint64_t)1);
+        };
+        return { divide(m_imageSize.width), divide(m_imageSize.height) };
+    }
+
+    TilePyramid::Size TilePyramid::tileCount(uint32_t level) const
+    {
+        auto size = levelSize(level);
+        return
+        {
+            (size.width + m_tileSize - 1) / m_tileSize,
+            (size.height + m_tileSize - 1) / m_tileSize
+        };
+    }
+
+    bool TilePyramid::contains(const TileKey& key) const
+    {
+        if (key.level >= m_levelCount) return false;
+
+        auto count = tileCount(key.level);
+        return key.x < count.width && key.y < count.height;
+    }
+
+    TilePyramid::Rect TilePyramid::tileRect(const TileKey& key) const
+    {
+        auto size = levelSize(key.level);
+
+        auto left = std::min(key.x * m_tileSize, size.width);
+        auto top = std::min(key.y * m_tileSize, size.height);
+
+        return
+        {
+            left, top,
+            std::min(left + m_tileSize, size.width),
+            std::min(top + m_tileSize, size.height)
+        };
+    }
+
+    TilePyramid::Rect TilePyramid::sourceRect(const TileKey& key) const
+    {
+        auto rect = tileRect(key);
+
+        auto scale = [&](uint32_t value, uint32_t limit)
+        {
+            return (uint32_t)std::min((uint64_t)value << key.level, (uint64_t)limit);
+        };
+        return
+        {
+            scale(rect.left, m_imageSize.width),
+            scale(rect.top, m_imageSize.height),
+            scale(rect.right, m_imageSize.width),
+            scale(rect.bottom, m_imageSize.height)
+        };
+    }
+
+    uint32_t TilePyramid::levelForScale(float scale) const
+    {
+        if (m_levelCount == 0 || scale >= 1.0f) return 0;
+        if (scale <= 0.0f) return m_levelCount - 1;
+
+        // The small epsilon keeps exact powers of 2 on the coarser side.
+        auto level = (uint32_t)std::max(std::floor(std::log2(1.0f / scale) + 1e-4f), 0.0f);
+        return std::min(level, m_levelCount - 1);
+    }
+
+    TilePyramid::TileRange TilePyramid::tilesInArea(uint32_t level, const Area& area, uint32_t margin) const
+    {
+        if (level >= m_levelCount) return { level, 0, 0, 0, 0 };
+
+        auto count = tileCount(level);
+        auto extent = (float)((uint64_t)m_tileSize << level);
+
+        // The first and one-past-the-last tile in each dimension.
+        auto first = [&](float value, uint32_t limit) -> uint32_t
+        {
+            auto index = std::floor(value / extent) - (float)margin;
+            return (uint32_t)std::clamp(index, 0.0f, (float)limit);
+        };
+        auto last = [&](float value, uint32_t limit) -> uint32_t
+        {
+            auto index = std::ceil(value / extent) + (float)margin;
+            return (uint32_t)std::clamp(index, 0.0f, (float)limit);
+        };
+        TileRange range =
+        {
+            level,
+            first(area.left, count.width), first(area.top, count.height),
+            last(area.right, count.width), last(area.bottom, count.height)
+        };
+        // An empty area yields an empty range.
+        range.right = std::max(range.right, range.left);
+        range.bottom = std::max(range.bottom, range.top);
+
+        return range;
+    }
+
+    Optional<TileKey> TilePyramid::parent(const TileKey& key) const
+    {
+        if (key.level + 1 >= m_levelCount) return std::nullopt;
+
+        return TileKey{ key.level + 1, key.x / 2, key.y / 2 };
+    }
+}
@@ -0,0 +1,82 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::uikit::image_utils
+{
+    struct TileKey
+    {
+        uint32_t level = 0, x = 0, y = 0;
+
+        bool operator==(const TileKey& rhs) const = default;
+
+        // 16 bits for the level and 24 bits for each coordinate,
+        // which covers images of up to 2^24 tiles in each dimension.
+        uint64_t packed() const;
+        static TileKey unpack(uint64_t packed);
+    };
+
+    // Describes a pyramid of fixed-size tiles over a huge image:
+    // level 0 is the image in full resolution, and each following level
+    // halves the size of the previous one (rounding up) until the whole
+    // level fits in a single tile.
+    //
+    // The coordinates in the image space are the pixels of level 0.
+
+    struct TilePyramid
+    {
+        TilePyramid() = default;
+
+        TilePyramid(uint32_t imageWidth, uint32_t imageHeight, uint32_t tileSize = 256);
+
+        struct Size { uint32_t width, height; };
+
+        // Half-open intervals in pixels: [left, right) x [top, bottom).
+        struct Rect { uint32_t left, top, right, bottom; };
+
+        // Half-open intervals in tile indices of the level.
+        struct TileRange { uint32_t level, left, top, right, bottom; };
+
+        // Floating-point rectangle in the image space (e.g. the viewport).
+        struct Area { float left, top, right, bottom; };
+
+    protected:
+        Size m_imageSize = { 0, 0 };
+
+        uint32_t m_tileSize = 256;
+
+        uint32_t m_levelCount = 0;
+
+    public:
+        const Size& imageSize() const;
+
+        uint32_t tileSize() const;
+
+        uint32_t levelCount() const;
+
+        Size levelSize(uint32_t level) const;
+
+        Size tileCount(uint32_t level) const;
+
+        bool contains(const TileKey& key) const;
+
+        // In the pixels of the level of the tile.
+        Rect tileRect(const TileKey& key) const;
+
+        // In the image space (clamped to the image size).
+        Rect sourceRect(const TileKey& key) const;
+
+        // Selects the coarsest level that still provides at least one pixel
+        // for each display pixel, where scale is display pixels per image
+        // pixel (e.g. 0.25 selects level 2).
+        uint32_t levelForScale(float scale) const;
+
+        // Returns the tiles of the level overlapped with the area,
+        // optionally expanded by margin tiles in each direction.
+        TileRange tilesInArea(uint32_t level, const Area& area, uint32_t margin = 0) const;
+
+        // Returns the tile of the coarser level that covers the key,
+        // or nullopt if the key is at the coarsest level already.
+        Optional<TileKey> parent(const TileKey& key) const;
+    };
+}
@@ -0,0 +1,71 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/TileScheduler.h"
+
+namespace d14engine::uikit::image_utils
+{
+    TileScheduler::RequestArray TileScheduler::plan(
+        const TilePyramid& pyramid, const TilePyramid::Area& viewport, float scale) const
+    {
+        RequestArray requests = {};
+
+        auto levelCount = pyramid.levelCount();
+        if (levelCount == 0) return requests;
+
+        std::unordered_set<uint64_t> planned = {};
+
+        auto add = [&](uint32_t level, uint32_t margin, Category category)
+        {
+            auto range = pyramid.tilesInArea(level, viewport, margin);
+            auto extent = (float)((uint64_t)pyramid.tileSize() << level);
+
+            // The viewport center in the tile units of the level.
+            auto centerX = (viewport.left + viewport.right) * 0.5f / extent;
+            auto centerY = (viewport.top + viewport.bottom) * 0.5f / extent;
+
+            for (auto y = range.top; y < range.bottom; ++y)
+            {
+                for (auto x = range.left; x < range.right; ++x)
+                {
+                    TileKey key = { level, x, y };
+                    if (!planned.insert(key.packed()).second) continue;
+
+                    auto dx = (float)x + 0.5f - centerX;
+                    auto dy = (float)y + 0.5f - centerY;
+
+                    requests.push_back(
+                    {
+                        key, category, priority(category, std::sqrt(dx * dx + dy * dy))
+                    });
+                }
+            }
+        };
+        auto level = pyramid.levelForScale(scale);
+
+        add(levelCount - 1, 0, Category::Fallback);
+        add(level, 0, Category::Visible);
+
+        if (setting.prefetchMargin > 0)
+        {
+            add(level, setting.prefetchMargin, Category::Prefetch);
+        }
+        if (setting.prefetchCoarserLevel && level + 1 < levelCount)
+        {
+            add(level + 1, 0, Category::Prefetch);
+        }
+        std::stable_sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs)
+        {
+            return lhs.priority > rhs.priority;
+        });
+        return requests;
+    }
+
+    int TileScheduler::priority(Category category, float distance)
+    {
+        // Leaves 2^20 slots of distance (in 1/16 tile) in each category.
+        constexpr int slotCount = 1 << 20;
+
+        auto slot = (int)std::min(std::max(distance, 0.0f) * 16.0f, (float)(slotCount - 1));
+        return (int)category * slotCount - slot;
+    }
+}
@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/TilePyramid.h"
+
+namespace d14engine::uikit::image_utils
+{
+    // Decides which tiles to load for a viewport and in what order:
+    //
+    // 1. The single tile of the coarsest level, which is tiny and serves
+    //    as the fallback of any tile that has not been loaded yet.
+    // 2. The visible tiles of the selected level, center first.
+    // 3. The tiles within the margin around the viewport (for panning),
+    //    and the visible tiles of the next coarser level (for zooming out).
+    //
+    // The priorities are compatible with DecodeQueue (larger goes first).
+
+    struct TileScheduler
+    {
+        struct Setting
+        {
+            // The count of extra tiles beyond each edge to be prefetched.
+            uint32_t prefetchMargin = 1;
+
+            // Whether to prefetch the next coarser level.
+            bool prefetchCoarserLevel = true;
+        }
+        setting = {};
+
+        enum class Category { Prefetch = 1, Visible = 2, Fallback = 3 };
+
+        struct Request
+        {
+            TileKey key = {};
+            Category category = {};
+
+            int priority = {};
+        };
+        using RequestArray = std::vector<Request>;
+
+        // The viewport is in the image space, and the scale is display
+        // pixels per image pixel.  Each tile appears at most once.
+        RequestArray plan(const TilePyramid& pyramid, const TilePyramid::Area& viewport, float scale) const;
+
+        // Returns the priority that sorts by the category first,
+        // and then by the distance (in tiles) to the viewport center.
+        static int priority(Category category, float distance);
+    };
+}
@@ -55,12 +55,16 @@ namespace d14engine::uikit
 
         m_textLayout = getTextLayout();
         updateTextOverhangMetrics();
+
+        invalidate();
     }
 
     void Label::setTextFormat(IDWriteTextFormat* textFormat)
     {
         m_textLayout = getTextLayout({ .textFormat = textFormat });
         updateTextOverhangMetrics();
+
+        invalidate();
     }
 
     void Label::insertTextFragment(WstrRefer fragment, size_t offset)
@@ -74,6 +78,8 @@ namespace d14engine::uikit
 
         m_textLayout = getTextLayout();
         updateTextOverhangMetrics();
+
+        invalidate();
     }
 
     void Label::appendTextFragment(WstrRefer fragment)
@@ -87,6 +93,8 @@ namespace d14engine::uikit
 
         m_textLayout = getTextLayout();
         updateTextOverhangMetrics();
+
+        invalidate();
     }
 
     void Label::eraseTextFragment(const CharacterRange& range)
@@ -98,6 +106,8 @@ namespace d14engine::uikit
 
         m_textLayout = getTextLayout();
         updateTextOverhangMetrics();
+
+        invalidate();
     }
 
     void Label::copyTextStyle(Label* source, OptRefer<WstringView> text)
@@ -148,6 +158,8 @@ do { \
             updateTextOverhangMetrics();
 
             drawTextOptions = source->drawTextOptions;
+
+            invalidate();
         }
     }
 
@@ -360,7 +372,7 @@ do { \
         }
         default: /* VertAlignment::None */ break;
         }
-        rndr->d2d1DeviceContext()->DrawTextLayout
+        rndr->recorder2D()->DrawTextLayout
         (
         /* origin           */ origin,
         /* textLayout       */ m_textLayout.Get(),
@@ -379,7 +391,7 @@ do { \
         auto frame = math_utils::inner(m_absoluteRect, stroke.width);
         D2D1_ROUNDED_RECT outlineRect = { frame, roundRadiusX, roundRadiusY };
 
-        rndr->d2d1DeviceContext()->DrawRoundedRectangle
+        rndr->recorder2D()->DrawRoundedRectangle
         (
         /* roundedRect */ outlineRect,
         /* brush       */ resource_utils::solidColorBrush(),
@@ -21,6 +21,171 @@ namespace d14engine::uikit
         // Here left blank intentionally.
     }
 
+    LabelArea::~LabelArea()
+    {
+        // The worker must exit before the callback is unregistered,
+        // otherwise it may post a notification to a released object.
+        m_backgroundSearch.cancel();
+
+        if (Application::g_app != nullptr)
+        {
+            Application::g_app->unregisterThreadCallback((Application::ThreadEventID)this);
+        }
+    }
+
+    void LabelArea::onSearchFinish(size_t matchCount)
+    {
+        onSearchFinishHelper(matchCount);
+
+        if (f_onSearchFinish) f_onSearchFinish(this, matchCount);
+    }
+
+    void LabelArea::onSearchFinishHelper(size_t matchCount)
+    {
+        // This method intentionally left blank.
+    }
+
+    void LabelArea::takeSearchMatches()
+    {
+        auto matches = m_backgroundSearch.takeMatches();
+
+        auto originalCount = m_searchMatches.size();
+        for (auto& match : matches)
+        {
+            m_searchMatches.push_back({ match.offset, match.count });
+        }
+        // Only the newly delivered matches need to be hit-tested.
+        updateSearchMatchRects(originalCount);
+
+        // Delivered by the thread event instead of a UI event.
+        if (!matches.empty()) invalidate();
+    }
+
+    void LabelArea::updateSearchMatchRects(size_t firstMatch)
+    {
+        if (firstMatch == 0) m_searchMatchRects.clear();
+
+        for (auto i = firstMatch; i < m_searchMatches.size(); ++i)
+        {
+            auto& match = m_searchMatches[i];
+            auto result = hitTestTextRange((UINT32)match.offset, (UINT32)match.count, 0.0f, 0.0f);
+
+            m_searchMatchRects.insert(m_searchMatchRects.end(), result.metrics.begin(), result.metrics.end());
+        }
+    }
+
+    const std::vector<Label::CharacterRange>& LabelArea::searchMatches() const
+    {
+        return m_searchMatches;
+    }
+
+    void LabelArea::startSearch(WstrRefer pattern, const text_utils::TextSearchOptions& options)
+    {
+        THROW_IF_NULL(Application::g_app);
+
+        // The params may refer to the members that cancelSearch clears.
+        text_utils::TextSearch search(pattern, options);
+
+        cancelSearch();
+
+        m_searchPattern = search.pattern();
+        m_searchOptions = search.options();
+
+        if (!search.valid()) return;
+
+        auto app = Application::g_app;
+        auto id = (Application::ThreadEventID)this;
+        auto generation = ++m_searchGeneration;
+
+        app->registerThreadCallback(id, [this](Application::ThreadEventData data)
+        {
+            if (data != (Application::ThreadEventData)m_searchGeneration) return;
+
+            takeSearchMatches();
+
+            if (m_isSearchFinishPending && !m_backgroundSearch.isRunning())
+            {
+                m_isSearchFinishPending = false;
+                onSearchFinish(m_searchMatches.size());
+            }
+        });
+        m_isSearchFinishPending = true;
+
+        // The snapshot keeps the search valid while the text is modified.
+        m_backgroundSearch.start(std::make_shared<const Wstring>(m_text), search,
+        [app, id, generation]
+        {
+            app->triggerThreadEvent(id, (Application::ThreadEventData)generation);
+        });
+    }
+
+    void LabelArea::scheduleSearchRestart()
+    {
+        if (m_searchPattern.empty()) return;
+
+        // The indicator animation keeps updating the focused label area,
+        // while a modification without the focus is seldom a keystroke.
+        if (!holdKeyboardFocus())
+        {
+            startSearch(m_searchPattern, m_searchOptions);
+            return;
+        }
+        m_backgroundSearch.requestCancel();
+
+        ++m_searchGeneration;
+        m_isSearchFinishPending = false;
+
+        m_searchMatches.clear();
+        m_searchMatchRects.clear();
+
+        m_isSearchRestartPending = true;
+        m_searchRestartElapsedSecs = 0.0f;
+    }
+
+    void LabelArea::cancelSearch()
+    {
+        m_backgroundSearch.cancel();
+
+        ++m_searchGeneration;
+        m_isSearchFinishPending = false;
+        m_isSearchRestartPending = false;
+
+        m_searchPattern.clear();
+
+        m_searchMatches.clear();
+        m_searchMatchRects.clear();
+    }
+
+    bool LabelArea::isSearching() const
+    {
+        return m_backgroundSearch.isRunning();
+    }
+
+    bool LabelArea::findNext(WstrRefer pattern, const text_utils::TextSearchOptions& options, bool backward)
+    {
+        text_utils::TextSearch search(pattern, options);
+
+        Optional<text_utils::TextSearch::Match> match = {};
+        if (backward)
+        {
+            match = search.findPrev(m_text, m_hiliteRange.count > 0 ? m_hiliteRange.offset : m_indicatorCharacterOffset);
+            if (!match.has_value()) match = search.findPrev(m_text, m_text.size());
+        }
+        else // forward
+        {
+            match = search.findNext(m_text, m_hiliteRange.count > 0 ? (m_hiliteRange.offset + m_hiliteRange.count) : m_indicatorCharacterOffset);
+            if (!match.has_value()) match = search.findNext(m_text, 0);
+        }
+        if (match.has_value())
+        {
+            setHiliteRange({ match.value().offset, match.value().count });
+            setIndicatorPosition(match.value().offset + match.value().count);
+
+            return true;
+        }
+        return false;
+    }
+
     const Label::CharacterRange& LabelArea::hiliteRange() const
     {
         return m_hiliteRange;
@@ -40,6 +205,8 @@ namespace d14engine::uikit
 
         m_hiliteRangeData = hitTestTextRange(
             (UINT32)m_hiliteRange.offset, (UINT32)m_hiliteRange.count, 0.0f, 0.0f);
+
+        invalidate();
     }
 
     size_t LabelArea::hitTestCharacterOffset(const D2D1_POINT_2F& sfpt)
@@ -61,6 +228,8 @@ namespace d14engine::uikit
         auto result = hitTestTextPos((UINT32)m_indicatorCharacterOffset, false);
         m_indicatorGeometry.first = { result.pointX, result.pointY };
         m_indicatorGeometry.second = { result.pointX, result.pointY + result.metrics.height };
+
+        invalidate();
     }
 
     void LabelArea::performCommandCtrlA()
@@ -91,6 +260,16 @@ namespace d14engine::uikit
             m_showIndicator = !m_showIndicator;
             m_indicatorBlinkElapsedSecs = 0.0f;
         }
+
+        ////////////////////
+        // Restart Search //
+        ////////////////////
+
+        if (m_isSearchRestartPending && (m_searchRestartElapsedSecs += deltaSecs) >= searchRestartDelaySecs)
+        {
+            m_isSearchRestartPending = false;
+            startSearch(m_searchPattern, m_searchOptions);
+        }
     }
 
     void LabelArea::drawHiliteRange(Renderer* rndr)
@@ -109,7 +288,7 @@ namespace d14engine::uikit
             resource_utils::solidColorBrush()->SetColor(setting.background.color);
             resource_utils::solidColorBrush()->SetOpacity(setting.background.opacity);
 
-            rndr->d2d1DeviceContext()->FillRectangle
+            rndr->recorder2D()->FillRectangle
             (
             /* rect  */ hiliteRangeRect,
             /* brush */ resource_utils::solidColorBrush()
@@ -127,7 +306,7 @@ namespace d14engine::uikit
             auto frame = math_utils::inner(hiliteRangeRect, strokeWidth);
             D2D1_ROUNDED_RECT outlineRect = { frame, roundRadiusX, roundRadiusY };
 
-            rndr->d2d1DeviceContext()->DrawRoundedRectangle
+            rndr->recorder2D()->DrawRoundedRectangle
             (
             /* roundedRect */ outlineRect,
             /* brush       */ resource_utils::solidColorBrush(),
@@ -136,6 +315,26 @@ namespace d14engine::uikit
         }
     }
 
+    void LabelArea::drawSearchMatches(Renderer* rndr)
+    {
+        auto& setting = appearance().searchMatch;
+
+        resource_utils::solidColorBrush()->SetColor(setting.background.color);
+        resource_utils::solidColorBrush()->SetOpacity(setting.background.opacity);
+
+        for (auto& rect : m_searchMatchRects)
+        {
+            auto matchRect = math_utils::roundf(selfCoordToAbsolute(
+                math_utils::rect(rect.left, rect.top, rect.width, rect.height)));
+
+            rndr->recorder2D()->FillRectangle
+            (
+            /* rect  */ matchRect,
+            /* brush */ resource_utils::solidColorBrush()
+            );
+        }
+    }
+
     void LabelArea::drawIndicator(Renderer* rndr)
     {
         auto& setting = appearance().indicator;
@@ -159,7 +358,7 @@ namespace d14engine::uikit
                 result1.point = math_utils::offset(math_utils::roundf(
                     selfCoordToAbsolute(result1.point)), { 0.5f, 0.0f });
 
-                rndr->d2d1DeviceContext()->DrawLine
+                rndr->recorder2D()->DrawLine
                 (
                 /* point0 */ result0.point,
                 /* point1 */ result1.point,
@@ -172,6 +371,7 @@ namespace d14engine::uikit
     void LabelArea::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
     {
         drawBackground(rndr);
+        drawSearchMatches(rndr);
         drawHiliteRange(rndr);
         drawText(rndr);
         drawIndicator(rndr);
@@ -211,6 +411,13 @@ namespace d14engine::uikit
             setIndicatorPosition(0);
         }
         decreaseAnimationCount();
+
+        // No more updates to wait for the typing to pause.
+        if (m_isSearchRestartPending)
+        {
+            m_isSearchRestartPending = false;
+            startSearch(m_searchPattern, m_searchOptions);
+        }
     }
 
     void LabelArea::onMouseMoveHelper(MouseMoveEvent& e)
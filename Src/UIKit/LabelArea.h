@@ -6,6 +6,7 @@
 
 #include "UIKit/Appearances/LabelArea.h"
 #include "UIKit/Label.h"
+#include "UIKit/TextUtils/BackgroundSearch.h"
 
 namespace d14engine::uikit
 {
@@ -13,6 +14,8 @@ namespace d14engine::uikit
     {
         LabelArea(WstrRefer text = {}, const D2D_RECT_F& rect = {});
 
+        virtual ~LabelArea();
+
         _D14_SET_APPEARANCE_PROPERTY(LabelArea)
 
     protected:
@@ -48,6 +51,68 @@ namespace d14engine::uikit
         size_t indicatorPosition() const;
         virtual void setIndicatorPosition(size_t characterOffset);
 
+    public:
+        void onSearchFinish(size_t matchCount);
+
+        Function<void(LabelArea*, size_t)> f_onSearchFinish = {};
+
+    protected:
+        virtual void onSearchFinishHelper(size_t matchCount);
+
+    protected:
+        std::vector<Label::CharacterRange> m_searchMatches = {};
+
+        // The hit-test rectangles of all search matches.
+        std::vector<DWRITE_HIT_TEST_METRICS> m_searchMatchRects = {};
+
+        Wstring m_searchPattern = {};
+        text_utils::TextSearchOptions m_searchOptions = {};
+
+        text_utils::BackgroundSearch m_backgroundSearch = {};
+
+        // Drops the notifications from the cancelled searches.
+        size_t m_searchGeneration = 0;
+
+        bool m_isSearchFinishPending = false;
+
+        // Called in the UI thread when notified by the background search.
+        void takeSearchMatches();
+
+        bool m_isSearchRestartPending = false;
+
+        float m_searchRestartElapsedSecs = 0.0f;
+
+    public:
+        // While typing, the search restarts only after the text has not
+        // changed for this period, so that each keystroke does not copy
+        // and re-scan the whole text.
+        float searchRestartDelaySecs = 0.3f;
+
+        // Called when the text is modified, which drops the outdated matches
+        // and restarts the search (if any) with the pattern once the typing
+        // pauses (or immediately without the keyboard focus).
+        void scheduleSearchRestart();
+
+    public:
+        const std::vector<Label::CharacterRange>& searchMatches() const;
+
+        // Called when the text layout is rebuilt with the same text
+        // (e.g. resized), and the former rectangles are out of date.
+        void updateSearchMatchRects(size_t firstMatch = 0);
+
+        // Cancels the former search and finds all matches in the background.
+        // The matches are highlighted progressively as they are delivered.
+        void startSearch(WstrRefer pattern, const text_utils::TextSearchOptions& options = {});
+
+        // Also clears the highlighted matches and the pending restart.
+        void cancelSearch();
+
+        bool isSearching() const;
+
+        // Highlights the next (or previous) match from the indicator,
+        // wraps around at the end, and returns false if there is none.
+        bool findNext(WstrRefer pattern, const text_utils::TextSearchOptions& options = {}, bool backward = false);
+
     public:
         virtual void performCommandCtrlA();
         virtual void performCommandCtrlC();
@@ -57,6 +122,7 @@ namespace d14engine::uikit
         void onRendererUpdateObject2DHelper(renderer::Renderer* rndr) override;
 
         void drawHiliteRange(renderer::Renderer* rndr);
+        void drawSearchMatches(renderer::Renderer* rndr);
         void drawIndicator(renderer::Renderer* rndr);
         void onRendererDrawD2d1ObjectHelper(renderer::Renderer* rndr) override;
 
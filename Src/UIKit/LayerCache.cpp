@@ -0,0 +1,234 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/LayerCache.h"
+
+namespace d14engine::uikit
+{
+    LayerCache::LayerCache(size_t budget) : m_budget(budget) { }
+
+    LayerCache::~LayerCache()
+    {
+        for (auto& node : m_residents)
+        {
+            node->m_cache = nullptr;
+            node->m_bytes = 0;
+        }
+    }
+
+    LayerCache::Node::~Node()
+    {
+        if (m_cache != nullptr)
+        {
+            // The owner is being destroyed, so do not call back into it.
+            f_onRelease = nullptr;
+
+            m_cache->release(*this);
+        }
+        setParent(nullptr);
+
+        for (auto& child : m_children)
+        {
+            child->m_parent = nullptr;
+        }
+    }
+
+    LayerCache::Node* LayerCache::Node::parent() const
+    {
+        return m_parent;
+    }
+
+    void LayerCache::Node::setParent(Node* node)
+    {
+        if (m_parent == node) return;
+
+        if (m_parent != nullptr)
+        {
+            std::erase(m_parent->m_children, this);
+        }
+        m_parent = node;
+
+        if (m_parent != nullptr)
+        {
+            m_parent->m_children.push_back(this);
+        }
+    }
+
+    const std::vector<LayerCache::Node*>& LayerCache::Node::children() const
+    {
+        return m_children;
+    }
+
+    bool LayerCache::Node::dirty() const
+    {
+        return m_dirty;
+    }
+
+    void LayerCache::Node::invalidate()
+    {
+        // Do not stop at the dirty ones, since only the resident nodes
+        // are cleaned and a dirty one may be below a clean one.
+        for (auto node = this; node != nullptr; node = node->m_parent)
+        {
+            node->m_dirty = true;
+        }
+    }
+
+    bool LayerCache::Node::resident() const
+    {
+        return m_cache != nullptr;
+    }
+
+    size_t LayerCache::Node::bytes() const
+    {
+        return m_bytes;
+    }
+
+    uint64_t LayerCache::Node::lastUsedFrame() const
+    {
+        return m_lastUsedFrame;
+    }
+
+    size_t LayerCache::budget() const
+    {
+        return m_budget;
+    }
+
+    void LayerCache::setBudget(size_t bytes)
+    {
+        m_budget = bytes;
+
+        while (m_statistics.residentBytes > m_budget)
+        {
+            auto lru = std::min_element(m_residents.begin(), m_residents.end(),
+                [](Node* a, Node* b) { return a->m_lastUsedFrame < b->m_lastUsedFrame; });
+
+            evict(**lru);
+        }
+    }
+
+    LayerCache::Action LayerCache::acquire(Node& node, size_t bytes, uint64_t frame)
+    {
+        if (node.m_cache == this && node.m_bytes == bytes)
+        {
+            node.m_lastUsedFrame = frame;
+
+            if (!node.m_dirty)
+            {
+                ++m_statistics.hits;
+                return Action::Reuse;
+            }
+            node.m_dirty = false;
+
+            ++m_statistics.redraws;
+            return Action::Redraw;
+        }
+        // The size has changed or the node is from another cache.
+        if (node.m_cache != nullptr)
+        {
+            node.m_cache->release(node);
+        }
+        if (bytes == 0 || bytes > m_budget)
+        {
+            ++m_statistics.bypasses;
+            return Action::Bypass;
+        }
+        ////////////////////////
+        // Evict LRU Surfaces //
+        ////////////////////////
+
+        // The surfaces used in the last frame are likely to be used later
+        // in this one, and evicting them for those drawn earlier in the
+        // traversal would make the surfaces evict each other in turn.
+        auto isEvictable = [&](Node* resident)
+        {
+            return resident->m_lastUsedFrame + 1 < frame;
+        };
+        size_t available = m_budget - std::min(m_budget, m_statistics.residentBytes);
+
+        // Check first so that nothing is evicted in vain.
+        if (available < bytes)
+        {
+            size_t evictable = 0;
+            for (auto& resident : m_residents)
+            {
+                if (isEvictable(resident)) evictable += resident->m_bytes;
+            }
+            if (available + evictable < bytes)
+            {
+                ++m_statistics.bypasses;
+                return Action::Bypass;
+            }
+        }
+        while (m_statistics.residentBytes + bytes > m_budget)
+        {
+            Node* lru = nullptr;
+            for (auto& resident : m_residents)
+            {
+                if (isEvictable(resident) && (lru == nullptr ||
+                    resident->m_lastUsedFrame < lru->m_lastUsedFrame))
+                {
+                    lru = resident;
+                }
+            }
+            evict(*lru);
+        }
+        //////////////////////
+        // Make It Resident //
+        //////////////////////
+
+        m_residents.push_back(&node);
+        m_statistics.residentBytes += bytes;
+
+        node.m_cache = this;
+        node.m_bytes = bytes;
+        node.m_lastUsedFrame = frame;
+        node.m_dirty = false;
+
+        ++m_statistics.redraws;
+        return Action::Redraw;
+    }
+
+    void LayerCache::release(Node& node)
+    {
+        if (node.m_cache != this) return;
+
+        std::erase(m_residents, &node);
+        m_statistics.residentBytes -= node.m_bytes;
+
+        node.m_cache = nullptr;
+        node.m_bytes = 0;
+
+        if (node.f_onRelease) node.f_onRelease(&node);
+    }
+
+    void LayerCache::clear()
+    {
+        // f_onRelease may release the others, so take them one by one.
+        while (!m_residents.empty())
+        {
+            release(*m_residents.back());
+        }
+    }
+
+    void LayerCache::evict(Node& node)
+    {
+        ++m_statistics.evictions;
+
+        release(node);
+    }
+
+    const std::vector<LayerCache::Node*>& LayerCache::residents() const
+    {
+        return m_residents;
+    }
+
+    const LayerCache::Statistics& LayerCache::statistics() const
+    {
+        return m_statistics;
+    }
+
+    void LayerCache::resetStatistics()
+    {
+        m_statistics = { .residentBytes = m_statistics.residentBytes };
+    }
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+namespace d14engine::uikit
+{
+    // Book-keeps the offscreen surfaces of the cached subtrees (see
+    // Panel::setCachedLayer), which are redrawn only after invalidated and
+    // evicted in the least-recently-used order when over the budget.
+    //
+    // The cache only counts the bytes and decides what to draw, while the
+    // owners of the nodes create and release the actual surfaces, so that
+    // it does not depend on the graphics devices.
+
+    struct LayerCache : cpp_lang_utils::NonCopyable
+    {
+        LayerCache() = default;
+
+        explicit LayerCache(size_t budget);
+
+        ~LayerCache();
+
+        struct Node : cpp_lang_utils::NonCopyable
+        {
+            friend LayerCache;
+
+            Node() = default;
+
+            // Detaches from the tree and the cache without f_onRelease.
+            ~Node();
+
+            // Called when the surface is evicted or released by the cache,
+            // after which the owner should free it.
+            Function<void(Node*)> f_onRelease = {};
+
+        private:
+            Node* m_parent = nullptr;
+
+            std::vector<Node*> m_children = {};
+
+            bool m_dirty = true;
+
+            // Not null when the surface is resident.
+            LayerCache* m_cache = nullptr;
+
+            size_t m_bytes = 0;
+
+            uint64_t m_lastUsedFrame = 0;
+
+        public:
+            Node* parent() const;
+            void setParent(Node* node);
+
+            const std::vector<Node*>& children() const;
+
+            bool dirty() const;
+
+            // Marks the node and all its ancestors dirty, i.e. the change
+            // of a descendant is reported to every cached subtree above.
+            void invalidate();
+
+            bool resident() const;
+
+            size_t bytes() const;
+
+            uint64_t lastUsedFrame() const;
+        };
+
+    private:
+        size_t m_budget = 64 * 1024 * 1024;
+
+    public:
+        size_t budget() const;
+
+        // Evicts the surfaces till they fit in the budget.
+        void setBudget(size_t bytes);
+
+        enum class Action
+        {
+            // The surface is up to date and can be composited as is.
+            Reuse,
+            // The surface is resident (or has been made so) and should be
+            // redrawn before composited.
+            Redraw,
+            // The surface does not fit in the budget (or is empty), so the
+            // subtree should be drawn directly.
+            Bypass
+        };
+
+        // Called once per frame before drawing the subtree, where bytes is
+        // the size of its surface.  Only the surfaces not used in this frame
+        // and the last one are evicted for the others, so a surface that no
+        // longer fits is drawn directly for a frame before taking the place
+        // of the hidden ones.
+        Action acquire(Node& node, size_t bytes, uint64_t frame);
+
+        void release(Node& node);
+
+        // Releases all the resident surfaces.
+        void clear();
+
+    private:
+        std::vector<Node*> m_residents = {};
+
+        void evict(Node& node);
+
+    public:
+        struct Statistics
+        {
+            size_t residentBytes = 0;
+
+            uint64_t hits = 0, redraws = 0, bypasses = 0, evictions = 0;
+        };
+
+    private:
+        Statistics m_statistics = {};
+
+    public:
+        const std::vector<Node*>& residents() const;
+
+        const Statistics& statistics() const;
+
+        // Resets the counters, but not residentBytes.
+        void resetStatistics();
+    };
+}
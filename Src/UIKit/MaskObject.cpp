@@ -5,6 +5,8 @@
 #include "Common/DirectXError.h"
 #include "Common/MathUtils/2D.h"
 
+#include "Renderer/D2D1Recorder.h"
+
 #include "UIKit/Application.h"
 #include "UIKit/BitmapUtils.h"
 #include "UIKit/PlatformUtils.h"
@@ -58,4 +60,18 @@ namespace d14engine::uikit
         // SetTarget is called before BeginDraw, so the target is always valid
         // when BeginDraw called, otherwise the program may crash unexpectedly.
     }
+
+    void MaskObject::beginDraw(renderer::D2D1Recorder* recorder, const D2D1_MATRIX_3X2_F& transform)
+    {
+        // See the above for the order of SetTarget and BeginDraw.
+        recorder->SetTarget(data.Get());
+        recorder->BeginDraw();
+        recorder->SetTransform(transform);
+        recorder->Clear(color);
+    }
+
+    void MaskObject::endDraw(renderer::D2D1Recorder* recorder)
+    {
+        THROW_IF_FAILED(recorder->EndDraw());
+    }
 }
@@ -4,6 +4,8 @@
 
 #include "UIKit/BitmapObject.h"
 
+namespace d14engine::renderer { struct D2D1Recorder; }
+
 namespace d14engine::uikit
 {
     struct MaskObject : BitmapObject
@@ -23,5 +25,11 @@ namespace d14engine::uikit
         void beginDraw(ID2D1DeviceContext* context, const D2D1_MATRIX_3X2_F& transform = D2D1::Matrix3x2F::Identity());
 
         void endDraw(ID2D1DeviceContext* context);
+
+        // Same as above, except that the draw is begun and ended through the
+        // recorder so that its commands can be captured and batched.
+        void beginDraw(renderer::D2D1Recorder* recorder, const D2D1_MATRIX_3X2_F& transform = D2D1::Matrix3x2F::Identity());
+
+        void endDraw(renderer::D2D1Recorder* recorder);
     };
 }
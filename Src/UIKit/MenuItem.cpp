@@ -70,14 +70,14 @@ namespace d14engine::uikit
             auto rigthTop = math_utils::rightTop(m_absoluteRect);
             auto arrowOrg = math_utils::offset(rigthTop, { setting.geometry.rightOffset, 0.0f });
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(arrowOrg, setting.geometry.line0.point0),
             /* point1      */ math_utils::offset(arrowOrg, setting.geometry.line0.point1),
             /* brush       */ resource_utils::solidColorBrush(),
             /* strokeWidth */ setting.strokeWidth
             );
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(arrowOrg, setting.geometry.line1.point0),
             /* point1      */ math_utils::offset(arrowOrg, setting.geometry.line1.point1),
@@ -24,7 +24,7 @@ namespace d14engine::uikit
 
         auto& bkgnRect = m_absoluteRect;
 
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ math_utils::leftCenter(bkgnRect),
         /* point1      */ math_utils::rightCenter(bkgnRect),
@@ -40,6 +40,8 @@ namespace d14engine::uikit
 
     void OnOffSwitch::setOnOff(State::ActiveFlag flag)
     {
+        if (m_state.activeFlag != flag) invalidate();
+
         m_state.activeFlag = flag;
 
         StatefulObject::Event soe = {};
@@ -59,6 +61,8 @@ namespace d14engine::uikit
 
     void OnOffSwitch::setOnOffState(State::ActiveFlag flag)
     {
+        if (m_state.activeFlag != flag) invalidate();
+
         m_state.activeFlag = flag;
         m_stateDetail.flag = m_state.activeFlag;
 
@@ -180,7 +184,7 @@ namespace d14engine::uikit
             handleAbsoluteRect(),
             geoSetting.roundRadius, geoSetting.roundRadius
         };
-        rndr->d2d1DeviceContext()->FillRoundedRectangle
+        rndr->recorder2D()->FillRoundedRectangle
         (
         /* roundedRect */ handleRoundedRect,
         /* brush       */ resource_utils::solidColorBrush()
@@ -196,7 +200,7 @@ namespace d14engine::uikit
         auto frame = math_utils::inner(m_absoluteRect, setting.stroke.width);
         D2D1_ROUNDED_RECT outlineRect = { frame, roundRadiusX, roundRadiusY };
 
-        rndr->d2d1DeviceContext()->DrawRoundedRectangle
+        rndr->recorder2D()->DrawRoundedRectangle
         (
         /* roundedRect */ outlineRect,
         /* brush       */ resource_utils::solidColorBrush(),
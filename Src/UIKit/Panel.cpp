@@ -24,6 +24,10 @@ namespace d14engine::uikit
         ISortable<IDrawObject2D>::m_priority = 0;
         ISortable<Panel>::m_priority = 0;
 
+        m_layerNode.f_onRelease = [this](LayerCache::Node*)
+        {
+            m_layerMask.data.Reset();
+        };
         updateAbsoluteRect();
     }
 
@@ -53,6 +57,8 @@ namespace d14engine::uikit
 
         m_drawObjects.insert(uiobj);
 
+        invalidate();
+
         ///////////////////////
         // Update Priorities //
         ///////////////////////
@@ -79,6 +85,8 @@ namespace d14engine::uikit
 
         m_drawObjects.erase(uiobj);
 
+        invalidate();
+
         ///////////////////////
         // Update Priorities //
         ///////////////////////
@@ -95,6 +103,8 @@ namespace d14engine::uikit
 
     void Panel::setVisible(bool value)
     {
+        if (m_visible != value) invalidate();
+
         m_visible = value;
     }
 
@@ -105,6 +115,8 @@ namespace d14engine::uikit
 
     void Panel::setEnabled(bool value)
     {
+        if (m_enabled != value) invalidate();
+
         m_enabled = value;
 
         updateAppEventReactability();
@@ -112,11 +124,15 @@ namespace d14engine::uikit
 
     void Panel::setPrivateVisible(bool value)
     {
+        if (m_privateVisible != value) invalidate();
+
         m_privateVisible = value;
     }
 
     void Panel::setPrivateEnabled(bool value)
     {
+        if (m_privateEnabled != value) invalidate();
+
         m_privateEnabled = value;
 
         updateAppEventReactability();
@@ -152,6 +168,8 @@ namespace d14engine::uikit
         if (originalSize.width != updatedSize.width ||
             originalSize.height != updatedSize.height)
         {
+            invalidate();
+
             SizeEvent e = {};
             e.size = updatedSize;
 
@@ -166,6 +184,8 @@ namespace d14engine::uikit
         if (originalPosition.x != updatedPosition.x ||
             originalPosition.y != updatedPosition.y)
         {
+            invalidate();
+
             MoveEvent e = {};
             e.position = position();
 
@@ -381,6 +401,53 @@ namespace d14engine::uikit
         }
     }
 
+    void Panel::drawCachedLayer(Renderer* rndr)
+    {
+        auto pixSize = pixelSize();
+
+        if (m_layerMask.data == nullptr ||
+            m_layerMask.data->GetPixelSize().width != pixSize.width ||
+            m_layerMask.data->GetPixelSize().height != pixSize.height)
+        {
+            m_layerMask.loadBitmap(size());
+        }
+        auto maskTrans = D2D1::Matrix3x2F::Translation
+        (
+            -m_absoluteRect.left, -m_absoluteRect.top
+        );
+        m_drawingLayer = true;
+
+        m_layerMask.beginDraw(rndr->recorder2D(), maskTrans);
+        {
+            onRendererDrawD2d1Object(rndr);
+        }
+        m_layerMask.endDraw(rndr->recorder2D());
+
+        m_drawingLayer = false;
+    }
+
+    bool Panel::cachedLayer() const
+    {
+        return m_cachedLayer;
+    }
+
+    void Panel::setCachedLayer(bool value)
+    {
+        m_cachedLayer = value;
+
+        if (!m_cachedLayer && m_layerNode.resident())
+        {
+            THROW_IF_NULL(Application::g_app);
+
+            Application::g_app->layerCache().release(m_layerNode);
+        }
+    }
+
+    void Panel::invalidate()
+    {
+        m_layerNode.invalidate();
+    }
+
     void Panel::updateChildrenObjects(Renderer* rndr)
     {
         for (auto& drawobj : m_drawObjects)
@@ -407,7 +474,7 @@ namespace d14engine::uikit
     {
         if (brush)
         {
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ { m_absoluteRect, roundRadiusX, roundRadiusY },
             /* brush       */ brush.Get()
@@ -422,7 +489,7 @@ namespace d14engine::uikit
             }
             else mode = BitmapObject::g_interpolationMode;
 
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ bitmap.Get(),
             /* destinationRectangle */ m_absoluteRect,
@@ -524,6 +591,9 @@ namespace d14engine::uikit
             uiobj->m_parent.lock()->removeUIObject(uiobj);
         }
         uiobj->m_parent = shared_from_this();
+        uiobj->m_layerNode.setParent(&m_layerNode);
+
+        invalidate();
 
         /////////////////////
         // Update Geometry //
@@ -566,6 +636,9 @@ namespace d14engine::uikit
             ///////////////////
 
             uiobj->m_parent.reset();
+            uiobj->m_layerNode.setParent(nullptr);
+
+            invalidate();
 
             /////////////////////
             // Update Geometry //
@@ -592,11 +665,14 @@ namespace d14engine::uikit
         for (auto& child : m_children)
         {
             child->m_parent.reset();
+            child->m_layerNode.setParent(nullptr);
             child->m_rect = child->m_absoluteRect;
         }
         m_drawObjects.clear();
         m_children.clear();
 
+        invalidate();
+
         m_frontPriorities = {};
         m_backPriorities = {};
     }
@@ -759,8 +835,6 @@ namespace d14engine::uikit
 
         auto& app = Application::g_app;
 
-        app->renderer()->waitGpuCommand();
-
         bool isReleased = true;
 
         // After Step 1, the ref-count of this may be 0 if it is released
@@ -768,6 +842,11 @@ namespace d14engine::uikit
         // callback in Step 2 could be triggered correctly (if it exists).
         auto temporaryLocked = shared_from_this();
 
+        // The resources of this may be still used by the commands in flight,
+        // so the destruction is deferred until the current frame completes
+        // instead of waiting for the GPU here.
+        app->renderer()->retire(temporaryLocked);
+
         /////////////////////////////////
         // Step 1 - Update Collections //
         /////////////////////////////////
@@ -793,7 +872,8 @@ namespace d14engine::uikit
     {
         THROW_IF_NULL(Application::g_app);
 
-        Application::g_app->renderer()->waitGpuCommand();
+        // Deferred like release (see the comment there).
+        Application::g_app->renderer()->retire(uiobj);
 
         if (f_onReleaseUIObject)
         {
@@ -813,6 +893,8 @@ namespace d14engine::uikit
 
     void Panel::onGetMouseFocus()
     {
+        invalidate();
+
         onGetMouseFocusHelper();
 
         if (f_onGetMouseFocus) f_onGetMouseFocus(this);
@@ -820,6 +902,8 @@ namespace d14engine::uikit
 
     void Panel::onGetKeyboardFocus()
     {
+        invalidate();
+
         onGetKeyboardFocusHelper();
 
         if (f_onGetKeyboardFocus) f_onGetKeyboardFocus(this);
@@ -827,6 +911,8 @@ namespace d14engine::uikit
 
     void Panel::onLoseMouseFocus()
     {
+        invalidate();
+
         onLoseMouseFocusHelper();
 
         if (f_onLoseMouseFocus) f_onLoseMouseFocus(this);
@@ -834,6 +920,8 @@ namespace d14engine::uikit
 
     void Panel::onLoseKeyboardFocus()
     {
+        invalidate();
+
         onLoseKeyboardFocusHelper();
 
         if (f_onLoseKeyboardFocus) f_onLoseKeyboardFocus(this);
@@ -919,6 +1007,8 @@ namespace d14engine::uikit
 
     void Panel::onMouseEnter(MouseMoveEvent& e)
     {
+        invalidate();
+
         onMouseEnterHelper(e);
 
         if (f_onMouseEnter) f_onMouseEnter(this, e);
@@ -933,6 +1023,8 @@ namespace d14engine::uikit
 
     void Panel::onMouseLeave(MouseMoveEvent& e)
     {
+        invalidate();
+
         onMouseLeaveHelper(e);
 
         if (f_onMouseLeave) f_onMouseLeave(this, e);
@@ -961,6 +1053,8 @@ namespace d14engine::uikit
 
     void Panel::onChangeThemeStyle(const ThemeStyle& style)
     {
+        invalidate();
+
         onChangeThemeStyleHelper(style);
 
         if (f_onChangeThemeStyle) f_onChangeThemeStyle(this, style);
@@ -968,6 +1062,8 @@ namespace d14engine::uikit
 
     void Panel::onChangeLangLocale(WstrRefer codeName)
     {
+        invalidate();
+
         onChangeLangLocaleHelper(codeName);
 
         if (f_onChangeLangLocale) f_onChangeLangLocale(this, codeName);
@@ -980,11 +1076,16 @@ namespace d14engine::uikit
 
     void Panel::setD2d1ObjectVisible(bool value)
     {
+        if (m_visible != value) invalidate();
+
         m_visible = value; // no for private
     }
 
     void Panel::onRendererUpdateObject2D(Renderer* rndr)
     {
+        // The animations change the appearance in each frame.
+        if (m_isPlayAnimation) invalidate();
+
         if (f_onRendererUpdateObject2DBefore)
         {
             f_onRendererUpdateObject2DBefore(this, rndr);
@@ -1001,6 +1102,22 @@ namespace d14engine::uikit
 
     void Panel::onRendererDrawD2d1Layer(Renderer* rndr)
     {
+        auto action = LayerCache::Action::Bypass;
+        if (m_cachedLayer)
+        {
+            THROW_IF_NULL(Application::g_app);
+
+            auto pixSize = pixelSize();
+
+            action = Application::g_app->layerCache().acquire
+            (
+            /* node  */ m_layerNode,
+            /* bytes */ (size_t)pixSize.width * pixSize.height * 4,
+            /* frame */ rndr->frameCount()
+            );
+            // The surface is up to date, and so are the layers in it.
+            if (action == LayerCache::Action::Reuse) return;
+        }
         if (f_onRendererDrawD2d1LayerBefore)
         {
             f_onRendererDrawD2d1LayerBefore(this, rndr);
@@ -1013,10 +1130,26 @@ namespace d14engine::uikit
         {
             f_onRendererDrawD2d1LayerAfter(this, rndr);
         }
+        if (action == LayerCache::Action::Redraw)
+        {
+            drawCachedLayer(rndr);
+        }
     }
 
     void Panel::onRendererDrawD2d1Object(Renderer* rndr)
     {
+        if (m_cachedLayer && !m_drawingLayer && m_layerMask.data &&
+            m_layerNode.resident() && !m_layerNode.dirty())
+        {
+            rndr->recorder2D()->DrawBitmap
+            (
+            /* bitmap               */ m_layerMask.data.Get(),
+            /* destinationRectangle */ m_absoluteRect,
+            /* opacity              */ m_layerMask.opacity,
+            /* interpolationMode    */ m_layerMask.getInterpolationMode()
+            );
+            return;
+        }
         if (f_onRendererDrawD2d1ObjectBefore)
         {
             f_onRendererDrawD2d1ObjectBefore(this, rndr);
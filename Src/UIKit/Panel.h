@@ -10,6 +10,7 @@
 
 #include "UIKit/Application.h"
 #include "UIKit/Event.h"
+#include "UIKit/MaskObject.h"
 
 namespace d14engine::uikit
 {
@@ -184,6 +185,45 @@ namespace d14engine::uikit
         void increaseAnimationCount();
         void decreaseAnimationCount();
 
+        //------------------------------------------------------------------
+        // Cached Layer
+        //------------------------------------------------------------------
+    protected:
+        bool m_cachedLayer = false;
+
+        // Linked to those of the parent and the children in the UI object
+        // tree, so that the changes are reported to the cached ancestors.
+        LayerCache::Node m_layerNode = {};
+
+        MaskObject m_layerMask = {};
+
+        // Whether the subtree is being drawn into m_layerMask.
+        bool m_drawingLayer = false;
+
+    public:
+        // In the cached-layer mode, the subtree (including this panel) is
+        // drawn into an offscreen surface of the size of the panel, and the
+        // later frames composite the surface instead of drawing the subtree
+        // (and skip its layer pass) until any panel in it is invalidated.
+        // The subtree is clipped by the panel in this mode.
+        //
+        // The panels are invalidated automatically when they are resized,
+        // moved, shown, hidden, enabled, disabled, added, removed, hovered,
+        // focused, change the theme or the locale, or play animations, and
+        // the widgets also invalidate themselves when their states change
+        // (e.g. pressing a button, the text and the caret of a label, the
+        // offset of a scroll view or the value of a slider).  The other UI
+        // events (moving the mouse inside, the wheel, the keys) do not, so
+        // the changes made in their callbacks (or directly, e.g. setting a
+        // brush) should be followed by calling invalidate.
+        //
+        // The surfaces share the budget of Application::layerCache, and the
+        // panels whose surfaces do not fit in it are drawn directly.
+        bool cachedLayer() const;
+        void setCachedLayer(bool value);
+
+        void invalidate();
+
     protected:
         using Renderer = renderer::Renderer;
 
@@ -193,6 +233,8 @@ namespace d14engine::uikit
         void drawBackground(Renderer* rndr);
         void drawChildrenObjects(Renderer* rndr);
 
+        void drawCachedLayer(Renderer* rndr);
+
     public:
         virtual void drawD2d1ObjectPreceding(Renderer* rndr);
         virtual void drawD2d1ObjectPosterior(Renderer* rndr);
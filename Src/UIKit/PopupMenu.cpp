@@ -211,7 +211,7 @@ namespace d14engine::uikit
         // Shape of Shadow //
         /////////////////////
 
-        shadow.beginDraw(rndr->d2d1DeviceContext());
+        shadow.beginDraw(rndr->recorder2D());
         {
             auto& geoSetting = appearance().geometry;
             auto& shadowSetting = appearance().shadow;
@@ -226,13 +226,13 @@ namespace d14engine::uikit
                 math_utils::moveVertex(extRect, shadowSetting.offset),
                 geoSetting.roundRadius, geoSetting.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ shadowRect,
             /* brush       */ resource_utils::solidColorBrush()
             );
         }
-        shadow.endDraw(rndr->d2d1DeviceContext());
+        shadow.endDraw(rndr->recorder2D());
     }
 
     void PopupMenu::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
@@ -252,7 +252,7 @@ namespace d14engine::uikit
         auto leftTop = absolutePosition();
         auto shadowLeftTop = math_utils::increaseY(leftTop, -geoSetting.extension);
 
-        rndr->d2d1DeviceContext()->DrawImage
+        rndr->recorder2D()->DrawImage
         (
         /* effect       */ resource_utils::shadowEffect(),
         /* targetOffset */ shadowLeftTop
@@ -272,7 +272,7 @@ namespace d14engine::uikit
             math_utils::stretch(m_absoluteRect, { 0.0f, geoSetting.extension }),
             geoSetting.roundRadius, geoSetting.roundRadius
         };
-        rndr->d2d1DeviceContext()->FillRoundedRectangle
+        rndr->recorder2D()->FillRoundedRectangle
         (
         /* roundedRect */ extRect,
         /* brush       */ resource_utils::solidColorBrush()
@@ -75,6 +75,9 @@ namespace d14engine::uikit
         {
             LabelArea::setText(text);
 
+            // The deltas are meaningless once the whole content is replaced.
+            m_editHistory.clear();
+
             onTextChange(m_text);
         }
     }
@@ -96,6 +99,9 @@ namespace d14engine::uikit
 
         m_visibleTextMask.loadBitmap(maskWidth, maskHeight);
 
+        // The text may be wrapped differently with the new width.
+        updateSearchMatchRects();
+
         m_placeholder->transform(m_visibleTextRect);
     }
 
@@ -174,6 +180,42 @@ namespace d14engine::uikit
         setTextContentOffset(originalOffset);
     }
 
+    void RawTextInput::insertTextFragmentRecorded(WstrRefer fragment, size_t offset)
+    {
+        auto originalSize = m_text.size();
+
+        insertTextFragment(fragment, offset);
+
+        // The fragment may be preprocessed before inserted (e.g. cut off at line breaks),
+        // so the actually inserted text is picked up from the updated content instead.
+        m_editHistory.recordInsert(offset, m_text.substr(offset, m_text.size() - originalSize));
+    }
+
+    void RawTextInput::eraseTextFragmentRecorded(const CharacterRange& range)
+    {
+        auto validOffset = std::clamp<size_t>(range.offset, 0, m_text.size());
+        auto validCount = std::clamp<size_t>(range.count, 0, m_text.size() - validOffset);
+
+        m_editHistory.recordErase(validOffset, m_text.substr(validOffset, validCount));
+
+        eraseTextFragment({ validOffset, validCount });
+    }
+
+    void RawTextInput::applyEditHistoryDelta(const text_utils::EditHistory::Delta& delta)
+    {
+        // The text layout is updated only once after all deltas are applied.
+        if (delta.type == text_utils::EditHistory::Delta::Type::Insert)
+        {
+            m_text.insert(delta.offset, delta.text);
+        }
+        else m_text.erase(delta.offset, delta.text.size());
+    }
+
+    text_utils::EditHistory& RawTextInput::editHistory()
+    {
+        return m_editHistory;
+    }
+
     void RawTextInput::performCommandCtrlX()
     {
         auto hiliteStr = m_text.substr
@@ -183,7 +225,7 @@ namespace d14engine::uikit
         );
         resource_utils::setClipboardText(hiliteStr);
 
-        eraseTextFragment(m_hiliteRange);
+        eraseTextFragmentRecorded(m_hiliteRange);
 
         setIndicatorPosition(m_hiliteRange.offset);
 
@@ -200,8 +242,10 @@ namespace d14engine::uikit
         {
             if (m_hiliteRange.count > 0)
             {
-                eraseTextFragment(m_hiliteRange);
-                insertTextFragment(content.value(), m_hiliteRange.offset);
+                m_editHistory.beginGroup();
+                eraseTextFragmentRecorded(m_hiliteRange);
+                insertTextFragmentRecorded(content.value(), m_hiliteRange.offset);
+                m_editHistory.endGroup();
 
                 setIndicatorPosition(m_hiliteRange.offset + content.value().size());
 
@@ -209,7 +253,7 @@ namespace d14engine::uikit
             }
             else // Insert at the indicator.
             {
-                insertTextFragment(content.value(), m_indicatorCharacterOffset);
+                insertTextFragmentRecorded(content.value(), m_indicatorCharacterOffset);
 
                 setIndicatorPosition(m_indicatorCharacterOffset + content.value().size());
             }
@@ -217,12 +261,94 @@ namespace d14engine::uikit
         }
     }
 
+    void RawTextInput::performCommandCtrlZ()
+    {
+        auto caret = m_editHistory.undo([this](const auto& delta)
+        {
+            applyEditHistoryDelta(delta);
+        });
+        if (caret.has_value())
+        {
+            m_textLayout = getTextLayout();
+            updateTextOverhangMetrics();
+
+            setHiliteRange({ 0, 0 });
+            setIndicatorPosition(caret.value());
+
+            onTextChange(m_text);
+        }
+    }
+
+    void RawTextInput::performCommandCtrlY()
+    {
+        auto caret = m_editHistory.redo([this](const auto& delta)
+        {
+            applyEditHistoryDelta(delta);
+        });
+        if (caret.has_value())
+        {
+            m_textLayout = getTextLayout();
+            updateTextOverhangMetrics();
+
+            setHiliteRange({ 0, 0 });
+            setIndicatorPosition(caret.value());
+
+            onTextChange(m_text);
+        }
+    }
+
+    size_t RawTextInput::replaceAll(
+        WstrRefer pattern, WstrRefer replacement,
+        const text_utils::TextSearchOptions& options)
+    {
+        if (!editable) return 0;
+
+        text_utils::TextSearch search(pattern, options);
+
+        size_t count = 0;
+        auto result = search.replaceAll(m_text, replacement, &count);
+
+        if (count == 0) return 0;
+
+        auto out = preprocessInputStr(result);
+        if (out.has_value()) result = std::move(out.value());
+
+        // Records only the span between the first and last differences,
+        // which is far more compact than the whole text, and undoing it
+        // takes a single pass instead of one per replaced match.
+        auto prefix = (size_t)std::distance(m_text.begin(),
+            std::mismatch(m_text.begin(), m_text.end(), result.begin(), result.end()).first);
+
+        auto maxSuffix = std::min(m_text.size(), result.size()) - prefix;
+        auto suffix = (size_t)std::distance(m_text.rbegin(),
+            std::mismatch(m_text.rbegin(), m_text.rbegin() + maxSuffix, result.rbegin()).first);
+
+        m_editHistory.beginGroup();
+        m_editHistory.recordErase(prefix, m_text.substr(prefix, m_text.size() - prefix - suffix));
+        m_editHistory.recordInsert(prefix, result.substr(prefix, result.size() - prefix - suffix));
+        m_editHistory.endGroup();
+
+        m_text = std::move(result);
+
+        m_textLayout = getTextLayout();
+        updateTextOverhangMetrics();
+
+        setHiliteRange({ 0, 0 });
+        setIndicatorPosition(std::min(m_indicatorCharacterOffset, m_text.size()));
+
+        onTextChange(m_text);
+
+        return count;
+    }
+
     void RawTextInput::changeCandidateText(WstrRefer str)
     {
         if (m_hiliteRange.count > 0)
         {
-            eraseTextFragment(m_hiliteRange);
-            insertTextFragment(str, m_hiliteRange.offset);
+            m_editHistory.beginGroup();
+            eraseTextFragmentRecorded(m_hiliteRange);
+            insertTextFragmentRecorded(str, m_hiliteRange.offset);
+            m_editHistory.endGroup();
 
             setIndicatorPosition(m_hiliteRange.offset + str.size());
 
@@ -230,7 +356,7 @@ namespace d14engine::uikit
         }
         else // Insert at the indicator.
         {
-            insertTextFragment(str, m_indicatorCharacterOffset);
+            insertTextFragmentRecorded(str, m_indicatorCharacterOffset);
 
             setIndicatorPosition(m_indicatorCharacterOffset + str.size());
         }
@@ -251,7 +377,7 @@ namespace d14engine::uikit
         m_visibleTextMask.color = Label::appearance().background.color;
         m_visibleTextMask.color.a = Label::appearance().background.opacity;
 
-        m_visibleTextMask.beginDraw(rndr->d2d1DeviceContext());
+        m_visibleTextMask.beginDraw(rndr->recorder2D());
         {
             // Placeholder
             if (m_placeholder->isD2d1ObjectVisible() && m_text.empty())
@@ -260,7 +386,7 @@ namespace d14engine::uikit
                 (
                     -m_placeholder->absoluteX(), -m_placeholder->absoluteY()
                 );
-                rndr->d2d1DeviceContext()->SetTransform(placeholderTrans);
+                rndr->recorder2D()->SetTransform(placeholderTrans);
 
                 m_placeholder->onRendererDrawD2d1Object(rndr);
             }
@@ -270,12 +396,12 @@ namespace d14engine::uikit
                 - (m_absoluteRect.left + m_textContentOffset.x),
                 - (m_absoluteRect.top  + m_textContentOffset.y)
             );
-            rndr->d2d1DeviceContext()->SetTransform(textContentTrans);
+            rndr->recorder2D()->SetTransform(textContentTrans);
 
             // The indicator will be drawn above the visible text mask.
-            drawHiliteRange(rndr); drawText(rndr); /* drawIndicator(rndr); */
+            drawSearchMatches(rndr); drawHiliteRange(rndr); drawText(rndr); /* drawIndicator(rndr); */
         }
-        m_visibleTextMask.endDraw(rndr->d2d1DeviceContext());
+        m_visibleTextMask.endDraw(rndr->recorder2D());
     }
 
     void RawTextInput::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
@@ -292,7 +418,7 @@ namespace d14engine::uikit
 
         auto dstRect = math_utils::roundf(selfCoordToAbsolute(m_visibleTextRect));
 
-        rndr->d2d1DeviceContext()->DrawBitmap
+        rndr->recorder2D()->DrawBitmap
         (
         /* bitmap               */ m_visibleTextMask.data.Get(),
         /* destinationRectangle */ dstRect,
@@ -305,14 +431,14 @@ namespace d14engine::uikit
         //////////////////
 
         D2D1_MATRIX_3X2_F originalTrans = {};
-        rndr->d2d1DeviceContext()->GetTransform(&originalTrans);
+        rndr->recorder2D()->GetTransform(&originalTrans);
 
         auto indicatorTrans = D2D1::Matrix3x2F::Translation
         (
             std::round(m_visibleTextRect.left - m_textContentOffset.x),
             std::round(m_visibleTextRect.top  - m_textContentOffset.y)
         );
-        rndr->d2d1DeviceContext()->SetTransform(originalTrans * indicatorTrans);
+        rndr->recorder2D()->SetTransform(originalTrans * indicatorTrans);
         {
             indicatorConstrainedRect = math_utils::rect
             (
@@ -320,7 +446,7 @@ namespace d14engine::uikit
             );
             drawIndicator(rndr); // Vertical Line Caret
         }
-        rndr->d2d1DeviceContext()->SetTransform(originalTrans);
+        rndr->recorder2D()->SetTransform(originalTrans);
 
         /////////////
         // Outline //
@@ -348,7 +474,7 @@ namespace d14engine::uikit
         auto brush = resource_utils::solidColorBrush();
         float strokeWidth = appearance().bottomLine.strokeWidth;
 
-        rndr->d2d1DeviceContext()->DrawLine(point0, point1, brush, strokeWidth);
+        rndr->recorder2D()->DrawLine(point0, point1, brush, strokeWidth);
     }
 
     void RawTextInput::onSizeHelper(SizeEvent& e)
@@ -373,6 +499,17 @@ namespace d14engine::uikit
         appearance().changeTheme(Label::appearance(), style.name);
     }
 
+    void RawTextInput::onMouseButtonHelper(MouseButtonEvent& e)
+    {
+        LabelArea::onMouseButtonHelper(e);
+
+        // Relocating the indicator ends the current typing group.
+        if (e.state.leftDown() || e.state.leftDblclk())
+        {
+            m_editHistory.seal();
+        }
+    }
+
     void RawTextInput::onKeyboardHelper(KeyboardEvent& e)
     {
         LabelArea::onKeyboardHelper(e);
@@ -389,7 +526,7 @@ namespace d14engine::uikit
                 {
                     if (m_hiliteRange.count > 0) // Remove the hilite text.
                     {
-                        eraseTextFragment(m_hiliteRange);
+                        eraseTextFragmentRecorded(m_hiliteRange);
 
                         setIndicatorPosition(m_hiliteRange.offset);
 
@@ -399,7 +536,7 @@ namespace d14engine::uikit
                     }
                     else if (m_indicatorCharacterOffset > 0) // Remove single character.
                     {
-                        eraseTextFragment({ m_indicatorCharacterOffset - 1, 1 });
+                        eraseTextFragmentRecorded({ m_indicatorCharacterOffset - 1, 1 });
 
                         setIndicatorPosition(m_indicatorCharacterOffset - 1);
 
@@ -428,18 +565,21 @@ namespace d14engine::uikit
             }
             case VK_END:
             {
+                m_editHistory.seal();
                 setHiliteRange({ 0, 0 });
                 setIndicatorPosition(m_text.size());
                 break;
             }
             case VK_HOME:
             {
+                m_editHistory.seal();
                 setHiliteRange({ 0, 0 });
                 setIndicatorPosition(0);
                 break;
             }
             case VK_LEFT:
             {
+                m_editHistory.seal();
                 if (m_hiliteRange.count == 0)
                 {
                     auto intOffset = (int)m_indicatorCharacterOffset;
@@ -456,6 +596,7 @@ namespace d14engine::uikit
             }
             case VK_RIGHT:
             {
+                m_editHistory.seal();
                 if (m_hiliteRange.count == 0)
                 {
                     setIndicatorPosition(m_indicatorCharacterOffset + 1);
@@ -474,7 +615,7 @@ namespace d14engine::uikit
                 {
                     if (m_hiliteRange.count > 0) // Remove hilite text.
                     {
-                        eraseTextFragment(m_hiliteRange);
+                        eraseTextFragmentRecorded(m_hiliteRange);
 
                         setIndicatorPosition(m_hiliteRange.offset);
 
@@ -484,7 +625,7 @@ namespace d14engine::uikit
                     }
                     else if (m_indicatorCharacterOffset >= 0 && m_text.size() > 0)
                     {
-                        eraseTextFragment({ m_indicatorCharacterOffset, 1 });
+                        eraseTextFragmentRecorded({ m_indicatorCharacterOffset, 1 });
 
                         onTextChange(m_text);
                     }
@@ -501,6 +642,14 @@ namespace d14engine::uikit
                         {
                         case 'X': performCommandCtrlX(); break;
                         case 'V': performCommandCtrlV(); break;
+                        case 'Y': performCommandCtrlY(); break;
+                        case 'Z':
+                        {
+                            // Ctrl+Shift+Z is an alternative shortcut for redo.
+                            if (e.SHIFT()) performCommandCtrlY();
+                            else performCommandCtrlZ();
+                            break;
+                        }
                         default: break;
                         }
                     }
@@ -559,4 +708,13 @@ namespace d14engine::uikit
             if (str.size() != 1 || str[0] >= L' ') changeCandidateText(str);
         }
     }
+
+    void RawTextInput::onTextChangeHelper(WstrRefer text)
+    {
+        TextInputObject::onTextChangeHelper(text);
+
+        // The former matches are out of date, so re-runs the search
+        // (debounced while typing).
+        scheduleSearchRestart();
+    }
 }
@@ -6,6 +6,7 @@
 #include "UIKit/LabelArea.h"
 #include "UIKit/MaskObject.h"
 #include "UIKit/TextInputObject.h"
+#include "UIKit/TextUtils/EditHistory.h"
 
 namespace d14engine::uikit
 {
@@ -68,10 +69,31 @@ namespace d14engine::uikit
         // Override to take m_textContentOffset into consideration.
         void setIndicatorPosition(size_t characterOffset) override;
 
+    protected:
+        text_utils::EditHistory m_editHistory = {};
+
+        // These modify the text content and record the deltas for undo/redo.
+        void insertTextFragmentRecorded(WstrRefer fragment, size_t offset);
+        void eraseTextFragmentRecorded(const CharacterRange& range);
+
+        void applyEditHistoryDelta(const text_utils::EditHistory::Delta& delta);
+
+    public:
+        text_utils::EditHistory& editHistory();
+
     public:
         virtual void performCommandCtrlX();
         virtual void performCommandCtrlV();
 
+        virtual void performCommandCtrlZ(); // Undo
+        virtual void performCommandCtrlY(); // Redo
+
+        // Replaces all matches as one undo-able modification,
+        // and returns the count of the replaced matches.
+        size_t replaceAll(
+            WstrRefer pattern, WstrRefer replacement,
+            const text_utils::TextSearchOptions& options = {});
+
     public:
         void changeCandidateText(WstrRefer str);
 
@@ -86,6 +108,8 @@ namespace d14engine::uikit
 
         void onChangeThemeStyleHelper(const ThemeStyle& style) override;
 
+        void onMouseButtonHelper(MouseButtonEvent& e) override;
+
         void onKeyboardHelper(KeyboardEvent& e) override;
 
     public:
@@ -95,5 +119,7 @@ namespace d14engine::uikit
 
     protected:
         void onInputStringHelper(WstrRefer str) override;
+
+        void onTextChangeHelper(WstrRefer text) override;
     };
 }
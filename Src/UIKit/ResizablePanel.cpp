@@ -195,7 +195,7 @@ namespace d14engine::uikit
             auto frame = math_utils::inner(m_sizingRect, frameSetting.strokeWidth);
             D2D1_ROUNDED_RECT outlineRect = { relativeToAbsolute(frame), roundRadiusX, roundRadiusY };
 
-            rndr->d2d1DeviceContext()->DrawRoundedRectangle
+            rndr->recorder2D()->DrawRoundedRectangle
             (
             /* roundedRect */ outlineRect,
             /* brush       */ resource_utils::solidColorBrush(),
@@ -10,8 +10,12 @@ namespace d14engine::uikit::resource_utils
 {
     void initialize()
     {
-        systemFonts(true);
-        loadBasicTextFormats();
+        THROW_IF_NULL(Application::g_app);
+
+        fontCatalog().setting.cacheFilePath =
+            Application::g_app->createInfo.fontCachePath;
+
+        fontCatalog().prefetch();
 
         loadCommonBrushes();
         loadCommonEffects();
@@ -23,7 +27,8 @@ namespace d14engine::uikit::resource_utils
 
         FontDetailSet fonts = {};
 
-        auto factory = Application::g_app->renderer()->dwriteFactory();
+        // Holds a reference since this may run in a worker thread.
+        ComPtr<IDWriteFactory3> factory = Application::g_app->renderer()->dwriteFactory();
 
         /////////////////////
         // Font Collection //
@@ -74,11 +79,52 @@ namespace d14engine::uikit::resource_utils
         return fonts;
     }
 
-    FontDetailSet g_systemFonts = {};
+    Optional<uint64_t> fontDirectoryFingerprint()
+    {
+        std::vector<std::filesystem::path> directories = {};
+
+        WCHAR windowsDirectory[MAX_PATH] = {};
+        auto length = GetWindowsDirectoryW(windowsDirectory, MAX_PATH);
+        if (length == 0 || length >= MAX_PATH) return std::nullopt;
+
+        directories.push_back(std::filesystem::path(windowsDirectory) / L"Fonts");
+
+        // The fonts installed for the current user only (since Windows 10 1809).
+        WCHAR localAppData[MAX_PATH] = {};
+        length = GetEnvironmentVariableW(L"LOCALAPPDATA", localAppData, MAX_PATH);
+        if (length > 0 && length < MAX_PATH)
+        {
+            directories.push_back(std::filesystem::path(localAppData) / L"Microsoft/Windows/Fonts");
+        }
+        // FNV-1a over the write time of each directory, which is updated
+        // whenever an entry is added to or removed from the directory.
+        uint64_t digest = 0xcbf29ce484222325;
+        for (auto& directory : directories)
+        {
+            std::error_code error = {};
+            auto writeTime = std::filesystem::last_write_time(directory, error);
+
+            // A missing per-user directory is also a valid state.
+            int64_t ticks = error ? -1 : (int64_t)writeTime.time_since_epoch().count();
+
+            auto bytes = (const BYTE*)&ticks;
+            for (size_t i = 0; i < sizeof(ticks); ++i)
+            {
+                digest = (digest ^ bytes[i]) * 0x100000001b3;
+            }
+        }
+        return digest;
+    }
+
+    text_utils::FontCatalog& fontCatalog()
+    {
+        static text_utils::FontCatalog catalog(querySystemFonts, fontDirectoryFingerprint);
+        return catalog;
+    }
 
     const FontDetailSet& systemFonts(bool query)
     {
-        return query ? (g_systemFonts = querySystemFonts()) : g_systemFonts;
+        return query ? fontCatalog().refresh() : fontCatalog().fonts();
     }
 
     TextFormatMap g_textFormats = {};
@@ -112,15 +158,11 @@ namespace d14engine::uikit::resource_utils
         return textFormat;
     }
 
-    void loadBasicTextFormats()
+    namespace
     {
-        for (int size = 9; size <= 36; ++size)
+        TextFormatDetail defaultTextFormatDetail(int size)
         {
-            Wstring name =
-            {
-                L"Default/" + std::to_wstring(size)
-            };
-            TextFormatDetail detail =
+            return
             {
                 .font =
                 {
@@ -129,7 +171,53 @@ namespace d14engine::uikit::resource_utils
                 },
                 .size = (float)size
             };
-            loadTextFormat(name, detail);
+        }
+
+        // Returns the N of "Default/N" (or nullopt if not in the form).
+        Optional<int> defaultTextFormatSize(WstrViewRefer name)
+        {
+            constexpr WstringView prefix = L"Default/";
+
+            if (!name.starts_with(prefix)) return std::nullopt;
+
+            auto digits = name.substr(prefix.size());
+
+            // A larger size is meaningless and might overflow the int.
+            if (digits.empty() || digits.size() > 4 || digits[0] == L'0')
+            {
+                return std::nullopt;
+            }
+            int size = 0;
+            for (auto ch : digits)
+            {
+                if (ch < L'0' || ch > L'9') return std::nullopt;
+                size = size * 10 + (ch - L'0');
+            }
+            return size;
+        }
+    }
+
+    IDWriteTextFormat* textFormat(WstrRefer name)
+    {
+        auto itor = g_textFormats.find(name);
+        if (itor != g_textFormats.end())
+        {
+            return itor->second.Get();
+        }
+        auto size = defaultTextFormatSize(name);
+        if (size.has_value())
+        {
+            return loadTextFormat(name, defaultTextFormatDetail(size.value())).Get();
+        }
+        // Throws std::out_of_range as the former textFormats().at(name).
+        return g_textFormats.at(name).Get();
+    }
+
+    void loadBasicTextFormats()
+    {
+        for (int size = 9; size <= 36; ++size)
+        {
+            loadTextFormat(L"Default/" + std::to_wstring(size), defaultTextFormatDetail(size));
         }
     }
 
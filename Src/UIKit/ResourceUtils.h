@@ -2,37 +2,38 @@
 
 #include "Common/Precompile.h"
 
+#include "UIKit/TextUtils/FontCatalog.h"
+
 namespace d14engine::uikit::resource_utils
 {
     void initialize();
 
 #pragma region Font
 
-    struct FontDetail
-    {
-        Wstring family = {};
-        Wstring locale = {};
-    };
-    struct FontDetailLess
-    {
-        bool operator()(const FontDetail& lhs, const FontDetail& rhs) const
-        {
-            return std::tie(lhs.family, lhs.locale) < std::tie(rhs.family, rhs.locale);
-        }
-    };
-    using FontDetailSet = std::set<FontDetail, FontDetailLess>;
+    using FontDetail = text_utils::FontName;
+    using FontDetailLess = text_utils::FontNameLess;
+    using FontDetailSet = text_utils::FontNameSet;
 
     FontDetailSet querySystemFonts();
 
-    // Call this with query=True to force updating the cached set.
-    // In most cases, there is no need to use the parameter because
-    // the application will perform an immediate query at startup and
-    // cache the returned result. If the user installs a new font
-    // while the application is running, set query=True to refresh.
+    // Returns a digest of the write time of the system and per-user font
+    // directories, which changes as soon as a font is installed or removed.
+    Optional<uint64_t> fontDirectoryFingerprint();
+
+    // The catalog that systemFonts is backed by.
+    text_utils::FontCatalog& fontCatalog();
+
+    // The enumeration is started in a worker thread at startup (or loaded
+    // from Application::CreateInfo::fontCachePath if the fonts are not
+    // changed since last time), and the first call only blocks if it has
+    // not finished yet.  If the user installs a new font while the
+    // application is running, set query=True to refresh the cached set.
     const FontDetailSet& systemFonts(bool query = false);
 
     using TextFormatMap = std::unordered_map<Wstring, ComPtr<IDWriteTextFormat>>;
 
+    // Only contains the text formats that have been loaded, and note that
+    // the "Default/N" formats are loaded on first use through textFormat.
     const TextFormatMap& textFormats();
 
     struct TextFormatDetail
@@ -48,9 +49,15 @@ namespace d14engine::uikit::resource_utils
     // and obtained through textFormats(), eliminating the repeated loading of font data.
     ComPtr<IDWriteTextFormat> loadTextFormat(WstrRefer name, const TextFormatDetail& detail);
 
+    // "Default/N" is Segoe UI (en-us) in N pt, and it is created on demand
+    // when first queried (N is a positive integer, e.g. Default/16).
+    IDWriteTextFormat* textFormat(WstrRefer name);
+
+    // Loads Default/9 ~ Default/36 in advance, which is no longer needed
+    // at startup since textFormat creates them lazily.
     void loadBasicTextFormats();
 
-#define D14_FONT(Name) d14engine::uikit::resource_utils::textFormats().at(Name).Get()
+#define D14_FONT(Name) d14engine::uikit::resource_utils::textFormat(Name)
 
 #pragma endregion
 
@@ -5,9 +5,9 @@
 #include "Common/DirectXError.h"
 #include "Common/MathUtils/Basic.h"
 
-#include "Renderer/GraphUtils/Barrier.h"
 #include "Renderer/GraphUtils/ParamHelper.h"
 #include "Renderer/Interfaces/DrawLayer.h"
+#include "Renderer/RenderGraph/D3D12RenderGraph.h"
 
 // Do NOT remove this header for code tidy
 // as the template deduction relies on it.
@@ -57,6 +57,11 @@ namespace d14engine::uikit
         }
     }
 
+    ScenePanel::~ScenePanel()
+    {
+        if (m_rtvHeap) m_rtvHeap->free(m_rtvDescriptor);
+    }
+
     void ScenePanel::onInitializeFinish()
     {
         Panel::onInitializeFinish();
@@ -65,18 +70,17 @@ namespace d14engine::uikit
 
         auto rndr = Application::g_app->renderer();
 
-        // The back/MSAA buffers share the same RTV heap. Literally 1 RTV seat
+        // The back/MSAA buffers share the same RTV descriptor. Literally 1 RTV seat
         // is enough as only 1 of them is used as render target at the same time:
         // (MSAA Enabled) back buffer == staging, MSAA buffer == render target
         // (MSAA Disabled) back buffer == render target, MSAA buffer == not used
 
-        D3D12_DESCRIPTOR_HEAP_DESC desc =
-        {
-            .Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
-            .NumDescriptors = 1
-        };
-        auto device = rndr->d3d12Device();
-        THROW_IF_FAILED(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_rtvHeap)));
+        m_rtvHeap = rndr->rtvDescriptors();
+
+        auto rtvDescriptor = m_rtvHeap->allocate();
+        THROW_IF_FALSE(rtvDescriptor.has_value());
+
+        m_rtvDescriptor = rtvDescriptor.value();
 
         loadOffscreenTexture();
 
@@ -88,71 +92,12 @@ namespace d14engine::uikit
         m_primaryLayer->f_onRendererDrawD3d12LayerAfter = [this]
         (DrawLayer* layer, Renderer* rndr)
         {
-            if (!m_msaaEnabled) // back buffer == render target
-            {
-                auto barrier = CD3DX12_RESOURCE_BARRIER::Transition
-                (
-                    m_backBuffer.Get(),
-                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_RENDER_TARGET
-                );
-                rndr->cmdList()->ResourceBarrier(1, &barrier);
-            }
-            ////////////////////////////
-            // Clear Background Color //
-            ////////////////////////////
-
-            auto rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
-            rndr->cmdList()->OMSetRenderTargets(1, &rtvHandle, TRUE, nullptr);
-            rndr->cmdList()->ClearRenderTargetView(rtvHandle, m_clearColor, 0, nullptr);
+            m_openingGraph->execute(rndr->cmdList());
         };
         m_closingLayer->f_onRendererDrawD3d12LayerAfter = [this]
         (DrawLayer* layer, Renderer* rndr)
         {
-            if (m_msaaEnabled) // MSAA buffer == render target
-            {
-                D3D12_RESOURCE_BARRIER barriers[] =
-                {
-                CD3DX12_RESOURCE_BARRIER::Transition
-                (
-                    m_backBuffer.Get(),
-                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_RESOLVE_DEST
-                ),
-                CD3DX12_RESOURCE_BARRIER::Transition
-                (
-                    m_msaaBuffer.Get(),
-                    D3D12_RESOURCE_STATE_RENDER_TARGET,
-                    D3D12_RESOURCE_STATE_RESOLVE_SOURCE
-                )};
-                rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
-
-                //////////////////////////
-                // Resolve MSAA Texture //
-                //////////////////////////
-
-                rndr->cmdList()->ResolveSubresource
-                (
-                /* pDstResource   */ m_backBuffer.Get(),
-                /* DstSubresource */ 0,
-                /* pSrcResource   */ m_msaaBuffer.Get(),
-                /* SrcSubresource */ 0,
-                /* Format         */ Renderer::g_renderTargetFormat
-                );
-
-                graph_utils::revertBarrier(NUM_ARR_ARGS(barriers));
-                rndr->cmdList()->ResourceBarrier(NUM_ARR_ARGS(barriers));
-            }
-            else // back buffer == render target
-            {
-                auto barrier = CD3DX12_RESOURCE_BARRIER::Transition
-                (
-                    m_backBuffer.Get(),
-                    D3D12_RESOURCE_STATE_RENDER_TARGET,
-                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-                );
-                rndr->cmdList()->ResourceBarrier(1, &barrier);
-            }
+            m_closingGraph->execute(rndr->cmdList());
         };
     }
 
@@ -253,6 +198,8 @@ namespace d14engine::uikit
 
         createWrappedBuffer();
 
+        createFrameGraphs();
+
         rndr->endGpuCommand();
     }
 
@@ -354,7 +301,7 @@ namespace d14engine::uikit
             /* riidResource         */
             /* ppvResource          */ IID_PPV_ARGS(&m_backBuffer)
             ));
-            auto rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
+            auto rtvHandle = m_rtvDescriptor.cpuHandle;
             device->CreateRenderTargetView(m_backBuffer.Get(), nullptr, rtvHandle);
         }
     }
@@ -406,10 +353,95 @@ namespace d14engine::uikit
         /* riidResource         */
         /* ppvResource          */ IID_PPV_ARGS(&m_msaaBuffer)
         ));
-        auto rtvHandle = m_rtvHeap->GetCPUDescriptorHandleForHeapStart();
+        auto rtvHandle = m_rtvDescriptor.cpuHandle;
         device->CreateRenderTargetView(m_msaaBuffer.Get(), nullptr, rtvHandle);
     }
 
+    void ScenePanel::createFrameGraphs()
+    {
+        THROW_IF_NULL(Application::g_app);
+
+        auto rndr = Application::g_app->renderer();
+
+        using namespace render_graph;
+
+        // The render target stays in RENDER_TARGET between the two graphs,
+        // during which the layers of the panel draw to it.
+
+        m_openingGraph = std::make_unique<D3D12RenderGraph>(rndr->d3d12Device());
+        m_closingGraph = std::make_unique<D3D12RenderGraph>(rndr->d3d12Device());
+
+        auto clear = [this, rndr]
+        {
+            auto rtvHandle = m_rtvDescriptor.cpuHandle;
+            rndr->cmdList()->OMSetRenderTargets(1, &rtvHandle, TRUE, nullptr);
+            rndr->cmdList()->ClearRenderTargetView(rtvHandle, m_clearColor, 0, nullptr);
+        };
+        if (m_msaaEnabled) // MSAA buffer == render target
+        {
+            auto target = m_openingGraph->importResource
+            (
+            /* name         */ L"MSAA Buffer",
+            /* resource     */ m_msaaBuffer.Get(),
+            /* initialState */ D3D12_RESOURCE_STATE_RENDER_TARGET,
+            /* finalState   */ D3D12_RESOURCE_STATE_RENDER_TARGET
+            );
+            m_openingGraph->graph.addPass(L"Clear", clear)
+                .write(target, ResourceState::RenderTarget);
+
+            auto source = m_closingGraph->importResource
+            (
+            /* name         */ L"MSAA Buffer",
+            /* resource     */ m_msaaBuffer.Get(),
+            /* initialState */ D3D12_RESOURCE_STATE_RENDER_TARGET,
+            /* finalState   */ D3D12_RESOURCE_STATE_RENDER_TARGET
+            );
+            auto dest = m_closingGraph->importResource
+            (
+            /* name         */ L"Back Buffer",
+            /* resource     */ m_backBuffer.Get(),
+            /* initialState */ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            /* finalState   */ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+            );
+            m_closingGraph->graph.addPass(L"Resolve", [this, rndr]
+            {
+                rndr->cmdList()->ResolveSubresource
+                (
+                /* pDstResource   */ m_backBuffer.Get(),
+                /* DstSubresource */ 0,
+                /* pSrcResource   */ m_msaaBuffer.Get(),
+                /* SrcSubresource */ 0,
+                /* Format         */ Renderer::g_renderTargetFormat
+                );
+            })
+            .read(source, ResourceState::ResolveSource)
+            .write(dest, ResourceState::ResolveDest);
+        }
+        else // back buffer == render target
+        {
+            auto target = m_openingGraph->importResource
+            (
+            /* name         */ L"Back Buffer",
+            /* resource     */ m_backBuffer.Get(),
+            /* initialState */ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+            /* finalState   */ D3D12_RESOURCE_STATE_RENDER_TARGET
+            );
+            m_openingGraph->graph.addPass(L"Clear", clear)
+                .write(target, ResourceState::RenderTarget);
+
+            // No pass but the final transition for D2D1.
+            m_closingGraph->importResource
+            (
+            /* name         */ L"Back Buffer",
+            /* resource     */ m_backBuffer.Get(),
+            /* initialState */ D3D12_RESOURCE_STATE_RENDER_TARGET,
+            /* finalState   */ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+            );
+        }
+        m_openingGraph->compile();
+        m_closingGraph->compile();
+    }
+
     void ScenePanel::createWrappedBuffer()
     {
         THROW_IF_NULL(Application::g_app);
@@ -470,9 +502,9 @@ namespace d14engine::uikit
         loadOffscreenTexture();
     }
 
-    ID3D12DescriptorHeap* ScenePanel::rtvHeap() const
+    D3D12_CPU_DESCRIPTOR_HANDLE ScenePanel::rtvHandle() const
     {
-        return m_rtvHeap.Get();
+        return m_rtvDescriptor.cpuHandle;
     }
 
     ID3D12Resource* ScenePanel::backBuffer() const
@@ -490,6 +522,14 @@ namespace d14engine::uikit
         return m_sharedBitmap.Get();
     }
 
+    void ScenePanel::onRendererUpdateObject2DHelper(Renderer* rndr)
+    {
+        Panel::onRendererUpdateObject2DHelper(rndr);
+
+        // The scene is rendered again in each frame.
+        invalidate();
+    }
+
     void ScenePanel::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
     {
         Panel::onRendererDrawD2d1ObjectHelper(rndr);
@@ -504,7 +544,7 @@ namespace d14engine::uikit
         }
         else mode = BitmapObject::g_interpolationMode;
 
-        rndr->d2d1DeviceContext()->DrawBitmap
+        rndr->recorder2D()->DrawBitmap
         (
         /* bitmap               */ m_sharedBitmap.Get(),
         /* destinationRectangle */ m_absoluteRect,
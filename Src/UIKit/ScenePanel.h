@@ -2,9 +2,16 @@
 
 #include "Common/Precompile.h"
 
+#include "Renderer/DescriptorHeap.h"
+
 #include "UIKit/Panel.h"
 
-namespace d14engine::renderer { struct DrawLayer; }
+namespace d14engine::renderer
+{
+    struct DrawLayer;
+
+    namespace render_graph { struct D3D12RenderGraph; }
+}
 
 namespace d14engine::uikit
 {
@@ -12,6 +19,8 @@ namespace d14engine::uikit
     {
         ScenePanel(const D2D1_RECT_F& rect = {}, int cmdLayerPriority = 100);
 
+        virtual ~ScenePanel();
+
         void onInitializeFinish() override;
 
     protected:
@@ -48,7 +57,9 @@ namespace d14engine::uikit
     protected:
         XMVECTORF32 m_clearColor = Colors::Black;
 
-        ComPtr<ID3D12DescriptorHeap> m_rtvHeap = {};
+        // Allocated from Renderer::rtvDescriptors.
+        SharedPtr<renderer::DescriptorHeap> m_rtvHeap = {};
+        renderer::DescriptorHeap::Descriptor m_rtvDescriptor = {};
 
         ComPtr<ID3D12Resource> m_backBuffer = {};
         ComPtr<ID3D12Resource> m_msaaBuffer = {};
@@ -64,11 +75,20 @@ namespace d14engine::uikit
 
         void createWrappedBuffer();
 
+        // Issue the barriers of the buffers around the layers of the panel:
+        // the opening one clears the render target, and the closing one
+        // resolves it (if MSAA is enabled) and leaves the back buffer in
+        // PIXEL_SHADER_RESOURCE, both of which are rebuilt with the buffers.
+        UniquePtr<renderer::render_graph::D3D12RenderGraph> m_openingGraph = {};
+        UniquePtr<renderer::render_graph::D3D12RenderGraph> m_closingGraph = {};
+
+        void createFrameGraphs();
+
     public:
         const XMVECTORF32& clearColor() const;
         void setClearColor(const XMVECTORF32& color);
 
-        ID3D12DescriptorHeap* rtvHeap() const;
+        D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle() const;
 
         ID3D12Resource* backBuffer() const;
 
@@ -86,6 +106,8 @@ namespace d14engine::uikit
 
     protected:
         // IDrawObject2D
+        void onRendererUpdateObject2DHelper(renderer::Renderer* rndr) override;
+
         void onRendererDrawD2d1ObjectHelper(renderer::Renderer* rndr) override;
 
         // Panel
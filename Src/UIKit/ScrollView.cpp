@@ -145,6 +145,8 @@ namespace d14engine::uikit
             validOffset.y != m_viewportOffset.y)
         {
             m_viewportOffset = validOffset;
+            invalidate();
+
             onViewportOffsetChange(validOffset);
         }
     }
@@ -171,6 +173,11 @@ namespace d14engine::uikit
         });
     }
 
+    std::array<bool, 4> ScrollView::scrollBarStates() const
+    {
+        return { m_isHorzBarHover, m_isHorzBarDown, m_isVertBarHover, m_isVertBarDown };
+    }
+
     bool ScrollView::isControllingHorzBar() const
     {
         return m_isHorzBarHover || m_isHorzBarDown;
@@ -270,11 +277,11 @@ namespace d14engine::uikit
             (
                 -m_absoluteRect.left, -m_absoluteRect.top
             );
-            contentMask.beginDraw(rndr->d2d1DeviceContext(), maskTrans);
+            contentMask.beginDraw(rndr->recorder2D(), maskTrans);
             {
                 m_content->onRendererDrawD2d1Object(rndr);
             }
-            contentMask.endDraw(rndr->d2d1DeviceContext());
+            contentMask.endDraw(rndr->recorder2D());
         }
     }
 
@@ -297,7 +304,7 @@ namespace d14engine::uikit
 
         if (m_content && m_content->isD2d1ObjectVisible())
         {
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ contentMask.data.Get(),
             /* destinationRectangle */ m_absoluteRect,
@@ -317,7 +324,7 @@ namespace d14engine::uikit
         auto frame = math_utils::inner(m_absoluteRect, stroke.width);
         D2D1_ROUNDED_RECT outlineRect = { frame, roundRadiusX, roundRadiusY };
 
-        rndr->d2d1DeviceContext()->DrawRoundedRectangle
+        rndr->recorder2D()->DrawRoundedRectangle
         (
         /* roundedRect */ outlineRect,
         /* brush       */ resource_utils::solidColorBrush(),
@@ -344,7 +351,7 @@ namespace d14engine::uikit
                 selfCoordToAbsolute(horzBarSelfcoordRect(state)),
                 setting.geometry.roundRadius, setting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -367,7 +374,7 @@ namespace d14engine::uikit
                 selfCoordToAbsolute(vertBarSelfcoordRect(state)),
                 setting.geometry.roundRadius, setting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -408,6 +415,8 @@ namespace d14engine::uikit
 
         auto selfSize = getSelfSize();
 
+        auto originalBarStates = scrollBarStates();
+
         //////////////////////////////
         // Perform viewport motion. //
         //////////////////////////////
@@ -448,6 +457,7 @@ namespace d14engine::uikit
 
             m_isVertBarHover = math_utils::isOverlapped(p, rect);
         }
+        if (scrollBarStates() != originalBarStates) invalidate();
     }
 
     void ScrollView::onMouseLeaveHelper(MouseMoveEvent& e)
@@ -467,6 +477,8 @@ namespace d14engine::uikit
 
         auto p = absoluteToSelfCoord(e.cursorPoint);
 
+        auto originalBarStates = scrollBarStates();
+
         if (e.state.leftDown() || e.state.leftDblclk())
         {
             if (isHorzBarEnabled)
@@ -496,6 +508,7 @@ namespace d14engine::uikit
             m_horzBarHoldOffset = m_vertBarHoldOffset = 0.0f;
             m_originalViewportOffset = { 0.0f, 0.0f };
         }
+        if (scrollBarStates() != originalBarStates) invalidate();
     }
 
     void ScrollView::onMouseWheelHelper(MouseWheelEvent& e)
@@ -92,6 +92,10 @@ namespace d14engine::uikit
         bool m_isHorzBarHover = false, m_isHorzBarDown = false;
         bool m_isVertBarHover = false, m_isVertBarDown = false;
 
+        // Compared before and after the mouse events, so that the view is
+        // only invalidated when any of the scroll bars changes.
+        std::array<bool, 4> scrollBarStates() const;
+
     public:
         bool isControllingHorzBar() const;
         bool isControllingVertBar() const;
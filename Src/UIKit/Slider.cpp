@@ -120,7 +120,7 @@ namespace d14engine::uikit
         {
             auto& shadow = handleRes.shadow;
 
-            shadow.beginDraw(rndr->d2d1DeviceContext());
+            shadow.beginDraw(rndr->recorder2D());
             {
                 auto& setting = appearance().handle;
 
@@ -135,13 +135,13 @@ namespace d14engine::uikit
                     math_utils::moveVertex(rect, setting.shadow.offset),
                     setting.geometry.roundRadius, setting.geometry.roundRadius
                 };
-                rndr->d2d1DeviceContext()->FillRoundedRectangle
+                rndr->recorder2D()->FillRoundedRectangle
                 (
                 /* roundedRect */ roundedRect,
                 /* brush       */ resource_utils::solidColorBrush()
                 );
             }
-            shadow.endDraw(rndr->d2d1DeviceContext());
+            shadow.endDraw(rndr->recorder2D());
         }
         //////////////////////
         // Value Label Mask //
@@ -151,7 +151,7 @@ namespace d14engine::uikit
         {
             auto& mask = valueLabelRes.mask();
 
-            mask.beginDraw(rndr->d2d1DeviceContext());
+            mask.beginDraw(rndr->recorder2D());
             {
                 auto& setting = appearance().valueLabel;
 
@@ -170,7 +170,7 @@ namespace d14engine::uikit
                         setting.mainRect.geometry.roundRadius,
                         setting.mainRect.geometry.roundRadius
                     };
-                    rndr->d2d1DeviceContext()->FillRoundedRectangle
+                    rndr->recorder2D()->FillRoundedRectangle
                     (
                     /* roundedRect */ roundedRect,
                     /* brush       */ resource_utils::solidColorBrush()
@@ -185,14 +185,14 @@ namespace d14engine::uikit
                     resource_utils::solidColorBrush()->SetColor(background.color);
                     resource_utils::solidColorBrush()->SetOpacity(background.opacity);
 
-                    rndr->d2d1DeviceContext()->FillGeometry
+                    rndr->recorder2D()->FillGeometry
                     (
                     /* geometry */ sideTriangleRes.pathGeo.Get(),
                     /* brush    */ resource_utils::solidColorBrush()
                     );
                 }
             }
-            mask.endDraw(rndr->d2d1DeviceContext());
+            mask.endDraw(rndr->recorder2D());
         }
     }
 
@@ -214,7 +214,7 @@ namespace d14engine::uikit
                 setting.geometry.roundRadius,
                 setting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -236,7 +236,7 @@ namespace d14engine::uikit
                 setting.geometry.roundRadius,
                 setting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -257,7 +257,7 @@ namespace d14engine::uikit
 
                 shadow.configEffectInput(resource_utils::shadowEffect());
 
-                rndr->d2d1DeviceContext()->DrawImage
+                rndr->recorder2D()->DrawImage
                 (
                 /* effect       */ resource_utils::shadowEffect(),
                 /* targetOffset */ math_utils::leftTop(handleAbsoluteRect())
@@ -279,7 +279,7 @@ namespace d14engine::uikit
                     setting.geometry.roundRadius,
                     setting.geometry.roundRadius
                 };
-                rndr->d2d1DeviceContext()->FillRoundedRectangle
+                rndr->recorder2D()->FillRoundedRectangle
                 (
                 /* roundedRect */ roundedRect,
                 /* brush       */ resource_utils::solidColorBrush()
@@ -311,7 +311,7 @@ namespace d14engine::uikit
 
                 shadow.configEffectInput(resource_utils::shadowEffect());
 
-                rndr->d2d1DeviceContext()->DrawImage
+                rndr->recorder2D()->DrawImage
                 (
                 /* effect       */ resource_utils::shadowEffect(),
                 /* targetOffset */ math_utils::leftTop(rect)
@@ -323,7 +323,7 @@ namespace d14engine::uikit
             {
                 auto& mask = valueLabelRes.mask();
 
-                rndr->d2d1DeviceContext()->DrawBitmap
+                rndr->recorder2D()->DrawBitmap
                 (
                 /* bitmap               */ mask.data.Get(),
                 /* destinationRectangle */ rect,
@@ -65,21 +65,33 @@ namespace d14engine::uikit
         value = std::clamp(value, m_minValue, m_maxValue);
 
         bool isValueChanged = ValuefulObject::setValue(value);
-        if (isValueChanged) onValueChange(m_value);
+        if (isValueChanged)
+        {
+            invalidate();
+            onValueChange(m_value);
+        }
         return isValueChanged;
     }
 
     bool SliderBase::setMinValue(float value)
     {
         bool isValueChanged = ValuefulObject::setMinValue(value);
-        if (isValueChanged) onValueChange(m_value);
+        if (isValueChanged)
+        {
+            invalidate();
+            onValueChange(m_value);
+        }
         return isValueChanged;
     }
 
     bool SliderBase::setMaxValue(float value)
     {
         bool isValueChanged = ValuefulObject::setMaxValue(value);
-        if (isValueChanged) onValueChange(m_value);
+        if (isValueChanged)
+        {
+            invalidate();
+            onValueChange(m_value);
+        }
         return isValueChanged;
     }
 
@@ -119,6 +131,7 @@ namespace d14engine::uikit
            (captureDoubleClick && e.state.leftDblclk()))
         {
             m_isSliding = true;
+            invalidate();
 
             updateValue(absoluteToSelfCoord(p));
             onStartSliding(m_value);
@@ -128,6 +141,7 @@ namespace d14engine::uikit
             if (m_isSliding)
             {
                 m_isSliding = false;
+                invalidate();
 
                 onEndSliding(m_value);
             }
@@ -145,7 +145,7 @@ namespace d14engine::uikit
                 buttonSetting.geometry.roundRadius,
                 buttonSetting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ buttonRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -163,14 +163,14 @@ namespace d14engine::uikit
 
             auto iconRect = closeIconAbsoluteRect();
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::leftTop(iconRect),
             /* point1      */ math_utils::rightBottom(iconRect),
             /* brush       */ resource_utils::solidColorBrush(),
             /* strokeWidth */ iconSetting.strokeWidth
             );
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::rightTop(iconRect),
             /* point1      */ math_utils::leftBottom(iconRect),
@@ -205,12 +205,17 @@ namespace d14engine::uikit
 
         auto& p = e.cursorPoint;
 
+        bool isCloseButtonHover = m_isCloseButtonHover;
+
         if (!math_utils::isOverlapped(p, closeButtonAbsoluteRect()))
         {
             m_isCloseButtonHover = false;
             m_isCloseButtonDown = false;
         }
         else m_isCloseButtonHover = true;
+
+        // The down state only changes along with the hover one here.
+        if (m_isCloseButtonHover != isCloseButtonHover) invalidate();
     }
 
     void TabCaption::onMouseLeaveHelper(MouseMoveEvent& e)
@@ -229,6 +234,8 @@ namespace d14engine::uikit
 
         if (e.state.leftDown() || e.state.leftDblclk())
         {
+            if (m_isCloseButtonDown != m_isCloseButtonHover) invalidate();
+
             m_isCloseButtonDown = m_isCloseButtonHover;
 
             if ((!closable || !m_isCloseButtonHover) && !m_parentTabGroup.expired())
@@ -252,6 +259,8 @@ namespace d14engine::uikit
             {
                 m_isCloseButtonDown = false;
 
+                invalidate();
+
                 if (closable && !m_parentTabGroup.expired())
                 {
                     auto tabGroup = m_parentTabGroup.lock();
@@ -445,6 +445,8 @@ do { \
         {
             std::swap(*tabIndex1.iterator, *tabIndex2.iterator);
 
+            invalidate();
+
             if (m_activeCardTabIndex == tabIndex1 ||
                 m_activeCardTabIndex == tabIndex2)
             {
@@ -488,6 +490,11 @@ do { \
         else return ButtonState::Idle;
     }
 
+    std::tuple<TabGroup::TabIndex, bool, bool> TabGroup::cardBarStates() const
+    {
+        return { m_hoverCardTabIndex, m_isMoreCardsButtonHover, m_isMoreCardsButtonDown };
+    }
+
     const SharedPtr<PopupMenu>& TabGroup::previewPanel() const
     {
         return m_previewPanel;
@@ -495,6 +502,9 @@ do { \
 
     void TabGroup::updateCandidateTabInfo()
     {
+        // The cards are laid out again.
+        invalidate();
+
         TabIndex orgIndex = { &m_tabs, 0 };
         for (; orgIndex < m_candidateTabCount && orgIndex.valid(); ++orgIndex)
         {
@@ -570,7 +580,7 @@ do { \
             tabIndex->m_previewItem->transform(math_utils::heightOnlyRect(prvwSrc.itemHeight));
             tabIndex->caption->release();
             tabIndex->m_previewItem->setContent(tabIndex->caption);
-            tabIndex->m_previewItem->state = ViewItem::State::Idle;
+            tabIndex->m_previewItem->setState(ViewItem::State::Idle);
 
             prvwItems.push_back(tabIndex->m_previewItem);
         }
@@ -733,26 +743,26 @@ do { \
                 // Active-Card Mask //
                 //////////////////////
 
-                activeCard.mask.beginDraw(rndr->d2d1DeviceContext());
+                activeCard.mask.beginDraw(rndr->recorder2D());
                 {
                     auto& setting = appearance().tabBar.card.main[(size_t)CardState::Active];
 
                     resource_utils::solidColorBrush()->SetColor(setting.background.color);
                     resource_utils::solidColorBrush()->SetOpacity(setting.background.opacity);
 
-                    rndr->d2d1DeviceContext()->FillGeometry
+                    rndr->recorder2D()->FillGeometry
                     (
                     /* geometry */ activeCard.pathGeo.Get(),
                     /* brush    */ resource_utils::solidColorBrush()
                     );
                 }
-                activeCard.mask.endDraw(rndr->d2d1DeviceContext());
+                activeCard.mask.endDraw(rndr->recorder2D());
 
                 /////////////////////
                 // More-Cards Mask //
                 /////////////////////
 
-                moreCards.mask.beginDraw(rndr->d2d1DeviceContext());
+                moreCards.mask.beginDraw(rndr->recorder2D());
                 {
                     auto state = getMoreCardsButtonState();
                     auto& setting = appearance().tabBar.moreCards.control;
@@ -772,7 +782,7 @@ do { \
                         setting.button.geometry.roundRadius,
                         setting.button.geometry.roundRadius
                     };
-                    rndr->d2d1DeviceContext()->FillRoundedRectangle
+                    rndr->recorder2D()->FillRoundedRectangle
                     (
                     /* roundedRect */ roundedRect,
                     /* brush       */ resource_utils::solidColorBrush()
@@ -787,18 +797,18 @@ do { \
                     resource_utils::solidColorBrush()->SetOpacity(iconBackground.opacity);
 
                     auto& topRect = setting.icon.geometry.topRect;
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ math_utils::rect(topRect.offset, topRect.size),
                     /* brush */ resource_utils::solidColorBrush()
                     );
-                    rndr->d2d1DeviceContext()->FillGeometry
+                    rndr->recorder2D()->FillGeometry
                     (
                     /* geometry */ moreCards.pathGeo.Get(),
                     /* brush    */ resource_utils::solidColorBrush()
                     );
                 }
-                moreCards.mask.endDraw(rndr->d2d1DeviceContext());
+                moreCards.mask.endDraw(rndr->recorder2D());
             }
         }
     }
@@ -820,7 +830,7 @@ do { \
                 setting.geometry.roundRadius,
                 setting.geometry.roundRadius
             };
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush()
@@ -845,7 +855,7 @@ do { \
                     setting.geometry.roundRadius,
                     setting.geometry.roundRadius
                 };
-                rndr->d2d1DeviceContext()->FillRoundedRectangle
+                rndr->recorder2D()->FillRoundedRectangle
                 (
                 /* roundedRect */ roundedRect,
                 /* brush       */ resource_utils::solidColorBrush()
@@ -868,7 +878,7 @@ do { \
 
             auto shadowPosition = math_utils::leftTop(cardAbsoluteRect(m_activeCardTabIndex));
 
-            rndr->d2d1DeviceContext()->DrawImage
+            rndr->recorder2D()->DrawImage
             (
             /* effect       */ resource_utils::shadowEffect(),
             /* targetOffset */ shadowPosition
@@ -879,7 +889,7 @@ do { \
 
             auto& setting = appearance().tabBar.card.main[(size_t)CardState::Active];
 
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ activeCard.mask.data.Get(),
             /* destinationRectangle */ cardAbsoluteRect(m_activeCardTabIndex),
@@ -937,7 +947,7 @@ do { \
                         resource_utils::solidColorBrush()->SetColor(setting.background.color);
                         resource_utils::solidColorBrush()->SetOpacity(setting.background.opacity);
 
-                        rndr->d2d1DeviceContext()->FillRectangle
+                        rndr->recorder2D()->FillRectangle
                         (
                         /* rect  */ separatorAbsoluteRect(tabIndex),
                         /* brush */ resource_utils::solidColorBrush()
@@ -949,7 +959,7 @@ do { \
             // More-Cards
             //-------------------------------------------------------------------------
 
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ moreCards.mask.data.Get(),
             /* destinationRectangle */ moreCardsButtonAbsoluteRect(),
@@ -968,7 +978,7 @@ do { \
             resource_utils::solidColorBrush()->SetColor(maskSetting.color);
             resource_utils::solidColorBrush()->SetOpacity(maskSetting.opacity);
 
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ { m_absoluteRect, roundRadiusX, roundRadiusY },
             /* brush       */ resource_utils::solidColorBrush()
@@ -1004,21 +1014,21 @@ do { \
         auto point20 = math_utils::offset(leftTop, { 0.0f, selfHeight - stroke.width * 0.5f });
         auto point21 = math_utils::offset(point20, { selfWidth, 0.0f });
 
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ point00,
         /* point1      */ point01,
         /* brush       */ resource_utils::solidColorBrush(),
         /* strokeWidth */ stroke.width
         );
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ point10,
         /* point1      */ point11,
         /* brush       */ resource_utils::solidColorBrush(),
         /* strokeWidth */ stroke.width
         );
-        rndr->d2d1DeviceContext()->DrawLine
+        rndr->recorder2D()->DrawLine
         (
         /* point0      */ point20,
         /* point1      */ point21,
@@ -1083,6 +1093,8 @@ do { \
 
         auto& p = e.cursorPoint;
 
+        auto originalCardBarStates = cardBarStates();
+
         if (math_utils::isOverlapped(p, cardBarExtendedCardBarAbsoluteRect()))
         {
             if (m_draggedCardTabIndex.valid())
@@ -1133,6 +1145,7 @@ do { \
             m_isMoreCardsButtonHover = false;
             m_isMoreCardsButtonDown = false;
         }
+        if (cardBarStates() != originalCardBarStates) invalidate();
     }
 
     void TabGroup::onMouseLeaveHelper(MouseMoveEvent& e)
@@ -1157,6 +1170,8 @@ do { \
 
         auto& p = e.cursorPoint;
 
+        auto originalCardBarStates = cardBarStates();
+
         if (e.state.leftDown() || e.state.leftDblclk())
         {
             if (m_hoverCardTabIndex.valid())
@@ -1181,5 +1196,6 @@ do { \
             }
             m_draggedCardTabIndex.invalidate();
         }
+        if (cardBarStates() != originalCardBarStates) invalidate();
     }
 }
@@ -128,6 +128,10 @@ namespace d14engine::uikit
         bool m_isMoreCardsButtonHover = false;
         bool m_isMoreCardsButtonDown = false;
 
+        // Compared before and after the mouse events, so that the group is
+        // only invalidated when the hover card or the button changes.
+        std::tuple<TabIndex, bool, bool> cardBarStates() const;
+
         ButtonState getMoreCardsButtonState() const;
 
     protected:
@@ -98,7 +98,7 @@ namespace d14engine::uikit
             auto solidColorBrush = resource_utils::solidColorBrush();
             float strokeWidth = srcBtlnSetting.strokeWidth;
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ point0,
             /* point1      */ point1,
@@ -0,0 +1,97 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/BackgroundSearch.h"
+
+namespace d14engine::uikit::text_utils
+{
+    BackgroundSearch::~BackgroundSearch()
+    {
+        cancel();
+    }
+
+    void BackgroundSearch::start(
+        ShrdPtrRefer<const Wstring> text,
+        const TextSearch& search,
+        const Notifier& notifier)
+    {
+        cancel();
+
+        m_matches.clear();
+        m_progress = 0;
+
+        if (!text || !search.valid()) return;
+
+        m_cancelled = false;
+        m_running = true;
+
+        auto chunkSize = std::max(setting.chunkSize, 1_uz);
+
+        // The text and the search are captured by value, so the worker
+        // never refers to anything that the UI thread may modify.
+        m_worker = Thread([this, text, search, notifier, chunkSize]
+        {
+            WstringView view = *text;
+
+            size_t first = 0;
+            while (first < view.size() && !m_cancelled)
+            {
+                auto last = std::min(first + chunkSize, view.size());
+
+                TextSearch::MatchArray matches = {};
+                search.findAll(view, first, last, matches);
+
+                // A match may run across the end of the chunk, in which
+                // case the next chunk resumes at the end of that match,
+                // so that the result is the same as a one-pass findAll
+                // (i.e. no match overlaps with the previous one).
+                auto next = last;
+                if (!matches.empty())
+                {
+                    next = std::max(next, matches.back().offset + matches.back().count);
+
+                    std::lock_guard lock(m_matchesMutex);
+                    m_matches.insert(m_matches.end(), matches.begin(), matches.end());
+                }
+                m_progress = next;
+
+                // The last notification is sent after m_running is reset.
+                if (next < view.size() && notifier) notifier();
+
+                first = next;
+            }
+            m_running = false;
+
+            if (!m_cancelled && notifier) notifier();
+        });
+    }
+
+    void BackgroundSearch::cancel()
+    {
+        m_cancelled = true;
+
+        if (m_worker.joinable()) m_worker.join();
+
+        m_running = false;
+    }
+
+    void BackgroundSearch::requestCancel()
+    {
+        m_cancelled = true;
+    }
+
+    bool BackgroundSearch::isRunning() const
+    {
+        return m_running;
+    }
+
+    size_t BackgroundSearch::progress() const
+    {
+        return m_progress;
+    }
+
+    TextSearch::MatchArray BackgroundSearch::takeMatches()
+    {
+        std::lock_guard lock(m_matchesMutex);
+        return std::exchange(m_matches, {});
+    }
+}
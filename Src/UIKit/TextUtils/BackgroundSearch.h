@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+#include "UIKit/TextUtils/TextSearch.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Runs a TextSearch over a snapshot of the text in a worker thread
+    // chunk by chunk, so that the matches of a huge buffer are delivered
+    // progressively, and a new search cancels the former one promptly.
+    //
+    // The worker never touches the UI: it only collects the matches and
+    // calls the notifier, which is expected to wake up the UI thread
+    // (e.g. Application::triggerThreadEvent) to take the matches.
+
+    struct BackgroundSearch : cpp_lang_utils::NonCopyable
+    {
+        ~BackgroundSearch();
+
+        struct Setting
+        {
+            // The count of characters to scan between two notifications.
+            size_t chunkSize = 1024 * 1024;
+        }
+        setting = {};
+
+        using Notifier = Function<void()>;
+
+        // Cancels the running search (if any) and starts a new one.
+        // The notifier is called in the worker thread after each chunk.
+        void start(
+            ShrdPtrRefer<const Wstring> text,
+            const TextSearch& search,
+            const Notifier& notifier = {});
+
+        // Blocks until the worker exits, which takes at most one chunk.
+        void cancel();
+
+        // Asks the worker to exit after the current chunk without waiting,
+        // e.g. when the text is modified and the matches become outdated.
+        void requestCancel();
+
+        bool isRunning() const;
+
+        // The count of characters that have been scanned.
+        size_t progress() const;
+
+        // Returns and clears the matches collected since the last call.
+        TextSearch::MatchArray takeMatches();
+
+    protected:
+        Thread m_worker = {};
+
+        std::atomic<bool> m_cancelled = false;
+        std::atomic<bool> m_running = false;
+
+        std::atomic<size_t> m_progress = 0;
+
+        std::mutex m_matchesMutex = {};
+        TextSearch::MatchArray m_matches = {};
+    };
+}
@@ -0,0 +1,255 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/EditHistory.h"
+
+namespace d14engine::uikit::text_utils
+{
+    EditHistory::Delta EditHistory::Delta::inverse() const
+    {
+        return { type == Type::Insert ? Type::Erase : Type::Insert, offset, text };
+    }
+
+    size_t EditHistory::Delta::caretAfter() const
+    {
+        return type == Type::Insert ? (offset + text.size()) : offset;
+    }
+
+    size_t EditHistory::Group::memoryUsage() const
+    {
+        size_t usage = sizeof(Group);
+        for (auto& delta : deltas)
+        {
+            usage += sizeof(Delta) + delta.text.size() * sizeof(wchar_t);
+        }
+        return usage;
+    }
+
+    size_t EditHistory::memoryUsage() const
+    {
+        return m_memoryUsage;
+    }
+
+    size_t EditHistory::undoCount() const
+    {
+        return m_undoGroups.size();
+    }
+
+    size_t EditHistory::redoCount() const
+    {
+        return m_redoGroups.size();
+    }
+
+    bool EditHistory::canUndo() const
+    {
+        return !m_undoGroups.empty();
+    }
+
+    bool EditHistory::canRedo() const
+    {
+        return !m_redoGroups.empty();
+    }
+
+    void EditHistory::clear()
+    {
+        m_undoGroups.clear();
+        m_redoGroups.clear();
+
+        m_memoryUsage = 0;
+
+        m_groupDepth = 0;
+        m_forceNewGroup = false;
+    }
+
+    void EditHistory::seal()
+    {
+        if (!m_undoGroups.empty())
+        {
+            m_undoGroups.back().sealed = true;
+        }
+    }
+
+    void EditHistory::beginGroup()
+    {
+        if (m_groupDepth++ == 0) m_forceNewGroup = true;
+    }
+
+    void EditHistory::endGroup()
+    {
+        if (m_groupDepth > 0 && --m_groupDepth == 0)
+        {
+            // An empty compound group records nothing at all.
+            if (!m_forceNewGroup) seal();
+
+            m_forceNewGroup = false;
+        }
+    }
+
+    void EditHistory::recordInsert(size_t offset, WstrRefer text, TimePoint time)
+    {
+        record({ Delta::Type::Insert, offset, text }, time);
+    }
+
+    void EditHistory::recordErase(size_t offset, WstrRefer text, TimePoint time)
+    {
+        record({ Delta::Type::Erase, offset, text }, time);
+    }
+
+    Optional<size_t> EditHistory::undo(DeltaApplier apply)
+    {
+        if (m_undoGroups.empty()) return std::nullopt;
+
+        auto group = std::move(m_undoGroups.back());
+        m_undoGroups.pop_back();
+
+        size_t caret = 0;
+        for (auto itor = group.deltas.rbegin(); itor != group.deltas.rend(); ++itor)
+        {
+            auto delta = itor->inverse();
+            apply(delta);
+            caret = delta.caretAfter();
+        }
+        group.sealed = true;
+        m_redoGroups.push_back(std::move(group));
+
+        // The typing after an undo should never merge into the former group.
+        seal();
+
+        return caret;
+    }
+
+    Optional<size_t> EditHistory::redo(DeltaApplier apply)
+    {
+        if (m_redoGroups.empty()) return std::nullopt;
+
+        auto group = std::move(m_redoGroups.back());
+        m_redoGroups.pop_back();
+
+        size_t caret = 0;
+        for (auto& delta : group.deltas)
+        {
+            apply(delta);
+            caret = delta.caretAfter();
+        }
+        m_undoGroups.push_back(std::move(group));
+
+        return caret;
+    }
+
+    void EditHistory::record(Delta&& delta, TimePoint time)
+    {
+        if (delta.text.empty()) return;
+
+        // Any new modification makes the redo-able groups out of date.
+        for (auto& group : m_redoGroups)
+        {
+            m_memoryUsage -= group.memoryUsage();
+        }
+        m_redoGroups.clear();
+
+        if (!m_forceNewGroup && !m_undoGroups.empty())
+        {
+            auto& group = m_undoGroups.back();
+
+            if (m_groupDepth > 0)
+            {
+                m_memoryUsage -= group.memoryUsage();
+                group.deltas.push_back(std::move(delta));
+                m_memoryUsage += group.memoryUsage();
+
+                trimToBudget();
+                return;
+            }
+            else if (tryMerge(group, delta, time))
+            {
+                m_memoryUsage -= group.memoryUsage();
+
+                auto& last = group.deltas.back();
+                if (delta.offset < last.offset) // Backspace
+                {
+                    last.text.insert(0, delta.text);
+                    last.offset = delta.offset;
+                }
+                else last.text.append(delta.text);
+
+                group.timestamp = time;
+                m_memoryUsage += group.memoryUsage();
+
+                trimToBudget();
+                return;
+            }
+        }
+        Group group = {};
+        // A multi-character modification (e.g. pasting) is never merged.
+        group.sealed = m_groupDepth == 0 && delta.text.size() > 1;
+        group.timestamp = time;
+        group.deltas.push_back(std::move(delta));
+
+        m_memoryUsage += group.memoryUsage();
+        m_undoGroups.push_back(std::move(group));
+
+        m_forceNewGroup = false;
+
+        trimToBudget();
+    }
+
+    bool EditHistory::tryMerge(Group& group, const Delta& delta, TimePoint time) const
+    {
+        if (group.sealed || group.deltas.size() != 1 || delta.text.size() != 1)
+        {
+            return false;
+        }
+        auto elapsedSecs = std::chrono::duration<float>(time - group.timestamp).count();
+        if (elapsedSecs > setting.mergeIntervalSecs)
+        {
+            return false;
+        }
+        auto& last = group.deltas.back();
+        if (last.type != delta.type || last.text.empty())
+        {
+            return false;
+        }
+        auto ch = delta.text.front();
+
+        if (delta.type == Delta::Type::Insert)
+        {
+            if (delta.offset != last.offset + last.text.size())
+            {
+                return false;
+            }
+            // Starts a new group at the first character of each word.
+            return !setting.breakAtWordBoundary ||
+                isWordCharacter(last.text.back()) || !isWordCharacter(ch);
+        }
+        else // Delta::Type::Erase
+        {
+            if (delta.offset + 1 == last.offset) // Backspace
+            {
+                return !setting.breakAtWordBoundary ||
+                    isWordCharacter(last.text.front()) || !isWordCharacter(ch);
+            }
+            else if (delta.offset == last.offset) // Delete
+            {
+                return !setting.breakAtWordBoundary ||
+                    isWordCharacter(last.text.back()) || !isWordCharacter(ch);
+            }
+            return false;
+        }
+    }
+
+    void EditHistory::trimToBudget()
+    {
+        // Keep the group being recorded intact until it is closed.
+        size_t reserved = m_groupDepth > 0 ? 1 : 0;
+
+        while (m_memoryUsage > setting.memoryBudget && m_undoGroups.size() > reserved)
+        {
+            m_memoryUsage -= m_undoGroups.front().memoryUsage();
+            m_undoGroups.pop_front();
+        }
+    }
+
+    bool EditHistory::isWordCharacter(wchar_t ch)
+    {
+        return std::iswalnum(ch) || ch == L'_';
+    }
+}
@@ -0,0 +1,112 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Records the modifications of a text buffer as compact deltas,
+    // so that only the inserted/erased fragments are kept in memory
+    // instead of the snapshots of the whole text content.
+    //
+    // The history does not own the text buffer, and undo/redo works by
+    // passing the deltas to be applied back to the caller one by one,
+    // in which case the cost is proportional to the size of the deltas.
+
+    struct EditHistory
+    {
+        using Clock = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        struct Delta
+        {
+            enum class Type { Insert, Erase } type = Type::Insert;
+
+            size_t offset = 0;
+
+            Wstring text = {};
+
+            // Returns the delta that cancels out this one.
+            Delta inverse() const;
+
+            // Returns the indicator position after applying this delta.
+            size_t caretAfter() const;
+        };
+
+        struct Group
+        {
+            std::vector<Delta> deltas = {};
+
+            TimePoint timestamp = {};
+
+            // A sealed group never merges with the subsequent deltas.
+            bool sealed = false;
+
+            size_t memoryUsage() const;
+        };
+
+        struct Setting
+        {
+            // The history discards the oldest groups when the total memory
+            // occupied by the recorded deltas exceeds this budget.
+            size_t memoryBudget = 4 * 1024 * 1024;
+
+            // Consecutive typing within this interval merges into one group.
+            float mergeIntervalSecs = 1.0f;
+
+            // Whether to start a new group at the beginning of each word.
+            bool breakAtWordBoundary = true;
+        }
+        setting = {};
+
+    protected:
+        std::deque<Group> m_undoGroups = {};
+        std::vector<Group> m_redoGroups = {};
+
+        size_t m_memoryUsage = 0;
+
+        // Deltas recorded between beginGroup and endGroup are kept together.
+        uint32_t m_groupDepth = 0;
+
+        // The next delta will open a new group, used by beginGroup.
+        bool m_forceNewGroup = false;
+
+    public:
+        size_t memoryUsage() const;
+
+        size_t undoCount() const;
+        size_t redoCount() const;
+
+        bool canUndo() const;
+        bool canRedo() const;
+
+        void clear();
+
+        // Prevents the last group from merging with the subsequent deltas,
+        // which is usually called when the indicator is moved manually.
+        void seal();
+
+        // Opens a compound group (e.g. replacing a selection by pasting),
+        // which is undone/redone as a whole and never merges with others.
+        void beginGroup();
+        void endGroup();
+
+        void recordInsert(size_t offset, WstrRefer text, TimePoint time = Clock::now());
+        void recordErase(size_t offset, WstrRefer text, TimePoint time = Clock::now());
+
+        using DeltaApplier = FuncRefer<void(const Delta&)>;
+
+        // Returns the indicator position after undo/redo, or std::nullopt
+        // if there is nothing to undo/redo (the applier is not called).
+        Optional<size_t> undo(DeltaApplier apply);
+        Optional<size_t> redo(DeltaApplier apply);
+
+    protected:
+        void record(Delta&& delta, TimePoint time);
+
+        bool tryMerge(Group& group, const Delta& delta, TimePoint time) const;
+
+        void trimToBudget();
+
+        static bool isWordCharacter(wchar_t ch);
+    };
+}
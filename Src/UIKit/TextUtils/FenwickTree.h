@@ -0,0 +1,71 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // The Fenwick tree (binary indexed tree) of a fixed count of values,
+    // where changing a value and getting a prefix sum both take O(log n).
+    //
+    // T only needs a default value of zero and operator+=.
+
+    template<typename T>
+    struct FenwickTree
+    {
+    protected:
+        // 1-based, and m_nodes[i] is the sum of the values in [i - lsb(i), i).
+        std::vector<T> m_nodes = { T{} };
+
+        static size_t lsb(size_t i) { return i & (~i + 1); }
+
+    public:
+        size_t size() const { return m_nodes.size() - 1; }
+
+        // Returns the raw node for the descent, where 1 <= i <= size().
+        const T& node(size_t i) const { return m_nodes[i]; }
+
+        // Returns the largest power of 2 not greater than size() (or 0),
+        // i.e. the first step of the descent.
+        size_t topStep() const
+        {
+            return size() > 0 ? std::bit_floor(size()) : 0;
+        }
+
+        // Builds the tree of the values in linear time.
+        template<typename ValueOf_T>
+        void build(size_t count, ValueOf_T&& valueOf)
+        {
+            m_nodes.assign(1, T{});
+            m_nodes.reserve(count + 1);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_nodes.push_back(valueOf(i));
+            }
+            for (size_t i = 1; i <= count; ++i)
+            {
+                auto parent = i + lsb(i);
+                if (parent <= count) m_nodes[parent] += m_nodes[i];
+            }
+        }
+
+        void add(size_t index, const T& delta)
+        {
+            for (auto i = index + 1; i < m_nodes.size(); i += lsb(i))
+            {
+                m_nodes[i] += delta;
+            }
+        }
+
+        // Returns the sum of the first n values.
+        T prefix(size_t n) const
+        {
+            T sum = {};
+            for (auto i = std::min(n, size()); i > 0; i -= lsb(i))
+            {
+                sum += m_nodes[i];
+            }
+            return sum;
+        }
+    };
+}
@@ -0,0 +1,220 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/FontCatalog.h"
+
+namespace d14engine::uikit::text_utils
+{
+    FontCatalog::FontCatalog(const Source& source, const Fingerprint& fingerprint)
+        :
+        m_source(source),
+        m_fingerprint(fingerprint) { }
+
+    FontCatalog::~FontCatalog()
+    {
+        // The worker may still refer to the source, so it must exit first,
+        // and any exception it has thrown is discarded at this point.
+        if (m_pending.valid()) m_pending.wait();
+    }
+
+    FontCatalog::Result FontCatalog::load(
+        const Source& source,
+        const Fingerprint& fingerprint,
+        const Wstring& cacheFilePath,
+        bool forceSource)
+    {
+        Optional<uint64_t> digest = {};
+        if (!cacheFilePath.empty() && fingerprint)
+        {
+            digest = fingerprint();
+        }
+        if (digest.has_value() && !forceSource)
+        {
+            auto fonts = readCache(cacheFilePath, digest.value());
+            if (fonts.has_value())
+            {
+                return { std::move(fonts.value()), Origin::Cache };
+            }
+        }
+        Result result = { source ? source() : FontNameSet{}, Origin::Source };
+
+        if (digest.has_value())
+        {
+            // A failed write only costs another enumeration next time.
+            writeCache(cacheFilePath, digest.value(), result.fonts);
+        }
+        return result;
+    }
+
+    void FontCatalog::wait()
+    {
+        if (m_pending.valid())
+        {
+            // Rethrows the exception thrown by the worker (if any).
+            auto result = m_pending.get();
+
+            m_fonts = std::move(result.fonts);
+            m_origin = result.origin;
+        }
+    }
+
+    void FontCatalog::prefetch()
+    {
+        if (isLoading() || isLoaded()) return;
+
+        // The arguments are captured by value, so the setting is free to
+        // be modified while the worker is running.
+        m_pending = std::async(std::launch::async, &FontCatalog::load,
+            m_source, m_fingerprint, setting.cacheFilePath, false);
+    }
+
+    bool FontCatalog::isLoading() const
+    {
+        return m_pending.valid();
+    }
+
+    bool FontCatalog::isLoaded() const
+    {
+        return m_origin != Origin::None;
+    }
+
+    FontCatalog::Origin FontCatalog::origin() const
+    {
+        return m_origin;
+    }
+
+    const FontNameSet& FontCatalog::fonts()
+    {
+        wait();
+
+        if (!isLoaded())
+        {
+            auto result = load(m_source, m_fingerprint, setting.cacheFilePath, false);
+
+            m_fonts = std::move(result.fonts);
+            m_origin = result.origin;
+        }
+        return m_fonts;
+    }
+
+    const FontNameSet& FontCatalog::refresh()
+    {
+        // Waits for the prefetch even though the result will be replaced,
+        // so the two writers of the cache file never run concurrently.
+        if (m_pending.valid()) m_pending.wait();
+        m_pending = {};
+
+        auto result = load(m_source, m_fingerprint, setting.cacheFilePath, true);
+
+        m_fonts = std::move(result.fonts);
+        m_origin = result.origin;
+
+        return m_fonts;
+    }
+
+    namespace
+    {
+        // File layout (native endianness):
+        // magic, version, sizeof(wchar_t), fingerprint, font count,
+        // followed by the length-prefixed family and locale of each font.
+
+        constexpr uint32_t g_cacheMagic = 0x544e4f46; // "FONT"
+        constexpr uint32_t g_cacheVersion = 1;
+
+        // Font names are far shorter in practice, and the limit prevents
+        // a corrupted length from causing a huge allocation.
+        constexpr uint32_t g_maxNameLength = 4096;
+
+        template<typename T>
+        bool readValue(std::istream& stream, T& value)
+        {
+            return (bool)stream.read((char*)&value, sizeof(T));
+        }
+
+        template<typename T>
+        void writeValue(std::ostream& stream, const T& value)
+        {
+            stream.write((const char*)&value, sizeof(T));
+        }
+
+        bool readString(std::istream& stream, Wstring& str)
+        {
+            uint32_t length = {};
+            if (!readValue(stream, length) || length > g_maxNameLength)
+            {
+                return false;
+            }
+            str.resize(length);
+            return (bool)stream.read((char*)str.data(), length * sizeof(wchar_t));
+        }
+
+        void writeString(std::ostream& stream, const Wstring& str)
+        {
+            writeValue(stream, (uint32_t)str.size());
+            stream.write((const char*)str.data(), str.size() * sizeof(wchar_t));
+        }
+    }
+
+    Optional<FontNameSet> FontCatalog::readCache(const Wstring& path, uint64_t fingerprint)
+    {
+        std::ifstream stream(std::filesystem::path(path), std::ios::binary);
+        if (!stream) return std::nullopt;
+
+        uint32_t magic = {}, version = {}, charSize = {};
+        uint64_t digest = {}, count = {};
+
+        if (!readValue(stream, magic) || magic != g_cacheMagic ||
+            !readValue(stream, version) || version != g_cacheVersion ||
+            !readValue(stream, charSize) || charSize != sizeof(wchar_t) ||
+            !readValue(stream, digest) || digest != fingerprint ||
+            !readValue(stream, count))
+        {
+            return std::nullopt;
+        }
+        FontNameSet fonts = {};
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            FontName font = {};
+            if (!readString(stream, font.family) ||
+                !readString(stream, font.locale))
+            {
+                return std::nullopt;
+            }
+            fonts.insert(fonts.end(), std::move(font));
+        }
+        return fonts;
+    }
+
+    bool FontCatalog::writeCache(const Wstring& path, uint64_t fingerprint, const FontNameSet& fonts)
+    {
+        std::filesystem::path target(path);
+
+        auto temporary = target;
+        temporary += L".tmp";
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+            if (!stream) return false;
+
+            writeValue(stream, g_cacheMagic);
+            writeValue(stream, g_cacheVersion);
+            writeValue(stream, (uint32_t)sizeof(wchar_t));
+            writeValue(stream, fingerprint);
+            writeValue(stream, (uint64_t)fonts.size());
+
+            for (auto& font : fonts)
+            {
+                writeString(stream, font.family);
+                writeString(stream, font.locale);
+            }
+            if (!stream.flush()) return false;
+        }
+        std::error_code error = {};
+        std::filesystem::rename(temporary, target, error);
+
+        if (error)
+        {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+}
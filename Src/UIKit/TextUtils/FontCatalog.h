@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/CppLangUtils/NonCopyable.h"
+
+namespace d14engine::uikit::text_utils
+{
+    struct FontName
+    {
+        Wstring family = {};
+        Wstring locale = {};
+
+        bool operator==(const FontName&) const = default;
+    };
+    struct FontNameLess
+    {
+        bool operator()(const FontName& lhs, const FontName& rhs) const
+        {
+            return std::tie(lhs.family, lhs.locale) < std::tie(rhs.family, rhs.locale);
+        }
+    };
+    using FontNameSet = std::set<FontName, FontNameLess>;
+
+    // Keeps the enumeration of the installed fonts off the critical path
+    // of startup: prefetch() runs it in a worker thread, and fonts() only
+    // blocks if the result is queried before the worker finishes (or does
+    // the whole work in place if nothing was prefetched).
+    //
+    // The result can be persisted to a cache file together with a cheap
+    // fingerprint of the installed fonts (e.g. the write time of the font
+    // directories), and the cache is reused until the fingerprint changes,
+    // so the expensive source is only consulted after fonts are changed.
+
+    struct FontCatalog : cpp_lang_utils::NonCopyable
+    {
+        // Enumerates the installed fonts (expected to be expensive).
+        using Source = Function<FontNameSet()>;
+
+        // Returns nullopt if the fingerprint is unavailable, in which case
+        // the cache is neither read nor written.
+        using Fingerprint = Function<Optional<uint64_t>()>;
+
+        FontCatalog(const Source& source, const Fingerprint& fingerprint = {});
+
+        ~FontCatalog();
+
+        struct Setting
+        {
+            // The cache file is disabled if the path is empty.
+            Wstring cacheFilePath = {};
+        }
+        setting = {};
+
+        enum class Origin { None, Cache, Source };
+
+    protected:
+        Source m_source = {};
+        Fingerprint m_fingerprint = {};
+
+        FontNameSet m_fonts = {};
+        Origin m_origin = Origin::None;
+
+        struct Result
+        {
+            FontNameSet fonts = {};
+            Origin origin = Origin::None;
+        };
+        std::future<Result> m_pending = {};
+
+        // Tries the cache first unless forceSource is true, and updates
+        // the cache after consulting the source.  Thread-safe as long as
+        // the source and the fingerprint are.
+        static Result load(
+            const Source& source,
+            const Fingerprint& fingerprint,
+            const Wstring& cacheFilePath,
+            bool forceSource);
+
+        void wait();
+
+    public:
+        // Starts loading in a worker thread if not loaded or loading yet.
+        void prefetch();
+
+        bool isLoading() const;
+        bool isLoaded() const;
+
+        // Where the current set came from (None if not loaded yet).
+        Origin origin() const;
+
+        // Waits for the prefetch if any, otherwise loads in place.
+        const FontNameSet& fonts();
+
+        // Consults the source regardless of the cache (e.g. the user has
+        // installed a new font while the application is running).
+        const FontNameSet& refresh();
+
+        // Returns nullopt if the file is missing, corrupted, or created
+        // with a different fingerprint.
+        static Optional<FontNameSet> readCache(const Wstring& path, uint64_t fingerprint);
+
+        // The file is replaced atomically, so a reader never sees a partial one.
+        static bool writeCache(const Wstring& path, uint64_t fingerprint, const FontNameSet& fonts);
+    };
+}
@@ -0,0 +1,300 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/FenwickTree.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Keeps a per-line item (e.g. the length or the height of a line) of
+    // a huge number of lines in blocks of at most MaxBlockSize items, with
+    // the sums of the blocks in a Fenwick tree, so that all of
+    //
+    // changing an item,
+    // inserting/erasing items (i.e. lines),
+    // getting the sum of the first n items,
+    // and finding the first item at which the running sum reaches a limit
+    //
+    // take O(MaxBlockSize + log n), and no item after an edit is touched.
+    // The tree of the blocks is only rebuilt when a block is split/dropped.
+    //
+    // Sum_T is the summary of an item given by Summarize_T, which needs a
+    // default value of zero, operator+= and operator-=.
+
+    template<typename Item_T, typename Sum_T = Item_T, typename Summarize_T = std::identity>
+    struct LineBlocks
+    {
+        static constexpr size_t MaxBlockSize = 512;
+
+    protected:
+        struct Block
+        {
+            std::vector<Item_T> items = {};
+
+            Sum_T sum = {};
+        };
+        std::vector<Block> m_blocks = {};
+
+        FenwickTree<Sum_T> m_sumTree = {};
+        FenwickTree<size_t> m_sizeTree = {};
+
+        size_t m_size = 0;
+
+        static Sum_T summarize(const Item_T& item)
+        {
+            return Sum_T(Summarize_T{}(item));
+        }
+
+        void rebuildTrees()
+        {
+            m_sumTree.build(m_blocks.size(), [this](size_t b) { return m_blocks[b].sum; });
+            m_sizeTree.build(m_blocks.size(), [this](size_t b) { return m_blocks[b].items.size(); });
+        }
+
+        // Returns { block, offset in block } of the item at index, where
+        // index == size() is located at the end of the last block.
+        std::pair<size_t, size_t> locate(size_t index) const
+        {
+            if (m_blocks.empty()) return { 0, 0 };
+
+            if (index >= m_size)
+            {
+                return { m_blocks.size() - 1, m_blocks.back().items.size() };
+            }
+            size_t pos = 0, count = 0;
+            for (auto step = m_sizeTree.topStep(); step > 0; step >>= 1)
+            {
+                auto next = pos + step;
+                if (next <= m_blocks.size() && count + m_sizeTree.node(next) <= index)
+                {
+                    pos = next;
+                    count += m_sizeTree.node(next);
+                }
+            }
+            return { pos, index - count };
+        }
+
+        // Splits the block into halves until all of them fit.
+        void splitBlock(size_t b)
+        {
+            auto& items = m_blocks[b].items;
+            if (items.size() <= MaxBlockSize) return;
+
+            std::vector<Block> blocks = {};
+            for (size_t i = 0; i < items.size(); i += MaxBlockSize / 2)
+            {
+                auto& block = blocks.emplace_back();
+
+                auto last = std::min(i + MaxBlockSize / 2, items.size());
+                block.items.assign(items.begin() + i, items.begin() + last);
+
+                for (auto& item : block.items) block.sum += summarize(item);
+            }
+            m_blocks.erase(m_blocks.begin() + b);
+            m_blocks.insert(m_blocks.begin() + b,
+                std::make_move_iterator(blocks.begin()), std::make_move_iterator(blocks.end()));
+
+            rebuildTrees();
+        }
+
+    public:
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        const Item_T& operator[](size_t index) const
+        {
+            auto [b, offset] = locate(index);
+            return m_blocks[b].items[offset];
+        }
+
+        void clear()
+        {
+            m_blocks.clear();
+            m_size = 0;
+
+            rebuildTrees();
+        }
+
+        void assign(size_t count, const Item_T& item)
+        {
+            m_blocks.clear();
+            m_size = count;
+
+            for (size_t i = 0; i < count; i += MaxBlockSize / 2)
+            {
+                auto& block = m_blocks.emplace_back();
+                block.items.assign(std::min(MaxBlockSize / 2, count - i), item);
+
+                for (auto& item : block.items) block.sum += summarize(item);
+            }
+            rebuildTrees();
+        }
+
+        // Modifies the item at index in place, e.g. modify(i, [](T& x) { ++x; }).
+        template<typename Modify_T>
+        void modify(size_t index, Modify_T&& modify)
+        {
+            auto [b, offset] = locate(index);
+            auto& item = m_blocks[b].items[offset];
+
+            Sum_T delta = {};
+            delta -= summarize(item);
+
+            modify(item);
+            delta += summarize(item);
+
+            m_blocks[b].sum += delta;
+            m_sumTree.add(b, delta);
+        }
+
+        template<typename Iterator_T>
+        void insertRange(size_t index, Iterator_T first, Iterator_T last)
+        {
+            auto count = (size_t)std::distance(first, last);
+            if (count == 0) return;
+
+            if (m_blocks.empty())
+            {
+                m_blocks.emplace_back();
+                rebuildTrees();
+            }
+            auto [b, offset] = locate(std::min(index, m_size));
+            auto& block = m_blocks[b];
+
+            block.items.insert(block.items.begin() + offset, first, last);
+            m_size += count;
+
+            if (block.items.size() > MaxBlockSize)
+            {
+                splitBlock(b);
+            }
+            else // Only the sums of this block change.
+            {
+                Sum_T delta = {};
+                for (auto i = offset; i < offset + count; ++i)
+                {
+                    delta += summarize(block.items[i]);
+                }
+                block.sum += delta;
+
+                m_sumTree.add(b, delta);
+                m_sizeTree.add(b, count);
+            }
+        }
+
+        void insert(size_t index, size_t count, const Item_T& item)
+        {
+            // Inserts in chunks so that each one fits in a block.
+            for (size_t inserted = 0; inserted < count; inserted += MaxBlockSize)
+            {
+                auto chunk = std::vector<Item_T>(std::min(MaxBlockSize, count - inserted), item);
+                insertRange(index + inserted, chunk.begin(), chunk.end());
+            }
+        }
+
+        void erase(size_t index, size_t count)
+        {
+            count = std::min(count, m_size - std::min(index, m_size));
+
+            while (count > 0)
+            {
+                auto [b, offset] = locate(index);
+                auto& block = m_blocks[b];
+
+                auto last = std::min(block.items.size(), offset + count);
+
+                Sum_T delta = {};
+                for (auto i = offset; i < last; ++i)
+                {
+                    delta -= summarize(block.items[i]);
+                }
+                block.items.erase(block.items.begin() + offset, block.items.begin() + last);
+
+                auto erased = last - offset;
+                m_size -= erased;
+                count -= erased;
+
+                if (block.items.empty())
+                {
+                    m_blocks.erase(m_blocks.begin() + b);
+                    rebuildTrees();
+                }
+                else
+                {
+                    block.sum += delta;
+
+                    m_sumTree.add(b, delta);
+                    m_sizeTree.add(b, (size_t)0 - erased);
+                }
+            }
+        }
+
+        Sum_T total() const
+        {
+            return m_sumTree.prefix(m_blocks.size());
+        }
+
+        // Returns the sum of the first n items.
+        Sum_T prefix(size_t n) const
+        {
+            if (n >= m_size) return total();
+
+            auto [b, offset] = locate(n);
+            auto& items = m_blocks[b].items;
+
+            // Sums the shorter side of the block.
+            if (offset <= items.size() / 2)
+            {
+                auto sum = m_sumTree.prefix(b);
+                for (size_t i = 0; i < offset; ++i) sum += summarize(items[i]);
+                return sum;
+            }
+            else
+            {
+                auto sum = m_sumTree.prefix(b + 1);
+                for (auto i = offset; i < items.size(); ++i) sum -= summarize(items[i]);
+                return sum;
+            }
+        }
+
+        // Returns the largest n such that predicate(prefix(n), n) holds,
+        // where the predicate must be monotone, i.e. once it fails for n,
+        // it fails for all the larger n, and it is assumed to hold for 0.
+        template<typename Predicate_T>
+        size_t countWhile(Predicate_T&& predicate) const
+        {
+            Sum_T sum = {};
+            size_t pos = 0, count = 0;
+
+            for (auto step = m_sumTree.topStep(); step > 0; step >>= 1)
+            {
+                auto next = pos + step;
+                if (next <= m_blocks.size())
+                {
+                    auto nextSum = sum;
+                    nextSum += m_sumTree.node(next);
+
+                    auto nextCount = count + m_sizeTree.node(next);
+                    if (predicate(nextSum, nextCount))
+                    {
+                        pos = next;
+                        sum = nextSum;
+                        count = nextCount;
+                    }
+                }
+            }
+            if (pos < m_blocks.size())
+            {
+                for (auto& item : m_blocks[pos].items)
+                {
+                    sum += summarize(item);
+                    if (!predicate(sum, count + 1)) break;
+                    ++count;
+                }
+            }
+            return count;
+        }
+    };
+}
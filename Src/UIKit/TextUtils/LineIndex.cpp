@@ -0,0 +1,113 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/LineIndex.h"
+
+namespace d14engine::uikit::text_utils
+{
+    void LineIndex::build(WstrViewRefer text)
+    {
+        std::vector<size_t> lengths = {};
+        m_textLength = text.size();
+
+        size_t start = 0;
+        for (auto pos = text.find(L'\n'); pos != WstringView::npos; pos = text.find(L'\n', pos + 1))
+        {
+            lengths.push_back(pos + 1 - start);
+            start = pos + 1;
+        }
+        lengths.push_back(text.size() - start);
+
+        m_lineLengths.clear();
+        m_lineLengths.insertRange(0, lengths.begin(), lengths.end());
+    }
+
+    LineIndex::Change LineIndex::onInsert(size_t offset, WstrViewRefer fragment)
+    {
+        // An empty text still has one (empty) line.
+        if (m_lineLengths.size() == 0) m_lineLengths.assign(1, 0);
+
+        auto line = lineOfOffset(offset);
+        m_textLength += fragment.size();
+
+        auto pos = fragment.find(L'\n');
+        if (pos == WstringView::npos)
+        {
+            m_lineLengths.modify(line, [&](size_t& length) { length += fragment.size(); });
+
+            return { line, 1, 1 };
+        }
+        // The line is split at offset, and the fragment lines go between.
+        auto head = offset - m_lineLengths.prefix(line);
+        auto tail = m_lineLengths[line] - head;
+
+        m_lineLengths.modify(line, [&](size_t& length) { length = head + pos + 1; });
+
+        std::vector<size_t> lengths = {};
+        for (auto next = fragment.find(L'\n', pos + 1); next != WstringView::npos; next = fragment.find(L'\n', pos + 1))
+        {
+            lengths.push_back(next - pos);
+            pos = next;
+        }
+        lengths.push_back(fragment.size() - (pos + 1) + tail);
+
+        m_lineLengths.insertRange(line + 1, lengths.begin(), lengths.end());
+
+        return { line, 1, 1 + lengths.size() };
+    }
+
+    LineIndex::Change LineIndex::onErase(size_t offset, WstrViewRefer fragment)
+    {
+        auto line = lineOfOffset(offset);
+        auto end = offset + fragment.size();
+
+        // The lines start within (offset, end] are joined into the first one.
+        auto last = lineOfOffset(end);
+        m_textLength -= fragment.size();
+
+        if (last == line)
+        {
+            m_lineLengths.modify(line, [&](size_t& length) { length -= fragment.size(); });
+
+            return { line, 1, 1 };
+        }
+        auto head = offset - m_lineLengths.prefix(line);
+        auto tail = m_lineLengths.prefix(last + 1) - end;
+
+        m_lineLengths.modify(line, [&](size_t& length) { length = head + tail; });
+        m_lineLengths.erase(line + 1, last - line);
+
+        return { line, 1 + last - line, 1 };
+    }
+
+    size_t LineIndex::lineCount() const
+    {
+        return std::max<size_t>(m_lineLengths.size(), 1);
+    }
+
+    size_t LineIndex::textLength() const
+    {
+        return m_textLength;
+    }
+
+    LineIndex::Range LineIndex::lineRange(size_t line) const
+    {
+        if (m_lineLengths.size() == 0) return { 0, 0 };
+
+        auto offset = m_lineLengths.prefix(line);
+        if (line + 1 < m_lineLengths.size())
+        {
+            // Excludes the '\n' at the end of the line.
+            return { offset, m_lineLengths[line] - 1 };
+        }
+        else return { offset, m_lineLengths[line] };
+    }
+
+    size_t LineIndex::lineOfOffset(size_t offset) const
+    {
+        // The lines that end at or before offset precede the target line,
+        // and only the last line can be empty, so the line ends increase.
+        auto count = m_lineLengths.countWhile([&](size_t length, size_t) { return length <= offset; });
+
+        return std::min(count, lineCount() - 1);
+    }
+}
@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/LineBlocks.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Keeps the length of each line in a text buffer (see LineBlocks), so
+    // that locating a line or the line of a character takes O(log n) with
+    // no scanning of the text, and an edit only re-scans the fragment and
+    // changes the lengths of the affected lines (the later ones are kept).
+    //
+    // A line ends at '\n' (excluded from its range), and a trailing '\r'
+    // is considered as part of the line content (i.e. not trimmed here).
+
+    struct LineIndex
+    {
+        struct Range { size_t offset, count; };
+
+        // Describes the lines affected by an edit:
+        // the lines in [first, first + removed) are replaced by
+        // the lines in [first, first + inserted) after the edit.
+        struct Change { size_t first, removed, inserted; };
+
+    protected:
+        // Each length includes the '\n' at the end of the line (if any).
+        LineBlocks<size_t> m_lineLengths = {};
+
+        size_t m_textLength = 0;
+
+    public:
+        void build(WstrViewRefer text);
+
+        Change onInsert(size_t offset, WstrViewRefer fragment);
+        Change onErase(size_t offset, WstrViewRefer fragment);
+
+        size_t lineCount() const;
+        size_t textLength() const;
+
+        Range lineRange(size_t line) const;
+
+        // Returns the line that contains the character at offset.
+        size_t lineOfOffset(size_t offset) const;
+    };
+}
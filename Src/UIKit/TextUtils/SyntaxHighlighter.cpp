@@ -0,0 +1,148 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/SyntaxHighlighter.h"
+
+namespace d14engine::uikit::text_utils
+{
+    SyntaxHighlighter::SyntaxHighlighter(ShrdPtrRefer<SyntaxLexer> lexer)
+        :
+        m_lexer(lexer)
+    {
+        // RuntimeError depends on Windows, so the standard one is thrown
+        // to keep the highlighter portable.
+        if (m_lexer == nullptr)
+        {
+            throw std::invalid_argument("SyntaxHighlighter requires a lexer");
+        }
+    }
+
+    const SharedPtr<SyntaxLexer>& SyntaxHighlighter::lexer() const
+    {
+        return m_lexer;
+    }
+
+    void SyntaxHighlighter::reset(size_t lineCount)
+    {
+        m_lines.assign(lineCount, {});
+
+        // The lines that have never been lexed never converge,
+        // so there is no need to mark them as dirty explicitly.
+        m_dirtyBegin = m_dirtyEnd = 0;
+    }
+
+    void SyntaxHighlighter::replace(size_t first, size_t removed, size_t inserted)
+    {
+        auto originalCount = m_lines.size();
+
+        first = std::min(first, originalCount);
+        removed = std::min(removed, originalCount - first);
+
+        auto itor = m_lines.erase(m_lines.begin() + first, m_lines.begin() + first + removed);
+        m_lines.insert(itor, inserted, {});
+
+        if (m_dirtyBegin >= originalCount) // all lines were up to date
+        {
+            m_dirtyBegin = first;
+            m_dirtyEnd = first + inserted;
+        }
+        else // merges with the pending dirty lines
+        {
+            auto shift = [&](size_t line)
+            {
+                if (line <= first) return line;
+                else if (line >= first + removed) return line - removed + inserted;
+                else return first + inserted;
+            };
+            m_dirtyBegin = std::min(m_dirtyBegin, first);
+            m_dirtyEnd = std::max(shift(m_dirtyEnd), first + inserted);
+        }
+    }
+
+    size_t SyntaxHighlighter::lineCount() const
+    {
+        return m_lines.size();
+    }
+
+    size_t SyntaxHighlighter::lexedLineCount() const
+    {
+        return std::min(m_dirtyBegin, m_lines.size());
+    }
+
+    const SyntaxHighlighter::TokenArray& SyntaxHighlighter::tokens(size_t line) const
+    {
+        return m_lines[line].tokens;
+    }
+
+    SyntaxHighlighter::ChangeArray SyntaxHighlighter::update(size_t lineLimit, LineGetter getLine)
+    {
+        ChangeArray changes = {};
+
+        auto count = m_lines.size();
+        lineLimit = std::min(lineLimit, count);
+
+        auto line = m_dirtyBegin;
+        for (; line < count; ++line)
+        {
+            auto state = line > 0 ? m_lines[line - 1].endState : SyntaxLexer::InitialState;
+            auto& data = m_lines[line];
+
+            // An untouched line that starts with the same state produces
+            // the same tokens, and so do all the lines after it.
+            if (line >= m_dirtyEnd && data.isLexed && data.startState == state)
+            {
+                line = count; break;
+            }
+            if (line >= lineLimit) break;
+
+            TokenArray tokens = {};
+            auto endState = m_lexer->lexLine(getLine(line), state, tokens);
+
+            auto span = diff(data.tokens, tokens);
+            if (span.has_value())
+            {
+                changes.push_back({ line, span.value() });
+            }
+            data = { state, endState, true, std::move(tokens) };
+        }
+        m_dirtyBegin = line;
+
+        if (m_dirtyBegin >= count) m_dirtyEnd = count;
+
+        // The cached start state of the line where the lexing stops may
+        // be stale, so it must not be compared in the convergence check.
+        else m_dirtyEnd = std::max(m_dirtyEnd, m_dirtyBegin + 1);
+
+        return changes;
+    }
+
+    Optional<SyntaxHighlighter::Span> SyntaxHighlighter::diff(const TokenArray& before, const TokenArray& after)
+    {
+        auto minCount = std::min(before.size(), after.size());
+
+        size_t head = 0;
+        while (head < minCount && before[head] == after[head]) ++head;
+
+        if (head == before.size() && head == after.size()) return std::nullopt;
+
+        size_t tail = 0;
+        while (tail < minCount - head &&
+               before[before.size() - 1 - tail] == after[after.size() - 1 - tail]) ++tail;
+
+        // The tokens are sorted and never overlap with each other,
+        // so the differences are covered by the remaining ones.
+        size_t spanBegin = SIZE_MAX, spanEnd = 0;
+
+        auto extend = [&](const TokenArray& tokens)
+        {
+            for (auto i = head; i < tokens.size() - tail; ++i)
+            {
+                spanBegin = std::min(spanBegin, tokens[i].offset);
+                spanEnd = std::max(spanEnd, tokens[i].offset + tokens[i].count);
+            }
+        };
+        extend(before);
+        extend(after);
+
+        return Span{ spanBegin, spanEnd - spanBegin };
+    }
+}
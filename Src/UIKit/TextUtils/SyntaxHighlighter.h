@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/SyntaxLexer.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Caches the lexer state at the start of each line, so that an edit
+    // only re-lexes from the first changed line, and the re-lexing stops
+    // as soon as the state of an untouched line converges to the cached.
+    //
+    // The lines beyond the requested limit are left to the next update,
+    // thus opening a block comment in a huge file costs no more than the
+    // lines in view, and the rest gets lexed while scrolling down.
+
+    struct SyntaxHighlighter
+    {
+        explicit SyntaxHighlighter(ShrdPtrRefer<SyntaxLexer> lexer);
+
+        using State = SyntaxLexer::State;
+        using Token = SyntaxLexer::Token;
+        using TokenArray = SyntaxLexer::TokenArray;
+
+        struct Span { size_t offset, count; };
+
+        // The styled characters of the line in the span have been changed.
+        struct Change { size_t line; Span span; };
+
+        using ChangeArray = std::vector<Change>;
+
+    protected:
+        SharedPtr<SyntaxLexer> m_lexer = {};
+
+        struct LineData
+        {
+            State startState = SyntaxLexer::InitialState;
+            State endState = SyntaxLexer::InitialState;
+
+            bool isLexed = false;
+
+            TokenArray tokens = {};
+        };
+        std::vector<LineData> m_lines = {};
+
+        // The lines in [m_dirtyBegin, m_dirtyEnd) must be re-lexed, and
+        // the subsequent ones are re-lexed until the state converges.
+        size_t m_dirtyBegin = 0, m_dirtyEnd = 0;
+
+    public:
+        const SharedPtr<SyntaxLexer>& lexer() const;
+
+        // Marks all lines as not lexed (e.g. the whole text is replaced).
+        void reset(size_t lineCount);
+
+        // Called after the lines in [first, first + removed) are replaced
+        // by [first, first + inserted), which has the same meaning as that
+        // of LineIndex::Change and VirtualLines::replace.
+        void replace(size_t first, size_t removed, size_t inserted);
+
+        size_t lineCount() const;
+
+        // The tokens of the lines in [0, lexedLineCount()) are up to date,
+        // and those of the others may be stale or empty.
+        size_t lexedLineCount() const;
+
+        const TokenArray& tokens(size_t line) const;
+
+        using LineGetter = FuncRefer<WstringView(size_t line)>;
+
+        // Re-lexes the dirty lines before lineLimit (exclusive),
+        // and returns the changes of the styled characters.
+        ChangeArray update(size_t lineLimit, LineGetter getLine);
+
+        // Returns the span that covers all differences of the styled
+        // characters, or std::nullopt if the two arrays are the same.
+        static Optional<Span> diff(const TokenArray& before, const TokenArray& after);
+    };
+}
@@ -0,0 +1,211 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/SyntaxLexer.h"
+
+namespace d14engine::uikit::text_utils
+{
+    CLikeLexer::CLikeLexer()
+    {
+        keywords =
+        {
+            L"alignas", L"alignof", L"auto", L"bool", L"break", L"case",
+            L"catch", L"char", L"class", L"const", L"consteval", L"constexpr",
+            L"constinit", L"continue", L"decltype", L"default", L"delete",
+            L"do", L"double", L"else", L"enum", L"explicit", L"export",
+            L"extern", L"false", L"float", L"for", L"friend", L"goto", L"if",
+            L"inline", L"int", L"long", L"mutable", L"namespace", L"new",
+            L"noexcept", L"nullptr", L"operator", L"override", L"private",
+            L"protected", L"public", L"return", L"short", L"signed", L"sizeof",
+            L"static", L"static_assert", L"struct", L"switch", L"template",
+            L"this", L"throw", L"true", L"try", L"typedef", L"typename",
+            L"union", L"unsigned", L"using", L"virtual", L"void", L"volatile",
+            L"wchar_t", L"while"
+        };
+    }
+
+    SyntaxLexer::State CLikeLexer::lexLine(WstrViewRefer line, State state, TokenArray& tokens) const
+    {
+        auto length = line.size();
+        size_t pos = 0;
+
+        auto append = [&](size_t offset, size_t count, SyntaxKind kind)
+        {
+            if (count == 0) return;
+
+            // Merges the adjacent tokens of the same kind (e.g. "+=").
+            if (!tokens.empty())
+            {
+                auto& last = tokens.back();
+                if (last.kind == kind && last.offset + last.count == offset)
+                {
+                    last.count += count; return;
+                }
+            }
+            tokens.push_back({ offset, count, kind });
+        };
+        // Returns the end of the block comment, or npos if not closed.
+        auto closeBlockComment = [&](size_t from)
+        {
+            auto end = line.find(L"*/", from);
+            return end != WstringView::npos ? end + 2 : WstringView::npos;
+        };
+        // Returns the end of the literal, or npos if not closed.
+        auto closeLiteral = [&](size_t from, wchar_t quote)
+        {
+            for (auto i = from; i < length; ++i)
+            {
+                if (line[i] == L'\\') ++i;
+                else if (line[i] == quote) return i + 1;
+            }
+            return WstringView::npos;
+        };
+        switch (state)
+        {
+        case BlockComment:
+        {
+            auto end = closeBlockComment(0);
+            if (end == WstringView::npos)
+            {
+                append(0, length, SyntaxKind::Comment);
+                return BlockComment;
+            }
+            append(0, end, SyntaxKind::Comment);
+            pos = end;
+            break;
+        }
+        case LineComment:
+        {
+            append(0, length, SyntaxKind::Comment);
+            return endsWithBackslash(line) ? LineComment : Normal;
+        }
+        case String:
+        {
+            auto end = closeLiteral(0, L'"');
+            if (end == WstringView::npos)
+            {
+                append(0, length, SyntaxKind::String);
+                return endsWithBackslash(line) ? String : Normal;
+            }
+            append(0, end, SyntaxKind::String);
+            pos = end;
+            break;
+        }
+        case Preprocessor:
+        {
+            append(0, length, SyntaxKind::Preprocessor);
+            return endsWithBackslash(line) ? Preprocessor : Normal;
+        }
+        default: /* Normal */ break;
+        }
+        bool isLineHead = (pos == 0);
+
+        while (pos < length)
+        {
+            auto ch = line[pos];
+
+            if (std::iswspace(ch))
+            {
+                ++pos; continue;
+            }
+            if (ch == L'#' && isLineHead)
+            {
+                append(pos, length - pos, SyntaxKind::Preprocessor);
+                return endsWithBackslash(line) ? Preprocessor : Normal;
+            }
+            isLineHead = false;
+
+            auto next = (pos + 1 < length) ? line[pos + 1] : L'\0';
+
+            if (ch == L'/' && next == L'/')
+            {
+                append(pos, length - pos, SyntaxKind::Comment);
+                return endsWithBackslash(line) ? LineComment : Normal;
+            }
+            else if (ch == L'/' && next == L'*')
+            {
+                auto end = closeBlockComment(pos + 2);
+                if (end == WstringView::npos)
+                {
+                    append(pos, length - pos, SyntaxKind::Comment);
+                    return BlockComment;
+                }
+                append(pos, end - pos, SyntaxKind::Comment);
+                pos = end;
+            }
+            else if (ch == L'"' || ch == L'\'')
+            {
+                auto end = closeLiteral(pos + 1, ch);
+                if (end == WstringView::npos)
+                {
+                    append(pos, length - pos, SyntaxKind::String);
+
+                    // Only a string literal can span multiple lines.
+                    return (ch == L'"' && endsWithBackslash(line)) ? String : Normal;
+                }
+                append(pos, end - pos, SyntaxKind::String);
+                pos = end;
+            }
+            else if (std::iswdigit(ch) || (ch == L'.' && std::iswdigit(next)))
+            {
+                auto end = pos + 1;
+                while (end < length)
+                {
+                    auto curr = line[end];
+                    auto prev = line[end - 1];
+
+                    if (isIdentifierBody(curr) || curr == L'.' || curr == L'\'' ||
+                        ((curr == L'+' || curr == L'-') && isExponentMark(prev)))
+                    {
+                        ++end;
+                    }
+                    else break;
+                }
+                append(pos, end - pos, SyntaxKind::Number);
+                pos = end;
+            }
+            else if (isIdentifierHead(ch))
+            {
+                auto end = pos + 1;
+                while (end < length && isIdentifierBody(line[end])) ++end;
+
+                if (keywords.find(line.substr(pos, end - pos)) != keywords.end())
+                {
+                    append(pos, end - pos, SyntaxKind::Keyword);
+                }
+                pos = end;
+            }
+            else if (isOperator(ch))
+            {
+                append(pos, 1, SyntaxKind::Operator);
+                ++pos;
+            }
+            else ++pos;
+        }
+        return Normal;
+    }
+
+    bool CLikeLexer::isIdentifierHead(wchar_t ch)
+    {
+        return std::iswalpha(ch) || ch == L'_';
+    }
+
+    bool CLikeLexer::isIdentifierBody(wchar_t ch)
+    {
+        return std::iswalnum(ch) || ch == L'_';
+    }
+
+    bool CLikeLexer::isExponentMark(wchar_t ch)
+    {
+        return ch == L'e' || ch == L'E' || ch == L'p' || ch == L'P';
+    }
+
+    bool CLikeLexer::isOperator(wchar_t ch)
+    {
+        return ch != L'\0' && std::wcschr(L"+-*/%=<>!&|^~?:;,.()[]{}", ch) != nullptr;
+    }
+
+    bool CLikeLexer::endsWithBackslash(WstrViewRefer line)
+    {
+        return !line.empty() && line.back() == L'\\';
+    }
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::uikit::text_utils
+{
+    enum class SyntaxKind : uint8_t
+    {
+        Plain, Keyword, Number, String, Comment, Preprocessor, Operator, Count
+    };
+
+    // A lexer works line by line, and everything it needs to continue
+    // with the next line must be encoded in the returned state, so that
+    // the state at each line start can be cached to re-lex incrementally.
+
+    struct SyntaxLexer
+    {
+        using State = uint32_t;
+
+        constexpr static State InitialState = 0;
+
+        struct Token
+        {
+            // The offset is relative to the start of the line.
+            size_t offset, count; SyntaxKind kind;
+
+            bool operator==(const Token&) const = default;
+        };
+        using TokenArray = std::vector<Token>;
+
+        virtual ~SyntaxLexer() = default;
+
+        // The line excludes the '\n' (and '\r'), and the plain characters
+        // may be left uncovered by the appended tokens.
+        virtual State lexLine(WstrViewRefer line, State state, TokenArray& tokens) const = 0;
+    };
+
+    // Recognizes the common syntax of C-family languages: keywords,
+    // numbers, string/character literals, line/block comments and
+    // preprocessor directives (with backslash line continuation).
+
+    struct CLikeLexer : SyntaxLexer
+    {
+        CLikeLexer();
+
+        // Use std::less to enable Heterogeneous Lookup.
+        std::set<Wstring, std::less<>> keywords = {};
+
+        State lexLine(WstrViewRefer line, State state, TokenArray& tokens) const override;
+
+    protected:
+        enum StateValue : State
+        {
+            Normal = InitialState, BlockComment, LineComment, String, Preprocessor
+        };
+        static bool isIdentifierHead(wchar_t ch);
+        static bool isIdentifierBody(wchar_t ch);
+
+        static bool isExponentMark(wchar_t ch);
+
+        static bool isOperator(wchar_t ch);
+
+        static bool endsWithBackslash(WstrViewRefer line);
+    };
+}
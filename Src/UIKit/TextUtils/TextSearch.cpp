@@ -0,0 +1,339 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/TextSearch.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define _D14_TEXT_SEARCH_SSE2 true
+#else
+#define _D14_TEXT_SEARCH_SSE2 false
+#endif
+
+namespace d14engine::uikit::text_utils
+{
+    TextSearch::TextSearch(WstrRefer pattern, const Options& options)
+        :
+        m_pattern(pattern),
+        m_options(options)
+    {
+        m_foldedPattern = m_pattern;
+        for (auto& ch : m_foldedPattern)
+        {
+            ch = (wchar_t)std::towlower(ch);
+        }
+        if (m_options.useRegex && !m_pattern.empty())
+        {
+            auto flags = std::regex_constants::ECMAScript | std::regex_constants::optimize;
+            if (!m_options.matchCase) flags |= std::regex_constants::icase;
+
+            try
+            {
+                m_regex = std::wregex(m_pattern, flags);
+            }
+            catch (std::regex_error&) { m_regex.reset(); }
+        }
+        m_valid = !m_pattern.empty() && (!m_options.useRegex || m_regex.has_value());
+    }
+
+    const Wstring& TextSearch::pattern() const
+    {
+        return m_pattern;
+    }
+
+    const TextSearch::Options& TextSearch::options() const
+    {
+        return m_options;
+    }
+
+    bool TextSearch::valid() const
+    {
+        return m_valid;
+    }
+
+    Optional<TextSearch::Match> TextSearch::findNext(WstrViewRefer text, size_t from) const
+    {
+        if (!m_valid) return std::nullopt;
+
+        if (m_options.useRegex)
+        {
+            // Searches line by line to stop as soon as a match is found.
+            while (from < text.size())
+            {
+                auto lineEnd = text.find(L'\n', from);
+                auto last = (lineEnd != WstringView::npos) ? lineEnd + 1 : text.size();
+
+                MatchArray matches = {};
+                findAll(text, from, last, matches);
+
+                if (!matches.empty()) return matches.front();
+
+                from = last;
+            }
+            return std::nullopt;
+        }
+        for (auto pos = findLiteral(text, from, text.size());
+             pos != WstringView::npos;
+             pos = findLiteral(text, pos + 1, text.size()))
+        {
+            Match match = { pos, m_pattern.size() };
+            if (isWholeWord(text, match)) return match;
+        }
+        return std::nullopt;
+    }
+
+    Optional<TextSearch::Match> TextSearch::findPrev(WstrViewRefer text, size_t before) const
+    {
+        if (!m_valid) return std::nullopt;
+
+        before = std::min(before, text.size());
+
+        // Searches backward chunk by chunk, and takes the last match of
+        // the first chunk that contains any, which keeps the cost linear.
+        constexpr size_t chunkSize = 64 * 1024;
+
+        while (before > 0)
+        {
+            auto first = before > chunkSize ? (before - chunkSize) : 0;
+            if (m_options.useRegex && first > 0)
+            {
+                // Aligns to a line start so that no regex match is split.
+                auto lineStart = text.rfind(L'\n', first);
+                first = (lineStart != WstringView::npos) ? lineStart + 1 : 0;
+            }
+            MatchArray matches = {};
+            findAll(text, first, before, matches);
+
+            if (!matches.empty()) return matches.back();
+
+            before = first;
+        }
+        return std::nullopt;
+    }
+
+    void TextSearch::findAll(WstrViewRefer text, size_t first, size_t last, MatchArray& matches) const
+    {
+        if (!m_valid) return;
+
+        last = std::min(last, text.size());
+        if (first >= last) return;
+
+        if (m_options.useRegex)
+        {
+            findRegex(text, first, last, [&](const std::wcmatch& results, const Match& match)
+            {
+                matches.push_back(match);
+            });
+            return;
+        }
+        auto pos = findLiteral(text, first, last);
+        while (pos != WstringView::npos)
+        {
+            Match match = { pos, m_pattern.size() };
+            if (isWholeWord(text, match))
+            {
+                matches.push_back(match);
+                pos = findLiteral(text, pos + match.count, last);
+            }
+            // The whole word option may reject an earlier one of two
+            // overlapped matches, so the later one must be checked too.
+            else pos = findLiteral(text, pos + 1, last);
+        }
+    }
+
+    TextSearch::MatchArray TextSearch::findAll(WstrViewRefer text) const
+    {
+        MatchArray matches = {};
+        findAll(text, 0, text.size(), matches);
+        return matches;
+    }
+
+    Wstring TextSearch::replaceAll(WstrViewRefer text, WstrRefer replacement, size_t* replacedCount) const
+    {
+        Wstring result = {};
+        size_t count = 0, copied = 0;
+
+        if (m_options.useRegex && m_valid)
+        {
+            // Collects the matches chunk by chunk as findAll does, so that
+            // the regex never runs over the whole of a huge buffer at once.
+            constexpr size_t chunkSize = 64 * 1024;
+
+            size_t first = 0;
+            while (first < text.size())
+            {
+                auto last = std::min(first + chunkSize, text.size());
+
+                findRegex(text, first, last, [&](const std::wcmatch& results, const Match& match)
+                {
+                    result.append(text.substr(copied, match.offset - copied));
+                    result.append(results.format(replacement));
+
+                    copied = match.offset + match.count;
+                    ++count;
+                });
+                // Resumes after a match that runs across the chunk end.
+                first = std::max(last, copied);
+            }
+        }
+        else // literal
+        {
+            auto matches = findAll(text);
+            if (!matches.empty())
+            {
+                auto deltaSize = (ptrdiff_t)replacement.size() - (ptrdiff_t)m_pattern.size();
+                result.reserve(text.size() + matches.size() * std::max(deltaSize, (ptrdiff_t)0));
+            }
+            for (auto& match : matches)
+            {
+                result.append(text.substr(copied, match.offset - copied));
+                result.append(replacement);
+
+                copied = match.offset + match.count;
+            }
+            count = matches.size();
+        }
+        result.append(text.substr(copied));
+
+        if (replacedCount != nullptr) *replacedCount = count;
+
+        return result;
+    }
+
+    void TextSearch::findRegex(WstrViewRefer text, size_t first, size_t last, FuncRefer<void(const std::wcmatch&, const Match&)> callback) const
+    {
+        auto lineEnd = text.find(L'\n', last);
+        auto end = (lineEnd != WstringView::npos) ? lineEnd : text.size();
+
+        auto flags = std::regex_constants::match_default;
+        // Lets ^ and \b see the character before the range.
+        if (first > 0) flags |= std::regex_constants::match_prev_avail;
+
+        std::wcregex_iterator itor(text.data() + first, text.data() + end, m_regex.value(), flags), none;
+        for (; itor != none; ++itor)
+        {
+            Match match = { first + (size_t)itor->position(), (size_t)itor->length() };
+
+            if (match.offset >= last) break;
+            if (match.count == 0) continue;
+
+            if (isWholeWord(text, match)) callback(*itor, match);
+        }
+    }
+
+    size_t TextSearch::findLiteral(WstrViewRefer text, size_t from, size_t last) const
+    {
+        auto length = m_pattern.size();
+
+        if (length == 0 || text.size() < length) return WstringView::npos;
+
+        // The last position where the pattern can start.
+        last = std::min(last, text.size() - length + 1);
+
+        auto pos = from;
+        auto data = text.data();
+
+        auto isCandidate = [&](wchar_t ch, size_t index)
+        {
+            if (m_options.matchCase) return ch == m_pattern[index];
+            else return (wchar_t)std::towlower(ch) == m_foldedPattern[index];
+        };
+#if _D14_TEXT_SEARCH_SSE2
+        constexpr size_t charSize = sizeof(wchar_t);
+        constexpr size_t laneCount = sizeof(__m128i) / charSize;
+
+        auto broadcast = [](wchar_t ch)
+        {
+            if constexpr (charSize == 2) return _mm_set1_epi16((short)ch);
+            else return _mm_set1_epi32((int)ch);
+        };
+        auto compare = [](__m128i a, __m128i b)
+        {
+            if constexpr (charSize == 2) return _mm_cmpeq_epi16(a, b);
+            else return _mm_cmpeq_epi32(a, b);
+        };
+        auto headChar = m_options.matchCase ? m_pattern.front() : m_foldedPattern.front();
+        auto tailChar = m_options.matchCase ? m_pattern.back() : m_foldedPattern.back();
+
+        auto head1 = broadcast(headChar), head2 = broadcast((wchar_t)std::towupper(headChar));
+        auto tail1 = broadcast(tailChar), tail2 = broadcast((wchar_t)std::towupper(tailChar));
+
+        // In case-insensitive mode, an ASCII character can only be folded
+        // from its uppercase variant or a non-ASCII one (e.g. the Kelvin
+        // sign), so the filter also keeps all non-ASCII characters, and the
+        // pattern ending with non-ASCII characters falls back to scalar.
+        auto isFilterable = m_options.matchCase || (headChar < 0x80 && tailChar < 0x80);
+
+        auto asciiMask = broadcast((wchar_t)~0x7f);
+        auto zero = _mm_setzero_si128();
+
+        auto filter = [&](__m128i block, __m128i variant1, __m128i variant2)
+        {
+            auto mask = compare(block, variant1);
+            if (!m_options.matchCase)
+            {
+                auto nonAscii = _mm_andnot_si128(compare(_mm_and_si128(block, asciiMask), zero), _mm_set1_epi8(-1));
+                mask = _mm_or_si128(mask, _mm_or_si128(compare(block, variant2), nonAscii));
+            }
+            return mask;
+        };
+        for (; isFilterable && pos + laneCount <= last; pos += laneCount)
+        {
+            auto headBlock = _mm_loadu_si128((const __m128i*)(data + pos));
+            auto tailBlock = _mm_loadu_si128((const __m128i*)(data + pos + length - 1));
+
+            auto headMask = filter(headBlock, head1, head2);
+            auto tailMask = filter(tailBlock, tail1, tail2);
+
+            auto mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(headMask, tailMask));
+
+            while (mask != 0)
+            {
+                auto lane = (size_t)std::countr_zero(mask) / charSize;
+                if (verifyLiteral(data + pos + lane)) return pos + lane;
+
+                // Clears all bytes of the lane at once.
+                mask &= ~(((1u << charSize) - 1) << (lane * charSize));
+            }
+        }
+#endif
+        for (; pos < last; ++pos)
+        {
+            if (isCandidate(data[pos], 0) && isCandidate(data[pos + length - 1], length - 1) && verifyLiteral(data + pos))
+            {
+                return pos;
+            }
+        }
+        return WstringView::npos;
+    }
+
+    bool TextSearch::verifyLiteral(const wchar_t* str) const
+    {
+        auto length = m_pattern.size();
+
+        if (m_options.matchCase)
+        {
+            return std::wmemcmp(str, m_pattern.data(), length) == 0;
+        }
+        for (size_t i = 0; i < length; ++i)
+        {
+            if ((wchar_t)std::towlower(str[i]) != m_foldedPattern[i]) return false;
+        }
+        return true;
+    }
+
+    bool TextSearch::isWholeWord(WstrViewRefer text, const Match& match) const
+    {
+        if (!m_options.matchWholeWord) return true;
+
+        auto end = match.offset + match.count;
+
+        bool headBound = match.offset == 0 || !isWordCharacter(text[match.offset - 1]);
+        bool tailBound = end >= text.size() || !isWordCharacter(text[end]);
+
+        return headBound && tailBound;
+    }
+
+    bool TextSearch::isWordCharacter(wchar_t ch)
+    {
+        return std::iswalnum(ch) || ch == L'_';
+    }
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Searches a text buffer for a literal or regex pattern.
+    //
+    // The literal search filters the candidates with SSE2 by comparing
+    // the first and last characters of the pattern against 16 bytes of
+    // the text at a time, and only verifies the few remaining positions,
+    // thus scanning a multi-megabyte buffer takes a few milliseconds.
+    //
+    // In case-insensitive mode, two characters are considered equal if
+    // they are the same after being converted to lowercase (towlower).
+
+    struct TextSearchOptions
+    {
+        bool matchCase = true;
+        bool matchWholeWord = false;
+
+        // Uses the ECMAScript grammar of std::wregex.
+        bool useRegex = false;
+    };
+
+    struct TextSearch
+    {
+        using Options = TextSearchOptions;
+
+        struct Match
+        {
+            size_t offset, count;
+
+            bool operator==(const Match&) const = default;
+        };
+        using MatchArray = std::vector<Match>;
+
+        explicit TextSearch(WstrRefer pattern, const Options& options = {});
+
+    protected:
+        Wstring m_pattern = {};
+        Options m_options = {};
+
+        // The lowercase pattern for the case-insensitive search.
+        Wstring m_foldedPattern = {};
+
+        Optional<std::wregex> m_regex = {};
+
+        bool m_valid = true;
+
+    public:
+        const Wstring& pattern() const;
+        const Options& options() const;
+
+        // Returns false if the pattern is empty or an invalid regex.
+        bool valid() const;
+
+        // Returns the first match that starts within [from, text.size()).
+        Optional<Match> findNext(WstrViewRefer text, size_t from = 0) const;
+
+        // Returns the last match that starts within [0, before).
+        Optional<Match> findPrev(WstrViewRefer text, size_t before) const;
+
+        // Appends the matches that start within [first, last) to the array.
+        // A regex match never spans across the first line break after last,
+        // which keeps the chunked search of a huge buffer in linear time.
+        void findAll(WstrViewRefer text, size_t first, size_t last, MatchArray& matches) const;
+
+        MatchArray findAll(WstrViewRefer text) const;
+
+        // The replacement of a regex match may refer to the groups with $n.
+        // As in the chunked findAll, a regex match never spans across the
+        // first line break after each chunk of 64K characters.
+        Wstring replaceAll(WstrViewRefer text, WstrRefer replacement, size_t* replacedCount = nullptr) const;
+
+    protected:
+        // Calls back with each non-empty whole-word regex match that starts
+        // within [first, last), which must be a valid non-empty range.
+        void findRegex(WstrViewRefer text, size_t first, size_t last, FuncRefer<void(const std::wcmatch&, const Match&)> callback) const;
+
+        // Returns the first position within [from, last) that matches the
+        // literal pattern (ignoring the whole word option), or npos if none.
+        size_t findLiteral(WstrViewRefer text, size_t from, size_t last) const;
+
+        bool verifyLiteral(const wchar_t* str) const;
+
+        bool isWholeWord(WstrViewRefer text, const Match& match) const;
+
+        static bool isWordCharacter(wchar_t ch);
+    };
+}
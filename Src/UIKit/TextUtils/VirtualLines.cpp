@@ -0,0 +1,177 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/VirtualLines.h"
+
+namespace d14engine::uikit::text_utils
+{
+    VirtualLines::Measure& VirtualLines::Measure::operator+=(const Measure& rhs)
+    {
+        height += rhs.height;
+        count += rhs.count;
+        return *this;
+    }
+
+    VirtualLines::Measure& VirtualLines::Measure::operator-=(const Measure& rhs)
+    {
+        height -= rhs.height;
+        count -= rhs.count;
+        return *this;
+    }
+
+    VirtualLines::Measure VirtualLines::MeasureOf::operator()(const LineData& line) const
+    {
+        return line.measured ? Measure{ line.height, 1 } : Measure{};
+    }
+
+    void VirtualLines::reset(size_t lineCount)
+    {
+        m_lines.assign(lineCount, {});
+
+        m_maxMeasuredWidth = 0.0f;
+    }
+
+    void VirtualLines::replace(size_t first, size_t removed, size_t inserted)
+    {
+        first = std::min(first, m_lines.size());
+        removed = std::min(removed, m_lines.size() - first);
+
+        // Keeps the line count when possible, which does not move any line.
+        auto kept = std::min(removed, inserted);
+        for (auto line = first; line < first + kept; ++line)
+        {
+            invalidate(line);
+        }
+        m_lines.erase(first + kept, removed - kept);
+        m_lines.insert(first + kept, inserted - kept, {});
+    }
+
+    void VirtualLines::invalidate()
+    {
+        reset(m_lines.size());
+    }
+
+    void VirtualLines::invalidate(size_t line)
+    {
+        if (line < m_lines.size() && m_lines[line].measured)
+        {
+            m_lines.modify(line, [](LineData& data) { data.measured = false; });
+        }
+    }
+
+    size_t VirtualLines::lineCount() const
+    {
+        return m_lines.size();
+    }
+
+    bool VirtualLines::isMeasured(size_t line) const
+    {
+        return m_lines[line].measured;
+    }
+
+    void VirtualLines::setMeasuredExtent(size_t line, const Extent& extent)
+    {
+        m_lines.modify(line, [&](LineData& data)
+        {
+            data.height = extent.height;
+            data.width = extent.width;
+            data.measured = true;
+        });
+        m_maxMeasuredWidth = std::max(m_maxMeasuredWidth, extent.width);
+    }
+
+    float VirtualLines::estimatedLineHeight() const
+    {
+        if (setting.refineEstimation)
+        {
+            auto total = m_lines.total();
+            if (total.count > 0)
+            {
+                return (float)(total.height / (double)total.count);
+            }
+        }
+        return setting.initialLineHeight;
+    }
+
+    float VirtualLines::lineHeight(size_t line) const
+    {
+        auto& data = m_lines[line];
+        return data.measured ? data.height : estimatedLineHeight();
+    }
+
+    float VirtualLines::lineTop(size_t line) const
+    {
+        auto prefix = m_lines.prefix(line);
+        auto unmeasured = std::min(line, m_lines.size()) - prefix.count;
+
+        return (float)(prefix.height + (double)unmeasured * estimatedLineHeight());
+    }
+
+    float VirtualLines::totalHeight() const
+    {
+        auto total = m_lines.total();
+        auto unmeasured = m_lines.size() - total.count;
+
+        return (float)(total.height + (double)unmeasured * estimatedLineHeight());
+    }
+
+    float VirtualLines::maxMeasuredWidth() const
+    {
+        return m_maxMeasuredWidth;
+    }
+
+    size_t VirtualLines::lineAtOffset(float y) const
+    {
+        auto count = m_lines.size();
+        if (count == 0 || y <= 0.0f) return 0;
+
+        double estimated = estimatedLineHeight();
+
+        // Finds the number of lines whose bottom edges are not below y,
+        // which is exactly the target line.
+        auto bottomCount = m_lines.countWhile([&](const Measure& prefix, size_t n)
+        {
+            return prefix.height + (double)(n - prefix.count) * estimated <= y;
+        });
+        return std::min(bottomCount, count - 1);
+    }
+
+    VirtualLines::Range VirtualLines::visibleRange(float top, float height) const
+    {
+        auto count = m_lines.size();
+        if (count == 0) return { 0, 0 };
+
+        auto first = lineAtOffset(top);
+        auto last = lineAtOffset(top + height) + 1;
+
+        first = first > setting.overscan ? (first - setting.overscan) : 0;
+        last = std::min(last + setting.overscan, count);
+
+        return { first, last };
+    }
+
+    VirtualLines::Range VirtualLines::measureVisibleRange(float top, float height, Shaper shape)
+    {
+        // In most cases the range becomes stable after 1 or 2 passes,
+        // and the limit only prevents oscillation of pathological input.
+        constexpr int maxPassCount = 4;
+
+        auto range = visibleRange(top, height);
+
+        for (int pass = 0; pass < maxPassCount; ++pass)
+        {
+            bool isStable = true;
+            for (auto line = range.first; line < range.last; ++line)
+            {
+                if (!m_lines[line].measured)
+                {
+                    setMeasuredExtent(line, shape(line));
+                    isStable = false;
+                }
+            }
+            if (isStable) break;
+
+            range = visibleRange(top, height);
+        }
+        return range;
+    }
+}
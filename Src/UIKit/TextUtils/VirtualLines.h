@@ -0,0 +1,104 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/LineBlocks.h"
+
+namespace d14engine::uikit::text_utils
+{
+    // Tracks the geometry of a huge number of lines without shaping them
+    // all: the unmeasured lines take an estimated height, which is refined
+    // with the average of the measured ones, and only the lines that come
+    // into view are handed over to the shaper to get the actual extents.
+    //
+    // The measured heights and counts are summed up in LineBlocks, thus
+    // locating the line at a vertical offset and inserting/erasing lines
+    // take O(log n) (plus a block scan), and changing the estimated height
+    // takes O(1) since it is never stored per line.
+
+    struct VirtualLines
+    {
+        struct Extent { float width, height; };
+
+        // Half-open interval of line indices: [first, last).
+        struct Range { size_t first, last; };
+
+        struct Setting
+        {
+            // The height of an unmeasured line before any line is measured.
+            float initialLineHeight = 20.0f;
+
+            // Whether to estimate with the average of the measured heights.
+            bool refineEstimation = true;
+
+            // The extra lines beyond each edge of the viewport to be shaped.
+            size_t overscan = 8;
+        }
+        setting = {};
+
+    protected:
+        struct LineData
+        {
+            float height = 0.0f, width = 0.0f;
+
+            bool measured = false;
+        };
+        struct Measure
+        {
+            double height = 0.0;
+
+            size_t count = 0;
+
+            Measure& operator+=(const Measure& rhs);
+            Measure& operator-=(const Measure& rhs);
+        };
+        struct MeasureOf
+        {
+            Measure operator()(const LineData& line) const;
+        };
+        LineBlocks<LineData, Measure, MeasureOf> m_lines = {};
+
+        float m_maxMeasuredWidth = 0.0f;
+
+    public:
+        void reset(size_t lineCount);
+
+        // Called after the lines in [first, first + removed) are replaced
+        // by [first, first + inserted), and the new lines become unmeasured.
+        void replace(size_t first, size_t removed, size_t inserted);
+
+        // Marks all lines as unmeasured (e.g. the font or wrapping changed).
+        void invalidate();
+
+        void invalidate(size_t line);
+
+        size_t lineCount() const;
+
+        bool isMeasured(size_t line) const;
+
+        void setMeasuredExtent(size_t line, const Extent& extent);
+
+        float estimatedLineHeight() const;
+
+        float lineHeight(size_t line) const;
+
+        // Returns the vertical offset of the top edge of the line.
+        float lineTop(size_t line) const;
+
+        float totalHeight() const;
+
+        float maxMeasuredWidth() const;
+
+        // Returns the line that covers the vertical offset (clamped).
+        size_t lineAtOffset(float y) const;
+
+        // Returns the lines overlapped with [top, top + height) with overscan.
+        Range visibleRange(float top, float height) const;
+
+        using Shaper = FuncRefer<Extent(size_t line)>;
+
+        // Shapes the unmeasured lines in the visible range until the range
+        // becomes stable, since the measurement moves the subsequent lines.
+        Range measureVisibleRange(float top, float height, Shaper shape);
+    };
+}
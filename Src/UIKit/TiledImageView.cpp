@@ -0,0 +1,557 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TiledImageView.h"
+
+#include "Common/DirectXError.h"
+#include "Common/PixelUtils/MipChain.h"
+#include "Common/RuntimeError.h"
+
+#include "Renderer/GraphUtils/Bitmap.h"
+#include "Renderer/Renderer.h"
+
+#include "UIKit/Application.h"
+#include "UIKit/BitmapObject.h"
+#include "UIKit/BitmapUtils.h"
+#include "UIKit/PlatformUtils.h"
+#include "UIKit/ResourceUtils.h"
+
+using namespace d14engine::renderer;
+
+namespace d14engine::uikit
+{
+    namespace
+    {
+        ComPtr<IWICFormatConverter> openImageSource(WstrRefer imagePath, UINT& width, UINT& height)
+        {
+            auto factory = graph_utils::bitmap::factory();
+
+            // Only the header is parsed here, and the pixels are decoded
+            // lazily by the region passed to CopyPixels.
+            ComPtr<IWICBitmapDecoder> decoder = {};
+            THROW_IF_FAILED(factory->CreateDecoderFromFilename
+            (
+            /* wzFilename      */ imagePath.c_str(),
+            /* pguidVendor     */ nullptr,
+            /* dwDesiredAccess */ GENERIC_READ,
+            /* metadataOptions */ WICDecodeMetadataCacheOnDemand,
+            /* ppIDecoder      */ &decoder
+            ));
+            ComPtr<IWICBitmapFrameDecode> frameDecode = {};
+            THROW_IF_FAILED(decoder->GetFrame(0, &frameDecode));
+
+            THROW_IF_FAILED(frameDecode->GetSize(&width, &height));
+
+            ComPtr<IWICFormatConverter> formatConverter = {};
+            THROW_IF_FAILED(factory->CreateFormatConverter(&formatConverter));
+
+            THROW_IF_FAILED(formatConverter->Initialize
+            (
+            /* pISource              */ frameDecode.Get(),
+            /* dstFormat             */ GUID_WICPixelFormat32bppPRGBA,
+            /* dither                */ WICBitmapDitherTypeNone,
+            /* pIPalette             */ nullptr,
+            /* alphaThresholdPercent */ 0.0f,
+            /* paletteTranslate      */ WICBitmapPaletteTypeCustom
+            ));
+            return formatConverter;
+        }
+
+        // Each worker keeps the decoder of the last image, so the tiles do
+        // not reopen the file and parse the header again, and the codecs
+        // that decode from the top can go on from the last region instead
+        // of starting over for each tile.
+        IWICBitmapSource* workerImageSource(WstrRefer imagePath, UINT& width, UINT& height)
+        {
+            struct WorkerSource
+            {
+                Wstring imagePath = {};
+                ComPtr<IWICFormatConverter> source = {};
+
+                UINT width = {}, height = {};
+            };
+            // Destroyed before the COM scope of the worker.
+            thread_local WorkerSource worker = {};
+
+            if (worker.imagePath != imagePath || worker.source == nullptr)
+            {
+                worker = {};
+                worker.source = openImageSource(imagePath, worker.width, worker.height);
+                worker.imagePath = imagePath;
+            }
+            width = worker.width;
+            height = worker.height;
+
+            return worker.source.Get();
+        }
+    }
+
+    TiledImageView::TiledImageView(const D2D1_RECT_F& rect, uint32_t tileSize, size_t threadCount)
+        :
+        Panel(rect, resource_utils::solidColorBrush()),
+        ScrollView(makeUIObject<Panel>(), rect),
+        m_tileSize(tileSize),
+        m_decodeQueue(
+        [tileSize, coarseLevels = m_coarseLevels](const image_utils::DecodeQueue::Request& request)
+        {
+            return decodeTile(request, tileSize, *coarseLevels);
+        },
+        threadCount,
+        [this]
+        {
+            // Called in the worker threads.
+            auto app = Application::g_app;
+            if (app != nullptr)
+            {
+                app->triggerThreadEvent((Application::ThreadEventID)this);
+            }
+        })
+    {
+        THROW_IF_NULL(Application::g_app);
+
+        Application::g_app->registerThreadCallback(
+            (Application::ThreadEventID)this,
+            [this](Application::ThreadEventData data)
+        {
+            receiveTiles();
+        });
+    }
+
+    TiledImageView::~TiledImageView()
+    {
+        if (Application::g_app != nullptr)
+        {
+            Application::g_app->unregisterThreadCallback((Application::ThreadEventID)this);
+        }
+        m_decodeQueue.cancelAll();
+    }
+
+    void TiledImageView::onInitializeFinish()
+    {
+        ScrollView::onInitializeFinish();
+
+        m_content->f_onRendererDrawD2d1ObjectAfter = [this](Panel* p, Renderer* rndr)
+        {
+            drawTiles(rndr);
+        };
+    }
+
+    void TiledImageView::open(WstrRefer imagePath)
+    {
+        close();
+
+        // Only the header is parsed here, which is cheap for any size.
+        UINT imageWidth = {}, imageHeight = {};
+        openImageSource(imagePath, imageWidth, imageHeight);
+
+        m_imagePath = imagePath;
+        m_pyramid = image_utils::TilePyramid(imageWidth, imageHeight, m_tileSize);
+
+        if (m_pyramid.levelCount() == 0) return;
+
+        // Fits the whole image into the viewport at first.
+        auto fitZoom = std::min(width() / (float)imageWidth, height() / (float)imageHeight);
+        m_zoom = std::clamp(std::min(fitZoom, 1.0f), minimalZoom, maximalZoom);
+
+        m_content->setSize((float)imageWidth * m_zoom, (float)imageHeight * m_zoom);
+
+        m_viewportOffset = { 0.0f, 0.0f };
+        ScrollView::onViewportOffsetChangeHelper(m_viewportOffset);
+
+        updateTiles();
+    }
+
+    void TiledImageView::close()
+    {
+        // The tiles being decoded are discarded when they are finished.
+        m_decodeQueue.cancelAll();
+        m_pendingTiles.clear();
+
+        m_tileCache.clear();
+
+        // Skipped if a worker is building the levels, which are replaced
+        // anyway when the next image is opened.
+        std::unique_lock lock(m_coarseLevels->mutex, std::try_to_lock);
+        if (lock.owns_lock()) m_coarseLevels->release();
+        m_imagePath.clear();
+        m_pyramid = {};
+
+        if (m_content) m_content->setSize(0.0f, 0.0f);
+    }
+
+    const Wstring& TiledImageView::imagePath() const
+    {
+        return m_imagePath;
+    }
+
+    const image_utils::TilePyramid& TiledImageView::pyramid() const
+    {
+        return m_pyramid;
+    }
+
+    size_t TiledImageView::cacheBudget() const
+    {
+        return m_tileCache.budget();
+    }
+
+    void TiledImageView::setCacheBudget(size_t bytes)
+    {
+        m_tileCache.setBudget(bytes);
+
+        updateTiles();
+    }
+
+    float TiledImageView::zoom() const
+    {
+        return m_zoom;
+    }
+
+    void TiledImageView::setZoom(float zoom, Optional<D2D1_POINT_2F> anchor)
+    {
+        zoom = std::clamp(zoom, minimalZoom, maximalZoom);
+
+        if (m_pyramid.levelCount() == 0)
+        {
+            m_zoom = zoom; return;
+        }
+        auto point = anchor.value_or(D2D1_POINT_2F{ width() * 0.5f, height() * 0.5f });
+
+        // The point of the image under the anchor.
+        auto imageX = (m_viewportOffset.x + point.x) / m_zoom;
+        auto imageY = (m_viewportOffset.y + point.y) / m_zoom;
+
+        m_zoom = zoom;
+
+        auto& imageSize = m_pyramid.imageSize();
+        m_content->setSize((float)imageSize.width * m_zoom, (float)imageSize.height * m_zoom);
+
+        setViewportOffset({ imageX * m_zoom - point.x, imageY * m_zoom - point.y });
+
+        // The offset may stay the same while the level changes.
+        updateTiles();
+    }
+
+    image_utils::TilePyramid::Area TiledImageView::visibleArea() const
+    {
+        return
+        {
+            m_viewportOffset.x / m_zoom,
+            m_viewportOffset.y / m_zoom,
+            (m_viewportOffset.x + width()) / m_zoom,
+            (m_viewportOffset.y + height()) / m_zoom
+        };
+    }
+
+    void TiledImageView::updateTiles()
+    {
+        if (m_pyramid.levelCount() == 0) return;
+
+        // Selects the level with the physical pixels instead of the DIPs.
+        auto scale = m_zoom * platform_utils::dpi() / 96.0f;
+
+        auto requests = tileScheduler.plan(m_pyramid, visibleArea(), scale);
+
+        decltype(m_pendingTiles) pendingTiles = {};
+
+        for (auto& request : requests)
+        {
+            if (m_tileCache.contains(request.key)) continue;
+
+            auto key = request.key.packed();
+
+            auto itor = m_pendingTiles.find(key);
+            if (itor != m_pendingTiles.end())
+            {
+                // Fails silently if the tile is being decoded already.
+                m_decodeQueue.setPriority(itor->second, request.priority);
+
+                pendingTiles.insert(*itor);
+                m_pendingTiles.erase(itor);
+            }
+            else pendingTiles[key] = m_decodeQueue.submit({ m_imagePath, key }, request.priority);
+        }
+        // The remaining tiles have scrolled away or belong to another level.
+        for (auto& tile : m_pendingTiles)
+        {
+            m_decodeQueue.cancel(tile.second);
+        }
+        m_pendingTiles = std::move(pendingTiles);
+    }
+
+    image_utils::DecodeQueue::Image TiledImageView::decodeTile(
+        const image_utils::DecodeQueue::Request& request,
+        uint32_t tileSize,
+        CoarseLevels& coarseLevels)
+    {
+        graph_utils::bitmap::initializeWorkerThread();
+
+        UINT imageWidth = {}, imageHeight = {};
+        auto source = workerImageSource(request.path, imageWidth, imageHeight);
+
+        image_utils::TilePyramid pyramid(imageWidth, imageHeight, tileSize);
+
+        auto key = image_utils::TileKey::unpack(request.region);
+        THROW_IF_FALSE(pyramid.contains(key));
+
+        auto rect = pyramid.tileRect(key);
+
+        image_utils::DecodeQueue::Image image =
+        {
+            .width = rect.right - rect.left,
+            .height = rect.bottom - rect.top
+        };
+        auto pitch = 4 * image.width;
+        image.pixels.resize((size_t)pitch * image.height);
+
+        if (key.level == 0)
+        {
+            WICRect rc =
+            {
+                (INT)rect.left, (INT)rect.top, (INT)image.width, (INT)image.height
+            };
+            THROW_IF_FAILED(source->CopyPixels
+            (
+            /* prc          */ &rc,
+            /* cbStride     */ pitch,
+            /* cbBufferSize */ (UINT)image.pixels.size(),
+            /* pbBuffer     */ image.pixels.data()
+            ));
+            return image;
+        }
+        // The other workers that need a coarse tile wait for the first one
+        // to build the levels, while the level 0 tiles go on in parallel.
+        std::lock_guard lock(coarseLevels.mutex);
+
+        if (coarseLevels.imagePath != request.path ||
+            coarseLevels.offsets.size() + 1 != pyramid.levelCount())
+        {
+            // Releases the levels of the previous image before building.
+            coarseLevels.release();
+
+            buildCoarseLevels(source, pyramid, coarseLevels);
+            coarseLevels.imagePath = request.path;
+        }
+        auto level = coarseLevels.level(pyramid, key.level);
+
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            std::copy_n(level.row(rect.top + y) + (size_t)rect.left * 4,
+                        pitch, image.pixels.data() + (size_t)y * pitch);
+        }
+        return image;
+    }
+
+    TiledImageView::CoarseLevels::~CoarseLevels()
+    {
+        release();
+    }
+
+    pixel_utils::ImageView TiledImageView::CoarseLevels::level(
+        const image_utils::TilePyramid& pyramid, uint32_t index) const
+    {
+        auto size = pyramid.levelSize(index);
+        return { file.data() + offsets[index - 1], size.width, size.height, (size_t)size.width * 4 };
+    }
+
+    void TiledImageView::CoarseLevels::release()
+    {
+        imagePath.clear();
+        offsets.clear();
+
+        file.close();
+        if (!filePath.empty())
+        {
+            std::error_code error = {};
+            std::filesystem::remove(filePath, error);
+
+            filePath.clear();
+        }
+    }
+
+    void TiledImageView::buildCoarseLevels(
+        IWICBitmapSource* source,
+        const image_utils::TilePyramid& pyramid,
+        CoarseLevels& coarseLevels)
+    {
+        if (pyramid.levelCount() <= 1) return;
+
+        uint64_t fileSize = 0;
+        for (uint32_t level = 1; level < pyramid.levelCount(); ++level)
+        {
+            coarseLevels.offsets.push_back(fileSize);
+
+            auto levelSize = pyramid.levelSize(level);
+            fileSize += (uint64_t)levelSize.width * levelSize.height * 4;
+        }
+        coarseLevels.filePath = std::filesystem::temp_directory_path() /
+        (
+            L"D14CoarseTiles-" + std::to_wstring(GetCurrentProcessId()) +
+            L"-" + std::to_wstring((uintptr_t)&coarseLevels) + L".tmp"
+        );
+        auto& file = coarseLevels.file;
+        if (!file.open(coarseLevels.filePath, MappedFile::Mode::ReadWrite) || !file.resize(fileSize))
+        {
+            coarseLevels.release();
+            THROW_ERROR(L"Failed to create the file of the coarse tile levels.");
+        }
+        // Each level is built in strips of an even row count from the level
+        // below, so that only one strip of the finer level is held at a time,
+        // and the built pages are written back to the file by the system.
+        constexpr UINT stripHeight = 64;
+
+        auto writeHalf = [&](const pixel_utils::ImageView& strip, uint32_t level, uint32_t top)
+        {
+            auto half = pixel_utils::halveRoundingUp(strip);
+
+            auto destination = file.data() + coarseLevels.offsets[level - 1];
+            std::copy(half.pixels.begin(), half.pixels.end(), destination + (size_t)(top / 2) * half.pitch());
+        };
+        // Level 0 is decoded from the file.
+        auto& imageSize = pyramid.imageSize();
+        pixel_utils::Image strip(imageSize.width, stripHeight);
+
+        for (UINT top = 0; top < imageSize.height; top += stripHeight)
+        {
+            auto rowCount = std::min(stripHeight, imageSize.height - top);
+
+            WICRect rc = { 0, (INT)top, (INT)imageSize.width, (INT)rowCount };
+            THROW_IF_FAILED(source->CopyPixels
+            (
+            /* prc          */ &rc,
+            /* cbStride     */ (UINT)strip.pitch(),
+            /* cbBufferSize */ (UINT)(strip.pitch() * rowCount),
+            /* pbBuffer     */ strip.pixels.data()
+            ));
+            writeHalf({ strip.pixels.data(), imageSize.width, rowCount, strip.pitch() }, 1, top);
+        }
+        for (uint32_t level = 2; level < pyramid.levelCount(); ++level)
+        {
+            auto finer = coarseLevels.level(pyramid, level - 1);
+
+            for (uint32_t top = 0; top < finer.height; top += stripHeight)
+            {
+                auto rowCount = std::min((uint32_t)stripHeight, finer.height - top);
+                writeHalf({ finer.row(top), finer.width, rowCount, finer.pitch }, level, top);
+            }
+        }
+    }
+
+    void TiledImageView::receiveTiles()
+    {
+        for (auto& result : m_decodeQueue.takeResults())
+        {
+            auto itor = m_pendingTiles.find(result.request.region);
+            if (itor == m_pendingTiles.end() || itor->second != result.ticket) continue;
+
+            m_pendingTiles.erase(itor);
+
+            auto key = image_utils::TileKey::unpack(result.request.region);
+
+            // A failed tile is cached as nullptr so that it is not requested
+            // again and again, and the coarser tile is drawn in its place.
+            if (result.image.has_value())
+            {
+                auto& image = result.image.value();
+                auto bitmap = bitmap_utils::loadBitmap(image.width, image.height, image.pixels.data());
+
+                m_tileCache.insert(key, bitmap, image.pixels.size());
+            }
+            else m_tileCache.insert(key, nullptr, 0);
+
+            // The finer tile replaces the coarser one drawn in its place.
+            invalidate();
+        }
+    }
+
+    void TiledImageView::drawTiles(Renderer* rndr)
+    {
+        if (m_pyramid.levelCount() == 0) return;
+
+        auto recorder = rndr->recorder2D();
+
+        auto& contentRect = m_content->absoluteRect();
+
+        auto scale = m_zoom * platform_utils::dpi() / 96.0f;
+        auto level = m_pyramid.levelForScale(scale);
+
+        auto range = m_pyramid.tilesInArea(level, visibleArea());
+
+        auto interpolationMode = BitmapObject::g_interpolationMode;
+
+        for (auto y = range.top; y < range.bottom; ++y)
+        {
+            for (auto x = range.left; x < range.right; ++x)
+            {
+                image_utils::TileKey key = { level, x, y };
+                auto target = m_pyramid.sourceRect(key);
+
+                // Falls back to the nearest coarser tile that is cached.
+                Optional<image_utils::TileKey> tileKey = key;
+                ID2D1Bitmap1* bitmap = nullptr;
+
+                for (; tileKey.has_value(); tileKey = m_pyramid.parent(tileKey.value()))
+                {
+                    auto tile = m_tileCache.find(tileKey.value());
+                    if (tile != nullptr && *tile)
+                    {
+                        bitmap = tile->Get(); break;
+                    }
+                }
+                if (bitmap == nullptr) continue;
+
+                // The part of the (coarser) tile that covers the target.
+                auto source = m_pyramid.sourceRect(tileKey.value());
+                auto pixelSize = bitmap->GetPixelSize();
+
+                auto ratioX = (float)pixelSize.width / (float)(source.right - source.left);
+                auto ratioY = (float)pixelSize.height / (float)(source.bottom - source.top);
+
+                D2D1_RECT_F sourceRect =
+                {
+                    (float)(target.left - source.left) * ratioX,
+                    (float)(target.top - source.top) * ratioY,
+                    (float)(target.right - source.left) * ratioX,
+                    (float)(target.bottom - source.top) * ratioY
+                };
+                D2D1_RECT_F destinationRect =
+                {
+                    contentRect.left + (float)target.left * m_zoom,
+                    contentRect.top + (float)target.top * m_zoom,
+                    contentRect.left + (float)target.right * m_zoom,
+                    contentRect.top + (float)target.bottom * m_zoom
+                };
+                recorder->DrawBitmap
+                (
+                /* bitmap               */ bitmap,
+                /* destinationRectangle */ destinationRect,
+                /* opacity              */ 1.0f,
+                /* interpolationMode    */ interpolationMode,
+                /* sourceRectangle      */ &sourceRect
+                );
+            }
+        }
+    }
+
+    void TiledImageView::onSizeHelper(SizeEvent& e)
+    {
+        ScrollView::onSizeHelper(e);
+
+        updateTiles();
+    }
+
+    void TiledImageView::onMouseWheelHelper(MouseWheelEvent& e)
+    {
+        if (e.keyState.CTRL)
+        {
+            auto anchor = absoluteToSelfCoord(e.cursorPoint);
+            setZoom(m_zoom * std::pow(1.25f, (float)e.deltaCount), anchor);
+        }
+        else ScrollView::onMouseWheelHelper(e);
+    }
+
+    void TiledImageView::onViewportOffsetChangeHelper(const D2D1_POINT_2F& offset)
+    {
+        ScrollView::onViewportOffsetChangeHelper(offset);
+
+        updateTiles();
+    }
+}
@@ -0,0 +1,144 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "Common/MappedFile.h"
+#include "Common/PixelUtils/Image.h"
+
+#include "UIKit/ImageUtils/DecodeQueue.h"
+#include "UIKit/ImageUtils/TileCache.h"
+#include "UIKit/ImageUtils/TilePyramid.h"
+#include "UIKit/ImageUtils/TileScheduler.h"
+#include "UIKit/ScrollView.h"
+
+namespace d14engine::uikit
+{
+    // Displays a very large image (e.g. a 30k x 30k scan that exceeds the
+    // texture size limit) as a pyramid of fixed-size tiles: only the tiles
+    // overlapped with the viewport are decoded (in the worker threads) at
+    // the level that matches the zoom, and the recently used ones are kept
+    // in a cache under the memory budget.
+    //
+    // A tile that is not ready yet is drawn with the best coarser tile in
+    // the cache, and the tiles around the viewport are prefetched.
+    //
+    // Hold CTRL and scroll the mouse wheel to zoom around the cursor.
+
+    struct TiledImageView : ScrollView
+    {
+        TiledImageView(
+            const D2D1_RECT_F& rect = {},
+            uint32_t tileSize = 256,
+            size_t threadCount = 2);
+
+        virtual ~TiledImageView();
+
+        void onInitializeFinish() override;
+
+    protected:
+        Wstring m_imagePath = {};
+
+        const uint32_t m_tileSize = {};
+
+        image_utils::TilePyramid m_pyramid = {};
+
+        image_utils::TileCache<ComPtr<ID2D1Bitmap1>> m_tileCache = {};
+
+        // Most codecs can only produce a scaled image by decoding the whole,
+        // so the levels after level 0 are built once in a single pass over
+        // the image (each one halved from the level below strip by strip)
+        // and shared by the workers. They take about a third of the full
+        // image, so they are spilled to a temporary mapped file instead of
+        // the memory, and only the strips being built and the coarse tiles
+        // in the cache (under its budget) are held in the memory.
+        struct CoarseLevels
+        {
+            ~CoarseLevels();
+
+            std::mutex mutex = {};
+
+            Wstring imagePath = {};
+
+            std::filesystem::path filePath = {};
+            MappedFile file = {};
+
+            // The tightly packed levels one after another in the file, where
+            // offsets[i] is the byte offset of the level (i + 1).
+            std::vector<uint64_t> offsets = {};
+
+            pixel_utils::ImageView level(const image_utils::TilePyramid& pyramid, uint32_t index) const;
+
+            // Closes and removes the file.
+            void release();
+        };
+        SharedPtr<CoarseLevels> m_coarseLevels = std::make_shared<CoarseLevels>();
+
+        image_utils::DecodeQueue m_decodeQueue;
+
+        // Maps the packed tile keys to the tickets of the decode queue.
+        std::unordered_map<uint64_t, image_utils::DecodeQueue::Ticket> m_pendingTiles = {};
+
+        // The image is drawn in (zoom * image pixels) DIPs.
+        float m_zoom = 1.0f;
+
+    public:
+        image_utils::TileScheduler tileScheduler = {};
+
+        // Only reads the size of the image, and the tiles come later.
+        void open(WstrRefer imagePath);
+
+        // Releases all tiles and cancels the pending ones.
+        void close();
+
+        const Wstring& imagePath() const;
+
+        const image_utils::TilePyramid& pyramid() const;
+
+        size_t cacheBudget() const;
+        void setCacheBudget(size_t bytes);
+
+        float minimalZoom = 1.0f / 1024.0f;
+        float maximalZoom = 16.0f;
+
+        float zoom() const;
+
+        // The anchor (relative to the viewport) stays at the same point of
+        // the image, which defaults to the center of the viewport.
+        void setZoom(float zoom, Optional<D2D1_POINT_2F> anchor = std::nullopt);
+
+    protected:
+        // The viewport in the image space.
+        image_utils::TilePyramid::Area visibleArea() const;
+
+        // Submits the planned tiles that are neither cached nor pending,
+        // re-prioritizes the pending ones and cancels the unplanned ones.
+        void updateTiles();
+
+        // Level 0 tiles are decoded from the file region by region with the
+        // decoder kept by each worker, and the coarser tiles are copied from
+        // the levels (built at the first one).
+        static image_utils::DecodeQueue::Image decodeTile(
+            const image_utils::DecodeQueue::Request& request,
+            uint32_t tileSize,
+            CoarseLevels& coarseLevels);
+
+        static void buildCoarseLevels(
+            IWICBitmapSource* source,
+            const image_utils::TilePyramid& pyramid,
+            CoarseLevels& coarseLevels);
+
+        // Called in the UI thread when some tiles are decoded.
+        void receiveTiles();
+
+        void drawTiles(renderer::Renderer* rndr);
+
+    protected:
+        // Panel
+        void onSizeHelper(SizeEvent& e) override;
+
+        void onMouseWheelHelper(MouseWheelEvent& e) override;
+
+        // ScrollView
+        void onViewportOffsetChangeHelper(const D2D1_POINT_2F& offset) override;
+    };
+}
@@ -31,6 +31,8 @@ namespace d14engine::uikit
 
     void ToggleButton::setActivated(StatefulObject::State::ActiveFlag flag)
     {
+        if (StatefulObject::m_state.activeFlag != flag) invalidate();
+
         StatefulObject::m_state.activeFlag = flag;
 
         StatefulObject::Event soe = {};
@@ -45,6 +47,8 @@ namespace d14engine::uikit
 
     void ToggleButton::setActivatedState(StatefulObject::State::ActiveFlag flag)
     {
+        if (StatefulObject::m_state.activeFlag != flag) invalidate();
+
         StatefulObject::m_state.activeFlag = flag;
         StatefulObject::m_stateDetail.flag = StatefulObject::m_state.activeFlag;
     }
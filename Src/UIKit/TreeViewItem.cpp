@@ -439,6 +439,8 @@ namespace d14engine::uikit
 
     void TreeViewItem::setFolded(StatefulObject::State::Flag flag)
     {
+        if (StatefulObject::m_state.flag != flag) invalidate();
+
         StatefulObject::m_state.flag = flag;
 
         StatefulObject::Event soe = {};
@@ -472,7 +474,7 @@ namespace d14engine::uikit
             auto offset = m_nodeLevel * m_parentView.lock()->horzIndentEachNodelLevel();
             auto arrowLeftTop = math_utils::offset(absolutePosition(), { offset, 0.0f });
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(arrowLeftTop, arrowGeometry.line0.point0),
             /* point1      */ math_utils::offset(arrowLeftTop, arrowGeometry.line0.point1),
@@ -480,7 +482,7 @@ namespace d14engine::uikit
             /* strokeWidth */ arrowSetting.strokeWidth, arrowIcon.strokeStyle.Get()
             );
 
-            rndr->d2d1DeviceContext()->DrawLine
+            rndr->recorder2D()->DrawLine
             (
             /* point0      */ math_utils::offset(arrowLeftTop, arrowGeometry.line1.point0),
             /* point1      */ math_utils::offset(arrowLeftTop, arrowGeometry.line1.point1),
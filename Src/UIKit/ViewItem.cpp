@@ -127,34 +127,41 @@ namespace d14engine::uikit
 
 #undef TARGET_STATE
 
+    void ViewItem::setState(State value)
+    {
+        if (state != value) invalidate();
+
+        state = value;
+    }
+
     void ViewItem::triggerEnterStateTrans()
     {
-        state = ENTER_STATE_TRANS_MAP[(size_t)state];
+        setState(ENTER_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::triggerLeaveStateTrans()
     {
-        state = LEAVE_STATE_TRANS_MAP[(size_t)state];
+        setState(LEAVE_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::triggerCheckStateTrans()
     {
-        state = CHECK_STATE_TRANS_MAP[(size_t)state];
+        setState(CHECK_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::triggerUnchkStateTrans()
     {
-        state = UNCHK_STATE_TRANS_MAP[(size_t)state];
+        setState(UNCHK_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::triggerGetfcStateTrans()
     {
-        state = GETFC_STATE_TRANS_MAP[(size_t)state];
+        setState(GETFC_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::triggerLosfcStateTrans()
     {
-        state = LOSFC_STATE_TRANS_MAP[(size_t)state];
+        setState(LOSFC_STATE_TRANS_MAP[(size_t)state]);
     }
 
     void ViewItem::setEnabled(bool value)
@@ -191,11 +198,11 @@ namespace d14engine::uikit
             (
                 -m_absoluteRect.left, -m_absoluteRect.top
             );
-            mask.beginDraw(rndr->d2d1DeviceContext(), maskDrawTrans);
+            mask.beginDraw(rndr->recorder2D(), maskDrawTrans);
             {
                 m_content->onRendererDrawD2d1Object(rndr);
             }
-            mask.endDraw(rndr->d2d1DeviceContext());
+            mask.endDraw(rndr->recorder2D());
         }
     }
 
@@ -222,7 +229,7 @@ namespace d14engine::uikit
         {
             auto& mask = drawBufferRes.mask;
 
-            rndr->d2d1DeviceContext()->DrawBitmap
+            rndr->recorder2D()->DrawBitmap
             (
             /* bitmap               */ mask.data.Get(),
             /* destinationRectangle */ m_absoluteRect,
@@ -242,7 +249,7 @@ namespace d14engine::uikit
             auto rect = math_utils::inner(m_absoluteRect, stroke.width);
             D2D1_ROUNDED_RECT roundedRect = { rect, roundRadiusX, roundRadiusY };
 
-            rndr->d2d1DeviceContext()->DrawRoundedRectangle
+            rndr->recorder2D()->DrawRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush(),
@@ -82,6 +82,9 @@ namespace d14engine::uikit
             GETFC_STATE_TRANS_MAP,
             LOSFC_STATE_TRANS_MAP;
 
+        // Invalidates the item if the state changes.
+        void setState(State value);
+
         void triggerEnterStateTrans();
         void triggerLeaveStateTrans();
         void triggerCheckStateTrans();
@@ -0,0 +1,423 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/VirtualTextEditor.h"
+
+#include "Common/DirectXError.h"
+
+#include "Renderer/Renderer.h"
+
+#include "UIKit/Application.h"
+#include "UIKit/Label.h"
+#include "UIKit/ResourceUtils.h"
+
+using namespace d14engine::renderer;
+
+namespace d14engine::uikit
+{
+    VirtualTextEditor::VirtualTextEditor(const D2D1_RECT_F& rect)
+        :
+        Panel(rect, resource_utils::solidColorBrush()),
+        ScrollView(makeUIObject<Panel>(), rect),
+        m_textFormat(D14_FONT(Label::defaultTextFormatName))
+    {
+        // Here left blank intentionally.
+    }
+
+    void VirtualTextEditor::onInitializeFinish()
+    {
+        ScrollView::onInitializeFinish();
+
+        m_content->f_onRendererDrawD2d1ObjectAfter = [this](Panel* p, Renderer* rndr)
+        {
+            drawVisibleLines(rndr);
+        };
+        m_lineIndex.build(m_text);
+        m_virtualLines.reset(m_lineIndex.lineCount());
+
+        updateVisibleLines();
+    }
+
+    const Wstring& VirtualTextEditor::text() const
+    {
+        return m_text;
+    }
+
+    void VirtualTextEditor::setText(WstrRefer text)
+    {
+        m_text = text;
+
+        m_lineIndex.build(m_text);
+        m_virtualLines.reset(m_lineIndex.lineCount());
+
+        m_lineLayouts.clear();
+
+        if (m_syntaxHighlighter)
+        {
+            m_syntaxHighlighter->reset(m_lineIndex.lineCount());
+        }
+        m_viewportOffset = { 0.0f, 0.0f };
+        ScrollView::onViewportOffsetChangeHelper(m_viewportOffset);
+
+        updateVisibleLines();
+
+        invalidateLines();
+    }
+
+    void VirtualTextEditor::insertText(WstrRefer fragment, size_t offset)
+    {
+        if (fragment.empty()) return;
+
+        offset = std::min(offset, m_text.size());
+        m_text.insert(offset, fragment);
+
+        onLinesChange(m_lineIndex.onInsert(offset, fragment));
+
+        invalidateLines();
+    }
+
+    void VirtualTextEditor::appendText(WstrRefer fragment)
+    {
+        insertText(fragment, m_text.size());
+    }
+
+    void VirtualTextEditor::eraseText(size_t offset, size_t count)
+    {
+        if (offset >= m_text.size() || count == 0) return;
+
+        count = std::min(count, m_text.size() - offset);
+        auto change = m_lineIndex.onErase(offset, WstringView(m_text).substr(offset, count));
+
+        m_text.erase(offset, count);
+
+        onLinesChange(change);
+
+        invalidateLines();
+    }
+
+    const text_utils::LineIndex& VirtualTextEditor::lineIndex() const
+    {
+        return m_lineIndex;
+    }
+
+    text_utils::VirtualLines& VirtualTextEditor::virtualLines()
+    {
+        return m_virtualLines;
+    }
+
+    const SharedPtr<text_utils::SyntaxHighlighter>& VirtualTextEditor::syntaxHighlighter() const
+    {
+        return m_syntaxHighlighter;
+    }
+
+    void VirtualTextEditor::setSyntaxLexer(ShrdPtrRefer<text_utils::SyntaxLexer> lexer)
+    {
+        if (lexer)
+        {
+            THROW_IF_NULL(Application::g_app);
+
+            auto context = Application::g_app->renderer()->d2d1DeviceContext();
+
+            for (size_t i = 0; i < m_syntaxBrushes.size(); ++i)
+            {
+                if (!m_syntaxBrushes[i])
+                {
+                    auto& style = syntaxStyles[i];
+                    THROW_IF_FAILED(context->CreateSolidColorBrush(style.color, &m_syntaxBrushes[i]));
+                }
+            }
+            m_syntaxHighlighter = std::make_shared<text_utils::SyntaxHighlighter>(lexer);
+            m_syntaxHighlighter->reset(m_lineIndex.lineCount());
+        }
+        else m_syntaxHighlighter.reset();
+
+        // The drawing effects of the cached layouts are out of date.
+        m_lineLayouts.clear();
+
+        updateVisibleLines();
+    }
+
+    void VirtualTextEditor::updateSyntaxHighlighting(size_t lineLimit)
+    {
+        if (!m_syntaxHighlighter) return;
+
+        auto changes = m_syntaxHighlighter->update(lineLimit, [this](size_t line)
+        {
+            return lineText(line);
+        });
+        bool restyled = false;
+        for (auto& change : changes)
+        {
+            auto layoutItor = m_lineLayouts.find(change.line);
+            if (layoutItor != m_lineLayouts.end())
+            {
+                applySyntaxStyles(layoutItor->second.Get(), change.line, change.span);
+                restyled = true;
+            }
+        }
+        if (restyled) invalidateLines();
+    }
+
+    void VirtualTextEditor::applySyntaxStyles(
+        IDWriteTextLayout* textLayout, size_t line,
+        const text_utils::SyntaxHighlighter::Span& span)
+    {
+        auto length = lineText(line).size();
+
+        auto spanBegin = std::min(span.offset, length);
+        auto spanEnd = std::min(span.offset + span.count, length);
+
+        if (spanBegin >= spanEnd) return;
+
+        DWRITE_TEXT_RANGE range = { (UINT32)spanBegin, (UINT32)(spanEnd - spanBegin) };
+        THROW_IF_FAILED(textLayout->SetDrawingEffect(nullptr, range));
+
+        for (auto& token : m_syntaxHighlighter->tokens(line))
+        {
+            auto tokenBegin = std::max(token.offset, spanBegin);
+            auto tokenEnd = std::min(token.offset + token.count, spanEnd);
+
+            if (tokenBegin >= tokenEnd || token.kind == text_utils::SyntaxKind::Plain) continue;
+
+            range = { (UINT32)tokenBegin, (UINT32)(tokenEnd - tokenBegin) };
+            THROW_IF_FAILED(textLayout->SetDrawingEffect(m_syntaxBrushes[(size_t)token.kind].Get(), range));
+        }
+    }
+
+    IDWriteTextFormat* VirtualTextEditor::textFormat() const
+    {
+        return m_textFormat.Get();
+    }
+
+    void VirtualTextEditor::setTextFormat(IDWriteTextFormat* textFormat)
+    {
+        m_textFormat = textFormat;
+
+        // All lines must be re-shaped with the new format.
+        m_virtualLines.invalidate();
+        m_lineLayouts.clear();
+
+        updateVisibleLines();
+
+        invalidateLines();
+    }
+
+    WstringView VirtualTextEditor::lineText(size_t line) const
+    {
+        auto range = m_lineIndex.lineRange(line);
+
+        if (range.count > 0 && m_text[range.offset + range.count - 1] == L'\r')
+        {
+            --range.count;
+        }
+        return WstringView(m_text).substr(range.offset, range.count);
+    }
+
+    ComPtr<IDWriteTextLayout> VirtualTextEditor::createLineLayout(size_t line)
+    {
+        THROW_IF_NULL(Application::g_app);
+
+        auto text = lineText(line);
+
+        ComPtr<IDWriteTextLayout> textLayout = {};
+
+        THROW_IF_FAILED(Application::g_app->renderer()->dwriteFactory()->CreateTextLayout
+        (
+        /* string       */ text.data(),
+        /* stringLength */ (UINT32)text.size(),
+        /* textFormat   */ m_textFormat.Get(),
+        /* maxWidth     */ 0.0f,
+        /* maxHeight    */ 0.0f,
+        /* textLayout   */ &textLayout)
+        );
+        THROW_IF_FAILED(textLayout->SetIncrementalTabStop(4.0f * 96.0f / 72.0f));
+        THROW_IF_FAILED(textLayout->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_LEADING));
+        THROW_IF_FAILED(textLayout->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR));
+        THROW_IF_FAILED(textLayout->SetWordWrapping(DWRITE_WORD_WRAPPING_NO_WRAP));
+
+        if (m_syntaxHighlighter)
+        {
+            updateSyntaxHighlighting(line + 1);
+            applySyntaxStyles(textLayout.Get(), line, { 0, text.size() });
+        }
+        return textLayout;
+    }
+
+    void VirtualTextEditor::onLinesChange(const text_utils::LineIndex::Change& change)
+    {
+        m_virtualLines.replace(change.first, change.removed, change.inserted);
+
+        if (m_syntaxHighlighter)
+        {
+            m_syntaxHighlighter->replace(change.first, change.removed, change.inserted);
+        }
+
+        // Drops the layouts of the replaced lines and shifts the others.
+        decltype(m_lineLayouts) lineLayouts = {};
+
+        for (auto& layout : m_lineLayouts)
+        {
+            if (layout.first < change.first)
+            {
+                lineLayouts.insert(std::move(layout));
+            }
+            else if (layout.first >= change.first + change.removed)
+            {
+                auto line = layout.first - change.removed + change.inserted;
+                lineLayouts.emplace(line, std::move(layout.second));
+            }
+        }
+        m_lineLayouts = std::move(lineLayouts);
+
+        updateVisibleLines();
+    }
+
+    const text_utils::VirtualLines::Range& VirtualTextEditor::visibleLines() const
+    {
+        return m_visibleLines;
+    }
+
+    void VirtualTextEditor::updateVisibleLines()
+    {
+        if (!m_content || !m_textFormat) return;
+
+        auto shape = [this](size_t line)
+        {
+            auto textLayout = createLineLayout(line);
+
+            DWRITE_TEXT_METRICS metrics = {};
+            THROW_IF_FAILED(textLayout->GetMetrics(&metrics));
+
+            m_lineLayouts[line] = textLayout;
+
+            return text_utils::VirtualLines::Extent
+            {
+                metrics.widthIncludingTrailingWhitespace, metrics.height
+            };
+        };
+        // Keeps the line at the top edge of the viewport in place,
+        // otherwise the refinement of the estimation makes it jump.
+        auto anchorLine = m_virtualLines.lineAtOffset(m_viewportOffset.y);
+        auto anchorDelta = m_viewportOffset.y - m_virtualLines.lineTop(anchorLine);
+
+        m_virtualLines.measureVisibleRange(m_viewportOffset.y, height(), shape);
+
+        m_content->setSize
+        (
+            std::max(m_virtualLines.maxMeasuredWidth(), width()),
+            m_virtualLines.totalHeight()
+        );
+        auto anchoredOffset = validateViewportOffset(
+        {
+            m_viewportOffset.x, m_virtualLines.lineTop(anchorLine) + anchorDelta
+        });
+        if (anchoredOffset.y != m_viewportOffset.y)
+        {
+            m_viewportOffset = anchoredOffset;
+            ScrollView::onViewportOffsetChangeHelper(m_viewportOffset);
+        }
+        m_visibleLines = m_virtualLines.measureVisibleRange(m_viewportOffset.y, height(), shape);
+
+        for (auto itor = m_lineLayouts.begin(); itor != m_lineLayouts.end(); )
+        {
+            if (itor->first < m_visibleLines.first || itor->first >= m_visibleLines.last)
+            {
+                itor = m_lineLayouts.erase(itor);
+            }
+            else ++itor;
+        }
+        // Re-styles the visible lines affected by the former modifications.
+        updateSyntaxHighlighting(m_visibleLines.last);
+
+        // The lines measured before may have been evicted since then.
+        for (auto line = m_visibleLines.first; line < m_visibleLines.last; ++line)
+        {
+            if (m_lineLayouts.find(line) == m_lineLayouts.end())
+            {
+                m_lineLayouts[line] = createLineLayout(line);
+            }
+        }
+    }
+
+    void VirtualTextEditor::invalidateLines()
+    {
+        if (m_content) m_content->invalidate();
+    }
+
+    void VirtualTextEditor::drawVisibleLines(Renderer* rndr)
+    {
+        resource_utils::solidColorBrush()->SetColor(foreground.color);
+        resource_utils::solidColorBrush()->SetOpacity(foreground.opacity);
+
+        for (size_t i = 0; i < m_syntaxBrushes.size(); ++i)
+        {
+            if (m_syntaxBrushes[i])
+            {
+                m_syntaxBrushes[i]->SetColor(syntaxStyles[i].color);
+                m_syntaxBrushes[i]->SetOpacity(syntaxStyles[i].opacity);
+            }
+        }
+        auto& contentRect = m_content->absoluteRect();
+
+        for (auto line = m_visibleLines.first; line < m_visibleLines.last; ++line)
+        {
+            auto layoutItor = m_lineLayouts.find(line);
+            if (layoutItor == m_lineLayouts.end()) continue;
+
+            D2D1_POINT_2F origin =
+            {
+                contentRect.left,
+                std::round(contentRect.top + m_virtualLines.lineTop(line))
+            };
+            rndr->recorder2D()->DrawTextLayout
+            (
+            /* origin           */ origin,
+            /* textLayout       */ layoutItor->second.Get(),
+            /* defaultFillBrush */ resource_utils::solidColorBrush(),
+            /* options          */ drawTextOptions
+            );
+        }
+    }
+
+    void VirtualTextEditor::onSizeHelper(SizeEvent& e)
+    {
+        ScrollView::onSizeHelper(e);
+
+        updateVisibleLines();
+    }
+
+    void VirtualTextEditor::onChangeThemeStyleHelper(const ThemeStyle& style)
+    {
+        ScrollView::onChangeThemeStyleHelper(style);
+
+        using Kind = text_utils::SyntaxKind;
+
+        auto setSyntaxColors = [this](const std::array<UINT32, (size_t)Kind::Count>& rgbs)
+        {
+            for (size_t i = 0; i < rgbs.size(); ++i)
+            {
+                syntaxStyles[i].color = D2D1::ColorF{ rgbs[i] };
+            }
+        };
+        if (style.name == L"Light")
+        {
+            foreground.color = D2D1::ColorF{ 0x000000 };
+
+            // Plain, Keyword, Number, String, Comment, Preprocessor, Operator
+            setSyntaxColors({ 0x000000, 0x0000ff, 0x098658, 0xa31515, 0x008000, 0x808080, 0x000000 });
+        }
+        else if (style.name == L"Dark")
+        {
+            foreground.color = D2D1::ColorF{ 0xe5e5e5 };
+
+            // Plain, Keyword, Number, String, Comment, Preprocessor, Operator
+            setSyntaxColors({ 0xe5e5e5, 0x569cd6, 0xb5cea8, 0xce9178, 0x6a9955, 0x9b9b9b, 0xd4d4d4 });
+        }
+    }
+
+    void VirtualTextEditor::onViewportOffsetChangeHelper(const D2D1_POINT_2F& offset)
+    {
+        ScrollView::onViewportOffsetChangeHelper(offset);
+
+        updateVisibleLines();
+    }
+}
@@ -0,0 +1,121 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include "UIKit/ScrollView.h"
+#include "UIKit/SolidStyle.h"
+#include "UIKit/TextUtils/LineIndex.h"
+#include "UIKit/TextUtils/SyntaxHighlighter.h"
+#include "UIKit/TextUtils/VirtualLines.h"
+
+namespace d14engine::uikit
+{
+    // Displays a huge text buffer (e.g. a log or a source file with
+    // millions of lines) by shaping only the visible lines plus overscan.
+    // The scroll extents are estimated from the measured lines and get
+    // refined gradually as more lines come into view.
+    //
+    // The text is modified programmatically with insertText/eraseText,
+    // and only the lines touched by the modification are re-shaped.
+    //
+    // With a syntax lexer set, the lines are highlighted incrementally,
+    // and only the changed spans of the cached layouts are re-styled.
+
+    struct VirtualTextEditor : ScrollView
+    {
+        VirtualTextEditor(const D2D1_RECT_F& rect = {});
+
+        void onInitializeFinish() override;
+
+        SolidStyle foreground = {};
+
+        D2D1_DRAW_TEXT_OPTIONS drawTextOptions = D2D1_DRAW_TEXT_OPTIONS_NONE;
+
+    protected:
+        Wstring m_text = {};
+
+        text_utils::LineIndex m_lineIndex = {};
+
+        text_utils::VirtualLines m_virtualLines = {};
+
+    public:
+        const Wstring& text() const;
+        void setText(WstrRefer text);
+
+        void insertText(WstrRefer fragment, size_t offset);
+        void appendText(WstrRefer fragment);
+
+        void eraseText(size_t offset, size_t count);
+
+        const text_utils::LineIndex& lineIndex() const;
+
+        // The settings (e.g. overscan) take effect at the next update.
+        text_utils::VirtualLines& virtualLines();
+
+    protected:
+        SharedPtr<text_utils::SyntaxHighlighter> m_syntaxHighlighter = {};
+
+        using SyntaxStyleArray = std::array<SolidStyle, (size_t)text_utils::SyntaxKind::Count>;
+
+        std::array<ComPtr<ID2D1SolidColorBrush>, (size_t)text_utils::SyntaxKind::Count> m_syntaxBrushes = {};
+
+    public:
+        // The plain characters are drawn with the foreground instead.
+        SyntaxStyleArray syntaxStyles = {};
+
+        const SharedPtr<text_utils::SyntaxHighlighter>& syntaxHighlighter() const;
+
+        // Pass nullptr to disable the syntax highlighting.
+        void setSyntaxLexer(ShrdPtrRefer<text_utils::SyntaxLexer> lexer);
+
+    protected:
+        // Lexes the dirty lines before lineLimit and re-styles the changed
+        // spans of the cached line layouts.
+        void updateSyntaxHighlighting(size_t lineLimit);
+
+        void applySyntaxStyles(IDWriteTextLayout* textLayout, size_t line, const text_utils::SyntaxHighlighter::Span& span);
+
+    protected:
+        ComPtr<IDWriteTextFormat> m_textFormat = {};
+
+    public:
+        IDWriteTextFormat* textFormat() const;
+        void setTextFormat(IDWriteTextFormat* textFormat);
+
+    protected:
+        // Only the layouts of the lines in the visible range are cached.
+        std::unordered_map<size_t, ComPtr<IDWriteTextLayout>> m_lineLayouts = {};
+
+        text_utils::VirtualLines::Range m_visibleLines = { 0, 0 };
+
+        // The '\r' of CRLF is kept in the text but never shaped.
+        WstringView lineText(size_t line) const;
+
+        ComPtr<IDWriteTextLayout> createLineLayout(size_t line);
+
+        void onLinesChange(const text_utils::LineIndex::Change& change);
+
+    public:
+        const text_utils::VirtualLines::Range& visibleLines() const;
+
+        // Shapes the unmeasured lines that come into view, evicts the line
+        // layouts out of view and resizes the content with the estimation.
+        void updateVisibleLines();
+
+    protected:
+        void drawVisibleLines(renderer::Renderer* rndr);
+
+        // The lines are drawn by the content, so this invalidates the cached
+        // layers from the content up (see Panel::setCachedLayer).
+        void invalidateLines();
+
+    protected:
+        // Panel
+        void onSizeHelper(SizeEvent& e) override;
+
+        void onChangeThemeStyleHelper(const ThemeStyle& style) override;
+
+        // ScrollView
+        void onViewportOffsetChangeHelper(const D2D1_POINT_2F& offset) override;
+    };
+}
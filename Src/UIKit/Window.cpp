@@ -395,6 +395,16 @@ namespace d14engine::uikit
         return m_isDragging || isSizing();
     }
 
+    std::array<bool, 6> Window::buttonStates() const
+    {
+        return
+        {
+            m_isButton1Hover, m_isButton1Down,
+            m_isButton2Hover, m_isButton2Down,
+            m_isButton3Hover, m_isButton3Down
+        };
+    }
+
     Window::ButtonState Window::getButton1State(bool isHover, bool isDown) const
     {
         if (isDown) return ButtonState::Down;
@@ -546,7 +556,7 @@ namespace d14engine::uikit
         (
             -m_absoluteRect.left, -m_absoluteRect.top
         );
-        mask.beginDraw(rndr->d2d1DeviceContext(), maskDrawTrans);
+        mask.beginDraw(rndr->recorder2D(), maskDrawTrans);
         {
             ////////////////
             // Background //
@@ -572,7 +582,7 @@ namespace d14engine::uikit
                     resource_utils::solidColorBrush()->SetColor(background.color);
                     resource_utils::solidColorBrush()->SetOpacity(background.opacity);
 
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ captionPanelAbsoluteRect(),
                     /* brush */ resource_utils::solidColorBrush()
@@ -590,7 +600,7 @@ namespace d14engine::uikit
                     brush->SetStartPoint({ rect.left, rect.top });
                     brush->SetEndPoint({ rect.right, rect.top });
 
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ rect,
                     /* brush */ brush.Get()
@@ -612,7 +622,7 @@ namespace d14engine::uikit
                     setButtonBrushState(state);
 
                     // Background
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ minimizeButtonAbsoluteRect(),
                     /* brush */ resource_utils::solidColorBrush()
@@ -620,7 +630,7 @@ namespace d14engine::uikit
                     setIconBrushState(state);
 
                     // Center Dash
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ minimizeIconAbsoluteRect(),
                     /* brush */ resource_utils::solidColorBrush()
@@ -637,7 +647,7 @@ namespace d14engine::uikit
                     setButtonBrushState(state);
 
                     // Background
-                    rndr->d2d1DeviceContext()->FillRectangle
+                    rndr->recorder2D()->FillRectangle
                     (
                     /* rect  */ maximizeButtonAbsoluteRect(),
                     /* brush */ resource_utils::solidColorBrush()
@@ -647,7 +657,7 @@ namespace d14engine::uikit
                     // Maximize Button
                     if (m_displayState == Normal)
                     {
-                        rndr->d2d1DeviceContext()->DrawRectangle
+                        rndr->recorder2D()->DrawRectangle
                         (
                         /* rect        */ maximizeIconAbsoluteRect(),
                         /* brush       */ resource_utils::solidColorBrush(),
@@ -659,7 +669,7 @@ namespace d14engine::uikit
                         auto rect = restoreIconAbsoluteRect();
 
                         // Square
-                        rndr->d2d1DeviceContext()->DrawRectangle
+                        rndr->recorder2D()->DrawRectangle
                         (
                         /* rect        */ rect,
                         /* brush       */ resource_utils::solidColorBrush(),
@@ -681,7 +691,7 @@ namespace d14engine::uikit
                             crossPoint, -restoreIconStrokeWidth() * 0.5f);
 
                         // Top Dash
-                        rndr->d2d1DeviceContext()->DrawLine
+                        rndr->recorder2D()->DrawLine
                         (
                         /* point0      */ point00,
                         /* point1      */ point01,
@@ -693,7 +703,7 @@ namespace d14engine::uikit
                             crossPoint, -restoreIconStrokeWidth() * 0.5f);
 
                         // Right Dash
-                        rndr->d2d1DeviceContext()->DrawLine
+                        rndr->recorder2D()->DrawLine
                         (
                         /* point0      */ point10,
                         /* point1      */ point11,
@@ -714,7 +724,7 @@ namespace d14engine::uikit
 
                     // Background
                     {
-                        rndr->d2d1DeviceContext()->FillRectangle
+                        rndr->recorder2D()->FillRectangle
                         (
                         /* rect  */ closeButtonAbsoluteRect(),
                         /* brush */ resource_utils::solidColorBrush()
@@ -726,7 +736,7 @@ namespace d14engine::uikit
                         auto rect = closeIconAbsoluteRect();
 
                         // Main Diagonal
-                        rndr->d2d1DeviceContext()->DrawLine
+                        rndr->recorder2D()->DrawLine
                         (
                         /* point0      */ { rect.left, rect.top },
                         /* point1      */ { rect.right, rect.bottom },
@@ -734,7 +744,7 @@ namespace d14engine::uikit
                         /* strokeWidth */ closeIconStrokeWidth()
                         );
                         // Back Diagonal
-                        rndr->d2d1DeviceContext()->DrawLine
+                        rndr->recorder2D()->DrawLine
                         (
                         /* point0      */ { rect.right, rect.top },
                         /* point1      */ { rect.left, rect.bottom },
@@ -759,7 +769,7 @@ namespace d14engine::uikit
                 Panel::drawChildrenObjects(rndr);
             }
         }
-        mask.endDraw(rndr->d2d1DeviceContext());
+        mask.endDraw(rndr->recorder2D());
     }
 
     void Window::onRendererDrawD2d1ObjectHelper(Renderer* rndr)
@@ -781,7 +791,7 @@ namespace d14engine::uikit
 
                 auto offset = math_utils::offset(absolutePosition(), shadow.offset);
 
-                rndr->d2d1DeviceContext()->DrawImage
+                rndr->recorder2D()->DrawImage
                 (
                 /* effect       */ resource_utils::shadowEffect(),
                 /* targetOffset */ offset
@@ -811,7 +821,7 @@ namespace d14engine::uikit
             (
                 m_absoluteRect.left, m_absoluteRect.top
             ));
-            rndr->d2d1DeviceContext()->FillRoundedRectangle
+            rndr->recorder2D()->FillRoundedRectangle
             (
             /* roundedRect */ { m_absoluteRect, roundRadiusX, roundRadiusY },
             /* brush       */ brush.Get()
@@ -833,7 +843,7 @@ namespace d14engine::uikit
             auto rect = math_utils::inner(m_absoluteRect, stroke.width);
             D2D1_ROUNDED_RECT roundedRect = { rect, roundRadiusX, roundRadiusY };
 
-            rndr->d2d1DeviceContext()->DrawRoundedRectangle
+            rndr->recorder2D()->DrawRoundedRectangle
             (
             /* roundedRect */ roundedRect,
             /* brush       */ resource_utils::solidColorBrush(),
@@ -888,6 +898,8 @@ namespace d14engine::uikit
 
         auto& p = e.cursorPoint;
 
+        auto originalButtonStates = buttonStates();
+
         if (!isPerformSpecialOperation())
         {
             if (button1Enabled)
@@ -920,6 +932,8 @@ namespace d14engine::uikit
         }
         else m_isButton1Hover = m_isButton2Hover = m_isButton3Hover = false;
 
+        if (buttonStates() != originalButtonStates) invalidate();
+
         DraggablePanel::onMouseMoveWrapper(e);
         ResizablePanel::onMouseMoveWrapper(e);
 
@@ -940,6 +954,8 @@ namespace d14engine::uikit
     {
         Panel::onMouseButtonHelper(e);
 
+        auto originalButtonStates = buttonStates();
+
         if (respondSetForegroundEvent)
         {
             if (e.state.leftDown() ||
@@ -979,6 +995,8 @@ namespace d14engine::uikit
             }
             m_isButton1Down = m_isButton2Down = m_isButton3Down = false;
         }
+        if (buttonStates() != originalButtonStates) invalidate();
+
         DraggablePanel::onMouseButtonWrapper(e);
         ResizablePanel::onMouseButtonWrapper(e);
 
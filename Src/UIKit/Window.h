@@ -273,6 +273,10 @@ namespace d14engine::uikit
         bool m_isButton2Hover = false, m_isButton2Down = false;
         bool m_isButton3Hover = false, m_isButton3Down = false;
 
+        // Compared before and after the mouse events, so that the window is
+        // only invalidated when any of the buttons changes.
+        std::array<bool, 6> buttonStates() const;
+
         ButtonState getButton1State(bool isHover, bool isDown) const;
         ButtonState getButton2State(bool isHover, bool isDown) const;
         ButtonState getButton3State(bool isHover, bool isDown) const;
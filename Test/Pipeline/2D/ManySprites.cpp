@@ -2,10 +2,181 @@
 
 #include "../TestWindow.h"
 
+#include "Common/DirectXError.h"
+#include "Common/MathUtils/2D.h"
+
+#include "Pipeline/2D/SpriteGroup.h"
+#include "Pipeline/Cameras/Camera2D.h"
+
+#include "Renderer/GraphUtils/Bitmap.h"
+#include "Renderer/GraphUtils/Texture.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/TickTimer.h"
+
+#include "UIKit/PlatformUtils.h"
+
 using namespace d14engine;
+using namespace d14engine::pipeline;
+using namespace d14engine::renderer;
 using namespace d14engine::uikit;
 
+namespace
+{
+    // A soft dot of the color in 32bppPRGBA.
+    ComPtr<IWICBitmapSource> makeDotBitmap(UINT size, const XMFLOAT3& color)
+    {
+        std::vector<BYTE> pixels(size * size * 4);
+        for (UINT y = 0; y < size; ++y)
+        {
+            for (UINT x = 0; x < size; ++x)
+            {
+                auto dx = ((float)x + 0.5f) / (float)size * 2.0f - 1.0f;
+                auto dy = ((float)y + 0.5f) / (float)size * 2.0f - 1.0f;
+
+                auto alpha = std::clamp(1.0f - std::sqrt(dx * dx + dy * dy), 0.0f, 1.0f);
+
+                auto pixel = &pixels[(y * size + x) * 4];
+                pixel[0] = (BYTE)(color.x * alpha * 255.0f);
+                pixel[1] = (BYTE)(color.y * alpha * 255.0f);
+                pixel[2] = (BYTE)(color.z * alpha * 255.0f);
+                pixel[3] = (BYTE)(alpha * 255.0f);
+            }
+        }
+        ComPtr<IWICBitmap> bitmap = {};
+        THROW_IF_FAILED(graph_utils::bitmap::factory()->CreateBitmapFromMemory
+        (
+        /* uiWidth      */ size,
+        /* uiHeight     */ size,
+        /* pixelFormat  */ GUID_WICPixelFormat32bppPRGBA,
+        /* cbStride     */ size * 4,
+        /* cbBufferSize */ (UINT)pixels.size(),
+        /* pbBuffer     */ pixels.data(),
+        /* ppIBitmap    */ &bitmap
+        ));
+        return bitmap;
+    }
+}
+
 void initTestScene(Application* app, ScenePanel* sp)
 {
-    // build scene here
+    constexpr size_t spriteCount = 200'000;
+    constexpr size_t textureCount = 16;
+    constexpr size_t layerCount = 4;
+
+    // The sprites are scattered over 4 x 4 views (of 160 x 90 units), and
+    // the camera pans across them, so most of them are culled in each frame.
+    constexpr float worldWidth = 640.0f, worldHeight = 360.0f;
+
+    auto rndr = app->renderer();
+
+    auto camera = std::make_shared<Camera2D>(rndr->d3d12Device());
+    {
+        camera->updateViewMatrix();
+
+        auto resize = [camera](const D2D1_SIZE_F& size)
+        {
+            auto dipSize = math_utils::roundu(size);
+            SIZE sz = { (LONG)dipSize.width, (LONG)dipSize.height };
+            auto pixSize = platform_utils::scaledByDpi(sz);
+
+            camera->onViewResize((UINT)pixSize.cx, (UINT)pixSize.cy);
+
+            // Fits the width of the scene (160 units).
+            camera->zoom = std::max((float)pixSize.cx, 1.0f) / 160.0f;
+            camera->updateProjMatrix();
+            camera->dirtyFrameCount = FrameResource::g_bufferCount;
+        };
+        resize(sp->size());
+
+        auto onSize = sp->f_onSize;
+        sp->f_onSize = [onSize, resize](Panel* p, SizeEvent& e)
+        {
+            if (onSize) onSize(p, e);
+            resize(e.size);
+        };
+    }
+    // Kept by the group since the placed textures free their heap ranges
+    // with the allocations (not with the last reference to the resource).
+    auto textures = std::make_shared<std::vector<graph_utils::texture::MipmappedTexture>>();
+
+    rndr->beginGpuCommand();
+
+    auto group = std::make_shared<SpriteGroup>(
+        rndr, (UINT)textureCount, DXGI_SAMPLE_DESC{ sp->sampleCount(), sp->sampleQuality() });
+
+    for (size_t i = 0; i < textureCount; ++i)
+    {
+        auto hue = (float)i / (float)textureCount * XM_2PI;
+        XMFLOAT3 color =
+        {
+            0.5f + 0.5f * std::cos(hue),
+            0.5f + 0.5f * std::cos(hue - XM_2PI / 3.0f),
+            0.5f + 0.5f * std::cos(hue + XM_2PI / 3.0f)
+        };
+        textures->push_back(graph_utils::texture::loadMipmapped(rndr, makeDotBitmap(64, color).Get()));
+    }
+    rndr->endGpuCommand();
+
+    group->camera = camera;
+    group->setPriority(0);
+
+    // xorshift32, which is enough to scatter the dots
+    uint32_t seed = 0x2545f491;
+    auto random = [&seed](float low, float high)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return low + (high - low) * (float)(seed >> 8) / (float)(1 << 24);
+    };
+    auto speeds = std::make_shared<std::vector<float>>(spriteCount);
+
+    group->sprites.reserve(spriteCount);
+    for (size_t i = 0; i < spriteCount; ++i)
+    {
+        auto sprite = std::make_shared<Sprite>();
+
+        auto& frames = sprite->textureData.fanim.frames;
+        frames.push_back({ (*textures)[i % textureCount].resource });
+
+        sprite->position =
+        {
+            random(-0.5f * worldWidth, 0.5f * worldWidth),
+            random(-0.5f * worldHeight, 0.5f * worldHeight)
+        };
+        auto size = random(0.5f, 2.0f);
+        sprite->size = { size, size * random(0.5f, 1.0f) };
+
+        // The sprites share a few layers to be batched well.
+        sprite->depth = (float)(i % layerCount) * 10.0f;
+
+        sprite->color.w = random(0.5f, 1.0f);
+        sprite->blend = (i % 3 == 0) ? SpriteBlend::Additive : SpriteBlend::Alpha;
+
+        (*speeds)[i] = random(-XM_PI, XM_PI);
+
+        group->sprites.push_back(sprite);
+    }
+    group->f_onRendererUpdateLayerBefore = [speeds, textures, camera](DrawLayer* layer, Renderer* rndr)
+    {
+        auto& sprites = ((SpriteGroup*)layer)->sprites;
+        auto deltaSecs = (float)rndr->timer()->deltaSecs();
+
+        // A slow Lissajous curve that stays within the scattered sprites.
+        auto elapsedSecs = (float)rndr->timer()->elapsedSecs();
+        camera->position =
+        {
+            0.375f * worldWidth * std::sin(0.05f * elapsedSecs),
+            0.375f * worldHeight * std::sin(0.08f * elapsedSecs)
+        };
+        camera->updateViewMatrix();
+        camera->dirtyFrameCount = FrameResource::g_bufferCount;
+
+        for (size_t i = 0; i < sprites.size(); ++i)
+        {
+            sprites[i]->rotation += (*speeds)[i] * deltaSecs;
+        }
+    };
+    auto& sceneTarget = std::get<Renderer::CommandLayer::D3D12Target>(sp->cmdLayer()->drawTarget);
+    sceneTarget[group] = {};
 }
@@ -377,6 +377,10 @@ D14_SET_APP_ENTRY(mainColorfulCube)
         camera->setPriority(1);
         objset.insert(camera);
 
+        // The objects with bounds (i.e. the cube) are culled by the camera
+        // when they are moved out of the view.
+        ui_scenePanel->primaryLayer()->cullingCamera = camera;
+
         auto objectGeometry = std::make_shared<std::array<XMFLOAT3, 3>>();
         (*objectGeometry)[0] = { 0.0f, 0.0f, 0.0f }; // position
         (*objectGeometry)[1] = { 0.0f, 0.0f, 0.0f }; // rotation
@@ -420,8 +424,8 @@ D14_SET_APP_ENTRY(mainColorfulCube)
                 4, 7, 2,
                 6, 2, 7
             };
-            auto vertexBuffer = std::make_shared<DefaultBuffer>(device, sizeof(vertices));
-            auto indexBuffer = std::make_shared<DefaultBuffer>(device, sizeof(indices));
+            auto vertexBuffer = std::make_shared<DefaultBuffer>(device, sizeof(vertices), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+            auto indexBuffer = std::make_shared<DefaultBuffer>(device, sizeof(indices), D3D12_RESOURCE_STATE_INDEX_BUFFER);
 
             rndr->beginGpuCommand();
 
@@ -453,6 +457,9 @@ D14_SET_APP_ENTRY(mainColorfulCube)
                 rndr->cmdList()->DrawIndexedInstanced(_countof(indices), 1, 0, 0, 0);
             };
         }
+        // The sphere around the unit cube, which is updated with the geometry.
+        cubeobj->bounds = cull_utils::Sphere{ .radius = 0.5f * std::sqrt(3.0f) };
+
         cubeobj->setPriority(2);
         objset.insert(cubeobj);
 
@@ -722,7 +729,7 @@ D14_SET_APP_ENTRY(mainColorfulCube)
                 geoInfo.axis.y = { offsetY, 1 };
                 ui_sideLayout->addElement(ui_objectData, geoInfo);
             }
-            auto updateObjectData = [=, wk_matrix = (WeakPtr<XMFLOAT4X4>)worldMatrix]
+            auto updateObjectData = [=, wk_matrix = (WeakPtr<XMFLOAT4X4>)worldMatrix, wk_cube = (WeakPtr<DrawObject>)cubeobj]
             (RawTextBox* src, wchar_t component /* select from X, Y, Z */)
             {
                 auto value = wcstof(src->text().c_str(), nullptr);
@@ -781,6 +788,18 @@ D14_SET_APP_ENTRY(mainColorfulCube)
                             /* Translation        */ position)
                         );
                     }
+                    if (!wk_cube.expired())
+                    {
+                        auto& position = (*objectGeometry)[0];
+                        auto& scaling = (*objectGeometry)[2];
+
+                        auto maxScaling = std::max({ std::abs(scaling.x), std::abs(scaling.y), std::abs(scaling.z) });
+
+                        wk_cube.lock()->bounds = cull_utils::Sphere
+                        {
+                            position.x, position.y, position.z, 0.5f * std::sqrt(3.0f) * maxScaling
+                        };
+                    }
                 }
                 src->setText(std::to_wstring(value));
             };
@@ -13,6 +13,7 @@
 #include "UIKit/FilledButton.h"
 #include "UIKit/GridLayout.h"
 #include "UIKit/IconLabel.h"
+#include "UIKit/ImageLoader.h"
 #include "UIKit/Label.h"
 #include "UIKit/MainWindow.h"
 #include "UIKit/OnOffSwitch.h"
@@ -151,14 +152,29 @@ D14_SET_APP_ENTRY(mainImageViewer)
         }
         Wstring assetsPath = L"Test/UIKit/ImageViewer/";
 
-        std::vector<std::pair<Wstring, ComPtr<ID2D1Bitmap1>>> images;
+        // Only the paths are collected at startup, and each image is decoded
+        // in the background when its tab is created (see ImageLoader).
+        std::vector<std::pair<Wstring, Wstring>> images;
         file_system_utils::foreachFileInDir(assetsPath, L"*.png", [&](WstrRefer filePath)
         {
             auto fileName = file_system_utils::extractFileName(filePath);
             auto filePrefix = file_system_utils::extractFilePrefix(fileName);
-            images.push_back({ filePrefix, bitmap_utils::loadBitmap(filePath) });
+            images.push_back({ filePrefix, filePath });
             return false;
         });
+        auto imageLoader = std::make_shared<ImageLoader>();
+        WeakPtr<ImageLoader> wk_imageLoader = imageLoader; // captured by lambdas
+
+        // Only the selected tab is visible, so its image is decoded first,
+        // and the image of a tab closed before being decoded is cancelled.
+        struct DecodingTabs
+        {
+            std::unordered_map<Panel*, ImageLoader::Ticket> tickets = {};
+
+            Panel* visible = nullptr;
+        };
+        auto decodingTabs = std::make_shared<DecodingTabs>();
+
         auto ui_insertButton = makeUIObject<FilledButton>(L"Create new image tab");
         {
             ui_insertButton->roundRadiusX = ui_insertButton->roundRadiusY = 8.0f;
@@ -181,10 +197,49 @@ D14_SET_APP_ENTRY(mainImageViewer)
                     auto caption = makeUIObject<TabCaption>(images[index].first);
                     caption->title()->label()->setTextFormat(D14_FONT(L"Default/12"));
 
-                    auto imageRect = math_utils::sizeOnlyRect(images[index].second->GetSize());
-                    auto content = makeUIObject<Panel>(imageRect, nullptr, images[index].second);
+                    // The content shows a placeholder until the image is decoded.
+                    auto imageRect = math_utils::sizeOnlyRect({ 256.0f, 256.0f });
+                    auto content = makeUIObject<Label>(L"Decoding...", imageRect);
+                    THROW_IF_FAILED(content->textLayout()->SetTextAlignment(DWRITE_TEXT_ALIGNMENT_CENTER));
+                    THROW_IF_FAILED(content->textLayout()->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_CENTER));
+
                     auto wrapper = makeUIObject<ScrollView>(content);
 
+                    // Boosted by f_onSelectedTabIndexChange when selected.
+                    auto ticket = imageLoader->load(images[index].second,
+                    [=, wk_content = (WeakPtr<Label>)content, wrapperPtr = wrapper.get()]
+                    (ComPtrParam<ID2D1Bitmap1> bitmap)
+                    {
+                        decodingTabs->tickets.erase(wrapperPtr);
+
+                        if (!wk_content.expired())
+                        {
+                            auto sh_content = wk_content.lock();
+                            if (bitmap)
+                            {
+                                sh_content->setText(L"");
+                                sh_content->setSize(bitmap->GetSize());
+                                sh_content->bitmap = bitmap;
+                            }
+                            else sh_content->setText(L"Failed to decode the image");
+                        }
+                    });
+                    decodingTabs->tickets[wrapper.get()] = ticket;
+
+                    wrapper->f_onDestroy = [=](Panel* p)
+                    {
+                        auto itor = decodingTabs->tickets.find(p);
+                        if (itor != decodingTabs->tickets.end())
+                        {
+                            if (!wk_imageLoader.expired())
+                            {
+                                wk_imageLoader.lock()->cancel(itor->second);
+                            }
+                            decodingTabs->tickets.erase(itor);
+                        }
+                        if (decodingTabs->visible == p) decodingTabs->visible = nullptr;
+                    };
+
                     size_t currTabIndex = sh_tabGroup->activeCardTabIndex().index;
                     sh_tabGroup->insertTab({ caption, wrapper }, currTabIndex);
                     sh_tabGroup->selectTab(currTabIndex);
@@ -391,6 +446,8 @@ D14_SET_APP_ENTRY(mainImageViewer)
         {
             ui_tabGroup->f_onSelectedTabIndexChange =
             [
+                wk_imageLoader, decodingTabs,
+
                 wk_titleEditor = (WeakPtr<TextBox>)ui_titleEditor,
 
                 wk_checkBox1 = (WeakPtr<CheckBox>)ui_checkBox1,
@@ -399,6 +456,25 @@ D14_SET_APP_ENTRY(mainImageViewer)
             ]
             (TabGroup* tg, TabGroup::TabIndexParam index)
             {
+                if (!wk_imageLoader.expired())
+                {
+                    auto sh_imageLoader = wk_imageLoader.lock();
+                    auto& tickets = decodingTabs->tickets;
+
+                    // The hidden tab falls back to the background priority.
+                    auto hidden = tickets.find(decodingTabs->visible);
+                    if (hidden != tickets.end())
+                    {
+                        sh_imageLoader->setPriority(hidden->second, 0);
+                    }
+                    decodingTabs->visible = index.valid() ? index->content.get() : nullptr;
+
+                    auto visible = tickets.find(decodingTabs->visible);
+                    if (visible != tickets.end())
+                    {
+                        sh_imageLoader->setPriority(visible->second, ImageLoader::g_visiblePriority);
+                    }
+                }
                 if (!wk_titleEditor.expired())
                 {
                     wk_titleEditor.lock()->setText(index.valid() ?
@@ -0,0 +1,228 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Common/AssetArchive.h"
+#include "Common/CompressUtils/LZ4.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+
+namespace
+{
+    struct TempArchive
+    {
+        std::filesystem::path path = {};
+
+        explicit TempArchive(const char* name)
+            :
+            path(std::filesystem::temp_directory_path() / name) { std::filesystem::remove(path); }
+
+        ~TempArchive() { std::filesystem::remove(path); }
+    };
+
+    // 0: noise, 1: short period, 2: small alphabet.
+    std::vector<uint8_t> randomData(std::mt19937& rng, size_t size, int mode)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (mode == 0) data[i] = (uint8_t)rng();
+            else if (mode == 1) data[i] = (uint8_t)(i % 7);
+            else data[i] = (uint8_t)(rng() % 4);
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> repeatedText(size_t size)
+    {
+        std::vector<uint8_t> text(size);
+        for (size_t i = 0; i < size; ++i) text[i] = (uint8_t)"hello world "[i % 12];
+        return text;
+    }
+
+    void writeSampleArchive(const std::filesystem::path& path, std::mt19937& rng)
+    {
+        AssetArchiveWriter writer = {};
+        writer.alignment = 64;
+
+        writer.add(L"b/text.txt", repeatedText(20000));
+        writer.add(L".\\a\\noise.bin", randomData(rng, 3000, 0));
+        writer.add(L"c/empty", {});
+        writer.add(L"b/sub/é\U0001F600.png", randomData(rng, 3000, 0), false);
+
+        CHECK(writer.write(path));
+    }
+}
+
+D14_TEST(LZ4RoundTrips)
+{
+    namespace lz4 = compress_utils::lz4;
+
+    std::mt19937 rng(35);
+
+    bool roundTrip = true, bounded = true, rejected = true;
+    for (int i = 0; i < 500; ++i)
+    {
+        auto data = randomData(rng, rng() % 5000, i % 3);
+        auto compressed = lz4::compress(data.data(), data.size());
+
+        bounded &= compressed.size() <= lz4::compressBound(data.size());
+
+        std::vector<uint8_t> output(data.size());
+        roundTrip &= lz4::decompress(compressed.data(), compressed.size(), output.data(), output.size());
+        roundTrip &= output == data;
+
+        // A short destination is rejected instead of overrun.
+        if (!data.empty())
+        {
+            std::vector<uint8_t> shortOutput(data.size() - 1);
+            rejected &= !lz4::decompress(compressed.data(), compressed.size(), shortOutput.data(), shortOutput.size());
+        }
+    }
+    CHECK(roundTrip);
+    CHECK(bounded);
+    CHECK(rejected);
+}
+
+D14_TEST(LZ4SurvivesCorruptInput)
+{
+    namespace lz4 = compress_utils::lz4;
+
+    std::mt19937 rng(3535);
+
+    // Only checks that nothing is read or written out of bounds (which
+    // the sanitizers report), since a flipped literal still decodes.
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto data = randomData(rng, 1 + rng() % 5000, i % 3);
+        auto compressed = lz4::compress(data.data(), data.size());
+
+        for (int flip = 0; flip < 3; ++flip)
+        {
+            compressed[rng() % compressed.size()] ^= (uint8_t)(1 + rng() % 255);
+        }
+        std::vector<uint8_t> output(data.size());
+        lz4::decompress(compressed.data(), compressed.size(), output.data(), output.size());
+
+        // A truncated stream can never fill the destination.
+        compressed.resize(rng() % compressed.size());
+        lz4::decompress(compressed.data(), compressed.size(), output.data(), output.size());
+    }
+    CHECK(!lz4::decompress(nullptr, 0, nullptr, 1));
+    CHECK(lz4::decompress(lz4::compress(nullptr, 0).data(), lz4::compress(nullptr, 0).size(), nullptr, 0));
+}
+
+D14_TEST(ArchiveRoundTrips)
+{
+    TempArchive temp("D14AssetArchiveTest.d14a");
+
+    std::mt19937 rng(350);
+    writeSampleArchive(temp.path, rng);
+
+    AssetArchive archive = {};
+    if (!CHECK(archive.open(temp.path))) return;
+
+    CHECK(archive.size() == 4);
+    CHECK(archive.verify());
+
+    auto text = archive.load(L"b/text.txt");
+    CHECK(text.has_value() && text->size() == 20000 && text->view == nullptr);
+    if (text.has_value())
+    {
+        auto expected = repeatedText(20000);
+        CHECK(std::equal(expected.begin(), expected.end(), text->data()));
+    }
+    // The stored entries are viewed in the mapping at the alignment.
+    auto noise = archive.load(L"a/noise.bin");
+    CHECK(noise.has_value() && noise->view != nullptr && noise->size() == 3000);
+    CHECK(noise.has_value() && (uintptr_t)noise->view % 64 == 0);
+
+    auto empty = archive.load(L"c/empty");
+    CHECK(empty.has_value() && empty->size() == 0);
+
+    CHECK(!archive.load(L"b/none").has_value());
+    CHECK(archive.contains(L"/b\\text.txt"));
+
+    auto names = archive.list(L"b");
+    CHECK((names == std::vector<Wstring>{ L"b/sub/é\U0001F600.png", L"b/text.txt" }));
+}
+
+D14_TEST(MountedArchiveOutlivesUnmount)
+{
+    TempArchive temp("D14AssetArchiveMountTest.d14a");
+
+    std::mt19937 rng(351);
+    writeSampleArchive(temp.path, rng);
+
+    auto archive = std::make_shared<AssetArchive>();
+    if (!CHECK(archive->open(temp.path))) return;
+
+    AssetArchive::mount(L"Bin", archive);
+    archive.reset();
+
+    auto text = AssetArchive::resolve(L"./Bin\\b/text.txt");
+    CHECK(text.has_value() && text->archive != nullptr && text->size() == 20000);
+
+    CHECK(!AssetArchive::resolve(L"Other/b/text.txt").has_value());
+    CHECK((AssetArchive::resolveList(L"Bin/b/sub") == std::vector<Wstring>{ L"é\U0001F600.png" }));
+
+    AssetArchive::unmount(L"Bin/");
+    CHECK(!AssetArchive::resolve(L"Bin/b/text.txt").has_value());
+
+    // The asset holds the archive alive.
+    CHECK(text.has_value() && text->data()[0] == 'h');
+}
+
+D14_TEST(CorruptArchiveIsRejected)
+{
+    TempArchive temp("D14AssetArchiveBadTest.d14a");
+    {
+        std::ofstream file(temp.path, std::ios::binary);
+        file << "garbage";
+    }
+    AssetArchive archive = {};
+    CHECK(!archive.open(temp.path));
+
+    std::mt19937 rng(352);
+    writeSampleArchive(temp.path, rng);
+
+    // Truncations of the valid archive at random points.
+    auto size = std::filesystem::file_size(temp.path);
+    for (int i = 0; i < 20; ++i)
+    {
+        writeSampleArchive(temp.path, rng);
+        std::filesystem::resize_file(temp.path, rng() % size);
+
+        AssetArchive truncated = {};
+        CHECK(!truncated.open(temp.path));
+    }
+}
+
+D14_BENCH(LZ4Throughput)
+{
+    namespace lz4 = compress_utils::lz4;
+
+    std::mt19937 rng(2035);
+
+    // Text-like data of 16 MB.
+    std::vector<uint8_t> data(16 * 1024 * 1024);
+    for (size_t i = 0; i < data.size();)
+    {
+        auto word = 3 + rng() % 8;
+        for (size_t k = 0; k < word && i < data.size(); ++k) data[i++] = (uint8_t)('a' + rng() % 6);
+        if (i < data.size()) data[i++] = ' ';
+    }
+    std::vector<uint8_t> compressed = {};
+    double us = unit_test::measure(3, [&] { compressed = lz4::compress(data.data(), data.size()); });
+
+    std::printf("  compress: %.1f MB/s (ratio %.2f)\n", data.size() / us, (double)data.size() / compressed.size());
+
+    std::vector<uint8_t> output(data.size());
+    us = unit_test::measure(3, [&]
+    {
+        lz4::decompress(compressed.data(), compressed.size(), output.data(), output.size());
+    });
+    std::printf("  decompress: %.1f MB/s\n", data.size() / us);
+}
@@ -0,0 +1,216 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Common/CullUtils/Frustum.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::cull_utils;
+
+namespace
+{
+    using Matrix = float[4][4];
+
+    // The row-vector matrices (as DirectXMath), i.e. clip = point * m.
+    struct Camera
+    {
+        Matrix viewProj = {};
+
+        Frustum frustum() const { return Frustum::fromMatrix(viewProj); }
+
+        // Whether the point is strictly inside the clip volume
+        // (with a small margin against the rounding).
+        bool contains(float x, float y, float z) const
+        {
+            auto& m = viewProj;
+            float clip[4] = {};
+            for (int j = 0; j < 4; ++j)
+            {
+                clip[j] = x * m[0][j] + y * m[1][j] + z * m[2][j] + m[3][j];
+            }
+            auto w = clip[3];
+            return w > 0.0f &&
+                   std::abs(clip[0]) <= w * 0.999f && std::abs(clip[1]) <= w * 0.999f &&
+                   clip[2] >= w * 0.001f && clip[2] <= w * 0.999f;
+        }
+    };
+
+    // A perspective camera at z = -10 looking at +z.
+    Camera perspectiveCamera()
+    {
+        float fov = 0.785f, aspect = 16.0f / 9.0f, zn = 1.0f, zf = 100.0f;
+
+        float h = 1.0f / std::tan(fov / 2.0f), w = h / aspect, q = zf / (zf - zn);
+
+        Camera camera =
+        {{
+            { w, 0.0f, 0.0f, 0.0f },
+            { 0.0f, h, 0.0f, 0.0f },
+            { 0.0f, 0.0f, q, 1.0f },
+            { 0.0f, 0.0f, 10.0f * q - q * zn, 10.0f }
+        }};
+        return camera;
+    }
+
+    // A 40 x 20 x 100 orthographic camera.
+    Camera orthographicCamera()
+    {
+        Camera camera =
+        {{
+            { 2.0f / 40.0f, 0.0f, 0.0f, 0.0f },
+            { 0.0f, 2.0f / 20.0f, 0.0f, 0.0f },
+            { 0.0f, 0.0f, 1.0f / 100.0f, 0.0f },
+            { 0.0f, 0.0f, 0.0f, 1.0f }
+        }};
+        return camera;
+    }
+
+    struct Scene
+    {
+        std::vector<Sphere> spheres = {};
+        std::vector<AABB> boxes = {};
+
+        SphereArray sphereArray = {};
+        AABBArray boxArray = {};
+
+        Scene(std::mt19937& rng, size_t count)
+        {
+            std::uniform_real_distribution<float> position(-120.0f, 120.0f), size(0.0f, 5.0f);
+
+            sphereArray.reserve(count);
+            boxArray.reserve(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                Sphere sphere = { position(rng), position(rng) * 0.5f, position(rng), size(rng) };
+                spheres.push_back(sphere);
+                sphereArray.push_back(sphere);
+
+                AABB box = { position(rng), position(rng) * 0.5f, position(rng), size(rng), size(rng), size(rng) };
+                boxes.push_back(box);
+                boxArray.push_back(box);
+            }
+        }
+    };
+}
+
+D14_TEST(BatchMatchesSingleTests)
+{
+    std::mt19937 rng(39);
+
+    for (auto camera : { perspectiveCamera(), orthographicCamera() })
+    {
+        auto frustum = camera.frustum();
+
+        // The odd counts cover the scalar tails of the SIMD paths.
+        for (size_t count : { 0, 1, 3, 4, 7, 100003 })
+        {
+            Scene scene(rng, count);
+
+            std::vector<uint8_t> sphereResults(count), boxResults(count);
+            auto sphereCount = cull(frustum, scene.sphereArray, sphereResults.data());
+            auto boxCount = cull(frustum, scene.boxArray, boxResults.data());
+
+            bool matched = true;
+            size_t expectedSpheres = 0, expectedBoxes = 0;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                matched &= sphereResults[i] == frustum.intersects(scene.spheres[i]);
+                matched &= boxResults[i] == frustum.intersects(scene.boxes[i]);
+
+                expectedSpheres += sphereResults[i];
+                expectedBoxes += boxResults[i];
+            }
+            CHECK(matched);
+            CHECK(sphereCount == expectedSpheres && boxCount == expectedBoxes);
+        }
+    }
+}
+
+D14_TEST(NeverCullsVisiblePoints)
+{
+    std::mt19937 rng(390);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    for (auto camera : { perspectiveCamera(), orthographicCamera() })
+    {
+        auto frustum = camera.frustum();
+        Scene scene(rng, 20000);
+
+        size_t visibleCount = 0, missedCount = 0;
+        for (size_t i = 0; i < scene.spheres.size(); ++i)
+        {
+            auto& sphere = scene.spheres[i];
+            auto& box = scene.boxes[i];
+
+            // The points in the cube inscribed in the sphere, and in the box.
+            for (int k = 0; k < 20; ++k)
+            {
+                auto r = sphere.radius * 0.577f;
+                if (camera.contains(sphere.x + unit(rng) * r, sphere.y + unit(rng) * r, sphere.z + unit(rng) * r))
+                {
+                    ++visibleCount;
+                    missedCount += !frustum.intersects(sphere);
+                }
+                if (camera.contains(box.centerX + unit(rng) * box.extentX,
+                                    box.centerY + unit(rng) * box.extentY,
+                                    box.centerZ + unit(rng) * box.extentZ))
+                {
+                    ++visibleCount;
+                    missedCount += !frustum.intersects(box);
+                }
+            }
+        }
+        CHECK(visibleCount > 1000);
+        CHECK(missedCount == 0);
+    }
+}
+
+D14_TEST(PlanesOfOrthographicBox)
+{
+    auto frustum = orthographicCamera().frustum();
+
+    CHECK(frustum.intersects(Sphere{ 0.0f, 0.0f, 50.0f, 0.0f }));
+    CHECK(frustum.intersects(Sphere{ 19.9f, 9.9f, 0.1f, 0.0f }));
+
+    CHECK(!frustum.intersects(Sphere{ 21.0f, 0.0f, 50.0f, 0.5f }));
+    CHECK(frustum.intersects(Sphere{ 21.0f, 0.0f, 50.0f, 1.5f }));
+
+    CHECK(!frustum.intersects(Sphere{ 0.0f, 0.0f, -1.0f, 0.5f }));
+    CHECK(!frustum.intersects(Sphere{ 0.0f, 0.0f, 101.0f, 0.5f }));
+
+    auto box = AABB::fromMinMax(20.5f, -1.0f, 10.0f, 22.0f, 1.0f, 20.0f);
+    CHECK(box.centerX == 21.25f && box.extentX == 0.75f);
+    CHECK(!frustum.intersects(box));
+
+    box.extentX = 1.5f;
+    CHECK(frustum.intersects(box));
+}
+
+D14_BENCH(CullOneMillionBounds)
+{
+    std::mt19937 rng(2039);
+
+    auto frustum = perspectiveCamera().frustum();
+    Scene scene(rng, 1000000);
+
+    std::vector<uint8_t> results(scene.spheres.size());
+    size_t count = 0;
+
+    double us = unit_test::measure(5, [&] { count = cull(frustum, scene.sphereArray, results.data()); });
+    std::printf("  spheres: %.2f ms (%zu visible)\n", us / 1000.0, count);
+
+    us = unit_test::measure(5, [&] { count = cull(frustum, scene.boxArray, results.data()); });
+    std::printf("  AABBs: %.2f ms (%zu visible)\n", us / 1000.0, count);
+
+    // One sphere at a time, as the scalar path does.
+    us = unit_test::measure(5, [&]
+    {
+        count = 0;
+        for (auto& sphere : scene.spheres) count += frustum.intersects(sphere);
+    });
+    std::printf("  spheres one by one: %.2f ms\n", us / 1000.0);
+}
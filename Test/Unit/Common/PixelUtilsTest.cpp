@@ -0,0 +1,237 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Common/PixelUtils/Blur.h"
+#include "Common/PixelUtils/MipChain.h"
+#include "Common/PixelUtils/Premultiply.h"
+#include "Common/PixelUtils/Resample.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::pixel_utils;
+
+namespace
+{
+    constexpr Filter g_filters[] = { Filter::Box, Filter::Mitchell, Filter::Lanczos3 };
+
+    Image randomPremultiplied(std::mt19937& rng, uint32_t width, uint32_t height)
+    {
+        Image image(width, height);
+        for (auto& byte : image.pixels) byte = (uint8_t)rng();
+
+        premultiply(image.pixels.data(), (size_t)width * height);
+        return image;
+    }
+
+    // Every (color, alpha) pair once.
+    std::vector<uint8_t> allColorAlphaPairs()
+    {
+        std::vector<uint8_t> pixels(256 * 256 * 4);
+        for (int a = 0; a < 256; ++a)
+        {
+            for (int c = 0; c < 256; ++c)
+            {
+                auto p = &pixels[(a * 256 + c) * 4];
+                p[0] = (uint8_t)c; p[1] = (uint8_t)(255 - c); p[2] = (uint8_t)(c / 2); p[3] = (uint8_t)a;
+            }
+        }
+        return pixels;
+    }
+
+    void printThroughput(const char* name, double us)
+    {
+        std::printf("  %-24s %8.2f ms %8.1f MP/s\n", name, us / 1000.0, 4096.0 * 4096.0 / us);
+    }
+}
+
+D14_TEST(PremultiplyRoundsExactly)
+{
+    auto simd = allColorAlphaPairs(), scalar = simd;
+
+    premultiply(simd.data(), 256 * 256);
+    premultiplyScalar(scalar.data(), 256 * 256);
+
+    CHECK(simd == scalar);
+
+    bool rounded = true;
+    for (int a = 0; a < 256 && rounded; ++a)
+    {
+        for (int c = 0; c < 256 && rounded; ++c)
+        {
+            rounded = scalar[(a * 256 + c) * 4] == (int)std::lround(c * a / 255.0);
+        }
+    }
+    CHECK(rounded);
+}
+
+D14_TEST(SwapRedBlueMatchesScalar)
+{
+    auto simd = allColorAlphaPairs(), scalar = simd;
+
+    // An odd count covers the scalar tail of the SIMD path.
+    swapRedBlue(simd.data(), 256 * 256 - 1);
+    swapRedBlueScalar(scalar.data(), 256 * 256 - 1);
+
+    CHECK(simd == scalar);
+    CHECK(scalar[0] == 0 && scalar[2] == 0 && scalar[4] == 0 && scalar[6] == 1);
+}
+
+D14_TEST(ResampleMatchesScalar)
+{
+    std::mt19937 rng(33);
+
+    bool matched = true, premultiplied = true;
+    for (int i = 0; i < 200 && matched; ++i)
+    {
+        uint32_t width = 1 + rng() % 70, height = 1 + rng() % 70;
+        auto source = randomPremultiplied(rng, width, height);
+
+        uint32_t dstWidth = 1 + rng() % 90, dstHeight = 1 + rng() % 90;
+        for (auto filter : g_filters)
+        {
+            auto simd = resample(source.view(), dstWidth, dstHeight, filter);
+            matched &= simd.pixels == resampleScalar(source.view(), dstWidth, dstHeight, filter).pixels;
+
+            // The ringing never produces colors over the alpha.
+            for (size_t p = 0; p < simd.pixels.size(); p += 4)
+            {
+                for (size_t c = 0; c < 3; ++c)
+                {
+                    premultiplied &= simd.pixels[p + c] <= simd.pixels[p + 3];
+                }
+            }
+            matched &= halve(source.view(), filter).pixels == halveScalar(source.view(), filter).pixels;
+        }
+    }
+    CHECK(matched);
+    CHECK(premultiplied);
+}
+
+D14_TEST(ConstantImageStaysConstant)
+{
+    Image image(37, 23);
+    for (size_t p = 0; p < image.pixels.size(); p += 4)
+    {
+        image.pixels[p] = 10; image.pixels[p + 1] = 100; image.pixels[p + 2] = 200; image.pixels[p + 3] = 255;
+    }
+    for (auto filter : g_filters)
+    {
+        auto result = resample(image.view(), 11, 50, filter);
+
+        bool constant = true;
+        for (size_t p = 0; p < result.pixels.size(); p += 4)
+        {
+            constant &= result.pixels[p] == 10 && result.pixels[p + 1] == 100 && result.pixels[p + 2] == 200;
+        }
+        CHECK(constant);
+    }
+}
+
+D14_TEST(MipChainEndsAtOnePixel)
+{
+    auto chain = generateMipChain(Image(100, 37).view());
+
+    CHECK(mipLevelCount(100, 37) == 7);
+    CHECK(chain.size() == 6);
+    CHECK(chain.back().width == 1 && chain.back().height == 1);
+
+    CHECK(generateMipChain(Image(1, 1).view()).empty());
+}
+
+D14_TEST(BlurMatchesScalar)
+{
+    std::mt19937 rng(49);
+
+    bool matched = true, padded = true;
+    for (int i = 0; i < 100 && matched; ++i)
+    {
+        Mask mask(1 + rng() % 80, 1 + rng() % 80);
+        for (auto& coverage : mask.pixels) coverage = (uint8_t)rng();
+
+        // From the narrow kernels to the wider ones than the mask.
+        float stdDev = 0.3f + (float)(rng() % 100) / 8.0f;
+
+        auto simd = gaussianBlur(mask, stdDev);
+        matched &= simd.pixels == gaussianBlurScalar(mask, stdDev).pixels;
+
+        auto radius = gaussianRadius(stdDev);
+        padded &= simd.width == mask.width + 2 * radius && simd.height == mask.height + 2 * radius;
+    }
+    CHECK(matched);
+    CHECK(padded);
+}
+
+D14_TEST(BlurKeepsTheCoverage)
+{
+    Mask dot(1, 1);
+    dot.pixels[0] = 255;
+
+    auto blurred = gaussianBlur(dot, 2.0f);
+    CHECK(gaussianRadius(2.0f) == 6 && blurred.width == 13);
+
+    // The weights sum up to 1 (up to the rounding of each pixel), and the
+    // kernel is symmetric.
+    int sum = 0;
+    bool symmetric = true;
+    for (uint32_t y = 0; y < blurred.height; ++y)
+    {
+        for (uint32_t x = 0; x < blurred.width; ++x)
+        {
+            sum += blurred.row(y)[x];
+            symmetric &= blurred.row(y)[x] == blurred.row(x)[y];
+            symmetric &= blurred.row(y)[x] == blurred.row(y)[blurred.width - 1 - x];
+        }
+    }
+    CHECK(std::abs(sum - 255) <= 24 && symmetric);
+
+    // A full mask stays full away from its edges.
+    Mask full(40, 40);
+    std::fill(full.pixels.begin(), full.pixels.end(), (uint8_t)255);
+
+    auto center = gaussianBlur(full, 3.0f);
+    CHECK(center.row(center.height / 2)[center.width / 2] == 255);
+}
+
+D14_BENCH(Throughput4096)
+{
+    std::mt19937 rng(2033);
+
+    Image image(4096, 4096);
+    for (auto& byte : image.pixels) byte = (uint8_t)rng();
+
+    auto pixels = image.pixels;
+    printThroughput("premultiply sse2", unit_test::measure(1, [&] { premultiply(pixels.data(), 4096 * 4096); }));
+    printThroughput("premultiply scalar", unit_test::measure(1, [&] { premultiplyScalar(pixels.data(), 4096 * 4096); }));
+
+    printThroughput("halve sse2", unit_test::measure(1, [&] { unit_test::doNotOptimize(halve(image.view())); }));
+    printThroughput("halve scalar", unit_test::measure(1, [&] { unit_test::doNotOptimize(halveScalar(image.view())); }));
+
+    printThroughput("mitchell to 512 sse2", unit_test::measure(1, [&]
+    {
+        unit_test::doNotOptimize(resample(image.view(), 512, 512, Filter::Mitchell));
+    }));
+    printThroughput("mitchell to 512 scalar", unit_test::measure(1, [&]
+    {
+        unit_test::doNotOptimize(resampleScalar(image.view(), 512, 512, Filter::Mitchell));
+    }));
+    printThroughput("lanczos3 to 512 sse2", unit_test::measure(1, [&]
+    {
+        unit_test::doNotOptimize(resample(image.view(), 512, 512, Filter::Lanczos3));
+    }));
+    printThroughput("mip chain box", unit_test::measure(1, [&] { unit_test::doNotOptimize(generateMipChain(image.view())); }));
+
+    // The shadows are blurred at the sizes of the panels.
+    Mask mask(1024, 1024);
+    for (auto& coverage : mask.pixels) coverage = (uint8_t)rng();
+
+    std::printf("  %-24s %8.2f ms\n", "blur 1024 sigma 4 sse2", unit_test::measure(5, [&]
+    {
+        unit_test::doNotOptimize(gaussianBlur(mask, 4.0f));
+    }) / 1000.0);
+    std::printf("  %-24s %8.2f ms\n", "blur 1024 sigma 4 scalar", unit_test::measure(5, [&]
+    {
+        unit_test::doNotOptimize(gaussianBlurScalar(mask, 4.0f));
+    }) / 1000.0);
+}
@@ -0,0 +1,273 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Common/AtlasUtils/RectPacker.h"
+#include "Common/AtlasUtils/TextureAtlas.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::atlas_utils;
+
+namespace
+{
+    using Heuristic = MaxRectsPacker::Heuristic;
+
+    constexpr Heuristic g_heuristics[] =
+    {
+        Heuristic::BestShortSideFit, Heuristic::BestAreaFit, Heuristic::BottomLeft
+    };
+
+    // Each pixel encodes (seed, x, y) so that any misplaced copy shows.
+    pixel_utils::Image patternImage(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        pixel_utils::Image image(width, height);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                auto p = image.row(y) + x * 4;
+                p[0] = (uint8_t)seed; p[1] = (uint8_t)x; p[2] = (uint8_t)y; p[3] = 255;
+            }
+        }
+        return image;
+    }
+
+    using SourceMap = std::map<TextureAtlas::ID, pixel_utils::Image>;
+
+    // The slots (with the padding) stay in bounds and never overlap, and
+    // each one holds its pixels surrounded by the bleed of its edges.
+    bool isConsistent(const TextureAtlas& atlas, const SourceMap& sources)
+    {
+        auto atlasView = atlas.image().view();
+        std::vector<Rect> slots = {};
+
+        for (auto& [id, source] : sources)
+        {
+            auto rect = atlas.rect(id);
+            if (rect.width != source.width || rect.height != source.height) return false;
+
+            for (uint32_t y = 0; y < rect.height; ++y)
+            {
+                if (std::memcmp(atlasView.row(rect.y + y) + rect.x * 4, source.view().row(y), rect.width * 4)) return false;
+            }
+            for (uint32_t b = 1; b <= atlas.bleed(); ++b)
+            {
+                auto topLeft = atlasView.row(rect.y - b) + (rect.x - b) * 4;
+                auto bottomRight = atlasView.row(rect.bottom() - 1 + b) + (rect.right() - 1 + b) * 4;
+
+                if (std::memcmp(topLeft, source.view().row(0), 4)) return false;
+                if (std::memcmp(bottomRight, source.view().row(source.height - 1) + (source.width - 1) * 4, 4)) return false;
+            }
+            auto padding = atlas.padding();
+            Rect slot = { rect.x - padding, rect.y - padding, rect.width + 2 * padding, rect.height + 2 * padding };
+
+            if (slot.right() > atlas.width() || slot.bottom() > atlas.height()) return false;
+
+            for (auto& other : slots)
+            {
+                if (other.overlaps(slot)) return false;
+            }
+            slots.push_back(slot);
+
+            if (atlas.uvRect(id).left != (float)rect.x / (float)atlas.width()) return false;
+        }
+        return true;
+    }
+
+    void insertRandom(TextureAtlas& atlas, SourceMap& sources, std::mt19937& rng, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            auto image = patternImage(4 + rng() % 28, 4 + rng() % 28, i);
+            auto id = atlas.insert(image.view());
+            if (id.has_value()) sources[id.value()] = std::move(image);
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> randomSizes(uint32_t seed, size_t count)
+    {
+        std::mt19937 rng(seed);
+
+        std::vector<std::pair<uint32_t, uint32_t>> sizes(count);
+        for (auto& size : sizes) size = { 8 + rng() % 57, 8 + rng() % 57 };
+        return sizes;
+    }
+
+    // The occupancy when the first insertion fails.
+    double onlineOccupancy(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, Heuristic heuristic)
+    {
+        MaxRectsPacker packer(2048, 2048, heuristic);
+        for (auto& size : sizes)
+        {
+            if (!packer.insert(size.first, size.second)) break;
+        }
+        return packer.occupancy();
+    }
+
+    // The occupancy of the longest prefix that fits as one sorted batch.
+    double batchOccupancy(const std::vector<std::pair<uint32_t, uint32_t>>& sizes, Heuristic heuristic)
+    {
+        size_t low = 0, high = sizes.size();
+        while (low < high)
+        {
+            auto middle = (low + high + 1) / 2;
+
+            MaxRectsPacker packer(2048, 2048, heuristic);
+            if (packer.insertAll({ sizes.begin(), sizes.begin() + middle })) low = middle;
+            else high = middle - 1;
+        }
+        MaxRectsPacker packer(2048, 2048, heuristic);
+        packer.insertAll({ sizes.begin(), sizes.begin() + low });
+
+        return packer.occupancy();
+    }
+}
+
+D14_TEST(PackedRectsNeverOverlap)
+{
+    for (auto heuristic : g_heuristics)
+    {
+        MaxRectsPacker packer(512, 512, heuristic);
+        std::vector<Rect> rects = {};
+
+        std::mt19937 rng(37);
+        for (int i = 0; i < 2000; ++i)
+        {
+            auto rect = packer.insert(1 + rng() % 40, 1 + rng() % 40);
+            if (rect.has_value()) rects.push_back(rect.value());
+        }
+        bool disjoint = true;
+        uint64_t area = 0;
+
+        for (size_t i = 0; i < rects.size(); ++i)
+        {
+            disjoint &= rects[i].right() <= 512 && rects[i].bottom() <= 512;
+            for (size_t k = 0; k < i; ++k) disjoint &= !rects[i].overlaps(rects[k]);
+
+            area += rects[i].area();
+        }
+        CHECK(disjoint);
+        CHECK(area == packer.usedArea());
+
+        // The released space is not merged, but each hole is reusable.
+        for (auto& rect : rects) packer.release(rect);
+        CHECK(packer.usedArea() == 0);
+
+        bool reused = true;
+        for (auto& rect : rects) reused &= packer.insert(rect.width, rect.height).has_value();
+        CHECK(reused);
+    }
+}
+
+D14_TEST(BatchPlacesLargestFirst)
+{
+    MaxRectsPacker packer(64, 64);
+
+    CHECK(!packer.insertAll({ { 64, 64 }, { 1, 1 } }).has_value());
+
+    // The packer is reset after a failed batch.
+    packer.reset(64, 64);
+    CHECK(packer.usedArea() == 0);
+
+    auto rects = packer.insertAll({ { 32, 64 }, { 32, 32 }, { 32, 32 } });
+    CHECK(rects.has_value() && rects->size() == 3);
+    CHECK(packer.occupancy() == 1.0);
+}
+
+D14_TEST(AtlasKeepsPixelsAndBleed)
+{
+    std::mt19937 rng(370);
+
+    TextureAtlas atlas(512, 512, 2, 2);
+    SourceMap sources = {};
+
+    insertRandom(atlas, sources, rng, 400);
+    CHECK(isConsistent(atlas, sources));
+
+    CHECK(atlas.takeDirtyRect().has_value());
+    CHECK(!atlas.takeDirtyRect().has_value());
+
+    CHECK(!atlas.insert(pixel_utils::Image().view()).has_value());
+}
+
+D14_TEST(AtlasEraseRefillAndRepack)
+{
+    std::mt19937 rng(371);
+
+    TextureAtlas atlas(512, 512, 2, 2);
+    SourceMap sources = {};
+
+    insertRandom(atlas, sources, rng, 400);
+
+    // Erases every other entry and refills the holes.
+    int index = 0;
+    for (auto itor = sources.begin(); itor != sources.end();)
+    {
+        if (index++ % 2)
+        {
+            atlas.erase(itor->first);
+            CHECK(!atlas.contains(itor->first));
+
+            itor = sources.erase(itor);
+        }
+        else ++itor;
+    }
+    auto remaining = sources.size();
+
+    insertRandom(atlas, sources, rng, 400);
+    CHECK(sources.size() > remaining);
+    CHECK(isConsistent(atlas, sources));
+
+    auto generation = atlas.generation();
+    CHECK(atlas.repack());
+    CHECK(atlas.generation() == generation + 1);
+    CHECK(isConsistent(atlas, sources));
+
+    // A failed repack leaves the atlas as it was.
+    CHECK(!atlas.repack(64, 64));
+    CHECK(isConsistent(atlas, sources));
+
+    CHECK(atlas.repack(1024, 1024));
+    CHECK(atlas.width() == 1024 && isConsistent(atlas, sources));
+    CHECK(atlas.size() == sources.size());
+}
+
+D14_TEST(OccupancyOfRandomSprites)
+{
+    // Random 8..64 px sprites in a 2048 x 2048 atlas.
+    auto sizes = randomSizes(0, 6000);
+
+    CHECK(onlineOccupancy(sizes, Heuristic::BestShortSideFit) > 0.9);
+    CHECK(batchOccupancy(sizes, Heuristic::BestShortSideFit) > 0.95);
+}
+
+D14_BENCH(OccupancyAndInsertTime)
+{
+    for (auto heuristic : g_heuristics)
+    {
+        double online = 0.0, batch = 0.0, us = 0.0;
+        for (uint32_t seed = 0; seed < 5; ++seed)
+        {
+            auto sizes = randomSizes(seed, 6000);
+
+            size_t insertCount = 0;
+            us += unit_test::measure(1, [&]
+            {
+                MaxRectsPacker packer(2048, 2048, heuristic);
+                for (auto& size : sizes)
+                {
+                    if (!packer.insert(size.first, size.second)) break;
+                    ++insertCount;
+                }
+            })
+            / (double)insertCount;
+
+            online += onlineOccupancy(sizes, heuristic);
+            batch += batchOccupancy(sizes, heuristic);
+        }
+        std::printf("  heuristic %d: online %.1f%% (%.3f ms/insert), sorted batch %.1f%%\n",
+                    (int)heuristic, online / 5.0 * 100.0, us / 5.0 / 1000.0, batch / 5.0 * 100.0);
+    }
+}
@@ -0,0 +1,225 @@
+﻿#include "Common/Precompile.h"
+
+#include <numbers>
+#include <random>
+
+#include "Pipeline/2D/SpriteBatch.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::pipeline;
+
+namespace
+{
+    struct Submission
+    {
+        SpriteBatcher::TextureID texture = {};
+        SpriteBlend blend = {};
+        float depth = {};
+        uint32_t index = {};
+    };
+    using SubmissionArray = std::vector<Submission>;
+
+    // The order documented by SpriteBatcher, i.e. the reference of the
+    // radix sort: back to front, then by the blend and the texture.
+    void referenceSort(SubmissionArray& submissions)
+    {
+        std::stable_sort(submissions.begin(), submissions.end(), [](const Submission& lhs, const Submission& rhs)
+        {
+            if (lhs.depth != rhs.depth) return lhs.depth > rhs.depth;
+            if (lhs.blend != rhs.blend) return lhs.blend < rhs.blend;
+            return lhs.texture < rhs.texture;
+        });
+    }
+
+    // The color of each instance records its submission index.
+    SubmissionArray addRandomSprites(SpriteBatcher& batcher, std::mt19937& rng, size_t count, uint32_t depthCount)
+    {
+        SubmissionArray submissions(count);
+        batcher.reserve(count);
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto& submission = submissions[i];
+            submission.texture = rng() % 64;
+            submission.blend = (SpriteBlend)(rng() % g_spriteBlendCount);
+            submission.depth = (float)(rng() % depthCount) / 8.0f - 0.3f;
+            submission.index = i;
+
+            SpriteInstance instance = {};
+            instance.setTransform((float)i, 0.0f, 10.0f, 10.0f, 0.1f);
+            instance.depth = submission.depth;
+            instance.color = i;
+
+            batcher.add(submission.texture, submission.blend, instance);
+        }
+        return submissions;
+    }
+
+    // The instances follow the reference order, and the batches cover them
+    // contiguously with the texture and the blend of each instance.
+    bool matchesReference(
+        const SpriteBatcher::BatchArray& batches,
+        const std::vector<SpriteInstance>& instances,
+        const SubmissionArray& sorted)
+    {
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            if (instances[i].color != sorted[i].index) return false;
+        }
+        uint32_t total = 0;
+        for (auto& batch : batches)
+        {
+            if (batch.firstInstance != total || batch.instanceCount == 0) return false;
+
+            for (auto i = batch.firstInstance; i < batch.firstInstance + batch.instanceCount; ++i)
+            {
+                if (sorted[i].texture != batch.texture || sorted[i].blend != batch.blend) return false;
+            }
+            total += batch.instanceCount;
+        }
+        return total == sorted.size();
+    }
+}
+
+D14_TEST(MatchesStableSortReference)
+{
+    std::mt19937 rng(38);
+
+    for (uint32_t depthCount : { 1u, 2u, 16u })
+    {
+        for (size_t count : { 0, 1, 1000, 100000 })
+        {
+            SpriteBatcher batcher = {};
+            auto submissions = addRandomSprites(batcher, rng, count, depthCount);
+
+            std::vector<SpriteInstance> instances(count);
+            auto& batches = batcher.build(instances.data());
+
+            referenceSort(submissions);
+            CHECK(matchesReference(batches, instances, submissions));
+        }
+    }
+}
+
+D14_TEST(NegativeAndEqualDepths)
+{
+    SpriteBatcher batcher = {};
+
+    float depths[] = { -1.0f, 2.0f, 0.0f, -0.0f, 2.0f, -3.5f };
+    for (uint32_t i = 0; i < std::size(depths); ++i)
+    {
+        SpriteInstance instance = {};
+        instance.depth = depths[i];
+        instance.color = i;
+
+        batcher.add(0, SpriteBlend::Alpha, instance);
+    }
+    std::vector<SpriteInstance> instances(batcher.size());
+    auto& batches = batcher.build(instances.data());
+
+    // The equal depths (including +-0) keep the submission order.
+    std::vector<uint32_t> order = {};
+    for (auto& instance : instances) order.push_back(instance.color);
+
+    CHECK((order == std::vector<uint32_t>{ 1, 4, 2, 3, 0, 5 }));
+    CHECK(batches.size() == 1 && batches.front().instanceCount == 6);
+}
+
+D14_TEST(ClearKeepsNothing)
+{
+    std::mt19937 rng(380);
+
+    SpriteBatcher batcher = {};
+    addRandomSprites(batcher, rng, 1000, 4);
+
+    std::vector<SpriteInstance> instances(batcher.size());
+    batcher.build(instances.data());
+
+    batcher.clear();
+    CHECK(batcher.size() == 0);
+    CHECK(batcher.build(nullptr).empty());
+}
+
+D14_TEST(SetTransform)
+{
+    SpriteInstance instance = {};
+
+    instance.setTransform(5.0f, 6.0f, 2.0f, 4.0f, 0.0f);
+    CHECK(instance.m11 == 2.0f && instance.m22 == 4.0f);
+    CHECK(instance.m12 == 0.0f && instance.m21 == 0.0f);
+    CHECK(instance.dx == 5.0f && instance.dy == 6.0f);
+
+    // A quarter turn maps the x axis onto the y axis.
+    instance.setTransform(0.0f, 0.0f, 2.0f, 4.0f, std::numbers::pi_v<float> / 2.0f);
+    CHECK(std::abs(instance.m11) < 1e-6f && std::abs(instance.m12 - 2.0f) < 1e-6f);
+}
+
+D14_TEST(SetTransformFromWorldMatrix)
+{
+    auto nearlyEqual = [](const SpriteInstance& a, const SpriteInstance& b)
+    {
+        auto equal = [](float x, float y) { return std::abs(x - y) < 1e-4f; };
+
+        return equal(a.m11, b.m11) && equal(a.m12, b.m12) &&
+               equal(a.m21, b.m21) && equal(a.m22, b.m22) &&
+               equal(a.dx, b.dx) && equal(a.dy, b.dy) && equal(a.depth, b.depth);
+    };
+    TransformSystem transforms = {};
+
+    auto node = transforms.create();
+    transforms.setPosition(node, { 5.0f, 6.0f, 3.0f });
+    transforms.setRotation(node, TransformSystem::Quaternion::fromRollPitchYaw(0.0f, 0.0f, 0.7f));
+    transforms.setScaling(node, { 2.0f, 4.0f, 1.0f });
+    transforms.update();
+
+    SpriteInstance expected = {}, instance = {};
+    expected.setTransform(5.0f, 6.0f, 2.0f, 4.0f, 0.7f);
+    expected.depth = 3.0f;
+
+    instance.setTransform(transforms.worldMatrix(node));
+    CHECK(nearlyEqual(instance, expected));
+
+    // The parent moves and turns the sprite around its own origin.
+    auto parent = transforms.create();
+    transforms.setPosition(parent, { 10.0f, 0.0f, 1.0f });
+    transforms.setRotation(parent, TransformSystem::Quaternion::fromRollPitchYaw(0.0f, 0.0f, std::numbers::pi_v<float> / 2.0f));
+    CHECK(transforms.setParent(node, parent));
+    transforms.update();
+
+    expected.setTransform(10.0f - 6.0f, 5.0f, 2.0f, 4.0f, 0.7f + std::numbers::pi_v<float> / 2.0f);
+    expected.depth = 4.0f;
+
+    instance.setTransform(transforms.worldMatrix(node));
+    CHECK(nearlyEqual(instance, expected));
+}
+
+D14_BENCH(OneMillionSprites)
+{
+    std::mt19937 rng(2038);
+
+    // 16 depths x 3 blends x 64 textures, and a single depth.
+    for (uint32_t depthCount : { 16u, 1u })
+    {
+        constexpr size_t count = 1000000;
+
+        SpriteBatcher batcher = {};
+        auto submissions = addRandomSprites(batcher, rng, count, depthCount);
+
+        std::vector<SpriteInstance> instances(count);
+        size_t batchCount = 0;
+
+        // The steady state of a frame, where the buffers are reused.
+        double us = unit_test::measure(5, [&] { batchCount = batcher.build(instances.data()).size(); });
+
+        double referenceUs = unit_test::measure(5, [&]
+        {
+            auto sorted = submissions;
+            referenceSort(sorted);
+            unit_test::doNotOptimize(sorted);
+        });
+        std::printf("  %u depth(s): %zu batches, build %.2f ms, std::stable_sort %.2f ms\n",
+                    depthCount, batchCount, us / 1000.0, referenceUs / 1000.0);
+    }
+}
@@ -0,0 +1,289 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Pipeline/Data/TransformSystem.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::pipeline;
+
+namespace
+{
+    using Handle = TransformSystem::Handle;
+
+    struct Matrix { double m[4][4] = {}; };
+
+    // The row-vector local matrix, i.e. scaling * rotation * translation.
+    Matrix localMatrix(const TransformSystem& system, Handle node)
+    {
+        auto p = system.position(node);
+        auto q = system.rotation(node);
+        auto s = system.scaling(node);
+
+        double x = q.x, y = q.y, z = q.z, w = q.w;
+        double r[3][3] =
+        {
+            { 1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w) },
+            { 2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w) },
+            { 2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y) }
+        };
+        double scaling[3] = { s.x, s.y, s.z };
+
+        Matrix local = {};
+        for (int i = 0; i < 3; ++i)
+        {
+            for (int j = 0; j < 3; ++j) local.m[i][j] = r[i][j] * scaling[i];
+        }
+        local.m[3][0] = p.x; local.m[3][1] = p.y; local.m[3][2] = p.z; local.m[3][3] = 1.0;
+
+        return local;
+    }
+
+    Matrix multiply(const Matrix& a, const Matrix& b)
+    {
+        Matrix result = {};
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+            {
+                for (int k = 0; k < 4; ++k) result.m[i][j] += a.m[i][k] * b.m[k][j];
+            }
+        }
+        return result;
+    }
+
+    // The double-precision reference that walks up to the root.
+    Matrix worldMatrix(const TransformSystem& system, Handle node)
+    {
+        auto local = localMatrix(system, node);
+        auto parent = system.parent(node);
+
+        return parent == TransformSystem::g_invalidHandle ? local : multiply(local, worldMatrix(system, parent));
+    }
+
+    double maxRelativeError(const TransformSystem& system, const std::vector<Handle>& nodes)
+    {
+        double error = 0.0;
+        for (auto node : nodes)
+        {
+            auto expected = worldMatrix(system, node);
+            auto& actual = system.worldMatrix(node);
+
+            for (int i = 0; i < 4; ++i)
+            {
+                for (int j = 0; j < 4; ++j)
+                {
+                    auto e = expected.m[i][j];
+                    error = std::max(error, std::abs(e - actual.m[i][j]) / (1.0 + std::abs(e)));
+                }
+            }
+        }
+        return error;
+    }
+
+    void randomize(TransformSystem& system, Handle node, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        system.setPosition(node, { unit(rng) * 10.0f, unit(rng) * 10.0f, unit(rng) * 10.0f });
+        system.setRotation(node, TransformSystem::Quaternion::fromRollPitchYaw(unit(rng) * 3.0f, unit(rng) * 3.0f, unit(rng) * 3.0f));
+        system.setScaling(node, { 1.0f + unit(rng) * 0.3f, 1.0f + unit(rng) * 0.3f, 1.0f + unit(rng) * 0.3f });
+    }
+
+    // 1000 roots, each of which has 99 groups of 9 leaves.
+    std::vector<Handle> createForest(TransformSystem& system, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        std::vector<Handle> nodes = {};
+        nodes.reserve(1000000);
+
+        for (int r = 0; r < 1000; ++r)
+        {
+            auto root = system.create();
+            nodes.push_back(root);
+
+            auto group = root;
+            for (int k = 0; k < 999; ++k)
+            {
+                auto node = system.create(k % 10 == 0 ? root : group);
+                if (k % 10 == 0) group = node;
+
+                nodes.push_back(node);
+            }
+        }
+        for (auto node : nodes) system.setPosition(node, { unit(rng), unit(rng), unit(rng) });
+
+        return nodes;
+    }
+}
+
+D14_TEST(MatchesReferenceThroughRandomEdits)
+{
+    std::mt19937 rng(40);
+
+    TransformSystem system = {};
+    std::vector<Handle> nodes = {};
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto parent = (nodes.empty() || rng() % 5 == 0) ? TransformSystem::g_invalidHandle : nodes[rng() % nodes.size()];
+        nodes.push_back(system.create(parent));
+        randomize(system, nodes.back(), rng);
+    }
+    CHECK(system.update() == 2000);
+    CHECK(maxRelativeError(system, nodes) < 1e-4);
+
+    // Each round edits, reparents, destroys or creates 20 nodes.
+    for (int round = 0; round < 50; ++round)
+    {
+        auto operation = rng() % 4;
+        for (int k = 0; k < 20; ++k)
+        {
+            auto node = nodes[rng() % nodes.size()];
+
+            if (operation == 0) randomize(system, node, rng);
+            else if (operation == 1)
+            {
+                // Rejected if it makes a cycle.
+                system.setParent(node, rng() % 4 ? nodes[rng() % nodes.size()] : TransformSystem::g_invalidHandle);
+            }
+            else if (operation == 2 && nodes.size() > 100)
+            {
+                system.destroy(node);
+                CHECK(!system.isValid(node));
+
+                nodes.erase(std::find(nodes.begin(), nodes.end(), node));
+            }
+            else
+            {
+                nodes.push_back(system.create(rng() % 2 ? node : TransformSystem::g_invalidHandle));
+                randomize(system, nodes.back(), rng);
+            }
+        }
+        system.update();
+
+        if (!CHECK(maxRelativeError(system, nodes) < 1e-4)) break;
+    }
+    CHECK(system.size() == nodes.size());
+}
+
+D14_TEST(OnlyDirtySubtreesUpdate)
+{
+    TransformSystem system = {};
+
+    auto root = system.create();
+    auto child = system.create(root);
+    auto grandchild = system.create(child);
+    auto other = system.create();
+
+    CHECK(system.update() == 4);
+    CHECK(system.update() == 0);
+
+    system.setPosition(child, { 1.0f, 2.0f, 3.0f });
+    CHECK(system.isDirty(child) && !system.isDirty(root));
+
+    // The child and its descendant.
+    CHECK(system.update() == 2);
+    CHECK(system.worldMatrix(grandchild).m[3][0] == 1.0f);
+
+    system.setParent(grandchild, other);
+    CHECK(system.update() == 1);
+    CHECK(system.worldMatrix(grandchild).m[3][0] == 0.0f);
+}
+
+D14_TEST(CyclesAreRejected)
+{
+    TransformSystem system = {};
+
+    auto a = system.create();
+    auto b = system.create(a);
+    auto c = system.create(b);
+
+    CHECK(!system.setParent(a, c));
+    CHECK(!system.setParent(a, a));
+    CHECK(system.parent(a) == TransformSystem::g_invalidHandle);
+
+    CHECK(system.setParent(c, a));
+    CHECK(system.parent(c) == a);
+}
+
+D14_TEST(DestroyKeepsChildrenWithGrandparent)
+{
+    TransformSystem system = {};
+
+    auto root = system.create();
+    auto middle = system.create(root);
+    auto leaf = system.create(middle);
+
+    system.setPosition(root, { 5.0f, 0.0f, 0.0f });
+    system.setPosition(middle, { 7.0f, 0.0f, 0.0f });
+    system.update();
+
+    system.destroy(middle);
+    CHECK(system.parent(leaf) == root);
+
+    system.update();
+    CHECK(system.worldMatrix(leaf).m[3][0] == 5.0f);
+
+    // The handle of a destroyed node is recycled as a new root.
+    auto recycled = system.create();
+    CHECK(recycled == middle && system.parent(recycled) == TransformSystem::g_invalidHandle);
+}
+
+D14_TEST(YawTurnsZToX)
+{
+    TransformSystem system = {};
+
+    auto node = system.create();
+    system.setRotation(node, TransformSystem::Quaternion::fromRollPitchYaw(0.0f, std::acos(-1.0f) / 2.0f, 0.0f));
+    system.update();
+
+    auto& m = system.worldMatrix(node).m;
+    CHECK(std::abs(m[2][0] - 1.0f) < 1e-6f && std::abs(m[2][1]) < 1e-6f && std::abs(m[2][2]) < 1e-6f);
+}
+
+D14_BENCH(OneMillionNodes)
+{
+    std::mt19937 rng(2040);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    TransformSystem system = {};
+    auto nodes = createForest(system, rng);
+
+    system.update();
+
+    double us = unit_test::measure(3, [&]
+    {
+        for (auto node : nodes) system.setRotation(node, { 0.0f, 0.0f, 0.1f, 0.99f });
+        system.update();
+    });
+    std::printf("  all dirty (with the setters): %.2f ms\n", us / 1000.0);
+
+    for (size_t i = 5; i < nodes.size(); i += 10)
+    {
+        system.setPosition(nodes[i], { unit(rng), unit(rng), unit(rng) });
+    }
+    size_t count = 0;
+    us = unit_test::measure(1, [&] { count = system.update(); });
+    std::printf("  10%% of the leaves touched: %.2f ms (%zu nodes)\n", us / 1000.0, count);
+
+    us = unit_test::measure(100, [&] { count = system.update(); });
+    std::printf("  nothing dirty: %.3f us\n", us);
+
+    // Composes one matrix at a time in the creation order (parents first).
+    std::vector<Matrix> worlds(nodes.size());
+    us = unit_test::measure(1, [&]
+    {
+        for (auto node : nodes)
+        {
+            auto local = localMatrix(system, node);
+            auto parent = system.parent(node);
+
+            worlds[node] = parent == TransformSystem::g_invalidHandle ? local : multiply(local, worlds[parent]);
+        }
+    });
+    std::printf("  naive one at a time (double): %.2f ms\n", us / 1000.0);
+}
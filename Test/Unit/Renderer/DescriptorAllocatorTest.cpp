@@ -0,0 +1,226 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/DescriptorAllocator.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using Range = DescriptorAllocator::Range;
+
+    // Simulates a GPU that completes each frame a few frames later.
+    struct FakeFence
+    {
+        DescriptorAllocator& allocator;
+
+        size_t latency = 3;
+
+        uint64_t value = 0;
+        std::deque<uint64_t> inflight = {};
+
+        void endFrame()
+        {
+            allocator.endFrame(++value);
+            inflight.push_back(value);
+
+            while (inflight.size() > latency) complete();
+        }
+        void complete()
+        {
+            allocator.reclaim(inflight.front());
+            inflight.pop_front();
+        }
+        void flush()
+        {
+            while (!inflight.empty()) complete();
+        }
+    };
+
+    // Marks the slots of each live range, which must not be taken twice.
+    struct Occupancy
+    {
+        std::vector<uint8_t> slots = {};
+
+        explicit Occupancy(uint32_t capacity) : slots(capacity) { }
+
+        bool take(const Range& range)
+        {
+            for (uint32_t i = range.offset; i < range.offset + range.count; ++i)
+            {
+                if (slots[i]) return false;
+                slots[i] = 1;
+            }
+            return true;
+        }
+        void release(const Range& range)
+        {
+            std::fill_n(slots.begin() + range.offset, range.count, (uint8_t)0);
+        }
+    };
+}
+
+D14_TEST(PersistentBestFitAndCoalescing)
+{
+    DescriptorAllocator allocator(1000, 200);
+
+    auto a = allocator.allocate(100), b = allocator.allocate(50), c = allocator.allocate(100);
+    if (!CHECK(a && b && c)) return;
+
+    CHECK(a->offset == 0 && b->offset == 100 && c->offset == 150);
+
+    // The freed range is not reusable until its frame has completed.
+    allocator.free(*b);
+    allocator.endFrame(1);
+
+    CHECK(allocator.statistics().pendingFree == 50);
+    CHECK(allocator.allocate(550)->offset == 250);
+    CHECK(!allocator.allocate(50).has_value());
+
+    allocator.reclaim(0);
+    CHECK(!allocator.allocate(50).has_value());
+
+    allocator.reclaim(1);
+    auto d = allocator.allocate(50);
+    CHECK(d && d->offset == 100);
+
+    // Everything freed coalesces into one range.
+    for (auto& range : { *a, *c, *d, Range{ 250, 550 } }) allocator.free(range);
+    allocator.endFrame(2);
+    allocator.reclaim(2);
+
+    auto statistics = allocator.statistics();
+    CHECK(statistics.persistentUsed == 0 && statistics.freeRangeCount == 1);
+    CHECK(statistics.largestFreeRange == 800 && statistics.fragmentation() == 0.0f);
+}
+
+D14_TEST(RingStaysInItsRegion)
+{
+    std::mt19937 rng(42);
+
+    for (size_t latency : { 1, 3 })
+    {
+        DescriptorAllocator allocator(1000, 200);
+        FakeFence fence = { allocator, latency };
+
+        bool inRegion = true, bounded = true;
+        size_t failedCount = 0;
+
+        for (int frame = 0; frame < 10000; ++frame)
+        {
+            for (int k = 0; k < 5; ++k)
+            {
+                auto range = allocator.allocateTransient(1 + rng() % 15);
+                if (range.has_value())
+                {
+                    inRegion &= range->offset >= 800 && range->offset + range->count <= 1000;
+                }
+                else ++failedCount;
+            }
+            fence.endFrame();
+
+            bounded &= allocator.statistics().ringUsed <= 200;
+        }
+        CHECK(inRegion && bounded);
+
+        // 2 frames of at most 75 slots (plus the skipped ones) always fit,
+        // while 4 frames in flight exhaust the ring from time to time.
+        CHECK(latency == 1 ? failedCount == 0 : failedCount > 0);
+
+        fence.flush();
+        CHECK(allocator.statistics().ringUsed == 0);
+
+        // A transient range never takes the persistent region.
+        CHECK(allocator.allocate(800).has_value() && !allocator.allocate(1).has_value());
+        CHECK(!allocator.allocateTransient(201).has_value());
+    }
+}
+
+D14_TEST(RandomPersistentAgainstOccupancy)
+{
+    DescriptorAllocator allocator(4096);
+    FakeFence fence = { allocator, 2 };
+    Occupancy occupancy(4096);
+
+    std::mt19937 rng(420);
+    std::vector<Range> live = {};
+
+    // The frees of the frames in flight are still taken in the occupancy.
+    std::deque<std::vector<Range>> pending = {};
+    pending.emplace_back();
+
+    bool disjoint = true;
+    for (int i = 0; i < 200000; ++i)
+    {
+        if (live.empty() || rng() % 2)
+        {
+            auto range = allocator.allocate(1 + rng() % 32);
+            if (range.has_value())
+            {
+                disjoint &= occupancy.take(*range);
+                live.push_back(*range);
+            }
+        }
+        else
+        {
+            auto k = rng() % live.size();
+            auto range = live[k];
+
+            live[k] = live.back();
+            live.pop_back();
+
+            allocator.free(range);
+            pending.back().push_back(range);
+        }
+        if (i % 7 == 0)
+        {
+            fence.endFrame();
+            pending.emplace_back();
+
+            while (pending.size() > fence.inflight.size() + 1)
+            {
+                for (auto& range : pending.front()) occupancy.release(range);
+                pending.pop_front();
+            }
+        }
+    }
+    CHECK(disjoint);
+
+    for (auto& range : live) allocator.free(range);
+    fence.endFrame();
+    fence.flush();
+
+    auto statistics = allocator.statistics();
+    CHECK(statistics.persistentUsed == 0 && statistics.pendingFree == 0);
+    CHECK(statistics.freeRangeCount == 1 && statistics.largestFreeRange == 4096);
+}
+
+D14_BENCH(AllocateAndFree)
+{
+    DescriptorAllocator allocator(16384, 4096);
+    FakeFence fence = { allocator };
+
+    std::mt19937 rng(2042);
+    std::vector<Range> live = {};
+
+    // A steady state of about 1000 textures and 64 transient views per frame.
+    for (int i = 0; i < 1000; ++i) live.push_back(allocator.allocate(1 + rng() % 8).value());
+
+    double us = unit_test::measure(10000, [&]
+    {
+        auto k = rng() % live.size();
+        allocator.free(live[k]);
+        live[k] = allocator.allocate(1 + rng() % 8).value();
+
+        for (int i = 0; i < 64; ++i) unit_test::doNotOptimize(allocator.allocateTransient(1));
+
+        fence.endFrame();
+    });
+    auto statistics = allocator.statistics();
+    std::printf("  frame (1 free, 1 allocate, 64 transient): %.3f us, %u free ranges, fragmentation %.3f\n",
+                us, statistics.freeRangeCount, statistics.fragmentation());
+}
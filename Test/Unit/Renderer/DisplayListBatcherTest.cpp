@@ -0,0 +1,227 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/DisplayListBatcher.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using List = DisplayList;
+
+    // A tiny raster where each draw paints its pixel-aligned bounds with
+    // a hash depending on the order, so any reordered overlap shows.
+    struct HashRaster : List::IBackend
+    {
+        const List* list = nullptr;
+
+        constexpr static int g_size = 64;
+        std::array<std::array<int, g_size>, g_size> pixels = {};
+
+        List::Matrix transform = {};
+
+        void paint(const List::Rect& rect, int value)
+        {
+            auto& m = transform;
+            float xs[4] = {}, ys[4] = {};
+
+            List::Point corners[4] =
+            {
+                { rect.left, rect.top }, { rect.right, rect.top }, { rect.left, rect.bottom }, { rect.right, rect.bottom }
+            };
+            for (int i = 0; i < 4; ++i)
+            {
+                xs[i] = corners[i].x * m.m11 + corners[i].y * m.m21 + m.dx;
+                ys[i] = corners[i].x * m.m12 + corners[i].y * m.m22 + m.dy;
+            }
+            auto x0 = std::max(0, (int)std::floor(*std::min_element(xs, xs + 4)));
+            auto x1 = std::min(g_size, (int)std::ceil(*std::max_element(xs, xs + 4)));
+            auto y0 = std::max(0, (int)std::floor(*std::min_element(ys, ys + 4)));
+            auto y1 = std::min(g_size, (int)std::ceil(*std::max_element(ys, ys + 4)));
+
+            for (int y = y0; y < y1; ++y)
+            {
+                for (int x = x0; x < x1; ++x) pixels[y][x] = pixels[y][x] * 31 + value;
+            }
+        }
+        void setTransform(const List::SetTransform& command) override { transform = command.transform; }
+
+        void clear(const List::Clear& command) override
+        {
+            for (auto& row : pixels)
+            {
+                for (auto& pixel : row) pixel = pixel * 7 + 1;
+            }
+        }
+        void fillRect(const List::FillRect& command) override
+        {
+            paint(command.rect, (int)(command.brush.color.r * 100) + 1);
+        }
+        void drawBitmap(const List::DrawBitmap& command) override
+        {
+            paint(command.destination, 1000 + (int)command.bitmap);
+        }
+        void drawTextLayout(const List::DrawTextLayout& command) override
+        {
+            auto& b = list->resource(command.layout)->bounds;
+            auto& o = command.origin;
+
+            paint({ b.left + o.x, b.top + o.y, b.right + o.x, b.bottom + o.y }, 5000 + (int)(command.brush.color.r * 100));
+        }
+    };
+
+    // Rects, bitmaps and texts in 4 colors, mixed with the transforms,
+    // the clips and the clears.
+    List randomList(std::mt19937& rng, size_t count, float extent = 60.0f)
+    {
+        List list = {};
+
+        auto text = list.addResource((void*)1, { .type = List::ResourceType::TextLayout, .bounds = { -1, -1, 12, 6 } });
+
+        if (rng() % 3) list.record(List::SetTransform{});
+
+        std::uniform_real_distribution<float> position(0.0f, extent);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto k = rng() % 100;
+
+            float x = std::floor(position(rng)), y = std::floor(position(rng));
+            float w = (float)(1 + rng() % 8), h = (float)(1 + rng() % 8);
+
+            List::Brush brush = { .color = { (float)(rng() % 4) / 10.0f, 0, 0, 1 } };
+
+            if (k < 50) list.record(List::FillRect{ .rect = { x, y, x + w, y + h }, .brush = brush });
+            else if (k < 65) list.record(List::DrawBitmap{ .bitmap = (List::ResourceID)(rng() % 3), .destination = { x, y, x + w, y + h } });
+            else if (k < 78) list.record(List::DrawTextLayout{ .layout = text, .origin = { x, y }, .brush = brush });
+            else if (k < 90) list.record(List::SetTransform{ .transform = { 1, 0, 0, 1, (float)(rng() % 4), (float)(rng() % 4) } });
+            else if (k < 93) list.record(List::SetTransform{ .transform = { 0.7f, 0.7f, -0.7f, 0.7f, 20, 0 } });
+            else if (k < 95) list.record(List::Clear{});
+            else if (k < 97) list.record(List::PushClip{ .rect = { 0, 0, 30, 30 } });
+            else list.record(List::PopClip{});
+        }
+        return list;
+    }
+
+    bool rastersEqual(const List& a, const List& b)
+    {
+        HashRaster rasterA = {}, rasterB = {};
+        rasterA.list = &a;
+        rasterB.list = &b;
+
+        a.replay(rasterA);
+        b.replay(rasterB);
+
+        return rasterA.pixels == rasterB.pixels;
+    }
+}
+
+D14_TEST(RandomListsKeepTheOutput)
+{
+    std::mt19937 rng(48);
+
+    size_t changesBefore = 0, changesAfter = 0;
+    bool verified = true, equal = true;
+
+    for (int i = 0; i < 3000; ++i)
+    {
+        auto list = randomList(rng, rng() % 200);
+
+        DisplayListBatcher batcher = {};
+        batcher.window = 1 + rng() % 64;
+
+        std::vector<size_t> order = {};
+        auto batched = batcher.run(list, &order);
+
+        verified &= batcher.verify(list, batched, order);
+        equal &= rastersEqual(list, batched);
+
+        changesBefore += DisplayListBatcher::countStateChanges(list);
+        changesAfter += DisplayListBatcher::countStateChanges(batched);
+
+        if (!verified || !equal) break;
+    }
+    CHECK(verified && equal);
+    CHECK(changesAfter < changesBefore);
+}
+
+D14_TEST(VerifyCatchesSwappedOverlaps)
+{
+    List list = {};
+    list.record(List::SetTransform{});
+    list.record(List::FillRect{ .rect = { 0, 0, 10, 10 } });
+    list.record(List::FillRect{ .rect = { 5, 5, 10, 10 }, .brush = { .color = { 1, 0, 0, 1 } } });
+
+    List swapped = {};
+    swapped.assignResources(list);
+    swapped.record(List::SetTransform{});
+    swapped.append(list, 2);
+    swapped.append(list, 1);
+
+    DisplayListBatcher batcher = {};
+    CHECK(!batcher.verify(list, swapped, { 2, 1 }));
+
+    // The transforms are not in the order.
+    std::vector<size_t> order = {};
+    auto batched = batcher.run(list, &order);
+    CHECK(batcher.verify(list, batched, order));
+    CHECK(order == (std::vector<size_t>{ 1, 2 }));
+}
+
+D14_TEST(DisjointDrawsAreGrouped)
+{
+    // Alternating colors in a row of separate cells.
+    List list = {};
+    list.record(List::SetTransform{});
+
+    for (int i = 0; i < 10; ++i)
+    {
+        float x = 10.0f * (float)i;
+        list.record(List::FillRect{ .rect = { x, 0, x + 5, 5 }, .brush = { .color = { (float)(i % 2), 0, 0, 1 } } });
+    }
+    DisplayListBatcher batcher = {};
+
+    std::vector<size_t> order = {};
+    auto batched = batcher.run(list, &order);
+
+    auto& statistics = batcher.statistics();
+    CHECK(statistics.draws == 10 && statistics.batches == 2);
+    CHECK(statistics.movedDraws == 4);
+
+    // Setting the first transform counts as well.
+    CHECK(DisplayListBatcher::countStateChanges(list) == 1 + 9);
+    CHECK(DisplayListBatcher::countStateChanges(batched) == 1 + 1);
+    CHECK(batcher.verify(list, batched, order));
+
+    // The draws under the inherited transform are never moved.
+    List inherited = {};
+    for (size_t i = 1; i < list.commandCount(); ++i) inherited.append(list, i);
+
+    batcher.run(inherited);
+    CHECK(batcher.statistics().batches == 0 && batcher.statistics().barriers == 10);
+}
+
+D14_BENCH(BatchLargeLists)
+{
+    std::mt19937 rng(2048);
+
+    for (size_t window : { 16, 64, 256 })
+    {
+        // About 100k commands spread over a 2000 x 2000 target.
+        auto list = randomList(rng, 100000, 2000.0f);
+
+        DisplayListBatcher batcher = {};
+        batcher.window = window;
+
+        size_t before = DisplayListBatcher::countStateChanges(list), after = 0;
+
+        double us = unit_test::measure(3, [&]
+        {
+            after = DisplayListBatcher::countStateChanges(batcher.run(list));
+        });
+        std::printf("  window %zu: %.2f ms, state changes %zu -> %zu\n", window, us / 1000.0, before, after);
+    }
+}
@@ -0,0 +1,246 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/DisplayList.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using List = DisplayList;
+
+    struct TempFile
+    {
+        std::filesystem::path path = {};
+
+        explicit TempFile(WstrRefer name) : path(std::filesystem::temp_directory_path() / name) { }
+
+        ~TempFile() { std::error_code ec = {}; std::filesystem::remove(path, ec); }
+    };
+
+    std::vector<char> readBytes(const std::filesystem::path& path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        return { std::istreambuf_iterator<char>(stream), {} };
+    }
+
+    void writeBytes(const std::filesystem::path& path, const std::vector<char>& bytes)
+    {
+        std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+        stream.write(bytes.data(), (std::streamsize)bytes.size());
+    }
+
+    // A frame like that of a window of panels: the rows of a list view,
+    // each with a background, an icon, a label and a separator.
+    List uiFrame(size_t rowCount)
+    {
+        List list = {};
+
+        auto icon = list.addResource((void*)0x10, { .type = List::ResourceType::Bitmap, .bounds = { 0, 0, 16, 16 } });
+        auto font = list.addResource((void*)0x20, { .type = List::ResourceType::TextLayout, .bounds = { 0, 0, 200, 20 }, .name = L"Segoe UI", .fontSize = 14 });
+        auto check = list.addResource((void*)0x30, { .type = List::ResourceType::Geometry, .bounds = { 0, 0, 12, 12 } });
+
+        list.record(List::SetTarget{}, 500);
+        list.record(List::Clear{ .color = { 1, 1, 1, 1 } }, 2000);
+
+        for (size_t i = 0; i < rowCount; ++i)
+        {
+            float top = 24.0f * (float)i;
+
+            list.record(List::PushClip{ .rect = { 0, top, 400, top + 24 } }, 100);
+            list.record(List::FillRoundedRect{ .rect = { 2, top, 398, top + 22 }, .radiusX = 4, .radiusY = 4, .brush = { .color = { 0.9f, 0.9f, 0.9f, 1 } } }, 800);
+            list.record(List::DrawBitmap{ .bitmap = icon, .destination = { 4, top + 4, 20, top + 20 } }, 1500);
+            list.record(List::DrawTextLayout{ .layout = font, .origin = { 24, top + 2 }, .brush = { .color = { 0, 0, 0, 1 } } }, 20000 + i % 7 * 1000);
+
+            if (i % 3 == 0)
+            {
+                list.record(List::FillGeometry{ .geometry = check, .brush = { .color = { 0, 0.5f, 1, 1 } } }, 3000);
+            }
+            list.record(List::DrawLine{ .point0 = { 0, top + 23 }, .point1 = { 400, top + 23 }, .brush = { .color = { 0.8f, 0.8f, 0.8f, 1 } } }, 300);
+            list.record(List::PopClip{}, 50);
+        }
+        return list;
+    }
+
+    bool sameCommands(const List& a, const List& b)
+    {
+        if (a.commandCount() != b.commandCount()) return false;
+
+        for (size_t i = 0; i < a.commandCount(); ++i)
+        {
+            if (a.typeOf(i) != b.typeOf(i) || a.durationOf(i) != b.durationOf(i)) return false;
+
+            auto size = List::payloadSizeOf(a.typeOf(i));
+            if (size > 0 && std::memcmp(a.payloadOf(i), b.payloadOf(i), size)) return false;
+        }
+        return true;
+    }
+
+    // Checks the resource references like a backend would.
+    struct CheckingBackend : List::IBackend
+    {
+        const List* list = nullptr;
+
+        size_t commandCount = 0, missingCount = 0;
+
+        void refer(List::ResourceID id)
+        {
+            ++commandCount;
+            if (id != List::g_nullResource && list->resource(id) == nullptr) ++missingCount;
+        }
+        void setTarget(const List::SetTarget& command) override { refer(command.target); }
+        void fillRect(const List::FillRect& command) override { refer(command.brush.resource); }
+        void drawLine(const List::DrawLine& command) override { refer(command.strokeStyle); }
+        void drawBitmap(const List::DrawBitmap& command) override { refer(command.bitmap); }
+        void drawTextLayout(const List::DrawTextLayout& command) override { refer(command.layout); }
+        void fillGeometry(const List::FillGeometry& command) override { refer(command.geometry); }
+        void drawImage(const List::DrawImage& command) override { refer(command.image); }
+    };
+}
+
+D14_TEST(SaveLoadRoundTrip)
+{
+    TempFile file(L"D14DisplayListTest.d14l");
+
+    auto list = uiFrame(100);
+    CHECK(list.findResource((void*)0x20) == 1u);
+    CHECK(!list.findResource((void*)0x40).has_value());
+
+    if (!CHECK(list.save(file.path))) return;
+
+    List loaded = {};
+    if (!CHECK(loaded.load(file.path))) return;
+
+    CHECK(sameCommands(list, loaded));
+
+    // The descriptions are kept, while the live objects are not.
+    auto font = loaded.resource(1);
+    CHECK(font != nullptr && font->name == L"Segoe UI" && font->fontSize == 14.0f);
+    CHECK(font->object == nullptr && loaded.resource(List::g_nullResource) == nullptr);
+
+    CHECK(loaded.commandAt<List::FillRoundedRect>(3) != nullptr);
+    CHECK(loaded.commandAt<List::FillRect>(3) == nullptr);
+    CHECK(loaded.commandAt<List::DrawTextLayout>(5)->origin.y == 2.0f);
+}
+
+D14_TEST(StatisticsAndAppend)
+{
+    auto list = uiFrame(30);
+    auto statistics = list.statistics();
+
+    auto& text = statistics.commands[(size_t)List::CommandType::DrawTextLayout];
+    CHECK(text.count == 30 && text.maxDuration == 26000);
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < list.commandCount(); ++i) total += list.durationOf(i);
+    CHECK(statistics.totalDuration == total);
+
+    // Copies the draws in reverse with the same resource table.
+    List reversed = {};
+    reversed.assignResources(list);
+
+    for (size_t i = list.commandCount(); i-- > 0;) reversed.append(list, i);
+
+    CHECK(reversed.commandCount() == list.commandCount());
+    CHECK(reversed.statistics().totalDuration == total);
+    CHECK(reversed.typeOf(0) == List::CommandType::PopClip);
+    CHECK(reversed.commandAt<List::SetTarget>(reversed.commandCount() - 1) != nullptr);
+}
+
+D14_TEST(RejectsCorruptedFiles)
+{
+    TempFile file(L"D14DisplayListTest.d14l");
+    TempFile corrupted(L"D14DisplayListCorrupted.d14l");
+
+    auto list = uiFrame(20);
+    if (!CHECK(list.save(file.path))) return;
+
+    auto bytes = readBytes(file.path);
+
+    // Truncated at every length.
+    bool rejected = true;
+    for (size_t size = 0; size < bytes.size(); size += 7)
+    {
+        writeBytes(corrupted.path, { bytes.begin(), bytes.begin() + size });
+
+        List loaded = {};
+        rejected &= !loaded.load(corrupted.path) && loaded.empty() && loaded.resources().empty();
+    }
+    CHECK(rejected);
+
+    List missing = {};
+    CHECK(!missing.load(std::filesystem::temp_directory_path() / L"D14DisplayListMissing.d14l"));
+}
+
+D14_TEST(FuzzRandomBytes)
+{
+    TempFile file(L"D14DisplayListTest.d14l");
+    TempFile fuzzed(L"D14DisplayListFuzzed.d14l");
+
+    auto list = uiFrame(20);
+    if (!CHECK(list.save(file.path))) return;
+
+    auto bytes = readBytes(file.path);
+
+    std::mt19937 rng(47);
+
+    // Whatever loads must replay without touching anything out of range
+    // (most useful under ASan/UBSan).
+    size_t loadedCount = 0;
+    bool consistent = true;
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto copy = bytes;
+        for (int k = 1 + rng() % 8; k > 0; --k)
+        {
+            copy[rng() % copy.size()] = (char)rng();
+        }
+        writeBytes(fuzzed.path, copy);
+
+        List loaded = {};
+        if (!loaded.load(fuzzed.path))
+        {
+            consistent &= loaded.empty();
+            continue;
+        }
+        ++loadedCount;
+
+        CheckingBackend backend = {};
+        backend.list = &loaded;
+        loaded.replay(backend);
+
+        unit_test::doNotOptimize(loaded.statistics());
+        consistent &= loaded.commandCount() == list.commandCount();
+    }
+    CHECK(consistent);
+
+    // Most of the flips land in the payloads, which stay loadable.
+    CHECK(loadedCount > 0);
+}
+
+D14_BENCH(RecordSaveLoadReplay)
+{
+    TempFile file(L"D14DisplayListBench.d14l");
+
+    // About 100k commands, i.e. a heavy frame of 16k rows.
+    List list = {};
+    double us = unit_test::measure(1, [&] { list = uiFrame(16000); });
+    std::printf("  record %zu commands: %.2f ms\n", list.commandCount(), us / 1000.0);
+
+    us = unit_test::measure(5, [&] { list.save(file.path); });
+    std::printf("  save: %.2f ms (%.1f MB)\n", us / 1000.0, std::filesystem::file_size(file.path) / 1048576.0);
+
+    List loaded = {};
+    us = unit_test::measure(5, [&] { loaded.load(file.path); });
+    std::printf("  load: %.2f ms\n", us / 1000.0);
+
+    CheckingBackend backend = {};
+    backend.list = &loaded;
+    us = unit_test::measure(20, [&] { loaded.replay(backend); });
+    std::printf("  null replay: %.2f ms\n", us / 1000.0);
+}
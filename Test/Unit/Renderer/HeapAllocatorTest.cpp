@@ -0,0 +1,282 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/HeapAllocator.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using Allocation = TlsfAllocator::Allocation;
+
+    // offset -> size of the live allocations
+    using OccupancyMap = std::map<uint64_t, uint64_t>;
+
+    bool isDisjoint(const OccupancyMap& occupancy, const Allocation& allocation)
+    {
+        auto itor = occupancy.lower_bound(allocation.offset);
+        if (itor != occupancy.end() && itor->first < allocation.offset + allocation.size) return false;
+
+        if (itor != occupancy.begin())
+        {
+            --itor;
+            if (itor->first + itor->second > allocation.offset) return false;
+        }
+        return true;
+    }
+
+    // The allocator reports exactly the allocations in the map.
+    bool matchesOccupancy(const TlsfAllocator& allocator, const OccupancyMap& occupancy)
+    {
+        uint64_t usedSize = 0;
+        for (auto& entry : occupancy) usedSize += entry.second;
+
+        size_t count = 0;
+        bool matched = true;
+
+        allocator.forEachAllocation([&](const Allocation& allocation, uint64_t userData)
+        {
+            auto itor = occupancy.find(allocation.offset);
+            matched &= itor != occupancy.end() && itor->second == allocation.size;
+            ++count;
+        });
+        return matched && count == occupancy.size() &&
+               count == allocator.allocationCount() && usedSize == allocator.usedSize();
+    }
+
+    struct FakeHeaps
+    {
+        int createdCount = 0, releasedCount = 0;
+
+        void bind(HeapPool& pool)
+        {
+            pool.f_onCreateHeap = [this](uint32_t index, uint64_t size) { ++createdCount; return true; };
+            pool.f_onReleaseHeap = [this](uint32_t index) { ++releasedCount; };
+        }
+    };
+}
+
+D14_TEST(TlsfMatchesOccupancyMap)
+{
+    constexpr uint64_t granularity = 256, size = 1 << 24;
+
+    TlsfAllocator allocator(size, granularity);
+
+    std::mt19937_64 rng(43);
+    std::vector<Allocation> live = {};
+    OccupancyMap occupancy = {};
+
+    bool valid = true;
+    for (int i = 0; i < 300000; ++i)
+    {
+        if (live.empty() || rng() % 100 < 52)
+        {
+            // Mostly small ones with some large ones, and a few aligned.
+            uint64_t requested = 1 + rng() % (rng() % 4 == 0 ? 1 << 20 : 1 << 14);
+            uint64_t alignment = rng() % 4 == 0 ? 1ull << (8 + rng() % 8) : 0;
+
+            auto allocation = allocator.allocate(requested, alignment, i);
+            if (allocation.has_value())
+            {
+                valid &= allocation->size >= requested && allocation->offset % granularity == 0;
+                valid &= alignment == 0 || allocation->offset % alignment == 0;
+                valid &= allocation->offset + allocation->size <= size;
+                valid &= isDisjoint(occupancy, *allocation);
+
+                occupancy[allocation->offset] = allocation->size;
+                live.push_back(*allocation);
+            }
+        }
+        else
+        {
+            auto k = rng() % live.size();
+            auto allocation = live[k];
+
+            live[k] = live.back();
+            live.pop_back();
+
+            occupancy.erase(allocation.offset);
+            allocator.free(allocation.block);
+        }
+        if (i % 50000 == 0)
+        {
+            if (!CHECK(valid && matchesOccupancy(allocator, occupancy))) return;
+        }
+    }
+    CHECK(valid);
+
+    // Everything merges back into one block.
+    for (auto& allocation : live) allocator.free(allocation.block);
+
+    CHECK(allocator.usedSize() == 0 && allocator.allocationCount() == 0);
+    CHECK(allocator.freeBlockCount() == 1 && allocator.largestFreeBlock() == size);
+}
+
+D14_TEST(TlsfExactFitAndExhaustion)
+{
+    // A size that is not a power of 2 still fits in the whole range.
+    TlsfAllocator allocator(101 * 65536, 65536);
+
+    auto whole = allocator.allocate(101 * 65536);
+    CHECK(whole && whole->offset == 0);
+    CHECK(!allocator.allocate(1).has_value());
+
+    allocator.free(whole->block);
+
+    // The sizes are rounded up to the granularity.
+    auto small = allocator.allocate(1, 0, 7);
+    CHECK(small && small->size == 65536);
+
+    uint64_t userData = 0;
+    allocator.forEachAllocation([&](const Allocation&, uint64_t value) { userData = value; });
+    CHECK(userData == 7);
+
+    CHECK(!allocator.allocate(101 * 65536).has_value());
+}
+
+D14_TEST(PoolDedicatedHeapsAndFences)
+{
+    HeapPool pool(64 << 20, 65536);
+    FakeHeaps heaps = {};
+    heaps.bind(pool);
+
+    auto big = pool.allocate(100 << 20);
+    CHECK(big && pool.statistics().dedicatedHeapCount == 1);
+
+    auto small = pool.allocate(1 << 20);
+    CHECK(small && small->heap != big->heap);
+    CHECK(pool.statistics().heapCount == 2 && heaps.createdCount == 2);
+
+    // The dedicated heap is released once its frame completes.
+    pool.free(*big);
+    pool.endFrame(1);
+
+    CHECK(pool.statistics().pendingFreeSize == 100 << 20);
+
+    pool.reclaim(0);
+    CHECK(pool.statistics().dedicatedHeapCount == 1);
+
+    pool.reclaim(1);
+    CHECK(pool.statistics().dedicatedHeapCount == 0 && heaps.releasedCount == 1);
+
+    // An empty shared heap stays until trimmed.
+    pool.free(*small);
+    pool.endFrame(2);
+    pool.reclaim(2);
+
+    CHECK(pool.statistics().heapCount == 1);
+
+    pool.trim();
+    CHECK(pool.statistics().heapCount == 0 && heaps.releasedCount == 2);
+}
+
+D14_TEST(PoolRespectsBudget)
+{
+    HeapPool pool(64 << 20, 65536);
+    FakeHeaps heaps = {};
+    heaps.bind(pool);
+
+    pool.setBudget(256 << 20);
+
+    size_t count = 0;
+    while (pool.allocate(1 << 20).has_value()) ++count;
+
+    auto statistics = pool.statistics();
+    CHECK(count == 256 && statistics.heapCount == 4);
+    CHECK(statistics.reservedSize <= pool.budget());
+
+    // A failing backend leaves no heap behind.
+    HeapPool failing(64 << 20, 65536);
+    failing.f_onCreateHeap = [](uint32_t, uint64_t) { return false; };
+
+    CHECK(!failing.allocate(1 << 20).has_value());
+    CHECK(failing.statistics().heapCount == 0);
+}
+
+D14_TEST(DefragmentEmptiesSparseHeaps)
+{
+    HeapPool pool(16 << 20, 65536);
+    FakeHeaps heaps = {};
+    heaps.bind(pool);
+
+    std::vector<HeapPool::Allocation> allocations = {};
+    for (uint64_t i = 0; i < 64; ++i) allocations.push_back(pool.allocate(1 << 20, 0, i).value());
+
+    CHECK(pool.statistics().heapCount == 4);
+
+    // Keeps every 5th one, so each heap is about 20% used.
+    std::vector<HeapPool::Allocation> kept = {};
+    for (size_t i = 0; i < allocations.size(); ++i)
+    {
+        if (i % 5) pool.free(allocations[i]);
+        else kept.push_back(allocations[i]);
+    }
+    pool.endFrame(1);
+    pool.reclaim(1);
+
+    auto usedSize = pool.statistics().usedSize;
+
+    bool preserved = true;
+    auto moveCount = pool.defragment([&](const HeapPool::Move& move)
+    {
+        preserved &= move.source.range.size == move.destination.range.size;
+        preserved &= move.source.heap != move.destination.heap;
+        preserved &= move.userData % 5 == 0;
+        return true;
+    });
+    CHECK(moveCount > 0 && preserved);
+
+    // The sources are freed as usual, i.e. after the fence.
+    pool.endFrame(2);
+    pool.reclaim(2);
+    pool.trim();
+
+    auto statistics = pool.statistics();
+    CHECK(statistics.usedSize == usedSize && statistics.allocationCount == kept.size());
+    CHECK(statistics.heapCount == 1);
+}
+
+D14_BENCH(TwoMillionOperations)
+{
+    constexpr int operationCount = 2000000;
+
+    std::mt19937_64 rng(2043);
+
+    // Large enough for about 20000 live allocations of 2MB on average.
+    TlsfAllocator allocator(1ull << 36, 65536);
+
+    std::vector<uint64_t> sizes(operationCount);
+    for (auto& size : sizes) size = 65536 * (1 + rng() % 64);
+
+    std::vector<uint8_t> isAllocation(operationCount);
+    for (auto& flag : isAllocation) flag = rng() & 1;
+
+    std::vector<TlsfAllocator::BlockID> live = {};
+    live.reserve(operationCount);
+
+    double us = unit_test::measure(1, [&]
+    {
+        for (int i = 0; i < operationCount; ++i)
+        {
+            if (live.size() < 20000 || isAllocation[i])
+            {
+                auto allocation = allocator.allocate(sizes[i]);
+                if (allocation.has_value()) live.push_back(allocation->block);
+            }
+            else
+            {
+                auto k = sizes[i] % live.size();
+                allocator.free(live[k]);
+
+                live[k] = live.back();
+                live.pop_back();
+            }
+        }
+    });
+    std::printf("  %d operations: %.1f ms (%.1f ns/op), %zu live, %zu free blocks\n",
+                operationCount, us / 1000.0, us * 1000.0 / operationCount, live.size(), allocator.freeBlockCount());
+}
@@ -0,0 +1,216 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/Interfaces/ICullingCamera.h"
+#include "Renderer/NullRenderer.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    // Culls every even object.
+    struct OddCamera : ICullingCamera
+    {
+        void cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results) override
+        {
+            results.resize(objects.size());
+            for (size_t i = 0; i < objects.size(); ++i) results[i] = i % 2;
+        }
+    };
+
+    std::vector<String> g_updateLog = {}, g_drawLog = {};
+
+    struct MockLayer : IDrawLayer
+    {
+        ICullingCamera* camera = nullptr;
+
+        bool visible = true;
+
+        bool isD3d12LayerVisible() const override { return visible; }
+        void setD3d12LayerVisible(bool value) override { visible = value; }
+
+        ICullingCamera* d3d12CullingCamera() const override { return camera; }
+
+        void onRendererUpdateLayer(Renderer* rndr) override { g_updateLog.push_back("L"); }
+        void onRendererDrawD3d12Layer(Renderer* rndr) override { g_drawLog.push_back("L"); }
+    };
+
+    struct MockObject : IDrawObject, IDrawObject2D
+    {
+        int id = 0;
+
+        // Where the 2D draws are recorded.
+        NullRenderer* sink = nullptr;
+
+        bool visible = true;
+
+        explicit MockObject(int id) : id(id) { }
+
+        bool isD3d12ObjectVisible() const override { return visible; }
+        void setD3d12ObjectVisible(bool value) override { visible = value; }
+
+        Optional<cull_utils::Bounds> d3d12ObjectBounds() const override { return std::nullopt; }
+
+        void onRendererUpdateObject(Renderer* rndr) override { g_updateLog.push_back("U" + std::to_string(id)); }
+        void onRendererDrawD3d12Object(Renderer* rndr) override { g_drawLog.push_back("D" + std::to_string(id)); }
+
+        bool isD2d1ObjectVisible() const override { return visible; }
+        void setD2d1ObjectVisible(bool value) override { visible = value; }
+
+        void onRendererUpdateObject2D(Renderer* rndr) override { g_updateLog.push_back("V" + std::to_string(id)); }
+        void onRendererDrawD2d1Layer(Renderer* rndr) override { g_drawLog.push_back("Y" + std::to_string(id)); }
+        void onRendererDrawD2d1Object(Renderer* rndr) override
+        {
+            g_drawLog.push_back("Z" + std::to_string(id));
+
+            DisplayList::FillRect command = {};
+            command.rect = { 0.0f, 0.0f, (float)id, (float)id };
+            sink->displayList.record(command);
+        }
+    };
+
+    struct Scene
+    {
+        OddCamera camera = {};
+
+        NullRenderer renderer = {};
+
+        SharedPtr<NullRenderer::CommandLayer> sceneLayer = {}, uiLayer = {};
+
+        Scene()
+        {
+            sceneLayer = std::make_shared<NullRenderer::CommandLayer>();
+            auto& target = sceneLayer->drawTarget.emplace<FrameTraversal::D3D12Target>();
+
+            auto visibleLayer = std::make_shared<MockLayer>();
+            visibleLayer->camera = &camera;
+            visibleLayer->setPriority(0);
+
+            auto hiddenLayer = std::make_shared<MockLayer>();
+            hiddenLayer->visible = false;
+            hiddenLayer->setPriority(1);
+
+            // Objects 0..4 are visible and the odd ones pass the culling.
+            for (int i = 0; i < 6; ++i)
+            {
+                auto obj = std::make_shared<MockObject>(i);
+                obj->IDrawObject::setPriority(i);
+                obj->visible = i != 5;
+                target[visibleLayer].insert(obj);
+            }
+            for (int i = 10; i < 13; ++i)
+            {
+                auto obj = std::make_shared<MockObject>(i);
+                obj->IDrawObject::setPriority(i);
+                target[hiddenLayer].insert(obj);
+            }
+            renderer.cmdLayers.insert(sceneLayer);
+
+            uiLayer = std::make_shared<NullRenderer::CommandLayer>();
+            uiLayer->setPriority(5);
+            uiLayer->enabled = false;
+            auto& uiTarget = uiLayer->drawTarget.emplace<FrameTraversal::D2D1Target>();
+
+            for (int i = 20; i < 22; ++i)
+            {
+                auto obj = std::make_shared<MockObject>(i);
+                obj->IDrawObject2D::setPriority(i);
+                obj->sink = &renderer;
+                uiTarget.insert(obj);
+            }
+            renderer.cmdLayers.insert(uiLayer);
+
+            g_updateLog.clear();
+            g_drawLog.clear();
+        }
+    };
+}
+
+D14_TEST(UpdatesAndCullsD3d12Target)
+{
+    Scene scene = {};
+    scene.renderer.renderNextFrame();
+
+    auto& c = scene.renderer.counters();
+    CHECK(c.frameCount == 1);
+    CHECK(c.layerUpdates == 1);
+    CHECK(c.objectUpdates == 8);
+    CHECK(c.object2DUpdates == 2);
+    CHECK(c.layerSubmissions == 1);
+    CHECK(c.d3d12Targets == 1);
+    CHECK(c.d3d12LayerDraws == 1);
+    // The 3 objects of the hidden layer are not culled by any camera.
+    CHECK(c.d3d12ObjectDraws == 2 + 3);
+    CHECK(c.culledObjects == 3);
+    CHECK(c.d2d1Targets == 0);
+
+    // The layers are updated before their objects in priority order.
+    CHECK(!g_updateLog.empty() && g_updateLog.front() == "L");
+}
+
+D14_TEST(DrawsD2d1TargetWithoutUpdates)
+{
+    Scene scene = {};
+    scene.renderer.renderNextFrame();
+
+    scene.uiLayer->enabled = true;
+    scene.renderer.invokeUpdates = false;
+    scene.renderer.resetCounters();
+    g_updateLog.clear();
+
+    scene.renderer.renderNextFrame();
+
+    auto& c = scene.renderer.counters();
+    CHECK(g_updateLog.empty());
+    CHECK(c.layerSubmissions == 2);
+    CHECK(c.d2d1Targets == 1);
+    CHECK(c.d2d1LayerDraws == 2);
+    CHECK(c.d2d1ObjectDraws == 2);
+}
+
+D14_TEST(InvokesDrawsAndRecords2D)
+{
+    Scene scene = {};
+    scene.uiLayer->enabled = true;
+
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        g_drawLog.clear();
+        scene.renderer.renderNextFrame();
+
+        // The same order as the counters: the layer, the odd objects that
+        // pass the culling, the hidden layer's objects, then the 2D layers
+        // before the 2D objects.
+        std::vector<String> expected =
+        {
+            "L", "D1", "D3", "D10", "D11", "D12", "Y20", "Y21", "Z20", "Z21"
+        };
+        CHECK(g_drawLog == expected);
+
+        // Each frame starts a new list.
+        auto& list = scene.renderer.displayList;
+        CHECK(list.commandCount() == 3);
+        CHECK(list.commandAt<DisplayList::SetTarget>(0) != nullptr);
+
+        auto fill = list.commandAt<DisplayList::FillRect>(2);
+        CHECK(fill != nullptr && fill->rect.right == 21.0f);
+    }
+    scene.renderer.invokeDraws = false;
+    g_drawLog.clear();
+
+    scene.renderer.renderNextFrame();
+    CHECK(g_drawLog.empty());
+    CHECK(scene.renderer.displayList.commandCount() == 1);
+    CHECK(scene.renderer.counters().d2d1ObjectDraws == 2 * 3);
+}
+
+D14_BENCH(FrameTimeOfMockScene)
+{
+    Scene scene = {};
+    scene.uiLayer->enabled = true;
+
+    double us = unit_test::measure(100000, [&] { scene.renderer.renderNextFrame(); });
+    std::printf("  %.3f us/frame\n", us);
+}
@@ -0,0 +1,229 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/RenderGraph/RenderGraph.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer::render_graph;
+
+namespace
+{
+    using S = ResourceState;
+    using Type = Barrier::Type;
+
+    // Records the batches of barriers and the names of the passes.
+    struct RecordingBackend : IBackend
+    {
+        std::vector<std::vector<Barrier>> batches = {};
+        std::vector<Wstring> passes = {};
+
+        void submitBarriers(const Barrier* barriers, size_t count) override
+        {
+            batches.emplace_back(barriers, barriers + count);
+        }
+        void beginPass(WstrRefer name) override { passes.push_back(name); }
+    };
+
+    bool hasBarrier(const std::vector<Barrier>& batch, Type type, ResourceID resource, State before = 0, State after = 0)
+    {
+        for (auto& barrier : batch)
+        {
+            if (barrier.type != type || barrier.resource != resource) continue;
+
+            if (type != Type::Transition || (barrier.before == before && barrier.after == after)) return true;
+        }
+        return false;
+    }
+
+    // A chain of full-screen passes, each of which reads the previous one.
+    void addChain(RenderGraph& graph, ResourceID backBuffer, size_t length)
+    {
+        auto previous = graph.createTransient(L"Chain0", { 1 << 20 });
+        graph.addPass(L"Pass0", {}).write(previous, S::RenderTarget);
+
+        for (size_t i = 1; i < length; ++i)
+        {
+            auto target = graph.createTransient(L"Chain" + std::to_wstring(i), { 1 << 20 });
+            graph.addPass(L"Pass" + std::to_wstring(i), {}).read(previous, S::PixelShaderResource).write(target, S::RenderTarget);
+            previous = target;
+        }
+        graph.addPass(L"Present", {}).read(previous, S::PixelShaderResource).write(backBuffer, S::RenderTarget);
+    }
+}
+
+D14_TEST(CullsPassesWithoutOutputs)
+{
+    RenderGraph graph = {};
+
+    auto backBuffer = graph.importResource(L"BackBuffer", S::Present, S::Present);
+    auto scene = graph.createTransient(L"Scene", { 1000, 256 });
+    auto unused = graph.createTransient(L"Unused", { 4000, 256 });
+    auto log = graph.createTransient(L"Log", { 100, 256 });
+
+    int executed = 0;
+    graph.addPass(L"Scene", [&] { executed += 1; }).write(scene, S::RenderTarget);
+    graph.addPass(L"Dead", [&] { executed += 100; }).read(scene, S::PixelShaderResource).write(unused, S::RenderTarget);
+    graph.addPass(L"Log", [&] { executed += 10; }).read(scene, S::CopySource).write(log, S::CopyDest).sideEffect();
+    graph.addPass(L"Present", [&] { executed += 1; }).read(scene, S::PixelShaderResource).write(backBuffer, S::RenderTarget);
+
+    graph.compile();
+
+    CHECK(graph.isPassLive(0) && !graph.isPassLive(1) && graph.isPassLive(2) && graph.isPassLive(3));
+    CHECK(graph.livePassCount() == 3);
+
+    CHECK(!graph.isResourceUsed(unused) && !graph.heapOffset(unused).has_value());
+    CHECK(graph.isResourceUsed(log));
+
+    RecordingBackend backend = {};
+    graph.execute(backend);
+
+    CHECK(executed == 12);
+    CHECK((backend.passes == std::vector<Wstring>{ L"Scene", L"Log", L"Present" }));
+}
+
+D14_TEST(ConsecutiveReadsAreMerged)
+{
+    RenderGraph graph = {};
+
+    auto a = graph.importResource(L"A", S::CopyDest, S::PixelShaderResource);
+    auto b = graph.importResource(L"B", S::Common, S::Common);
+
+    graph.addPass(L"First", {}).read(a, S::PixelShaderResource).write(b, S::CopyDest);
+    graph.addPass(L"Second", {}).read(a, S::CopySource).write(b, S::CopyDest);
+
+    RecordingBackend backend = {};
+    graph.execute(backend);
+
+    // One batch before the first pass, none before the second one, and
+    // the final states at the end.
+    CHECK(graph.batchCount() == 2 && graph.barrierCount() == 4);
+    if (!CHECK(backend.batches.size() == 2)) return;
+
+    State combined = S::PixelShaderResource | S::CopySource;
+    CHECK(hasBarrier(backend.batches[0], Type::Transition, a, S::CopyDest, combined));
+    CHECK(hasBarrier(backend.batches[0], Type::Transition, b, S::Common, S::CopyDest));
+
+    CHECK(hasBarrier(backend.batches[1], Type::Transition, a, combined, S::PixelShaderResource));
+    CHECK(hasBarrier(backend.batches[1], Type::Transition, b, S::CopyDest, S::Common));
+}
+
+D14_TEST(WritesAfterWritesNeedUAVBarriers)
+{
+    RenderGraph graph = {};
+
+    auto backBuffer = graph.importResource(L"BackBuffer", S::Present, S::Present);
+    auto buffer = graph.createTransient(L"Buffer", { 1000, 256 });
+
+    graph.addPass(L"Blur0", {}).write(buffer, S::UnorderedAccess);
+    graph.addPass(L"Blur1", {}).write(buffer, S::UnorderedAccess);
+    graph.addPass(L"Compose", {}).read(buffer, S::PixelShaderResource).write(backBuffer, S::RenderTarget);
+
+    RecordingBackend backend = {};
+    graph.execute(backend);
+
+    // The transient one starts in its state at the end of the frame.
+    CHECK(graph.initialState(buffer) == S::PixelShaderResource);
+
+    if (!CHECK(backend.batches.size() == 4)) return;
+
+    CHECK(hasBarrier(backend.batches[0], Type::Transition, buffer, S::PixelShaderResource, S::UnorderedAccess));
+    CHECK(hasBarrier(backend.batches[1], Type::UAV, buffer));
+    CHECK(hasBarrier(backend.batches[2], Type::Transition, buffer, S::UnorderedAccess, S::PixelShaderResource));
+    CHECK(hasBarrier(backend.batches[2], Type::Transition, backBuffer, S::Present, S::RenderTarget));
+
+    // No barrier of the transient one at the end.
+    CHECK(backend.batches[3].size() == 1);
+    CHECK(hasBarrier(backend.batches[3], Type::Transition, backBuffer, S::RenderTarget, S::Present));
+}
+
+D14_TEST(DisjointTransientsAreAliased)
+{
+    RenderGraph graph = {};
+
+    auto backBuffer = graph.importResource(L"BackBuffer", S::Present, S::Present);
+    auto a = graph.createTransient(L"A", { 1000, 256 });
+    auto b = graph.createTransient(L"B", { 1000, 256 });
+    auto c = graph.createTransient(L"C", { 1000, 256 });
+    auto buffer = graph.createTransient(L"Buffer", { 1000, 256, 1 });
+
+    graph.addPass(L"P0", {}).write(a, S::RenderTarget).write(buffer, S::UnorderedAccess);
+    graph.addPass(L"P1", {}).read(a, S::PixelShaderResource).write(b, S::RenderTarget);
+    graph.addPass(L"P2", {}).read(b, S::PixelShaderResource).write(c, S::RenderTarget);
+    graph.addPass(L"P3", {}).read(c, S::PixelShaderResource).read(buffer, S::PixelShaderResource).write(backBuffer, S::RenderTarget);
+
+    RecordingBackend backend = {};
+    graph.execute(backend);
+
+    // A and C share the memory, while B overlaps both of them in time.
+    CHECK(graph.heapOffset(a) == 0u && graph.heapOffset(b) == 1024u && graph.heapOffset(c) == 0u);
+    CHECK(graph.heapSizes().size() == 2 && graph.heapSizes()[0] == 2024 && graph.heapSizes()[1] == 1000);
+    CHECK(graph.transientSize() == 4000);
+
+    // The buffer is in another heap group, so it aliases nothing.
+    CHECK(graph.heapGroup(buffer) == 1 && graph.heapOffset(buffer) == 0u);
+
+    if (!CHECK(backend.batches.size() == 5)) return;
+
+    // The aliasing barriers come first in their batches.
+    CHECK(backend.batches[0].front().type == Type::Aliasing && hasBarrier(backend.batches[0], Type::Aliasing, a));
+    CHECK(backend.batches[2].front().type == Type::Aliasing && hasBarrier(backend.batches[2], Type::Aliasing, c));
+    CHECK(!hasBarrier(backend.batches[1], Type::Aliasing, b));
+}
+
+D14_TEST(ExecutesTheSameBarriersEachFrame)
+{
+    RenderGraph graph = {};
+
+    auto backBuffer = graph.importResource(L"BackBuffer", S::Present, S::Present);
+    addChain(graph, backBuffer, 8);
+
+    RecordingBackend first = {}, second = {};
+    graph.execute(first);
+
+    CHECK(graph.isCompiled());
+    graph.execute(second);
+
+    bool same = first.batches.size() == second.batches.size();
+    for (size_t i = 0; same && i < first.batches.size(); ++i)
+    {
+        same &= first.batches[i].size() == second.batches[i].size();
+        for (size_t k = 0; same && k < first.batches[i].size(); ++k)
+        {
+            auto& x = first.batches[i][k];
+            auto& y = second.batches[i][k];
+            same &= x.type == y.type && x.resource == y.resource && x.before == y.before && x.after == y.after;
+        }
+    }
+    CHECK(same);
+
+    // Any change invalidates the compilation.
+    graph.addPass(L"Overlay", {}).write(backBuffer, S::RenderTarget);
+    CHECK(!graph.isCompiled());
+
+    graph.clear();
+    CHECK(graph.passCount() == 0 && graph.resourceCount() == 0);
+}
+
+D14_BENCH(CompileLongChains)
+{
+    for (size_t length : { 16, 256, 4096 })
+    {
+        RenderGraph graph = {};
+
+        auto backBuffer = graph.importResource(L"BackBuffer", S::Present, S::Present);
+        addChain(graph, backBuffer, length);
+
+        // Each pass invalidates the previous compilation.
+        double compileUs = unit_test::measure(10, [&]
+        {
+            graph.addPass(L"Overlay", {}).write(backBuffer, S::RenderTarget);
+            graph.compile();
+        });
+        RecordingBackend backend = {};
+        double executeUs = unit_test::measure(10, [&] { backend.batches.clear(); graph.execute(backend); });
+
+        std::printf("  %zu passes: compile %.1f us, execute %.1f us, heap %.1f MB of %.1f MB\n",
+                    length, compileUs, executeUs, graph.heapSizes()[0] / 1048576.0, graph.transientSize() / 1048576.0);
+    }
+}
@@ -0,0 +1,107 @@
+﻿#include "Common/Precompile.h"
+
+#include "Renderer/RetirementQueue.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    // Counts the live instances, and optionally retires another one from
+    // its destructor (as a panel releasing its children does).
+    struct Tracked
+    {
+        static inline int g_aliveCount = 0;
+
+        RetirementQueue* queue = nullptr;
+        bool spawn = false;
+
+        Tracked(RetirementQueue* queue, bool spawn) : queue(queue), spawn(spawn) { ++g_aliveCount; }
+
+        ~Tracked()
+        {
+            --g_aliveCount;
+            if (spawn) queue->retire(std::make_shared<Tracked>(queue, false));
+        }
+    };
+}
+
+D14_TEST(ReleasesAfterTheFence)
+{
+    RetirementQueue queue = {};
+
+    queue.retire(std::make_shared<Tracked>(&queue, false));
+    queue.retire(std::make_shared<Tracked>(&queue, true));
+    queue.endFrame(1);
+
+    queue.retire(std::make_shared<Tracked>(&queue, false));
+    queue.endFrame(2);
+
+    CHECK(Tracked::g_aliveCount == 3 && queue.retiredCount() == 3);
+
+    CHECK(queue.reclaim(0) == 0 && Tracked::g_aliveCount == 3);
+
+    // The spawned one is retired into the current frame.
+    CHECK(queue.reclaim(1) == 2);
+    CHECK(Tracked::g_aliveCount == 2 && queue.retiredCount() == 2);
+
+    queue.endFrame(3);
+
+    CHECK(queue.reclaim(2) == 1 && Tracked::g_aliveCount == 1);
+    CHECK(queue.reclaim(3) == 1 && Tracked::g_aliveCount == 0);
+}
+
+D14_TEST(ReleaseAllDrainsChains)
+{
+    RetirementQueue queue = {};
+
+    queue.retire(10, std::make_shared<Tracked>(&queue, true));
+    queue.retire(std::make_shared<Tracked>(&queue, true));
+
+    CHECK(queue.releaseAll() == 4);
+    CHECK(Tracked::g_aliveCount == 0 && queue.retiredCount() == 0);
+
+    // A null object is not queued.
+    queue.retire(SharedPtr<void>{});
+    CHECK(queue.retiredCount() == 0);
+}
+
+D14_TEST(KeptAliveByTheQueueOnly)
+{
+    RetirementQueue queue = {};
+
+    auto object = std::make_shared<Tracked>(&queue, false);
+    WeakPtr<Tracked> weak = object;
+
+    queue.retire(std::move(object));
+    queue.endFrame(5);
+
+    CHECK(!weak.expired());
+
+    queue.reclaim(4);
+    CHECK(!weak.expired());
+
+    queue.reclaim(5);
+    CHECK(weak.expired());
+}
+
+D14_BENCH(RetireAndReclaim)
+{
+    RetirementQueue queue = {};
+
+    // 1000 objects per frame, with the GPU 2 frames behind.
+    std::vector<SharedPtr<void>> objects(1000);
+    for (auto& object : objects) object = std::make_shared<int>();
+
+    uint64_t frame = 0;
+    double us = unit_test::measure(1000, [&]
+    {
+        for (auto& object : objects) queue.retire(object);
+
+        queue.endFrame(++frame);
+        if (frame > 2) queue.reclaim(frame - 2);
+    });
+    std::printf("  frame of 1000 objects: %.2f us\n", us);
+}
@@ -0,0 +1,213 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/SoftwareRasterizer.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using Rect = SoftwareRasterizer::Rect;
+    using Color = SoftwareRasterizer::Color;
+
+    const uint8_t* pixelAt(const SoftwareRasterizer& rasterizer, uint32_t x, uint32_t y)
+    {
+        auto& target = rasterizer.target();
+        return target.pixels.data() + ((size_t)y * target.width + x) * 4;
+    }
+
+    // Every kind of the draws at random, with the rotations, the clips
+    // and the layers, on a target of many tiles.
+    void drawRandomScene(SoftwareRasterizer& rasterizer, uint32_t seed, const pixel_utils::Image& bitmap)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        auto randomRect = [&]
+        {
+            float x = unit(rng) * 200.0f, y = unit(rng) * 150.0f;
+            return Rect{ x, y, x + 4.0f + unit(rng) * 60.0f, y + 4.0f + unit(rng) * 40.0f };
+        };
+        auto randomColor = [&] { return Color{ unit(rng), unit(rng), unit(rng), 0.2f + 0.8f * unit(rng) }; };
+
+        pixel_utils::Mask glyphs(24, 12);
+        for (auto& coverage : glyphs.pixels) coverage = (uint8_t)rng();
+
+        rasterizer.clear({ 1, 1, 1, 1 });
+
+        int clipDepth = 0, layerDepth = 0;
+        for (int i = 0; i < 120; ++i)
+        {
+            switch (rng() % 12)
+            {
+            case 0: rasterizer.fillRect(randomRect(), randomColor()); break;
+            case 1: rasterizer.drawRect(randomRect(), randomColor(), 0.5f + unit(rng) * 3.0f); break;
+            case 2: rasterizer.fillRoundedRect(randomRect(), 6.0f, 4.0f, randomColor()); break;
+            case 3: rasterizer.drawRoundedRect(randomRect(), 8.0f, 8.0f, randomColor(), 1.5f); break;
+            case 4:
+            {
+                auto rect = randomRect();
+                rasterizer.drawLine({ rect.left, rect.top }, { rect.right, rect.bottom }, randomColor(), 0.5f + unit(rng) * 4.0f);
+                break;
+            }
+            case 5: rasterizer.drawBitmap(bitmap.view(), randomRect(), unit(rng), rng() % 2 == 0); break;
+            case 6: rasterizer.drawMask(glyphs, { unit(rng) * 200.0f, unit(rng) * 150.0f }, randomColor()); break;
+            case 7: rasterizer.drawShadow(randomRect(), 4.0f, 4.0f, 1.0f + unit(rng) * 5.0f, { 0, 0, 0, 0.4f }); break;
+            case 8:
+            {
+                float angle = unit(rng) * 6.28f, c = std::cos(angle), s = std::sin(angle);
+                rasterizer.setTransform({ c, s, -s, c, unit(rng) * 200.0f, unit(rng) * 150.0f });
+                break;
+            }
+            case 9: rasterizer.setTransform({}); break;
+            case 10:
+            {
+                if (clipDepth < 3) { rasterizer.pushClip(randomRect(), rng() % 2 == 0); ++clipDepth; }
+                else { rasterizer.popClip(); --clipDepth; }
+                break;
+            }
+            default:
+            {
+                // The layers only nest inside the clips pushed after them.
+                if (layerDepth == 0 && clipDepth == 0) { rasterizer.pushLayer(randomRect(), unit(rng)); ++layerDepth; }
+                else if (layerDepth > 0 && clipDepth == 0) { rasterizer.popLayer(); --layerDepth; }
+                break;
+            }
+            }
+        }
+        // The rest are closed by flush.
+        rasterizer.flush();
+    }
+
+    pixel_utils::Image randomBitmap(uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+
+        pixel_utils::Image bitmap(13, 7);
+        for (size_t p = 0; p < bitmap.pixels.size(); p += 4)
+        {
+            uint8_t alpha = (uint8_t)rng();
+            for (size_t c = 0; c < 3; ++c) bitmap.pixels[p + c] = (uint8_t)(rng() % (alpha + 1u));
+            bitmap.pixels[p + 3] = alpha;
+        }
+        return bitmap;
+    }
+}
+
+D14_TEST(AlignedRectCoverage)
+{
+    SoftwareRasterizer rasterizer(32, 32);
+    rasterizer.fillRect({ 10.5f, 10.0f, 20.0f, 20.0f }, { 1, 0, 0, 1 });
+    rasterizer.flush();
+
+    // The exact area of each pixel.
+    auto inside = pixelAt(rasterizer, 15, 15), edge = pixelAt(rasterizer, 10, 15);
+    CHECK(inside[0] == 255 && inside[1] == 0 && inside[3] == 255);
+    CHECK(std::abs(edge[3] - 128) <= 1 && edge[0] == edge[3]);
+
+    CHECK(pixelAt(rasterizer, 9, 15)[3] == 0 && pixelAt(rasterizer, 20, 15)[3] == 0);
+    CHECK(pixelAt(rasterizer, 15, 9)[3] == 0 && pixelAt(rasterizer, 15, 19)[3] == 255);
+}
+
+D14_TEST(ClipsAndLayers)
+{
+    SoftwareRasterizer rasterizer(32, 32);
+
+    // Only the left half is drawn.
+    rasterizer.pushClip({ 0, 0, 16, 32 }, false);
+    rasterizer.fillRect({ 0, 0, 32, 32 }, { 0, 0, 1, 1 });
+    rasterizer.popClip();
+
+    CHECK(rasterizer.transform().m11 == 1.0f);
+    rasterizer.flush();
+
+    CHECK(pixelAt(rasterizer, 15, 3)[2] == 255 && pixelAt(rasterizer, 16, 3)[3] == 0);
+
+    // The overlapping draws are composited as one, so the overlap is not
+    // darker than the rest.
+    rasterizer.clear({ 0, 0, 0, 0 });
+    rasterizer.pushLayer({ 0, 0, 32, 32 }, 0.5f);
+    rasterizer.fillRect({ 0, 0, 20, 32 }, { 1, 1, 1, 1 });
+    rasterizer.fillRect({ 10, 0, 32, 32 }, { 1, 1, 1, 1 });
+    rasterizer.popLayer();
+    rasterizer.flush();
+
+    auto single = pixelAt(rasterizer, 5, 5)[3], overlap = pixelAt(rasterizer, 15, 5)[3];
+    CHECK(std::abs(single - 128) <= 1 && overlap == single);
+}
+
+D14_TEST(SimdMatchesScalarAcrossThreads)
+{
+    auto bitmap = randomBitmap(49);
+
+    bool matched = true;
+    for (uint32_t seed = 0; seed < 20 && matched; ++seed)
+    {
+        SoftwareRasterizer reference(257, 190);
+        reference.settings.useSimd = false;
+        reference.settings.threadCount = 1;
+        drawRandomScene(reference, seed, bitmap);
+
+        SoftwareRasterizer parallel(257, 190);
+        parallel.settings.threadCount = 4;
+        drawRandomScene(parallel, seed, bitmap);
+
+        // Smaller tiles than the shapes and the shadows.
+        SoftwareRasterizer tiled(257, 190);
+        tiled.settings.tileSize = 16;
+        tiled.settings.threadCount = 3;
+        drawRandomScene(tiled, seed, bitmap);
+
+        matched &= parallel.target().pixels == reference.target().pixels;
+        matched &= tiled.target().pixels == reference.target().pixels;
+    }
+    CHECK(matched);
+}
+
+D14_TEST(ReplayerDrawsTheList)
+{
+    DisplayList list = {};
+    list.record(DisplayList::SetTransform{ .transform = { 1, 0, 0, 1, 4, 2 } });
+    list.record(DisplayList::FillRect{ .rect = { 0, 0, 10, 10 }, .brush = { .color = { 0, 1, 0, 1 } } });
+
+    // Nothing is drawn to the other targets.
+    list.record(DisplayList::SetTarget{ .target = 1 });
+    list.record(DisplayList::FillRect{ .rect = { 0, 0, 32, 32 }, .brush = { .color = { 1, 0, 0, 1 } } });
+    list.record(DisplayList::SetTarget{});
+
+    SoftwareRasterizer replayed(32, 32);
+    SoftwareReplayer replayer(replayed, list);
+    list.replay(replayer);
+    replayed.flush();
+
+    SoftwareRasterizer direct(32, 32);
+    direct.setTransform({ 1, 0, 0, 1, 4, 2 });
+    direct.fillRect({ 0, 0, 10, 10 }, { 0, 1, 0, 1 });
+    direct.flush();
+
+    CHECK(replayed.target().pixels == direct.target().pixels);
+    CHECK(pixelAt(replayed, 4, 2)[1] == 255 && pixelAt(replayed, 3, 2)[3] == 0);
+}
+
+D14_BENCH(PanelSizedDraws)
+{
+    SoftwareRasterizer rasterizer(352, 240);
+    rasterizer.settings.threadCount = 1;
+
+    auto print = [](const char* name, double us) { std::printf("  %-24s %8.1f us\n", name, us); };
+
+    print("empty flush", unit_test::measure(200, [&] { rasterizer.flush(); }));
+    print("clear", unit_test::measure(200, [&] { rasterizer.clear({ 1, 1, 1, 1 }); rasterizer.flush(); }));
+    print("fill rect", unit_test::measure(200, [&] { rasterizer.fillRect({ 20, 20, 300, 220 }, { 1, 0, 0, 1 }); rasterizer.flush(); }));
+    print("fill rounded rect", unit_test::measure(200, [&] { rasterizer.fillRoundedRect({ 20, 20, 300, 220 }, 8, 8, { 1, 0, 0, 1 }); rasterizer.flush(); }));
+    print("shadow", unit_test::measure(200, [&] { rasterizer.drawShadow({ 20, 20, 300, 220 }, 8, 8, 4, { 0, 0, 0, 0.3f }); rasterizer.flush(); }));
+
+    auto bitmap = randomBitmap(2049);
+    rasterizer.settings.threadCount = 0;
+
+    print("random scene, all cores", unit_test::measure(50, [&] { drawRandomScene(rasterizer, 2049, bitmap); }));
+}
@@ -0,0 +1,207 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Renderer/UploadRing.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+namespace
+{
+    using Buffer = std::vector<uint8_t>;
+
+    // Executes the batches in order when stepped, and reads the staging
+    // memory only then (as the GPU does), so any space reused too early
+    // shows up in the destinations.
+    struct SimulatedQueue : UploadRing::IBackend
+    {
+        Buffer staging = {};
+
+        explicit SimulatedQueue(size_t capacity) : staging(capacity) { }
+
+        struct Copy
+        {
+            void* destination = nullptr;
+
+            uint64_t dstOffset = 0, srcOffset = 0, size = 0;
+        };
+        std::vector<Copy> recording = {};
+
+        std::deque<std::pair<uint64_t, std::vector<Copy>>> inflight = {};
+
+        uint64_t completed = 0, lastSignaled = 0;
+        uint64_t copyCallCount = 0;
+
+        bool inOrder = true, inBounds = true;
+
+        void copyBuffer(void* destination, uint64_t dstOffset, uint64_t srcOffset, uint64_t size) override
+        {
+            ++copyCallCount;
+            recording.push_back({ destination, dstOffset, srcOffset, size });
+        }
+        void submitBatch(uint64_t fenceValue) override
+        {
+            inOrder &= fenceValue == lastSignaled + 1;
+            lastSignaled = fenceValue;
+
+            inflight.emplace_back(fenceValue, std::move(recording));
+            recording.clear();
+        }
+        void step()
+        {
+            if (inflight.empty()) return;
+
+            for (auto& copy : inflight.front().second)
+            {
+                auto& destination = *(Buffer*)copy.destination;
+
+                inBounds &= copy.dstOffset + copy.size <= destination.size();
+                inBounds &= copy.srcOffset + copy.size <= staging.size();
+
+                if (inBounds)
+                {
+                    std::memcpy(destination.data() + copy.dstOffset, staging.data() + copy.srcOffset, copy.size);
+                }
+            }
+            completed = inflight.front().first;
+            inflight.pop_front();
+        }
+        uint64_t completedValue() override { return completed; }
+
+        void waitForValue(uint64_t fenceValue) override
+        {
+            while (completed < fenceValue && !inflight.empty()) step();
+        }
+    };
+
+    Buffer randomBytes(std::mt19937_64& rng, size_t size)
+    {
+        Buffer bytes(size);
+        for (auto& byte : bytes) byte = (uint8_t)rng();
+        return bytes;
+    }
+}
+
+D14_TEST(AdjacentCopiesAreMerged)
+{
+    SimulatedQueue queue(4096);
+    UploadRing ring(&queue, queue.staging.data(), queue.staging.size());
+
+    Buffer destination(256);
+
+    Buffer ones(32, 1), twos(32, 2);
+    auto first = ring.enqueue(&destination, 0, ones.data(), ones.size());
+    auto second = ring.enqueue(&destination, 32, twos.data(), twos.size());
+
+    CHECK(first == 1 && second == first);
+    CHECK(ring.statistics().mergedCount == 1 && ring.statistics().pendingCopyCount == 1);
+
+    // Not submitted yet.
+    CHECK(!ring.isComplete(first) && ring.lastSubmitted() == 0);
+
+    CHECK(ring.flush() == 1);
+    CHECK(queue.copyCallCount == 1);
+
+    ring.wait(first);
+    CHECK(ring.isComplete(first));
+
+    bool landed = true;
+    for (int i = 0; i < 64; ++i) landed &= destination[i] == (i < 32 ? 1 : 2);
+    CHECK(landed);
+
+    // A gap in the destination starts a new copy.
+    ring.enqueue(&destination, 128, ones.data(), ones.size());
+    ring.enqueue(&destination, 192, ones.data(), ones.size());
+    CHECK(ring.statistics().pendingCopyCount == 2);
+
+    ring.wait(ring.flush());
+    ring.reclaim();
+    CHECK(ring.statistics().used == 0 && ring.statistics().batchesInFlight == 0);
+}
+
+D14_TEST(LargeUploadIsSplit)
+{
+    std::mt19937_64 rng(44);
+
+    SimulatedQueue queue(4096);
+    UploadRing ring(&queue, queue.staging.data(), queue.staging.size());
+
+    auto source = randomBytes(rng, 10000);
+    Buffer destination(source.size());
+
+    // The ticket covers the last chunk, and the earlier ones go first.
+    ring.wait(ring.enqueue(&destination, 0, source.data(), source.size()));
+
+    CHECK(destination == source);
+    CHECK(ring.statistics().stallCount > 0 && queue.inBounds);
+}
+
+D14_TEST(RandomUploadsMatchReference)
+{
+    std::mt19937_64 rng(440);
+
+    SimulatedQueue queue(4096);
+    UploadRing ring(&queue, queue.staging.data(), queue.staging.size());
+
+    std::vector<Buffer> destinations(8, Buffer(2048)), references = destinations;
+
+    bool bounded = true, ordered = true;
+    for (int i = 0; i < 200000; ++i)
+    {
+        auto k = rng() % destinations.size();
+        uint64_t size = 1 + rng() % 600, offset = rng() % (2048 - size);
+
+        auto data = randomBytes(rng, size);
+        std::memcpy(references[k].data() + offset, data.data(), size);
+
+        auto ticket = ring.enqueue(&destinations[k], offset, data.data(), size);
+        ordered &= ticket >= ring.lastSubmitted();
+
+        // The GPU progresses at its own pace.
+        if (rng() % 8 == 0) ring.flush();
+        if (rng() % 3 == 0) queue.step();
+        if (rng() % 5 == 0) ring.reclaim();
+
+        auto statistics = ring.statistics();
+        bounded &= statistics.used <= statistics.capacity;
+    }
+    ring.wait(ring.flush());
+
+    CHECK(bounded && ordered && queue.inOrder && queue.inBounds);
+    CHECK(destinations == references);
+
+    auto statistics = ring.statistics();
+    CHECK(statistics.used == 0 && statistics.uploadedSize > 0);
+}
+
+D14_BENCH(SmallUploads)
+{
+    std::mt19937_64 rng(2044);
+
+    SimulatedQueue queue(1 << 20);
+    UploadRing ring(&queue, queue.staging.data(), queue.staging.size(), 256);
+
+    Buffer destination(1 << 16);
+    auto data = randomBytes(rng, 256);
+
+    // 64 constant buffers per frame, with the GPU 2 frames behind.
+    size_t offset = 0;
+    double us = unit_test::measure(10000, [&]
+    {
+        for (int i = 0; i < 64; ++i)
+        {
+            ring.enqueue(&destination, offset, data.data(), data.size());
+            offset = (offset + 256) % destination.size();
+        }
+        ring.flush();
+        if (queue.inflight.size() > 2) queue.step();
+
+        ring.reclaim();
+    });
+    auto statistics = ring.statistics();
+    std::printf("  frame of 64 x 256 bytes: %.3f us, %.1f copies per batch, %llu stalls\n",
+                us, (double)queue.copyCallCount / (double)statistics.batchCount, (unsigned long long)statistics.stallCount);
+}
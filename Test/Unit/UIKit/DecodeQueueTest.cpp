@@ -0,0 +1,204 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/DecodeQueue.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::image_utils;
+
+namespace
+{
+    // Records the decoded paths, and throws for the path "bad".
+    struct FakeDecoder
+    {
+        std::mutex mutex = {};
+        std::vector<Wstring> order = {};
+
+        DecodeQueue::Decoder decoder()
+        {
+            return [this](const DecodeQueue::Request& request)
+            {
+                {
+                    std::lock_guard lock(mutex);
+                    order.push_back(request.path);
+                }
+                if (request.path == L"bad") throw std::runtime_error("bad image");
+                return DecodeQueue::Image{ 1, 1, { 1, 2, 3, 4 } };
+            };
+        }
+    };
+}
+
+D14_TEST(DecodesInOrderOfPriorityThenSubmission)
+{
+    FakeDecoder fake = {};
+    DecodeQueue queue(fake.decoder(), 0);
+
+    queue.submit({ L"a" });
+    queue.submit({ L"b" });
+    queue.submit({ L"c" }, 5);
+    queue.submit({ L"d" });
+
+    while (queue.decodeNext());
+
+    CHECK((fake.order == std::vector<Wstring>{ L"c", L"a", L"b", L"d" }));
+    CHECK(queue.takeResults().size() == 4);
+}
+
+D14_TEST(PendingTaskCanBeBoosted)
+{
+    FakeDecoder fake = {};
+    DecodeQueue queue(fake.decoder(), 0);
+
+    auto a = queue.submit({ L"a" });
+    auto b = queue.submit({ L"b" });
+    queue.submit({ L"c" }, 5);
+
+    CHECK(queue.setPriority(b, 10));
+    CHECK(queue.decodeNext());
+    CHECK(fake.order.back() == L"b");
+
+    // Demoted below the default priority.
+    CHECK(queue.setPriority(a, -1));
+    while (queue.decodeNext());
+
+    CHECK((fake.order == std::vector<Wstring>{ L"b", L"c", L"a" }));
+
+    // A finished task can no longer be re-prioritized.
+    CHECK(queue.state(a) == DecodeQueue::State::Finished);
+    CHECK(!queue.setPriority(a, 3));
+}
+
+D14_TEST(CancelledTaskIsNeverDecoded)
+{
+    FakeDecoder fake = {};
+    DecodeQueue queue(fake.decoder(), 0);
+
+    auto a = queue.submit({ L"a" });
+    auto b = queue.submit({ L"b" });
+    auto c = queue.submit({ L"c" });
+
+    queue.cancel(b);
+    CHECK(queue.state(b) == DecodeQueue::State::Unknown);
+    CHECK(queue.pendingCount() == 2);
+
+    while (queue.decodeNext());
+    CHECK((fake.order == std::vector<Wstring>{ L"a", L"c" }));
+
+    // Cancelling a finished task drops its result.
+    queue.cancel(c);
+    auto results = queue.takeResults();
+
+    CHECK(results.size() == 1 && results.front().ticket == a);
+    CHECK(queue.state(a) == DecodeQueue::State::Unknown);
+
+    queue.submit({ L"d" });
+    queue.submit({ L"e" });
+    queue.cancelAll();
+
+    CHECK(queue.pendingCount() == 0);
+    CHECK(!queue.decodeNext());
+}
+
+D14_TEST(DecoderErrorIsReported)
+{
+    FakeDecoder fake = {};
+    DecodeQueue queue(fake.decoder(), 0);
+
+    auto good = queue.submit({ L"good" });
+    auto bad = queue.submit({ L"bad" });
+
+    while (queue.decodeNext());
+
+    for (auto& result : queue.takeResults())
+    {
+        if (result.ticket == bad)
+        {
+            CHECK(!result.image.has_value() && result.error != nullptr);
+            CHECK(result.request.path == L"bad");
+        }
+        else
+        {
+            CHECK(result.ticket == good);
+            CHECK(result.image.has_value() && result.image->pixels.size() == 4);
+        }
+    }
+}
+
+D14_TEST(WorkersDecodeAllButCancelled)
+{
+    std::atomic<int> decodedCount = 0, notifiedCount = 0;
+
+    DecodeQueue queue([&](const DecodeQueue::Request&)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ++decodedCount;
+        return DecodeQueue::Image{};
+    },
+    4, [&] { ++notifiedCount; });
+
+    std::vector<DecodeQueue::Ticket> tickets = {};
+    for (int i = 0; i < 200; ++i)
+    {
+        tickets.push_back(queue.submit({ L"x" }, i % 7));
+    }
+    for (size_t i = 0; i < tickets.size(); i += 3) queue.cancel(tickets[i]);
+
+    std::set<DecodeQueue::Ticket> finished = {};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    // The 67 cancelled ones may or may not have been started already.
+    while (finished.size() < 133 && std::chrono::steady_clock::now() < deadline)
+    {
+        for (auto& result : queue.takeResults()) finished.insert(result.ticket);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(finished.size() == 133);
+    for (size_t i = 0; i < tickets.size(); i += 3)
+    {
+        CHECK(!finished.contains(tickets[i]));
+    }
+    CHECK(decodedCount >= 133 && notifiedCount >= 133);
+}
+
+D14_TEST(DestructorDropsPendingTasks)
+{
+    std::atomic<int> decodedCount = 0;
+    {
+        DecodeQueue queue([&](const DecodeQueue::Request&)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            ++decodedCount;
+            return DecodeQueue::Image{};
+        },
+        2);
+        for (int i = 0; i < 100; ++i) queue.submit({ L"x" });
+    }
+    CHECK(decodedCount < 100);
+}
+
+D14_BENCH(SubmitAndReprioritizeTenThousand)
+{
+    DecodeQueue queue([](const DecodeQueue::Request&) { return DecodeQueue::Image{}; }, 0);
+
+    std::vector<DecodeQueue::Ticket> tickets(10000);
+    double us = unit_test::measure(1, [&]
+    {
+        for (auto& ticket : tickets) ticket = queue.submit({ L"x" });
+    });
+    std::printf("  submit: %.3f us/task\n", us / tickets.size());
+
+    // Emulates the items scrolling in and out of the view.
+    us = unit_test::measure(1, [&]
+    {
+        for (size_t i = 0; i < tickets.size(); ++i)
+        {
+            queue.setPriority(tickets[(i * 7919) % tickets.size()], (int)(i % 100));
+        }
+    });
+    std::printf("  setPriority: %.3f us/task\n", us / tickets.size());
+
+    us = unit_test::measure(1, [&] { while (queue.decodeNext()); });
+    std::printf("  decodeNext: %.3f us/task\n", us / tickets.size());
+}
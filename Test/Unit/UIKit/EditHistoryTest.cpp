@@ -0,0 +1,178 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "UIKit/TextUtils/EditHistory.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::text_utils;
+
+namespace
+{
+    struct Buffer
+    {
+        Wstring text = {};
+
+        EditHistory history = {};
+
+        EditHistory::TimePoint now = EditHistory::Clock::now();
+
+        void apply(const EditHistory::Delta& delta)
+        {
+            if (delta.type == EditHistory::Delta::Type::Insert)
+            {
+                text.insert(delta.offset, delta.text);
+            }
+            else text.erase(delta.offset, delta.text.size());
+        }
+        void insert(size_t offset, WstrRefer fragment)
+        {
+            text.insert(offset, fragment);
+            history.recordInsert(offset, fragment, now);
+        }
+        void erase(size_t offset, size_t count)
+        {
+            auto fragment = text.substr(offset, count);
+            text.erase(offset, count);
+            history.recordErase(offset, fragment, now);
+        }
+        Optional<size_t> undo()
+        {
+            return history.undo([this](const EditHistory::Delta& d) { apply(d); });
+        }
+        Optional<size_t> redo()
+        {
+            return history.redo([this](const EditHistory::Delta& d) { apply(d); });
+        }
+    };
+}
+
+D14_TEST(TypingMergesAndBreaksAtWords)
+{
+    Buffer b = {};
+    Wstring typed = L"hello world";
+    for (size_t i = 0; i < typed.size(); ++i)
+    {
+        b.insert(i, typed.substr(i, 1));
+    }
+    CHECK(b.history.undoCount() == 2);
+
+    auto caret = b.undo();
+    CHECK(b.text == L"hello " && caret == 6u);
+
+    caret = b.redo();
+    CHECK(b.text == L"hello world" && caret == 11u);
+}
+
+D14_TEST(BackspacingMergesIntoOneGroup)
+{
+    Buffer b = {};
+    b.insert(0, L"hello world");
+    b.history.seal();
+
+    for (int i = 0; i < 3; ++i) b.erase(b.text.size() - 1, 1);
+    CHECK(b.text == L"hello wo");
+    CHECK(b.history.undoCount() == 2);
+
+    b.undo();
+    CHECK(b.text == L"hello world");
+}
+
+D14_TEST(CompoundGroupUndoesAsWhole)
+{
+    Buffer b = {};
+    b.insert(0, L"hello world");
+
+    b.history.beginGroup();
+    b.erase(0, 5);
+    b.insert(0, L"bye");
+    b.history.endGroup();
+    CHECK(b.text == L"bye world");
+
+    auto caret = b.undo();
+    CHECK(b.text == L"hello world" && caret == 5u);
+    CHECK(b.history.redoCount() == 1);
+
+    // A new edit drops the redo branch.
+    b.insert(0, L"x");
+    CHECK(b.history.redoCount() == 0);
+}
+
+D14_TEST(MergeIntervalSplitsGroups)
+{
+    Buffer b = {};
+    b.insert(0, L"a");
+    b.now += std::chrono::seconds(5);
+    b.insert(1, L"b");
+    CHECK(b.history.undoCount() == 2);
+}
+
+D14_TEST(MemoryBudgetDropsOldestGroups)
+{
+    Buffer b = {};
+    for (int i = 0; i < 10; ++i)
+    {
+        b.insert(0, Wstring(100, L'a'));
+        b.history.seal();
+    }
+    b.history.setting.memoryBudget = b.history.memoryUsage() / 2;
+    b.insert(0, Wstring(100, L'b'));
+
+    CHECK(b.history.memoryUsage() <= b.history.setting.memoryBudget);
+    CHECK(b.history.undoCount() < 11);
+}
+
+D14_TEST(RandomEditsRoundTrip)
+{
+    std::mt19937 rng(26);
+    Buffer b = {};
+    std::vector<Wstring> snapshots = { b.text };
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        if (b.text.empty() || rng() % 3 != 0)
+        {
+            size_t offset = rng() % (b.text.size() + 1);
+            b.insert(offset, Wstring(1 + rng() % 3, (wchar_t)(L'a' + rng() % 26)));
+        }
+        else
+        {
+            size_t offset = rng() % b.text.size();
+            b.erase(offset, std::min<size_t>(1 + rng() % 4, b.text.size() - offset));
+        }
+        b.history.seal();
+        snapshots.push_back(b.text);
+    }
+    bool matched = true;
+    for (size_t i = snapshots.size() - 1; i > 0; --i)
+    {
+        b.undo();
+        matched &= b.text == snapshots[i - 1];
+    }
+    CHECK(matched);
+    CHECK(!b.history.canUndo());
+
+    for (size_t i = 1; i < snapshots.size(); ++i)
+    {
+        b.redo();
+        matched &= b.text == snapshots[i];
+    }
+    CHECK(matched);
+}
+
+D14_BENCH(TypingIntoLargeBuffer)
+{
+    // The deltas versus the snapshots of a 1 MB buffer.
+    Buffer b = {};
+    b.text.assign(1 << 20, L'x');
+
+    size_t count = 10000;
+    double us = unit_test::measure(count, [&]
+    {
+        b.insert(b.text.size() / 2, L"y");
+    });
+    std::printf("  %.3f us/keystroke, history %zu bytes (snapshots would take %zu MB)\n",
+                us, b.history.memoryUsage(), count * b.text.size() * sizeof(wchar_t) >> 20);
+}
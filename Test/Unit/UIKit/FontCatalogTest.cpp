@@ -0,0 +1,171 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/TextUtils/FontCatalog.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::text_utils;
+
+namespace
+{
+    using Origin = FontCatalog::Origin;
+
+    // A fake of the DirectWrite enumeration that counts the calls.
+    struct FakeSystem
+    {
+        std::atomic<int> sourceCalls = 0;
+
+        uint64_t fingerprint = 1;
+        bool hasFingerprint = true;
+
+        FontNameSet fonts = { { L"Segoe UI", L"en-us" }, { L"微软雅黑", L"zh-cn" } };
+
+        std::chrono::milliseconds delay = std::chrono::milliseconds(20);
+
+        FontCatalog::Source source()
+        {
+            return [this]
+            {
+                ++sourceCalls;
+                std::this_thread::sleep_for(delay);
+                return fonts;
+            };
+        }
+        FontCatalog::Fingerprint fingerprinter()
+        {
+            return [this]() -> Optional<uint64_t>
+            {
+                if (hasFingerprint) return fingerprint;
+                else return std::nullopt;
+            };
+        }
+    };
+
+    struct TempCache
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "D14FontCatalogTest.bin";
+
+        TempCache() { std::filesystem::remove(path); }
+        ~TempCache() { std::filesystem::remove(path); }
+
+        Origin load(FakeSystem& system, bool prefetch = false)
+        {
+            FontCatalog catalog(system.source(), system.fingerprinter());
+            catalog.setting.cacheFilePath = path.wstring();
+
+            if (prefetch) catalog.prefetch();
+            CHECK(catalog.fonts().size() == system.fonts.size());
+
+            return catalog.origin();
+        }
+    };
+}
+
+D14_TEST(PrefetchRunsInBackground)
+{
+    FakeSystem system = {};
+
+    FontCatalog catalog(system.source());
+    CHECK(catalog.origin() == Origin::None);
+
+    catalog.prefetch();
+    CHECK(catalog.isLoading());
+
+    CHECK(catalog.fonts() == system.fonts);
+    CHECK(catalog.isLoaded() && catalog.origin() == Origin::Source);
+    CHECK(system.sourceCalls == 1);
+
+    // The destructor waits for a pending prefetch.
+    FontCatalog pending(system.source());
+    pending.prefetch();
+}
+
+D14_TEST(CacheFollowsFingerprint)
+{
+    FakeSystem system = {};
+    TempCache cache = {};
+
+    CHECK(cache.load(system, true) == Origin::Source);
+    CHECK(cache.load(system) == Origin::Cache);
+    CHECK(system.sourceCalls == 1);
+
+    // The fonts are changed.
+    system.fingerprint = 2;
+    CHECK(cache.load(system, true) == Origin::Source);
+    CHECK(cache.load(system) == Origin::Cache);
+
+    system.hasFingerprint = false;
+    CHECK(cache.load(system) == Origin::Source);
+    CHECK(system.sourceCalls == 3);
+}
+
+D14_TEST(CorruptedCacheIsIgnored)
+{
+    FakeSystem system = {};
+    TempCache cache = {};
+
+    CHECK(FontCatalog::writeCache(cache.path.wstring(), 7, system.fonts));
+    CHECK(FontCatalog::readCache(cache.path.wstring(), 7) == system.fonts);
+    CHECK(!FontCatalog::readCache(cache.path.wstring(), 8).has_value());
+
+    auto size = std::filesystem::file_size(cache.path);
+    std::filesystem::resize_file(cache.path, size - 3);
+    CHECK(!FontCatalog::readCache(cache.path.wstring(), 7).has_value());
+
+    system.fingerprint = 7;
+    CHECK(cache.load(system) == Origin::Source);
+    CHECK(cache.load(system) == Origin::Cache);
+}
+
+D14_TEST(RefreshBypassesCache)
+{
+    FakeSystem system = {};
+    TempCache cache = {};
+
+    cache.load(system);
+
+    FontCatalog catalog(system.source(), system.fingerprinter());
+    catalog.setting.cacheFilePath = cache.path.wstring();
+
+    catalog.fonts();
+    CHECK(catalog.origin() == Origin::Cache);
+
+    system.fonts.insert({ L"New Font", L"en-us" });
+    CHECK(catalog.refresh().size() == 3);
+    CHECK(catalog.origin() == Origin::Source);
+}
+
+D14_TEST(SourceErrorPropagates)
+{
+    FontCatalog catalog([]() -> FontNameSet { throw std::runtime_error("enumeration failed"); });
+    catalog.prefetch();
+
+    bool thrown = false;
+    try { catalog.fonts(); }
+    catch (std::runtime_error&) { thrown = true; }
+
+    CHECK(thrown);
+}
+
+D14_BENCH(CacheOfThousandFonts)
+{
+    FakeSystem system = {};
+    system.delay = {};
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        system.fonts.insert({ L"Font Family " + std::to_wstring(i), i % 2 ? L"en-us" : L"zh-cn" });
+    }
+    TempCache cache = {};
+
+    double write = unit_test::measure(100, [&]
+    {
+        FontCatalog::writeCache(cache.path.wstring(), 1, system.fonts);
+    });
+    double read = unit_test::measure(100, [&]
+    {
+        unit_test::doNotOptimize(FontCatalog::readCache(cache.path.wstring(), 1));
+    });
+    std::printf("  write %.1f us, read %.1f us\n", write, read);
+}
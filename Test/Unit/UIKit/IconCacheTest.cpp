@@ -0,0 +1,158 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/IconCache.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::image_utils;
+
+namespace
+{
+    // "Missing" is missing, "Throw" throws, the names ending with '/' are
+    // animated with 3 frames, and the first byte of the others is 1 for
+    // the dark theme.
+    IconCache::Icon fakeIcon(WstrRefer theme, WstrRefer name)
+    {
+        if (name.back() == L'/')
+        {
+            std::vector<pixel_utils::Image> frames = {};
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                pixel_utils::Image frame(4 + i, 5);
+                std::fill(frame.pixels.begin(), frame.pixels.end(), (uint8_t)(i + 1));
+                frames.push_back(std::move(frame));
+            }
+            return IconCache::packFrames(frames);
+        }
+        pixel_utils::Image image(2, 2);
+        image.pixels[0] = theme == L"Dark";
+        return { image, 1 };
+    }
+
+    IconCache::Source fakeSource(std::chrono::milliseconds delay = {})
+    {
+        return [delay](WstrRefer theme, WstrRefer name) -> Optional<IconCache::Icon>
+        {
+            std::this_thread::sleep_for(delay);
+
+            if (name == L"Missing") return std::nullopt;
+            if (name == L"Throw") throw std::runtime_error("broken icon");
+
+            return fakeIcon(theme, name);
+        };
+    }
+
+    std::vector<Wstring> iconNames(size_t count)
+    {
+        std::vector<Wstring> names = {};
+        for (size_t i = 0; i < count; ++i) names.push_back(L"Icon" + std::to_wstring(i));
+        return names;
+    }
+}
+
+D14_TEST(ResolvesEachIconOnce)
+{
+    IconCache cache(fakeSource());
+
+    CHECK(!cache.isResolved(L"Light", L"Arrow"));
+
+    auto icon = cache.find(L"Light", L"Arrow");
+    CHECK(icon != nullptr && icon->sheet.pixels[0] == 0);
+
+    CHECK(cache.find(L"Light", L"Arrow") == icon);
+    CHECK(cache.find(L"Dark", L"Arrow")->sheet.pixels[0] == 1);
+    CHECK(cache.sourceCallCount() == 2);
+}
+
+D14_TEST(MissingIconIsCached)
+{
+    IconCache cache(fakeSource());
+
+    CHECK(cache.find(L"Light", L"Missing") == nullptr);
+    CHECK(cache.find(L"Light", L"Missing") == nullptr);
+
+    // A thrown error is resolved as missing as well.
+    CHECK(cache.find(L"Light", L"Throw") == nullptr);
+    CHECK(cache.find(L"Light", L"Throw") == nullptr);
+
+    CHECK(cache.isResolved(L"Light", L"Throw"));
+    CHECK(cache.sourceCallCount() == 2);
+}
+
+D14_TEST(FramesArePackedInCells)
+{
+    IconCache cache(fakeSource());
+
+    auto icon = cache.find(L"Light", L"Busy/");
+    if (!CHECK(icon != nullptr)) return;
+
+    // The cells take the largest frame (6 x 5).
+    CHECK(icon->frameCount == 3 && icon->frameWidth() == 6 && icon->sheet.height == 5);
+
+    auto sheet = icon->sheet.view();
+    CHECK(sheet.row(0)[2 * 6 * 4] == 3);
+    CHECK(sheet.row(4)[6 * 4 + 5 * 4 - 1] == 2);
+
+    // The padding of the smaller frame (4 wide in a 6 wide cell).
+    CHECK(sheet.row(0)[4 * 4] == 0);
+}
+
+D14_TEST(FindDuringPreload)
+{
+    IconCache cache(fakeSource(std::chrono::milliseconds(1)));
+
+    auto names = iconNames(50);
+    cache.preload(L"Dark", names);
+
+    CHECK(cache.isPreloading());
+
+    // Requested from the back, racing the worker going from the front.
+    bool found = true;
+    for (int i = 49; i >= 0; i -= 3)
+    {
+        auto icon = cache.find(L"Dark", names[i]);
+        found &= icon != nullptr && icon->sheet.pixels[0] == 1;
+    }
+    CHECK(found);
+
+    cache.waitForPreload();
+    CHECK(!cache.isPreloading());
+
+    bool resolved = true;
+    for (auto& name : names) resolved &= cache.isResolved(L"Dark", name);
+    CHECK(resolved);
+
+    // Each icon is resolved exactly once by either thread.
+    CHECK(cache.sourceCallCount() == 50);
+}
+
+D14_TEST(DestructorSkipsPendingPreload)
+{
+    std::atomic<int> callCount = 0;
+    {
+        IconCache cache([&](WstrRefer, WstrRefer) -> Optional<IconCache::Icon>
+        {
+            ++callCount;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return std::nullopt;
+        });
+        cache.preload(L"Light", iconNames(50));
+    }
+    CHECK(callCount < 50);
+}
+
+D14_BENCH(FindCachedIcons)
+{
+    IconCache cache(fakeSource());
+
+    auto names = iconNames(200);
+    for (auto& name : names) cache.find(L"Light", name);
+
+    size_t index = 0;
+    double us = unit_test::measure(100000, [&]
+    {
+        unit_test::doNotOptimize(cache.find(L"Light", names[index++ % names.size()]));
+    });
+    std::printf("  cached find: %.3f us\n", us);
+}
@@ -0,0 +1,235 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "UIKit/TextUtils/LineIndex.h"
+#include "UIKit/TextUtils/SyntaxHighlighter.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::text_utils;
+
+namespace
+{
+    using TokenArray = SyntaxLexer::TokenArray;
+
+    struct Document
+    {
+        Wstring text = {};
+
+        LineIndex index = {};
+
+        SyntaxHighlighter highlighter{ std::make_shared<CLikeLexer>() };
+
+        explicit Document(WstrRefer text) : text(text)
+        {
+            index.build(text);
+            highlighter.reset(index.lineCount());
+        }
+
+        WstringView line(size_t line) const
+        {
+            auto range = index.lineRange(line);
+            return WstringView(text).substr(range.offset, range.count);
+        }
+
+        SyntaxHighlighter::ChangeArray update(size_t lineLimit = SIZE_MAX)
+        {
+            return highlighter.update(lineLimit, [this](size_t l) { return line(l); });
+        }
+
+        void insert(size_t offset, WstrRefer fragment)
+        {
+            text.insert(offset, fragment);
+
+            auto change = index.onInsert(offset, fragment);
+            highlighter.replace(change.first, change.removed, change.inserted);
+        }
+
+        void erase(size_t offset, size_t count)
+        {
+            auto change = index.onErase(offset, WstringView(text).substr(offset, count));
+            text.erase(offset, count);
+
+            highlighter.replace(change.first, change.removed, change.inserted);
+        }
+
+        // Lexes all lines from scratch.
+        std::vector<TokenArray> lexAll() const
+        {
+            CLikeLexer lexer = {};
+            std::vector<TokenArray> lines = {};
+
+            auto state = SyntaxLexer::InitialState;
+            for (size_t i = 0; i < index.lineCount(); ++i)
+            {
+                state = lexer.lexLine(line(i), state, lines.emplace_back());
+            }
+            return lines;
+        }
+    };
+
+    Wstring sampleSource(size_t lineCount)
+    {
+        Wstring source = {};
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            source += i % 10 == 0
+                ? L"/* comment line */ int foo(int a, double b) { return a + 42; }\n"
+                : L"    auto value = compute(\"string\", 3.14f) + other; // trailing\n";
+        }
+        return source;
+    }
+}
+
+D14_TEST(LexesTokensOfOneLine)
+{
+    CLikeLexer lexer = {};
+    TokenArray tokens = {};
+
+    auto state = lexer.lexLine(L"int x = 0x1f; // hi", SyntaxLexer::InitialState, tokens);
+    CHECK(state == SyntaxLexer::InitialState);
+    CHECK(!tokens.empty() && tokens.front().kind == SyntaxKind::Keyword && tokens.front().count == 3);
+    CHECK(!tokens.empty() && tokens.back().kind == SyntaxKind::Comment && tokens.back().offset == 14);
+
+    bool hasNumber = false;
+    for (auto& token : tokens)
+    {
+        hasNumber |= token.kind == SyntaxKind::Number && token.offset == 8 && token.count == 4;
+    }
+    CHECK(hasNumber);
+}
+
+D14_TEST(CarriesStateAcrossLines)
+{
+    CLikeLexer lexer = {};
+    TokenArray tokens = {};
+
+    auto state = lexer.lexLine(L"a /* b", SyntaxLexer::InitialState, tokens);
+    CHECK(state != SyntaxLexer::InitialState);
+
+    tokens.clear();
+    state = lexer.lexLine(L"c */ return \"s\\\"x\";", state, tokens);
+    CHECK(state == SyntaxLexer::InitialState);
+    CHECK(!tokens.empty() && tokens.front().kind == SyntaxKind::Comment && tokens.front().count == 4);
+
+    tokens.clear();
+    state = lexer.lexLine(L"#define X \\", SyntaxLexer::InitialState, tokens);
+    CHECK(state != SyntaxLexer::InitialState);
+
+    tokens.clear();
+    state = lexer.lexLine(L"    1", state, tokens);
+    CHECK(state == SyntaxLexer::InitialState);
+    CHECK(!tokens.empty() && tokens.front().kind == SyntaxKind::Preprocessor);
+}
+
+D14_TEST(DiffCoversChangedSpan)
+{
+    TokenArray before = { { 0, 3, SyntaxKind::Keyword }, { 4, 2, SyntaxKind::Number } };
+    TokenArray after = { { 0, 3, SyntaxKind::Keyword }, { 4, 5, SyntaxKind::Comment } };
+
+    CHECK(!SyntaxHighlighter::diff(before, before).has_value());
+
+    auto span = SyntaxHighlighter::diff(before, after);
+    CHECK(span.has_value() && span->offset == 4 && span->count == 5);
+}
+
+D14_TEST(RandomEditsMatchFullLexing)
+{
+    // The fuzz of the incremental re-lexing against lexing from scratch.
+    Wstring pieces[] =
+    {
+        L"int", L" ", L"/*", L"*/", L"\n", L"\"", L"x", L"//", L"#", L"\\", L"1.5e+3", L"return"
+    };
+    std::mt19937 rng(28);
+
+    Wstring text = {};
+    for (int i = 0; i < 300; ++i) text += pieces[rng() % std::size(pieces)];
+
+    Document doc(text);
+    doc.update();
+
+    bool matched = true;
+    for (int i = 0; i < 3000; ++i)
+    {
+        if (doc.text.empty() || rng() % 2)
+        {
+            doc.insert(rng() % (doc.text.size() + 1), pieces[rng() % std::size(pieces)]);
+        }
+        else
+        {
+            auto offset = rng() % doc.text.size();
+            doc.erase(offset, std::min<size_t>(rng() % 4 + 1, doc.text.size() - offset));
+        }
+        // Sometimes leaves the lines after a random limit for later.
+        if (rng() % 3 == 0) doc.update(rng() % (doc.index.lineCount() + 1));
+
+        if (rng() % 5 == 0)
+        {
+            doc.update();
+            auto lines = doc.lexAll();
+
+            matched &= doc.highlighter.lexedLineCount() == lines.size();
+            for (size_t l = 0; l < lines.size() && matched; ++l)
+            {
+                matched &= lines[l] == doc.highlighter.tokens(l);
+            }
+        }
+    }
+    CHECK(matched);
+}
+
+D14_TEST(OpeningCommentStopsAtLimit)
+{
+    // Every 10th line closes the comment: "/* comment line */".
+    Document doc(sampleSource(1000));
+    doc.update();
+
+    doc.insert(doc.index.lineRange(501).offset, L"/*");
+
+    auto changes = doc.update(505);
+    CHECK(changes.size() == 4);
+    CHECK(doc.highlighter.lexedLineCount() == 505);
+
+    // Line 510 closes the comment with the same tokens, then converges.
+    changes = doc.update();
+    CHECK(changes.size() == 5);
+    CHECK(doc.highlighter.lexedLineCount() == doc.index.lineCount());
+
+    doc.erase(doc.index.lineRange(501).offset, 2);
+
+    changes = doc.update();
+    CHECK(changes.size() == 9);
+}
+
+D14_BENCH(HighlightHundredThousandLines)
+{
+    Document doc(sampleSource(100000));
+
+    auto elapsed = [](auto&& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto full = elapsed([&] { doc.update(); });
+
+    // Only the re-lexing is measured (not the edits of the text).
+    auto offset = doc.index.lineRange(50001).offset;
+
+    double typing = 0.0, comment = 0.0;
+    for (int i = 0; i < 100; ++i)
+    {
+        doc.insert(offset, L"x");
+        typing += elapsed([&] { unit_test::doNotOptimize(doc.update()); });
+
+        // Opens and closes a block comment with the lines in view.
+        doc.insert(offset, L"/*");
+        comment += elapsed([&] { unit_test::doNotOptimize(doc.update(50100)); });
+        doc.erase(offset, 2);
+        comment += elapsed([&] { unit_test::doNotOptimize(doc.update(50100)); });
+    }
+    std::printf("  full %.2f ms, typing %.3f us, block comment in view %.3f us\n",
+                full / 1000.0, typing / 100.0, comment / 200.0);
+}
@@ -0,0 +1,215 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "UIKit/TextUtils/BackgroundSearch.h"
+#include "UIKit/TextUtils/TextSearch.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::text_utils;
+
+namespace
+{
+    bool isWordCharacter(wchar_t ch)
+    {
+        return std::iswalnum(ch) || ch == L'_';
+    }
+
+    // The scalar reference of the non-overlapping literal matches.
+    TextSearch::MatchArray naiveFindAll(WstrViewRefer text, WstrViewRefer pattern, const TextSearchOptions& options)
+    {
+        TextSearch::MatchArray matches = {};
+        for (size_t pos = 0; pos + pattern.size() <= text.size();)
+        {
+            bool matched = true;
+            for (size_t i = 0; i < pattern.size() && matched; ++i)
+            {
+                if (options.matchCase) matched = text[pos + i] == pattern[i];
+                else matched = std::towlower(text[pos + i]) == std::towlower(pattern[i]);
+            }
+            if (matched && options.matchWholeWord)
+            {
+                auto end = pos + pattern.size();
+                matched = (pos == 0 || !isWordCharacter(text[pos - 1])) &&
+                          (end == text.size() || !isWordCharacter(text[end]));
+            }
+            if (matched)
+            {
+                matches.push_back({ pos, pattern.size() });
+                pos += pattern.size();
+            }
+            else ++pos;
+        }
+        return matches;
+    }
+
+    TextSearch::MatchArray searchInBackground(
+        const Wstring& text, const TextSearch& search, size_t chunkSize)
+    {
+        BackgroundSearch background = {};
+        background.setting.chunkSize = chunkSize;
+
+        background.start(std::make_shared<const Wstring>(text), search);
+        while (background.isRunning()) std::this_thread::yield();
+
+        return background.takeMatches();
+    }
+
+    Wstring randomText(std::mt19937& rng, size_t length, WstrViewRefer alphabet)
+    {
+        Wstring text(length, L' ');
+        for (auto& ch : text) ch = alphabet[rng() % alphabet.size()];
+        return text;
+    }
+}
+
+D14_TEST(LiteralMatchesNaiveSearch)
+{
+    std::mt19937 rng(29);
+
+    bool matched = true;
+    for (int i = 0; i < 500; ++i)
+    {
+        // Long enough to cover the SIMD blocks and the scalar tails.
+        auto text = randomText(rng, rng() % 200, L"abAB _\néK");
+        auto pattern = randomText(rng, 1 + rng() % 3, L"abAB _k");
+
+        TextSearchOptions options = {};
+        options.matchCase = rng() % 2;
+        options.matchWholeWord = rng() % 2;
+
+        TextSearch search(pattern, options);
+        matched &= search.findAll(text) == naiveFindAll(text, pattern, options);
+    }
+    CHECK(matched);
+}
+
+D14_TEST(FindNextAndPrev)
+{
+    Wstring text = L"one two one three one";
+    TextSearch search(L"one");
+
+    auto next = search.findNext(text, 1);
+    CHECK(next.has_value() && next->offset == 8);
+
+    auto prev = search.findPrev(text, 8);
+    CHECK(prev.has_value() && prev->offset == 0);
+
+    CHECK(!search.findNext(text, 19).has_value());
+
+    TextSearch regex(L"t\\w+", { .useRegex = true });
+    auto match = regex.findNext(text, 5);
+    CHECK(match.has_value() && match->offset == 12 && match->count == 5);
+
+    CHECK(!TextSearch(L"(", { .useRegex = true }).valid());
+    CHECK(!TextSearch(L"").valid());
+}
+
+D14_TEST(ReplaceAll)
+{
+    size_t count = 0;
+
+    auto result = TextSearch(L"cat", { .matchWholeWord = true }).replaceAll(L"cat concat cat", L"dog", &count);
+    CHECK(result == L"dog concat dog" && count == 2);
+
+    result = TextSearch(L"(\\d+)-(\\d+)", { .useRegex = true }).replaceAll(L"1-2 and 30-40", L"$2-$1", &count);
+    CHECK(result == L"2-1 and 40-30" && count == 2);
+}
+
+D14_TEST(RegexReplaceAcrossChunks)
+{
+    // Many chunks of short lines, so that the chunked replacement must
+    // give the same result as a one-pass std::regex_replace.
+    std::mt19937 rng(2900);
+    auto text = randomText(rng, 300 * 1000, L"ab12 _\n");
+
+    std::wregex regex(L"([ab]+)(\\d+)");
+    auto expected = std::regex_replace(text, regex, L"$2<$1>");
+
+    size_t count = 0;
+    auto result = TextSearch(L"([ab]+)(\\d+)", { .useRegex = true }).replaceAll(text, L"$2<$1>", &count);
+
+    CHECK(result == expected);
+    CHECK(count == (size_t)std::distance(std::wsregex_iterator(text.begin(), text.end(), regex), std::wsregex_iterator()));
+}
+
+D14_TEST(ChunkedSearchEqualsOnePass)
+{
+    // The matches that run across the chunk boundaries must not produce
+    // overlapped ones in the next chunk (e.g. "aa" in "aaaaa"). A regex
+    // match never spans lines in the chunked search (see findAll).
+    std::mt19937 rng(290);
+
+    bool matched = true;
+    for (int i = 0; i < 200; ++i)
+    {
+        auto text = randomText(rng, rng() % 300, L"aab\n");
+
+        TextSearch literal(randomText(rng, 1 + rng() % 4, L"aab"));
+        TextSearch regex(L"a+b?|ba", { .useRegex = true });
+
+        auto chunkSize = 1 + rng() % 17;
+
+        matched &= searchInBackground(text, literal, chunkSize) == literal.findAll(text);
+        matched &= searchInBackground(text, regex, chunkSize) == regex.findAll(text);
+    }
+    CHECK(matched);
+}
+
+D14_TEST(CancelStopsWorker)
+{
+    auto text = std::make_shared<const Wstring>(Wstring(4 * 1024 * 1024, L'a'));
+
+    BackgroundSearch background = {};
+    background.setting.chunkSize = 1024;
+
+    std::atomic<size_t> notifications = 0;
+    background.start(text, TextSearch(L"a"), [&] { ++notifications; });
+
+    background.cancel();
+    CHECK(!background.isRunning());
+    CHECK(background.progress() < text->size());
+
+    // A new search after the request takes over cleanly.
+    background.start(text, TextSearch(L"b"));
+    background.requestCancel();
+    background.start(text, TextSearch(L"aaaa"));
+    while (background.isRunning()) std::this_thread::yield();
+
+    CHECK(background.takeMatches().size() == text->size() / 4);
+}
+
+D14_BENCH(SearchTwentyMillionCharacters)
+{
+    std::mt19937 rng(2029);
+    auto text = randomText(rng, 20 * 1000 * 1000, L"abcdefghijklmnopqrstuvwxyz    \n");
+    for (size_t i = 0; i + 6 < text.size(); i += 10007) text.replace(i, 6, L"needle");
+
+    for (bool matchCase : { true, false })
+    {
+        TextSearch search(L"needle", { .matchCase = matchCase });
+
+        TextSearch::MatchArray matches = {};
+        double us = unit_test::measure(5, [&] { matches = search.findAll(text); });
+
+        std::printf("  %s: %.2f ms (%zu matches)\n",
+                    matchCase ? "literal" : "case-insensitive", us / 1000.0, matches.size());
+    }
+    for (bool useRegex : { false, true })
+    {
+        TextSearch search(useRegex ? L"ne(e)dle" : L"needle", { .useRegex = useRegex });
+
+        size_t count = 0;
+        double us = unit_test::measure(3, [&] { unit_test::doNotOptimize(search.replaceAll(text, L"pin", &count)); });
+
+        std::printf("  replace %s: %.2f ms (%zu replaced)\n", useRegex ? "regex" : "literal", us / 1000.0, count);
+    }
+    auto snapshot = std::make_shared<const Wstring>(text);
+    double us = unit_test::measure(5, [&]
+    {
+        unit_test::doNotOptimize(searchInBackground(*snapshot, TextSearch(L"needle"), 1024 * 1024));
+    });
+    std::printf("  background: %.2f ms\n", us / 1000.0);
+}
@@ -0,0 +1,200 @@
+﻿#include "Common/Precompile.h"
+
+#include "UIKit/ImageUtils/ThumbnailStore.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::image_utils;
+
+namespace
+{
+    constexpr size_t g_thumbnailBytes = 64 * 64 * 4;
+
+    struct TempStore
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "D14ThumbnailStoreTest";
+
+        TempStore() { std::filesystem::remove_all(path); }
+        ~TempStore() { std::filesystem::remove_all(path); }
+
+        Wstring directory() const { return path.wstring(); }
+    };
+
+    pixel_utils::Image filledImage(uint32_t width, uint32_t height, uint8_t value)
+    {
+        pixel_utils::Image image(width, height);
+        std::fill(image.pixels.begin(), image.pixels.end(), value);
+        return image;
+    }
+
+    ThumbnailStore::Key thumbnailKey(int index)
+    {
+        return { L"/image/" + std::to_wstring(index) + L".png", 100u + index, 5, 64, 64 };
+    }
+
+    bool holds(const ThumbnailStore& store, int index, uint8_t value)
+    {
+        auto image = store.find(thumbnailKey(index));
+        return image.has_value() && image->width == 64 && image->pixels[123] == value;
+    }
+}
+
+D14_TEST(PersistsAcrossInstances)
+{
+    TempStore temp = {};
+    {
+        ThumbnailStore store(temp.directory(), g_thumbnailBytes * 10);
+        for (int i = 0; i < 8; ++i)
+        {
+            CHECK(store.insert(thumbnailKey(i), filledImage(64, 64, (uint8_t)i).view()));
+        }
+        CHECK(store.size() == 8 && holds(store, 3, 3));
+        CHECK(store.flush());
+    }
+    ThumbnailStore store(temp.directory(), g_thumbnailBytes * 10);
+
+    CHECK(store.size() == 8);
+    CHECK(holds(store, 5, 5));
+}
+
+D14_TEST(EvictsLeastRecentlyUsed)
+{
+    TempStore temp = {};
+    ThumbnailStore store(temp.directory(), g_thumbnailBytes * 10);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        CHECK(store.insert(thumbnailKey(i), filledImage(64, 64, (uint8_t)i).view()));
+    }
+    store.find(thumbnailKey(0));
+
+    for (int i = 10; i < 13; ++i)
+    {
+        CHECK(store.insert(thumbnailKey(i), filledImage(64, 64, (uint8_t)i).view()));
+    }
+    CHECK(store.usage() <= g_thumbnailBytes * 10);
+    CHECK(store.contains(thumbnailKey(0)) && store.contains(thumbnailKey(12)));
+    CHECK(!store.contains(thumbnailKey(1)));
+
+    // Larger than the whole budget.
+    CHECK(!store.insert(thumbnailKey(99), filledImage(256, 256, 1).view()));
+}
+
+D14_TEST(ChangedFileIsStale)
+{
+    TempStore temp = {};
+    ThumbnailStore store(temp.directory());
+
+    CHECK(store.insert(thumbnailKey(0), filledImage(64, 64, 7).view()));
+
+    auto key = thumbnailKey(0);
+    key.modifiedTime = 6;
+    CHECK(!store.find(key).has_value());
+
+    key = thumbnailKey(0);
+    key.maxWidth = 32;
+    CHECK(!store.find(key).has_value());
+}
+
+D14_TEST(CompactionKeepsLatestPixels)
+{
+    TempStore temp = {};
+    {
+        ThumbnailStore store(temp.directory(), g_thumbnailBytes * 50);
+
+        // Replaces each of the 400 keys several times to pile up dead records.
+        for (int i = 0; i < 3000; ++i)
+        {
+            CHECK(store.insert(thumbnailKey(i % 400), filledImage(64, 64, (uint8_t)i).view()));
+        }
+        CHECK(store.packSize() < g_thumbnailBytes * 50 * 4);
+
+        bool latest = true;
+        for (int i = 2960; i < 3000; ++i) latest &= holds(store, i % 400, (uint8_t)i);
+        CHECK(latest);
+
+        store.compact();
+
+        latest = true;
+        for (int i = 2960; i < 3000; ++i) latest &= holds(store, i % 400, (uint8_t)i);
+        CHECK(latest);
+    }
+    ThumbnailStore store(temp.directory(), g_thumbnailBytes * 50);
+    CHECK(holds(store, 2999 % 400, (uint8_t)2999));
+}
+
+D14_TEST(CorruptedIndexStartsOver)
+{
+    TempStore temp = {};
+    {
+        ThumbnailStore store(temp.directory());
+        CHECK(store.insert(thumbnailKey(0), filledImage(64, 64, 1).view()));
+    }
+    {
+        std::ofstream file(temp.path / "thumbnails.index", std::ios::binary | std::ios::trunc);
+        file << "garbage";
+    }
+    ThumbnailStore store(temp.directory());
+
+    CHECK(store.size() == 0);
+    CHECK(store.insert(thumbnailKey(1), filledImage(8, 8, 1).view()));
+}
+
+D14_TEST(ConcurrentReadersSeeWholeThumbnails)
+{
+    TempStore temp = {};
+    ThumbnailStore store(temp.directory(), g_thumbnailBytes * 30);
+
+    std::atomic<int> tornCount = 0;
+    std::vector<std::thread> threads = {};
+
+    // 2 writers and 4 readers over 60 keys (of which 30 fit).
+    for (int t = 0; t < 6; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (int i = 0; i < 1500; ++i)
+            {
+                int index = (i * 7 + t) % 60;
+                if (t < 2)
+                {
+                    store.insert(thumbnailKey(index), filledImage(64, 64, (uint8_t)index).view());
+                }
+                else if (store.contains(thumbnailKey(index)))
+                {
+                    auto image = store.find(thumbnailKey(index));
+                    if (image.has_value() && image->pixels[123] != (uint8_t)index) ++tornCount;
+                }
+                if (t == 0 && i % 500 == 0) store.flush();
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    CHECK(tornCount == 0);
+}
+
+D14_BENCH(FindAndInsertThumbnails)
+{
+    TempStore temp = {};
+    ThumbnailStore store(temp.directory(), g_thumbnailBytes * 1000);
+
+    auto image = filledImage(64, 64, 9);
+
+    int index = 0;
+    double us = unit_test::measure(1000, [&]
+    {
+        store.insert(thumbnailKey(index++), image.view());
+    });
+    std::printf("  insert: %.2f us\n", us);
+
+    us = unit_test::measure(10000, [&]
+    {
+        unit_test::doNotOptimize(store.find(thumbnailKey(index++ % 1000)));
+    });
+    std::printf("  find: %.2f us\n", us);
+
+    us = unit_test::measure(10, [&] { store.flush(); });
+    std::printf("  flush (1000 entries): %.2f ms\n", us / 1000.0);
+}
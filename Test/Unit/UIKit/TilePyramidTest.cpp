@@ -0,0 +1,220 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "Common/PixelUtils/MipChain.h"
+
+#include "UIKit/ImageUtils/TileCache.h"
+#include "UIKit/ImageUtils/TilePyramid.h"
+#include "UIKit/ImageUtils/TileScheduler.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::image_utils;
+
+namespace
+{
+    pixel_utils::Image randomImage(std::mt19937& rng, uint32_t width, uint32_t height)
+    {
+        pixel_utils::Image image(width, height);
+        for (auto& byte : image.pixels) byte = (uint8_t)rng();
+        return image;
+    }
+
+    // Emulates TiledImageView::buildCoarseLevels without the decoder:
+    // level 1 is halved strip by strip, and the others from the level below.
+    std::vector<pixel_utils::Image> buildCoarseLevels(
+        const pixel_utils::Image& image, const TilePyramid& pyramid, uint32_t stripHeight)
+    {
+        std::vector<pixel_utils::Image> levels = {};
+        if (pyramid.levelCount() <= 1) return levels;
+
+        auto levelSize = pyramid.levelSize(1);
+        levels.emplace_back(levelSize.width, levelSize.height);
+
+        for (uint32_t top = 0; top < image.height; top += stripHeight)
+        {
+            auto rowCount = std::min(stripHeight, image.height - top);
+
+            pixel_utils::ImageView strip = { image.pixels.data() + top * image.pitch(), image.width, rowCount, image.pitch() };
+            auto half = pixel_utils::halveRoundingUp(strip);
+
+            std::copy(half.pixels.begin(), half.pixels.end(), levels.front().row(top / 2));
+        }
+        for (uint32_t level = 2; level < pyramid.levelCount(); ++level)
+        {
+            levels.push_back(pixel_utils::halveRoundingUp(levels.back().view()));
+        }
+        return levels;
+    }
+}
+
+D14_TEST(LevelsHalveRoundingUp)
+{
+    TilePyramid pyramid(30000, 30000, 256);
+
+    // 30000 / 2^7 = 234.4 rounds up to 235, which fits in a tile.
+    CHECK(pyramid.levelCount() == 8);
+    CHECK(pyramid.levelSize(7).width == 235);
+    CHECK(pyramid.tileCount(0).width == 118);
+
+    auto rect = pyramid.sourceRect({ 0, 117, 117 });
+    CHECK(rect.left == 117 * 256 && rect.right == 30000);
+    CHECK(pyramid.sourceRect({ 7, 0, 0 }).right == 30000);
+
+    CHECK(TilePyramid(100, 50).levelCount() == 1);
+    CHECK(TilePyramid(0, 0).levelCount() == 0);
+}
+
+D14_TEST(LevelForScale)
+{
+    TilePyramid pyramid(30000, 30000, 256);
+
+    CHECK(pyramid.levelForScale(1.0f) == 0);
+    CHECK(pyramid.levelForScale(0.6f) == 0);
+    CHECK(pyramid.levelForScale(0.5f) == 1);
+    CHECK(pyramid.levelForScale(0.3f) == 1);
+    CHECK(pyramid.levelForScale(0.25f) == 2);
+    CHECK(pyramid.levelForScale(0.0001f) == 7);
+}
+
+D14_TEST(ParentCoversChild)
+{
+    TilePyramid pyramid(30000, 17000, 256);
+
+    for (uint32_t level = 0; level < pyramid.levelCount(); ++level)
+    {
+        auto count = pyramid.tileCount(level);
+        for (uint32_t x = 0; x < count.width; x += 7)
+        {
+            for (uint32_t y = 0; y < count.height; y += 5)
+            {
+                TileKey key = { level, x, y };
+                CHECK(TileKey::unpack(key.packed()) == key);
+
+                auto parent = pyramid.parent(key);
+                if (!parent.has_value())
+                {
+                    CHECK(level + 1 == pyramid.levelCount()); continue;
+                }
+                CHECK(pyramid.contains(parent.value()));
+
+                auto child = pyramid.sourceRect(key);
+                auto cover = pyramid.sourceRect(parent.value());
+
+                CHECK(cover.left <= child.left && cover.top <= child.top &&
+                      cover.right >= child.right && cover.bottom >= child.bottom);
+            }
+        }
+    }
+}
+
+D14_TEST(TilesInArea)
+{
+    TilePyramid pyramid(30000, 30000, 256);
+
+    auto range = pyramid.tilesInArea(0, { 100.0f, 100.0f, 700.0f, 300.0f });
+    CHECK(range.left == 0 && range.right == 3 && range.top == 0 && range.bottom == 2);
+
+    range = pyramid.tilesInArea(0, { 100.0f, 100.0f, 700.0f, 300.0f }, 1);
+    CHECK(range.left == 0 && range.right == 4);
+}
+
+D14_TEST(SchedulerPutsFallbackFirst)
+{
+    TilePyramid pyramid(30000, 30000, 256);
+    TileScheduler scheduler = {};
+
+    auto requests = scheduler.plan(pyramid, { 5000.0f, 5000.0f, 6000.0f, 5800.0f }, 1.0f);
+
+    CHECK(requests.size() > 2);
+    CHECK(requests[0].category == TileScheduler::Category::Fallback);
+    CHECK(requests[0].key == (TileKey{ 7, 0, 0 }));
+    CHECK(requests[1].category == TileScheduler::Category::Visible);
+
+    std::set<uint64_t> keys = {};
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (i > 0) CHECK(requests[i - 1].priority >= requests[i].priority);
+        CHECK(keys.insert(requests[i].key.packed()).second);
+    }
+    TilePyramid single(100, 50);
+    CHECK(scheduler.plan(single, { 0.0f, 0.0f, 100.0f, 50.0f }, 1.0f).size() == 1);
+}
+
+D14_TEST(CacheEvictsLeastRecentlyUsed)
+{
+    TileCache<int> cache(100);
+
+    cache.insert({ 0, 0, 0 }, 1, 40);
+    cache.insert({ 0, 1, 0 }, 2, 40);
+    cache.find({ 0, 0, 0 });
+    cache.insert({ 0, 2, 0 }, 3, 40);
+
+    CHECK(cache.contains({ 0, 0, 0 }) && !cache.contains({ 0, 1, 0 }));
+    CHECK(cache.usage() == 80);
+
+    // The newest tile is kept even if it exceeds the whole budget.
+    cache.insert({ 0, 3, 0 }, 4, 500);
+    CHECK(cache.size() == 1 && cache.usage() == 500);
+
+    cache.insert({ 0, 4, 0 }, 5, 10);
+    CHECK(cache.size() == 1 && cache.usage() == 10);
+
+    cache.setBudget(5);
+    CHECK(cache.size() == 0 && cache.usage() == 0);
+}
+
+D14_TEST(HalveRoundingUpRepeatsEdges)
+{
+    // 3 x 1: the last column and the only row are repeated.
+    pixel_utils::Image image(3, 1);
+    for (uint32_t x = 0; x < 3; ++x)
+    {
+        std::fill_n(image.row(0) + x * 4, 4, (uint8_t)(x * 100));
+    }
+    auto half = pixel_utils::halveRoundingUp(image.view());
+
+    CHECK(half.width == 2 && half.height == 1);
+    CHECK(half.row(0)[0] == 50 && half.row(0)[4] == 200);
+}
+
+D14_TEST(StripLevelsMatchPyramid)
+{
+    std::mt19937 rng(32);
+
+    for (auto [width, height] : { std::pair{ 1000u, 777u }, { 513u, 1025u }, { 64u, 3u } })
+    {
+        TilePyramid pyramid(width, height, 64);
+
+        auto image = randomImage(rng, width, height);
+        auto levels = buildCoarseLevels(image, pyramid, 64);
+
+        if (!CHECK(levels.size() + 1 == pyramid.levelCount())) continue;
+
+        for (uint32_t level = 1; level < pyramid.levelCount(); ++level)
+        {
+            auto size = pyramid.levelSize(level);
+            CHECK(levels[level - 1].width == size.width && levels[level - 1].height == size.height);
+        }
+        // Even strips never straddle a 2 x 2 box, so the result is exact.
+        if (!levels.empty())
+        {
+            CHECK(levels.front().pixels == pixel_utils::halveRoundingUp(image.view()).pixels);
+        }
+    }
+}
+
+D14_BENCH(BuildCoarseLevelsOf8kImage)
+{
+    std::mt19937 rng(2032);
+
+    TilePyramid pyramid(8192, 8192, 256);
+    auto image = randomImage(rng, 8192, 8192);
+
+    std::vector<pixel_utils::Image> levels = {};
+    double us = unit_test::measure(3, [&] { levels = buildCoarseLevels(image, pyramid, 64); });
+
+    std::printf("  %u levels: %.2f ms\n", pyramid.levelCount(), us / 1000.0);
+}
@@ -0,0 +1,279 @@
+﻿#include "Common/Precompile.h"
+
+#include <random>
+
+#include "UIKit/TextUtils/LineBlocks.h"
+#include "UIKit/TextUtils/LineIndex.h"
+#include "UIKit/TextUtils/VirtualLines.h"
+
+#include "UnitTest.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit::text_utils;
+
+namespace
+{
+    bool sameLines(const LineIndex& lhs, const LineIndex& rhs)
+    {
+        if (lhs.lineCount() != rhs.lineCount()) return false;
+        if (lhs.textLength() != rhs.textLength()) return false;
+
+        for (size_t i = 0; i < lhs.lineCount(); ++i)
+        {
+            auto a = lhs.lineRange(i), b = rhs.lineRange(i);
+            if (a.offset != b.offset || a.count != b.count) return false;
+        }
+        return true;
+    }
+
+    VirtualLines::Extent fixedExtent(size_t line)
+    {
+        return { 100.0f, 20.0f };
+    }
+}
+
+D14_TEST(LineBlocksRandomEdits)
+{
+    // Large enough for the blocks to be split and dropped.
+    std::mt19937 rng(2027);
+
+    LineBlocks<size_t> blocks = {};
+    std::vector<size_t> reference = {};
+
+    blocks.assign(3000, 1);
+    reference.assign(3000, 1);
+
+    bool matched = true;
+    for (int i = 0; i < 3000; ++i)
+    {
+        auto index = rng() % (reference.size() + 1);
+        switch (rng() % 4)
+        {
+        case 0:
+        {
+            std::vector<size_t> items(rng() % 700);
+            for (auto& item : items) item = rng() % 10;
+
+            blocks.insertRange(index, items.begin(), items.end());
+            reference.insert(reference.begin() + index, items.begin(), items.end());
+            break;
+        }
+        case 1:
+        {
+            auto count = std::min<size_t>(rng() % 900, reference.size() - index);
+
+            blocks.erase(index, count);
+            reference.erase(reference.begin() + index, reference.begin() + index + count);
+            break;
+        }
+        default:
+        {
+            if (index == reference.size()) break;
+
+            auto value = (size_t)(rng() % 10);
+            blocks.modify(index, [&](size_t& item) { item = value; });
+            reference[index] = value;
+            break;
+        }
+        }
+        matched &= blocks.size() == reference.size();
+
+        auto n = rng() % (reference.size() + 1);
+        auto sum = std::accumulate(reference.begin(), reference.begin() + n, (size_t)0);
+        matched &= blocks.prefix(n) == sum;
+
+        // The longest prefix whose sum does not exceed the limit.
+        auto limit = sum + rng() % 5;
+        size_t count = 0, running = 0;
+        while (count < reference.size() && running + reference[count] <= limit)
+        {
+            running += reference[count++];
+        }
+        matched &= blocks.countWhile([&](size_t s, size_t) { return s <= limit; }) == count;
+
+        if (n < reference.size()) matched &= blocks[n] == reference[n];
+    }
+    CHECK(matched);
+}
+
+D14_TEST(LineIndexRanges)
+{
+    LineIndex index = {};
+    index.build(L"ab\ncd\n\nefg");
+
+    CHECK(index.lineCount() == 4);
+    CHECK(index.lineRange(0).offset == 0 && index.lineRange(0).count == 2);
+    CHECK(index.lineRange(2).offset == 6 && index.lineRange(2).count == 0);
+    CHECK(index.lineRange(3).offset == 7 && index.lineRange(3).count == 3);
+
+    CHECK(index.lineOfOffset(2) == 0);
+    CHECK(index.lineOfOffset(3) == 1);
+    CHECK(index.lineOfOffset(6) == 2);
+    CHECK(index.lineOfOffset(10) == 3);
+
+    index.build(L"ab\n");
+    CHECK(index.lineCount() == 2);
+    CHECK(index.lineOfOffset(3) == 1);
+    CHECK(index.lineRange(1).offset == 3 && index.lineRange(1).count == 0);
+}
+
+D14_TEST(LineIndexChanges)
+{
+    Wstring text = L"one\ntwo\nthree";
+    LineIndex index = {};
+    index.build(text);
+
+    auto change = index.onInsert(5, L"X\nY\n");
+    CHECK(change.first == 1 && change.removed == 1 && change.inserted == 3);
+
+    change = index.onInsert(0, L"abc");
+    CHECK(change.first == 0 && change.removed == 1 && change.inserted == 1);
+
+    // "abcone\ntX\nY\nwo\nthree": erases "X\nY\nw".
+    change = index.onErase(8, L"X\nY\nw");
+    CHECK(change.first == 1 && change.removed == 3 && change.inserted == 1);
+    CHECK(index.lineCount() == 3 && index.lineRange(1).count == 2);
+}
+
+D14_TEST(LineIndexRandomEdits)
+{
+    std::mt19937 rng(27);
+    Wstring text = L"ab\ncd\n\nefg";
+
+    LineIndex index = {};
+    index.build(text);
+
+    bool matched = true;
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (text.empty() || rng() % 2)
+        {
+            size_t offset = rng() % (text.size() + 1);
+            Wstring fragment = {};
+            for (int k = rng() % 6; k > 0; --k) fragment += rng() % 3 == 0 ? L'\n' : L'x';
+
+            text.insert(offset, fragment);
+            index.onInsert(offset, fragment);
+        }
+        else
+        {
+            size_t offset = rng() % text.size();
+            size_t count = rng() % std::min<size_t>(text.size() - offset + 1, 12);
+
+            auto fragment = text.substr(offset, count);
+            text.erase(offset, count);
+            index.onErase(offset, fragment);
+        }
+        LineIndex reference = {};
+        reference.build(text);
+
+        matched &= sameLines(index, reference);
+    }
+    CHECK(matched);
+}
+
+D14_TEST(VirtualLinesEstimation)
+{
+    VirtualLines lines = {};
+    lines.setting.initialLineHeight = 10.0f;
+    lines.reset(1000000);
+
+    CHECK(lines.totalHeight() == 10000000.0f);
+    CHECK(lines.lineAtOffset(25.0f) == 2);
+    CHECK(lines.lineTop(5) == 50.0f);
+
+    lines.measureVisibleRange(1000.0f, 100.0f, fixedExtent);
+    CHECK(lines.estimatedLineHeight() == 20.0f);
+
+    bool covered = true;
+    for (float y = 0.0f; y < 5000.0f; y += 7.3f)
+    {
+        auto line = lines.lineAtOffset(y);
+        covered &= lines.lineTop(line) <= y + 1e-3f;
+        covered &= lines.lineTop(line) + lines.lineHeight(line) > y - 1e-3f;
+    }
+    CHECK(covered);
+}
+
+D14_TEST(VirtualLinesRandomReplace)
+{
+    // The incremental trees must agree with the ones built from scratch.
+    std::mt19937 rng(270);
+
+    VirtualLines lines = {};
+    lines.reset(3000);
+
+    bool matched = true;
+    for (int i = 0; i < 2000; ++i)
+    {
+        auto count = lines.lineCount();
+        switch (rng() % 3)
+        {
+        case 0:
+        {
+            auto line = rng() % count;
+            lines.setMeasuredExtent(line, { 1.0f, (float)(1 + rng() % 40) });
+            break;
+        }
+        case 1:
+        {
+            auto first = rng() % count;
+            auto removed = std::min<size_t>(rng() % 4, count - first);
+            lines.replace(first, removed, removed);
+            break;
+        }
+        default:
+        {
+            auto first = rng() % count;
+            auto removed = std::min<size_t>(rng() % 4, count - first - 1);
+            lines.replace(first, removed, rng() % 4);
+            break;
+        }
+        }
+        VirtualLines reference = {};
+        reference.reset(lines.lineCount());
+        for (size_t line = 0; line < lines.lineCount(); ++line)
+        {
+            if (lines.isMeasured(line))
+            {
+                reference.setMeasuredExtent(line, { 1.0f, lines.lineHeight(line) });
+            }
+        }
+        auto probe = rng() % lines.lineCount();
+        matched &= std::abs(lines.totalHeight() - reference.totalHeight()) < 1e-2f;
+        matched &= std::abs(lines.lineTop(probe) - reference.lineTop(probe)) < 1e-2f;
+        matched &= lines.lineAtOffset(lines.lineTop(probe) + 0.5f) == probe;
+    }
+    CHECK(matched);
+}
+
+D14_BENCH(EditsInMillionLines)
+{
+    Wstring text = {};
+    for (int i = 0; i < 1000000; ++i) text += L"int value = 0;\n";
+
+    LineIndex index = {};
+    index.build(text);
+
+    VirtualLines lines = {};
+    lines.reset(index.lineCount());
+    lines.measureVisibleRange(0.0f, 1000.0f, fixedExtent);
+
+    auto offset = index.lineRange(10).offset;
+
+    double typing = unit_test::measure(100000, [&]
+    {
+        auto change = index.onInsert(offset, L"x");
+        lines.replace(change.first, change.removed, change.inserted);
+    });
+    double newline = unit_test::measure(1000, [&]
+    {
+        auto change = index.onInsert(offset, L"\n");
+        lines.replace(change.first, change.removed, change.inserted);
+    });
+    double lookup = unit_test::measure(100000, [&]
+    {
+        unit_test::doNotOptimize(index.lineOfOffset(offset * 1000));
+    });
+    std::printf("  typing at line 10: %.3f us, new line: %.3f us, line lookup: %.3f us\n", typing, newline, lookup);
+}
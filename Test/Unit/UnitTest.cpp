@@ -0,0 +1,93 @@
+﻿#include "Common/Precompile.h"
+
+#include "UnitTest.h"
+
+namespace d14engine::unit_test
+{
+    namespace
+    {
+        size_t g_failureCount = 0;
+    }
+
+    std::vector<Case>& registeredCases()
+    {
+        static std::vector<Case> g_cases = {};
+        return g_cases;
+    }
+
+    Registrar::Registrar(const char* name, void(*func)(), bool benchmark)
+    {
+        registeredCases().push_back({ name, func, benchmark });
+    }
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    void useCharPointer(const volatile char* pointer) { }
+#endif
+
+    bool check(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition)
+        {
+            std::printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+            ++g_failureCount;
+        }
+        return condition;
+    }
+
+    int run(int argc, char* argv[])
+    {
+        bool benchmark = false;
+        String filter = {};
+
+        for (int i = 1; i < argc; ++i)
+        {
+            String arg = argv[i];
+            if (arg == "--bench")
+            {
+                benchmark = true;
+            }
+            else if (arg == "--filter" && i + 1 < argc)
+            {
+                filter = argv[++i];
+            }
+            else
+            {
+                std::fprintf(stderr, "Usage: %s [--bench] [--filter STR]\n", argv[0]);
+                return 2;
+            }
+        }
+        size_t failedCaseCount = 0;
+
+        // The cases go first so that the benchmarks measure checked code.
+        for (bool pass : { false, true })
+        {
+            if (pass && !benchmark) break;
+
+            for (auto& c : registeredCases())
+            {
+                if (c.benchmark != pass) continue;
+                if (!filter.empty() && String(c.name).find(filter) == String::npos) continue;
+
+                std::printf("%s %s\n", pass ? "[bench]" : "[test] ", c.name);
+                std::fflush(stdout);
+
+                auto previousCount = g_failureCount;
+                c.func();
+
+                if (g_failureCount != previousCount) ++failedCaseCount;
+            }
+        }
+        if (failedCaseCount > 0)
+        {
+            std::printf("%zu case(s) failed\n", failedCaseCount);
+            return 1;
+        }
+        std::printf("All cases passed\n");
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    return d14engine::unit_test::run(argc, argv);
+}
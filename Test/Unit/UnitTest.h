@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include "Common/Precompile.h"
+
+#include <cstdio>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace d14engine::unit_test
+{
+    // The minimal harness of the unit tests of the portable cores (see
+    // CMakeLists.txt), where each test program registers its cases with
+    // D14_TEST and its benchmarks with D14_BENCH:
+    //
+    // XxxTest                 Runs all the cases (as ctest does).
+    // XxxTest --bench         Runs the benchmarks after the cases.
+    // XxxTest --filter <str>  Only runs those whose names contain str.
+    //
+    // The program exits with 1 if any CHECK fails.
+
+    struct Case
+    {
+        const char* name = nullptr;
+
+        void(*func)() = nullptr;
+
+        bool benchmark = false;
+    };
+    std::vector<Case>& registeredCases();
+
+    struct Registrar
+    {
+        Registrar(const char* name, void(*func)(), bool benchmark);
+    };
+
+    // Returns whether the condition holds.
+    bool check(bool condition, const char* expression, const char* file, int line);
+
+    int run(int argc, char* argv[]);
+
+    // Returns the microseconds per call of func over the count of the calls.
+    template<typename Func_T>
+    double measure(size_t count, Func_T&& func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i) func();
+
+        auto duration = std::chrono::steady_clock::now() - start;
+        return std::chrono::duration<double, std::micro>(duration).count() / (double)count;
+    }
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    // Defined in UnitTest.cpp so that MSVC can not see it does nothing.
+    void useCharPointer(const volatile char* pointer);
+#endif
+    // Keeps the compiler from removing the benchmarked work, i.e. the value
+    // is assumed to be read (and the memory to be clobbered) here.
+    template<typename T>
+    void doNotOptimize(const T& value)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        useCharPointer(&reinterpret_cast<const volatile char&>(value));
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "g"(&value) : "memory");
+#endif
+    }
+}
+
+#define D14_TEST_CASE(Name, Benchmark) \
+    static void Name(); \
+    static d14engine::unit_test::Registrar Name##Registrar(#Name, Name, Benchmark); \
+    static void Name()
+
+#define D14_TEST(Name) D14_TEST_CASE(Name, false)
+#define D14_BENCH(Name) D14_TEST_CASE(Name, true)
+
+#define CHECK(Condition) d14engine::unit_test::check((Condition), #Condition, __FILE__, __LINE__)
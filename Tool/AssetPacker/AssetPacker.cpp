@@ -0,0 +1,107 @@
+﻿#include "Common/Precompile.h"
+
+#include <cstdio>
+
+#include "Common/AssetArchive.h"
+
+using namespace d14engine;
+
+// Packs the loose files into an asset archive, e.g. to replace Bin/ with
+// Bin.d14a (mounted at L"Bin/" so that the paths stay the same):
+//
+// AssetPacker Bin.d14a Bin/Cursors=Cursors/ Bin/Shaders/CSO=Shaders/CSO/
+//
+// Usage: AssetPacker [options] <archive> <directory>[=<prefix>]...
+//
+// Options:
+// --store        Stores the data without compression.
+// --align <N>    Aligns the data of each entry to N bytes (default 16).
+// --list         Lists the entries of the archive instead.
+//
+// This only depends on AssetArchive, MappedFile and CompressUtils/LZ4 of
+// Common, so it is also built for the POSIX systems (see CMakeLists.txt).
+
+namespace
+{
+    int printUsage()
+    {
+        std::fprintf(stderr,
+            "Usage: AssetPacker [--store] [--align N] <archive> <directory>[=<prefix>]...\n"
+            "       AssetPacker --list <archive>\n");
+        return 2;
+    }
+
+    int listArchive(const std::filesystem::path& path)
+    {
+        AssetArchive archive = {};
+        if (!archive.open(path))
+        {
+            std::fprintf(stderr, "Failed to open %s\n", path.string().c_str());
+            return 1;
+        }
+        for (auto& name : archive.list({}))
+        {
+            auto asset = archive.load(name);
+            std::printf("%10zu %s\n", asset.has_value() ? asset->size() : 0,
+                std::filesystem::path(name).string().c_str());
+        }
+        if (!archive.verify())
+        {
+            std::fprintf(stderr, "Checksum mismatch\n");
+            return 1;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    bool compress = true, list = false;
+    uint32_t alignment = 16;
+
+    std::vector<String> arguments = {};
+    for (int i = 1; i < argc; ++i)
+    {
+        String argument = argv[i];
+
+        if (argument == "--store") compress = false;
+        else if (argument == "--list") list = true;
+        else if (argument == "--align" && i + 1 < argc)
+        {
+            alignment = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else arguments.push_back(std::move(argument));
+    }
+    if (list)
+    {
+        return arguments.size() == 1 ? listArchive(arguments[0]) : printUsage();
+    }
+    if (arguments.size() < 2) return printUsage();
+
+    AssetArchiveWriter writer = {};
+    writer.alignment = alignment;
+
+    for (size_t i = 1; i < arguments.size(); ++i)
+    {
+        auto& source = arguments[i];
+
+        auto separator = source.find('=');
+        std::filesystem::path directory = source.substr(0, separator);
+
+        Wstring prefix = {};
+        if (separator != String::npos)
+        {
+            prefix = std::filesystem::path(source.substr(separator + 1)).generic_wstring();
+        }
+        auto count = writer.addDirectory(directory, prefix, compress);
+        std::printf("%zu files from %s\n", count, directory.string().c_str());
+    }
+    if (!writer.write(arguments[0]))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", arguments[0].c_str());
+        return 1;
+    }
+    std::printf("%zu entries written to %s\n", writer.size(), arguments[0].c_str());
+
+    return 0;
+}
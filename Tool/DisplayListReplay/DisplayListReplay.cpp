@@ -0,0 +1,237 @@
+﻿#include "Common/Precompile.h"
+
+#include <cstdio>
+
+#include "Renderer/DisplayList.h"
+#include "Renderer/DisplayListBatcher.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+// Reports the per-command timing of a 2D frame captured with
+// Renderer::captureNextFrame2D and saved with DisplayList::save:
+//
+// DisplayListReplay --top 20 --repeat 100 --batch Frame.d14l
+//
+// Options:
+// --top <N>       Count of the slowest commands listed (default 10).
+// --repeat <N>    Count of the replays to a null backend, which measure
+//                 the overhead of the list itself (default 100).
+// --batch         Also runs DisplayListBatcher on the list, checks the
+//                 output against the original order and reports the
+//                 saved state changes.
+//
+// This only depends on DisplayList and DisplayListBatcher of Renderer,
+// so it can also be built for the POSIX systems (see CMakeLists.txt).
+// The captured timing is that of issuing each command to D2D1 on the
+// machine of the capture.
+//
+// Sample.d14l is a synthetic frame of a list view (48 rows and an
+// offscreen target), which the tests replay with --batch.
+
+namespace
+{
+    int printUsage()
+    {
+        std::fprintf(stderr, "Usage: DisplayListReplay [--top N] [--repeat N] [--batch] <capture>\n");
+        return 2;
+    }
+
+    double toMicroseconds(uint64_t nanoseconds)
+    {
+        return (double)nanoseconds / 1000.0;
+    }
+
+    // Counts the commands (and the state changes) while replaying.
+    struct CountingBackend : DisplayList::IBackend
+    {
+        uint64_t targetChanges = 0;
+        uint64_t draws = 0;
+        int64_t clipDepth = 0, layerDepth = 0;
+
+        void setTarget(const DisplayList::SetTarget& command) override { ++targetChanges; }
+
+        void pushClip(const DisplayList::PushClip& command) override { ++clipDepth; }
+        void popClip(const DisplayList::PopClip& command) override { --clipDepth; }
+        void pushLayer(const DisplayList::PushLayer& command) override { ++layerDepth; }
+        void popLayer(const DisplayList::PopLayer& command) override { --layerDepth; }
+
+        void fillRect(const DisplayList::FillRect& command) override { ++draws; }
+        void drawRect(const DisplayList::DrawRect& command) override { ++draws; }
+        void fillRoundedRect(const DisplayList::FillRoundedRect& command) override { ++draws; }
+        void drawRoundedRect(const DisplayList::DrawRoundedRect& command) override { ++draws; }
+        void drawLine(const DisplayList::DrawLine& command) override { ++draws; }
+
+        void drawBitmap(const DisplayList::DrawBitmap& command) override { ++draws; }
+        void drawTextLayout(const DisplayList::DrawTextLayout& command) override { ++draws; }
+        void fillGeometry(const DisplayList::FillGeometry& command) override { ++draws; }
+        void drawGeometry(const DisplayList::DrawGeometry& command) override { ++draws; }
+        void drawImage(const DisplayList::DrawImage& command) override { ++draws; }
+    };
+
+    // Describes the resource referred to by the command if any.
+    String describe(const DisplayList& list, size_t index)
+    {
+        DisplayList::ResourceID id = DisplayList::g_nullResource;
+
+        switch (list.typeOf(index))
+        {
+        case DisplayList::CommandType::SetTarget:
+            id = list.commandAt<DisplayList::SetTarget>(index)->target; break;
+        case DisplayList::CommandType::DrawBitmap:
+            id = list.commandAt<DisplayList::DrawBitmap>(index)->bitmap; break;
+        case DisplayList::CommandType::DrawTextLayout:
+            id = list.commandAt<DisplayList::DrawTextLayout>(index)->layout; break;
+        case DisplayList::CommandType::FillGeometry:
+            id = list.commandAt<DisplayList::FillGeometry>(index)->geometry; break;
+        case DisplayList::CommandType::DrawGeometry:
+            id = list.commandAt<DisplayList::DrawGeometry>(index)->geometry; break;
+        case DisplayList::CommandType::DrawImage:
+            id = list.commandAt<DisplayList::DrawImage>(index)->image; break;
+        default: return {};
+        }
+        auto resource = list.resource(id);
+        if (resource == nullptr) return "frame target";
+
+        char buffer[128] = {};
+        auto& b = resource->bounds;
+
+        std::snprintf(buffer, sizeof(buffer), "#%u %.0fx%.0f",
+            id, b.right - b.left, b.bottom - b.top);
+
+        String result = buffer;
+        if (resource->type == DisplayList::ResourceType::TextLayout)
+        {
+            // The font names are expected to be ASCII.
+            result += " ";
+            for (auto c : resource->name) result.push_back(c < 0x80 ? (char)c : '?');
+
+            std::snprintf(buffer, sizeof(buffer), " %.1fpt", resource->fontSize);
+            result += buffer;
+        }
+        return result;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t top = 10, repeat = 100;
+    bool batch = false;
+    const char* path = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        if (arg == "--top" && i + 1 < argc)
+        {
+            top = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--repeat" && i + 1 < argc)
+        {
+            repeat = std::max<size_t>(std::strtoull(argv[++i], nullptr, 10), 1);
+        }
+        else if (arg == "--batch")
+        {
+            batch = true;
+        }
+        else if (path == nullptr && !arg.starts_with("--"))
+        {
+            path = argv[i];
+        }
+        else return printUsage();
+    }
+    if (path == nullptr) return printUsage();
+
+    DisplayList list = {};
+    if (!list.load(path))
+    {
+        std::fprintf(stderr, "Failed to load %s\n", path);
+        return 1;
+    }
+    auto stats = list.statistics();
+
+    std::printf("%zu commands, %zu resources, %.1f us captured\n\n",
+        list.commandCount(), list.resources().size(), toMicroseconds(stats.totalDuration));
+
+    std::printf("%-16s %8s %12s %10s %10s %7s\n", "Command", "Count", "Total (us)", "Avg (us)", "Max (us)", "Share");
+
+    for (size_t i = 0; i < stats.commands.size(); ++i)
+    {
+        auto& item = stats.commands[i];
+        if (item.count == 0) continue;
+
+        std::printf("%-16s %8llu %12.1f %10.2f %10.2f %6.1f%%\n",
+            DisplayList::nameOf((DisplayList::CommandType)i),
+            (unsigned long long)item.count,
+            toMicroseconds(item.totalDuration),
+            toMicroseconds(item.totalDuration) / (double)item.count,
+            toMicroseconds(item.maxDuration),
+            stats.totalDuration ? 100.0 * (double)item.totalDuration / (double)stats.totalDuration : 0.0);
+    }
+    // The slowest commands with their positions in the frame.
+    std::vector<size_t> indices(list.commandCount());
+    std::iota(indices.begin(), indices.end(), 0);
+
+    top = std::min(top, indices.size());
+    std::partial_sort(indices.begin(), indices.begin() + top, indices.end(), [&](size_t a, size_t b)
+    {
+        return list.durationOf(a) > list.durationOf(b);
+    });
+    if (top > 0)
+    {
+        std::printf("\n%-8s %-16s %10s  %s\n", "Index", "Command", "Time (us)", "Resource");
+
+        for (size_t i = 0; i < top; ++i)
+        {
+            auto index = indices[i];
+
+            std::printf("%-8zu %-16s %10.2f  %s\n", index,
+                DisplayList::nameOf(list.typeOf(index)),
+                toMicroseconds(list.durationOf(index)),
+                describe(list, index).c_str());
+        }
+    }
+    CountingBackend backend = {};
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < repeat; ++i)
+    {
+        list.replay(backend);
+    }
+    auto replayDuration = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::printf("\nNull replay: %.2f us/frame, %llu draws and %llu target changes per frame\n",
+        toMicroseconds(replayDuration) / (double)repeat,
+        (unsigned long long)(backend.draws / repeat),
+        (unsigned long long)(backend.targetChanges / repeat));
+
+    if (backend.clipDepth != 0 || backend.layerDepth != 0)
+    {
+        std::printf("Warning: unbalanced clips (%lld) or layers (%lld)\n",
+            (long long)(backend.clipDepth / (int64_t)repeat),
+            (long long)(backend.layerDepth / (int64_t)repeat));
+    }
+    if (batch)
+    {
+        DisplayListBatcher batcher = {};
+
+        std::vector<size_t> order = {};
+        auto batched = batcher.run(list, &order);
+
+        auto& bstats = batcher.statistics();
+        std::printf("\nBatching: %zu draws in %zu batches (%zu moved, %zu barriers)\n",
+            bstats.draws, bstats.batches, bstats.movedDraws, bstats.barriers);
+
+        std::printf("State changes: %zu -> %zu\n",
+            DisplayListBatcher::countStateChanges(list),
+            DisplayListBatcher::countStateChanges(batched));
+
+        if (!batcher.verify(list, batched, order))
+        {
+            std::printf("Error: the batched list does not match the original order\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,418 @@
+﻿#include "Common/Precompile.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Common/CullUtils/Frustum.h"
+
+#include "Pipeline/Data/TransformSystem.h"
+
+#include "Renderer/Interfaces/ICullingCamera.h"
+#include "Renderer/NullRenderer.h"
+
+using namespace d14engine;
+using namespace d14engine::pipeline;
+using namespace d14engine::renderer;
+
+// Measures the frame time and the allocations of the traversal in
+// Renderer::renderNextFrame with NullRenderer, i.e. without any window
+// or GPU, on a scene of D3D12 layers and a UI of 2D panels:
+//
+// FrameBench --layers 4 --objects 10000 --objects2d 2000 --frames 1000
+//
+// Each scene layer is a forest of TransformSystem nodes (a few of which
+// spin in each frame) culled by a panning orthographic camera, and each
+// drawn object writes its world matrix as the constants of its draw.
+//
+// The UI is a tree of windows, rows and leaves (labels and buttons) that
+// draw themselves and then their children as UIKit panels do, where the
+// 2D draws are recorded into NullRenderer::displayList, and every 4th
+// window draws its content into its own target in the layer pass.
+//
+// Options:
+// --layers <N>      Count of D3D12 layers in the scene (default 4).
+// --objects <N>     Count of D3D12 objects per layer (default 10000).
+// --objects2d <N>   Count of 2D panels in the UI (default 2000).
+// --hidden <P>      Percentage of the invisible objects (default 10).
+// --frames <N>      Count of the measured frames (default 1000).
+//
+// This only depends on the portable cores of Renderer and Pipeline, so it
+// can also be built for the POSIX systems.
+
+namespace
+{
+    std::atomic<uint64_t> g_allocationCount = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++g_allocationCount;
+
+    if (auto ptr = std::malloc(size ? size : 1)) return ptr;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+    //----------------------------------------------------------------------
+    // Scene
+    //----------------------------------------------------------------------
+
+    constexpr float g_worldSize = 2000.0f;
+    constexpr float g_viewSize = 600.0f;
+
+    struct SceneObject;
+
+    struct SceneLayer : IDrawLayer, ICullingCamera
+    {
+        bool visible = true;
+
+        TransformSystem transforms = {};
+
+        // The center of the view, which pans across the world.
+        float time = 0.0f;
+        float viewX = 0.0f, viewY = 0.0f;
+
+        // The constants written by the drawn objects in the current frame.
+        std::vector<TransformSystem::Float4x4> constants = {};
+
+        cull_utils::SphereArray spheres = {};
+
+        bool isD3d12LayerVisible() const override { return visible; }
+        void setD3d12LayerVisible(bool value) override { visible = value; }
+
+        ICullingCamera* d3d12CullingCamera() const override { return const_cast<SceneLayer*>(this); }
+
+        void onRendererUpdateLayer(Renderer* rndr) override
+        {
+            time += 1.0f / 60.0f;
+
+            viewX = 0.5f * (g_worldSize - g_viewSize) * std::sin(0.3f * time);
+            viewY = 0.5f * (g_worldSize - g_viewSize) * std::sin(0.2f * time);
+        }
+        void onRendererDrawD3d12Layer(Renderer* rndr) override
+        {
+            // After the objects have spun in their updates.
+            transforms.update();
+
+            constants.clear();
+        }
+
+        cull_utils::Frustum frustum() const
+        {
+            // The orthographic view-projection of the view, looking down z.
+            float m[4][4] =
+            {
+                { 2.0f / g_viewSize, 0.0f, 0.0f, 0.0f },
+                { 0.0f, 2.0f / g_viewSize, 0.0f, 0.0f },
+                { 0.0f, 0.0f, 1.0f / 100.0f, 0.0f },
+                { -2.0f * viewX / g_viewSize, -2.0f * viewY / g_viewSize, 0.5f, 1.0f }
+            };
+            return cull_utils::Frustum::fromMatrix(m);
+        }
+        void cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results) override;
+    };
+
+    struct SceneObject : IDrawObject
+    {
+        SceneLayer* layer = nullptr;
+
+        TransformSystem::Handle node = TransformSystem::g_invalidHandle;
+
+        bool visible = true;
+
+        // Only a few objects spin, so only their subtrees are dirty.
+        float spin = 0.0f, angle = 0.0f;
+
+        bool isD3d12ObjectVisible() const override { return visible; }
+        void setD3d12ObjectVisible(bool value) override { visible = value; }
+
+        Optional<cull_utils::Bounds> d3d12ObjectBounds() const override
+        {
+            auto& m = layer->transforms.worldMatrix(node).m;
+            return cull_utils::Sphere{ m[3][0], m[3][1], m[3][2], 1.0f };
+        }
+        void onRendererUpdateObject(Renderer* rndr) override
+        {
+            if (spin == 0.0f) return;
+
+            angle += spin;
+            layer->transforms.setRotation(node, TransformSystem::Quaternion::fromRollPitchYaw(0.0f, 0.0f, angle));
+        }
+        void onRendererDrawD3d12Object(Renderer* rndr) override
+        {
+            layer->constants.push_back(layer->transforms.worldMatrix(node));
+        }
+    };
+
+    void SceneLayer::cullD3d12Objects(const std::vector<IDrawObject*>& objects, std::vector<uint8_t>& results)
+    {
+        spheres.clear();
+        for (auto obj : objects)
+        {
+            spheres.push_back(std::get<cull_utils::Sphere>(obj->d3d12ObjectBounds().value()));
+        }
+        results.resize(objects.size());
+        cull_utils::cull(frustum(), spheres, results.data());
+    }
+
+    //----------------------------------------------------------------------
+    // UI
+    //----------------------------------------------------------------------
+
+    struct UIPanel : IDrawObject2D
+    {
+        NullRenderer* rndr = nullptr;
+
+        bool visible = true;
+
+        enum class Kind { Window, Row, Label, Button } kind = Kind::Window;
+
+        DisplayList::Rect rect = {};
+
+        std::vector<SharedPtr<UIPanel>> children = {};
+
+        // The windows drawn into their own targets in the layer pass.
+        bool offscreen = false;
+
+        float hover = 0.0f;
+
+        bool isD2d1ObjectVisible() const override { return visible; }
+        void setD2d1ObjectVisible(bool value) override { visible = value; }
+
+        void onRendererUpdateObject2D(Renderer* rndr) override
+        {
+            hover = hover * 0.9f + (kind == Kind::Button ? 0.1f : 0.0f);
+
+            for (auto& child : children)
+            {
+                if (child->visible) child->onRendererUpdateObject2D(rndr);
+            }
+        }
+        void onRendererDrawD2d1Layer(Renderer* rndr) override
+        {
+            if (!offscreen) return;
+
+            auto& list = this->rndr->displayList;
+
+            DisplayList::Resource target = { .type = DisplayList::ResourceType::Target };
+            target.bounds = { 0.0f, 0.0f, rect.right - rect.left, rect.bottom - rect.top };
+
+            list.record(DisplayList::SetTarget{ .target = list.addResource(this, target) });
+            list.record(DisplayList::Clear{});
+
+            drawContent();
+        }
+        void onRendererDrawD2d1Object(Renderer* rndr) override
+        {
+            if (!offscreen)
+            {
+                drawContent(); return;
+            }
+            auto& list = this->rndr->displayList;
+
+            list.record(DisplayList::DrawBitmap
+            {
+                .bitmap = list.findResource(this).value_or(DisplayList::g_nullResource),
+                .destination = rect
+            });
+        }
+        void drawContent()
+        {
+            auto& list = rndr->displayList;
+
+            DisplayList::Brush brush = { .color = { 0.2f, 0.2f, 0.2f + hover, 1.0f } };
+
+            list.record(DisplayList::PushClip{ .rect = rect });
+            list.record(DisplayList::FillRoundedRect{ .rect = rect, .radiusX = 4.0f, .radiusY = 4.0f, .brush = brush });
+
+            if (kind == Kind::Label || kind == Kind::Button)
+            {
+                DisplayList::ResourceID layout = {};
+                if (auto id = list.findResource(this); id.has_value())
+                {
+                    layout = id.value();
+                }
+                else // The text layout of the panel, as D2D1Recorder adds it.
+                {
+                    DisplayList::Resource resource = { .type = DisplayList::ResourceType::TextLayout, .bounds = rect };
+                    resource.fontSize = 14.0f;
+
+                    layout = list.addResource(this, resource);
+                }
+                list.record(DisplayList::DrawTextLayout
+                {
+                    .layout = layout,
+                    .origin = { rect.left + 4.0f, rect.top + 2.0f },
+                    .brush = { .color = { 1.0f, 1.0f, 1.0f, 1.0f } }
+                });
+            }
+            for (auto& child : children)
+            {
+                if (child->visible) child->drawContent();
+            }
+            if (kind != Kind::Label)
+            {
+                list.record(DisplayList::DrawRoundedRect{ .rect = rect, .radiusX = 4.0f, .radiusY = 4.0f, .brush = brush });
+            }
+            list.record(DisplayList::PopClip{});
+        }
+    };
+
+    int printUsage()
+    {
+        std::fprintf(stderr,
+            "Usage: FrameBench [--layers N] [--objects N] [--objects2d N] [--hidden P] [--frames N]\n");
+        return 2;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t layerCount = 4, objectCount = 10000, object2DCount = 2000, frameCount = 1000;
+    int hiddenPercent = 10;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string_view arg = argv[i];
+        if (i + 1 >= argc) return printUsage();
+
+        auto value = std::strtoull(argv[++i], nullptr, 10);
+
+        if (arg == "--layers") layerCount = (size_t)value;
+        else if (arg == "--objects") objectCount = (size_t)value;
+        else if (arg == "--objects2d") object2DCount = (size_t)value;
+        else if (arg == "--hidden") hiddenPercent = (int)value;
+        else if (arg == "--frames") frameCount = (size_t)std::max(value, 1ull);
+        else return printUsage();
+    }
+    NullRenderer rndr = {};
+
+    size_t index = 0;
+    auto nextVisible = [&] { return (int)(index++ % 100) >= hiddenPercent; };
+
+    ///////////
+    // Scene //
+    ///////////
+
+    auto sceneLayer = std::make_shared<NullRenderer::CommandLayer>();
+    auto& scene = sceneLayer->drawTarget.emplace<FrameTraversal::D3D12Target>();
+
+    for (size_t i = 0; i < layerCount; ++i)
+    {
+        auto layer = std::make_shared<SceneLayer>();
+        layer->setPriority((int)i);
+
+        // Each root carries 15 descendants within a few units of it.
+        auto& transforms = layer->transforms;
+        auto& objects = scene[layer];
+
+        TransformSystem::Handle root = TransformSystem::g_invalidHandle;
+        for (size_t j = 0; j < objectCount; ++j)
+        {
+            auto obj = std::make_shared<SceneObject>();
+            obj->IDrawObject::setPriority((int)j);
+            obj->layer = layer.get();
+            obj->visible = nextVisible();
+
+            auto hash = (float)((j * 2654435761u) % 10007) / 10007.0f;
+            if (j % 16 == 0)
+            {
+                root = obj->node = transforms.create();
+                transforms.setPosition(obj->node, { (hash - 0.5f) * g_worldSize, (std::fmod(hash * 97.0f, 1.0f) - 0.5f) * g_worldSize, 0.0f });
+
+                obj->spin = j % 64 == 0 ? 0.01f : 0.0f;
+            }
+            else // the descendants
+            {
+                obj->node = transforms.create(j % 4 == 0 ? root : root + (TransformSystem::Handle)(j % 16 / 4 * 4));
+                transforms.setPosition(obj->node, { 8.0f * (hash - 0.5f), 8.0f * (std::fmod(hash * 31.0f, 1.0f) - 0.5f), 0.0f });
+            }
+            objects.insert(obj);
+        }
+        transforms.update();
+    }
+    rndr.cmdLayers.insert(sceneLayer);
+
+    ////////
+    // UI //
+    ////////
+
+    auto uiLayer = std::make_shared<NullRenderer::CommandLayer>();
+    uiLayer->setPriority(1);
+
+    auto& ui = uiLayer->drawTarget.emplace<FrameTraversal::D2D1Target>();
+
+    // A window of 8 rows of a label and 2 buttons, i.e. 33 panels.
+    size_t panelCount = 0;
+    for (int w = 0; panelCount < object2DCount; ++w)
+    {
+        auto makePanel = [&](UIPanel::Kind kind, const DisplayList::Rect& rect)
+        {
+            auto panel = std::make_shared<UIPanel>();
+            panel->rndr = &rndr;
+            panel->kind = kind;
+            panel->rect = rect;
+            panel->visible = nextVisible();
+
+            ++panelCount;
+            return panel;
+        };
+        float left = (float)(w % 8) * 240.0f, top = (float)(w / 8 % 8) * 180.0f;
+
+        auto window = makePanel(UIPanel::Kind::Window, { left, top, left + 230.0f, top + 170.0f });
+        window->IDrawObject2D::setPriority(w);
+        window->offscreen = w % 4 == 0;
+
+        for (int r = 0; r < 8 && panelCount < object2DCount; ++r)
+        {
+            float rowTop = top + 5.0f + 20.0f * r;
+
+            auto row = makePanel(UIPanel::Kind::Row, { left + 5.0f, rowTop, left + 225.0f, rowTop + 18.0f });
+            row->children.push_back(makePanel(UIPanel::Kind::Label, { left + 5.0f, rowTop, left + 105.0f, rowTop + 18.0f }));
+            row->children.push_back(makePanel(UIPanel::Kind::Button, { left + 110.0f, rowTop, left + 165.0f, rowTop + 18.0f }));
+            row->children.push_back(makePanel(UIPanel::Kind::Button, { left + 170.0f, rowTop, left + 225.0f, rowTop + 18.0f }));
+
+            window->children.push_back(row);
+        }
+        ui.insert(window);
+    }
+    rndr.cmdLayers.insert(uiLayer);
+
+    rndr.renderNextFrame(); // warm up
+    rndr.resetCounters();
+
+    auto allocationCount = g_allocationCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    size_t commandCount = 0;
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        rndr.renderNextFrame();
+
+        commandCount += rndr.displayList.commandCount();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+    allocationCount = g_allocationCount.load() - allocationCount;
+
+    auto& counters = rndr.counters();
+    std::printf("frames          %llu\n", (unsigned long long)counters.frameCount);
+    std::printf("frame time      %.3f us\n", nanoseconds / 1000.0 / frameCount);
+    std::printf("allocations     %.2f per frame\n", (double)allocationCount / frameCount);
+    std::printf("object updates  %llu per frame\n", (unsigned long long)(counters.objectUpdates / frameCount));
+    std::printf("2D updates      %llu per frame\n", (unsigned long long)(counters.object2DUpdates / frameCount));
+    std::printf("object draws    %llu per frame\n", (unsigned long long)(counters.d3d12ObjectDraws / frameCount));
+    std::printf("culled objects  %llu per frame\n", (unsigned long long)(counters.culledObjects / frameCount));
+    std::printf("2D draws        %llu per frame\n", (unsigned long long)(counters.d2d1ObjectDraws / frameCount));
+    std::printf("2D commands     %llu per frame\n", (unsigned long long)(commandCount / frameCount));
+
+    return 0;
+}
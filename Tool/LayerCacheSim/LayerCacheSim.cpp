@@ -0,0 +1,627 @@
+﻿#include "Common/Precompile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "UIKit/LayerCache.h"
+
+using namespace d14engine;
+using namespace d14engine::uikit;
+
+// Checks the invalidation and the eviction of the cached layers (see
+// Panel::setCachedLayer) on the mock panel trees, which mirror the layer
+// pass and the object pass of Panel and count the draws instead of drawing,
+// and optionally measures the draws saved on a synthetic settings page:
+//
+// LayerCacheSim
+// LayerCacheSim --bench 1000 --pages 8 --items 200 --budget 16
+//
+// Options:
+// --bench <N>     Count of the simulated frames, where each frame changes
+//                 one random item of the visible page.
+// --pages <N>     Count of the cached pages, one visible at a time (default 8).
+// --items <N>     Count of the items in each page (default 200).
+// --budget <MB>   Budget of the cache in MiB (default 64).
+//
+// This only depends on LayerCache of UIKit, so it can also be built for the
+// POSIX systems (see CMakeLists.txt, which also runs it with ctest).
+
+namespace
+{
+    int printUsage()
+    {
+        std::fprintf(stderr,
+            "Usage: LayerCacheSim [--bench N] [--pages N] [--items N] [--budget MB]\n");
+        return 2;
+    }
+
+    struct Counters
+    {
+        // The draws of the backgrounds, i.e. the work saved by the cache.
+        size_t primitives = 0;
+
+        size_t redraws = 0, composites = 0;
+
+        // The highlights on the screen, either drawn or composited.
+        size_t shownHighlights = 0;
+    };
+
+    // Mirrors the parts of Panel that decide what to draw.
+    struct MockPanel : cpp_lang_utils::NonCopyable
+    {
+        MockPanel(uint32_t width, uint32_t height, bool cachedLayer = false)
+            : width(width), height(height), cachedLayer(cachedLayer)
+        {
+            node.f_onRelease = [this](LayerCache::Node*) { surface = false; ++releases; };
+        }
+
+        uint32_t width = 0, height = 0;
+
+        bool cachedLayer = false;
+        bool visible = true;
+
+        LayerCache::Node node = {};
+
+        // Whether the surface exists, i.e. m_layerMask.data of Panel.
+        bool surface = false;
+        bool drawingLayer = false;
+
+        size_t releases = 0;
+
+        // The content changed out of the UI events (e.g. the search matches
+        // of LabelArea), and that drawn into the surface in the last redraw.
+        size_t highlights = 0, surfaceHighlights = 0;
+
+        std::vector<MockPanel*> children = {};
+
+        void addChild(MockPanel* child)
+        {
+            children.push_back(child);
+            child->node.setParent(&node);
+
+            node.invalidate();
+        }
+
+        void setVisible(bool value)
+        {
+            visible = value;
+            node.invalidate();
+        }
+
+        void setSize(uint32_t w, uint32_t h)
+        {
+            width = w;
+            height = h;
+            node.invalidate();
+        }
+
+        bool hovered = false;
+
+        // Mirrors the mouse events of Panel (and the hover states of the
+        // widgets), where only the transitions invalidate, and moving the
+        // mouse inside does not.
+        void setHovered(bool value)
+        {
+            if (hovered != value) node.invalidate();
+
+            hovered = value;
+        }
+
+        void drawLayer(LayerCache& cache, uint64_t frame, Counters& counters)
+        {
+            auto action = LayerCache::Action::Bypass;
+            if (cachedLayer)
+            {
+                action = cache.acquire(node, (size_t)width * height * 4, frame);
+
+                if (action == LayerCache::Action::Reuse) return;
+            }
+            for (auto& child : children)
+            {
+                if (child->visible) child->drawLayer(cache, frame, counters);
+            }
+            if (action == LayerCache::Action::Redraw)
+            {
+                surface = true;
+                ++counters.redraws;
+
+                // The highlights drawn into the surface are not shown until
+                // it is composited.
+                auto shownHighlights = counters.shownHighlights;
+
+                drawingLayer = true;
+                drawObject(counters);
+                drawingLayer = false;
+
+                surfaceHighlights = counters.shownHighlights - shownHighlights;
+                counters.shownHighlights = shownHighlights;
+            }
+        }
+
+        void drawObject(Counters& counters)
+        {
+            if (cachedLayer && !drawingLayer && surface && node.resident() && !node.dirty())
+            {
+                ++counters.composites;
+                counters.shownHighlights += surfaceHighlights;
+                return;
+            }
+            ++counters.primitives;
+            counters.shownHighlights += highlights;
+
+            for (auto& child : children)
+            {
+                if (child->visible) child->drawObject(counters);
+            }
+        }
+    };
+
+    // Renders a frame of the root like Renderer::renderNextFrame.
+    Counters renderFrame(MockPanel& root, LayerCache& cache, uint64_t& frame)
+    {
+        Counters counters = {};
+
+        root.drawLayer(cache, frame, counters);
+        root.drawObject(counters);
+
+        ++frame;
+        return counters;
+    }
+
+    int g_failures = 0;
+
+    void check(bool condition, const char* scenario, const char* expression)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL  %s: %s\n", scenario, expression);
+            ++g_failures;
+        }
+    }
+
+#define CHECK(Condition) check(Condition, scenario, #Condition)
+
+    // A page of the items with the labels.
+    struct Page
+    {
+        Page(size_t itemCount, uint32_t width, uint32_t height) : panel(width, height, true)
+        {
+            for (size_t i = 0; i < itemCount; ++i)
+            {
+                items.push_back(std::make_unique<MockPanel>(width, 24));
+                labels.push_back(std::make_unique<MockPanel>(width / 2, 24));
+
+                items.back()->addChild(labels.back().get());
+                panel.addChild(items.back().get());
+            }
+        }
+
+        MockPanel panel;
+
+        std::vector<UniquePtr<MockPanel>> items = {};
+        std::vector<UniquePtr<MockPanel>> labels = {};
+
+        size_t primitiveCount() const { return 1 + items.size() + labels.size(); }
+    };
+
+    void checkStaticSubtree()
+    {
+        auto scenario = "static subtree";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page page(10, 400, 300);
+        root.addChild(&page.panel);
+
+        auto first = renderFrame(root, cache, frame);
+        CHECK(first.redraws == 1);
+        CHECK(first.primitives == 1 + page.primitiveCount());
+        CHECK(first.composites == 1);
+
+        for (int i = 0; i < 5; ++i)
+        {
+            auto later = renderFrame(root, cache, frame);
+            CHECK(later.redraws == 0);
+            CHECK(later.primitives == 1);
+            CHECK(later.composites == 1);
+        }
+        CHECK(cache.statistics().hits == 5);
+        CHECK(cache.statistics().residentBytes == 400 * 300 * 4);
+    }
+
+    void checkDescendantChange()
+    {
+        auto scenario = "descendant change";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page a(10, 400, 300), b(10, 400, 300);
+        root.addChild(&a.panel);
+        root.addChild(&b.panel);
+
+        renderFrame(root, cache, frame);
+
+        // The change of a label is reported to its page only.
+        a.labels[3]->node.invalidate();
+        CHECK(a.panel.node.dirty());
+        CHECK(!b.panel.node.dirty());
+
+        auto changed = renderFrame(root, cache, frame);
+        CHECK(changed.redraws == 1);
+        CHECK(changed.primitives == 1 + a.primitiveCount());
+        CHECK(changed.composites == 2);
+
+        auto later = renderFrame(root, cache, frame);
+        CHECK(later.redraws == 0);
+        CHECK(later.primitives == 1);
+
+        // Invalidating twice in a frame still redraws once.
+        b.items[0]->node.invalidate();
+        b.labels[9]->node.invalidate();
+
+        auto twice = renderFrame(root, cache, frame);
+        CHECK(twice.redraws == 1);
+        CHECK(twice.primitives == 1 + b.primitiveCount());
+    }
+
+    void checkNestedCaches()
+    {
+        auto scenario = "nested caches";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        MockPanel outer(600, 400, true), header(600, 40);
+        Page inner(20, 600, 300);
+
+        root.addChild(&outer);
+        outer.addChild(&header);
+        outer.addChild(&inner.panel);
+
+        auto first = renderFrame(root, cache, frame);
+        CHECK(first.redraws == 2);
+        // The inner page is drawn into its surface only.
+        CHECK(first.primitives == 1 + 2 + inner.primitiveCount());
+
+        // The change inside the inner page redraws both.
+        inner.labels[0]->node.invalidate();
+
+        auto innerChanged = renderFrame(root, cache, frame);
+        CHECK(innerChanged.redraws == 2);
+        CHECK(innerChanged.primitives == 1 + 2 + inner.primitiveCount());
+
+        // The change of the header composites the inner page as is.
+        header.node.invalidate();
+
+        auto headerChanged = renderFrame(root, cache, frame);
+        CHECK(headerChanged.redraws == 1);
+        CHECK(headerChanged.primitives == 1 + 2);
+        CHECK(headerChanged.composites == 2);
+    }
+
+    void checkBudget()
+    {
+        auto scenario = "budget";
+
+        // Fits 2 of the pages.
+        LayerCache cache(2 * 100 * 100 * 4);
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page a(5, 100, 100), b(5, 100, 100), c(5, 100, 100);
+        root.addChild(&a.panel);
+        root.addChild(&b.panel);
+        root.addChild(&c.panel);
+
+        // The surfaces used in the same frame are never evicted, so the
+        // last page is drawn directly in each frame.
+        for (int i = 0; i < 3; ++i)
+        {
+            auto counters = renderFrame(root, cache, frame);
+            CHECK(!c.panel.node.resident());
+            CHECK(counters.primitives == 1 + (i == 0 ? 2 * a.primitiveCount() : 0) + c.primitiveCount());
+        }
+        CHECK(cache.statistics().bypasses == 3);
+        CHECK(cache.statistics().evictions == 0);
+
+        // The surface of a hidden page is evicted after a frame.
+        a.panel.setVisible(false);
+
+        renderFrame(root, cache, frame);
+        CHECK(a.panel.node.resident());
+        CHECK(!c.panel.node.resident());
+
+        auto hidden = renderFrame(root, cache, frame);
+        CHECK(!a.panel.node.resident() && !a.panel.surface);
+        CHECK(a.panel.releases == 1);
+        CHECK(c.panel.node.resident());
+        CHECK(hidden.redraws == 1);
+        CHECK(cache.statistics().evictions == 1);
+        CHECK(cache.statistics().residentBytes == cache.budget());
+
+        // Switching the pages moves the surface to the shown one, which
+        // never evicts the visible ones.
+        a.panel.setVisible(true);
+        c.panel.setVisible(false);
+
+        auto switched = renderFrame(root, cache, frame);
+        CHECK(!a.panel.node.resident());
+        CHECK(b.panel.node.resident() && c.panel.node.resident());
+        CHECK(switched.primitives == 1 + a.primitiveCount());
+
+        auto shown = renderFrame(root, cache, frame);
+        CHECK(a.panel.node.resident());
+        CHECK(!c.panel.node.resident() && c.panel.releases == 1);
+        CHECK(shown.redraws == 1);
+        CHECK(cache.statistics().evictions == 2);
+
+        // Shrinking the budget evicts immediately.
+        cache.setBudget(100 * 100 * 4);
+        CHECK(cache.residents().size() == 1);
+        CHECK(cache.statistics().residentBytes <= cache.budget());
+    }
+
+    void checkResize()
+    {
+        auto scenario = "resize";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page page(5, 200, 100);
+        root.addChild(&page.panel);
+
+        renderFrame(root, cache, frame);
+        page.panel.setSize(300, 100);
+
+        auto resized = renderFrame(root, cache, frame);
+        CHECK(resized.redraws == 1);
+        CHECK(page.panel.releases == 1);
+        CHECK(cache.statistics().residentBytes == 300 * 100 * 4);
+
+        // An empty panel has no surface to draw into.
+        page.panel.setSize(0, 100);
+
+        auto empty = renderFrame(root, cache, frame);
+        CHECK(empty.redraws == 0);
+        CHECK(empty.primitives == 1 + page.primitiveCount());
+        CHECK(cache.statistics().residentBytes == 0);
+    }
+
+    void checkHover()
+    {
+        auto scenario = "hover";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page page(10, 400, 300);
+        root.addChild(&page.panel);
+
+        renderFrame(root, cache, frame);
+
+        page.items[3]->setHovered(true);
+
+        auto entered = renderFrame(root, cache, frame);
+        CHECK(entered.redraws == 1);
+
+        // The mouse keeps moving over the same item.
+        for (int i = 0; i < 5; ++i)
+        {
+            page.items[3]->setHovered(true);
+
+            auto moved = renderFrame(root, cache, frame);
+            CHECK(moved.redraws == 0);
+            CHECK(moved.composites == 1);
+        }
+        page.items[3]->setHovered(false);
+        page.items[4]->setHovered(true);
+
+        auto crossed = renderFrame(root, cache, frame);
+        CHECK(crossed.redraws == 1);
+    }
+
+    void checkDestruction()
+    {
+        auto scenario = "destruction";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        auto page = std::make_unique<Page>(5, 200, 100);
+        root.addChild(&page->panel);
+
+        renderFrame(root, cache, frame);
+        CHECK(cache.residents().size() == 1);
+
+        auto item = std::move(page->items[0]);
+        root.children.clear();
+        page.reset();
+
+        // The destroyed node leaves the cache and the tree.
+        CHECK(cache.residents().empty());
+        CHECK(cache.statistics().residentBytes == 0);
+        CHECK(item->node.parent() == nullptr);
+        CHECK(root.node.children().empty());
+
+        item->node.invalidate();
+
+        // The node outlives the cache.
+        MockPanel survivor(100, 100, true);
+        {
+            LayerCache temporary = {};
+            temporary.acquire(survivor.node, 100 * 100 * 4, 0);
+            CHECK(survivor.node.resident());
+        }
+        CHECK(!survivor.node.resident());
+    }
+
+    // Mirrors the background search of LabelArea, whose thread delivers
+    // the matches, and the thread event that takes them between frames.
+    struct MockSearch
+    {
+        std::mutex mutex = {};
+        size_t pendingMatches = 0;
+
+        void deliver(size_t count)
+        {
+            std::lock_guard lock(mutex);
+            pendingMatches += count;
+        }
+
+        // Mirrors LabelArea::takeSearchMatches.
+        void takeMatches(MockPanel& area)
+        {
+            size_t matches = 0;
+            {
+                std::lock_guard lock(mutex);
+                std::swap(matches, pendingMatches);
+            }
+            area.highlights += matches;
+
+            if (matches > 0) area.node.invalidate();
+        }
+    };
+
+    void checkAsyncResults()
+    {
+        auto scenario = "async results";
+
+        LayerCache cache = {};
+        uint64_t frame = 0;
+
+        MockPanel root(800, 600);
+        Page page(10, 400, 300);
+        root.addChild(&page.panel);
+
+        auto& area = *page.labels[5];
+        MockSearch search = {};
+
+        renderFrame(root, cache, frame);
+
+        // The matches arrive in batches while the frames go on.
+        size_t delivered = 0;
+        for (size_t batch : { 3, 0, 7, 1 })
+        {
+            std::thread([&search, batch] { search.deliver(batch); }).join();
+            delivered += batch;
+
+            search.takeMatches(area);
+
+            auto taken = renderFrame(root, cache, frame);
+            CHECK(taken.redraws == (batch > 0 ? 1 : 0));
+            CHECK(taken.shownHighlights == delivered);
+
+            auto later = renderFrame(root, cache, frame);
+            CHECK(later.redraws == 0);
+            CHECK(later.shownHighlights == delivered);
+        }
+    }
+
+    void bench(size_t frameCount, size_t pageCount, size_t itemCount, size_t budget)
+    {
+        LayerCache cache(budget);
+
+        MockPanel root(1280, 720);
+        std::vector<UniquePtr<Page>> pages = {};
+
+        for (size_t i = 0; i < pageCount; ++i)
+        {
+            pages.push_back(std::make_unique<Page>(itemCount, 1280, 680));
+            root.addChild(&pages.back()->panel);
+        }
+        std::mt19937 random(14);
+
+        Counters total = {};
+        size_t baseline = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t frame = 0; frame < frameCount;)
+        {
+            // Switches the page every 100 frames like a tab group.
+            for (size_t i = 0; i < pageCount; ++i)
+            {
+                auto visible = i == (frame / 100) % pageCount;
+                if (pages[i]->panel.visible != visible) pages[i]->panel.setVisible(visible);
+            }
+            auto& page = *pages[(frame / 100) % pageCount];
+            if (random() % 4 == 0)
+            {
+                page.labels[random() % itemCount]->node.invalidate();
+            }
+            auto counters = renderFrame(root, cache, frame);
+
+            total.primitives += counters.primitives;
+            total.redraws += counters.redraws;
+            total.composites += counters.composites;
+
+            baseline += 1 + page.primitiveCount();
+        }
+        auto duration = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        auto& statistics = cache.statistics();
+        std::printf(
+            "%zu frames: %zu draws (%zu without the cache), %zu redraws, %zu composites\n"
+            "hits %llu, bypasses %llu, evictions %llu, resident %.1f MiB, %.2f us/frame\n",
+            frameCount, total.primitives, baseline, total.redraws, total.composites,
+            (unsigned long long)statistics.hits, (unsigned long long)statistics.bypasses,
+            (unsigned long long)statistics.evictions, statistics.residentBytes / 1048576.0,
+            duration.count() / (double)frameCount);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    size_t frameCount = 0;
+    size_t pageCount = 8, itemCount = 200;
+    size_t budget = 64;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc)
+        {
+            frameCount = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--pages" && i + 1 < argc)
+        {
+            pageCount = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--items" && i + 1 < argc)
+        {
+            itemCount = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--budget" && i + 1 < argc)
+        {
+            budget = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else return printUsage();
+    }
+    if (pageCount == 0 || itemCount == 0) return printUsage();
+
+    checkStaticSubtree();
+    checkDescendantChange();
+    checkNestedCaches();
+    checkBudget();
+    checkResize();
+    checkHover();
+    checkDestruction();
+    checkAsyncResults();
+
+    std::printf("%s\n", g_failures == 0 ? "All checks passed" : "Some checks failed");
+
+    if (frameCount > 0) bench(frameCount, pageCount, itemCount, budget * 1024 * 1024);
+
+    return g_failures == 0 ? 0 : 1;
+}
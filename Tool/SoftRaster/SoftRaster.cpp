@@ -0,0 +1,507 @@
+﻿#include "Common/Precompile.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "Renderer/SoftwareRasterizer.h"
+
+using namespace d14engine;
+using namespace d14engine::renderer;
+
+// Tests SoftwareRasterizer on the built-in scenes of the UI (a panel with
+// the shadow, the clips, the layers and the texts, the bitmaps, and the
+// rotated shapes) against the golden images, and checks that the SIMD
+// path and the counts of the threads never change the result:
+//
+// SoftRaster --golden Golden --tolerance 2
+// SoftRaster --golden Golden --update
+// SoftRaster --capture Frame.d14l --size 1280x720 --output Frame.pam
+//
+// Options:
+// --golden <dir>     Compares each scene with <dir>/<scene>.pam, and the
+//                    result is saved as <scene>.actual.pam in the working
+//                    directory (e.g. that of ctest in the build tree) if
+//                    they differ or the golden image is missing.
+// --update           Saves the results as the golden images instead.
+// --tolerance <N>    The max difference of the channels (default 2), which
+//                    covers the rounding of the floats across compilers.
+// --threads <N>      Count of the threads (default 0 for all the cores).
+// --bench <N>        Count of the timed rasterizations of each scene.
+// --capture <file>   Rasterizes a display list saved by DisplayList::save
+//                    (the bitmaps and the texts drawn as the placeholders)
+//                    to --output with --size.
+//
+// The images are PAM (P7) files of RGB_ALPHA with the straight alpha, and
+// the golden ones are kept in Tool/SoftRaster/Golden, which ctest checks
+// (see CMakeLists.txt).  Update them with --update after changing what
+// the scenes draw, and check the new ones by eye.
+//
+// This only depends on SoftwareRasterizer (with DisplayList and the pixel
+// utilities), so it can also be built for the POSIX systems.
+
+namespace
+{
+    int printUsage()
+    {
+        std::fprintf(stderr,
+            "Usage: SoftRaster [--golden DIR [--update]] [--tolerance N] [--threads N] [--bench N]\n"
+            "       SoftRaster --capture FILE --size WxH --output FILE\n");
+        return 2;
+    }
+
+    using Rect = DisplayList::Rect;
+    using Color = DisplayList::Color;
+    using Matrix = DisplayList::Matrix;
+
+    Matrix rotation(float degrees, float cx, float cy)
+    {
+        auto radians = degrees * 3.14159265f / 180.0f;
+        auto c = std::cos(radians), s = std::sin(radians);
+
+        return { c, s, -s, c, cx - cx * c + cy * s, cy - cx * s - cy * c };
+    }
+
+    // Stands in for a run of the glyphs rasterized by a font engine, i.e.
+    // the antialiased strokes of the letters of the given count.
+    pixel_utils::Mask textMask(uint32_t letters, uint32_t height, uint32_t seed)
+    {
+        auto advance = height * 3 / 5;
+        pixel_utils::Mask mask(letters * advance, height);
+
+        for (uint32_t i = 0; i < letters; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 28) == 0) continue; // space
+
+            auto stem = (seed >> 8) % 3;
+            auto top = (seed >> 12) % 2 ? height / 5 : height * 2 / 5;
+
+            for (uint32_t y = top; y < height * 4 / 5; ++y)
+            {
+                auto row = mask.row(y);
+                auto x0 = i * advance + 1 + stem * advance / 4;
+
+                row[x0] = 255; row[x0 + 1] = 160;
+
+                if (y == top || y == height * 4 / 5 - 1)
+                {
+                    for (uint32_t x = i * advance + 1; x < (i + 1) * advance - 1; ++x) row[x] = 200;
+                }
+            }
+        }
+        return mask;
+    }
+
+    // The premultiplied checkerboard with the gradient and a translucent
+    // corner, which shows the filtering.
+    pixel_utils::Image bitmap()
+    {
+        pixel_utils::Image image(16, 16);
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            auto row = image.row(y);
+            for (uint32_t x = 0; x < image.width; ++x)
+            {
+                uint8_t a = (x >= 12 && y >= 12) ? 128 : 255;
+                bool light = ((x / 2) + (y / 2)) % 2 == 0;
+
+                uint8_t r = light ? (uint8_t)(x * 16) : 20;
+                uint8_t g = light ? (uint8_t)(y * 16) : 40;
+                uint8_t b = light ? 200 : 60;
+
+                row[x * 4 + 0] = (uint8_t)(r * a / 255);
+                row[x * 4 + 1] = (uint8_t)(g * a / 255);
+                row[x * 4 + 2] = (uint8_t)(b * a / 255);
+                row[x * 4 + 3] = a;
+            }
+        }
+        return image;
+    }
+
+    const pixel_utils::Image g_bitmap = bitmap();
+
+    struct Scene
+    {
+        const char* name = nullptr;
+
+        uint32_t width = 0, height = 0;
+
+        Function<void(SoftwareRasterizer&)> draw = {};
+    };
+
+    void drawPanel(SoftwareRasterizer& r)
+    {
+        Color background = { 0.93f, 0.94f, 0.96f, 1.0f };
+        Color panel = { 1.0f, 1.0f, 1.0f, 1.0f };
+        Color border = { 0.75f, 0.77f, 0.80f, 1.0f };
+        Color accent = { 0.15f, 0.45f, 0.90f, 1.0f };
+        Color text = { 0.10f, 0.10f, 0.12f, 1.0f };
+
+        r.clear(background);
+
+        r.drawShadow({ 20.0f, 20.0f, 300.0f, 220.0f }, 8.0f, 8.0f, 4.0f, { 0.0f, 0.0f, 0.0f, 0.35f });
+        r.fillRoundedRect({ 20.0f, 20.0f, 300.0f, 220.0f }, 8.0f, 8.0f, panel);
+        r.drawRoundedRect({ 20.5f, 20.5f, 299.5f, 219.5f }, 8.0f, 8.0f, border);
+
+        // The title and the separator.
+        r.drawLine({ 20.0f, 48.5f }, { 300.0f, 48.5f }, border);
+        r.drawMask(textMask(12, 14, 1), { 32.0f, 27.0f }, text);
+
+        // The rows of a list clipped by the view, whose last row is cut.
+        r.pushClip({ 28.0f, 56.0f, 292.0f, 150.0f }, false);
+        for (int i = 0; i < 5; ++i)
+        {
+            auto top = 56.0f + i * 26.0f;
+            if (i == 1)
+            {
+                r.fillRect({ 28.0f, top, 292.0f, top + 24.0f }, { 0.85f, 0.91f, 1.0f, 1.0f });
+            }
+            r.drawRoundedRect({ 36.5f, top + 6.5f, 47.5f, top + 17.5f }, 2.0f, 2.0f, border);
+            if (i % 2 == 0)
+            {
+                r.fillRoundedRect({ 39.0f, top + 9.0f, 45.0f, top + 15.0f }, 1.0f, 1.0f, accent);
+            }
+            r.drawMask(textMask(9 + i * 2, 12, 7 + i), { 56.0f, top + 6.0f }, text);
+        }
+        r.popClip();
+
+        // The overlapping buttons in a translucent layer, which blends as
+        // one (the overlap is not darker).
+        r.pushLayer({ 28.0f, 160.0f, 292.0f, 212.0f }, 0.6f);
+        r.fillRoundedRect({ 36.0f, 168.0f, 156.0f, 204.0f }, 6.0f, 6.0f, accent);
+        r.fillRoundedRect({ 140.0f, 168.0f, 260.0f, 204.0f }, 18.0f, 18.0f, { 0.9f, 0.3f, 0.2f, 1.0f });
+        r.drawMask(textMask(6, 14, 3), { 60.0f, 179.0f }, panel);
+        r.popLayer();
+
+        // The fractional edges.
+        r.fillRect({ 310.3f, 20.3f, 340.7f, 60.7f }, accent);
+        r.drawRect({ 310.25f, 70.25f, 340.75f, 110.75f }, accent, 1.5f);
+    }
+
+    void drawBitmaps(SoftwareRasterizer& r)
+    {
+        auto view = g_bitmap.view();
+
+        r.clear({ 1.0f, 1.0f, 1.0f, 1.0f });
+
+        r.drawBitmap(view, { 8.0f, 8.0f, 72.0f, 72.0f }, 1.0f, false);
+        r.drawBitmap(view, { 80.0f, 8.0f, 144.0f, 72.0f }, 1.0f, true);
+        r.drawBitmap(view, { 152.0f, 8.0f, 182.5f, 38.5f }, 0.5f, true);
+
+        Rect source = { 4.0f, 4.0f, 12.0f, 12.0f };
+        r.drawBitmap(view, { 152.0f, 42.0f, 216.0f, 106.0f }, 1.0f, true, &source);
+
+        r.setTransform(rotation(30.0f, 112.0f, 120.0f));
+        r.drawBitmap(view, { 88.0f, 96.0f, 136.0f, 144.0f }, 1.0f, true);
+        r.setTransform({});
+
+        // A translucent target (cleared inside the clip only).
+        r.pushClip({ 8.0f, 100.0f, 60.0f, 152.0f });
+        r.clear({ 0.0f, 0.0f, 0.0f, 0.0f });
+        r.drawBitmap(view, { 8.0f, 100.0f, 60.0f, 152.0f }, 0.8f, true);
+        r.popClip();
+    }
+
+    void drawTransforms(SoftwareRasterizer& r)
+    {
+        Color ink = { 0.2f, 0.2f, 0.25f, 1.0f };
+
+        r.clear({ 0.98f, 0.98f, 0.98f, 1.0f });
+
+        for (int i = 0; i < 6; ++i)
+        {
+            r.setTransform(rotation(i * 15.0f, 60.0f, 60.0f));
+            r.drawRect({ 30.0f, 30.0f, 90.0f, 90.0f }, { 0.9f - i * 0.12f, 0.3f, 0.2f + i * 0.12f, 0.7f }, 1.5f);
+        }
+        r.setTransform(rotation(20.0f, 180.0f, 60.0f));
+        r.fillRoundedRect({ 140.0f, 35.0f, 220.0f, 85.0f }, 12.0f, 6.0f, { 0.2f, 0.6f, 0.3f, 1.0f });
+
+        // The non-uniform scale with the rotated clip (its bounds).
+        Matrix scale = { 1.5f, 0.0f, 0.0f, 0.75f, 20.0f, 130.0f };
+        r.setTransform(scale);
+        r.fillRoundedRect({ 0.0f, 0.0f, 80.0f, 60.0f }, 10.0f, 10.0f, { 0.3f, 0.4f, 0.9f, 1.0f });
+        r.drawRoundedRect({ 90.0f, 0.0f, 170.0f, 60.0f }, 10.0f, 10.0f, ink, 2.0f);
+
+        r.setTransform(rotation(45.0f, 60.0f, 200.0f));
+        r.pushClip({ 40.0f, 180.0f, 80.0f, 220.0f });
+        r.setTransform({});
+        r.fillRect({ 0.0f, 150.0f, 120.0f, 250.0f }, { 0.95f, 0.7f, 0.1f, 1.0f });
+        r.popClip();
+
+        for (int i = 0; i < 12; ++i)
+        {
+            auto a = i * 3.14159265f / 12.0f;
+            r.drawLine(
+                { 180.0f + 10.0f * std::cos(a), 190.0f + 10.0f * std::sin(a) },
+                { 180.0f + 50.0f * std::cos(a), 190.0f + 50.0f * std::sin(a) },
+                ink, 0.5f + i * 0.25f);
+        }
+    }
+
+    const std::array<Scene, 3> g_scenes =
+    {{
+        { "Panel", 352, 240, drawPanel },
+        { "Bitmaps", 224, 160, drawBitmaps },
+        { "Transforms", 240, 256, drawTransforms }
+    }};
+
+    pixel_utils::Image render(const Scene& scene, uint32_t threadCount, bool useSimd)
+    {
+        SoftwareRasterizer rasterizer(scene.width, scene.height);
+        rasterizer.settings.threadCount = threadCount;
+        rasterizer.settings.useSimd = useSimd;
+
+        scene.draw(rasterizer);
+        rasterizer.flush();
+
+        return rasterizer.target();
+    }
+
+    // Converts to the straight alpha in place.
+    void unpremultiply(pixel_utils::Image& image)
+    {
+        for (size_t i = 0; i < image.pixels.size(); i += 4)
+        {
+            auto a = image.pixels[i + 3];
+            for (size_t c = 0; c < 3; ++c)
+            {
+                image.pixels[i + c] = a ? (uint8_t)std::min((image.pixels[i + c] * 255 + a / 2) / a, 255) : 0;
+            }
+        }
+    }
+
+    bool savePam(const std::filesystem::path& path, const pixel_utils::Image& image)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        file << "P7\nWIDTH " << image.width << "\nHEIGHT " << image.height
+             << "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+
+        file.write((const char*)image.pixels.data(), (std::streamsize)image.pixels.size());
+        return (bool)file;
+    }
+
+    Optional<pixel_utils::Image> loadPam(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return std::nullopt;
+
+        String token = {};
+        file >> token;
+        if (token != "P7") return std::nullopt;
+
+        uint32_t width = 0, height = 0, depth = 0, maxValue = 0;
+        while (file >> token && token != "ENDHDR")
+        {
+            if (token == "WIDTH") file >> width;
+            else if (token == "HEIGHT") file >> height;
+            else if (token == "DEPTH") file >> depth;
+            else if (token == "MAXVAL") file >> maxValue;
+            else if (token == "TUPLTYPE") file >> token;
+            else return std::nullopt;
+        }
+        if (token != "ENDHDR" || depth != 4 || maxValue != 255 || width == 0 || height == 0)
+        {
+            return std::nullopt;
+        }
+        file.get(); // the newline after ENDHDR
+
+        pixel_utils::Image image(width, height);
+        file.read((char*)image.pixels.data(), (std::streamsize)image.pixels.size());
+
+        if (file.gcount() != (std::streamsize)image.pixels.size()) return std::nullopt;
+
+        return image;
+    }
+
+    // Returns the max difference of the channels and the count of the
+    // pixels beyond the tolerance.
+    std::pair<int, size_t> compare(const pixel_utils::Image& a, const pixel_utils::Image& b, int tolerance)
+    {
+        int maxDifference = 0;
+        size_t count = 0;
+
+        for (size_t i = 0; i < a.pixels.size(); i += 4)
+        {
+            int difference = 0;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                difference = std::max(difference, std::abs((int)a.pixels[i + c] - (int)b.pixels[i + c]));
+            }
+            maxDifference = std::max(maxDifference, difference);
+            if (difference > tolerance) ++count;
+        }
+        return { maxDifference, count };
+    }
+
+    int rasterizeCapture(const char* path, uint32_t width, uint32_t height, const char* output, uint32_t threadCount)
+    {
+        DisplayList list = {};
+        if (!list.load(path))
+        {
+            std::fprintf(stderr, "Failed to load %s\n", path);
+            return 1;
+        }
+        SoftwareRasterizer rasterizer(width, height);
+        rasterizer.settings.threadCount = threadCount;
+
+        SoftwareReplayer replayer(rasterizer, list);
+
+        auto start = std::chrono::steady_clock::now();
+
+        list.replay(replayer);
+        rasterizer.flush();
+
+        auto duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+
+        auto image = rasterizer.target();
+        unpremultiply(image);
+
+        if (!savePam(output, image))
+        {
+            std::fprintf(stderr, "Failed to save %s\n", output);
+            return 1;
+        }
+        std::printf("%zu commands rasterized to %ux%u in %.2f ms\n",
+            list.commandCount(), width, height, duration.count());
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* golden = nullptr;
+    bool update = false;
+    int tolerance = 2;
+    uint32_t threadCount = 0;
+    size_t bench = 0;
+
+    const char* capture = nullptr;
+    const char* output = nullptr;
+    uint32_t width = 0, height = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        if (arg == "--golden" && i + 1 < argc)
+        {
+            golden = argv[++i];
+        }
+        else if (arg == "--update")
+        {
+            update = true;
+        }
+        else if (arg == "--tolerance" && i + 1 < argc)
+        {
+            tolerance = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadCount = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--bench" && i + 1 < argc)
+        {
+            bench = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--capture" && i + 1 < argc)
+        {
+            capture = argv[++i];
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (arg == "--size" && i + 1 < argc)
+        {
+            if (std::sscanf(argv[++i], "%ux%u", &width, &height) != 2) return printUsage();
+        }
+        else return printUsage();
+    }
+    if (capture != nullptr)
+    {
+        if (output == nullptr || width == 0 || height == 0) return printUsage();
+
+        return rasterizeCapture(capture, width, height, output, threadCount);
+    }
+    if (update && golden == nullptr) return printUsage();
+
+    int failures = 0;
+    for (auto& scene : g_scenes)
+    {
+        auto result = render(scene, threadCount, true);
+
+        // The reference path on a single thread must be identical.
+        auto reference = render(scene, 1, false);
+        auto [difference, count] = compare(result, reference, 0);
+
+        std::printf("%-12s %ux%u", scene.name, scene.width, scene.height);
+        if (count > 0)
+        {
+            std::printf("  SIMD/scalar mismatch: %zu pixels (max %d)", count, difference);
+            ++failures;
+        }
+        if (bench > 0)
+        {
+            SoftwareRasterizer rasterizer(scene.width, scene.height);
+            rasterizer.settings.threadCount = threadCount;
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < bench; ++i)
+            {
+                scene.draw(rasterizer);
+                rasterizer.flush();
+            }
+            auto duration = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+            std::printf("  %.1f us/frame", duration.count() / (double)bench);
+        }
+        if (golden != nullptr)
+        {
+            unpremultiply(result);
+
+            auto path = std::filesystem::path(golden) / (String(scene.name) + ".pam");
+            if (update)
+            {
+                if (!savePam(path, result))
+                {
+                    std::printf("  failed to save %s", path.string().c_str());
+                    ++failures;
+                }
+                else std::printf("  updated");
+            }
+            else
+            {
+                auto expected = loadPam(path);
+                if (!expected.has_value() ||
+                    expected->width != result.width || expected->height != result.height)
+                {
+                    std::printf("  golden image missing or invalid");
+                    count = 1;
+                }
+                else
+                {
+                    std::tie(difference, count) = compare(result, expected.value(), tolerance);
+                    if (count > 0)
+                    {
+                        std::printf("  %zu pixels differ (max %d)", count, difference);
+                    }
+                    else std::printf("  passed (max %d)", difference);
+                }
+                if (count > 0)
+                {
+                    // Keeps the source tree clean (the golden directory).
+                    auto actual = std::filesystem::current_path() / (String(scene.name) + ".actual.pam");
+                    if (savePam(actual, result))
+                    {
+                        std::printf(", saved %s", actual.string().c_str());
+                    }
+                    ++failures;
+                }
+            }
+        }
+        std::printf("\n");
+    }
+    return failures > 0 ? 1 : 0;
+}